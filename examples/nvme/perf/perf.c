@@ -151,6 +151,7 @@ struct ns_worker_ctx {
 			struct spdk_nvme_qpair		**qpair;
 			struct spdk_nvme_poll_group	*group;
 			int				last_qpair;
+			struct spdk_nvme_pcie_stat	pcie_stat;
 		} nvme;
 
 #ifdef SPDK_CONFIG_URING
@@ -212,6 +213,7 @@ static int g_outstanding_commands;
 
 static bool g_latency_ssd_tracking_enable;
 static int g_latency_sw_tracking_level;
+static bool g_dump_transport_stats;
 
 static bool g_vmd;
 static const char *g_workload_type;
@@ -811,11 +813,45 @@ poll_group_failed:
 	return -1;
 }
 
+static void
+nvme_get_transport_stats(struct ns_worker_ctx *ns_ctx)
+{
+	struct spdk_nvme_poll_group_stat *stat;
+	struct spdk_nvme_pcie_stat *pcie_stat;
+	uint32_t i;
+
+	if (spdk_nvme_poll_group_get_stats(ns_ctx->u.nvme.group, &stat) != 0) {
+		fprintf(stderr, "Failed to get transport statistics for %s\n", ns_ctx->entry->name);
+		return;
+	}
+
+	for (i = 0; i < stat->num_transports; i++) {
+		if (stat->transport_stat[i].trtype != SPDK_NVME_TRANSPORT_PCIE) {
+			continue;
+		}
+		pcie_stat = &stat->transport_stat[i].u.pcie;
+		ns_ctx->u.nvme.pcie_stat.polls += pcie_stat->polls;
+		ns_ctx->u.nvme.pcie_stat.idle_polls += pcie_stat->idle_polls;
+		ns_ctx->u.nvme.pcie_stat.completions += pcie_stat->completions;
+		ns_ctx->u.nvme.pcie_stat.submitted_requests += pcie_stat->submitted_requests;
+		ns_ctx->u.nvme.pcie_stat.queued_requests += pcie_stat->queued_requests;
+		ns_ctx->u.nvme.pcie_stat.sq_doorbell_updates += pcie_stat->sq_doorbell_updates;
+		ns_ctx->u.nvme.pcie_stat.cq_doorbell_updates += pcie_stat->cq_doorbell_updates;
+	}
+
+	spdk_nvme_poll_group_free_stats(stat);
+}
+
 static void
 nvme_cleanup_ns_worker_ctx(struct ns_worker_ctx *ns_ctx)
 {
 	int i;
 
+	/* The counters live in the poll group, so collect them before it goes away */
+	if (g_dump_transport_stats) {
+		nvme_get_transport_stats(ns_ctx);
+	}
+
 	for (i = 0; i < ns_ctx->u.nvme.num_all_qpairs; i++) {
 		spdk_nvme_poll_group_remove(ns_ctx->u.nvme.group, ns_ctx->u.nvme.qpair[i]);
 		spdk_nvme_ctrlr_free_io_qpair(ns_ctx->u.nvme.qpair[i]);
@@ -852,6 +888,9 @@ build_nvme_name(char *name, size_t length, struct spdk_nvme_ctrlr *ctrlr)
 	case SPDK_NVME_TRANSPORT_TCP:
 		res = snprintf(name, length, "TCP  (addr:%s subnqn:%s)", trid->traddr, trid->subnqn);
 		break;
+	case SPDK_NVME_TRANSPORT_CUSTOM:
+		res = snprintf(name, length, "%s (addr:%s)", trid->trstring, trid->traddr);
+		break;
 
 	default:
 		fprintf(stderr, "Unknown transport type %d\n", trid->trtype);
@@ -1336,6 +1375,7 @@ static void usage(char *program_name)
 	printf("\t[-H enable header digest for TCP transport, default: disabled]\n");
 	printf("\t[-I enable data digest for TCP transport, default: disabled]\n");
 	printf("\t[-N no shutdown notification process for controllers, default: disabled]\n");
+	printf("\t[-S print PCIe transport statistics, including doorbell MMIO writes per I/O]\n");
 	printf("\t[-r Transport ID for local PCIe NVMe or NVMeoF]\n");
 	printf("\t Format: 'key:value [key:value] ...'\n");
 	printf("\t Keys:\n");
@@ -1345,7 +1385,8 @@ static void usage(char *program_name)
 	printf("\t  trsvcid     Transport service identifier (e.g. 4420)\n");
 	printf("\t  subnqn      Subsystem NQN (default: %s)\n", SPDK_NVMF_DISCOVERY_NQN);
 	printf("\t Example: -r 'trtype:PCIe traddr:0000:04:00.0' for PCIe or\n");
-	printf("\t          -r 'trtype:RDMA adrfam:IPv4 traddr:192.168.100.8 trsvcid:4420' for NVMeoF\n");
+	printf("\t          -r 'trtype:RDMA adrfam:IPv4 traddr:192.168.100.8 trsvcid:4420' for NVMeoF or\n");
+	printf("\t          -r 'trtype:MEMORY traddr:mem0,latency_us=10' for an emulated controller\n");
 	printf("\t[-e metadata configuration]\n");
 	printf("\t Keys:\n");
 	printf("\t  PRACT      Protection Information Action bit (PRACT=1 or PRACT=0)\n");
@@ -1593,10 +1634,62 @@ print_latency_statistics(const char *op_name, enum spdk_nvme_intel_log_page log_
 	printf("\n");
 }
 
+static void
+print_transport_stats(void)
+{
+	struct worker_thread	*worker;
+	struct ns_worker_ctx	*ns_ctx;
+	struct spdk_nvme_pcie_stat *stat;
+	uint64_t mmio_writes;
+	uint32_t max_strlen = 0;
+
+	worker = g_workers;
+	while (worker) {
+		ns_ctx = worker->ns_ctx;
+		while (ns_ctx) {
+			max_strlen = spdk_max(strlen(ns_ctx->entry->name), max_strlen);
+			ns_ctx = ns_ctx->next;
+		}
+		worker = worker->next;
+	}
+
+	printf("========================================================\n");
+	printf("PCIe transport statistics\n");
+	printf("%-*s: %12s %12s %12s %12s %12s %10s\n",
+	       max_strlen + 13, "Device Information", "polls", "idle_polls", "completions",
+	       "sq_doorbells", "cq_doorbells", "MMIO/IO");
+
+	worker = g_workers;
+	while (worker) {
+		ns_ctx = worker->ns_ctx;
+		while (ns_ctx) {
+			stat = &ns_ctx->u.nvme.pcie_stat;
+			if (ns_ctx->entry->type != ENTRY_TYPE_NVME_NS || stat->completions == 0) {
+				ns_ctx = ns_ctx->next;
+				continue;
+			}
+
+			mmio_writes = stat->sq_doorbell_updates + stat->cq_doorbell_updates;
+			printf("%-*.*s from core %2u: %12" PRIu64 " %12" PRIu64 " %12" PRIu64
+			       " %12" PRIu64 " %12" PRIu64 " %10.3f\n",
+			       max_strlen, max_strlen, ns_ctx->entry->name, worker->lcore,
+			       stat->polls, stat->idle_polls, stat->completions,
+			       stat->sq_doorbell_updates, stat->cq_doorbell_updates,
+			       (double)mmio_writes / stat->completions);
+			ns_ctx = ns_ctx->next;
+		}
+		worker = worker->next;
+	}
+	printf("\n");
+}
+
 static void
 print_stats(void)
 {
 	print_performance();
+	if (g_dump_transport_stats) {
+		print_transport_stats();
+	}
 	if (g_latency_ssd_tracking_enable) {
 		if (g_rw_percentage != 0) {
 			print_latency_statistics("Read", SPDK_NVME_INTEL_LOG_READ_CMD_LATENCY);
@@ -1640,8 +1733,10 @@ add_trid(const char *trid_str)
 		return 1;
 	}
 
-	spdk_nvme_transport_id_populate_trstring(trid,
-			spdk_nvme_transport_id_trtype_str(trid->trtype));
+	if (trid->trtype != SPDK_NVME_TRANSPORT_CUSTOM) {
+		spdk_nvme_transport_id_populate_trstring(trid,
+				spdk_nvme_transport_id_trtype_str(trid->trtype));
+	}
 
 	ns = strcasestr(trid_str, "ns:");
 	if (ns) {
@@ -1772,7 +1867,7 @@ parse_args(int argc, char **argv)
 	long int val;
 	int rc;
 
-	while ((op = getopt(argc, argv, "c:e:i:lo:q:r:k:s:t:w:C:DGHILM:NP:RT:U:V")) != -1) {
+	while ((op = getopt(argc, argv, "c:e:i:lo:q:r:k:s:t:w:C:DGHILM:NP:RST:U:V")) != -1) {
 		switch (op) {
 		case 'i':
 		case 'C':
@@ -1870,6 +1965,9 @@ parse_args(int argc, char **argv)
 		case 'N':
 			g_no_shn_notification = true;
 			break;
+		case 'S':
+			g_dump_transport_stats = true;
+			break;
 		case 'R':
 #ifndef SPDK_CONFIG_URING
 			fprintf(stderr, "%s must be rebuilt with CONFIG_URING=y for -R flag.\n",
@@ -193,6 +193,13 @@ struct spdk_bs_dev {
 
 	uint64_t	blockcnt;
 	uint32_t	blocklen; /* In bytes */
+
+	/* Copy lba_count blocks from src_lba to dst_lba without moving the data
+	 * through a host buffer. Optional, set to NULL if the device can't copy.
+	 * The ranges never overlap. */
+	void (*copy)(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+		     uint64_t dst_lba, uint64_t src_lba, uint32_t lba_count,
+		     struct spdk_bs_dev_cb_args *cb_args);
 };
 
 struct spdk_bs_type {
@@ -223,6 +230,14 @@ struct spdk_bs_opts {
 
 	/** Argument passed to iter_cb_fn for each blob. */
 	void *iter_cb_arg;
+
+	/**
+	 * Granularity in bytes in which clones and snapshotted blobs copy clusters
+	 * from their parent on first write. Must be a multiple of 4KiB page size.
+	 * 0 copies whole clusters. Only used when initializing a blobstore, it is
+	 * persisted in the super block and applies to clones created later.
+	 */
+	uint32_t cow_granularity;
 };
 
 /**
@@ -344,6 +359,10 @@ uint64_t spdk_bs_get_io_unit_size(struct spdk_blob_store *bs);
 /**
  * Get the number of free clusters.
  *
+ * Clusters that I/O channels have reserved for allocating writes but not used yet
+ * are counted as free. They are returned to the pool when it runs out, so every
+ * cluster counted here can be allocated.
+ *
  * \param bs blobstore to query.
  *
  * \return the number of free clusters.
@@ -359,6 +378,29 @@ uint64_t spdk_bs_free_cluster_count(struct spdk_blob_store *bs);
  */
 uint64_t spdk_bs_total_data_cluster_count(struct spdk_blob_store *bs);
 
+/**
+ * Get the number of clusters released by blobs that are waiting to be unmapped.
+ *
+ * Clusters of blobs cleared with unmap are unmapped in the background after the
+ * operation releasing them completes, and only count as free once unmapped. An
+ * allocation that doesn't find enough free clusters waits for the pending ones to
+ * be unmapped, regardless of the rate limit, before failing.
+ *
+ * \param bs blobstore to query.
+ *
+ * \return the number of clusters waiting to be unmapped.
+ */
+uint64_t spdk_bs_unmap_pending_cluster_count(struct spdk_blob_store *bs);
+
+/**
+ * Limit the rate at which released clusters are unmapped. This function must be
+ * called on the blobstore metadata thread.
+ *
+ * \param bs blobstore to configure.
+ * \param max_bytes_per_sec Maximum number of bytes unmapped per second, 0 for no limit.
+ */
+void spdk_bs_set_unmap_rate_limit(struct spdk_blob_store *bs, uint64_t max_bytes_per_sec);
+
 /**
  * Get the blob id.
  *
@@ -395,6 +437,27 @@ uint64_t spdk_blob_get_num_io_units(struct spdk_blob *blob);
  */
 uint64_t spdk_blob_get_num_clusters(struct spdk_blob *blob);
 
+/**
+ * Get the number of clusters the blob has allocated itself. This function must be
+ * called on the blobstore metadata thread.
+ *
+ * \param blob Blob struct to query.
+ *
+ * \return the number of allocated clusters.
+ */
+uint64_t spdk_blob_get_num_allocated_clusters(struct spdk_blob *blob);
+
+/**
+ * Get the number of clusters of the blob that are not allocated in the blob, but
+ * read from one of its snapshots. This function must be called on the blobstore
+ * metadata thread.
+ *
+ * \param blob Blob struct to query.
+ *
+ * \return the number of clusters shared with snapshots.
+ */
+uint64_t spdk_blob_get_num_shared_clusters(struct spdk_blob *blob);
+
 struct spdk_blob_xattr_opts {
 	/* Number of attributes */
 	size_t	count;
@@ -565,6 +628,9 @@ void spdk_bs_delete_blob(struct spdk_blob_store *bs, spdk_blob_id blobid,
  *
  * This call removes all dependencies on any backing blobs.
  *
+ * The operation is not recorded in the blob's metadata, use
+ * spdk_bs_inflate_blob_ext() for an operation that can be resumed.
+ *
  * \param bs blobstore.
  * \param channel IO channel used to inflate blob.
  * \param blobid The id of the blob to inflate.
@@ -583,6 +649,9 @@ void spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *ch
  *
  * If blob have no parent -EINVAL error is reported.
  *
+ * The operation is not recorded in the blob's metadata, use
+ * spdk_bs_blob_decouple_parent_ext() for an operation that can be resumed.
+ *
  * \param bs blobstore.
  * \param channel IO channel used to inflate blob.
  * \param blobid The id of the blob.
@@ -592,6 +661,137 @@ void spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 void spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 				  spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg);
 
+struct spdk_blob_inflate_opts {
+	/** Clusters copied per second at most, 0 for no limit */
+	uint64_t max_clusters_per_sec;
+
+	/** Bytes copied per second at most, 0 for no limit */
+	uint64_t max_bytes_per_sec;
+};
+
+/**
+ * Initialize a spdk_blob_inflate_opts structure to the default option values,
+ * without any limits.
+ *
+ * \param opts spdk_blob_inflate_opts structure to initialize.
+ */
+void spdk_blob_inflate_opts_init(struct spdk_blob_inflate_opts *opts);
+
+/**
+ * Inflate a blob like spdk_bs_inflate_blob(), copying clusters at the rate
+ * allowed by the options.
+ *
+ * The operation is recorded in the blob's metadata until it completes. If it
+ * is interrupted, e.g. by an application restart, it can be started again
+ * with the options returned by spdk_blob_get_inflate_checkpoint(). Clusters
+ * copied before are not copied again.
+ *
+ * \param bs blobstore.
+ * \param channel IO channel used to inflate blob.
+ * \param blobid The id of the blob to inflate.
+ * \param opts Rate limits, NULL for no limits.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_inflate_blob_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			      spdk_blob_id blobid, const struct spdk_blob_inflate_opts *opts,
+			      spdk_blob_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Decouple the parent of a blob like spdk_bs_blob_decouple_parent(), copying
+ * clusters at the rate allowed by the options. See spdk_bs_inflate_blob_ext().
+ *
+ * \param bs blobstore.
+ * \param channel IO channel used to inflate blob.
+ * \param blobid The id of the blob.
+ * \param opts Rate limits, NULL for no limits.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_blob_decouple_parent_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+				      spdk_blob_id blobid,
+				      const struct spdk_blob_inflate_opts *opts,
+				      spdk_blob_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Delete an existing blob like spdk_bs_delete_blob().
+ *
+ * Deleting a snapshot with a clone first copies the units the clone would no
+ * longer find in the same place, at the rate allowed by the options. The clone
+ * I/O is only frozen to copy those its writes left behind in the meantime. The
+ * blob and its clone are held open until the deletion completes.
+ *
+ * \param bs blobstore.
+ * \param blobid The id of the blob to delete.
+ * \param opts Rate limits for copying the units, NULL for no limits.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_delete_blob_ext(struct spdk_blob_store *bs, spdk_blob_id blobid,
+			     const struct spdk_blob_inflate_opts *opts,
+			     spdk_blob_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Cancel the inflate or parent decouple running on a blob.
+ *
+ * The operation completes with -ECANCELED once the cluster copy in flight, if
+ * any, is done. An operation started with spdk_bs_inflate_blob_ext() or
+ * spdk_bs_blob_decouple_parent_ext() stays recorded in the blob's metadata, so
+ * it can be started again later, see spdk_blob_get_inflate_checkpoint(). The
+ * blob is no longer
+ * held open by the operation when cb_fn is called, so the blob can be deleted
+ * and the blobstore unloaded.
+ *
+ * \param bs blobstore.
+ * \param blobid The id of the blob.
+ * \param cb_fn Called once the operation has stopped.
+ * \param cb_arg Argument passed to function cb_fn.
+ *
+ * \return 0 if the operation is being canceled, -ENOENT if none is running on
+ * the blob, -EALREADY if it is already being canceled. cb_fn is only called if
+ * 0 is returned.
+ */
+int spdk_bs_inflate_blob_cancel(struct spdk_blob_store *bs, spdk_blob_id blobid,
+				spdk_blob_op_complete cb_fn, void *cb_arg);
+
+struct spdk_blob_inflate_progress {
+	/** true for an inflate, false for a parent decouple */
+	bool		allocate_all;
+
+	/** Clusters to copy, counted when the operation started */
+	uint64_t	clusters_total;
+
+	/** Clusters copied so far */
+	uint64_t	clusters_done;
+
+	/** Ticks since the operation started */
+	uint64_t	elapsed_ticks;
+};
+
+/**
+ * Get the progress of the inflate or parent decouple running on the blob.
+ *
+ * \param blob Blob to query.
+ * \param progress Filled with the progress of the operation.
+ *
+ * \return 0 on success, -ENOENT if no such operation is running on the blob.
+ */
+int spdk_blob_get_inflate_progress(struct spdk_blob *blob,
+				   struct spdk_blob_inflate_progress *progress);
+
+/**
+ * Get the inflate or parent decouple recorded in the blob's metadata, which
+ * either is running or was interrupted before it completed.
+ *
+ * \param blob Blob to query.
+ * \param opts Filled with the options the operation was started with.
+ * \param allocate_all Set to true for an inflate, false for a parent decouple.
+ *
+ * \return 0 on success, -ENOENT if no such operation is recorded.
+ */
+int spdk_blob_get_inflate_checkpoint(struct spdk_blob *blob, struct spdk_blob_inflate_opts *opts,
+				     bool *allocate_all);
+
 struct spdk_blob_open_opts {
 	enum blob_clear_method  clear_method;
 };
@@ -673,6 +873,10 @@ void spdk_blob_close(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *
 /**
  * Allocate an I/O channel for the given blobstore.
  *
+ * Copy-on-write of clusters that can't be copied within the device goes through
+ * cluster sized DMA buffers. Each channel keeps up to 4 of them, and no more than
+ * 4 MiB in total, for reuse until the channel is freed.
+ *
  * \param bs blobstore.
  * \return a pointer to the allocated I/O channel.
  */
@@ -387,6 +387,35 @@ uint64_t spdk_fs_get_cache_size(void);
  */
 void spdk_file_set_priority(struct spdk_file *file, uint32_t priority);
 
+/**
+ * Limit how far ahead of a sequential stream of reads data of the file is read
+ * into the cache. The readahead window starts at two cache buffers once a
+ * sequential stream is detected and grows with the stream up to this limit.
+ *
+ * \param file File to set the readahead limit for.
+ * \param max_bytes Maximum number of bytes read ahead, 0 disables readahead.
+ * The default is 2 MiB.
+ */
+void spdk_file_set_readahead(struct spdk_file *file, uint64_t max_bytes);
+
+/**
+ * Statistics of the blobfs cache, shared by all filesystems.
+ */
+struct spdk_fs_cache_stats {
+	uint64_t	hits;		/* reads served from the cache */
+	uint64_t	misses;		/* reads that went to the blobstore */
+	uint64_t	evictions;	/* cache buffers reclaimed from files */
+	uint64_t	readaheads;	/* cache buffers read ahead of sequential streams */
+};
+
+/**
+ * Get the statistics of the blobfs cache. The statistics are reset when the
+ * cache is created by the first filesystem being initialized or loaded.
+ *
+ * \param stats Filled with the current statistics.
+ */
+void spdk_fs_get_cache_stats(struct spdk_fs_cache_stats *stats);
+
 /**
  * Synchronize the data from the cache to the disk.
  *
@@ -275,7 +275,8 @@ void spdk_lvs_load(struct spdk_bs_dev *bs_dev, spdk_lvs_op_with_handle_complete
 void spdk_lvol_open(struct spdk_lvol *lvol, spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg);
 
 /**
- * Inflate lvol
+ * Inflate lvol. The operation is not recorded in the lvol's metadata, see
+ * spdk_lvol_inflate_ext().
  *
  * \param lvol Handle to lvol
  * \param cb_fn Completion callback
@@ -284,7 +285,8 @@ void spdk_lvol_open(struct spdk_lvol *lvol, spdk_lvol_op_with_handle_complete cb
 void spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg);
 
 /**
- * Decouple parent of lvol
+ * Decouple parent of lvol. The operation is not recorded in the lvol's
+ * metadata, see spdk_lvol_decouple_parent_ext().
  *
  * \param lvol Handle to lvol
  * \param cb_fn Completion callback
@@ -292,6 +294,44 @@ void spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void
  */
 void spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Inflate lvol, copying clusters at the rate allowed by the options. An
+ * interrupted inflate is recorded in the lvol's metadata, see
+ * spdk_blob_get_inflate_checkpoint().
+ *
+ * \param lvol Handle to lvol
+ * \param opts Rate limits, NULL for no limits
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_inflate_ext(struct spdk_lvol *lvol, const struct spdk_blob_inflate_opts *opts,
+			   spdk_lvol_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Decouple parent of lvol, copying clusters at the rate allowed by the options.
+ * An interrupted parent decouple is recorded in the lvol's metadata, see
+ * spdk_blob_get_inflate_checkpoint().
+ *
+ * \param lvol Handle to lvol
+ * \param opts Rate limits, NULL for no limits
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_decouple_parent_ext(struct spdk_lvol *lvol,
+				   const struct spdk_blob_inflate_opts *opts,
+				   spdk_lvol_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Get the progress of the inflate or parent decouple running on the lvol.
+ *
+ * \param lvol Handle to lvol
+ * \param progress Filled with the progress of the operation
+ *
+ * \return 0 on success, -ENOENT if no such operation is running.
+ */
+int spdk_lvol_get_inflate_progress(struct spdk_lvol *lvol,
+				   struct spdk_blob_inflate_progress *progress);
+
 #ifdef __cplusplus
 }
 #endif
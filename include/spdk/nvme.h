@@ -52,6 +52,7 @@ extern "C" {
 #define SPDK_NVME_TRANSPORT_NAME_PCIE	"PCIE"
 #define SPDK_NVME_TRANSPORT_NAME_RDMA	"RDMA"
 #define SPDK_NVME_TRANSPORT_NAME_TCP	"TCP"
+#define SPDK_NVME_TRANSPORT_NAME_MEMORY	"MEMORY"
 
 #define SPDK_NVMF_PRIORITY_MAX_LEN 4
 
@@ -151,6 +152,10 @@ struct spdk_nvme_ctrlr_opts {
 	 * A single I/O may allocate more than one request, since splitting may be necessary to
 	 * conform to the device's maximum transfer size, PRP list compatibility requirements,
 	 * or driver-assisted striping.
+	 *
+	 * An I/O split on the maximum transfer size or stripe boundaries into more requests
+	 * than are free is still accepted, the remaining requests are submitted as earlier
+	 * ones complete.
 	 */
 	uint32_t io_queue_requests;
 
@@ -185,9 +190,10 @@ struct spdk_nvme_ctrlr_opts {
 	/**
 	 * The I/O command set to select.
 	 *
-	 * If the requested command set is not supported, the controller
-	 * initialization process will not proceed. By default, the NVM
-	 * command set is used.
+	 * If the requested command set is not supported, the NVM command set
+	 * is used. By default, all the I/O command sets the controller supports
+	 * are enabled (SPDK_NVME_CC_CSS_IOCS), which is required to access zoned
+	 * namespaces.
 	 */
 	enum spdk_nvme_cc_css command_set;
 
@@ -1114,6 +1120,10 @@ struct spdk_nvme_io_qpair_opts {
 	 * A single I/O may allocate more than one request, since splitting may be
 	 * necessary to conform to the device's maximum transfer size, PRP list
 	 * compatibility requirements, or driver-assisted striping.
+	 *
+	 * An I/O split on the maximum transfer size or stripe boundaries into more
+	 * requests than are free is still accepted, the remaining requests are
+	 * submitted as earlier ones complete.
 	 */
 	uint32_t io_queue_requests;
 
@@ -2002,6 +2012,39 @@ struct spdk_nvme_poll_group;
 typedef void (*spdk_nvme_disconnected_qpair_cb)(struct spdk_nvme_qpair *qpair,
 		void *poll_group_ctx);
 
+/**
+ * Completion callback of an operation submitted through spdk_nvme_accel_fn_table.
+ *
+ * \param cb_arg Argument passed to the submit function.
+ * \param status 0 on success, negative errno on failure.
+ */
+typedef void (*spdk_nvme_accel_completion_cb)(void *cb_arg, int status);
+
+/**
+ * Functions a poll group may use to offload work of its transports, like the
+ * computation of NVMe/TCP data digests, to an acceleration engine.
+ */
+struct spdk_nvme_accel_fn_table {
+	/**
+	 * The size of spdk_nvme_accel_fn_table according to the caller of
+	 * spdk_nvme_poll_group_create_ext(). Newer members are only used when they
+	 * fit in table_size.
+	 */
+	size_t table_size;
+
+	/**
+	 * Compute the CRC-32C of a scattered buffer. The result written to dst is
+	 * the same as spdk_accel_submit_crc32c() produces for the concatenation of
+	 * the iovs, i.e. the CRC is started from ~seed and not finalized. cb_fn must
+	 * be called on the thread polling the group, it may be called before the
+	 * function returns. Errors, including submission failures, are reported
+	 * through cb_fn.
+	 */
+	void (*submit_accel_crc32c)(void *ctx, uint32_t *dst, struct iovec *iov,
+				    uint32_t iovcnt, uint32_t seed,
+				    spdk_nvme_accel_completion_cb cb_fn, void *cb_arg);
+};
+
 /**
  * Create a new poll group.
  *
@@ -2011,6 +2054,19 @@ typedef void (*spdk_nvme_disconnected_qpair_cb)(struct spdk_nvme_qpair *qpair,
  */
 struct spdk_nvme_poll_group *spdk_nvme_poll_group_create(void *ctx);
 
+/**
+ * Create a new poll group whose transports may offload work to an acceleration engine.
+ *
+ * \param ctx A user supplied context that can be retrieved later with spdk_nvme_poll_group_get_ctx.
+ * It is also passed to the functions of table.
+ * \param table Acceleration functions the transports of the group may use. Optional,
+ * may be NULL.
+ *
+ * \return Pointer to the new poll group, or NULL on error.
+ */
+struct spdk_nvme_poll_group *spdk_nvme_poll_group_create_ext(void *ctx,
+		struct spdk_nvme_accel_fn_table *table);
+
 /**
  * Add an spdk_nvme_qpair to a poll group. qpairs may only be added to
  * a poll group if they are in the disconnected state; i.e. either they were
@@ -2070,6 +2126,108 @@ int64_t spdk_nvme_poll_group_process_completions(struct spdk_nvme_poll_group *gr
  */
 void *spdk_nvme_poll_group_get_ctx(struct spdk_nvme_poll_group *group);
 
+/**
+ * Statistics of the NVMe/PCIe transport of a poll group.
+ */
+struct spdk_nvme_pcie_stat {
+	/* Calls to process the completions of a qpair */
+	uint64_t polls;
+	/* Polls that found no completions */
+	uint64_t idle_polls;
+	uint64_t completions;
+	uint64_t submitted_requests;
+	/* Requests that found the qpair full and were queued by the driver */
+	uint64_t queued_requests;
+	/* MMIO writes of submission queue tail doorbells */
+	uint64_t sq_doorbell_updates;
+	/* MMIO writes of completion queue head doorbells */
+	uint64_t cq_doorbell_updates;
+};
+
+/**
+ * Statistics of the NVMe/TCP transport of a poll group. Dividing recv_syscalls
+ * by nvme_completions gives the number of socket reads needed per I/O.
+ */
+struct spdk_nvme_tcp_stat {
+	/* Calls to process the completions of a qpair */
+	uint64_t polls;
+	/* Polls that found no completions */
+	uint64_t idle_polls;
+	uint64_t submitted_requests;
+	/* Requests that found the qpair full and were queued by the driver */
+	uint64_t queued_requests;
+	/* Requests completed, including aborted ones */
+	uint64_t nvme_completions;
+	/* Reads from the sockets of the qpairs */
+	uint64_t recv_syscalls;
+	/* PDUs received */
+	uint64_t recv_pdus;
+	/* Bytes received through the receive buffers of the qpairs */
+	uint64_t recv_buffered_bytes;
+	/* Payload bytes received directly into the buffers of the requests */
+	uint64_t recv_direct_bytes;
+	/* Polls that ended in the middle of a PDU */
+	uint64_t recv_partial_reads;
+};
+
+/**
+ * Statistics of the NVMe/RDMA transport of a poll group.
+ */
+struct spdk_nvme_rdma_stat {
+	/* Calls to ibv_poll_cq() */
+	uint64_t polls;
+	/* Calls to ibv_poll_cq() that returned no work completions */
+	uint64_t idle_polls;
+	uint64_t completions;
+	/* Requests that found the qpair full and were queued by the driver */
+	uint64_t queued_requests;
+	uint64_t total_send_wrs;
+	/* Calls to ibv_post_send() */
+	uint64_t send_doorbell_updates;
+	uint64_t total_recv_wrs;
+	/* Calls to ibv_post_recv() */
+	uint64_t recv_doorbell_updates;
+};
+
+/**
+ * Statistics of one transport of a poll group.
+ */
+struct spdk_nvme_transport_poll_group_stat {
+	enum spdk_nvme_transport_type trtype;
+	union {
+		struct spdk_nvme_pcie_stat pcie;
+		struct spdk_nvme_tcp_stat tcp;
+		struct spdk_nvme_rdma_stat rdma;
+	} u;
+};
+
+/**
+ * Statistics of a poll group, one entry per transport that reports statistics.
+ */
+struct spdk_nvme_poll_group_stat {
+	uint32_t num_transports;
+	struct spdk_nvme_transport_poll_group_stat *transport_stat;
+};
+
+/**
+ * Get the statistics of a poll group. Must be called from the thread polling the group.
+ *
+ * \param group The poll group to get the statistics of.
+ * \param stats Set to the statistics on success. Must be freed with
+ * spdk_nvme_poll_group_free_stats().
+ *
+ * \return 0 on success, -ENOMEM on memory allocation failure.
+ */
+int spdk_nvme_poll_group_get_stats(struct spdk_nvme_poll_group *group,
+				   struct spdk_nvme_poll_group_stat **stats);
+
+/**
+ * Free statistics returned by spdk_nvme_poll_group_get_stats().
+ *
+ * \param stats The statistics to free.
+ */
+void spdk_nvme_poll_group_free_stats(struct spdk_nvme_poll_group_stat *stats);
+
 /**
  * Get the identify namespace data as defined by the NVMe specification.
  *
@@ -2267,6 +2425,16 @@ uint32_t spdk_nvme_ns_get_optimal_io_boundary(struct spdk_nvme_ns *ns);
  */
 const struct spdk_uuid *spdk_nvme_ns_get_uuid(const struct spdk_nvme_ns *ns);
 
+/**
+ * Get the Command Set Identifier for the given namespace.
+ *
+ * \param ns Namespace to query.
+ *
+ * \return the namespace Command Set Identifier. SPDK_NVME_CSI_NVM is returned
+ * if the controller does not report one.
+ */
+enum spdk_nvme_csi spdk_nvme_ns_get_csi(const struct spdk_nvme_ns *ns);
+
 /**
  * \brief Namespace command support flags.
  */
@@ -3208,6 +3376,9 @@ struct spdk_nvme_transport_ops {
 			uint32_t completions_per_qpair, spdk_nvme_disconnected_qpair_cb disconnected_qpair_cb);
 
 	int (*poll_group_destroy)(struct spdk_nvme_transport_poll_group *tgroup);
+
+	int (*poll_group_get_stats)(struct spdk_nvme_transport_poll_group *tgroup,
+				    struct spdk_nvme_transport_poll_group_stat *stat);
 };
 
 /**
@@ -1012,6 +1012,14 @@ union spdk_nvme_cmd_cdw11 {
 		uint32_t reserved : 31;
 	} resv_report;
 
+	struct {
+		/* NVM Set Identifier */
+		uint32_t nvmsetid : 16;
+		uint32_t reserved : 8;
+		/* Command Set Identifier, see \ref spdk_nvme_csi */
+		uint32_t csi      : 8;
+	} identify;
+
 	union spdk_nvme_feat_arbitration feat_arbitration;
 	union spdk_nvme_feat_power_management feat_power_management;
 	union spdk_nvme_feat_lba_range_type feat_lba_range_type;
@@ -1249,6 +1257,16 @@ enum spdk_nvme_command_specific_status_code {
 	SPDK_NVME_SC_CONFLICTING_ATTRIBUTES		= 0x80,
 	SPDK_NVME_SC_INVALID_PROTECTION_INFO		= 0x81,
 	SPDK_NVME_SC_ATTEMPTED_WRITE_TO_RO_RANGE	= 0x82,
+
+	/* Zoned Namespace command set */
+	SPDK_NVME_SC_ZONE_BOUNDARY_ERROR		= 0xb8,
+	SPDK_NVME_SC_ZONE_IS_FULL			= 0xb9,
+	SPDK_NVME_SC_ZONE_IS_READ_ONLY			= 0xba,
+	SPDK_NVME_SC_ZONE_IS_OFFLINE			= 0xbb,
+	SPDK_NVME_SC_ZONE_INVALID_WRITE			= 0xbc,
+	SPDK_NVME_SC_TOO_MANY_ACTIVE_ZONES		= 0xbd,
+	SPDK_NVME_SC_TOO_MANY_OPEN_ZONES		= 0xbe,
+	SPDK_NVME_SC_INVALID_ZONE_STATE_TRANSITION	= 0xbf,
 };
 
 /**
@@ -1342,6 +1360,11 @@ enum spdk_nvme_nvm_opcode {
 
 	SPDK_NVME_OPC_RESERVATION_ACQUIRE		= 0x11,
 	SPDK_NVME_OPC_RESERVATION_RELEASE		= 0x15,
+
+	/* Zoned Namespace command set */
+	SPDK_NVME_OPC_ZONE_MGMT_SEND			= 0x79,
+	SPDK_NVME_OPC_ZONE_MGMT_RECV			= 0x7a,
+	SPDK_NVME_OPC_ZONE_APPEND			= 0x7d,
 };
 
 /**
@@ -2769,6 +2792,21 @@ enum spdk_nvme_nidt {
 
 	/** Namespace UUID */
 	SPDK_NVME_NIDT_UUID		= 0x03,
+
+	/** Command Set Identifier, see \ref spdk_nvme_csi */
+	SPDK_NVME_NIDT_CSI		= 0x04,
+};
+
+/**
+ * Command Set Identifier
+ *
+ * Reported in the namespace identification descriptor list and selects the
+ * command set of the CNS values of Identify specific to a command set.
+ */
+enum spdk_nvme_csi {
+	SPDK_NVME_CSI_NVM		= 0x0,
+	SPDK_NVME_CSI_KV		= 0x1,
+	SPDK_NVME_CSI_ZNS		= 0x2,
 };
 
 struct spdk_nvme_ns_id_desc {
@@ -2786,6 +2824,156 @@ struct spdk_nvme_ns_id_desc {
 };
 SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_ns_id_desc) == 4, "Incorrect size");
 
+/**
+ * Identify Controller data specific to the Zoned Namespace command set
+ * (CNS 06h, CSI 02h)
+ */
+struct spdk_nvme_zns_ctrlr_data {
+	/** zone append size limit, a power of two in units of CAP.MPSMIN; 0 means MDTS */
+	uint8_t			zasl;
+
+	uint8_t			reserved1[4095];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_ctrlr_data) == 4096, "Incorrect size");
+
+/** LBA format extension of a zoned namespace */
+struct spdk_nvme_zns_lbaf_ext {
+	/** zone size in logical blocks */
+	uint64_t		zsze;
+
+	/** zone descriptor extension size, in units of 64 bytes */
+	uint8_t			zdes;
+
+	uint8_t			reserved9[7];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_lbaf_ext) == 16, "Incorrect size");
+
+/**
+ * Identify Namespace data specific to the Zoned Namespace command set
+ * (CNS 05h, CSI 02h)
+ */
+struct spdk_nvme_zns_ns_data {
+	/** zone operation characteristics */
+	struct {
+		uint16_t	variable_zone_capacity : 1;
+		uint16_t	zone_active_excursions : 1;
+		uint16_t	reserved : 14;
+	} zoc;
+
+	/** optional zoned command support */
+	struct {
+		uint16_t	read_across_zone_boundaries : 1;
+		uint16_t	reserved : 15;
+	} ozcs;
+
+	/** maximum active resources, 0-based, 0xffffffff means no limit */
+	uint32_t		mar;
+
+	/** maximum open resources, 0-based, 0xffffffff means no limit */
+	uint32_t		mor;
+
+	/** reset recommended limit, in seconds */
+	uint32_t		rrl;
+
+	/** finish recommended limit, in seconds */
+	uint32_t		frl;
+
+	uint8_t			reserved20[2796];
+
+	/** LBA format extensions, indexed like lbaf of the NVM Identify Namespace data */
+	struct spdk_nvme_zns_lbaf_ext	lbafe[16];
+
+	uint8_t			reserved3072[768];
+
+	uint8_t			vendor_specific[256];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_ns_data) == 4096, "Incorrect size");
+
+/** Zone Send Action of the Zone Management Send command (cdw13 bits 7:0) */
+enum spdk_nvme_zns_zone_send_action {
+	SPDK_NVME_ZONE_CLOSE		= 0x1,
+	SPDK_NVME_ZONE_FINISH		= 0x2,
+	SPDK_NVME_ZONE_OPEN		= 0x3,
+	SPDK_NVME_ZONE_RESET		= 0x4,
+	SPDK_NVME_ZONE_OFFLINE		= 0x5,
+	SPDK_NVME_ZONE_SET_ZDE		= 0x10,
+};
+
+/** Zone Receive Action of the Zone Management Receive command (cdw13 bits 7:0) */
+enum spdk_nvme_zns_zone_receive_action {
+	SPDK_NVME_ZONE_REPORT		= 0x0,
+	SPDK_NVME_ZONE_EXTENDED_REPORT	= 0x1,
+};
+
+/** Zone Receive Action Specific Field of a zone report (cdw13 bits 15:8) */
+enum spdk_nvme_zns_zra_report_opts {
+	SPDK_NVME_ZRA_LIST_ALL		= 0x0,
+	SPDK_NVME_ZRA_LIST_ZSE		= 0x1,
+	SPDK_NVME_ZRA_LIST_ZSIO		= 0x2,
+	SPDK_NVME_ZRA_LIST_ZSEO		= 0x3,
+	SPDK_NVME_ZRA_LIST_ZSC		= 0x4,
+	SPDK_NVME_ZRA_LIST_ZSF		= 0x5,
+	SPDK_NVME_ZRA_LIST_ZSRO		= 0x6,
+	SPDK_NVME_ZRA_LIST_ZSO		= 0x7,
+};
+
+enum spdk_nvme_zns_zone_type {
+	SPDK_NVME_ZONE_TYPE_SEQWR	= 0x2,
+};
+
+enum spdk_nvme_zns_zone_state {
+	SPDK_NVME_ZONE_STATE_EMPTY	= 0x1,
+	SPDK_NVME_ZONE_STATE_IOPEN	= 0x2,
+	SPDK_NVME_ZONE_STATE_EOPEN	= 0x3,
+	SPDK_NVME_ZONE_STATE_CLOSED	= 0x4,
+	SPDK_NVME_ZONE_STATE_RONLY	= 0xD,
+	SPDK_NVME_ZONE_STATE_FULL	= 0xE,
+	SPDK_NVME_ZONE_STATE_OFFLINE	= 0xF,
+};
+
+/** Zone descriptor of a zone report */
+struct spdk_nvme_zns_zone_desc {
+	/** zone type, see \ref spdk_nvme_zns_zone_type */
+	uint8_t			zt : 4;
+	uint8_t			reserved0 : 4;
+
+	uint8_t			reserved1 : 4;
+	/** zone state, see \ref spdk_nvme_zns_zone_state */
+	uint8_t			zs : 4;
+
+	/** zone attributes */
+	struct {
+		uint8_t		zfc : 1;	/* zone finished by controller */
+		uint8_t		fzr : 1;	/* finish zone recommended */
+		uint8_t		rzr : 1;	/* reset zone recommended */
+		uint8_t		reserved : 4;
+		uint8_t		zdev : 1;	/* zone descriptor extension valid */
+	} za;
+
+	uint8_t			reserved3[5];
+
+	/** zone capacity in logical blocks */
+	uint64_t		zcap;
+
+	/** zone start logical block address */
+	uint64_t		zslba;
+
+	/** write pointer */
+	uint64_t		wp;
+
+	uint8_t			reserved32[32];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_zone_desc) == 64, "Incorrect size");
+
+/** Header of the data returned by a zone report */
+struct spdk_nvme_zns_zone_report {
+	/** number of zones matching the report, or returned if the report is partial */
+	uint64_t			nr_zones;
+	uint8_t				reserved8[56];
+	struct spdk_nvme_zns_zone_desc	descs[];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_zone_report) == 64, "Incorrect size");
+
 struct spdk_nvme_ctrlr_list {
 	uint16_t ctrlr_count;
 	uint16_t ctrlr_list[2047];
@@ -102,6 +102,8 @@ struct nvme_tcp_pdu {
 	bool						has_hdgst;
 	bool						ddgst_enable;
 	uint8_t						data_digest[SPDK_NVME_TCP_DIGEST_LEN];
+	/* Data digest computed by an acceleration engine, not yet finalized */
+	uint32_t					data_digest_crc32;
 
 	uint8_t						ch_valid_bytes;
 	uint8_t						psh_valid_bytes;
@@ -529,7 +531,7 @@ nvme_tcp_readv_data(struct spdk_sock *sock, struct iovec *iov, int iovcnt)
 }
 
 
-static int
+static inline int
 nvme_tcp_read_payload_data(struct spdk_sock *sock, struct nvme_tcp_pdu *pdu)
 {
 	struct iovec iov[NVME_TCP_MAX_SGL_DESCRIPTORS + 1];
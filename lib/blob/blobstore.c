@@ -54,7 +54,10 @@ static int bs_register_md_thread(struct spdk_blob_store *bs);
 static int bs_unregister_md_thread(struct spdk_blob_store *bs);
 static void blob_close_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno);
 static void blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
-		uint64_t cluster, uint32_t extent, spdk_blob_op_complete cb_fn, void *cb_arg);
+		uint64_t cluster, uint32_t extent, uint16_t uncopied_units,
+		spdk_blob_op_complete cb_fn, void *cb_arg);
+static void blob_copy_units_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
+		uint16_t units, spdk_blob_op_complete cb_fn, void *cb_arg);
 
 static int blob_set_xattr(struct spdk_blob *blob, const char *name, const void *value,
 			  uint16_t value_len, bool internal);
@@ -118,6 +121,8 @@ bs_claim_cluster(struct spdk_blob_store *bs, uint32_t cluster_num)
 	bs->num_free_clusters--;
 }
 
+static bool blob_cluster_unallocated_in_ancestors(struct spdk_blob *blob, uint32_t cluster_num);
+
 static int
 blob_insert_cluster(struct spdk_blob *blob, uint32_t cluster_num, uint64_t cluster)
 {
@@ -130,18 +135,94 @@ blob_insert_cluster(struct spdk_blob *blob, uint32_t cluster_num, uint64_t clust
 	}
 
 	*cluster_lba = bs_cluster_to_lba(blob->bs, cluster);
+
+	if (blob->clusters_counted) {
+		blob->num_allocated_clusters++;
+		if (!blob_cluster_unallocated_in_ancestors(blob, cluster_num)) {
+			assert(blob->num_shared_clusters > 0);
+			blob->num_shared_clusters--;
+		}
+	}
+
 	return 0;
 }
 
+/* Called with used_clusters_mutex held. Searching from bs->first_free_cluster
+ * instead of the beginning of the array keeps allocation from becoming a scan
+ * over every used cluster as the blobstore fills up.
+ */
+static uint32_t
+bs_find_free_cluster(struct spdk_blob_store *bs, uint32_t start)
+{
+	uint32_t cluster;
+
+	if (start > bs->first_free_cluster) {
+		return spdk_bit_array_find_first_clear(bs->used_clusters, start);
+	}
+
+	cluster = spdk_bit_array_find_first_clear(bs->used_clusters, bs->first_free_cluster);
+	if (cluster == UINT32_MAX) {
+		bs->first_free_cluster = spdk_bit_array_capacity(bs->used_clusters);
+	} else {
+		bs->first_free_cluster = cluster;
+	}
+
+	return cluster;
+}
+
+#define BS_RESERVED_RUN(next, end)	((uint64_t)(end) << 32 | (next))
+
+/* Take the unused part of a channel's reserved run. Can be called from any thread. */
+static uint32_t
+bs_channel_take_reserved(struct spdk_bs_channel *ch, uint32_t *next)
+{
+	uint64_t run = __atomic_exchange_n(&ch->reserved_clusters, 0, __ATOMIC_ACQ_REL);
+
+	*next = (uint32_t)run;
+	return (uint32_t)(run >> 32) - *next;
+}
+
+/* Return the clusters reserved by all channels to the free pool. Called with
+ * used_clusters_mutex held when no free cluster is left.
+ */
+static uint32_t
+bs_reclaim_reserved_clusters(struct spdk_blob_store *bs)
+{
+	struct spdk_bs_channel *ch;
+	uint32_t next, count, total = 0;
+
+	TAILQ_FOREACH(ch, &bs->channels, link) {
+		count = bs_channel_take_reserved(ch, &next);
+		__atomic_fetch_sub(&bs->num_reserved_clusters, count, __ATOMIC_RELAXED);
+		total += count;
+		if (count != 0) {
+			bs->first_free_cluster = spdk_min(bs->first_free_cluster, next);
+		}
+		while (count-- > 0) {
+			spdk_bit_array_clear(bs->used_clusters, next++);
+			bs->num_free_clusters++;
+		}
+	}
+
+	if (total != 0) {
+		SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Reclaimed %u clusters reserved by channels\n", total);
+	}
+
+	return total;
+}
+
 static int
 bs_allocate_cluster(struct spdk_blob *blob, uint32_t cluster_num,
 		    uint64_t *lowest_free_cluster, uint32_t *lowest_free_md_page, bool update_map)
 {
+	uint64_t start = *lowest_free_cluster;
 	uint32_t *extent_page = 0;
 
 	pthread_mutex_lock(&blob->bs->used_clusters_mutex);
-	*lowest_free_cluster = spdk_bit_array_find_first_clear(blob->bs->used_clusters,
-			       *lowest_free_cluster);
+	*lowest_free_cluster = bs_find_free_cluster(blob->bs, start);
+	if (*lowest_free_cluster == UINT32_MAX && bs_reclaim_reserved_clusters(blob->bs) != 0) {
+		*lowest_free_cluster = bs_find_free_cluster(blob->bs, start);
+	}
 	if (*lowest_free_cluster == UINT32_MAX) {
 		/* No more free clusters. Cannot satisfy the request */
 		pthread_mutex_unlock(&blob->bs->used_clusters_mutex);
@@ -190,9 +271,406 @@ bs_release_cluster(struct spdk_blob_store *bs, uint32_t cluster_num)
 	pthread_mutex_lock(&bs->used_clusters_mutex);
 	spdk_bit_array_clear(bs->used_clusters, cluster_num);
 	bs->num_free_clusters++;
+	bs->first_free_cluster = spdk_min(bs->first_free_cluster, cluster_num);
+	pthread_mutex_unlock(&bs->used_clusters_mutex);
+}
+
+/* Clusters are handed out to I/O channels in contiguous runs of up to
+ * BS_CLUSTER_RESERVE_BATCH, so that allocating writes only take
+ * used_clusters_mutex once per run and a blob written from one thread gets
+ * physically contiguous clusters. Runs are only reserved while at least
+ * BS_CLUSTER_RESERVE_MIN_FREE clusters are free. Below that, channels allocate
+ * from the shared pool, and an allocation that finds the pool empty takes back
+ * the runs still held by other channels before failing with -ENOSPC.
+ */
+#define BS_CLUSTER_RESERVE_BATCH	32
+#define BS_CLUSTER_RESERVE_MIN_FREE	(BS_CLUSTER_RESERVE_BATCH * 64)
+
+static void
+bs_channel_reserve_clusters(struct spdk_bs_channel *ch)
+{
+	struct spdk_blob_store *bs = ch->bs;
+	uint32_t capacity, start, cluster;
+
+	pthread_mutex_lock(&bs->used_clusters_mutex);
+	if (bs->num_free_clusters < BS_CLUSTER_RESERVE_MIN_FREE) {
+		pthread_mutex_unlock(&bs->used_clusters_mutex);
+		return;
+	}
+
+	capacity = spdk_bit_array_capacity(bs->used_clusters);
+	start = bs_find_free_cluster(bs, 0);
+	cluster = start;
+	while (cluster < capacity && cluster - start < BS_CLUSTER_RESERVE_BATCH &&
+	       !spdk_bit_array_get(bs->used_clusters, cluster)) {
+		bs_claim_cluster(bs, cluster);
+		cluster++;
+	}
+
+	if (cluster != start) {
+		__atomic_fetch_add(&bs->num_reserved_clusters, cluster - start, __ATOMIC_RELAXED);
+		/* Published under the mutex, a concurrent reclaim sees the whole run or none of it. */
+		__atomic_store_n(&ch->reserved_clusters, BS_RESERVED_RUN(start, cluster),
+				 __ATOMIC_RELEASE);
+	}
 	pthread_mutex_unlock(&bs->used_clusters_mutex);
 }
 
+static void
+bs_channel_release_clusters(struct spdk_bs_channel *ch)
+{
+	struct spdk_blob_store *bs = ch->bs;
+	uint32_t next, count;
+
+	count = bs_channel_take_reserved(ch, &next);
+	__atomic_fetch_sub(&bs->num_reserved_clusters, count, __ATOMIC_RELAXED);
+	while (count-- > 0) {
+		bs_release_cluster(bs, next++);
+	}
+}
+
+/* Hand out the next cluster of the channel's reserved run, unless another thread took it back. */
+static bool
+bs_channel_next_reserved(struct spdk_bs_channel *ch, uint64_t *cluster)
+{
+	uint64_t run = __atomic_load_n(&ch->reserved_clusters, __ATOMIC_ACQUIRE);
+	uint32_t next, end;
+
+	do {
+		next = (uint32_t)run;
+		end = (uint32_t)(run >> 32);
+		if (next == end) {
+			return false;
+		}
+	} while (!__atomic_compare_exchange_n(&ch->reserved_clusters, &run,
+					      next + 1 == end ? 0 : BS_RESERVED_RUN(next + 1, end),
+					      false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	__atomic_fetch_sub(&ch->bs->num_reserved_clusters, 1, __ATOMIC_RELAXED);
+	*cluster = next;
+	return true;
+}
+
+/* Allocate a cluster for an allocating write on the channel's thread. The
+ * cluster is only claimed in used_clusters, it is inserted into the blob's
+ * cluster map on the metadata thread.
+ */
+static int
+bs_channel_allocate_cluster(struct spdk_bs_channel *ch, struct spdk_blob *blob,
+			    uint32_t cluster_num, uint64_t *cluster, uint32_t *extent_page)
+{
+	*cluster = 0;
+	*extent_page = 0;
+
+	if (blob->use_extent_table && *bs_cluster_to_extent_page(blob, cluster_num) == 0) {
+		/* A new extent page has to be claimed as well, that needs the lock anyway. */
+		return bs_allocate_cluster(blob, cluster_num, cluster, extent_page, false);
+	}
+
+	if (!bs_channel_next_reserved(ch, cluster)) {
+		bs_channel_reserve_clusters(ch);
+		if (!bs_channel_next_reserved(ch, cluster)) {
+			return bs_allocate_cluster(blob, cluster_num, cluster, extent_page, false);
+		}
+	}
+
+	SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Using reserved cluster %lu for blob %lu\n",
+		      *cluster, blob->id);
+
+	return 0;
+}
+
+/* Number of units new clones copy clusters from their parent in. The granularity
+ * is rounded up so that a cluster splits into equal units, at most
+ * SPDK_BLOB_COW_UNITS_MAX of them.
+ */
+static uint32_t
+bs_cow_units_per_cluster(struct spdk_blob_store *bs)
+{
+	uint32_t units;
+
+	if (bs->cow_granularity == 0 || bs->cow_granularity >= bs->cluster_sz) {
+		return 1;
+	}
+
+	units = spdk_min(bs->cluster_sz / bs->cow_granularity, SPDK_BLOB_COW_UNITS_MAX);
+	while (units > 1 && bs->pages_per_cluster % units != 0) {
+		units--;
+	}
+
+	return units;
+}
+
+static int
+blob_resize_cow_map(struct spdk_blob *blob, uint64_t num_clusters)
+{
+	uint16_t *tmp;
+
+	if (blob->cow_units_per_cluster == 1 || num_clusters <= blob->cow_map_size) {
+		return 0;
+	}
+
+	tmp = realloc(blob->cow_map, num_clusters * sizeof(*blob->cow_map));
+	if (tmp == NULL) {
+		return -ENOMEM;
+	}
+	memset(tmp + blob->cow_map_size, 0, (num_clusters - blob->cow_map_size) * sizeof(*tmp));
+	blob->cow_map = tmp;
+	blob->cow_map_size = num_clusters;
+
+	return 0;
+}
+
+/* Older versions can't load blobs with partially copied clusters */
+static void
+blob_update_cow_flag(struct spdk_blob *blob)
+{
+	if (blob->cow_units_per_cluster > 1) {
+		blob->invalid_flags |= SPDK_BLOB_COW_MAP;
+	} else {
+		blob->invalid_flags &= ~SPDK_BLOB_COW_MAP;
+	}
+}
+
+/* Change the number of units clusters are copied from back_bs_dev in. The blob
+ * must not have any partially copied clusters.
+ */
+static int
+blob_set_cow_units(struct spdk_blob *blob, uint32_t units)
+{
+	uint16_t *cow_map = NULL;
+	size_t cow_map_size = 0;
+
+	assert(units >= 1 && units <= SPDK_BLOB_COW_UNITS_MAX);
+	assert(blob->cow_map == NULL ||
+	       spdk_mem_all_zero(blob->cow_map, blob->cow_map_size * sizeof(*blob->cow_map)));
+
+	if (units > 1) {
+		cow_map_size = spdk_max(blob->active.num_clusters, 1);
+		cow_map = calloc(cow_map_size, sizeof(*cow_map));
+		if (cow_map == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	free(blob->cow_map);
+	blob->cow_map = cow_map;
+	blob->cow_map_size = cow_map_size;
+	blob->cow_units_per_cluster = units;
+	blob_update_cow_flag(blob);
+
+	return 0;
+}
+
+/* Mask of the units of a cluster that an operation on the given range touches. The
+ * range must not cross a cluster boundary. Zero length writes are used to allocate
+ * clusters and touch all units.
+ */
+static uint16_t
+blob_cow_units_in_range(struct spdk_blob *blob, uint64_t io_unit, uint64_t length)
+{
+	uint32_t first, last;
+
+	if (length == 0) {
+		return (1u << blob->cow_units_per_cluster) - 1;
+	}
+
+	first = bs_io_unit_to_cow_unit(blob, io_unit);
+	last = bs_io_unit_to_cow_unit(blob, io_unit + length - 1);
+	assert(first <= last);
+
+	return ((1u << (last + 1)) - 1) & ~((1u << first) - 1);
+}
+
+/* Check if a write to the given range has to allocate a cluster or copy units first. */
+static bool
+blob_write_needs_copy(struct spdk_blob *blob, uint64_t io_unit, uint64_t length)
+{
+	uint32_t cluster = bs_io_unit_to_cluster_number(blob, io_unit);
+
+	if (blob->active.clusters[cluster] == 0) {
+		return true;
+	}
+
+	return (bs_cluster_uncopied_units(blob, cluster) &
+		blob_cow_units_in_range(blob, io_unit, length)) != 0;
+}
+
+/* Marks clusters in the back LBA cache that none of the snapshots has */
+#define BLOB_BACK_LBA_ZEROES UINT64_MAX
+
+/* Drop the clusters looked up in the snapshots of the blob, and size the cache for
+ * its current number of clusters. A blob without cache reads through back_bs_dev.
+ *
+ * Channel threads read the cache without locks, so it is only reallocated or freed
+ * while I/O to the blob is frozen or before the blob is opened, which is when its
+ * parent and size change. Otherwise the entries are only cleared in place, lookups
+ * past the end of the cache read through back_bs_dev.
+ */
+static void
+blob_back_lba_cache_reset(struct spdk_blob *blob)
+{
+	uint64_t *tmp;
+
+	if (blob->frozen_refcnt == 0 && blob->open_ref > 0) {
+		if (blob->back_lba_cache != NULL) {
+			memset(blob->back_lba_cache, 0,
+			       blob->back_lba_cache_size * sizeof(*blob->back_lba_cache));
+		}
+		return;
+	}
+
+	if (blob->parent_id == SPDK_BLOBID_INVALID || blob->active.num_clusters == 0) {
+		free(blob->back_lba_cache);
+		blob->back_lba_cache = NULL;
+		blob->back_lba_cache_size = 0;
+		return;
+	}
+
+	if (blob->back_lba_cache_size != blob->active.num_clusters) {
+		tmp = realloc(blob->back_lba_cache, blob->active.num_clusters * sizeof(*tmp));
+		if (tmp == NULL) {
+			free(blob->back_lba_cache);
+			blob->back_lba_cache = NULL;
+			blob->back_lba_cache_size = 0;
+			return;
+		}
+		blob->back_lba_cache = tmp;
+		blob->back_lba_cache_size = blob->active.num_clusters;
+	}
+
+	memset(blob->back_lba_cache, 0, blob->back_lba_cache_size * sizeof(*blob->back_lba_cache));
+}
+
+/* The cluster map of the blob or of one of its snapshots changed other than by
+ * allocating a cluster, drop everything derived from it.
+ */
+static void
+blob_cluster_map_changed(struct spdk_blob *blob)
+{
+	blob->clusters_counted = false;
+	blob_back_lba_cache_reset(blob);
+}
+
+/* A chain of snapshots changed, what was derived from it by any open blob may be stale */
+static void
+bs_cluster_maps_changed(struct spdk_blob_store *bs)
+{
+	struct spdk_blob *blob;
+
+	TAILQ_FOREACH(blob, &bs->blobs, link) {
+		blob_cluster_map_changed(blob);
+	}
+}
+
+/* Walk the snapshots of the blob for the nearest one that has the cluster. Returns 0
+ * if the cluster can't be read from there directly, or if one of the snapshots is
+ * frozen while its chain changes.
+ */
+static uint64_t
+blob_back_lba_resolve(struct spdk_blob *blob, uint64_t cluster)
+{
+	struct spdk_blob *parent = blob;
+
+	while (parent->parent_id != SPDK_BLOBID_INVALID) {
+		parent = ((struct spdk_blob_bs_dev *)parent->back_bs_dev)->blob;
+		if (parent->frozen_refcnt > 0) {
+			/* Read through back_bs_dev, which queues the I/O until it is thawed */
+			return 0;
+		}
+		if (cluster >= parent->active.num_clusters) {
+			return 0;
+		}
+
+		if (parent->active.clusters[cluster] != 0) {
+			if (bs_cluster_uncopied_units(parent, cluster) != 0) {
+				return 0;
+			}
+			return parent->active.clusters[cluster];
+		}
+	}
+
+	return spdk_blob_is_thin_provisioned(parent) ? BLOB_BACK_LBA_ZEROES : 0;
+}
+
+/* Given an io_unit the blob doesn't have and the range computed for back_bs_dev, look
+ * up the device to read it from. Returns bs->dev if the data is read right from the
+ * cluster of a snapshot, *lba and *lba_count are updated for the returned device.
+ */
+static struct spdk_bs_dev *
+blob_back_dev_lookup(struct spdk_blob *blob, uint64_t io_unit, uint64_t length,
+		     uint64_t *lba, uint32_t *lba_count)
+{
+	struct spdk_bs_dev *zeroes_dev;
+	uint64_t cluster;
+	uint64_t back_lba;
+
+	if (blob->back_lba_cache == NULL) {
+		return blob->back_bs_dev;
+	}
+
+	cluster = bs_io_unit_to_cluster_number(blob, io_unit);
+	if (spdk_unlikely(cluster >= blob->back_lba_cache_size)) {
+		return blob->back_bs_dev;
+	}
+
+	back_lba = blob->back_lba_cache[cluster];
+	if (back_lba == 0) {
+		back_lba = blob_back_lba_resolve(blob, cluster);
+		if (back_lba == 0) {
+			return blob->back_bs_dev;
+		}
+		blob->back_lba_cache[cluster] = back_lba;
+	}
+
+	if (back_lba == BLOB_BACK_LBA_ZEROES) {
+		zeroes_dev = bs_create_zeroes_dev();
+		*lba = 0;
+		*lba_count = length * blob->bs->io_unit_size / zeroes_dev->blocklen;
+		return zeroes_dev;
+	}
+
+	*lba = back_lba + io_unit % (bs_io_unit_per_page(blob->bs) * blob->bs->pages_per_cluster);
+	*lba_count = length;
+	return blob->bs->dev;
+}
+
+/* Number of io_units until the next point where a read has to be split. Reads of
+ * a partially copied cluster are split where its units switch between copied and
+ * not copied, other reads are only split at cluster boundaries.
+ */
+static uint64_t
+blob_num_io_units_to_read_boundary(struct spdk_blob *blob, uint64_t io_unit)
+{
+	uint64_t io_units_per_unit;
+	uint32_t cluster, unit, end;
+	uint16_t uncopied;
+	bool copied;
+
+	cluster = bs_io_unit_to_cluster_number(blob, io_unit);
+	if (blob->active.clusters[cluster] == 0) {
+		return bs_num_io_units_to_cluster_boundary(blob, io_unit);
+	}
+
+	uncopied = bs_cluster_uncopied_units(blob, cluster);
+	if (uncopied == 0) {
+		return bs_num_io_units_to_cluster_boundary(blob, io_unit);
+	}
+
+	io_units_per_unit = bs_io_unit_per_page(blob->bs) * blob->bs->pages_per_cluster /
+			    blob->cow_units_per_cluster;
+	unit = bs_io_unit_to_cow_unit(blob, io_unit);
+	copied = !(uncopied & (1u << unit));
+	for (end = unit + 1; end < blob->cow_units_per_cluster; end++) {
+		if (copied != !(uncopied & (1u << end))) {
+			break;
+		}
+	}
+
+	return end * io_units_per_unit -
+	       io_unit % (io_units_per_unit * blob->cow_units_per_cluster);
+}
+
 static void
 blob_xattrs_init(struct spdk_blob_xattr_opts *xattrs)
 {
@@ -249,6 +727,9 @@ blob_alloc(struct spdk_blob_store *bs, spdk_blob_id id)
 	TAILQ_INIT(&blob->xattrs_internal);
 	TAILQ_INIT(&blob->pending_persists);
 
+	blob->cow_units_per_cluster = 1;
+	TAILQ_INIT(&blob->cow_copies);
+
 	return blob;
 }
 
@@ -270,7 +751,10 @@ blob_free(struct spdk_blob *blob)
 {
 	assert(blob != NULL);
 	assert(TAILQ_EMPTY(&blob->pending_persists));
+	assert(TAILQ_EMPTY(&blob->cow_copies));
 
+	free(blob->cow_map);
+	free(blob->back_lba_cache);
 	free(blob->active.extent_pages);
 	free(blob->clean.extent_pages);
 	free(blob->active.clusters);
@@ -296,6 +780,13 @@ struct freeze_io_ctx {
 static void
 blob_io_sync(struct spdk_io_channel_iter *i)
 {
+	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(_ch);
+
+	/* Freezing precedes resize and snapshot operations that claim clusters on the
+	 * metadata thread, make the clusters reserved by this channel available to them. */
+	bs_channel_release_clusters(ch);
+
 	spdk_for_each_channel_continue(i, 0);
 }
 
@@ -712,6 +1203,57 @@ blob_parse_page(const struct spdk_blob_md_page *page, struct spdk_blob *blob)
 			assert(desc_extent->start_cluster_idx + cluster_count == blob->active.num_clusters);
 			assert(blob->remaining_clusters_in_et >= cluster_count);
 			blob->remaining_clusters_in_et -= cluster_count;
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_COW_MAP) {
+			struct spdk_blob_md_descriptor_cow_map	*desc_cow_map;
+			size_t					units_length;
+			uint64_t				i, start, count;
+			int					rc;
+
+			desc_cow_map = (struct spdk_blob_md_descriptor_cow_map *)desc;
+			if (desc_cow_map->length < sizeof(*desc_cow_map) - sizeof(*desc)) {
+				return -EINVAL;
+			}
+
+			units_length = desc_cow_map->length -
+				       (sizeof(*desc_cow_map) - sizeof(*desc));
+			if (units_length % sizeof(desc_cow_map->uncopied_units[0]) != 0) {
+				return -EINVAL;
+			}
+
+			if (desc_cow_map->units_per_cluster < 2 ||
+			    desc_cow_map->units_per_cluster > SPDK_BLOB_COW_UNITS_MAX ||
+			    blob->bs->pages_per_cluster % desc_cow_map->units_per_cluster != 0) {
+				return -EINVAL;
+			}
+
+			if (blob->cow_units_per_cluster != 1 &&
+			    blob->cow_units_per_cluster != desc_cow_map->units_per_cluster) {
+				return -EINVAL;
+			}
+			blob->cow_units_per_cluster = desc_cow_map->units_per_cluster;
+
+			start = desc_cow_map->start_cluster_idx;
+			count = units_length / sizeof(desc_cow_map->uncopied_units[0]);
+			if (start + count > blob->active.num_clusters) {
+				return -EINVAL;
+			}
+
+			rc = blob_resize_cow_map(blob, start + count);
+			if (rc != 0) {
+				return rc;
+			}
+
+			for (i = 0; i < count; i++) {
+				uint16_t units = desc_cow_map->uncopied_units[i];
+
+				if (units >= (1u << blob->cow_units_per_cluster)) {
+					return -EINVAL;
+				}
+				if (units != 0 && blob->active.clusters[start + i] == 0) {
+					return -EINVAL;
+				}
+				blob->cow_map[start + i] = units;
+			}
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_XATTR) {
 			int rc;
 
@@ -1056,21 +1598,136 @@ blob_serialize_extents_rle(const struct spdk_blob *blob,
 	return 0;
 }
 
+/* Largest run of fully copied clusters kept inside a single cow map descriptor.
+ * Longer runs start a new descriptor.
+ */
+#define BLOB_COW_MAP_MAX_GAP 8
+
 static void
-blob_serialize_extent_page(const struct spdk_blob *blob,
-			   uint64_t cluster, struct spdk_blob_md_page *page)
+blob_serialize_cow_map_desc(const struct spdk_blob *blob,
+			    uint64_t start_cluster, uint64_t *next_cluster,
+			    uint8_t **buf, size_t *buf_sz)
 {
-	struct spdk_blob_md_descriptor_extent_page *desc_extent;
-	uint64_t i, extent_idx;
-	uint64_t lba, lba_per_cluster;
-	uint64_t start_cluster_idx = (cluster / SPDK_EXTENTS_PER_EP) * SPDK_EXTENTS_PER_EP;
+	struct spdk_blob_md_descriptor_cow_map *desc;
+	size_t cur_sz, min_sz;
+	uint64_t i, count, zeroes;
 
-	desc_extent = (struct spdk_blob_md_descriptor_extent_page *) page->descriptors;
-	desc_extent->type = SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE;
+	/* For extent table blobs the md chain only records the number of units,
+	 * the maps are kept in extent pages. */
+	min_sz = sizeof(*desc);
+	if (!blob->use_extent_table) {
+		min_sz += sizeof(desc->uncopied_units[0]);
+	}
+	if (*buf_sz < min_sz) {
+		*next_cluster = start_cluster;
+		return;
+	}
 
-	lba_per_cluster = bs_cluster_to_lba(blob->bs, 1);
+	desc = (struct spdk_blob_md_descriptor_cow_map *)*buf;
+	desc->type = SPDK_MD_DESCRIPTOR_TYPE_COW_MAP;
+	desc->units_per_cluster = blob->cow_units_per_cluster;
+	desc->start_cluster_idx = start_cluster;
 
-	desc_extent->start_cluster_idx = start_cluster_idx;
+	count = 0;
+	if (!blob->use_extent_table) {
+		cur_sz = sizeof(*desc);
+		zeroes = 0;
+		for (i = start_cluster; i < blob->active.num_clusters; i++) {
+			if (cur_sz + sizeof(desc->uncopied_units[0]) > *buf_sz) {
+				break;
+			}
+			if (blob->cow_map[i] == 0) {
+				if (++zeroes > BLOB_COW_MAP_MAX_GAP) {
+					break;
+				}
+			} else {
+				zeroes = 0;
+			}
+			desc->uncopied_units[count++] = blob->cow_map[i];
+			cur_sz += sizeof(desc->uncopied_units[0]);
+		}
+
+		while (count > 0 && desc->uncopied_units[count - 1] == 0) {
+			count--;
+		}
+	}
+
+	/* Skip to the next partially copied cluster */
+	i = start_cluster + count;
+	while (i < blob->active.num_clusters && (blob->use_extent_table || blob->cow_map[i] == 0)) {
+		i++;
+	}
+	*next_cluster = i;
+
+	desc->length = sizeof(*desc) - sizeof(struct spdk_blob_md_descriptor) +
+		       sizeof(desc->uncopied_units[0]) * count;
+	*buf_sz -= sizeof(struct spdk_blob_md_descriptor) + desc->length;
+	*buf += sizeof(struct spdk_blob_md_descriptor) + desc->length;
+}
+
+static int
+blob_serialize_cow_map(const struct spdk_blob *blob,
+		       struct spdk_blob_md_page **pages,
+		       struct spdk_blob_md_page *cur_page,
+		       uint32_t *page_count, uint8_t **buf,
+		       size_t *remaining_sz)
+{
+	uint64_t	next_cluster;
+	uint8_t		*prev_buf;
+	int		rc;
+
+	if (blob->cow_units_per_cluster == 1) {
+		return 0;
+	}
+
+	/* Start at the first partially copied cluster, the first descriptor is
+	 * always persisted to record the number of units. */
+	next_cluster = 0;
+	while (!blob->use_extent_table && next_cluster < blob->active.num_clusters &&
+	       blob->cow_map[next_cluster] == 0) {
+		next_cluster++;
+	}
+
+	while (true) {
+		prev_buf = *buf;
+		blob_serialize_cow_map_desc(blob, next_cluster, &next_cluster, buf, remaining_sz);
+
+		if (*buf != prev_buf) {
+			if (next_cluster == blob->active.num_clusters) {
+				break;
+			}
+			continue;
+		}
+
+		/* No room left for a descriptor on this page */
+		rc = blob_serialize_add_page(blob, pages, page_count, &cur_page);
+		if (rc < 0) {
+			return rc;
+		}
+
+		*buf = (uint8_t *)cur_page->descriptors;
+		*remaining_sz = sizeof(cur_page->descriptors);
+	}
+
+	return 0;
+}
+
+static void
+blob_serialize_extent_page(const struct spdk_blob *blob,
+			   uint64_t cluster, struct spdk_blob_md_page *page)
+{
+	struct spdk_blob_md_descriptor_extent_page *desc_extent;
+	struct spdk_blob_md_descriptor_cow_map *desc_cow_map;
+	uint64_t i, extent_idx, count;
+	uint64_t lba, lba_per_cluster;
+	uint64_t start_cluster_idx = (cluster / SPDK_EXTENTS_PER_EP) * SPDK_EXTENTS_PER_EP;
+
+	desc_extent = (struct spdk_blob_md_descriptor_extent_page *) page->descriptors;
+	desc_extent->type = SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE;
+
+	lba_per_cluster = bs_cluster_to_lba(blob->bs, 1);
+
+	desc_extent->start_cluster_idx = start_cluster_idx;
 	extent_idx = 0;
 	for (i = start_cluster_idx; i < blob->active.num_clusters; i++) {
 		lba = blob->active.clusters[i];
@@ -1081,6 +1738,34 @@ blob_serialize_extent_page(const struct spdk_blob *blob,
 	}
 	desc_extent->length = sizeof(desc_extent->start_cluster_idx) +
 			      sizeof(desc_extent->cluster_idx[0]) * extent_idx;
+
+	if (blob->cow_units_per_cluster == 1) {
+		return;
+	}
+
+	/* Maps of the clusters in the extent page follow the extents. There is always
+	 * room for them, since SPDK_EXTENTS_PER_EP is rounded down to a power of two. */
+	count = extent_idx;
+	while (count > 0 && blob->cow_map[start_cluster_idx + count - 1] == 0) {
+		count--;
+	}
+	if (count == 0) {
+		return;
+	}
+
+	desc_cow_map = (struct spdk_blob_md_descriptor_cow_map *)((uintptr_t)page->descriptors +
+			sizeof(struct spdk_blob_md_descriptor) + desc_extent->length);
+	assert(sizeof(struct spdk_blob_md_descriptor_extent_page) +
+	       SPDK_EXTENTS_PER_EP * sizeof(uint32_t) +
+	       sizeof(struct spdk_blob_md_descriptor_cow_map) +
+	       SPDK_EXTENTS_PER_EP * sizeof(uint16_t) <= SPDK_BS_MAX_DESC_SIZE);
+	desc_cow_map->type = SPDK_MD_DESCRIPTOR_TYPE_COW_MAP;
+	desc_cow_map->units_per_cluster = blob->cow_units_per_cluster;
+	desc_cow_map->start_cluster_idx = start_cluster_idx;
+	memcpy(desc_cow_map->uncopied_units, &blob->cow_map[start_cluster_idx],
+	       count * sizeof(desc_cow_map->uncopied_units[0]));
+	desc_cow_map->length = sizeof(*desc_cow_map) - sizeof(struct spdk_blob_md_descriptor) +
+			       count * sizeof(desc_cow_map->uncopied_units[0]);
 }
 
 static void
@@ -1208,8 +1893,12 @@ blob_serialize(const struct spdk_blob *blob, struct spdk_blob_md_page **pages,
 		/* Serialize extents */
 		rc = blob_serialize_extents_rle(blob, pages, cur_page, page_count, &buf, &remaining_sz);
 	}
+	if (rc < 0) {
+		return rc;
+	}
 
-	return rc;
+	/* Serialize copy-on-write map */
+	return blob_serialize_cow_map(blob, pages, cur_page, page_count, &buf, &remaining_sz);
 }
 
 struct spdk_blob_load_ctx {
@@ -1243,6 +1932,10 @@ blob_load_final(void *cb_arg, int bserrno)
 	struct spdk_blob_load_ctx	*ctx = cb_arg;
 	struct spdk_blob		*blob = ctx->blob;
 
+	if (bserrno == 0) {
+		bserrno = blob_resize_cow_map(blob, blob->active.num_clusters);
+	}
+
 	if (bserrno == 0) {
 		blob_mark_clean(blob);
 	}
@@ -1264,6 +1957,8 @@ blob_load_snapshot_cpl(void *cb_arg, struct spdk_blob *snapshot, int bserrno)
 		blob->back_bs_dev = bs_create_blob_bs_dev(snapshot);
 		if (blob->back_bs_dev == NULL) {
 			bserrno = -ENOMEM;
+		} else {
+			blob_cluster_map_changed(blob);
 		}
 	}
 	if (bserrno != 0) {
@@ -1524,18 +2219,524 @@ blob_load(spdk_bs_sequence_t *seq, struct spdk_blob *blob,
 struct spdk_blob_persist_ctx {
 	struct spdk_blob		*blob;
 
-	struct spdk_bs_super_block	*super;
-
 	struct spdk_blob_md_page	*pages;
-	uint32_t			next_extent_page;
-	struct spdk_blob_md_page	*extent_page;
+	struct spdk_blob_md_page	*extent_pages;
+	uint32_t			*extent_page_nums;
 
 	spdk_bs_sequence_t		*seq;
 	spdk_bs_sequence_cpl		cb_fn;
 	void				*cb_arg;
 	TAILQ_ENTRY(spdk_blob_persist_ctx) link;
+
+	/* Persists of the same blob that this one writes out as well */
+	TAILQ_HEAD(, spdk_blob_persist_ctx) coalesced;
+};
+
+/* Pages of md writes flushed together are merged into writes of up to this many pages */
+#define SPDK_BS_MD_WRITE_MAX_PAGES 32
+
+/* Pages issued by a single md write, completed along with the rest of its group */
+struct spdk_bs_md_write {
+	struct spdk_blob_md_page	*pages;
+	uint32_t			num_pages;
+	int				bserrno;
+
+	spdk_bs_sequence_t		*seq;
+	spdk_bs_sequence_cpl		cb_fn;
+	void				*cb_arg;
+	TAILQ_ENTRY(spdk_bs_md_write)	link;
+
+	uint32_t			page_nums[0];
+};
+
+struct spdk_bs_md_write_page {
+	uint32_t			page_num;
+	uint32_t			order;
+	struct spdk_blob_md_page	*page;
+	struct spdk_bs_md_write		*write;
 };
 
+/* Device write of a run of consecutive md pages */
+struct spdk_bs_md_write_run {
+	struct spdk_bs_dev_cb_args	cb_args;
+	struct spdk_bs_md_write_group	*group;
+	struct spdk_bs_md_write_page	*pages;
+	uint32_t			num_pages;
+	struct iovec			iov[SPDK_BS_MD_WRITE_MAX_PAGES];
+};
+
+/* All md writes flushed at once */
+struct spdk_bs_md_write_group {
+	uint32_t			outstanding;
+	struct spdk_bs_md_write_page	*pages;
+	struct spdk_bs_md_write_run	*runs;
+	TAILQ_HEAD(, spdk_bs_md_write)	writes;
+};
+
+static int
+bs_md_write_page_cmp(const void *_a, const void *_b)
+{
+	const struct spdk_bs_md_write_page *a = _a;
+	const struct spdk_bs_md_write_page *b = _b;
+
+	if (a->page_num != b->page_num) {
+		return a->page_num < b->page_num ? -1 : 1;
+	}
+
+	return a->order < b->order ? -1 : 1;
+}
+
+static void
+bs_md_write_group_free(struct spdk_bs_md_write_group *group)
+{
+	struct spdk_bs_md_write *write;
+
+	while ((write = TAILQ_FIRST(&group->writes))) {
+		TAILQ_REMOVE(&group->writes, write, link);
+		write->cb_fn(write->seq, write->cb_arg, write->bserrno);
+		free(write);
+	}
+
+	free(group->runs);
+	free(group->pages);
+	free(group);
+}
+
+static void
+bs_md_write_run_cpl(struct spdk_io_channel *channel, void *cb_arg, int bserrno)
+{
+	struct spdk_bs_md_write_run *run = cb_arg;
+	struct spdk_bs_md_write_group *group = run->group;
+	uint32_t i;
+
+	if (bserrno != 0) {
+		for (i = 0; i < run->num_pages; i++) {
+			run->pages[i].write->bserrno = bserrno;
+		}
+	}
+
+	if (--group->outstanding == 0) {
+		bs_md_write_group_free(group);
+	}
+}
+
+static void
+bs_md_writes_fail(struct spdk_blob_store *bs, int bserrno)
+{
+	struct spdk_bs_md_write *write;
+
+	while ((write = TAILQ_FIRST(&bs->md_writes))) {
+		TAILQ_REMOVE(&bs->md_writes, write, link);
+		write->cb_fn(write->seq, write->cb_arg, bserrno);
+		free(write);
+	}
+}
+
+/*
+ * Write out all of the md pages queued since the last flush. Pages of
+ * different blobs that follow each other on the device go out in a single
+ * write, so that syncing many blobs at once takes a handful of writes.
+ */
+static void
+bs_md_writes_flush(void *ctx)
+{
+	struct spdk_blob_store *bs = ctx;
+	struct spdk_bs_channel *channel = spdk_io_channel_get_ctx(bs->md_channel);
+	struct spdk_bs_md_write_group *group;
+	struct spdk_bs_md_write_run *run;
+	struct spdk_bs_md_write *write;
+	uint32_t i, j, num_pages = 0, num_runs = 0;
+	uint64_t lba;
+
+	bs->md_writes_flush_pending = false;
+
+	TAILQ_FOREACH(write, &bs->md_writes, link) {
+		num_pages += write->num_pages;
+	}
+
+	group = calloc(1, sizeof(*group));
+	if (group != NULL) {
+		group->pages = calloc(num_pages, sizeof(*group->pages));
+		group->runs = calloc(num_pages, sizeof(*group->runs));
+	}
+	if (group == NULL || group->pages == NULL || group->runs == NULL) {
+		if (group != NULL) {
+			free(group->pages);
+			free(group->runs);
+			free(group);
+		}
+		bs_md_writes_fail(bs, -ENOMEM);
+		return;
+	}
+
+	TAILQ_INIT(&group->writes);
+	TAILQ_SWAP(&group->writes, &bs->md_writes, spdk_bs_md_write, link);
+
+	num_pages = 0;
+	TAILQ_FOREACH(write, &group->writes, link) {
+		for (i = 0; i < write->num_pages; i++) {
+			group->pages[num_pages].page_num = write->page_nums[i];
+			group->pages[num_pages].order = num_pages;
+			group->pages[num_pages].page = &write->pages[i];
+			group->pages[num_pages].write = write;
+			num_pages++;
+		}
+	}
+
+	qsort(group->pages, num_pages, sizeof(*group->pages), bs_md_write_page_cmp);
+
+	/* A page written more than once, e.g. an extent page updated for each inserted
+	 * cluster, only needs its last contents written. The writes it was part of are
+	 * completed along with the group either way. */
+	for (i = 1, j = 0; i < num_pages; i++) {
+		if (group->pages[i].page_num != group->pages[j].page_num) {
+			j++;
+		}
+		group->pages[j] = group->pages[i];
+	}
+	num_pages = num_pages > 0 ? j + 1 : 0;
+
+	for (i = 0; i < num_pages; i += run->num_pages) {
+		run = &group->runs[num_runs++];
+		run->group = group;
+		run->pages = &group->pages[i];
+		run->num_pages = 1;
+		while (i + run->num_pages < num_pages &&
+		       run->num_pages < SPDK_BS_MD_WRITE_MAX_PAGES &&
+		       run->pages[run->num_pages].page_num ==
+		       run->pages[0].page_num + run->num_pages) {
+			run->num_pages++;
+		}
+	}
+
+	/* Submit only after the group is complete, a run may finish right away */
+	group->outstanding = num_runs;
+	for (i = 0; i < num_runs; i++) {
+		run = &group->runs[i];
+		run->cb_args.cb_fn = bs_md_write_run_cpl;
+		run->cb_args.channel = bs->md_channel;
+		run->cb_args.cb_arg = run;
+
+		lba = bs_md_page_to_lba(bs, run->pages[0].page_num);
+		if (run->num_pages == 1) {
+			channel->dev->write(channel->dev, channel->dev_channel, run->pages[0].page,
+					    lba, bs_byte_to_lba(bs, SPDK_BS_PAGE_SIZE),
+					    &run->cb_args);
+			continue;
+		}
+
+		for (j = 0; j < run->num_pages; j++) {
+			run->iov[j].iov_base = run->pages[j].page;
+			run->iov[j].iov_len = SPDK_BS_PAGE_SIZE;
+		}
+		channel->dev->writev(channel->dev, channel->dev_channel, run->iov, run->num_pages,
+				     lba, bs_byte_to_lba(bs, run->num_pages * SPDK_BS_PAGE_SIZE),
+				     &run->cb_args);
+	}
+}
+
+/*
+ * Write md pages to the given page numbers. The write is deferred until the
+ * current thread iteration is done, to be merged with the md writes of other
+ * blobs issued in the meantime.
+ */
+static void
+bs_md_write_pages(spdk_bs_sequence_t *seq, struct spdk_blob_store *bs,
+		  struct spdk_blob_md_page *pages, const uint32_t *page_nums, uint32_t num_pages,
+		  spdk_bs_sequence_cpl cb_fn, void *cb_arg)
+{
+	struct spdk_bs_md_write *write;
+
+	if (num_pages == 0) {
+		cb_fn(seq, cb_arg, 0);
+		return;
+	}
+
+	write = calloc(1, sizeof(*write) + num_pages * sizeof(*page_nums));
+	if (write == NULL) {
+		cb_fn(seq, cb_arg, -ENOMEM);
+		return;
+	}
+
+	write->pages = pages;
+	memcpy(write->page_nums, page_nums, num_pages * sizeof(*page_nums));
+	write->num_pages = num_pages;
+	write->seq = seq;
+	write->cb_fn = cb_fn;
+	write->cb_arg = cb_arg;
+	TAILQ_INSERT_TAIL(&bs->md_writes, write, link);
+
+	if (!bs->md_writes_flush_pending) {
+		bs->md_writes_flush_pending = true;
+		spdk_thread_send_msg(bs->md_thread, bs_md_writes_flush, bs);
+	}
+}
+
+/* Clusters released by blobs cleared with unmap are unmapped in the background once
+ * the metadata no longer references them, so that a slow deallocate on the device
+ * doesn't hold up the metadata operation. They are only returned to the free pool
+ * once unmapped. Contiguous ranges released meanwhile are merged into one unmap.
+ * An allocation that fails while clusters are still queued drains the queue,
+ * regardless of the rate limit, and is retried.
+ */
+#define BS_UNMAP_MAX_CLUSTERS	256
+
+struct spdk_bs_unmap_range {
+	uint64_t				lba;
+	uint64_t				lba_count;
+	TAILQ_ENTRY(spdk_bs_unmap_range)	link;
+};
+
+struct spdk_bs_unmap_waiter {
+	spdk_bs_op_complete			cb_fn;
+	void					*cb_arg;
+	TAILQ_ENTRY(spdk_bs_unmap_waiter)	link;
+};
+
+static void bs_unmap_next(void *arg);
+
+static int
+bs_unmap_poll(void *arg)
+{
+	struct spdk_blob_store *bs = arg;
+
+	spdk_poller_unregister(&bs->unmap_poller);
+	bs_unmap_next(bs);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+bs_unmap_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_store *bs = cb_arg;
+	uint32_t cluster_num;
+	uint64_t i, num_clusters;
+
+	if (bserrno != 0) {
+		/* The clusters are not referenced anymore, they can be reused anyway */
+		SPDK_ERRLOG("Failed to unmap released clusters: %d\n", bserrno);
+	}
+
+	cluster_num = bs_lba_to_cluster(bs, bs->unmap_lba);
+	num_clusters = bs_lba_to_cluster(bs, bs->unmap_lba_count);
+	for (i = 0; i < num_clusters; i++) {
+		bs_release_cluster(bs, cluster_num + i);
+	}
+	assert(__atomic_load_n(&bs->num_unmap_clusters, __ATOMIC_RELAXED) >= num_clusters);
+	__atomic_fetch_sub(&bs->num_unmap_clusters, num_clusters, __ATOMIC_RELAXED);
+	bs->unmap_lba_count = 0;
+
+	bs_unmap_next(bs);
+}
+
+static void
+bs_unmap_next(void *arg)
+{
+	struct spdk_blob_store *bs = arg;
+	struct spdk_bs_unmap_range *range;
+	struct spdk_bs_unmap_waiter *waiter;
+	struct spdk_bs_cpl cpl;
+	spdk_bs_batch_t *batch;
+	uint64_t now, delay_us;
+
+	range = TAILQ_FIRST(&bs->unmap_ranges);
+	if (range == NULL) {
+		bs->unmap_busy = false;
+		while ((waiter = TAILQ_FIRST(&bs->unmap_waiters)) != NULL) {
+			TAILQ_REMOVE(&bs->unmap_waiters, waiter, link);
+			waiter->cb_fn(waiter->cb_arg, 0);
+			free(waiter);
+		}
+		return;
+	}
+
+	/* Nothing is held back while waiting for the queue to drain */
+	if (bs->unmap_ticks_per_cluster != 0 && TAILQ_EMPTY(&bs->unmap_waiters)) {
+		now = spdk_get_ticks();
+		if (now < bs->unmap_next_tsc) {
+			delay_us = (bs->unmap_next_tsc - now) * SPDK_SEC_TO_USEC /
+				   spdk_get_ticks_hz();
+			bs->unmap_poller = SPDK_POLLER_REGISTER(bs_unmap_poll, bs, delay_us);
+			return;
+		}
+	}
+
+	bs->unmap_lba = range->lba;
+	bs->unmap_lba_count = spdk_min(range->lba_count,
+				       bs_cluster_to_lba(bs, BS_UNMAP_MAX_CLUSTERS));
+	range->lba += bs->unmap_lba_count;
+	range->lba_count -= bs->unmap_lba_count;
+	if (range->lba_count == 0) {
+		TAILQ_REMOVE(&bs->unmap_ranges, range, link);
+		free(range);
+	}
+
+	bs->unmap_next_tsc = spdk_get_ticks() + bs->unmap_ticks_per_cluster *
+			     bs_lba_to_cluster(bs, bs->unmap_lba_count);
+
+	cpl.type = SPDK_BS_CPL_TYPE_BS_BASIC;
+	cpl.u.bs_basic.cb_fn = bs_unmap_cpl;
+	cpl.u.bs_basic.cb_arg = bs;
+
+	batch = bs_batch_open(bs->md_channel, &cpl);
+	if (batch == NULL) {
+		bs_unmap_cpl(bs, -ENOMEM);
+		return;
+	}
+
+	bs_batch_unmap_dev(batch, bs->unmap_lba, bs->unmap_lba_count);
+	bs_batch_close(batch);
+}
+
+/* Queue a released cluster for unmap. Returns an error if the cluster can't be queued,
+ * it is then up to the caller to release it right away.
+ */
+static int
+bs_unmap_defer(struct spdk_blob_store *bs, uint64_t lba)
+{
+	struct spdk_bs_unmap_range *range, *next;
+	uint64_t lba_count = bs_cluster_to_lba(bs, 1);
+
+	/* Clusters are mostly released in increasing order, look from the end */
+	TAILQ_FOREACH_REVERSE(range, &bs->unmap_ranges, spdk_bs_unmap_ranges, link) {
+		if (range->lba <= lba) {
+			break;
+		}
+	}
+
+	if (range != NULL && range->lba + range->lba_count == lba) {
+		range->lba_count += lba_count;
+	} else {
+		next = calloc(1, sizeof(*next));
+		if (next == NULL) {
+			return -ENOMEM;
+		}
+		next->lba = lba;
+		next->lba_count = lba_count;
+		if (range != NULL) {
+			TAILQ_INSERT_AFTER(&bs->unmap_ranges, range, next, link);
+		} else {
+			TAILQ_INSERT_HEAD(&bs->unmap_ranges, next, link);
+		}
+		range = next;
+	}
+
+	next = TAILQ_NEXT(range, link);
+	if (next != NULL && range->lba + range->lba_count == next->lba) {
+		range->lba_count += next->lba_count;
+		TAILQ_REMOVE(&bs->unmap_ranges, next, link);
+		free(next);
+	}
+
+	__atomic_fetch_add(&bs->num_unmap_clusters, 1, __ATOMIC_RELAXED);
+
+	if (!bs->unmap_busy) {
+		/* Let the rest of the clusters released by this operation queue up first */
+		bs->unmap_busy = true;
+		spdk_thread_send_msg(bs->md_thread, bs_unmap_next, bs);
+	}
+
+	return 0;
+}
+
+/* Wait for the clusters queued for unmap to be unmapped and released, regardless of
+ * the rate limit.
+ */
+static void
+bs_unmap_drain(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_bs_unmap_waiter *waiter;
+
+	if (!bs->unmap_busy) {
+		cb_fn(cb_arg, 0);
+		return;
+	}
+
+	waiter = calloc(1, sizeof(*waiter));
+	if (waiter == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+	waiter->cb_fn = cb_fn;
+	waiter->cb_arg = cb_arg;
+	TAILQ_INSERT_TAIL(&bs->unmap_waiters, waiter, link);
+
+	if (bs->unmap_poller != NULL) {
+		spdk_poller_unregister(&bs->unmap_poller);
+		bs_unmap_next(bs);
+	}
+}
+
+struct spdk_bs_user_op_unmap_ctx {
+	struct spdk_blob_store	*bs;
+	struct spdk_thread	*thread;
+	spdk_bs_user_op_t	*op;
+	int			rc;
+};
+
+static void
+bs_user_op_unmap_retry(void *arg)
+{
+	struct spdk_bs_user_op_unmap_ctx *ctx = arg;
+
+	if (ctx->rc == 0) {
+		bs_user_op_execute(ctx->op);
+	} else {
+		bs_user_op_abort(ctx->op);
+	}
+	free(ctx);
+}
+
+static void
+bs_user_op_unmap_drained(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_user_op_unmap_ctx *ctx = cb_arg;
+
+	ctx->rc = bserrno;
+	spdk_thread_send_msg(ctx->thread, bs_user_op_unmap_retry, ctx);
+}
+
+static void
+bs_user_op_unmap_drain(void *arg)
+{
+	struct spdk_bs_user_op_unmap_ctx *ctx = arg;
+
+	bs_unmap_drain(ctx->bs, bs_user_op_unmap_drained, ctx);
+}
+
+/* Called from the channel thread when a cluster can't be allocated for a user op.
+ * If released clusters are still queued for unmap, the op is re-executed once they
+ * are back in the free pool. Returns an error if the op can't be retried.
+ */
+static int
+bs_user_op_retry_after_unmap(struct spdk_blob_store *bs, spdk_bs_user_op_t *op)
+{
+	struct spdk_bs_user_op_unmap_ctx *ctx;
+
+	if (__atomic_load_n(&bs->num_unmap_clusters, __ATOMIC_RELAXED) == 0) {
+		return -ENOSPC;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+	ctx->bs = bs;
+	ctx->thread = spdk_get_thread();
+	ctx->op = op;
+
+	spdk_thread_send_msg(bs->md_thread, bs_user_op_unmap_drain, ctx);
+	return 0;
+}
+
+static bool
+blob_clear_deferred(struct spdk_blob *blob)
+{
+	return blob->clear_method == BLOB_CLEAR_WITH_DEFAULT ||
+	       blob->clear_method == BLOB_CLEAR_WITH_UNMAP;
+}
+
 static void
 bs_batch_clear_dev(struct spdk_blob_persist_ctx *ctx, spdk_bs_batch_t *batch, uint64_t lba,
 		   uint32_t lba_count)
@@ -1555,12 +2756,14 @@ bs_batch_clear_dev(struct spdk_blob_persist_ctx *ctx, spdk_bs_batch_t *batch, ui
 }
 
 static void blob_persist_check_dirty(struct spdk_blob_persist_ctx *ctx);
+static void bs_mark_dirty(spdk_bs_sequence_t *seq, struct spdk_blob_store *bs, uint32_t page,
+			  spdk_bs_sequence_cpl cb_fn, void *cb_arg);
 
 static void
 blob_persist_complete(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_blob_persist_ctx	*ctx = cb_arg;
-	struct spdk_blob_persist_ctx	*next_persist;
+	struct spdk_blob_persist_ctx	*next_persist, *coalesced;
 	struct spdk_blob		*blob = ctx->blob;
 
 	if (bserrno == 0) {
@@ -1571,10 +2774,24 @@ blob_persist_complete(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	TAILQ_REMOVE(&blob->pending_persists, ctx, link);
 
 	next_persist = TAILQ_FIRST(&blob->pending_persists);
+	if (next_persist != NULL) {
+		/* The next persist writes out all of the changes made so far, so it
+		 * completes the others queued up to now as well. */
+		TAILQ_REMOVE(&blob->pending_persists, next_persist, link);
+		TAILQ_SWAP(&next_persist->coalesced, &blob->pending_persists,
+			   spdk_blob_persist_ctx, link);
+		TAILQ_INSERT_HEAD(&blob->pending_persists, next_persist, link);
+	}
 
 	/* Call user callback */
 	ctx->cb_fn(seq, ctx->cb_arg, bserrno);
 
+	while ((coalesced = TAILQ_FIRST(&ctx->coalesced))) {
+		TAILQ_REMOVE(&ctx->coalesced, coalesced, link);
+		coalesced->cb_fn(coalesced->seq, coalesced->cb_arg, bserrno);
+		free(coalesced);
+	}
+
 	/* Free the memory */
 	spdk_free(ctx->pages);
 	free(ctx);
@@ -1603,7 +2820,13 @@ blob_persist_clear_clusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserr
 
 		/* Nothing to release if it was not allocated */
 		if (blob->active.clusters[i] != 0) {
-			bs_release_cluster(bs, cluster_num);
+			if (!blob_clear_deferred(blob) ||
+			    bs_unmap_defer(bs, blob->active.clusters[i]) != 0) {
+				bs_release_cluster(bs, cluster_num);
+			}
+		}
+		if (i < blob->cow_map_size) {
+			blob->cow_map[i] = 0;
 		}
 	}
 
@@ -1648,6 +2871,12 @@ blob_persist_clear_clusters(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		return;
 	}
 
+	if (blob_clear_deferred(blob)) {
+		/* Unmapped once released, see bs_unmap_defer() */
+		blob_persist_clear_clusters_cpl(seq, ctx, 0);
+		return;
+	}
+
 	/* Clusters don't move around in blobs. The list shrinks or grows
 	 * at the end, but no changes ever occur in the middle of the list.
 	 */
@@ -1773,9 +3002,6 @@ blob_persist_write_page_root(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	struct spdk_blob_persist_ctx	*ctx = cb_arg;
 	struct spdk_blob		*blob = ctx->blob;
 	struct spdk_blob_store		*bs = blob->bs;
-	uint64_t			lba;
-	uint32_t			lba_count;
-	struct spdk_blob_md_page	*page;
 
 	if (bserrno != 0) {
 		blob_persist_complete(seq, ctx, bserrno);
@@ -1788,14 +3014,10 @@ blob_persist_write_page_root(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		return;
 	}
 
-	lba_count = bs_byte_to_lba(bs, sizeof(*page));
-
-	page = &ctx->pages[0];
 	/* The first page in the metadata goes where the blobid indicates */
-	lba = bs_md_page_to_lba(bs, bs_blobid_to_page(blob->id));
-
-	bs_sequence_write_dev(seq, page, lba, lba_count,
-			      blob_persist_zero_pages, ctx);
+	assert(blob->active.pages[0] == bs_blobid_to_page(blob->id));
+	bs_md_write_pages(seq, bs, &ctx->pages[0], &blob->active.pages[0], 1,
+			  blob_persist_zero_pages, ctx);
 }
 
 static void
@@ -1804,10 +3026,6 @@ blob_persist_write_page_chain(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno
 	struct spdk_blob_persist_ctx	*ctx = cb_arg;
 	struct spdk_blob		*blob = ctx->blob;
 	struct spdk_blob_store		*bs = blob->bs;
-	uint64_t			lba;
-	uint32_t			lba_count;
-	struct spdk_blob_md_page	*page;
-	spdk_bs_batch_t			*batch;
 	size_t				i;
 
 	if (bserrno != 0) {
@@ -1819,23 +3037,15 @@ blob_persist_write_page_chain(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno
 	 * at the end, but no changes ever occur in the middle of the list.
 	 */
 
-	lba_count = bs_byte_to_lba(bs, sizeof(*page));
-
-	batch = bs_sequence_to_batch(seq, blob_persist_write_page_root, ctx);
-
 	/* This starts at 1. The root page is not written until
 	 * all of the others are finished
 	 */
 	for (i = 1; i < blob->active.num_pages; i++) {
-		page = &ctx->pages[i];
-		assert(page->sequence_num == i);
-
-		lba = bs_md_page_to_lba(bs, blob->active.pages[i]);
-
-		bs_batch_write_dev(batch, page, lba, lba_count);
+		assert(ctx->pages[i].sequence_num == i);
 	}
 
-	bs_batch_close(batch);
+	bs_md_write_pages(seq, bs, &ctx->pages[1], &blob->active.pages[1],
+			  blob->active.num_pages - 1, blob_persist_write_page_root, ctx);
 }
 
 static int
@@ -1913,6 +3123,10 @@ blob_resize(struct spdk_blob *blob, uint64_t sz)
 		blob->active.clusters = tmp;
 		blob->active.cluster_array_size = sz;
 
+		if (blob_resize_cow_map(blob, sz) != 0) {
+			return -ENOMEM;
+		}
+
 		/* Expand the extents table, only if enough clusters were added */
 		if (new_num_ep > current_num_ep && blob->use_extent_table) {
 			ep_tmp = realloc(blob->active.extent_pages, sizeof(*blob->active.extent_pages) * new_num_ep);
@@ -1940,6 +3154,7 @@ blob_resize(struct spdk_blob *blob, uint64_t sz)
 
 	blob->active.num_clusters = sz;
 	blob->active.num_extent_pages = new_num_ep;
+	blob_cluster_map_changed(blob);
 
 	return 0;
 }
@@ -2001,31 +3216,43 @@ blob_persist_generate_new_md(struct spdk_blob_persist_ctx *ctx)
 	ctx->pages[i - 1].crc = blob_md_page_calc_crc(&ctx->pages[i - 1]);
 	/* Start writing the metadata from last page to first */
 	blob->state = SPDK_BLOB_STATE_CLEAN;
-	blob_persist_write_page_chain(seq, ctx, 0);
+	/* Pages past the first one were claimed in ascending order */
+	bs_mark_dirty(seq, bs, spdk_max(blob->active.pages[0],
+					blob->active.pages[blob->active.num_pages - 1]),
+		      blob_persist_write_page_chain, ctx);
 }
 
 static void
-blob_persist_write_extent_pages(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+blob_persist_write_extent_pages_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_blob_persist_ctx	*ctx = cb_arg;
-	struct spdk_blob		*blob = ctx->blob;
-	size_t				i;
-	uint32_t			extent_page_id;
-	uint32_t                        page_count = 0;
-	int				rc;
 
-	if (ctx->extent_page != NULL) {
-		spdk_free(ctx->extent_page);
-		ctx->extent_page = NULL;
-	}
+	spdk_free(ctx->extent_pages);
+	ctx->extent_pages = NULL;
+	free(ctx->extent_page_nums);
+	ctx->extent_page_nums = NULL;
 
 	if (bserrno != 0) {
 		blob_persist_complete(seq, ctx, bserrno);
 		return;
 	}
 
-	/* Only write out changed extent pages */
-	for (i = ctx->next_extent_page; i < blob->active.num_extent_pages; i++) {
+	blob_persist_generate_new_md(ctx);
+}
+
+static void
+blob_persist_write_extent_pages(struct spdk_blob_persist_ctx *ctx)
+{
+	spdk_bs_sequence_t		*seq = ctx->seq;
+	struct spdk_blob		*blob = ctx->blob;
+	struct spdk_blob_md_page	*page;
+	size_t				i;
+	uint32_t			extent_page_id;
+	uint32_t			page_count = 0;
+
+	/* Only write out changed extent pages. The ones written before only change when a
+	 * cluster is inserted, and are written out right then. */
+	for (i = 0; i < blob->active.num_extent_pages; i++) {
 		extent_page_id = blob->active.extent_pages[i];
 		if (extent_page_id == 0) {
 			/* No Extent Page to persist */
@@ -2035,28 +3262,52 @@ blob_persist_write_extent_pages(spdk_bs_sequence_t *seq, void *cb_arg, int bserr
 		/* Writing out new extent page for the first time. Either active extent pages is larger
 		 * than clean extent pages or there was no extent page assigned due to thin provisioning. */
 		if (i >= blob->clean.extent_pages_array_size || blob->clean.extent_pages[i] == 0) {
-			blob->state = SPDK_BLOB_STATE_DIRTY;
-			assert(spdk_bit_array_get(blob->bs->used_md_pages, extent_page_id));
-			ctx->next_extent_page = i + 1;
-			rc = blob_serialize_add_page(ctx->blob, &ctx->extent_page, &page_count, &ctx->extent_page);
-			if (rc < 0) {
-				blob_persist_complete(seq, ctx, rc);
-				return;
-			}
+			page_count++;
+		} else {
+			assert(blob->clean.extent_pages[i] != 0);
+		}
+	}
 
-			blob_serialize_extent_page(blob, i * SPDK_EXTENTS_PER_EP, ctx->extent_page);
+	if (page_count == 0) {
+		if (blob->state == SPDK_BLOB_STATE_CLEAN) {
+			/* A persist queued before this one already wrote everything out */
+			blob_persist_complete(seq, ctx, 0);
+			return;
+		}
+		blob_persist_generate_new_md(ctx);
+		return;
+	}
 
-			ctx->extent_page->crc = blob_md_page_calc_crc(ctx->extent_page);
+	ctx->extent_pages = spdk_zmalloc(page_count * SPDK_BS_PAGE_SIZE, SPDK_BS_PAGE_SIZE, NULL,
+					 SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	ctx->extent_page_nums = calloc(page_count, sizeof(*ctx->extent_page_nums));
+	if (ctx->extent_pages == NULL || ctx->extent_page_nums == NULL) {
+		blob_persist_write_extent_pages_cpl(seq, ctx, -ENOMEM);
+		return;
+	}
 
-			bs_sequence_write_dev(seq, ctx->extent_page, bs_md_page_to_lba(blob->bs, extent_page_id),
-					      bs_byte_to_lba(blob->bs, SPDK_BS_PAGE_SIZE),
-					      blob_persist_write_extent_pages, ctx);
-			return;
+	/* All of them go out at once, along with md writes of other blobs */
+	blob->state = SPDK_BLOB_STATE_DIRTY;
+	page_count = 0;
+	for (i = 0; i < blob->active.num_extent_pages; i++) {
+		extent_page_id = blob->active.extent_pages[i];
+		if (extent_page_id == 0 ||
+		    (i < blob->clean.extent_pages_array_size && blob->clean.extent_pages[i] != 0)) {
+			continue;
 		}
-		assert(blob->clean.extent_pages[i] != 0);
+
+		assert(spdk_bit_array_get(blob->bs->used_md_pages, extent_page_id));
+		page = &ctx->extent_pages[page_count];
+		page->id = blob->id;
+		page->sequence_num = 0;
+		page->next = SPDK_INVALID_MD_PAGE;
+		blob_serialize_extent_page(blob, i * SPDK_EXTENTS_PER_EP, page);
+		page->crc = blob_md_page_calc_crc(page);
+		ctx->extent_page_nums[page_count++] = extent_page_id;
 	}
 
-	blob_persist_generate_new_md(ctx);
+	bs_md_write_pages(seq, blob->bs, ctx->extent_pages, ctx->extent_page_nums, page_count,
+			  blob_persist_write_extent_pages_cpl, ctx);
 }
 
 static void
@@ -2075,67 +3326,181 @@ blob_persist_start(struct spdk_blob_persist_ctx *ctx)
 
 	}
 
-	blob_persist_write_extent_pages(seq, ctx, 0);
+	blob_persist_write_extent_pages(ctx);
 }
 
 static void
-blob_persist_dirty_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+bs_write_super(spdk_bs_sequence_t *seq, struct spdk_blob_store *bs,
+	       struct spdk_bs_super_block *super, spdk_bs_sequence_cpl cb_fn, void *cb_arg);
+
+/* The md used limit is raised by at least this many pages, or by an eighth of it */
+#define SPDK_BS_MD_USED_LIMIT_STEP 256
+
+struct spdk_bs_mark_dirty_ctx {
+	struct spdk_blob_store		*bs;
+	struct spdk_bs_super_block	*super;
+	uint32_t			page;
+	uint32_t			md_used_limit;
+	spdk_bs_sequence_t		*seq;
+	spdk_bs_sequence_cpl		cb_fn;
+	void				*cb_arg;
+	TAILQ_ENTRY(spdk_bs_mark_dirty_ctx) link;
+};
+
+static void bs_mark_dirty_start(struct spdk_bs_mark_dirty_ctx *ctx);
+
+static void
+bs_mark_dirty_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
-	struct spdk_blob_persist_ctx *ctx = cb_arg;
+	struct spdk_bs_mark_dirty_ctx *ctx = cb_arg;
+	struct spdk_blob_store *bs = ctx->bs;
+	struct spdk_bs_mark_dirty_ctx *waiter;
+	TAILQ_HEAD(, spdk_bs_mark_dirty_ctx) waiters;
 
 	spdk_free(ctx->super);
 
+	if (bserrno == 0) {
+		bs->clean = 0;
+		bs->md_used_limit = ctx->md_used_limit;
+	}
+	bs->super_dirty_in_progress = false;
+
+	/* Each waiter either finds its page covered now or starts the next update */
+	TAILQ_INIT(&waiters);
+	TAILQ_SWAP(&waiters, &bs->mark_dirty_waiters, spdk_bs_mark_dirty_ctx, link);
+	while (!TAILQ_EMPTY(&waiters)) {
+		waiter = TAILQ_FIRST(&waiters);
+		TAILQ_REMOVE(&waiters, waiter, link);
+		bs_mark_dirty_start(waiter);
+	}
+
+	ctx->cb_fn(seq, ctx->cb_arg, bserrno);
+	free(ctx);
+}
+
+static void
+bs_mark_dirty_write(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_bs_mark_dirty_ctx *ctx = cb_arg;
+	struct spdk_blob_store *bs = ctx->bs;
+
 	if (bserrno != 0) {
-		blob_persist_complete(seq, ctx, bserrno);
+		bs_mark_dirty_cpl(seq, ctx, bserrno);
 		return;
 	}
 
-	ctx->blob->bs->clean = 0;
+	ctx->super->clean = 0;
+	if (ctx->super->size == 0) {
+		ctx->super->size = bs->dev->blockcnt * bs->dev->blocklen;
+	}
+
+	ctx->md_used_limit = bs->md_used_limit;
+	if (ctx->page >= ctx->md_used_limit) {
+		/* Leave room for the pages allocated next, so that the super
+		 * block does not have to be written for each of them. */
+		ctx->md_used_limit = spdk_min(bs->md_len, ctx->page +
+					      spdk_max(SPDK_BS_MD_USED_LIMIT_STEP,
+						       bs->md_used_limit / 8));
+	}
+	ctx->super->md_used_limit = ctx->md_used_limit;
+	if (ctx->super->version != SPDK_BS_VERSION_MD_USED_LIMIT) {
+		ctx->super->clean_version = ctx->super->version;
+		ctx->super->version = SPDK_BS_VERSION_MD_USED_LIMIT;
+	}
 
-	blob_persist_start(ctx);
+	bs_write_super(seq, bs, ctx->super, bs_mark_dirty_cpl, ctx);
 }
 
 static void
-bs_write_super(spdk_bs_sequence_t *seq, struct spdk_blob_store *bs,
-	       struct spdk_bs_super_block *super, spdk_bs_sequence_cpl cb_fn, void *cb_arg);
+bs_mark_dirty_start(struct spdk_bs_mark_dirty_ctx *ctx)
+{
+	struct spdk_blob_store *bs = ctx->bs;
+
+	if (!bs->clean && ctx->page < bs->md_used_limit) {
+		ctx->cb_fn(ctx->seq, ctx->cb_arg, 0);
+		free(ctx);
+		return;
+	}
 
+	if (bs->super_dirty_in_progress) {
+		TAILQ_INSERT_TAIL(&bs->mark_dirty_waiters, ctx, link);
+		return;
+	}
+
+	ctx->super = spdk_zmalloc(sizeof(*ctx->super), 0x1000, NULL,
+				  SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (!ctx->super) {
+		ctx->cb_fn(ctx->seq, ctx->cb_arg, -ENOMEM);
+		free(ctx);
+		return;
+	}
+
+	bs->super_dirty_in_progress = true;
+	bs_sequence_read_dev(ctx->seq, ctx->super, bs_page_to_lba(bs, 0),
+			     bs_byte_to_lba(bs, sizeof(*ctx->super)),
+			     bs_mark_dirty_write, ctx);
+}
+
+/*
+ * Must be called before md page is written. Marks the blobstore dirty in the
+ * super block, and raises the md used limit kept there if the page is past
+ * it, so that recovery after a crash reads the page.
+ */
+static void
+bs_mark_dirty(spdk_bs_sequence_t *seq, struct spdk_blob_store *bs, uint32_t page,
+	      spdk_bs_sequence_cpl cb_fn, void *cb_arg)
+{
+	struct spdk_bs_mark_dirty_ctx *ctx;
+
+	if (!bs->clean && page < bs->md_used_limit) {
+		cb_fn(seq, cb_arg, 0);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb_fn(seq, cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->bs = bs;
+	ctx->page = page;
+	ctx->seq = seq;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	bs_mark_dirty_start(ctx);
+}
 
 static void
-blob_persist_dirty(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+blob_persist_dirty_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_blob_persist_ctx *ctx = cb_arg;
 
 	if (bserrno != 0) {
-		spdk_free(ctx->super);
 		blob_persist_complete(seq, ctx, bserrno);
 		return;
 	}
 
-	ctx->super->clean = 0;
-	if (ctx->super->size == 0) {
-		ctx->super->size = ctx->blob->bs->dev->blockcnt * ctx->blob->bs->dev->blocklen;
-	}
-
-	bs_write_super(seq, ctx->blob->bs, ctx->super, blob_persist_dirty_cpl, ctx);
+	blob_persist_start(ctx);
 }
 
 static void
 blob_persist_check_dirty(struct spdk_blob_persist_ctx *ctx)
 {
-	if (ctx->blob->bs->clean) {
-		ctx->super = spdk_zmalloc(sizeof(*ctx->super), 0x1000, NULL,
-					  SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-		if (!ctx->super) {
-			blob_persist_complete(ctx->seq, ctx, -ENOMEM);
-			return;
-		}
+	struct spdk_blob *blob = ctx->blob;
+	uint32_t page = 0;
+	uint64_t i;
 
-		bs_sequence_read_dev(ctx->seq, ctx->super, bs_page_to_lba(ctx->blob->bs, 0),
-				     bs_byte_to_lba(ctx->blob->bs, sizeof(*ctx->super)),
-				     blob_persist_dirty, ctx);
-	} else {
-		blob_persist_start(ctx);
+	/* Pages of the md chain are assigned later and checked before they are written */
+	if (blob->active.num_pages > 0) {
+		page = bs_blobid_to_page(blob->id);
+		for (i = 0; i < blob->active.num_extent_pages; i++) {
+			page = spdk_max(page, blob->active.extent_pages[i]);
+		}
 	}
+
+	bs_mark_dirty(ctx->seq, blob->bs, page, blob_persist_dirty_cpl, ctx);
 }
 
 /* Write a blob to disk */
@@ -2161,7 +3526,7 @@ blob_persist(spdk_bs_sequence_t *seq, struct spdk_blob *blob,
 	ctx->seq = seq;
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
-	ctx->next_extent_page = 0;
+	TAILQ_INIT(&ctx->coalesced);
 
 	/* Multiple blob persists can affect one another, via blob->state or
 	 * blob mutable data changes. To prevent it, queue up the persists. */
@@ -2174,13 +3539,98 @@ blob_persist(spdk_bs_sequence_t *seq, struct spdk_blob *blob,
 	blob_persist_check_dirty(ctx);
 }
 
+static void *
+bs_channel_get_copy_buf(struct spdk_bs_channel *ch)
+{
+	if (ch->num_copy_bufs > 0) {
+		return ch->copy_bufs[--ch->num_copy_bufs];
+	}
+
+	return spdk_malloc(ch->bs->cluster_sz, SPDK_BS_PAGE_SIZE, NULL,
+			   SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+}
+
+static void
+bs_channel_put_copy_buf(struct spdk_bs_channel *ch, void *buf)
+{
+	if (buf == NULL) {
+		return;
+	}
+
+	if (ch->num_copy_bufs < ch->max_copy_bufs) {
+		ch->copy_bufs[ch->num_copy_bufs++] = buf;
+	} else {
+		spdk_free(buf);
+	}
+}
+
+/*
+ * The back_bs_dev of a clone is its snapshot, which lives on the same device.
+ * If the snapshot holds the data of the given range itself, return the LBA of
+ * that data on bs->dev so that it can be copied within the device. Return 0
+ * when the range has to be read through back_bs_dev instead.
+ */
+static uint64_t
+blob_back_dev_copy_lba(struct spdk_blob *blob, uint64_t page, uint64_t num_pages)
+{
+	struct spdk_blob_store *bs = blob->bs;
+	struct spdk_blob *parent;
+	uint32_t cluster_num;
+
+	if (bs->dev->copy == NULL || blob->parent_id == SPDK_BLOBID_INVALID) {
+		return 0;
+	}
+
+	parent = ((struct spdk_blob_bs_dev *)blob->back_bs_dev)->blob;
+	cluster_num = page / bs->pages_per_cluster;
+	assert(cluster_num == (page + num_pages - 1) / bs->pages_per_cluster);
+
+	if (cluster_num >= parent->active.num_clusters ||
+	    parent->active.clusters[cluster_num] == 0 ||
+	    bs_cluster_uncopied_units(parent, cluster_num) != 0) {
+		return 0;
+	}
+
+	return parent->active.clusters[cluster_num] +
+	       bs_page_to_lba(bs, page % bs->pages_per_cluster);
+}
+
+/* Whether none of the blob's ancestors has the cluster allocated, so that it reads as zeroes */
+static bool
+blob_cluster_unallocated_in_ancestors(struct spdk_blob *blob, uint32_t cluster_num)
+{
+	struct spdk_blob *parent = blob;
+
+	while (parent->parent_id != SPDK_BLOBID_INVALID) {
+		parent = ((struct spdk_blob_bs_dev *)parent->back_bs_dev)->blob;
+		if (cluster_num < parent->active.num_clusters &&
+		    parent->active.clusters[cluster_num] != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 struct spdk_blob_copy_cluster_ctx {
 	struct spdk_blob *blob;
 	uint8_t *buf;
 	uint64_t page;
+	uint32_t cluster_number;
 	uint64_t new_cluster;
 	uint32_t new_extent_page;
+	/* Range of the cluster copied from back_bs_dev, in pages from its start */
+	uint64_t copy_page;
+	uint64_t copy_num_pages;
+	/* LBA of the data on bs->dev when it is copied within the device, 0 otherwise */
+	uint64_t copy_src_lba;
+	/* Nothing to copy, the cluster is zeroed instead */
+	bool zeroes;
+	uint16_t uncopied_units;
 	spdk_bs_sequence_t *seq;
+	/* User ops waiting for this cluster, including the one that started the allocation */
+	TAILQ_HEAD(, spdk_bs_request_set) requests;
+	TAILQ_ENTRY(spdk_blob_copy_cluster_ctx) link;
 };
 
 static void
@@ -2188,15 +3638,13 @@ blob_allocate_and_copy_cluster_cpl(void *cb_arg, int bserrno)
 {
 	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
 	struct spdk_bs_request_set *set = (struct spdk_bs_request_set *)ctx->seq;
-	TAILQ_HEAD(, spdk_bs_request_set) requests;
 	spdk_bs_user_op_t *op;
 
-	TAILQ_INIT(&requests);
-	TAILQ_SWAP(&set->channel->need_cluster_alloc, &requests, spdk_bs_request_set, link);
+	TAILQ_REMOVE(&set->channel->cluster_allocs, ctx, link);
 
-	while (!TAILQ_EMPTY(&requests)) {
-		op = TAILQ_FIRST(&requests);
-		TAILQ_REMOVE(&requests, op, link);
+	while (!TAILQ_EMPTY(&ctx->requests)) {
+		op = TAILQ_FIRST(&ctx->requests);
+		TAILQ_REMOVE(&ctx->requests, op, link);
 		if (bserrno == 0) {
 			bs_user_op_execute(op);
 		} else {
@@ -2204,7 +3652,7 @@ blob_allocate_and_copy_cluster_cpl(void *cb_arg, int bserrno)
 		}
 	}
 
-	spdk_free(ctx->buf);
+	bs_channel_put_copy_buf(set->channel, ctx->buf);
 	free(ctx);
 }
 
@@ -2214,10 +3662,10 @@ blob_insert_cluster_cpl(void *cb_arg, int bserrno)
 	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
 
 	if (bserrno) {
-		if (bserrno == -EEXIST) {
+		if (bserrno == -EEXIST || bserrno == -EAGAIN) {
 			/* The metadata insert failed because another thread
-			 * allocated the cluster first. Free our cluster
-			 * but continue without error. */
+			 * allocated the cluster first, or the copy-on-write units
+			 * changed. Free our cluster but continue without error. */
 			bserrno = 0;
 		}
 		bs_release_cluster(ctx->blob->bs, ctx->new_cluster);
@@ -2244,7 +3692,8 @@ blob_write_copy_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	cluster_number = bs_page_to_cluster(ctx->blob->bs, ctx->page);
 
 	blob_insert_cluster_on_md_thread(ctx->blob, cluster_number, ctx->new_cluster,
-					 ctx->new_extent_page, blob_insert_cluster_cpl, ctx);
+					 ctx->new_extent_page, ctx->uncopied_units,
+					 blob_insert_cluster_cpl, ctx);
 }
 
 static void
@@ -2258,35 +3707,75 @@ blob_write_copy(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		return;
 	}
 
-	/* Write whole cluster */
+	/* Write the copied part of the cluster */
 	bs_sequence_write_dev(seq, ctx->buf,
-			      bs_cluster_to_lba(ctx->blob->bs, ctx->new_cluster),
-			      bs_cluster_to_lba(ctx->blob->bs, 1),
+			      bs_cluster_to_lba(ctx->blob->bs, ctx->new_cluster) +
+			      bs_page_to_lba(ctx->blob->bs, ctx->copy_page),
+			      bs_page_to_lba(ctx->blob->bs, ctx->copy_num_pages),
 			      blob_write_copy_cpl, ctx);
 }
 
+static void
+blob_copy_units_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+
+	bs_sequence_finish(ctx->seq, bserrno);
+}
+
+/* Copy the units of an allocated cluster, that the user op needs, from back_bs_dev. */
+static void
+bs_copy_cluster_units(struct spdk_blob *blob, struct spdk_io_channel *_ch,
+		      uint32_t cluster_number, uint16_t units, spdk_bs_user_op_t *op)
+{
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(_ch);
+	struct spdk_blob_copy_cluster_ctx *ctx;
+	struct spdk_bs_cpl cpl;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		bs_user_op_abort(op);
+		return;
+	}
+
+	ctx->blob = blob;
+	ctx->cluster_number = cluster_number;
+	TAILQ_INIT(&ctx->requests);
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = blob_allocate_and_copy_cluster_cpl;
+	cpl.u.blob_basic.cb_arg = ctx;
+
+	ctx->seq = bs_sequence_start(_ch, &cpl);
+	if (!ctx->seq) {
+		free(ctx);
+		bs_user_op_abort(op);
+		return;
+	}
+
+	TAILQ_INSERT_TAIL(&ctx->requests, op, link);
+	TAILQ_INSERT_TAIL(&ch->cluster_allocs, ctx, link);
+
+	blob_copy_units_on_md_thread(blob, cluster_number, units, blob_copy_units_cpl, ctx);
+}
+
 static void
 bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 			     struct spdk_io_channel *_ch,
-			     uint64_t io_unit, spdk_bs_user_op_t *op)
+			     uint64_t io_unit, uint64_t length, spdk_bs_user_op_t *op)
 {
 	struct spdk_bs_cpl cpl;
 	struct spdk_bs_channel *ch;
 	struct spdk_blob_copy_cluster_ctx *ctx;
 	uint32_t cluster_start_page;
 	uint32_t cluster_number;
+	uint32_t units = blob->cow_units_per_cluster;
+	uint16_t touched;
+	uint64_t pages_per_unit;
 	int rc;
 
 	ch = spdk_io_channel_get_ctx(_ch);
 
-	if (!TAILQ_EMPTY(&ch->need_cluster_alloc)) {
-		/* There are already operations pending. Queue this user op
-		 * and return because it will be re-executed when the outstanding
-		 * cluster allocation completes. */
-		TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
-		return;
-	}
-
 	/* Round the io_unit offset down to the first page in the cluster */
 	cluster_start_page = bs_io_unit_to_cluster_start(blob, io_unit);
 
@@ -2294,6 +3783,27 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 	 * cluster is supposed to be at. */
 	cluster_number = bs_io_unit_to_cluster_number(blob, io_unit);
 
+	TAILQ_FOREACH(ctx, &ch->cluster_allocs, link) {
+		if (ctx->blob == blob && ctx->cluster_number == cluster_number) {
+			/* This cluster is already being allocated. Queue this user op
+			 * and return because it will be re-executed when the outstanding
+			 * cluster allocation completes. Allocations of other clusters
+			 * proceed independently. */
+			TAILQ_INSERT_TAIL(&ctx->requests, op, link);
+			return;
+		}
+	}
+
+	touched = units > 1 ? blob_cow_units_in_range(blob, io_unit, length) : 1;
+
+	if (blob->active.clusters[cluster_number] != 0) {
+		/* The cluster is allocated, but some of the units the op touches
+		 * were not copied yet. */
+		assert(bs_cluster_uncopied_units(blob, cluster_number) & touched);
+		bs_copy_cluster_units(blob, _ch, cluster_number, touched, op);
+		return;
+	}
+
 	ctx = calloc(1, sizeof(*ctx));
 	if (!ctx) {
 		bs_user_op_abort(op);
@@ -2304,10 +3814,33 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 
 	ctx->blob = blob;
 	ctx->page = cluster_start_page;
+	ctx->cluster_number = cluster_number;
+	ctx->copy_page = 0;
+	ctx->copy_num_pages = blob->bs->pages_per_cluster;
+	TAILQ_INIT(&ctx->requests);
 
-	if (blob->parent_id != SPDK_BLOBID_INVALID) {
-		ctx->buf = spdk_malloc(blob->bs->cluster_sz, blob->back_bs_dev->blocklen,
-				       NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	/* A cluster that none of the ancestors has is zeroed, without reading it */
+	ctx->zeroes = blob->parent_id != SPDK_BLOBID_INVALID &&
+		      blob_cluster_unallocated_in_ancestors(blob, cluster_number);
+
+	if (blob->parent_id != SPDK_BLOBID_INVALID && !ctx->zeroes && units > 1) {
+		/* Copy only the units from the first to the last one the op touches,
+		 * the rest is copied when it is written to or the blob is inflated. */
+		pages_per_unit = blob->bs->pages_per_cluster / units;
+		ctx->copy_page = (__builtin_ffs(touched) - 1) * pages_per_unit;
+		ctx->copy_num_pages = (32 - __builtin_clz(touched)) * pages_per_unit -
+				      ctx->copy_page;
+		ctx->uncopied_units = ((1u << units) - 1) & ~touched;
+	}
+
+	if (blob->parent_id != SPDK_BLOBID_INVALID && !ctx->zeroes) {
+		ctx->copy_src_lba = blob_back_dev_copy_lba(blob,
+				    cluster_start_page + ctx->copy_page,
+				    ctx->copy_num_pages);
+	}
+
+	if (blob->parent_id != SPDK_BLOBID_INVALID && !ctx->zeroes && ctx->copy_src_lba == 0) {
+		ctx->buf = bs_channel_get_copy_buf(ch);
 		if (!ctx->buf) {
 			SPDK_ERRLOG("DMA allocation for cluster of size = %" PRIu32 " failed.\n",
 				    blob->bs->cluster_sz);
@@ -2317,12 +3850,14 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 		}
 	}
 
-	rc = bs_allocate_cluster(blob, cluster_number, &ctx->new_cluster, &ctx->new_extent_page,
-				 false);
+	rc = bs_channel_allocate_cluster(ch, blob, cluster_number, &ctx->new_cluster,
+					 &ctx->new_extent_page);
 	if (rc != 0) {
-		spdk_free(ctx->buf);
+		bs_channel_put_copy_buf(ch, ctx->buf);
 		free(ctx);
-		bs_user_op_abort(op);
+		if (rc != -ENOSPC || bs_user_op_retry_after_unmap(blob->bs, op) != 0) {
+			bs_user_op_abort(op);
+		}
 		return;
 	}
 
@@ -2333,24 +3868,42 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 	ctx->seq = bs_sequence_start(_ch, &cpl);
 	if (!ctx->seq) {
 		bs_release_cluster(blob->bs, ctx->new_cluster);
-		spdk_free(ctx->buf);
+		bs_channel_put_copy_buf(ch, ctx->buf);
 		free(ctx);
 		bs_user_op_abort(op);
 		return;
 	}
 
-	/* Queue the user op to block other incoming operations */
-	TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
-
-	if (blob->parent_id != SPDK_BLOBID_INVALID) {
+	/* Queue the user op and track the allocation to block other incoming
+	 * operations to the same cluster */
+	TAILQ_INSERT_TAIL(&ctx->requests, op, link);
+	TAILQ_INSERT_TAIL(&ch->cluster_allocs, ctx, link);
+
+	if (ctx->zeroes) {
+		bs_sequence_write_zeroes_dev(ctx->seq,
+					     bs_cluster_to_lba(blob->bs, ctx->new_cluster),
+					     bs_cluster_to_lba(blob->bs, 1),
+					     blob_write_copy_cpl, ctx);
+	} else if (ctx->copy_src_lba != 0) {
+		/* The snapshot's data is on our device, copy it there */
+		bs_sequence_copy_dev(ctx->seq,
+				     bs_cluster_to_lba(blob->bs, ctx->new_cluster) +
+				     bs_page_to_lba(blob->bs, ctx->copy_page),
+				     ctx->copy_src_lba,
+				     bs_page_to_lba(blob->bs, ctx->copy_num_pages),
+				     blob_write_copy_cpl, ctx);
+	} else if (blob->parent_id != SPDK_BLOBID_INVALID) {
 		/* Read cluster from backing device */
 		bs_sequence_read_bs_dev(ctx->seq, blob->back_bs_dev, ctx->buf,
-					bs_dev_page_to_lba(blob->back_bs_dev, cluster_start_page),
-					bs_dev_byte_to_lba(blob->back_bs_dev, blob->bs->cluster_sz),
+					bs_dev_page_to_lba(blob->back_bs_dev,
+							cluster_start_page + ctx->copy_page),
+					bs_dev_byte_to_lba(blob->back_bs_dev,
+							ctx->copy_num_pages * SPDK_BS_PAGE_SIZE),
 					blob_write_copy, ctx);
 	} else {
 		blob_insert_cluster_on_md_thread(ctx->blob, cluster_number, ctx->new_cluster,
-						 ctx->new_extent_page, blob_insert_cluster_cpl, ctx);
+						 ctx->new_extent_page, 0,
+						 blob_insert_cluster_cpl, ctx);
 	}
 }
 
@@ -2397,8 +3950,11 @@ blob_request_submit_op_split_next(void *cb_arg, int bserrno)
 		return;
 	}
 
-	op_length = spdk_min(length, bs_num_io_units_to_cluster_boundary(blob,
-			     offset));
+	if (op_type == SPDK_BLOB_READ) {
+		op_length = spdk_min(length, blob_num_io_units_to_read_boundary(blob, offset));
+	} else {
+		op_length = spdk_min(length, bs_num_io_units_to_cluster_boundary(blob, offset));
+	}
 
 	/* Update length and payload for next operation */
 	ctx->io_units_remaining -= op_length;
@@ -2508,6 +4064,7 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 	switch (op_type) {
 	case SPDK_BLOB_READ: {
 		spdk_bs_batch_t *batch;
+		struct spdk_bs_dev *back_dev;
 
 		batch = bs_batch_open(_ch, &cpl);
 		if (!batch) {
@@ -2519,8 +4076,13 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 			/* Read from the blob */
 			bs_batch_read_dev(batch, payload, lba, lba_count);
 		} else {
-			/* Read from the backing block device */
-			bs_batch_read_bs_dev(batch, blob->back_bs_dev, payload, lba, lba_count);
+			/* Read from the backing block device, or the snapshot that has the data */
+			back_dev = blob_back_dev_lookup(blob, offset, length, &lba, &lba_count);
+			if (back_dev == blob->bs->dev) {
+				bs_batch_read_dev(batch, payload, lba, lba_count);
+			} else {
+				bs_batch_read_bs_dev(batch, back_dev, payload, lba, lba_count);
+			}
 		}
 
 		bs_batch_close(batch);
@@ -2528,7 +4090,7 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 	}
 	case SPDK_BLOB_WRITE:
 	case SPDK_BLOB_WRITE_ZEROES: {
-		if (bs_io_unit_is_allocated(blob, offset)) {
+		if (!blob_write_needs_copy(blob, offset, length)) {
 			/* Write to the blob */
 			spdk_bs_batch_t *batch;
 
@@ -2560,7 +4122,7 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 				return;
 			}
 
-			bs_allocate_and_copy_cluster(blob, _ch, offset, op);
+			bs_allocate_and_copy_cluster(blob, _ch, offset, length, op);
 		}
 		break;
 	}
@@ -2593,6 +4155,8 @@ blob_request_submit_op(struct spdk_blob *blob, struct spdk_io_channel *_channel,
 		       void *payload, uint64_t offset, uint64_t length,
 		       spdk_blob_op_complete cb_fn, void *cb_arg, enum spdk_blob_op_type op_type)
 {
+	uint64_t io_units_to_boundary;
+
 	assert(blob != NULL);
 
 	if (blob->data_ro && op_type != SPDK_BLOB_READ) {
@@ -2604,7 +4168,13 @@ blob_request_submit_op(struct spdk_blob *blob, struct spdk_io_channel *_channel,
 		cb_fn(cb_arg, -EINVAL);
 		return;
 	}
-	if (length <= bs_num_io_units_to_cluster_boundary(blob, offset)) {
+	if (op_type == SPDK_BLOB_READ) {
+		io_units_to_boundary = blob_num_io_units_to_read_boundary(blob, offset);
+	} else {
+		io_units_to_boundary = bs_num_io_units_to_cluster_boundary(blob, offset);
+	}
+
+	if (length <= io_units_to_boundary) {
 		blob_request_submit_op_single(_channel, blob, payload, offset, length,
 					      cb_fn, cb_arg, op_type);
 	} else {
@@ -2652,7 +4222,11 @@ rw_iov_split_next(void *cb_arg, int bserrno)
 	}
 
 	io_unit_offset = ctx->io_unit_offset;
-	io_units_to_boundary = bs_num_io_units_to_cluster_boundary(blob, io_unit_offset);
+	if (ctx->read) {
+		io_units_to_boundary = blob_num_io_units_to_read_boundary(blob, io_unit_offset);
+	} else {
+		io_units_to_boundary = bs_num_io_units_to_cluster_boundary(blob, io_unit_offset);
+	}
 	io_units_count = spdk_min(ctx->io_units_remaining, io_units_to_boundary);
 	/*
 	 * Get index and offset into the original iov array for our current position in the I/O sequence.
@@ -2710,6 +4284,7 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 			   spdk_blob_op_complete cb_fn, void *cb_arg, bool read)
 {
 	struct spdk_bs_cpl	cpl;
+	uint64_t		io_units_to_boundary;
 
 	assert(blob != NULL);
 
@@ -2742,7 +4317,13 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 	 *  in a batch.  That would also require creating an intermediate spdk_bs_cpl that would get called
 	 *  when the batch was completed, to allow for freeing the memory for the iov arrays.
 	 */
-	if (spdk_likely(length <= bs_num_io_units_to_cluster_boundary(blob, offset))) {
+	if (read) {
+		io_units_to_boundary = blob_num_io_units_to_read_boundary(blob, offset);
+	} else {
+		io_units_to_boundary = bs_num_io_units_to_cluster_boundary(blob, offset);
+	}
+
+	if (spdk_likely(length <= io_units_to_boundary)) {
 		uint32_t lba_count;
 		uint64_t lba;
 
@@ -2772,6 +4353,7 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 
 		if (read) {
 			spdk_bs_sequence_t *seq;
+			struct spdk_bs_dev *back_dev;
 
 			seq = bs_sequence_start(_channel, &cpl);
 			if (!seq) {
@@ -2782,11 +4364,18 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 			if (bs_io_unit_is_allocated(blob, offset)) {
 				bs_sequence_readv_dev(seq, iov, iovcnt, lba, lba_count, rw_iov_done, NULL);
 			} else {
-				bs_sequence_readv_bs_dev(seq, blob->back_bs_dev, iov, iovcnt, lba, lba_count,
-							 rw_iov_done, NULL);
+				back_dev = blob_back_dev_lookup(blob, offset, length,
+								&lba, &lba_count);
+				if (back_dev == blob->bs->dev) {
+					bs_sequence_readv_dev(seq, iov, iovcnt, lba, lba_count,
+							      rw_iov_done, NULL);
+				} else {
+					bs_sequence_readv_bs_dev(seq, back_dev, iov, iovcnt,
+								 lba, lba_count, rw_iov_done, NULL);
+				}
 			}
 		} else {
-			if (bs_io_unit_is_allocated(blob, offset)) {
+			if (!blob_write_needs_copy(blob, offset, length)) {
 				spdk_bs_sequence_t *seq;
 
 				seq = bs_sequence_start(_channel, &cpl);
@@ -2807,7 +4396,7 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 					return;
 				}
 
-				bs_allocate_and_copy_cluster(blob, _channel, offset, op);
+				bs_allocate_and_copy_cluster(blob, _channel, offset, length, op);
 			}
 		}
 	} else {
@@ -2913,8 +4502,16 @@ bs_channel_create(void *io_device, void *ctx_buf)
 		return -1;
 	}
 
-	TAILQ_INIT(&channel->need_cluster_alloc);
+	TAILQ_INIT(&channel->cluster_allocs);
+	channel->reserved_clusters = 0;
+	pthread_mutex_lock(&bs->used_clusters_mutex);
+	TAILQ_INSERT_TAIL(&bs->channels, channel, link);
+	pthread_mutex_unlock(&bs->used_clusters_mutex);
 	TAILQ_INIT(&channel->queued_io);
+	channel->num_copy_bufs = 0;
+	/* Clusters larger than the byte limit are copied through a buffer allocated per copy. */
+	channel->max_copy_bufs = spdk_min(SPDK_BS_CHANNEL_COPY_BUFS,
+					  SPDK_BS_CHANNEL_COPY_BUF_BYTES / bs->cluster_sz);
 
 	return 0;
 }
@@ -2923,12 +4520,15 @@ static void
 bs_channel_destroy(void *io_device, void *ctx_buf)
 {
 	struct spdk_bs_channel *channel = ctx_buf;
+	struct spdk_blob_copy_cluster_ctx *ctx;
 	spdk_bs_user_op_t *op;
 
-	while (!TAILQ_EMPTY(&channel->need_cluster_alloc)) {
-		op = TAILQ_FIRST(&channel->need_cluster_alloc);
-		TAILQ_REMOVE(&channel->need_cluster_alloc, op, link);
-		bs_user_op_abort(op);
+	TAILQ_FOREACH(ctx, &channel->cluster_allocs, link) {
+		while (!TAILQ_EMPTY(&ctx->requests)) {
+			op = TAILQ_FIRST(&ctx->requests);
+			TAILQ_REMOVE(&ctx->requests, op, link);
+			bs_user_op_abort(op);
+		}
 	}
 
 	while (!TAILQ_EMPTY(&channel->queued_io)) {
@@ -2937,6 +4537,15 @@ bs_channel_destroy(void *io_device, void *ctx_buf)
 		bs_user_op_abort(op);
 	}
 
+	pthread_mutex_lock(&channel->bs->used_clusters_mutex);
+	TAILQ_REMOVE(&channel->bs->channels, channel, link);
+	pthread_mutex_unlock(&channel->bs->used_clusters_mutex);
+	bs_channel_release_clusters(channel);
+
+	while (channel->num_copy_bufs > 0) {
+		spdk_free(channel->copy_bufs[--channel->num_copy_bufs]);
+	}
+
 	free(channel->req_mem);
 	channel->dev->destroy_channel(channel->dev, channel->dev_channel);
 }
@@ -2946,9 +4555,15 @@ bs_dev_destroy(void *io_device)
 {
 	struct spdk_blob_store *bs = io_device;
 	struct spdk_blob	*blob, *blob_tmp;
+	struct spdk_bs_unmap_range *range;
 
 	bs->dev->destroy(bs->dev);
 
+	while ((range = TAILQ_FIRST(&bs->unmap_ranges))) {
+		TAILQ_REMOVE(&bs->unmap_ranges, range, link);
+		free(range);
+	}
+
 	TAILQ_FOREACH_SAFE(blob, &bs->blobs, link, blob_tmp) {
 		TAILQ_REMOVE(&bs->blobs, blob, link);
 		spdk_bit_array_clear(bs->open_blobids, blob->id);
@@ -3076,6 +4691,7 @@ spdk_bs_opts_init(struct spdk_bs_opts *opts)
 	memset(&opts->bstype, 0, sizeof(opts->bstype));
 	opts->iter_cb_fn = NULL;
 	opts->iter_cb_arg = NULL;
+	opts->cow_granularity = 0;
 }
 
 static int
@@ -3087,6 +4703,13 @@ bs_opts_verify(struct spdk_bs_opts *opts)
 		return -1;
 	}
 
+	if (opts->cow_granularity % SPDK_BS_PAGE_SIZE != 0) {
+		SPDK_ERRLOG("Copy-on-write granularity %" PRIu32
+			    " is not a multiple of page size %d\n",
+			    opts->cow_granularity, SPDK_BS_PAGE_SIZE);
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -3117,6 +4740,10 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 
 	TAILQ_INIT(&bs->blobs);
 	TAILQ_INIT(&bs->snapshots);
+	TAILQ_INIT(&bs->mark_dirty_waiters);
+	TAILQ_INIT(&bs->md_writes);
+	TAILQ_INIT(&bs->unmap_ranges);
+	TAILQ_INIT(&bs->unmap_waiters);
 	bs->dev = dev;
 	bs->md_thread = spdk_get_thread();
 	assert(bs->md_thread != NULL);
@@ -3140,6 +4767,7 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 	}
 
 	bs->max_channel_ops = opts->max_channel_ops;
+	bs->cow_granularity = opts->cow_granularity;
 	bs->super_blob = SPDK_BLOBID_INVALID;
 	memcpy(&bs->bstype, &opts->bstype, sizeof(opts->bstype));
 
@@ -3149,6 +4777,7 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 	bs->open_blobids = spdk_bit_array_create(0);
 
 	pthread_mutex_init(&bs->used_clusters_mutex, NULL);
+	TAILQ_INIT(&bs->channels);
 
 	spdk_io_device_register(bs, bs_channel_create, bs_channel_destroy,
 				sizeof(struct spdk_bs_channel), "blobstore");
@@ -3176,12 +4805,20 @@ struct spdk_bs_load_ctx {
 	struct spdk_bs_super_block	*super;
 
 	struct spdk_bs_md_mask		*mask;
-	bool				in_page_chain;
-	uint32_t			page_index;
-	uint32_t			cur_page;
-	struct spdk_blob_md_page	*page;
+
+	/* Recovery reads the metadata region up to md_scan_end, one window at a time */
+	uint32_t			md_scan_end;
+	uint32_t			window_start;
+	uint32_t			window_len;
+	struct spdk_blob_md_page	*window;
+
+	/* Pages that md chains continue at, outside of the window */
+	uint32_t			num_chain_pages;
+	uint32_t			*chain_page_num;
+	struct spdk_blob_md_page	*chain_pages;
 
 	uint64_t			num_extent_pages;
+	uint64_t			next_extent_page;
 	uint32_t			*extent_page_num;
 	struct spdk_blob_md_page	*extent_pages;
 
@@ -3197,6 +4834,11 @@ bs_load_ctx_fail(struct spdk_bs_load_ctx *ctx, int bserrno)
 {
 	assert(bserrno != 0);
 
+	spdk_free(ctx->window);
+	spdk_free(ctx->chain_pages);
+	free(ctx->chain_page_num);
+	spdk_free(ctx->extent_pages);
+	free(ctx->extent_page_num);
 	spdk_free(ctx->super);
 	bs_sequence_finish(ctx->seq, bserrno);
 	bs_free(ctx->bs);
@@ -3410,6 +5052,10 @@ bs_delete_corrupted_blob(void *cb_arg, int bserrno)
 	for (i = 0; i < ctx->blob->active.num_extent_pages; i++) {
 		ctx->blob->active.extent_pages[i] = 0;
 	}
+	if (ctx->blob->cow_map != NULL) {
+		memset(ctx->blob->cow_map, 0,
+		       ctx->blob->cow_map_size * sizeof(*ctx->blob->cow_map));
+	}
 
 	ctx->blob->md_ro = false;
 
@@ -3599,6 +5245,21 @@ bs_load_used_clusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 			     bs_load_used_blobids_cpl, ctx);
 }
 
+/* One past the highest md page in use */
+static uint32_t
+bs_md_pages_in_use_end(struct spdk_blob_store *bs)
+{
+	uint32_t page, end = 0;
+
+	page = spdk_bit_array_find_first_set(bs->used_md_pages, 0);
+	while (page != UINT32_MAX) {
+		end = page + 1;
+		page = spdk_bit_array_find_first_set(bs->used_md_pages, end);
+	}
+
+	return end;
+}
+
 static void
 bs_load_used_pages_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
@@ -3628,6 +5289,8 @@ bs_load_used_pages_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 
 	spdk_free(ctx->mask);
 
+	ctx->bs->md_used_limit = bs_md_pages_in_use_end(ctx->bs);
+
 	/* Read the used clusters mask */
 	mask_size = ctx->super->used_cluster_mask_len * SPDK_BS_PAGE_SIZE;
 	ctx->mask = spdk_zmalloc(mask_size, 0x1000, NULL, SPDK_ENV_SOCKET_ID_ANY,
@@ -3830,9 +5493,20 @@ static bool bs_load_cur_extent_page_valid(struct spdk_blob_md_page *page)
 		return false;
 	}
 
-	/* It has to be the only descriptor in the page. */
+	/* It can only be followed by the copy-on-write map of its clusters. */
 	if (desc_len + sizeof(*desc) <= sizeof(page->descriptors)) {
 		desc = (struct spdk_blob_md_descriptor *)((uintptr_t)page->descriptors + desc_len);
+		if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_COW_MAP) {
+			desc_len += sizeof(*desc) + desc->length;
+			if (desc_len > sizeof(page->descriptors)) {
+				return false;
+			}
+			if (desc_len + sizeof(*desc) > sizeof(page->descriptors)) {
+				return true;
+			}
+			desc = (struct spdk_blob_md_descriptor *)((uintptr_t)page->descriptors +
+					desc_len);
+		}
 		if (desc->length != 0) {
 			return false;
 		}
@@ -3841,10 +5515,14 @@ static bool bs_load_cur_extent_page_valid(struct spdk_blob_md_page *page)
 	return true;
 }
 
-static bool bs_load_cur_md_page_valid(struct spdk_bs_load_ctx *ctx)
+/* Metadata pages read at once during recovery, and pages per read */
+#define SPDK_BS_LOAD_MD_WINDOW		512
+#define SPDK_BS_LOAD_MD_READ_PAGES	32
+
+static bool
+bs_load_md_page_valid(struct spdk_blob_md_page *page, uint32_t page_num)
 {
 	uint32_t crc;
-	struct spdk_blob_md_page *page = ctx->page;
 
 	crc = blob_md_page_calc_crc(page);
 	if (crc != page->crc) {
@@ -3853,7 +5531,7 @@ static bool bs_load_cur_md_page_valid(struct spdk_bs_load_ctx *ctx)
 
 	/* First page of a sequence should match the blobid. */
 	if (page->sequence_num == 0 &&
-	    bs_page_to_blobid(ctx->cur_page) != page->id) {
+	    bs_page_to_blobid(page_num) != page->id) {
 		return false;
 	}
 	assert(bs_load_cur_extent_page_valid(page) == false);
@@ -3861,9 +5539,6 @@ static bool bs_load_cur_md_page_valid(struct spdk_bs_load_ctx *ctx)
 	return true;
 }
 
-static void
-bs_load_replay_cur_md_page(struct spdk_bs_load_ctx *ctx);
-
 static void
 bs_load_write_used_clusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
@@ -3916,89 +5591,94 @@ bs_load_write_used_md(struct spdk_bs_load_ctx *ctx)
 }
 
 static void
-bs_load_replay_md_chain_cpl(struct spdk_bs_load_ctx *ctx)
+bs_load_replay_md_done(struct spdk_bs_load_ctx *ctx)
 {
 	uint64_t num_md_clusters;
 	uint64_t i;
 
-	ctx->in_page_chain = false;
+	/* Claim all of the clusters used by the metadata */
+	num_md_clusters = spdk_divide_round_up(ctx->super->md_len, ctx->bs->pages_per_cluster);
+	for (i = 0; i < num_md_clusters; i++) {
+		bs_claim_cluster(ctx->bs, i);
+	}
 
-	do {
-		ctx->page_index++;
-	} while (spdk_bit_array_get(ctx->bs->used_md_pages, ctx->page_index) == true);
+	ctx->bs->md_used_limit = spdk_max(ctx->md_scan_end, bs_md_pages_in_use_end(ctx->bs));
 
-	if (ctx->page_index < ctx->super->md_len) {
-		ctx->cur_page = ctx->page_index;
-		bs_load_replay_cur_md_page(ctx);
-	} else {
-		/* Claim all of the clusters used by the metadata */
-		num_md_clusters = spdk_divide_round_up(ctx->super->md_len, ctx->bs->pages_per_cluster);
-		for (i = 0; i < num_md_clusters; i++) {
-			bs_claim_cluster(ctx->bs, i);
-		}
-		spdk_free(ctx->page);
-		bs_load_write_used_md(ctx);
-	}
+	spdk_free(ctx->window);
+	ctx->window = NULL;
+	spdk_free(ctx->chain_pages);
+	ctx->chain_pages = NULL;
+	free(ctx->chain_page_num);
+	ctx->chain_page_num = NULL;
+	spdk_free(ctx->extent_pages);
+	ctx->extent_pages = NULL;
+
+	bs_load_write_used_md(ctx);
 }
 
+static void bs_load_replay_md_window(struct spdk_bs_load_ctx *ctx);
+
+static void
+bs_load_replay_extent_pages(struct spdk_bs_load_ctx *ctx);
+
 static void
 bs_load_replay_extent_page_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_bs_load_ctx *ctx = cb_arg;
 	uint32_t page_num;
-	uint64_t i;
+	uint64_t i, count;
 
 	if (bserrno != 0) {
-		spdk_free(ctx->extent_pages);
 		bs_load_ctx_fail(ctx, bserrno);
 		return;
 	}
 
-	for (i = 0; i < ctx->num_extent_pages; i++) {
+	count = spdk_min(SPDK_BS_LOAD_MD_WINDOW, ctx->num_extent_pages - ctx->next_extent_page);
+	for (i = 0; i < count; i++) {
 		/* Extent pages are only read when present within in chain md.
 		 * Integrity of md is not right if that page was not a valid extent page. */
 		if (bs_load_cur_extent_page_valid(&ctx->extent_pages[i]) != true) {
-			spdk_free(ctx->extent_pages);
 			bs_load_ctx_fail(ctx, -EILSEQ);
 			return;
 		}
 
-		page_num = ctx->extent_page_num[i];
+		page_num = ctx->extent_page_num[ctx->next_extent_page + i];
 		spdk_bit_array_set(ctx->bs->used_md_pages, page_num);
 		if (bs_load_replay_md_parse_page(ctx, &ctx->extent_pages[i])) {
-			spdk_free(ctx->extent_pages);
 			bs_load_ctx_fail(ctx, -EILSEQ);
 			return;
 		}
 	}
 
-	spdk_free(ctx->extent_pages);
-	free(ctx->extent_page_num);
-	ctx->extent_page_num = NULL;
-	ctx->num_extent_pages = 0;
-
-	bs_load_replay_md_chain_cpl(ctx);
+	ctx->next_extent_page += count;
+	bs_load_replay_extent_pages(ctx);
 }
 
+/* Read the extent pages of the blobs found in the window, at most a window worth at a time */
 static void
 bs_load_replay_extent_pages(struct spdk_bs_load_ctx *ctx)
 {
 	spdk_bs_batch_t *batch;
 	uint32_t page;
 	uint64_t lba;
-	uint64_t i;
+	uint64_t i, count;
 
-	ctx->extent_pages = spdk_zmalloc(SPDK_BS_PAGE_SIZE * ctx->num_extent_pages, SPDK_BS_PAGE_SIZE,
-					 NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (!ctx->extent_pages) {
-		bs_load_ctx_fail(ctx, -ENOMEM);
+	if (ctx->next_extent_page == ctx->num_extent_pages) {
+		free(ctx->extent_page_num);
+		ctx->extent_page_num = NULL;
+		ctx->num_extent_pages = 0;
+		ctx->next_extent_page = 0;
+
+		ctx->window_start += ctx->window_len;
+		bs_load_replay_md_window(ctx);
 		return;
 	}
 
 	batch = bs_sequence_to_batch(ctx->seq, bs_load_replay_extent_page_cpl, ctx);
 
-	for (i = 0; i < ctx->num_extent_pages; i++) {
-		page = ctx->extent_page_num[i];
+	count = spdk_min(SPDK_BS_LOAD_MD_WINDOW, ctx->num_extent_pages - ctx->next_extent_page);
+	for (i = 0; i < count; i++) {
+		page = ctx->extent_page_num[ctx->next_extent_page + i];
 		assert(page < ctx->super->md_len);
 		lba = bs_md_page_to_lba(ctx->bs, page);
 		bs_batch_read_dev(batch, &ctx->extent_pages[i], lba,
@@ -4008,69 +5688,185 @@ bs_load_replay_extent_pages(struct spdk_bs_load_ctx *ctx)
 	bs_batch_close(batch);
 }
 
+/*
+ * Claim the md chain that starts at the given valid page, as long as it stays
+ * within the window. On return next holds the page the chain continues at
+ * outside of the window, or SPDK_INVALID_MD_PAGE.
+ */
+static int
+bs_load_replay_md_chain(struct spdk_bs_load_ctx *ctx, struct spdk_blob_md_page *page,
+			uint32_t page_num, uint32_t *next)
+{
+	while (true) {
+		bs_claim_md_page(ctx->bs, page_num);
+		if (page->sequence_num == 0) {
+			spdk_bit_array_set(ctx->bs->used_blobids, page_num);
+		}
+		if (bs_load_replay_md_parse_page(ctx, page)) {
+			return -EILSEQ;
+		}
+
+		page_num = page->next;
+		*next = SPDK_INVALID_MD_PAGE;
+		if (page_num == SPDK_INVALID_MD_PAGE) {
+			return 0;
+		}
+		if (page_num >= ctx->super->md_len) {
+			return -EILSEQ;
+		}
+		if (page_num < ctx->window_start ||
+		    page_num >= ctx->window_start + ctx->window_len) {
+			*next = page_num;
+			return 0;
+		}
+
+		page = &ctx->window[page_num - ctx->window_start];
+		if (spdk_bit_array_get(ctx->bs->used_md_pages, page_num) ||
+		    !bs_load_md_page_valid(page, page_num)) {
+			return 0;
+		}
+	}
+}
+
+static void bs_load_replay_chain_pages(struct spdk_bs_load_ctx *ctx);
+
+static void
+bs_load_replay_chain_pages_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_bs_load_ctx *ctx = cb_arg;
+	struct spdk_blob_md_page *page;
+	uint32_t i, num_chain_pages, page_num, next;
+
+	if (bserrno != 0) {
+		bs_load_ctx_fail(ctx, bserrno);
+		return;
+	}
+
+	/* Chains that go on are collected again, each entry is used before it is overwritten */
+	num_chain_pages = ctx->num_chain_pages;
+	ctx->num_chain_pages = 0;
+	for (i = 0; i < num_chain_pages; i++) {
+		page_num = ctx->chain_page_num[i];
+		page = &ctx->chain_pages[i];
+		if (spdk_bit_array_get(ctx->bs->used_md_pages, page_num) ||
+		    !bs_load_md_page_valid(page, page_num)) {
+			continue;
+		}
+
+		if (bs_load_replay_md_chain(ctx, page, page_num, &next)) {
+			bs_load_ctx_fail(ctx, -EILSEQ);
+			return;
+		}
+		if (next != SPDK_INVALID_MD_PAGE) {
+			ctx->chain_page_num[ctx->num_chain_pages++] = next;
+		}
+	}
+
+	bs_load_replay_chain_pages(ctx);
+}
+
+static void
+bs_load_replay_chain_pages(struct spdk_bs_load_ctx *ctx)
+{
+	spdk_bs_batch_t *batch;
+	uint32_t i;
+
+	if (ctx->num_chain_pages == 0) {
+		bs_load_replay_extent_pages(ctx);
+		return;
+	}
+
+	batch = bs_sequence_to_batch(ctx->seq, bs_load_replay_chain_pages_cpl, ctx);
+
+	for (i = 0; i < ctx->num_chain_pages; i++) {
+		bs_batch_read_dev(batch, &ctx->chain_pages[i],
+				  bs_md_page_to_lba(ctx->bs, ctx->chain_page_num[i]),
+				  bs_byte_to_lba(ctx->bs, SPDK_BS_PAGE_SIZE));
+	}
+
+	bs_batch_close(batch);
+}
+
 static void
-bs_load_replay_md_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+bs_load_replay_md_window_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_bs_load_ctx *ctx = cb_arg;
-	uint32_t page_num;
 	struct spdk_blob_md_page *page;
+	uint32_t i, page_num, next;
 
 	if (bserrno != 0) {
 		bs_load_ctx_fail(ctx, bserrno);
 		return;
 	}
 
-	page_num = ctx->cur_page;
-	page = ctx->page;
-	if (bs_load_cur_md_page_valid(ctx) == true) {
-		if (page->sequence_num == 0 || ctx->in_page_chain == true) {
-			bs_claim_md_page(ctx->bs, page_num);
-			if (page->sequence_num == 0) {
-				spdk_bit_array_set(ctx->bs->used_blobids, page_num);
-			}
-			if (bs_load_replay_md_parse_page(ctx, page)) {
-				bs_load_ctx_fail(ctx, -EILSEQ);
-				return;
-			}
-			if (page->next != SPDK_INVALID_MD_PAGE) {
-				ctx->in_page_chain = true;
-				ctx->cur_page = page->next;
-				bs_load_replay_cur_md_page(ctx);
-				return;
-			}
-			if (ctx->num_extent_pages != 0) {
-				bs_load_replay_extent_pages(ctx);
-				return;
-			}
+	for (i = 0; i < ctx->window_len; i++) {
+		page_num = ctx->window_start + i;
+		page = &ctx->window[i];
+
+		/* Only the first page of a blob starts a chain, the rest is claimed through it */
+		if (page->sequence_num != 0 ||
+		    spdk_bit_array_get(ctx->bs->used_md_pages, page_num) ||
+		    !bs_load_md_page_valid(page, page_num)) {
+			continue;
+		}
+
+		if (bs_load_replay_md_chain(ctx, page, page_num, &next)) {
+			bs_load_ctx_fail(ctx, -EILSEQ);
+			return;
+		}
+		if (next != SPDK_INVALID_MD_PAGE) {
+			ctx->chain_page_num[ctx->num_chain_pages++] = next;
 		}
 	}
-	bs_load_replay_md_chain_cpl(ctx);
+
+	bs_load_replay_chain_pages(ctx);
 }
 
 static void
-bs_load_replay_cur_md_page(struct spdk_bs_load_ctx *ctx)
+bs_load_replay_md_window(struct spdk_bs_load_ctx *ctx)
 {
-	uint64_t lba;
+	spdk_bs_batch_t *batch;
+	uint32_t i, count;
 
-	assert(ctx->cur_page < ctx->super->md_len);
-	lba = bs_md_page_to_lba(ctx->bs, ctx->cur_page);
-	bs_sequence_read_dev(ctx->seq, ctx->page, lba,
-			     bs_byte_to_lba(ctx->bs, SPDK_BS_PAGE_SIZE),
-			     bs_load_replay_md_cpl, ctx);
+	if (ctx->window_start >= ctx->md_scan_end) {
+		bs_load_replay_md_done(ctx);
+		return;
+	}
+
+	ctx->window_len = spdk_min(SPDK_BS_LOAD_MD_WINDOW, ctx->md_scan_end - ctx->window_start);
+
+	/* Split the window into several reads, to keep more than one in flight */
+	batch = bs_sequence_to_batch(ctx->seq, bs_load_replay_md_window_cpl, ctx);
+
+	for (i = 0; i < ctx->window_len; i += count) {
+		count = spdk_min(SPDK_BS_LOAD_MD_READ_PAGES, ctx->window_len - i);
+		bs_batch_read_dev(batch, &ctx->window[i],
+				  bs_md_page_to_lba(ctx->bs, ctx->window_start + i),
+				  bs_byte_to_lba(ctx->bs, count * SPDK_BS_PAGE_SIZE));
+	}
+
+	bs_batch_close(batch);
 }
 
 static void
 bs_load_replay_md(struct spdk_bs_load_ctx *ctx)
 {
-	ctx->page_index = 0;
-	ctx->cur_page = 0;
-	ctx->page = spdk_zmalloc(SPDK_BS_PAGE_SIZE, SPDK_BS_PAGE_SIZE,
-				 NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (!ctx->page) {
+	ctx->window = spdk_zmalloc(SPDK_BS_LOAD_MD_WINDOW * SPDK_BS_PAGE_SIZE, SPDK_BS_PAGE_SIZE,
+				   NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	ctx->chain_pages = spdk_zmalloc(SPDK_BS_LOAD_MD_WINDOW * SPDK_BS_PAGE_SIZE,
+					SPDK_BS_PAGE_SIZE, NULL, SPDK_ENV_SOCKET_ID_ANY,
+					SPDK_MALLOC_DMA);
+	ctx->extent_pages = spdk_zmalloc(SPDK_BS_LOAD_MD_WINDOW * SPDK_BS_PAGE_SIZE,
+					 SPDK_BS_PAGE_SIZE, NULL, SPDK_ENV_SOCKET_ID_ANY,
+					 SPDK_MALLOC_DMA);
+	ctx->chain_page_num = calloc(SPDK_BS_LOAD_MD_WINDOW, sizeof(*ctx->chain_page_num));
+	if (!ctx->window || !ctx->chain_pages || !ctx->extent_pages || !ctx->chain_page_num) {
 		bs_load_ctx_fail(ctx, -ENOMEM);
 		return;
 	}
-	bs_load_replay_cur_md_page(ctx);
+
+	ctx->window_start = 0;
+	bs_load_replay_md_window(ctx);
 }
 
 static void
@@ -4096,10 +5892,13 @@ bs_recover(struct spdk_bs_load_ctx *ctx)
 		return;
 	}
 
-	rc = spdk_bit_array_resize(&ctx->bs->open_blobids, ctx->super->md_len);
-	if (rc < 0) {
-		bs_load_ctx_fail(ctx, -ENOMEM);
-		return;
+	/* Pages past the limit recorded while the blobstore was dirty are not in use. A limit
+	 * in a super block of another version may have been left behind by a version that
+	 * doesn't maintain it, so it is not trusted. */
+	ctx->md_scan_end = ctx->super->md_len;
+	if (ctx->super->version == SPDK_BS_VERSION_MD_USED_LIMIT &&
+	    ctx->super->md_used_limit != 0) {
+		ctx->md_scan_end = spdk_min(ctx->super->md_used_limit, ctx->super->md_len);
 	}
 
 	ctx->bs->num_free_clusters = ctx->bs->total_clusters;
@@ -4114,7 +5913,7 @@ bs_load_super_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	int		rc;
 	static const char zeros[SPDK_BLOBSTORE_TYPE_LENGTH];
 
-	if (ctx->super->version > SPDK_BS_VERSION ||
+	if (ctx->super->version > SPDK_BS_VERSION_MD_USED_LIMIT ||
 	    ctx->super->version < SPDK_BS_INITIAL_VERSION) {
 		bs_load_ctx_fail(ctx, -EILSEQ);
 		return;
@@ -4168,6 +5967,7 @@ bs_load_super_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		ctx->bs->pages_per_cluster_shift = spdk_u32log2(ctx->bs->pages_per_cluster);
 	}
 	ctx->bs->io_unit_size = ctx->super->io_unit_size;
+	ctx->bs->cow_granularity = ctx->super->cow_granularity;
 	rc = spdk_bit_array_resize(&ctx->bs->used_clusters, ctx->bs->total_clusters);
 	if (rc < 0) {
 		bs_load_ctx_fail(ctx, -ENOMEM);
@@ -4175,6 +5975,12 @@ bs_load_super_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	}
 	ctx->bs->md_start = ctx->super->md_start;
 	ctx->bs->md_len = ctx->super->md_len;
+	/* blob_lookup() relies on it, whether the blobstore is recovered or not */
+	rc = spdk_bit_array_resize(&ctx->bs->open_blobids, ctx->super->md_len);
+	if (rc < 0) {
+		bs_load_ctx_fail(ctx, -ENOMEM);
+		return;
+	}
 	ctx->bs->total_data_clusters = ctx->bs->total_clusters - spdk_divide_round_up(
 					       ctx->bs->md_start + ctx->bs->md_len, ctx->bs->pages_per_cluster);
 	ctx->bs->super_blob = ctx->super->super_blob;
@@ -4553,6 +6359,7 @@ spdk_bs_dump(struct spdk_bs_dev *dev, FILE *fp, spdk_bs_dump_print_xattr print_x
 struct spdk_bs_init_ctx {
 	struct spdk_blob_store		*bs;
 	struct spdk_bs_super_block	*super;
+	spdk_bs_sequence_t		*seq;
 };
 
 static void
@@ -4680,6 +6487,7 @@ spdk_bs_init(struct spdk_bs_dev *dev, struct spdk_bs_opts *o,
 	ctx->super->clean = 0;
 	ctx->super->cluster_size = bs->cluster_sz;
 	ctx->super->io_unit_size = bs->io_unit_size;
+	ctx->super->cow_granularity = bs->cow_granularity;
 	memcpy(&ctx->super->bstype, &bs->bstype, sizeof(bs->bstype));
 
 	/* Calculate how many pages the metadata consumes at the front
@@ -4805,12 +6613,23 @@ bs_destroy_trim_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	free(ctx);
 }
 
+static void
+bs_destroy_unmap_drained(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_init_ctx *ctx = cb_arg;
+
+	/* Write zeroes to the super block */
+	bs_sequence_write_zeroes_dev(ctx->seq,
+				     bs_page_to_lba(ctx->bs, 0),
+				     bs_byte_to_lba(ctx->bs, sizeof(struct spdk_bs_super_block)),
+				     bs_destroy_trim_cpl, ctx);
+}
+
 void
 spdk_bs_destroy(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn,
 		void *cb_arg)
 {
 	struct spdk_bs_cpl	cpl;
-	spdk_bs_sequence_t	*seq;
 	struct spdk_bs_init_ctx *ctx;
 
 	SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Destroying blobstore\n");
@@ -4833,18 +6652,15 @@ spdk_bs_destroy(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn,
 
 	ctx->bs = bs;
 
-	seq = bs_sequence_start(bs->md_channel, &cpl);
-	if (!seq) {
+	ctx->seq = bs_sequence_start(bs->md_channel, &cpl);
+	if (!ctx->seq) {
 		free(ctx);
 		cb_fn(cb_arg, -ENOMEM);
 		return;
 	}
 
-	/* Write zeroes to the super block */
-	bs_sequence_write_zeroes_dev(seq,
-				     bs_page_to_lba(bs, 0),
-				     bs_byte_to_lba(bs, sizeof(struct spdk_bs_super_block)),
-				     bs_destroy_trim_cpl, ctx);
+	/* Released clusters must not be unmapped after the blobstore is gone */
+	bs_unmap_drain(bs, bs_destroy_unmap_drained, ctx);
 }
 
 /* END spdk_bs_destroy */
@@ -4893,6 +6709,12 @@ bs_unload_write_used_clusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bse
 	}
 
 	ctx->super->clean = 1;
+	/* Only kept while dirty, a version not aware of it may use the blobstore next */
+	ctx->super->md_used_limit = 0;
+	if (ctx->super->version == SPDK_BS_VERSION_MD_USED_LIMIT) {
+		ctx->super->version = ctx->super->clean_version;
+		ctx->super->clean_version = 0;
+	}
 
 	bs_write_super(seq, ctx->bs, ctx->super, bs_unload_write_super_cpl, ctx);
 }
@@ -4942,6 +6764,18 @@ bs_unload_read_super_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	bs_write_used_md(seq, cb_arg, bs_unload_write_used_pages_cpl);
 }
 
+static void
+bs_unload_unmap_drained(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_load_ctx *ctx = cb_arg;
+	struct spdk_blob_store *bs = ctx->bs;
+
+	/* Read super block */
+	bs_sequence_read_dev(ctx->seq, ctx->super, bs_page_to_lba(bs, 0),
+			     bs_byte_to_lba(bs, sizeof(*ctx->super)),
+			     bs_unload_read_super_cpl, ctx);
+}
+
 void
 spdk_bs_unload(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn, void *cb_arg)
 {
@@ -4972,6 +6806,10 @@ spdk_bs_unload(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn, void *cb_a
 		return;
 	}
 
+	/* The metadata thread's channel lives until the blobstore is freed, return
+	 * its reserved clusters before used_clusters is written out. */
+	bs_channel_release_clusters(spdk_io_channel_get_ctx(bs->md_channel));
+
 	cpl.type = SPDK_BS_CPL_TYPE_BS_BASIC;
 	cpl.u.bs_basic.cb_fn = cb_fn;
 	cpl.u.bs_basic.cb_arg = cb_arg;
@@ -4984,10 +6822,9 @@ spdk_bs_unload(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn, void *cb_a
 		return;
 	}
 
-	/* Read super block */
-	bs_sequence_read_dev(ctx->seq, ctx->super, bs_page_to_lba(bs, 0),
-			     bs_byte_to_lba(bs, sizeof(*ctx->super)),
-			     bs_unload_read_super_cpl, ctx);
+	/* Clusters waiting for unmap are still marked used, they have to be released
+	 * before used_clusters is written out. */
+	bs_unmap_drain(bs, bs_unload_unmap_drained, ctx);
 }
 
 /* END spdk_bs_unload */
@@ -5111,7 +6948,10 @@ spdk_bs_get_io_unit_size(struct spdk_blob_store *bs)
 uint64_t
 spdk_bs_free_cluster_count(struct spdk_blob_store *bs)
 {
-	return bs->num_free_clusters;
+	/* Clusters reserved by channels are taken back when the pool runs dry, so they
+	 * can still be allocated by any blob. */
+	return bs->num_free_clusters +
+	       __atomic_load_n(&bs->num_reserved_clusters, __ATOMIC_RELAXED);
 }
 
 uint64_t
@@ -5120,6 +6960,30 @@ spdk_bs_total_data_cluster_count(struct spdk_blob_store *bs)
 	return bs->total_data_clusters;
 }
 
+uint64_t
+spdk_bs_unmap_pending_cluster_count(struct spdk_blob_store *bs)
+{
+	return __atomic_load_n(&bs->num_unmap_clusters, __ATOMIC_RELAXED);
+}
+
+void
+spdk_bs_set_unmap_rate_limit(struct spdk_blob_store *bs, uint64_t max_bytes_per_sec)
+{
+	if (max_bytes_per_sec == 0) {
+		bs->unmap_ticks_per_cluster = 0;
+	} else {
+		bs->unmap_ticks_per_cluster = spdk_max(spdk_get_ticks_hz() * bs->cluster_sz /
+						       max_bytes_per_sec, 1);
+	}
+	bs->unmap_next_tsc = 0;
+
+	if (bs->unmap_poller != NULL) {
+		/* Start over with the new rate */
+		spdk_poller_unregister(&bs->unmap_poller);
+		bs_unmap_next(bs);
+	}
+}
+
 static int
 bs_register_md_thread(struct spdk_blob_store *bs)
 {
@@ -5168,6 +7032,47 @@ uint64_t spdk_blob_get_num_clusters(struct spdk_blob *blob)
 	return blob->active.num_clusters;
 }
 
+static void
+blob_count_clusters(struct spdk_blob *blob)
+{
+	uint64_t i;
+
+	if (blob->clusters_counted) {
+		return;
+	}
+
+	blob->num_allocated_clusters = 0;
+	blob->num_shared_clusters = 0;
+	for (i = 0; i < blob->active.num_clusters; i++) {
+		if (blob->active.clusters[i] != 0) {
+			blob->num_allocated_clusters++;
+		} else if (!blob_cluster_unallocated_in_ancestors(blob, i)) {
+			blob->num_shared_clusters++;
+		}
+	}
+	blob->clusters_counted = true;
+}
+
+uint64_t
+spdk_blob_get_num_allocated_clusters(struct spdk_blob *blob)
+{
+	assert(blob != NULL);
+	blob_verify_md_op(blob);
+
+	blob_count_clusters(blob);
+	return blob->num_allocated_clusters;
+}
+
+uint64_t
+spdk_blob_get_num_shared_clusters(struct spdk_blob *blob)
+{
+	assert(blob != NULL);
+	blob_verify_md_op(blob);
+
+	blob_count_clusters(blob);
+	return blob->num_shared_clusters;
+}
+
 /* START spdk_bs_create_blob */
 
 static void
@@ -5210,6 +7115,10 @@ blob_set_xattrs(struct spdk_blob *blob, const struct spdk_blob_xattr_opts *xattr
 	return 0;
 }
 
+static void bs_create_blob_resize(struct spdk_blob *blob, uint32_t page_idx,
+				  uint64_t num_clusters, bool drain_unmaps,
+				  spdk_blob_op_with_id_complete cb_fn, void *cb_arg);
+
 static void
 bs_create_blob(struct spdk_blob_store *bs,
 	       const struct spdk_blob_opts *opts,
@@ -5218,10 +7127,8 @@ bs_create_blob(struct spdk_blob_store *bs,
 {
 	struct spdk_blob	*blob;
 	uint32_t		page_idx;
-	struct spdk_bs_cpl	cpl;
 	struct spdk_blob_opts	opts_default;
 	struct spdk_blob_xattr_opts internal_xattrs_default;
-	spdk_bs_sequence_t	*seq;
 	spdk_blob_id		id;
 	int rc;
 
@@ -5286,7 +7193,53 @@ bs_create_blob(struct spdk_blob_store *bs,
 
 	blob_set_clear_method(blob, opts->clear_method);
 
-	rc = blob_resize(blob, opts->num_clusters);
+	bs_create_blob_resize(blob, page_idx, opts->num_clusters, true, cb_fn, cb_arg);
+}
+
+struct spdk_bs_create_resize_ctx {
+	struct spdk_blob		*blob;
+	uint32_t			page_idx;
+	uint64_t			num_clusters;
+	spdk_blob_op_with_id_complete	cb_fn;
+	void				*cb_arg;
+};
+
+static void
+bs_create_blob_unmap_drained(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_create_resize_ctx *ctx = cb_arg;
+
+	/* On error the resize simply fails again with -ENOSPC */
+	bs_create_blob_resize(ctx->blob, ctx->page_idx, ctx->num_clusters, false,
+			      ctx->cb_fn, ctx->cb_arg);
+	free(ctx);
+}
+
+static void
+bs_create_blob_resize(struct spdk_blob *blob, uint32_t page_idx, uint64_t num_clusters,
+		      bool drain_unmaps, spdk_blob_op_with_id_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob_store		*bs = blob->bs;
+	struct spdk_bs_create_resize_ctx *ctx;
+	struct spdk_bs_cpl		cpl;
+	spdk_bs_sequence_t		*seq;
+	int				rc;
+
+	rc = blob_resize(blob, num_clusters);
+	if (rc == -ENOSPC && drain_unmaps &&
+	    __atomic_load_n(&bs->num_unmap_clusters, __ATOMIC_RELAXED) > 0) {
+		/* Retry once the released clusters are unmapped and back in the pool */
+		ctx = calloc(1, sizeof(*ctx));
+		if (ctx != NULL) {
+			ctx->blob = blob;
+			ctx->page_idx = page_idx;
+			ctx->num_clusters = num_clusters;
+			ctx->cb_fn = cb_fn;
+			ctx->cb_arg = cb_arg;
+			bs_unmap_drain(bs, bs_create_blob_unmap_drained, ctx);
+			return;
+		}
+	}
 	if (rc < 0) {
 		blob_free(blob);
 		spdk_bit_array_clear(bs->used_blobids, page_idx);
@@ -5327,6 +7280,69 @@ void spdk_bs_create_blob_ext(struct spdk_blob_store *bs, const struct spdk_blob_
 
 /* START blob_cleanup */
 
+/* Spaces out the clusters copied by an inflate or a snapshot deletion, to stay within
+ * the rate limits of spdk_blob_inflate_opts. */
+struct bs_copy_throttle {
+	uint64_t ticks_per_cluster;
+	uint64_t next_tsc;
+	struct spdk_poller *poller;
+
+	/* Called by the poller once the next cluster can be copied */
+	spdk_blob_op_complete resume_fn;
+	void *resume_arg;
+};
+
+static void
+bs_copy_throttle_init(struct bs_copy_throttle *throttle, struct spdk_blob_store *bs,
+		      const struct spdk_blob_inflate_opts *opts,
+		      spdk_blob_op_complete resume_fn, void *resume_arg)
+{
+	throttle->ticks_per_cluster = 0;
+	if (opts->max_clusters_per_sec != 0) {
+		throttle->ticks_per_cluster = spdk_get_ticks_hz() / opts->max_clusters_per_sec;
+	}
+	if (opts->max_bytes_per_sec != 0) {
+		throttle->ticks_per_cluster = spdk_max(throttle->ticks_per_cluster,
+						       spdk_get_ticks_hz() * bs->cluster_sz /
+						       opts->max_bytes_per_sec);
+	}
+	throttle->next_tsc = 0;
+	throttle->resume_fn = resume_fn;
+	throttle->resume_arg = resume_arg;
+}
+
+static int
+bs_copy_throttle_poll(void *arg)
+{
+	struct bs_copy_throttle *throttle = arg;
+
+	spdk_poller_unregister(&throttle->poller);
+	throttle->resume_fn(throttle->resume_arg, 0);
+
+	return SPDK_POLLER_BUSY;
+}
+
+/* Returns true if the next cluster is copied later, once the poller calls resume_fn */
+static bool
+bs_copy_throttle(struct bs_copy_throttle *throttle)
+{
+	uint64_t now, delay_us;
+
+	if (throttle->ticks_per_cluster == 0) {
+		return false;
+	}
+
+	now = spdk_get_ticks();
+	if (now < throttle->next_tsc) {
+		delay_us = (throttle->next_tsc - now) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+		throttle->poller = SPDK_POLLER_REGISTER(bs_copy_throttle_poll, throttle, delay_us);
+		return true;
+	}
+
+	throttle->next_tsc = now + throttle->ticks_per_cluster;
+	return false;
+}
+
 struct spdk_clone_snapshot_ctx {
 	struct spdk_bs_cpl      cpl;
 	int bserrno;
@@ -5341,6 +7357,20 @@ struct spdk_clone_snapshot_ctx {
 	 * thin-provisioning. Otherwise only decouple parent and keep clone thin. */
 	bool allocate_all;
 
+	/* Record the inflate in the blob's metadata, only done for the _ext calls */
+	bool persist;
+
+	/* Inflate progress and rate limiting */
+	struct spdk_blob_inflate_opts inflate_opts;
+	uint64_t clusters_total;
+	uint64_t clusters_done;
+	uint64_t start_tsc;
+	struct bs_copy_throttle throttle;
+
+	/* Set by spdk_bs_inflate_blob_cancel(), called once the operation stopped */
+	spdk_blob_op_complete cancel_cb_fn;
+	void *cancel_cb_arg;
+
 	struct {
 		spdk_blob_id id;
 		struct spdk_blob *blob;
@@ -5381,6 +7411,10 @@ bs_clone_snapshot_cleanup_finish(void *cb_arg, int bserrno)
 		break;
 	}
 
+	if (ctx->cancel_cb_fn != NULL) {
+		ctx->cancel_cb_fn(ctx->cancel_cb_arg, 0);
+	}
+
 	free(ctx);
 }
 
@@ -5400,6 +7434,9 @@ bs_snapshot_unfreeze_cpl(void *cb_arg, int bserrno)
 
 	ctx->original.id = origblob->id;
 	origblob->locked_operation_in_progress = false;
+	if (origblob->inflate_ctx == ctx) {
+		origblob->inflate_ctx = NULL;
+	}
 
 	spdk_blob_close(origblob, bs_clone_snapshot_cleanup_finish, ctx);
 }
@@ -5454,6 +7491,9 @@ bs_snapshot_swap_cluster_maps(struct spdk_blob *blob1, struct spdk_blob *blob2)
 {
 	uint64_t *cluster_temp;
 	uint32_t *extent_page_temp;
+	uint16_t *cow_map_temp;
+	size_t cow_map_size_temp;
+	uint32_t cow_units_temp;
 
 	cluster_temp = blob1->active.clusters;
 	blob1->active.clusters = blob2->active.clusters;
@@ -5462,6 +7502,22 @@ bs_snapshot_swap_cluster_maps(struct spdk_blob *blob1, struct spdk_blob *blob2)
 	extent_page_temp = blob1->active.extent_pages;
 	blob1->active.extent_pages = blob2->active.extent_pages;
 	blob2->active.extent_pages = extent_page_temp;
+
+	/* Partially copied clusters move together with the cluster map */
+	cow_units_temp = blob1->cow_units_per_cluster;
+	blob1->cow_units_per_cluster = blob2->cow_units_per_cluster;
+	blob2->cow_units_per_cluster = cow_units_temp;
+
+	cow_map_temp = blob1->cow_map;
+	blob1->cow_map = blob2->cow_map;
+	blob2->cow_map = cow_map_temp;
+
+	cow_map_size_temp = blob1->cow_map_size;
+	blob1->cow_map_size = blob2->cow_map_size;
+	blob2->cow_map_size = cow_map_size_temp;
+
+	blob_update_cow_flag(blob1);
+	blob_update_cow_flag(blob2);
 }
 
 static void
@@ -5525,6 +7581,15 @@ bs_snapshot_newblob_sync_cpl(void *cb_arg, int bserrno)
 		return;
 	}
 
+	/* Clusters of the original blob are copied from the snapshot in units */
+	bserrno = blob_set_cow_units(origblob, bs_cow_units_per_cluster(origblob->bs));
+	if (bserrno != 0) {
+		/* return cluster map back to original */
+		bs_snapshot_swap_cluster_maps(newblob, origblob);
+		bs_clone_snapshot_newblob_cleanup(ctx, bserrno);
+		return;
+	}
+
 	bs_blob_list_remove(origblob);
 	origblob->parent_id = newblob->id;
 
@@ -5541,6 +7606,7 @@ bs_snapshot_newblob_sync_cpl(void *cb_arg, int bserrno)
 	blob_set_thin_provision(origblob);
 
 	bs_blob_list_add(newblob);
+	bs_cluster_maps_changed(origblob->bs);
 
 	/* sync clone metadata */
 	spdk_blob_sync_md(origblob, bs_snapshot_origblob_sync_cpl, ctx);
@@ -5739,6 +7805,13 @@ bs_clone_newblob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 	ctx->new.blob = clone;
 	bs_blob_list_add(clone);
 
+	/* Copy clusters from the snapshot in units. Without memory for the map the
+	 * clone keeps copying whole clusters. */
+	if (blob_set_cow_units(clone, bs_cow_units_per_cluster(clone->bs)) == 0 &&
+	    clone->cow_units_per_cluster > 1) {
+		clone->state = SPDK_BLOB_STATE_DIRTY;
+	}
+
 	spdk_blob_close(clone, bs_clone_snapshot_origblob_cleanup, ctx);
 }
 
@@ -5849,12 +7922,13 @@ bs_inflate_blob_set_parent_cpl(void *cb_arg, struct spdk_blob *_parent, int bser
 	_blob->back_bs_dev->destroy(_blob->back_bs_dev);
 	_blob->back_bs_dev = bs_create_blob_bs_dev(_parent);
 	bs_blob_list_add(_blob);
+	bs_cluster_maps_changed(_blob->bs);
 
 	spdk_blob_sync_md(_blob, bs_clone_snapshot_origblob_cleanup, ctx);
 }
 
 static void
-bs_inflate_blob_done(void *cb_arg, int bserrno)
+bs_inflate_blob_freeze_cpl(void *cb_arg, int bserrno)
 {
 	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
 	struct spdk_blob *_blob = ctx->original.blob;
@@ -5865,6 +7939,11 @@ bs_inflate_blob_done(void *cb_arg, int bserrno)
 		return;
 	}
 
+	/* bs_clone_snapshot_origblob_cleanup() unfreezes the blob */
+	ctx->frozen = true;
+
+	blob_remove_xattr(_blob, BLOB_INFLATE, true);
+
 	if (ctx->allocate_all) {
 		/* remove thin provisioning */
 		bs_blob_list_remove(_blob);
@@ -5873,6 +7952,8 @@ bs_inflate_blob_done(void *cb_arg, int bserrno)
 		_blob->back_bs_dev->destroy(_blob->back_bs_dev);
 		_blob->back_bs_dev = NULL;
 		_blob->parent_id = SPDK_BLOBID_INVALID;
+		/* All clusters were copied, nothing is left to copy in units */
+		blob_set_cow_units(_blob, 1);
 	} else {
 		_parent = ((struct spdk_blob_bs_dev *)(_blob->back_bs_dev))->blob;
 		if (_parent->parent_id != SPDK_BLOBID_INVALID) {
@@ -5889,10 +7970,28 @@ bs_inflate_blob_done(void *cb_arg, int bserrno)
 		_blob->back_bs_dev = bs_create_zeroes_dev();
 	}
 
+	bs_cluster_maps_changed(_blob->bs);
 	_blob->state = SPDK_BLOB_STATE_DIRTY;
 	spdk_blob_sync_md(_blob, bs_clone_snapshot_origblob_cleanup, ctx);
 }
 
+static void
+bs_inflate_blob_done(void *cb_arg, int bserrno)
+{
+	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+
+	if (bserrno != 0) {
+		/* The checkpoint is kept, so that the operation can be started again */
+		bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
+		return;
+	}
+
+	/* Channel threads read through the parent and the back LBA cache of the blob,
+	 * only swap them while its I/O is frozen.
+	 */
+	blob_freeze_io(ctx->original.blob, bs_inflate_blob_freeze_cpl, ctx);
+}
+
 /* Check if cluster needs allocation */
 static inline bool
 bs_cluster_needs_allocation(struct spdk_blob *blob, uint64_t cluster, bool allocate_all)
@@ -5901,8 +8000,9 @@ bs_cluster_needs_allocation(struct spdk_blob *blob, uint64_t cluster, bool alloc
 
 	assert(blob != NULL);
 
-	if (blob->active.clusters[cluster] != 0) {
-		/* Cluster is already allocated */
+	if (blob->active.clusters[cluster] != 0 &&
+	    bs_cluster_uncopied_units(blob, cluster) == 0) {
+		/* Cluster is already allocated and copied */
 		return false;
 	}
 
@@ -5922,8 +8022,12 @@ bs_inflate_blob_touch_next(void *cb_arg, int bserrno)
 	struct spdk_blob *_blob = ctx->original.blob;
 	uint64_t offset;
 
+	if (bserrno == 0 && ctx->cancel_cb_fn != NULL) {
+		bserrno = -ECANCELED;
+	}
+
 	if (bserrno != 0) {
-		bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
+		bs_inflate_blob_done(ctx, bserrno);
 		return;
 	}
 
@@ -5934,12 +8038,18 @@ bs_inflate_blob_touch_next(void *cb_arg, int bserrno)
 	}
 
 	if (ctx->cluster < _blob->active.num_clusters) {
+		if (bs_copy_throttle(&ctx->throttle)) {
+			return;
+		}
+
 		offset = bs_cluster_to_lba(_blob->bs, ctx->cluster);
 
 		/* We may safely increment a cluster before write */
 		ctx->cluster++;
+		ctx->clusters_done++;
 
-		/* Use zero length write to touch a cluster */
+		/* Use zero length write to touch a cluster, it also copies the
+		 * remaining units of a partially copied one */
 		spdk_blob_io_write(_blob, ctx->channel, NULL, offset, 0,
 				   bs_inflate_blob_touch_next, ctx);
 	} else {
@@ -5951,6 +8061,8 @@ static void
 bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 {
 	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+	struct spdk_blob_inflate_checkpoint checkpoint = {};
+	struct spdk_blob_inflate_opts *opts;
 	uint64_t lfc; /* lowest free cluster */
 	uint64_t i;
 
@@ -5988,7 +8100,11 @@ bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 	 */
 	lfc = 0;
 	for (i = 0; i < _blob->active.num_clusters; i++) {
-		if (bs_cluster_needs_allocation(_blob, i, ctx->allocate_all)) {
+		if (!bs_cluster_needs_allocation(_blob, i, ctx->allocate_all)) {
+			continue;
+		}
+		ctx->clusters_total++;
+		if (_blob->active.clusters[i] == 0) {
 			lfc = spdk_bit_array_find_first_clear(_blob->bs->used_clusters, lfc);
 			if (lfc == UINT32_MAX) {
 				/* No more free clusters. Cannot satisfy the request */
@@ -5999,13 +8115,36 @@ bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 		}
 	}
 
+	opts = &ctx->inflate_opts;
+	bs_copy_throttle_init(&ctx->throttle, _blob->bs, opts, bs_inflate_blob_touch_next, ctx);
+
 	ctx->cluster = 0;
+	ctx->start_tsc = spdk_get_ticks();
+	_blob->inflate_ctx = ctx;
+
+	if (!ctx->persist) {
+		bs_inflate_blob_touch_next(ctx, 0);
+		return;
+	}
+
+	/* Record the operation, so that it can be started again if it is interrupted.
+	 * Clusters are persisted as they are copied, nothing else needs to be kept. */
+	checkpoint.allocate_all = ctx->allocate_all;
+	checkpoint.max_clusters_per_sec = opts->max_clusters_per_sec;
+	checkpoint.max_bytes_per_sec = opts->max_bytes_per_sec;
+	if (blob_set_xattr(_blob, BLOB_INFLATE, &checkpoint, sizeof(checkpoint), true) == 0) {
+		spdk_blob_sync_md(_blob, bs_inflate_blob_touch_next, ctx);
+		return;
+	}
+
 	bs_inflate_blob_touch_next(ctx, 0);
 }
 
 static void
 bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
-		spdk_blob_id blobid, bool allocate_all, spdk_blob_op_complete cb_fn, void *cb_arg)
+		spdk_blob_id blobid, bool allocate_all, bool persist,
+		const struct spdk_blob_inflate_opts *opts,
+		spdk_blob_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_clone_snapshot_ctx *ctx = calloc(1, sizeof(*ctx));
 
@@ -6020,22 +8159,124 @@ bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 	ctx->original.id = blobid;
 	ctx->channel = channel;
 	ctx->allocate_all = allocate_all;
+	ctx->persist = persist;
+	if (opts) {
+		ctx->inflate_opts = *opts;
+	} else {
+		spdk_blob_inflate_opts_init(&ctx->inflate_opts);
+	}
+
+	spdk_bs_open_blob(bs, ctx->original.id, bs_inflate_blob_open_cpl, ctx);
+}
+
+void
+spdk_blob_inflate_opts_init(struct spdk_blob_inflate_opts *opts)
+{
+	opts->max_clusters_per_sec = 0;
+	opts->max_bytes_per_sec = 0;
+}
+
+void
+spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+		     spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	bs_inflate_blob(bs, channel, blobid, true, false, NULL, cb_fn, cb_arg);
+}
+
+void
+spdk_bs_inflate_blob_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			 spdk_blob_id blobid, const struct spdk_blob_inflate_opts *opts,
+			 spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	bs_inflate_blob(bs, channel, blobid, true, true, opts, cb_fn, cb_arg);
+}
+
+void
+spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			     spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	bs_inflate_blob(bs, channel, blobid, false, false, NULL, cb_fn, cb_arg);
+}
+
+void
+spdk_bs_blob_decouple_parent_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+				 spdk_blob_id blobid, const struct spdk_blob_inflate_opts *opts,
+				 spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	bs_inflate_blob(bs, channel, blobid, false, true, opts, cb_fn, cb_arg);
+}
+
+static void
+bs_inflate_blob_cancel_msg(void *arg)
+{
+	bs_inflate_blob_touch_next(arg, 0);
+}
+
+int
+spdk_bs_inflate_blob_cancel(struct spdk_blob_store *bs, spdk_blob_id blobid,
+			    spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob *blob = blob_lookup(bs, blobid);
+	struct spdk_clone_snapshot_ctx *ctx;
+
+	if (blob == NULL || blob->inflate_ctx == NULL) {
+		return -ENOENT;
+	}
+
+	ctx = blob->inflate_ctx;
+	if (ctx->cancel_cb_fn != NULL) {
+		return -EALREADY;
+	}
+
+	ctx->cancel_cb_fn = cb_fn;
+	ctx->cancel_cb_arg = cb_arg;
+
+	/* A cluster touch in flight stops the operation when it completes */
+	if (ctx->throttle.poller != NULL) {
+		spdk_poller_unregister(&ctx->throttle.poller);
+		spdk_thread_send_msg(spdk_get_thread(), bs_inflate_blob_cancel_msg, ctx);
+	}
+
+	return 0;
+}
+
+int
+spdk_blob_get_inflate_progress(struct spdk_blob *blob,
+			       struct spdk_blob_inflate_progress *progress)
+{
+	struct spdk_clone_snapshot_ctx *ctx = blob->inflate_ctx;
+
+	if (ctx == NULL) {
+		return -ENOENT;
+	}
+
+	progress->allocate_all = ctx->allocate_all;
+	progress->clusters_total = ctx->clusters_total;
+	progress->clusters_done = ctx->clusters_done;
+	progress->elapsed_ticks = spdk_get_ticks() - ctx->start_tsc;
 
-	spdk_bs_open_blob(bs, ctx->original.id, bs_inflate_blob_open_cpl, ctx);
+	return 0;
 }
 
-void
-spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
-		     spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
+int
+spdk_blob_get_inflate_checkpoint(struct spdk_blob *blob, struct spdk_blob_inflate_opts *opts,
+				 bool *allocate_all)
 {
-	bs_inflate_blob(bs, channel, blobid, true, cb_fn, cb_arg);
-}
+	const struct spdk_blob_inflate_checkpoint *checkpoint;
+	const void *value;
+	size_t value_len;
 
-void
-spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
-			     spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
-{
-	bs_inflate_blob(bs, channel, blobid, false, cb_fn, cb_arg);
+	if (blob_get_xattr_value(blob, BLOB_INFLATE, &value, &value_len, true) != 0 ||
+	    value_len != sizeof(*checkpoint)) {
+		return -ENOENT;
+	}
+
+	checkpoint = value;
+	opts->max_clusters_per_sec = checkpoint->max_clusters_per_sec;
+	opts->max_bytes_per_sec = checkpoint->max_bytes_per_sec;
+	*allocate_all = checkpoint->allocate_all;
+
+	return 0;
 }
 /* END spdk_bs_inflate_blob */
 
@@ -6046,6 +8287,7 @@ struct spdk_bs_resize_ctx {
 	struct spdk_blob *blob;
 	uint64_t sz;
 	int rc;
+	bool unmap_drained;
 };
 
 static void
@@ -6068,6 +8310,22 @@ bs_resize_unfreeze_cpl(void *cb_arg, int rc)
 	free(ctx);
 }
 
+static void bs_resize_freeze_cpl(void *cb_arg, int rc);
+
+static void
+bs_resize_unmap_drained(void *cb_arg, int rc)
+{
+	struct spdk_bs_resize_ctx *ctx = (struct spdk_bs_resize_ctx *)cb_arg;
+
+	if (rc != 0) {
+		/* Report the original -ENOSPC */
+		blob_unfreeze_io(ctx->blob, bs_resize_unfreeze_cpl, ctx);
+		return;
+	}
+
+	bs_resize_freeze_cpl(ctx, 0);
+}
+
 static void
 bs_resize_freeze_cpl(void *cb_arg, int rc)
 {
@@ -6081,6 +8339,13 @@ bs_resize_freeze_cpl(void *cb_arg, int rc)
 	}
 
 	ctx->rc = blob_resize(ctx->blob, ctx->sz);
+	if (ctx->rc == -ENOSPC && !ctx->unmap_drained &&
+	    __atomic_load_n(&ctx->blob->bs->num_unmap_clusters, __ATOMIC_RELAXED) > 0) {
+		/* Retry once the released clusters are unmapped and back in the pool */
+		ctx->unmap_drained = true;
+		bs_unmap_drain(ctx->blob->bs, bs_resize_unmap_drained, ctx);
+		return;
+	}
 
 	blob_unfreeze_io(ctx->blob, bs_resize_unfreeze_cpl, ctx);
 }
@@ -6171,6 +8436,12 @@ struct delete_snapshot_ctx {
 	spdk_blob_op_with_handle_complete cb_fn;
 	void *cb_arg;
 	int bserrno;
+	/* Current cluster for copying partially copied clusters */
+	uint64_t cluster;
+	/* Rate limits for copying them while the clone I/O is not frozen */
+	struct spdk_blob_inflate_opts copy_opts;
+	struct bs_copy_throttle throttle;
+	bool frozen;
 };
 
 static void
@@ -6219,6 +8490,13 @@ delete_snapshot_cleanup_clone(void *cb_arg, int bserrno)
 {
 	struct delete_snapshot_ctx *ctx = cb_arg;
 
+	if (ctx->frozen) {
+		/* Release the I/O held while the clone was being updated */
+		ctx->frozen = false;
+		blob_unfreeze_io(ctx->clone, delete_snapshot_cleanup_clone, ctx);
+		return;
+	}
+
 	ctx->clone->locked_operation_in_progress = false;
 	ctx->clone->md_ro = ctx->clone_md_ro;
 
@@ -6291,6 +8569,7 @@ delete_snapshot_sync_snapshot_cpl(void *cb_arg, int bserrno)
 	ctx->clone->md_ro = ctx->clone_md_ro;
 	ctx->snapshot->md_ro = ctx->snapshot_md_ro;
 
+	ctx->frozen = false;
 	blob_unfreeze_io(ctx->clone, delete_snapshot_unfreeze_cpl, ctx);
 }
 
@@ -6321,6 +8600,9 @@ delete_snapshot_sync_clone_cpl(void *cb_arg, int bserrno)
 	for (i = 0; i < ctx->snapshot->active.num_clusters && i < ctx->clone->active.num_clusters; i++) {
 		if (ctx->clone->active.clusters[i] == ctx->snapshot->active.clusters[i]) {
 			ctx->snapshot->active.clusters[i] = 0;
+			if (i < ctx->snapshot->cow_map_size) {
+				ctx->snapshot->cow_map[i] = 0;
+			}
 		}
 	}
 	for (i = 0; i < ctx->snapshot->active.num_extent_pages &&
@@ -6361,6 +8643,13 @@ delete_snapshot_sync_snapshot_xattr_cpl(void *cb_arg, int bserrno)
 	for (i = 0; i < ctx->snapshot->active.num_clusters && i < ctx->clone->active.num_clusters; i++) {
 		if (ctx->clone->active.clusters[i] == 0) {
 			ctx->clone->active.clusters[i] = ctx->snapshot->active.clusters[i];
+			if (bs_cluster_uncopied_units(ctx->snapshot, i) != 0) {
+				/* Units left to copy come from the parent of the snapshot,
+				 * which becomes the parent of the clone. */
+				assert(ctx->clone->cow_units_per_cluster ==
+				       ctx->snapshot->cow_units_per_cluster);
+				ctx->clone->cow_map[i] = ctx->snapshot->cow_map[i];
+			}
 		}
 	}
 	for (i = 0; i < ctx->snapshot->active.num_extent_pages &&
@@ -6387,22 +8676,71 @@ delete_snapshot_sync_snapshot_xattr_cpl(void *cb_arg, int bserrno)
 		ctx->clone->back_bs_dev = bs_create_zeroes_dev();
 		blob_remove_xattr(ctx->clone, BLOB_SNAPSHOT, true);
 	}
+	bs_cluster_maps_changed(ctx->clone->bs);
 
 	spdk_blob_sync_md(ctx->clone, delete_snapshot_sync_clone_cpl, ctx);
 }
 
+static void delete_snapshot_freeze_io_cb(void *cb_arg, int bserrno);
+
+/* Before the clone takes over the clusters of the snapshot, finish copying the
+ * clusters whose remaining units would be read from a different place afterwards:
+ * clusters of the clone that still read from the snapshot, and clusters of the
+ * snapshot that the clone takes over but tracks in a different number of units.
+ *
+ * The units are copied at the rate allowed by copy_opts while the clone I/O keeps
+ * going, then the clone I/O is frozen and the clusters its writes partially copied
+ * in the meantime are finished without limits. Units are persisted as they are
+ * copied, a deletion that is interrupted and started again does not copy them again.
+ */
 static void
-delete_snapshot_freeze_io_cb(void *cb_arg, int bserrno)
+delete_snapshot_copy_units_next(void *cb_arg, int bserrno)
 {
 	struct delete_snapshot_ctx *ctx = cb_arg;
+	struct spdk_blob *snapshot = ctx->snapshot;
+	struct spdk_blob *clone = ctx->clone;
+	struct spdk_blob *blob;
+	uint64_t i;
 
 	if (bserrno) {
-		SPDK_ERRLOG("Failed to freeze I/O on clone\n");
+		SPDK_ERRLOG("Failed to copy clusters of the snapshot\n");
 		ctx->bserrno = bserrno;
 		delete_snapshot_cleanup_clone(ctx, 0);
 		return;
 	}
 
+	for (i = ctx->cluster; i < spdk_min(snapshot->active.num_clusters,
+					       clone->active.num_clusters); i++) {
+		if (snapshot->active.clusters[i] == 0) {
+			continue;
+		}
+
+		if (clone->active.clusters[i] != 0 && bs_cluster_uncopied_units(clone, i) != 0) {
+			blob = clone;
+		} else if (clone->active.clusters[i] == 0 &&
+			   bs_cluster_uncopied_units(snapshot, i) != 0 &&
+			   clone->cow_units_per_cluster != snapshot->cow_units_per_cluster) {
+			blob = snapshot;
+		} else {
+			continue;
+		}
+
+		ctx->cluster = i;
+		if (!ctx->frozen && bs_copy_throttle(&ctx->throttle)) {
+			return;
+		}
+
+		ctx->cluster = i + 1;
+		blob_copy_units_on_md_thread(blob, i, UINT16_MAX,
+					     delete_snapshot_copy_units_next, ctx);
+		return;
+	}
+
+	if (!ctx->frozen) {
+		blob_freeze_io(clone, delete_snapshot_freeze_io_cb, ctx);
+		return;
+	}
+
 	/* Temporarily override md_ro flag for snapshot for MD modification */
 	ctx->snapshot_md_ro = ctx->snapshot->md_ro;
 	ctx->snapshot->md_ro = false;
@@ -6418,6 +8756,23 @@ delete_snapshot_freeze_io_cb(void *cb_arg, int bserrno)
 	spdk_blob_sync_md(ctx->snapshot, delete_snapshot_sync_snapshot_xattr_cpl, ctx);
 }
 
+static void
+delete_snapshot_freeze_io_cb(void *cb_arg, int bserrno)
+{
+	struct delete_snapshot_ctx *ctx = cb_arg;
+
+	if (bserrno) {
+		SPDK_ERRLOG("Failed to freeze I/O on clone\n");
+		ctx->bserrno = bserrno;
+		delete_snapshot_cleanup_clone(ctx, 0);
+		return;
+	}
+
+	ctx->frozen = true;
+	ctx->cluster = 0;
+	delete_snapshot_copy_units_next(ctx, 0);
+}
+
 static void
 delete_snapshot_open_clone_cb(void *cb_arg, struct spdk_blob *clone, int bserrno)
 {
@@ -6441,7 +8796,10 @@ delete_snapshot_open_clone_cb(void *cb_arg, struct spdk_blob *clone, int bserrno
 
 	clone->locked_operation_in_progress = true;
 
-	blob_freeze_io(clone, delete_snapshot_freeze_io_cb, ctx);
+	bs_copy_throttle_init(&ctx->throttle, clone->bs, &ctx->copy_opts,
+			      delete_snapshot_copy_units_next, ctx);
+	ctx->cluster = 0;
+	delete_snapshot_copy_units_next(ctx, 0);
 }
 
 static void
@@ -6546,37 +8904,22 @@ bs_is_blob_deletable(struct spdk_blob *blob, bool *update_clone)
 	return 0;
 }
 
-static void
-bs_delete_enomem_close_cpl(void *cb_arg, int bserrno)
-{
-	spdk_bs_sequence_t *seq = cb_arg;
-
-	bs_sequence_finish(seq, -ENOMEM);
-}
-
 static void
 bs_delete_open_cpl(void *cb_arg, struct spdk_blob *blob, int bserrno)
 {
-	spdk_bs_sequence_t *seq = cb_arg;
-	struct delete_snapshot_ctx *ctx;
+	struct delete_snapshot_ctx *ctx = cb_arg;
+	spdk_bs_sequence_t *seq = ctx->cb_arg;
 	bool update_clone = false;
 
 	if (bserrno != 0) {
+		free(ctx);
 		bs_sequence_finish(seq, bserrno);
 		return;
 	}
 
 	blob_verify_md_op(blob);
 
-	ctx = calloc(1, sizeof(*ctx));
-	if (ctx == NULL) {
-		spdk_blob_close(blob, bs_delete_enomem_close_cpl, seq);
-		return;
-	}
-
 	ctx->snapshot = blob;
-	ctx->cb_fn = bs_delete_blob_finish;
-	ctx->cb_arg = seq;
 
 	/* Check if blob can be removed and if it is a snapshot with clone on top of it */
 	ctx->bserrno = bs_is_blob_deletable(blob, &update_clone);
@@ -6612,12 +8955,14 @@ bs_delete_open_cpl(void *cb_arg, struct spdk_blob *blob, int bserrno)
 	}
 }
 
-void
-spdk_bs_delete_blob(struct spdk_blob_store *bs, spdk_blob_id blobid,
-		    spdk_blob_op_complete cb_fn, void *cb_arg)
+static void
+bs_delete_blob(struct spdk_blob_store *bs, spdk_blob_id blobid,
+	       const struct spdk_blob_inflate_opts *opts,
+	       spdk_blob_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_bs_cpl	cpl;
 	spdk_bs_sequence_t	*seq;
+	struct delete_snapshot_ctx *ctx;
 
 	SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Deleting blob %lu\n", blobid);
 
@@ -6633,7 +8978,36 @@ spdk_bs_delete_blob(struct spdk_blob_store *bs, spdk_blob_id blobid,
 		return;
 	}
 
-	spdk_bs_open_blob(bs, blobid, bs_delete_open_cpl, seq);
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		bs_sequence_finish(seq, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = bs_delete_blob_finish;
+	ctx->cb_arg = seq;
+	if (opts) {
+		ctx->copy_opts = *opts;
+	} else {
+		spdk_blob_inflate_opts_init(&ctx->copy_opts);
+	}
+
+	spdk_bs_open_blob(bs, blobid, bs_delete_open_cpl, ctx);
+}
+
+void
+spdk_bs_delete_blob(struct spdk_blob_store *bs, spdk_blob_id blobid,
+		    spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	bs_delete_blob(bs, blobid, NULL, cb_fn, cb_arg);
+}
+
+void
+spdk_bs_delete_blob_ext(struct spdk_blob_store *bs, spdk_blob_id blobid,
+			const struct spdk_blob_inflate_opts *opts,
+			spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	bs_delete_blob(bs, blobid, opts, cb_fn, cb_arg);
 }
 
 /* END spdk_bs_delete_blob */
@@ -6802,6 +9176,8 @@ struct spdk_blob_insert_cluster_ctx {
 	uint32_t		cluster_num;	/* cluster index in blob */
 	uint32_t		cluster;	/* cluster on disk */
 	uint32_t		extent_page;	/* extent page on disk */
+	uint16_t		uncopied_units;	/* units not copied from back_bs_dev */
+	uint32_t		units_per_cluster;
 	int			rc;
 	spdk_blob_op_complete	cb_fn;
 	void			*cb_arg;
@@ -6865,9 +9241,9 @@ blob_insert_extent(struct spdk_blob *blob, uint32_t extent, uint64_t cluster_num
 
 	assert(spdk_bit_array_get(blob->bs->used_md_pages, extent) == true);
 
-	bs_sequence_write_dev(seq, page, bs_md_page_to_lba(blob->bs, extent),
-			      bs_byte_to_lba(blob->bs, SPDK_BS_PAGE_SIZE),
-			      blob_persist_extent_page_cpl, page);
+	/* Goes through the same queue as blob persists, which may hold an older
+	 * version of this extent page */
+	bs_md_write_pages(seq, blob->bs, page, &extent, 1, blob_persist_extent_page_cpl, page);
 }
 
 static void
@@ -6882,6 +9258,20 @@ blob_insert_cluster_msg(void *arg)
 		return;
 	}
 
+	if (ctx->uncopied_units != 0) {
+		if (ctx->blob->cow_map == NULL ||
+		    ctx->blob->cow_units_per_cluster != ctx->units_per_cluster) {
+			/* Units changed while the cluster was being copied, e.g. by a
+			 * snapshot. Drop the cluster and let the user op start over. */
+			ctx->blob->active.clusters[ctx->cluster_num] = 0;
+			blob_cluster_map_changed(ctx->blob);
+			ctx->rc = -EAGAIN;
+			spdk_thread_send_msg(ctx->thread, blob_insert_cluster_msg_cpl, ctx);
+			return;
+		}
+		ctx->blob->cow_map[ctx->cluster_num] = ctx->uncopied_units;
+	}
+
 	if (ctx->blob->use_extent_table == false) {
 		/* Extent table is not used, proceed with sync of md that will only use extents_rle. */
 		ctx->blob->state = SPDK_BLOB_STATE_DIRTY;
@@ -6917,7 +9307,8 @@ blob_insert_cluster_msg(void *arg)
 
 static void
 blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
-				 uint64_t cluster, uint32_t extent_page, spdk_blob_op_complete cb_fn, void *cb_arg)
+				 uint64_t cluster, uint32_t extent_page, uint16_t uncopied_units,
+				 spdk_blob_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_blob_insert_cluster_ctx *ctx;
 
@@ -6932,12 +9323,247 @@ blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
 	ctx->cluster_num = cluster_num;
 	ctx->cluster = cluster;
 	ctx->extent_page = extent_page;
+	ctx->uncopied_units = uncopied_units;
+	ctx->units_per_cluster = blob->cow_units_per_cluster;
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
 
 	spdk_thread_send_msg(blob->bs->md_thread, blob_insert_cluster_msg, ctx);
 }
 
+/* Copying the remaining units of a partially copied cluster is done on the md
+ * thread, so that copies of the same cluster started from different channels
+ * are serialized with each other and with the metadata update that follows.
+ */
+struct spdk_blob_copy_units_ctx {
+	struct spdk_thread	*thread;
+	struct spdk_blob	*blob;
+	uint32_t		cluster_num;	/* cluster index in blob */
+	uint16_t		units;		/* mask of units to copy */
+	uint32_t		unit;		/* next unit to check */
+	uint8_t			*buf;
+	int			rc;
+	spdk_blob_op_complete	cb_fn;
+	void			*cb_arg;
+	/* Copies of the same cluster waiting for this one to finish */
+	TAILQ_HEAD(, spdk_blob_copy_units_ctx) waiters;
+	TAILQ_ENTRY(spdk_blob_copy_units_ctx) link;
+};
+
+static void blob_copy_units_start(struct spdk_blob_copy_units_ctx *ctx);
+
+static void
+blob_copy_units_msg_cpl(void *arg)
+{
+	struct spdk_blob_copy_units_ctx *ctx = arg;
+
+	ctx->cb_fn(ctx->cb_arg, ctx->rc);
+	free(ctx);
+}
+
+static void
+blob_copy_units_done(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_units_ctx *ctx = cb_arg;
+	struct spdk_blob_copy_units_ctx *waiter;
+
+	TAILQ_REMOVE(&ctx->blob->cow_copies, ctx, link);
+	bs_channel_put_copy_buf(spdk_io_channel_get_ctx(ctx->blob->bs->md_channel), ctx->buf);
+	ctx->buf = NULL;
+
+	while (!TAILQ_EMPTY(&ctx->waiters)) {
+		waiter = TAILQ_FIRST(&ctx->waiters);
+		TAILQ_REMOVE(&ctx->waiters, waiter, link);
+		blob_copy_units_start(waiter);
+	}
+
+	ctx->rc = bserrno;
+	spdk_thread_send_msg(ctx->thread, blob_copy_units_msg_cpl, ctx);
+}
+
+static void
+blob_copy_units_persist(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_units_ctx *ctx = cb_arg;
+	struct spdk_blob *blob = ctx->blob;
+	uint32_t *extent_page;
+
+	if (bserrno != 0) {
+		blob_copy_units_done(ctx, bserrno);
+		return;
+	}
+
+	if (ctx->cluster_num >= blob->active.num_clusters ||
+	    blob->active.clusters[ctx->cluster_num] == 0 || blob->cow_map == NULL) {
+		/* The cluster was released while it was being copied. */
+		blob_copy_units_done(ctx, 0);
+		return;
+	}
+
+	blob->cow_map[ctx->cluster_num] &= ~ctx->units;
+
+	if (blob->use_extent_table) {
+		extent_page = bs_cluster_to_extent_page(blob, ctx->cluster_num);
+		if (*extent_page != 0) {
+			blob_insert_extent(blob, *extent_page, ctx->cluster_num,
+					   blob_copy_units_done, ctx);
+			return;
+		}
+	}
+
+	blob->state = SPDK_BLOB_STATE_DIRTY;
+	blob_sync_md(blob, blob_copy_units_done, ctx);
+}
+
+static void blob_copy_units_next(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno);
+
+static void
+blob_copy_units_write(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_units_ctx *ctx = cb_arg;
+	struct spdk_blob *blob = ctx->blob;
+	uint64_t pages_per_unit = blob->bs->pages_per_cluster / blob->cow_units_per_cluster;
+	uint64_t lba;
+
+	if (bserrno != 0) {
+		bs_sequence_finish(seq, bserrno);
+		return;
+	}
+
+	lba = blob->active.clusters[ctx->cluster_num] +
+	      bs_page_to_lba(blob->bs, ctx->unit * pages_per_unit);
+	ctx->unit++;
+
+	bs_sequence_write_dev(seq, ctx->buf, lba, bs_page_to_lba(blob->bs, pages_per_unit),
+			      blob_copy_units_next, ctx);
+}
+
+static void
+blob_copy_units_next(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_units_ctx *ctx = cb_arg;
+	struct spdk_blob *blob = ctx->blob;
+	uint64_t pages_per_unit = blob->bs->pages_per_cluster / blob->cow_units_per_cluster;
+	uint64_t page, src_lba, dst_lba;
+
+	if (bserrno != 0) {
+		bs_sequence_finish(seq, bserrno);
+		return;
+	}
+
+	while (ctx->unit < blob->cow_units_per_cluster && !(ctx->units & (1u << ctx->unit))) {
+		ctx->unit++;
+	}
+
+	if (ctx->unit == blob->cow_units_per_cluster ||
+	    ctx->cluster_num >= blob->active.num_clusters ||
+	    blob->active.clusters[ctx->cluster_num] == 0) {
+		bs_sequence_finish(seq, 0);
+		return;
+	}
+
+	page = (uint64_t)ctx->cluster_num * blob->bs->pages_per_cluster +
+	       ctx->unit * pages_per_unit;
+	src_lba = blob_back_dev_copy_lba(blob, page, pages_per_unit);
+	if (src_lba != 0) {
+		dst_lba = blob->active.clusters[ctx->cluster_num] +
+			  bs_page_to_lba(blob->bs, ctx->unit * pages_per_unit);
+		ctx->unit++;
+		bs_sequence_copy_dev(seq, dst_lba, src_lba,
+				     bs_page_to_lba(blob->bs, pages_per_unit),
+				     blob_copy_units_next, ctx);
+		return;
+	}
+
+	if (ctx->buf == NULL) {
+		ctx->buf = bs_channel_get_copy_buf(spdk_io_channel_get_ctx(blob->bs->md_channel));
+		if (ctx->buf == NULL) {
+			bs_sequence_finish(seq, -ENOMEM);
+			return;
+		}
+	}
+
+	bs_sequence_read_bs_dev(seq, blob->back_bs_dev, ctx->buf,
+				bs_dev_page_to_lba(blob->back_bs_dev, page),
+				bs_dev_byte_to_lba(blob->back_bs_dev,
+						   pages_per_unit * SPDK_BS_PAGE_SIZE),
+				blob_copy_units_write, ctx);
+}
+
+static void
+blob_copy_units_start(struct spdk_blob_copy_units_ctx *ctx)
+{
+	struct spdk_blob *blob = ctx->blob;
+	struct spdk_blob_copy_units_ctx *other;
+	spdk_bs_sequence_t *seq;
+	struct spdk_bs_cpl cpl;
+
+	if (ctx->cluster_num < blob->active.num_clusters &&
+	    blob->active.clusters[ctx->cluster_num] != 0) {
+		ctx->units &= bs_cluster_uncopied_units(blob, ctx->cluster_num);
+	} else {
+		ctx->units = 0;
+	}
+
+	if (ctx->units == 0) {
+		/* Nothing left to copy, the user op will be re-executed. */
+		ctx->rc = 0;
+		spdk_thread_send_msg(ctx->thread, blob_copy_units_msg_cpl, ctx);
+		return;
+	}
+
+	TAILQ_FOREACH(other, &blob->cow_copies, link) {
+		if (other->cluster_num == ctx->cluster_num) {
+			TAILQ_INSERT_TAIL(&other->waiters, ctx, link);
+			return;
+		}
+	}
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = blob_copy_units_persist;
+	cpl.u.blob_basic.cb_arg = ctx;
+
+	seq = bs_sequence_start(blob->bs->md_channel, &cpl);
+	if (seq == NULL) {
+		ctx->rc = -ENOMEM;
+		spdk_thread_send_msg(ctx->thread, blob_copy_units_msg_cpl, ctx);
+		return;
+	}
+
+	TAILQ_INSERT_TAIL(&blob->cow_copies, ctx, link);
+	ctx->unit = 0;
+	blob_copy_units_next(seq, ctx, 0);
+}
+
+static void
+blob_copy_units_msg(void *arg)
+{
+	blob_copy_units_start(arg);
+}
+
+static void
+blob_copy_units_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num, uint16_t units,
+			     spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob_copy_units_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->thread = spdk_get_thread();
+	ctx->blob = blob;
+	ctx->cluster_num = cluster_num;
+	ctx->units = units;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	TAILQ_INIT(&ctx->waiters);
+
+	spdk_thread_send_msg(blob->bs->md_thread, blob_copy_units_msg, ctx);
+}
+
 /* START spdk_blob_close */
 
 static void
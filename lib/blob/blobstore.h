@@ -161,11 +161,41 @@ struct spdk_blob {
 
 	uint32_t frozen_refcnt;
 	bool locked_operation_in_progress;
+	/* Inflate or decouple running on this blob, if any */
+	struct spdk_clone_snapshot_ctx *inflate_ctx;
 	enum blob_clear_method clear_method;
 	bool extent_rle_found;
 	bool extent_table_found;
 	bool use_extent_table;
 
+	/* Clusters are copied from back_bs_dev in this many units on first write.
+	 * 1 means whole clusters are copied. */
+	uint32_t	cow_units_per_cluster;
+
+	/* Per cluster mask of units that were not copied from back_bs_dev yet,
+	 * 0 for unallocated and fully copied clusters. Only allocated when
+	 * cow_units_per_cluster is greater than 1, in which case it covers
+	 * at least num_clusters entries. */
+	uint16_t	*cow_map;
+	size_t		cow_map_size;
+
+	/* Unit copies in progress, only accessed on the metadata thread */
+	TAILQ_HEAD(, spdk_blob_copy_units_ctx) cow_copies;
+
+	/* Per cluster LBA of the data in the nearest snapshot that has the cluster, so that
+	 * reads of unallocated clusters skip the snapshots in between. 0 if not looked up
+	 * yet. Only allocated for clones, reset on the metadata thread whenever a snapshot
+	 * is added to or removed from a chain. */
+	uint64_t	*back_lba_cache;
+	size_t		back_lba_cache_size;
+
+	/* Clusters the blob has allocated and clusters it reads from its snapshots.
+	 * Counted again on first query after the cluster map of the blob or of one of its
+	 * snapshots changes, and kept up to date on cluster allocation in between. */
+	uint64_t	num_allocated_clusters;
+	uint64_t	num_shared_clusters;
+	bool		clusters_counted;
+
 	/* A list of pending metadata pending_persists */
 	TAILQ_HEAD(, spdk_blob_persist_ctx) pending_persists;
 
@@ -177,6 +207,9 @@ struct spdk_blob {
 struct spdk_blob_store {
 	uint64_t			md_start; /* Offset from beginning of disk, in pages */
 	uint32_t			md_len; /* Count, in pages */
+	/* No md page at or past this index is in use. Once the blobstore is marked
+	 * dirty on disk, this is also what the super block holds. */
+	uint32_t			md_used_limit;
 
 	struct spdk_io_channel		*md_channel;
 	uint32_t			max_channel_ops;
@@ -191,14 +224,22 @@ struct spdk_blob_store {
 	struct spdk_bit_array		*open_blobids;
 
 	pthread_mutex_t			used_clusters_mutex;
+	/* All clusters below this index are in use. Protected by used_clusters_mutex. */
+	uint32_t			first_free_cluster;
+	/* Channels that may hold reserved clusters. Protected by used_clusters_mutex. */
+	TAILQ_HEAD(, spdk_bs_channel)	channels;
 
 	uint32_t			cluster_sz;
 	uint64_t			total_clusters;
 	uint64_t			total_data_clusters;
 	uint64_t			num_free_clusters;
+	/* Clusters claimed by channels but not handed out yet, updated atomically */
+	uint64_t			num_reserved_clusters;
 	uint64_t			pages_per_cluster;
 	uint8_t				pages_per_cluster_shift;
 	uint32_t			io_unit_size;
+	/* Copy-on-write granularity for new clones in bytes, 0 copies whole clusters */
+	uint32_t			cow_granularity;
 
 	spdk_blob_id			super_blob;
 	struct spdk_bs_type		bstype;
@@ -210,8 +251,35 @@ struct spdk_blob_store {
 	TAILQ_HEAD(, spdk_blob_list)	snapshots;
 
 	bool                            clean;
+	/* Super block writes that mark the blobstore dirty are serialized */
+	bool				super_dirty_in_progress;
+	TAILQ_HEAD(, spdk_bs_mark_dirty_ctx) mark_dirty_waiters;
+
+	/* md page writes issued since the last flush, written out together */
+	TAILQ_HEAD(, spdk_bs_md_write)	md_writes;
+	bool				md_writes_flush_pending;
+
+	/* Released clusters waiting to be unmapped, sorted by LBA. They are returned to
+	 * the free pool once unmapped. Only accessed on the metadata thread. */
+	TAILQ_HEAD(spdk_bs_unmap_ranges, spdk_bs_unmap_range) unmap_ranges;
+	/* Only updated on the metadata thread, but also read from channel threads so
+	 * all accesses go through __atomic builtins. */
+	uint64_t			num_unmap_clusters;
+	/* Set while a range is being unmapped or is about to be */
+	bool				unmap_busy;
+	uint64_t			unmap_lba;
+	uint64_t			unmap_lba_count;
+	uint64_t			unmap_ticks_per_cluster;
+	uint64_t			unmap_next_tsc;
+	struct spdk_poller		*unmap_poller;
+	/* Waiting for the queue to drain, the rate limit is ignored meanwhile */
+	TAILQ_HEAD(, spdk_bs_unmap_waiter) unmap_waiters;
 };
 
+/* Copy-on-write buffers kept per channel, bounded by count and by total size */
+#define SPDK_BS_CHANNEL_COPY_BUFS 4
+#define SPDK_BS_CHANNEL_COPY_BUF_BYTES (4 * 1024 * 1024)
+
 struct spdk_bs_channel {
 	struct spdk_bs_request_set	*req_mem;
 	TAILQ_HEAD(, spdk_bs_request_set) reqs;
@@ -221,8 +289,20 @@ struct spdk_bs_channel {
 	struct spdk_bs_dev		*dev;
 	struct spdk_io_channel		*dev_channel;
 
-	TAILQ_HEAD(, spdk_bs_request_set) need_cluster_alloc;
+	/* Cluster allocations in flight, each holds the user ops waiting for its cluster */
+	TAILQ_HEAD(, spdk_blob_copy_cluster_ctx) cluster_allocs;
+
+	/* Run of clusters claimed for allocations on this channel, [next, end) packed as
+	 * next | end << 32. Updated atomically, other threads take the run back when the
+	 * blobstore runs out of free clusters. */
+	uint64_t			reserved_clusters;
+	TAILQ_ENTRY(spdk_bs_channel)	link;
 	TAILQ_HEAD(, spdk_bs_request_set) queued_io;
+
+	/* Cluster sized DMA buffers for copy-on-write, kept instead of allocating one per copy */
+	void				*copy_bufs[SPDK_BS_CHANNEL_COPY_BUFS];
+	uint32_t			num_copy_bufs;
+	uint32_t			max_copy_bufs;
 };
 
 /** operation type */
@@ -240,6 +320,16 @@ enum spdk_blob_op_type {
 #define BLOB_SNAPSHOT "SNAP"
 #define SNAPSHOT_IN_PROGRESS "SNAPTMP"
 #define SNAPSHOT_PENDING_REMOVAL "SNAPRM"
+#define BLOB_INFLATE "INFLATE"
+
+/* Value of the BLOB_INFLATE internal xattr, kept while an inflate or decouple runs */
+struct spdk_blob_inflate_checkpoint {
+	uint8_t		allocate_all;
+	uint8_t		reserved[7];
+	uint64_t	max_clusters_per_sec;
+	uint64_t	max_bytes_per_sec;
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_blob_inflate_checkpoint) == 24, "Incorrect size");
 
 struct spdk_blob_bs_dev {
 	struct spdk_bs_dev bs_dev;
@@ -252,6 +342,10 @@ struct spdk_blob_bs_dev {
  */
 #define SPDK_BS_INITIAL_VERSION 1
 #define SPDK_BS_VERSION 3 /* current version */
+/* Written while the blobstore is dirty and the super block holds md_used_limit, so that
+ * versions not aware of the limit can't use the blobstore and leave a stale one behind.
+ * The version from before is kept in clean_version and restored on clean shutdown. */
+#define SPDK_BS_VERSION_MD_USED_LIMIT 4
 
 #pragma pack(push, 1)
 
@@ -289,6 +383,16 @@ struct spdk_bs_md_mask {
  * with 0's being unallocated clusters. It is NOT part of
  * serialized metadata chain for a blob. */
 #define SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE 6
+/* COW_MAP descriptor holds, for blobs that copy clusters from their
+ * parent in smaller units, a mask of units not copied yet for each
+ * cluster starting at start_cluster_idx. Clusters not covered by any
+ * COW_MAP descriptor are fully copied or unallocated. Blobs using
+ * an extent table store it in each extent page right after the
+ * EXTENT_PAGE descriptor, covering the same clusters. Otherwise it is
+ * part of serialized metadata chain for a blob, following EXTENT_RLE.
+ * At least one descriptor is part of the metadata chain to persist
+ * the number of units. */
+#define SPDK_MD_DESCRIPTOR_TYPE_COW_MAP 7
 
 struct spdk_blob_md_descriptor_xattr {
 	uint8_t		type;
@@ -334,10 +438,29 @@ struct spdk_blob_md_descriptor_extent_page {
 	uint32_t        cluster_idx[0];
 };
 
+/* A cluster can be copied in at most that many units, so that a COW_MAP
+ * descriptor for a full extent page fits in the page next to it. */
+#define SPDK_BLOB_COW_UNITS_MAX 16
+
+struct spdk_blob_md_descriptor_cow_map {
+	uint8_t		type;
+	uint32_t	length;
+
+	uint16_t	units_per_cluster;
+
+	/* First cluster index in this descriptor */
+	uint32_t	start_cluster_idx;
+
+	/* Bit n is set when unit n of the cluster was not copied yet */
+	uint16_t	uncopied_units[0];
+};
+
 #define SPDK_BLOB_THIN_PROV (1ULL << 0)
 #define SPDK_BLOB_INTERNAL_XATTR (1ULL << 1)
 #define SPDK_BLOB_EXTENT_TABLE (1ULL << 2)
-#define SPDK_BLOB_INVALID_FLAGS_MASK	(SPDK_BLOB_THIN_PROV | SPDK_BLOB_INTERNAL_XATTR | SPDK_BLOB_EXTENT_TABLE)
+#define SPDK_BLOB_COW_MAP (1ULL << 3)
+#define SPDK_BLOB_INVALID_FLAGS_MASK	(SPDK_BLOB_THIN_PROV | SPDK_BLOB_INTERNAL_XATTR | \
+					 SPDK_BLOB_EXTENT_TABLE | SPDK_BLOB_COW_MAP)
 
 #define SPDK_BLOB_READ_ONLY (1ULL << 0)
 #define SPDK_BLOB_DATA_RO_FLAGS_MASK	SPDK_BLOB_READ_ONLY
@@ -426,7 +549,16 @@ struct spdk_bs_super_block {
 	uint64_t        size; /* size of blobstore in bytes */
 	uint32_t        io_unit_size; /* Size of io unit in bytes */
 
-	uint8_t         reserved[4000];
+	uint32_t	cow_granularity; /* Copy-on-write granularity for new clones in bytes */
+
+	/* While the blobstore is dirty, no md page at or past this index is in use.
+	 * Only valid if version is SPDK_BS_VERSION_MD_USED_LIMIT, 0 if unknown.
+	 * Otherwise recovery reads the whole metadata region. */
+	uint32_t	md_used_limit;
+	/* Version to write back on clean shutdown, if version is SPDK_BS_VERSION_MD_USED_LIMIT */
+	uint32_t	clean_version;
+
+	uint8_t         reserved[3988];
 	uint32_t	crc;
 };
 SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_super_block) == 0x1000, "Invalid super block size");
@@ -670,13 +802,43 @@ bs_io_unit_to_cluster_number(struct spdk_blob *blob, uint64_t io_unit)
 	}
 }
 
-/* Given an io unit offset into a blob, look up if it is from allocated cluster. */
+/* Given a cluster index in a blob, look up the mask of its units that were not
+ * copied from the backing device yet.
+ */
+static inline uint16_t
+bs_cluster_uncopied_units(struct spdk_blob *blob, uint64_t cluster)
+{
+	if (blob->cow_map == NULL) {
+		return 0;
+	}
+
+	assert(cluster < blob->cow_map_size);
+	return blob->cow_map[cluster];
+}
+
+/* Given an io_unit offset into a blob, look up the copy-on-write unit within its cluster. */
+static inline uint32_t
+bs_io_unit_to_cow_unit(struct spdk_blob *blob, uint64_t io_unit)
+{
+	uint64_t	io_units_per_cluster;
+
+	io_units_per_cluster = bs_io_unit_per_page(blob->bs) * blob->bs->pages_per_cluster;
+
+	return (io_unit % io_units_per_cluster) /
+	       (io_units_per_cluster / blob->cow_units_per_cluster);
+}
+
+/* Given an io unit offset into a blob, look up if it is from allocated cluster.
+ * Units of a cluster that were not copied from the backing device yet are
+ * reported as not allocated.
+ */
 static inline bool
 bs_io_unit_is_allocated(struct spdk_blob *blob, uint64_t io_unit)
 {
 	uint64_t	lba;
 	uint64_t	page;
 	uint64_t	pages_per_cluster;
+	uint64_t	cluster;
 	uint8_t		shift;
 
 	shift = blob->bs->pages_per_cluster_shift;
@@ -686,14 +848,18 @@ bs_io_unit_is_allocated(struct spdk_blob *blob, uint64_t io_unit)
 	assert(page < blob->active.num_clusters * pages_per_cluster);
 
 	if (shift != 0) {
-		lba = blob->active.clusters[page >> shift];
+		cluster = page >> shift;
 	} else {
-		lba = blob->active.clusters[page / pages_per_cluster];
+		cluster = page / pages_per_cluster;
 	}
+	lba = blob->active.clusters[cluster];
 
 	if (lba == 0) {
 		assert(spdk_blob_is_thin_provisioned(blob));
 		return false;
+	} else if (bs_cluster_uncopied_units(blob, cluster) != 0) {
+		return !(bs_cluster_uncopied_units(blob, cluster) &
+			 (1u << bs_io_unit_to_cow_unit(blob, io_unit)));
 	} else {
 		return true;
 	}
@@ -58,13 +58,36 @@
 
 static uint64_t g_fs_cache_size = BLOBFS_DEFAULT_CACHE_SIZE;
 static struct spdk_mempool *g_cache_pool;
-static TAILQ_HEAD(, spdk_file) g_caches;
 static struct spdk_poller *g_cache_pool_mgmt_poller;
 static struct spdk_thread *g_cache_pool_thread;
 #define BLOBFS_CACHE_POOL_POLL_PERIOD_IN_US 1000ULL
 static int g_fs_count = 0;
 static pthread_mutex_t g_cache_init_lock = PTHREAD_MUTEX_INITIALIZER;
 
+/* Files holding cache buffers are spread over one shard per core, each with its own
+ * lock, so that threads caching data of different files don't contend on one list.
+ * The reclaim poller sweeps the shards in turn, with the head of each list acting as
+ * a CLOCK hand: files read from the cache since the last sweep get a second chance.
+ */
+#define BLOBFS_CACHE_MAX_SHARDS 64
+
+struct blobfs_cache_shard {
+	pthread_spinlock_t		lock;
+	TAILQ_HEAD(, spdk_file)		files;
+	uint32_t			num_files;
+
+	/* Statistics of the files in the shard, updated atomically */
+	uint64_t			hits;
+	uint64_t			misses;
+	uint64_t			evictions;
+	uint64_t			readaheads;
+} __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
+
+static struct blobfs_cache_shard g_cache_shards[BLOBFS_CACHE_MAX_SHARDS];
+static uint32_t g_cache_num_shards;
+static uint32_t g_cache_next_shard;
+static uint32_t g_cache_reclaim_shard;
+
 #define TRACE_GROUP_BLOBFS	0x7
 #define TRACE_BLOBFS_XATTR_START	SPDK_TPOINT_ID(TRACE_GROUP_BLOBFS, 0x0)
 #define TRACE_BLOBFS_XATTR_END		SPDK_TPOINT_ID(TRACE_GROUP_BLOBFS, 0x1)
@@ -114,7 +137,10 @@ cache_buffer_free(struct cache_buffer *cache_buffer)
 	free(cache_buffer);
 }
 
+/* Reads are considered a sequential stream once this many bytes were read in a row */
 #define CACHE_READAHEAD_THRESHOLD	(128 * 1024)
+/* Default limit on how far ahead of a sequential stream a file is read */
+#define CACHE_READAHEAD_MAX_DEFAULT	(2 * 1024 * 1024)
 
 struct spdk_file {
 	struct spdk_filesystem	*fs;
@@ -129,6 +155,7 @@ struct spdk_file {
 	uint64_t		append_pos;
 	uint64_t		seq_byte_count;
 	uint64_t		next_seq_offset;
+	uint64_t		readahead_max;
 	uint32_t		priority;
 	TAILQ_ENTRY(spdk_file)	tailq;
 	spdk_blob_id		blobid;
@@ -138,7 +165,12 @@ struct spdk_file {
 	struct cache_tree	*tree;
 	TAILQ_HEAD(open_requests_head, spdk_fs_request) open_requests;
 	TAILQ_HEAD(sync_requests_head, spdk_fs_request) sync_requests;
+	struct blobfs_cache_shard *cache_shard;
+	/* Protected by the lock of cache_shard */
 	TAILQ_ENTRY(spdk_file)	cache_tailq;
+	bool			cache_listed;
+	/* Set when a read is served from the cache, cleared by the reclaim poller */
+	bool			cache_referenced;
 };
 
 struct spdk_deleted_file {
@@ -292,7 +324,6 @@ __start_cache_pool_mgmt(void *ctx)
 			    "increase the memory and try again\n");
 		assert(false);
 	}
-	TAILQ_INIT(&g_caches);
 
 	assert(g_cache_pool_mgmt_poller == NULL);
 	g_cache_pool_mgmt_poller = SPDK_POLLER_REGISTER(_blobfs_cache_pool_reclaim, NULL,
@@ -302,6 +333,8 @@ __start_cache_pool_mgmt(void *ctx)
 static void
 __stop_cache_pool_mgmt(void *ctx)
 {
+	uint32_t i;
+
 	spdk_poller_unregister(&g_cache_pool_mgmt_poller);
 
 	assert(g_cache_pool != NULL);
@@ -309,14 +342,39 @@ __stop_cache_pool_mgmt(void *ctx)
 	spdk_mempool_free(g_cache_pool);
 	g_cache_pool = NULL;
 
+	for (i = 0; i < g_cache_num_shards; i++) {
+		assert(TAILQ_EMPTY(&g_cache_shards[i].files));
+		pthread_spin_destroy(&g_cache_shards[i].lock);
+	}
+
 	spdk_thread_exit(g_cache_pool_thread);
 }
 
+static void
+initialize_cache_shards(void)
+{
+	struct blobfs_cache_shard *shard;
+	uint32_t i;
+
+	g_cache_num_shards = spdk_max(spdk_min(spdk_env_get_core_count(),
+					       BLOBFS_CACHE_MAX_SHARDS), 1);
+	g_cache_next_shard = 0;
+	g_cache_reclaim_shard = 0;
+
+	for (i = 0; i < g_cache_num_shards; i++) {
+		shard = &g_cache_shards[i];
+		memset(shard, 0, sizeof(*shard));
+		pthread_spin_init(&shard->lock, PTHREAD_PROCESS_PRIVATE);
+		TAILQ_INIT(&shard->files);
+	}
+}
+
 static void
 initialize_global_cache(void)
 {
 	pthread_mutex_lock(&g_cache_init_lock);
 	if (g_fs_count == 0) {
+		initialize_cache_shards();
 		g_cache_pool_thread = spdk_thread_create("cache_pool_mgmt", NULL);
 		assert(g_cache_pool_thread != NULL);
 		spdk_thread_send_msg(g_cache_pool_thread, __start_cache_pool_mgmt, NULL);
@@ -673,6 +731,9 @@ file_alloc(struct spdk_filesystem *fs)
 	pthread_spin_init(&file->lock, 0);
 	TAILQ_INSERT_TAIL(&fs->files, file, tailq);
 	file->priority = SPDK_FILE_PRIORITY_LOW;
+	file->readahead_max = CACHE_READAHEAD_MAX_DEFAULT;
+	file->cache_shard = &g_cache_shards[__atomic_fetch_add(&g_cache_next_shard, 1,
+			    __ATOMIC_RELAXED) % g_cache_num_shards];
 	return file;
 }
 
@@ -2048,11 +2109,48 @@ spdk_fs_get_cache_size(void)
 
 static void __file_flush(void *ctx);
 
-/* Try to free some cache buffers from this file.
+/* Must be called with the file lock held */
+static void
+cache_shard_add_file(struct spdk_file *file)
+{
+	struct blobfs_cache_shard *shard = file->cache_shard;
+
+	pthread_spin_lock(&shard->lock);
+	if (!file->cache_listed) {
+		TAILQ_INSERT_TAIL(&shard->files, file, cache_tailq);
+		shard->num_files++;
+		file->cache_listed = true;
+	}
+	pthread_spin_unlock(&shard->lock);
+}
+
+/* Must be called with the file lock held */
+static void
+cache_shard_remove_file(struct spdk_file *file)
+{
+	struct blobfs_cache_shard *shard = file->cache_shard;
+
+	pthread_spin_lock(&shard->lock);
+	if (file->cache_listed) {
+		TAILQ_REMOVE(&shard->files, file, cache_tailq);
+		shard->num_files--;
+		file->cache_listed = false;
+	}
+	pthread_spin_unlock(&shard->lock);
+}
+
+static inline void
+cache_stat_inc(uint64_t *stat, uint64_t count)
+{
+	__atomic_fetch_add(stat, count, __ATOMIC_RELAXED);
+}
+
+/* Try to free some cache buffers from this file. Called with the shard lock held.
  */
 static int
-reclaim_cache_buffers(struct spdk_file *file)
+reclaim_cache_buffers(struct blobfs_cache_shard *shard, struct spdk_file *file)
 {
+	uint32_t freed;
 	int rc;
 
 	BLOBFS_TRACE(file, "free=%s\n", file->name);
@@ -2070,82 +2168,109 @@ reclaim_cache_buffers(struct spdk_file *file)
 		pthread_spin_unlock(&file->lock);
 		return -1;
 	}
-	tree_free_buffers(file->tree);
+	freed = tree_free_buffers(file->tree);
+	cache_stat_inc(&shard->evictions, freed);
 
-	TAILQ_REMOVE(&g_caches, file, cache_tailq);
+	TAILQ_REMOVE(&shard->files, file, cache_tailq);
 	/* If not freed, put it in the end of the queue */
 	if (file->tree->present_mask != 0) {
-		TAILQ_INSERT_TAIL(&g_caches, file, cache_tailq);
+		TAILQ_INSERT_TAIL(&shard->files, file, cache_tailq);
 	} else {
+		shard->num_files--;
+		file->cache_listed = false;
 		file->last = NULL;
 	}
 	pthread_spin_unlock(&file->lock);
 
-	return 0;
+	return freed > 0 ? 0 : -1;
 }
 
-static int
-_blobfs_cache_pool_reclaim(void *arg)
-{
-	struct spdk_file *file, *tmp;
-	int rc;
+enum cache_reclaim_pass {
+	CACHE_RECLAIM_LOW_PRIORITY,
+	CACHE_RECLAIM_NOT_WRITING,
+	CACHE_RECLAIM_ANY,
+};
 
-	if (!blobfs_cache_pool_need_reclaim()) {
-		return SPDK_POLLER_IDLE;
-	}
+/* Sweep the CLOCK hand (the head of the shard's list) over at most one full
+ * revolution and reclaim the first eligible file. Files referenced since the last
+ * sweep get a second chance, except in the last pass.
+ */
+static bool
+cache_shard_reclaim_pass(struct blobfs_cache_shard *shard, enum cache_reclaim_pass pass)
+{
+	struct spdk_file *file;
+	uint32_t steps;
 
-	TAILQ_FOREACH_SAFE(file, &g_caches, cache_tailq, tmp) {
-		if (!file->open_for_writing &&
-		    file->priority == SPDK_FILE_PRIORITY_LOW) {
-			rc = reclaim_cache_buffers(file);
-			if (rc < 0) {
-				continue;
-			}
-			if (!blobfs_cache_pool_need_reclaim()) {
-				return SPDK_POLLER_BUSY;
-			}
+	for (steps = shard->num_files; steps > 0; steps--) {
+		file = TAILQ_FIRST(&shard->files);
+		if (file == NULL) {
 			break;
 		}
-	}
 
-	TAILQ_FOREACH_SAFE(file, &g_caches, cache_tailq, tmp) {
-		if (!file->open_for_writing) {
-			rc = reclaim_cache_buffers(file);
-			if (rc < 0) {
-				continue;
-			}
-			if (!blobfs_cache_pool_need_reclaim()) {
-				return SPDK_POLLER_BUSY;
-			}
-			break;
+		if ((pass == CACHE_RECLAIM_LOW_PRIORITY &&
+		     file->priority != SPDK_FILE_PRIORITY_LOW) ||
+		    (pass != CACHE_RECLAIM_ANY && file->open_for_writing)) {
+			TAILQ_REMOVE(&shard->files, file, cache_tailq);
+			TAILQ_INSERT_TAIL(&shard->files, file, cache_tailq);
+			continue;
 		}
-	}
 
-	TAILQ_FOREACH_SAFE(file, &g_caches, cache_tailq, tmp) {
-		rc = reclaim_cache_buffers(file);
-		if (rc < 0) {
+		if (pass != CACHE_RECLAIM_ANY && file->cache_referenced) {
+			file->cache_referenced = false;
+			TAILQ_REMOVE(&shard->files, file, cache_tailq);
+			TAILQ_INSERT_TAIL(&shard->files, file, cache_tailq);
 			continue;
 		}
-		break;
+
+		if (reclaim_cache_buffers(shard, file) == 0) {
+			return true;
+		}
+
+		/* Either busy or nothing freeable right now, look at the next one */
+		if (file->cache_listed && TAILQ_FIRST(&shard->files) == file) {
+			TAILQ_REMOVE(&shard->files, file, cache_tailq);
+			TAILQ_INSERT_TAIL(&shard->files, file, cache_tailq);
+		}
 	}
 
-	return SPDK_POLLER_BUSY;
+	return false;
 }
 
-static void
-_add_file_to_cache_pool(void *ctx)
+static bool
+cache_shard_reclaim(struct blobfs_cache_shard *shard)
 {
-	struct spdk_file *file = ctx;
+	enum cache_reclaim_pass pass;
+	bool reclaimed = false;
+
+	pthread_spin_lock(&shard->lock);
+	for (pass = CACHE_RECLAIM_LOW_PRIORITY; pass <= CACHE_RECLAIM_ANY; pass++) {
+		if (cache_shard_reclaim_pass(shard, pass)) {
+			reclaimed = true;
+			break;
+		}
+	}
+	pthread_spin_unlock(&shard->lock);
 
-	TAILQ_INSERT_TAIL(&g_caches, file, cache_tailq);
+	return reclaimed;
 }
 
-static void
-_remove_file_from_cache_pool(void *ctx)
+static int
+_blobfs_cache_pool_reclaim(void *arg)
 {
-	struct spdk_file *file = ctx;
+	struct blobfs_cache_shard *shard;
+	uint32_t i;
+
+	for (i = 0; i < g_cache_num_shards; i++) {
+		if (!blobfs_cache_pool_need_reclaim()) {
+			return i == 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
+		}
+
+		shard = &g_cache_shards[g_cache_reclaim_shard];
+		g_cache_reclaim_shard = (g_cache_reclaim_shard + 1) % g_cache_num_shards;
+		cache_shard_reclaim(shard);
+	}
 
-	TAILQ_REMOVE(&g_caches, file, cache_tailq);
+	return SPDK_POLLER_BUSY;
 }
 
 static struct cache_buffer *
@@ -2153,7 +2278,6 @@ cache_insert_buffer(struct spdk_file *file, uint64_t offset)
 {
 	struct cache_buffer *buf;
 	int count = 0;
-	bool need_update = false;
 
 	buf = calloc(1, sizeof(*buf));
 	if (buf == NULL) {
@@ -2178,14 +2302,8 @@ cache_insert_buffer(struct spdk_file *file, uint64_t offset)
 	buf->buf_size = CACHE_BUFFER_SIZE;
 	buf->offset = offset;
 
-	if (file->tree->present_mask == 0) {
-		need_update = true;
-	}
 	file->tree = tree_insert_buffer(file->tree, buf);
-
-	if (need_update) {
-		spdk_thread_send_msg(g_cache_pool_thread, _add_file_to_cache_pool, file);
-	}
+	cache_shard_add_file(file);
 
 	return buf;
 }
@@ -2633,6 +2751,7 @@ check_readahead(struct spdk_file *file, uint64_t offset,
 	}
 
 	args->op.readahead.cache_buffer->in_progress = true;
+	cache_stat_inc(&file->cache_shard->readaheads, 1);
 	if (file->length < (offset + CACHE_BUFFER_SIZE)) {
 		args->op.readahead.length = file->length & (CACHE_BUFFER_SIZE - 1);
 	} else {
@@ -2647,6 +2766,7 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 {
 	struct spdk_fs_channel *channel = (struct spdk_fs_channel *)ctx;
 	uint64_t final_offset, final_length;
+	uint64_t ra_window, ra_offset;
 	uint32_t sub_reads = 0;
 	struct cache_buffer *buf;
 	uint64_t read_len;
@@ -2672,9 +2792,15 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 	}
 	file->seq_byte_count += length;
 	file->next_seq_offset = offset + length;
-	if (file->seq_byte_count >= CACHE_READAHEAD_THRESHOLD) {
-		check_readahead(file, offset, channel);
-		check_readahead(file, offset + CACHE_BUFFER_SIZE, channel);
+	if (file->seq_byte_count >= CACHE_READAHEAD_THRESHOLD && file->readahead_max > 0) {
+		/* Read further ahead the longer the sequential stream gets, starting
+		 * with two buffers, up to the limit set for the file.
+		 */
+		ra_window = spdk_max(file->seq_byte_count, 2 * CACHE_BUFFER_SIZE);
+		ra_window = spdk_min(ra_window, file->readahead_max);
+		for (ra_offset = 0; ra_offset < ra_window; ra_offset += CACHE_BUFFER_SIZE) {
+			check_readahead(file, offset + ra_offset, channel);
+		}
 	}
 
 	final_length = 0;
@@ -2687,6 +2813,7 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 
 		buf = tree_find_filled_buffer(file->tree, offset);
 		if (buf == NULL) {
+			cache_stat_inc(&file->cache_shard->misses, 1);
 			pthread_spin_unlock(&file->lock);
 			rc = __send_rw_from_file(file, payload, offset, length, true, channel);
 			pthread_spin_lock(&file->lock);
@@ -2700,10 +2827,12 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 			}
 			BLOBFS_TRACE(file, "read %p offset=%ju length=%ju\n", payload, offset, read_len);
 			memcpy(payload, &buf->buf[offset - buf->offset], read_len);
+			cache_stat_inc(&file->cache_shard->hits, 1);
+			file->cache_referenced = true;
 			if ((offset + read_len) % CACHE_BUFFER_SIZE == 0) {
 				tree_remove_buffer(file->tree, buf);
 				if (file->tree->present_mask == 0) {
-					spdk_thread_send_msg(g_cache_pool_thread, _remove_file_from_cache_pool, file);
+					cache_shard_remove_file(file);
 				}
 			}
 		}
@@ -2808,6 +2937,31 @@ spdk_file_set_priority(struct spdk_file *file, uint32_t priority)
 
 }
 
+void
+spdk_file_set_readahead(struct spdk_file *file, uint64_t max_bytes)
+{
+	BLOBFS_TRACE(file, "readahead=%ju\n", max_bytes);
+	pthread_spin_lock(&file->lock);
+	file->readahead_max = max_bytes;
+	pthread_spin_unlock(&file->lock);
+}
+
+void
+spdk_fs_get_cache_stats(struct spdk_fs_cache_stats *stats)
+{
+	struct blobfs_cache_shard *shard;
+	uint32_t i;
+
+	memset(stats, 0, sizeof(*stats));
+	for (i = 0; i < g_cache_num_shards; i++) {
+		shard = &g_cache_shards[i];
+		stats->hits += __atomic_load_n(&shard->hits, __ATOMIC_RELAXED);
+		stats->misses += __atomic_load_n(&shard->misses, __ATOMIC_RELAXED);
+		stats->evictions += __atomic_load_n(&shard->evictions, __ATOMIC_RELAXED);
+		stats->readaheads += __atomic_load_n(&shard->readaheads, __ATOMIC_RELAXED);
+	}
+}
+
 /*
  * Close routines
  */
@@ -2936,35 +3090,21 @@ spdk_file_get_id(struct spdk_file *file, void *id, size_t size)
 	return sizeof(spdk_blob_id);
 }
 
-static void
-_file_free(void *ctx)
-{
-	struct spdk_file *file = ctx;
-
-	TAILQ_REMOVE(&g_caches, file, cache_tailq);
-
-	free(file->name);
-	free(file->tree);
-	free(file);
-}
-
 static void
 file_free(struct spdk_file *file)
 {
 	BLOBFS_TRACE(file, "free=%s\n", file->name);
 	pthread_spin_lock(&file->lock);
-	if (file->tree->present_mask == 0) {
-		pthread_spin_unlock(&file->lock);
-		free(file->name);
-		free(file->tree);
-		free(file);
-		return;
+	if (file->tree->present_mask != 0) {
+		tree_free_buffers(file->tree);
+		assert(file->tree->present_mask == 0);
 	}
-
-	tree_free_buffers(file->tree);
-	assert(file->tree->present_mask == 0);
-	spdk_thread_send_msg(g_cache_pool_thread, _file_free, file);
+	cache_shard_remove_file(file);
 	pthread_spin_unlock(&file->lock);
+
+	free(file->name);
+	free(file->tree);
+	free(file);
 }
 
 SPDK_LOG_REGISTER_COMPONENT("blobfs", SPDK_LOG_BLOBFS)
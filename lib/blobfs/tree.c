@@ -144,15 +144,15 @@ tree_remove_buffer(struct cache_tree *tree, struct cache_buffer *buffer)
 	}
 }
 
-void
+uint32_t
 tree_free_buffers(struct cache_tree *tree)
 {
 	struct cache_buffer *buffer;
 	struct cache_tree *child;
-	uint32_t i;
+	uint32_t i, freed = 0;
 
 	if (tree->present_mask == 0) {
-		return;
+		return 0;
 	}
 
 	if (tree->level == 0) {
@@ -163,13 +163,14 @@ tree_free_buffers(struct cache_tree *tree)
 				cache_buffer_free(buffer);
 				tree->u.buffer[i] = NULL;
 				tree->present_mask &= ~(1ULL << i);
+				freed++;
 			}
 		}
 	} else {
 		for (i = 0; i < CACHE_TREE_WIDTH; i++) {
 			child = tree->u.tree[i];
 			if (child != NULL) {
-				tree_free_buffers(child);
+				freed += tree_free_buffers(child);
 				if (child->present_mask == 0) {
 					free(child);
 					tree->u.tree[i] = NULL;
@@ -178,4 +179,6 @@ tree_free_buffers(struct cache_tree *tree)
 			}
 		}
 	}
+
+	return freed;
 }
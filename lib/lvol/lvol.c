@@ -744,6 +744,52 @@ spdk_lvs_rename(struct spdk_lvol_store *lvs, const char *new_name,
 	spdk_bs_open_blob(lvs->blobstore, lvs->super_blob_id, lvs_rename_open_cb, req);
 }
 
+struct lvs_cancel_inflates_ctx {
+	struct spdk_lvol_store	*lvs;
+	struct spdk_lvol	*lvol;
+	spdk_lvs_op_complete	cb_fn;
+	void			*cb_arg;
+};
+
+static void
+lvs_cancel_inflates_next(void *cb_arg, int bserrno)
+{
+	struct lvs_cancel_inflates_ctx *ctx = cb_arg;
+	struct spdk_lvol *lvol;
+
+	while ((lvol = ctx->lvol) != NULL) {
+		ctx->lvol = TAILQ_NEXT(lvol, link);
+		if (spdk_bs_inflate_blob_cancel(ctx->lvs->blobstore, lvol->blob_id,
+						lvs_cancel_inflates_next, ctx) == 0) {
+			return;
+		}
+	}
+
+	ctx->cb_fn(ctx->cb_arg, 0);
+	free(ctx);
+}
+
+/* Inflates and parent decouples running in the background hold the blobs of their
+ * lvols open, cancel them before the blobstore goes away. They are recorded in the
+ * blobs and resumed when the lvol store is loaded again. */
+static void
+lvs_cancel_inflates(struct spdk_lvol_store *lvs, spdk_lvs_op_complete cb_fn, void *cb_arg)
+{
+	struct lvs_cancel_inflates_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->lvs = lvs;
+	ctx->lvol = TAILQ_FIRST(&lvs->lvols);
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	lvs_cancel_inflates_next(ctx, 0);
+}
+
 static void
 _lvs_unload_cb(void *cb_arg, int lvserrno)
 {
@@ -755,6 +801,29 @@ _lvs_unload_cb(void *cb_arg, int lvserrno)
 	free(lvs_req);
 }
 
+static void
+_lvs_unload_inflates_canceled(void *cb_arg, int lvserrno)
+{
+	struct spdk_lvs_req *lvs_req = cb_arg;
+	struct spdk_lvol_store *lvs = lvs_req->lvol_store;
+	struct spdk_lvol *lvol, *tmp;
+
+	if (lvserrno != 0) {
+		SPDK_ERRLOG("Cannot cancel inflates on lvol store\n");
+		_lvs_unload_cb(lvs_req, lvserrno);
+		return;
+	}
+
+	TAILQ_FOREACH_SAFE(lvol, &lvs->lvols, link, tmp) {
+		TAILQ_REMOVE(&lvs->lvols, lvol, link);
+		lvol_free(lvol);
+	}
+
+	SPDK_INFOLOG(SPDK_LOG_LVOL, "Unloading lvol store\n");
+	spdk_bs_unload(lvs->blobstore, _lvs_unload_cb, lvs_req);
+	lvs_free(lvs);
+}
+
 int
 spdk_lvs_unload(struct spdk_lvol_store *lvs, spdk_lvs_op_complete cb_fn,
 		void *cb_arg)
@@ -779,11 +848,6 @@ spdk_lvs_unload(struct spdk_lvol_store *lvs, spdk_lvs_op_complete cb_fn,
 		}
 	}
 
-	TAILQ_FOREACH_SAFE(lvol, &lvs->lvols, link, tmp) {
-		TAILQ_REMOVE(&lvs->lvols, lvol, link);
-		lvol_free(lvol);
-	}
-
 	lvs_req = calloc(1, sizeof(*lvs_req));
 	if (!lvs_req) {
 		SPDK_ERRLOG("Cannot alloc memory for lvol store request pointer\n");
@@ -792,10 +856,9 @@ spdk_lvs_unload(struct spdk_lvol_store *lvs, spdk_lvs_op_complete cb_fn,
 
 	lvs_req->cb_fn = cb_fn;
 	lvs_req->cb_arg = cb_arg;
+	lvs_req->lvol_store = lvs;
 
-	SPDK_INFOLOG(SPDK_LOG_LVOL, "Unloading lvol store\n");
-	spdk_bs_unload(lvs->blobstore, _lvs_unload_cb, lvs_req);
-	lvs_free(lvs);
+	lvs_cancel_inflates(lvs, _lvs_unload_inflates_canceled, lvs_req);
 
 	return 0;
 }
@@ -824,6 +887,27 @@ _lvs_destroy_super_cb(void *cb_arg, int bserrno)
 	lvs_free(lvs);
 }
 
+static void
+_lvs_destroy_inflates_canceled(void *cb_arg, int lvserrno)
+{
+	struct spdk_lvs_destroy_req *lvs_req = cb_arg;
+	struct spdk_lvol_store *lvs = lvs_req->lvs;
+	struct spdk_lvol *iter_lvol, *tmp;
+
+	if (lvserrno != 0) {
+		SPDK_ERRLOG("Cannot cancel inflates on lvol store\n");
+		_lvs_destroy_cb(lvs_req, lvserrno);
+		return;
+	}
+
+	TAILQ_FOREACH_SAFE(iter_lvol, &lvs->lvols, link, tmp) {
+		free(iter_lvol);
+	}
+
+	SPDK_INFOLOG(SPDK_LOG_LVOL, "Deleting super blob\n");
+	spdk_bs_delete_blob(lvs->blobstore, lvs->super_blob_id, _lvs_destroy_super_cb, lvs_req);
+}
+
 int
 spdk_lvs_destroy(struct spdk_lvol_store *lvs, spdk_lvs_op_complete cb_fn,
 		 void *cb_arg)
@@ -848,10 +932,6 @@ spdk_lvs_destroy(struct spdk_lvol_store *lvs, spdk_lvs_op_complete cb_fn,
 		}
 	}
 
-	TAILQ_FOREACH_SAFE(iter_lvol, &lvs->lvols, link, tmp) {
-		free(iter_lvol);
-	}
-
 	lvs_req = calloc(1, sizeof(*lvs_req));
 	if (!lvs_req) {
 		SPDK_ERRLOG("Cannot alloc memory for lvol store request pointer\n");
@@ -862,8 +942,7 @@ spdk_lvs_destroy(struct spdk_lvol_store *lvs, spdk_lvs_op_complete cb_fn,
 	lvs_req->cb_arg = cb_arg;
 	lvs_req->lvs = lvs;
 
-	SPDK_INFOLOG(SPDK_LOG_LVOL, "Deleting super blob\n");
-	spdk_bs_delete_blob(lvs->blobstore, lvs->super_blob_id, _lvs_destroy_super_cb, lvs_req);
+	lvs_cancel_inflates(lvs, _lvs_destroy_inflates_canceled, lvs_req);
 
 	return 0;
 }
@@ -1340,6 +1419,15 @@ spdk_lvol_rename(struct spdk_lvol *lvol, const char *new_name,
 	spdk_blob_sync_md(blob, lvol_rename_cb, req);
 }
 
+static void
+lvol_destroy_inflate_canceled(void *cb_arg, int bserrno)
+{
+	struct spdk_lvol_req *req = cb_arg;
+	struct spdk_lvol *lvol = req->lvol;
+
+	spdk_bs_delete_blob(lvol->lvol_store->blobstore, lvol->blob_id, lvol_delete_blob_cb, req);
+}
+
 void
 spdk_lvol_destroy(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg)
 {
@@ -1374,6 +1462,12 @@ spdk_lvol_destroy(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_
 	req->lvol = lvol;
 	bs = lvol->lvol_store->blobstore;
 
+	/* An inflate running in the background holds the blob open */
+	if (spdk_bs_inflate_blob_cancel(bs, lvol->blob_id, lvol_destroy_inflate_canceled,
+					req) == 0) {
+		return;
+	}
+
 	spdk_bs_delete_blob(bs, lvol->blob_id, lvol_delete_blob_cb, req);
 }
 
@@ -1436,10 +1530,13 @@ lvol_inflate_cb(void *cb_arg, int lvolerrno)
 	free(req);
 }
 
-void
-spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg)
+static void
+lvol_inflate_blob(struct spdk_lvol *lvol, bool allocate_all, bool ext,
+		  const struct spdk_blob_inflate_opts *opts,
+		  spdk_lvol_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_lvol_req *req;
+	struct spdk_blob_store *bs;
 	spdk_blob_id blob_id;
 
 	assert(cb_fn != NULL);
@@ -1467,43 +1564,49 @@ spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_
 		return;
 	}
 
+	bs = lvol->lvol_store->blobstore;
 	blob_id = spdk_blob_get_id(lvol->blob);
-	spdk_bs_inflate_blob(lvol->lvol_store->blobstore, req->channel, blob_id, lvol_inflate_cb,
-			     req);
+	/* Only the _ext calls record the operation in the blob's metadata */
+	if (!ext && allocate_all) {
+		spdk_bs_inflate_blob(bs, req->channel, blob_id, lvol_inflate_cb, req);
+	} else if (!ext) {
+		spdk_bs_blob_decouple_parent(bs, req->channel, blob_id, lvol_inflate_cb, req);
+	} else if (allocate_all) {
+		spdk_bs_inflate_blob_ext(bs, req->channel, blob_id, opts, lvol_inflate_cb, req);
+	} else {
+		spdk_bs_blob_decouple_parent_ext(bs, req->channel, blob_id, opts,
+						 lvol_inflate_cb, req);
+	}
 }
 
 void
-spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg)
+spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg)
 {
-	struct spdk_lvol_req *req;
-	spdk_blob_id blob_id;
-
-	assert(cb_fn != NULL);
+	lvol_inflate_blob(lvol, true, false, NULL, cb_fn, cb_arg);
+}
 
-	if (lvol == NULL) {
-		SPDK_ERRLOG("Lvol does not exist\n");
-		cb_fn(cb_arg, -ENODEV);
-		return;
-	}
+void
+spdk_lvol_inflate_ext(struct spdk_lvol *lvol, const struct spdk_blob_inflate_opts *opts,
+		      spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	lvol_inflate_blob(lvol, true, true, opts, cb_fn, cb_arg);
+}
 
-	req = calloc(1, sizeof(*req));
-	if (!req) {
-		SPDK_ERRLOG("Cannot alloc memory for lvol request pointer\n");
-		cb_fn(cb_arg, -ENOMEM);
-		return;
-	}
+void
+spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	lvol_inflate_blob(lvol, false, false, NULL, cb_fn, cb_arg);
+}
 
-	req->cb_fn = cb_fn;
-	req->cb_arg = cb_arg;
-	req->channel = spdk_bs_alloc_io_channel(lvol->lvol_store->blobstore);
-	if (req->channel == NULL) {
-		SPDK_ERRLOG("Cannot alloc io channel for lvol inflate request\n");
-		free(req);
-		cb_fn(cb_arg, -ENOMEM);
-		return;
-	}
+void
+spdk_lvol_decouple_parent_ext(struct spdk_lvol *lvol, const struct spdk_blob_inflate_opts *opts,
+			      spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	lvol_inflate_blob(lvol, false, true, opts, cb_fn, cb_arg);
+}
 
-	blob_id = spdk_blob_get_id(lvol->blob);
-	spdk_bs_blob_decouple_parent(lvol->lvol_store->blobstore, req->channel, blob_id,
-				     lvol_inflate_cb, req);
+int
+spdk_lvol_get_inflate_progress(struct spdk_lvol *lvol, struct spdk_blob_inflate_progress *progress)
+{
+	return spdk_blob_get_inflate_progress(lvol->blob, progress);
 }
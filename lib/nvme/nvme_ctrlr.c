@@ -47,6 +47,7 @@ static int nvme_ctrlr_construct_and_submit_aer(struct spdk_nvme_ctrlr *ctrlr,
 static void nvme_ctrlr_identify_active_ns_async(struct nvme_active_ns_ctx *ctx);
 static int nvme_ctrlr_identify_ns_async(struct spdk_nvme_ns *ns);
 static int nvme_ctrlr_identify_id_desc_async(struct spdk_nvme_ns *ns);
+static int nvme_ctrlr_identify_ns_iocs_specific_async(struct spdk_nvme_ns *ns);
 
 static int
 nvme_ctrlr_get_cc(struct spdk_nvme_ctrlr *ctrlr, union spdk_nvme_cc_register *cc)
@@ -180,7 +181,7 @@ spdk_nvme_ctrlr_get_default_ctrlr_opts(struct spdk_nvme_ctrlr_opts *opts, size_t
 	}
 
 	if (FIELD_OK(command_set)) {
-		opts->command_set = SPDK_NVME_CC_CSS_NVM;
+		opts->command_set = SPDK_NVME_CC_CSS_IOCS;
 	}
 
 	if (FIELD_OK(admin_timeout_ms)) {
@@ -981,6 +982,10 @@ nvme_ctrlr_state_string(enum nvme_ctrlr_state state)
 		return "identify controller";
 	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY:
 		return "wait for identify controller";
+	case NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC:
+		return "identify controller iocs specific";
+	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_IOCS_SPECIFIC:
+		return "wait for identify controller iocs specific";
 	case NVME_CTRLR_STATE_SET_NUM_QUEUES:
 		return "set number of queues";
 	case NVME_CTRLR_STATE_WAIT_FOR_SET_NUM_QUEUES:
@@ -999,6 +1004,10 @@ nvme_ctrlr_state_string(enum nvme_ctrlr_state state)
 		return "identify namespace id descriptors";
 	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ID_DESCS:
 		return "wait for identify namespace id descriptors";
+	case NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC:
+		return "identify ns iocs specific";
+	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS_IOCS_SPECIFIC:
+		return "wait for identify ns iocs specific";
 	case NVME_CTRLR_STATE_CONFIGURE_AER:
 		return "configure AER";
 	case NVME_CTRLR_STATE_WAIT_FOR_CONFIGURE_AER:
@@ -1365,7 +1374,7 @@ nvme_ctrlr_identify_done(void *arg, const struct spdk_nvme_cpl *cpl)
 		ctrlr->flags |= SPDK_NVME_CTRLR_COMPARE_AND_WRITE_SUPPORTED;
 	}
 
-	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_NUM_QUEUES,
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC,
 			     ctrlr->opts.admin_timeout_ms);
 }
 
@@ -1377,7 +1386,7 @@ nvme_ctrlr_identify(struct spdk_nvme_ctrlr *ctrlr)
 	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY,
 			     ctrlr->opts.admin_timeout_ms);
 
-	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_CTRLR, 0, 0,
+	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_CTRLR, 0, 0, 0,
 				     &ctrlr->cdata, sizeof(ctrlr->cdata),
 				     nvme_ctrlr_identify_done, ctrlr);
 	if (rc != 0) {
@@ -1388,6 +1397,69 @@ nvme_ctrlr_identify(struct spdk_nvme_ctrlr *ctrlr)
 	return 0;
 }
 
+static void
+nvme_ctrlr_identify_zns_specific_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_ctrlr *ctrlr = (struct spdk_nvme_ctrlr *)arg;
+	uint64_t zasl_size;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		/* The controller implements other I/O command sets, but not ZNS. */
+		SPDK_DEBUGLOG(SPDK_LOG_NVME, "Zoned Namespace Command Set not supported\n");
+		spdk_free(ctrlr->cdata_zns);
+		ctrlr->cdata_zns = NULL;
+	} else {
+		/* A ZASL of 0 means that the limit is MDTS. */
+		ctrlr->max_zone_append_size = ctrlr->max_xfer_size;
+		if (ctrlr->cdata_zns->zasl > 0) {
+			zasl_size = (uint64_t)ctrlr->min_page_size << ctrlr->cdata_zns->zasl;
+			ctrlr->max_zone_append_size = spdk_min(ctrlr->max_xfer_size, zasl_size);
+		}
+		SPDK_DEBUGLOG(SPDK_LOG_NVME, "ZASL max_zone_append_size %u\n",
+			      ctrlr->max_zone_append_size);
+	}
+
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_NUM_QUEUES,
+			     ctrlr->opts.admin_timeout_ms);
+}
+
+static int
+nvme_ctrlr_identify_iocs_specific(struct spdk_nvme_ctrlr *ctrlr)
+{
+	int	rc;
+
+	ctrlr->max_zone_append_size = 0;
+
+	if (ctrlr->opts.command_set != SPDK_NVME_CC_CSS_IOCS) {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_NUM_QUEUES,
+				     ctrlr->opts.admin_timeout_ms);
+		return 0;
+	}
+
+	if (ctrlr->cdata_zns == NULL) {
+		ctrlr->cdata_zns = spdk_zmalloc(sizeof(*ctrlr->cdata_zns), 64, NULL,
+						SPDK_ENV_SOCKET_ID_ANY,
+						SPDK_MALLOC_SHARE | SPDK_MALLOC_DMA);
+		if (ctrlr->cdata_zns == NULL) {
+			nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+			return -ENOMEM;
+		}
+	}
+
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_IOCS_SPECIFIC,
+			     ctrlr->opts.admin_timeout_ms);
+
+	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_CTRLR_IOCS, 0, 0, SPDK_NVME_CSI_ZNS,
+				     ctrlr->cdata_zns, sizeof(*ctrlr->cdata_zns),
+				     nvme_ctrlr_identify_zns_specific_done, ctrlr);
+	if (rc != 0) {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+		return rc;
+	}
+
+	return 0;
+}
+
 enum nvme_active_ns_state {
 	NVME_ACTIVE_NS_STATE_IDLE,
 	NVME_ACTIVE_NS_STATE_PROCESSING,
@@ -1507,7 +1579,7 @@ nvme_ctrlr_identify_active_ns_async(struct nvme_active_ns_ctx *ctx)
 	}
 
 	ctx->state = NVME_ACTIVE_NS_STATE_PROCESSING;
-	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_ACTIVE_NS_LIST, 0, ctx->next_nsid,
+	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_ACTIVE_NS_LIST, 0, ctx->next_nsid, 0,
 				     &ctx->new_ns_list[1024 * ctx->page], sizeof(struct spdk_nvme_ns_list),
 				     nvme_ctrlr_identify_active_ns_async_done, ctx);
 	if (rc != 0) {
@@ -1631,7 +1703,7 @@ nvme_ctrlr_identify_ns_async(struct spdk_nvme_ns *ns)
 
 	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS,
 			     ctrlr->opts.admin_timeout_ms);
-	return nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS, 0, ns->id,
+	return nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS, 0, ns->id, 0,
 				       nsdata, sizeof(*nsdata),
 				       nvme_ctrlr_identify_ns_async_done, ns);
 }
@@ -1672,16 +1744,18 @@ nvme_ctrlr_identify_id_desc_async_done(void *arg, const struct spdk_nvme_cpl *cp
 	int rc;
 
 	if (spdk_nvme_cpl_is_error(cpl)) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONFIGURE_AER,
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
 				     ctrlr->opts.admin_timeout_ms);
 		return;
 	}
 
+	nvme_ns_set_id_desc_list_data(ns);
+
 	/* move on to the next active NS */
 	nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, ns->id);
 	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
 	if (ns == NULL) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONFIGURE_AER,
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
 				     ctrlr->opts.admin_timeout_ms);
 		return;
 	}
@@ -1702,7 +1776,7 @@ nvme_ctrlr_identify_id_desc_async(struct spdk_nvme_ns *ns)
 	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ID_DESCS,
 			     ctrlr->opts.admin_timeout_ms);
 	return nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS_ID_DESCRIPTOR_LIST,
-				       0, ns->id, ns->id_desc_list, sizeof(ns->id_desc_list),
+				       0, ns->id, 0, ns->id_desc_list, sizeof(ns->id_desc_list),
 				       nvme_ctrlr_identify_id_desc_async_done, ns);
 }
 
@@ -1716,6 +1790,7 @@ nvme_ctrlr_identify_id_desc_namespaces(struct spdk_nvme_ctrlr *ctrlr)
 	if (ctrlr->vs.raw < SPDK_NVME_VERSION(1, 3, 0) ||
 	    (ctrlr->quirks & NVME_QUIRK_IDENTIFY_CNS)) {
 		SPDK_DEBUGLOG(SPDK_LOG_NVME, "Version < 1.3; not attempting to retrieve NS ID Descriptor List\n");
+		/* Only NVM command set namespaces predate the NS ID Descriptor List. */
 		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONFIGURE_AER,
 				     ctrlr->opts.admin_timeout_ms);
 		return 0;
@@ -1738,6 +1813,98 @@ nvme_ctrlr_identify_id_desc_namespaces(struct spdk_nvme_ctrlr *ctrlr)
 	return rc;
 }
 
+static struct spdk_nvme_ns *
+nvme_ctrlr_get_next_iocs_specific_ns(struct spdk_nvme_ctrlr *ctrlr, uint32_t prev_nsid)
+{
+	struct spdk_nvme_ns *ns;
+	uint32_t nsid;
+
+	nsid = prev_nsid == 0 ? spdk_nvme_ctrlr_get_first_active_ns(ctrlr) :
+	       spdk_nvme_ctrlr_get_next_active_ns(ctrlr, prev_nsid);
+	for (; nsid != 0; nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, nsid)) {
+		ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
+		if (ns != NULL && ns->csi == SPDK_NVME_CSI_ZNS) {
+			return ns;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+nvme_ctrlr_identify_ns_iocs_specific_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_ns *ns = (struct spdk_nvme_ns *)arg;
+	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
+	int rc;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		/* Not fatal: the namespace is still usable, only without its zone geometry. */
+		SPDK_WARNLOG("Failed to retrieve zoned namespace data of NS %u\n", ns->id);
+		nvme_ns_free_zns_specific_data(ns);
+	}
+
+	/* move on to the next zoned NS */
+	ns = nvme_ctrlr_get_next_iocs_specific_ns(ctrlr, ns->id);
+	if (ns == NULL) {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONFIGURE_AER,
+				     ctrlr->opts.admin_timeout_ms);
+		return;
+	}
+
+	rc = nvme_ctrlr_identify_ns_iocs_specific_async(ns);
+	if (rc) {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	}
+}
+
+static int
+nvme_ctrlr_identify_ns_iocs_specific_async(struct spdk_nvme_ns *ns)
+{
+	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
+	int rc;
+
+	assert(ns->csi == SPDK_NVME_CSI_ZNS);
+
+	rc = nvme_ns_alloc_zns_specific_data(ns);
+	if (rc) {
+		return rc;
+	}
+
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS_IOCS_SPECIFIC,
+			     ctrlr->opts.admin_timeout_ms);
+	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_NS_IOCS, 0, ns->id,
+				     SPDK_NVME_CSI_ZNS, ns->nsdata_zns, sizeof(*ns->nsdata_zns),
+				     nvme_ctrlr_identify_ns_iocs_specific_async_done, ns);
+	if (rc) {
+		nvme_ns_free_zns_specific_data(ns);
+	}
+
+	return rc;
+}
+
+static int
+nvme_ctrlr_identify_namespaces_iocs_specific(struct spdk_nvme_ctrlr *ctrlr)
+{
+	struct spdk_nvme_ns *ns;
+	int rc;
+
+	ns = nvme_ctrlr_get_next_iocs_specific_ns(ctrlr, 0);
+	if (ns == NULL) {
+		/* No zoned NS, move on to the next state */
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONFIGURE_AER,
+				     ctrlr->opts.admin_timeout_ms);
+		return 0;
+	}
+
+	rc = nvme_ctrlr_identify_ns_iocs_specific_async(ns);
+	if (rc) {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	}
+
+	return rc;
+}
+
 static void
 nvme_ctrlr_update_nvmf_ioccsz(struct spdk_nvme_ctrlr *ctrlr)
 {
@@ -2635,6 +2802,14 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
 		break;
 
+	case NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC:
+		rc = nvme_ctrlr_identify_iocs_specific(ctrlr);
+		break;
+
+	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_IOCS_SPECIFIC:
+		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
+		break;
+
 	case NVME_CTRLR_STATE_SET_NUM_QUEUES:
 		nvme_ctrlr_update_nvmf_ioccsz(ctrlr);
 		rc = nvme_ctrlr_set_num_queues(ctrlr);
@@ -2674,6 +2849,14 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
 		break;
 
+	case NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC:
+		rc = nvme_ctrlr_identify_namespaces_iocs_specific(ctrlr);
+		break;
+
+	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS_IOCS_SPECIFIC:
+		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
+		break;
+
 	case NVME_CTRLR_STATE_CONFIGURE_AER:
 		rc = nvme_ctrlr_configure_aer(ctrlr);
 		break;
@@ -2865,6 +3048,9 @@ nvme_ctrlr_destruct(struct spdk_nvme_ctrlr *ctrlr)
 
 	nvme_ctrlr_destruct_namespaces(ctrlr);
 
+	spdk_free(ctrlr->cdata_zns);
+	ctrlr->cdata_zns = NULL;
+
 	spdk_bit_array_free(&ctrlr->free_io_qids);
 
 	nvme_transport_ctrlr_destruct(ctrlr);
@@ -257,7 +257,14 @@ struct nvme_request {
 	 * True if the request is in the queued_req list.
 	 */
 	uint8_t				queued : 1;
-	uint8_t				reserved : 6;
+
+	/**
+	 * True if this request was split into more children than could be
+	 *  allocated when it was submitted.  The remaining children are built
+	 *  from the split member as earlier children complete.
+	 */
+	uint8_t				split_pending : 1;
+	uint8_t				reserved : 5;
 
 	/**
 	 * Number of children requests still outstanding for this
@@ -344,6 +351,25 @@ struct nvme_request {
 	 */
 	struct spdk_nvme_cpl		parent_status;
 
+	/**
+	 * Part of a request split on max I/O size or stripe boundaries that
+	 *  has no child requests yet.  Only valid while split_pending is set.
+	 */
+	struct {
+		struct spdk_nvme_ns	*ns;
+		uint64_t		lba;
+		uint32_t		lba_count;
+		uint32_t		payload_offset;
+		uint32_t		md_offset;
+		uint32_t		sector_size;
+		uint32_t		sectors_per_io;
+		uint32_t		sector_mask;
+		uint32_t		io_flags;
+		uint16_t		apptag_mask;
+		uint16_t		apptag;
+		uint8_t			opc;
+	} split;
+
 	/**
 	 * The user_cb_fn and user_cb_arg fields are used for holding the original
 	 * callback data when using nvme_allocate_request_user_copy.
@@ -408,6 +434,9 @@ struct spdk_nvme_qpair {
 	STAILQ_HEAD(, nvme_request)		queued_req;
 	STAILQ_HEAD(, nvme_request)		aborting_queued_req;
 
+	/* Split requests waiting for free requests to build their remaining children */
+	STAILQ_HEAD(, nvme_request)		split_req;
+
 	/* List entry for spdk_nvme_transport_poll_group::qpairs */
 	STAILQ_ENTRY(spdk_nvme_qpair)		poll_group_stailq;
 
@@ -437,6 +466,7 @@ struct spdk_nvme_qpair {
 
 struct spdk_nvme_poll_group {
 	void						*ctx;
+	struct spdk_nvme_accel_fn_table			accel_fn_table;
 	STAILQ_HEAD(, spdk_nvme_transport_poll_group)	tgroups;
 };
 
@@ -468,8 +498,14 @@ struct spdk_nvme_ns {
 	uint32_t			id;
 	uint16_t			flags;
 
+	/* Command Set Identifier */
+	enum spdk_nvme_csi		csi;
+
 	/* Namespace Identification Descriptor List (CNS = 03h) */
 	uint8_t				id_desc_list[4096];
+
+	/* Zoned Namespace Command Set Specific Identify Namespace data (CNS = 05h, CSI = 02h) */
+	struct spdk_nvme_zns_ns_data	*nsdata_zns;
 };
 
 /**
@@ -521,6 +557,17 @@ enum nvme_ctrlr_state {
 	 */
 	NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY,
 
+	/**
+	 * Get Identify Controller data specific to the I/O command sets.
+	 */
+	NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC,
+
+	/**
+	 * Waiting for the Identify Controller command specific to the
+	 * I/O command sets to be completed.
+	 */
+	NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_IOCS_SPECIFIC,
+
 	/**
 	 * Set Number of Queues of the controller.
 	 */
@@ -567,6 +614,17 @@ enum nvme_ctrlr_state {
 	 */
 	NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ID_DESCS,
 
+	/**
+	 * Get Identify Namespace data specific to the command set of each NS.
+	 */
+	NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
+
+	/**
+	 * Waiting for the Identify Namespace commands specific to
+	 * the command sets to be completed.
+	 */
+	NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS_IOCS_SPECIFIC,
+
 	/**
 	 * Configure AER of the controller.
 	 */
@@ -723,6 +781,9 @@ struct spdk_nvme_ctrlr {
 	/** maximum i/o size in bytes */
 	uint32_t			max_xfer_size;
 
+	/** maximum zone append size in bytes */
+	uint32_t			max_zone_append_size;
+
 	/** minimum page size supported by this controller in bytes */
 	uint32_t			min_page_size;
 
@@ -747,6 +808,11 @@ struct spdk_nvme_ctrlr {
 	 */
 	struct spdk_nvme_ctrlr_data	cdata;
 
+	/**
+	 * Zoned Namespace Command Set Specific Identify Controller data.
+	 */
+	struct spdk_nvme_zns_ctrlr_data	*cdata_zns;
+
 	/**
 	 * Keep track of active namespaces
 	 */
@@ -854,7 +920,7 @@ int nvme_poll_group_disconnect_qpair(struct spdk_nvme_qpair *qpair);
 /* Admin functions */
 int	nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr,
 				uint8_t cns, uint16_t cntid, uint32_t nsid,
-				void *payload, size_t payload_size,
+				uint8_t csi, void *payload, size_t payload_size,
 				spdk_nvme_cmd_cb cb_fn, void *cb_arg);
 int	nvme_ctrlr_cmd_set_num_queues(struct spdk_nvme_ctrlr *ctrlr,
 				      uint32_t num_queues, spdk_nvme_cmd_cb cb_fn,
@@ -939,10 +1005,24 @@ void	nvme_qpair_resubmit_requests(struct spdk_nvme_qpair *qpair, uint32_t num_re
 
 int	nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr);
 void	nvme_ns_set_identify_data(struct spdk_nvme_ns *ns);
+void	nvme_ns_set_id_desc_list_data(struct spdk_nvme_ns *ns);
+int	nvme_ns_alloc_zns_specific_data(struct spdk_nvme_ns *ns);
+void	nvme_ns_free_zns_specific_data(struct spdk_nvme_ns *ns);
 int	nvme_ns_construct(struct spdk_nvme_ns *ns, uint32_t id,
 			  struct spdk_nvme_ctrlr *ctrlr);
 void	nvme_ns_destruct(struct spdk_nvme_ns *ns);
 int	nvme_ns_update(struct spdk_nvme_ns *ns);
+bool	nvme_ns_cmd_resume_split(struct nvme_request *req);
+int	nvme_ns_cmd_zone_append_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+					void *buffer, void *metadata, uint64_t zslba,
+					uint32_t lba_count, spdk_nvme_cmd_cb cb_fn, void *cb_arg,
+					uint32_t io_flags, uint16_t apptag_mask, uint16_t apptag);
+int	nvme_ns_cmd_zone_appendv_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+		uint64_t zslba, uint32_t lba_count,
+		spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t io_flags,
+		spdk_nvme_req_reset_sgl_cb reset_sgl_fn,
+		spdk_nvme_req_next_sge_cb next_sge_fn, void *metadata,
+		uint16_t apptag_mask, uint16_t apptag);
 
 int	nvme_fabric_ctrlr_set_reg_4(struct spdk_nvme_ctrlr *ctrlr, uint32_t offset, uint32_t value);
 int	nvme_fabric_ctrlr_set_reg_8(struct spdk_nvme_ctrlr *ctrlr, uint32_t offset, uint64_t value);
@@ -1104,7 +1184,7 @@ nvme_cb_complete_child(void *child_arg, const struct spdk_nvme_cpl *cpl)
 		memcpy(&parent->parent_status, cpl, sizeof(*cpl));
 	}
 
-	if (parent->num_children == 0) {
+	if (parent->num_children == 0 && !parent->split_pending) {
 		nvme_complete_request(parent->cb_fn, parent->cb_arg, parent->qpair,
 				      parent, &parent->parent_status);
 		nvme_free_request(parent);
@@ -1116,7 +1196,7 @@ nvme_request_add_child(struct nvme_request *parent, struct nvme_request *child)
 {
 	assert(parent->num_children != UINT16_MAX);
 
-	if (parent->num_children == 0) {
+	if (parent->num_children == 0 && !parent->split_pending) {
 		/*
 		 * Defer initialization of the children TAILQ since it falls
 		 *  on a separate cacheline.  This ensures we do not touch this
@@ -1214,6 +1294,8 @@ int nvme_transport_poll_group_connect_qpair(struct spdk_nvme_qpair *qpair);
 int64_t nvme_transport_poll_group_process_completions(struct spdk_nvme_transport_poll_group *tgroup,
 		uint32_t completions_per_qpair, spdk_nvme_disconnected_qpair_cb disconnected_qpair_cb);
 int nvme_transport_poll_group_destroy(struct spdk_nvme_transport_poll_group *tgroup);
+int nvme_transport_poll_group_get_stats(struct spdk_nvme_transport_poll_group *tgroup,
+					struct spdk_nvme_transport_poll_group_stat *stat);
 /*
  * Below ref related functions must be called with the global
  *  driver lock held for the multi-process condition.
@@ -0,0 +1,1277 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * NVMe over memory transport
+ *
+ * Emulates an NVMe controller with a single namespace inside the host process.
+ * Commands are placed on a submission queue ring, executed by the emulated
+ * controller when the queue pair is polled and their completions are posted
+ * to a completion queue ring with a phase bit, the same way a PCIe device
+ * does. An optional per command latency and a bandwidth limit shared by all
+ * queue pairs of the controller model the media, so the host side cost of
+ * each I/O can be measured without any hardware.
+ *
+ * The controller is configured through the transport address:
+ *
+ *   trtype:MEMORY traddr:<name>[,<option>=<value>...]
+ *
+ * See nvme_mem_parse_opts() for the list of options.
+ */
+
+#include "nvme_internal.h"
+
+#include "spdk/endian.h"
+#include "spdk/likely.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+#define NVME_MEM_DEFAULT_BLOCK_SIZE		512
+#define NVME_MEM_DEFAULT_NUM_BLOCKS		(1024 * 1024 * 1024 / NVME_MEM_DEFAULT_BLOCK_SIZE)
+#define NVME_MEM_DEFAULT_IO_QUEUES		128
+#define NVME_MEM_DEFAULT_QUEUE_SIZE		1024
+#define NVME_MEM_DEFAULT_MAX_XFER_SIZE		(128 * 1024)
+#define NVME_MEM_PAGE_SIZE			4096
+#define NVME_MEM_NSID				1
+
+/* Configuration of an emulated controller, parsed from the transport address */
+struct nvme_mem_ctrlr_opts {
+	uint32_t	block_size;
+	uint64_t	num_blocks;
+	uint32_t	io_queues;
+	uint32_t	queue_size;
+	uint32_t	max_xfer_size;
+	uint32_t	latency_us;
+	uint32_t	mb_per_sec;
+	bool		store_data;
+};
+
+/* NVMe memory transport extensions for spdk_nvme_ctrlr */
+struct nvme_mem_ctrlr {
+	struct spdk_nvme_ctrlr		ctrlr;
+
+	struct nvme_mem_ctrlr_opts	opts;
+
+	/* Emulated controller state */
+	struct spdk_nvme_registers	regs;
+	struct spdk_nvme_ctrlr_data	cdata;
+	struct spdk_nvme_ns_data	nsdata;
+	uint32_t			num_io_queues;
+
+	/* Namespace contents, NULL if the data is not stored */
+	uint8_t				*data;
+
+	uint64_t			latency_ticks;
+	uint64_t			bytes_per_sec;
+	uint64_t			ticks_hz;
+	/* Tick at which the media is done with the transfers accepted so far */
+	uint64_t			media_busy_tsc;
+};
+
+struct nvme_mem_tracker {
+	TAILQ_ENTRY(nvme_mem_tracker)	tq_list;
+	TAILQ_ENTRY(nvme_mem_tracker)	ctrlr_list;
+
+	struct nvme_request		*req;
+	uint16_t			cid;
+
+	/* Completion the emulated controller posts once ready_tsc has passed */
+	uint64_t			ready_tsc;
+	struct spdk_nvme_status		status;
+	uint32_t			cdw0;
+};
+
+/* NVMe memory transport extensions for spdk_nvme_qpair */
+struct nvme_mem_qpair {
+	struct spdk_nvme_qpair			qpair;
+
+	uint16_t				num_entries;
+
+	/* Queues shared by the host and the emulated controller */
+	struct spdk_nvme_cmd			*cmd;
+	struct spdk_nvme_cpl			*cpl;
+
+	/* Host side */
+	uint16_t				sq_tail;
+	uint16_t				cq_head;
+	uint8_t					phase;
+
+	struct nvme_mem_tracker			*tr;
+	TAILQ_HEAD(, nvme_mem_tracker)		free_tr;
+	TAILQ_HEAD(, nvme_mem_tracker)		outstanding_tr;
+
+	/* Controller side */
+	uint16_t				sq_head;
+	uint16_t				cq_tail;
+	uint8_t					ctrlr_phase;
+
+	/* Commands being executed, in the order their completions are posted */
+	TAILQ_HEAD(, nvme_mem_tracker)		executing_tr;
+	/* Asynchronous Event Requests held by the controller */
+	TAILQ_HEAD(, nvme_mem_tracker)		aer_tr;
+};
+
+struct nvme_mem_poll_group {
+	struct spdk_nvme_transport_poll_group	group;
+};
+
+static inline struct nvme_mem_ctrlr *
+nvme_mem_ctrlr(struct spdk_nvme_ctrlr *ctrlr)
+{
+	assert(ctrlr->trid.trtype == SPDK_NVME_TRANSPORT_CUSTOM);
+	return SPDK_CONTAINEROF(ctrlr, struct nvme_mem_ctrlr, ctrlr);
+}
+
+static inline struct nvme_mem_qpair *
+nvme_mem_qpair(struct spdk_nvme_qpair *qpair)
+{
+	return SPDK_CONTAINEROF(qpair, struct nvme_mem_qpair, qpair);
+}
+
+static void
+nvme_mem_get_default_opts(struct nvme_mem_ctrlr_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->block_size = NVME_MEM_DEFAULT_BLOCK_SIZE;
+	opts->num_blocks = NVME_MEM_DEFAULT_NUM_BLOCKS;
+	opts->io_queues = NVME_MEM_DEFAULT_IO_QUEUES;
+	opts->queue_size = NVME_MEM_DEFAULT_QUEUE_SIZE;
+	opts->max_xfer_size = NVME_MEM_DEFAULT_MAX_XFER_SIZE;
+}
+
+/*
+ * Parse the options following the controller name in the transport address.
+ * Options are separated by ',' and take the form <option>=<value>:
+ *
+ *   block_size    - logical block size in bytes (512)
+ *   num_blocks    - namespace size in logical blocks (1 GiB worth)
+ *   io_queues     - maximum number of I/O queue pairs (128)
+ *   queue_size    - maximum number of entries of an I/O queue (1024)
+ *   max_xfer_size - maximum data transfer size in bytes (128 KiB)
+ *   latency_us    - time each I/O command spends on the media (0)
+ *   mb_per_sec    - media bandwidth in MB/s shared by all queues, 0 for unlimited (0)
+ *   store_data    - 1 to keep the namespace contents in memory, otherwise
+ *                   written data is discarded and reads leave the buffer untouched (0)
+ */
+static int
+nvme_mem_parse_opts(const char *traddr, struct nvme_mem_ctrlr_opts *opts)
+{
+	char buf[SPDK_NVMF_TRADDR_MAX_LEN + 1];
+	char *tok, *sp = NULL, *val;
+	long long num;
+
+	nvme_mem_get_default_opts(opts);
+
+	snprintf(buf, sizeof(buf), "%s", traddr);
+
+	/* The first token is the name of the controller. */
+	tok = strtok_r(buf, ",", &sp);
+	if (tok == NULL) {
+		SPDK_ERRLOG("Missing controller name in traddr '%s'\n", traddr);
+		return -EINVAL;
+	}
+
+	while ((tok = strtok_r(NULL, ",", &sp)) != NULL) {
+		val = strchr(tok, '=');
+		if (val == NULL) {
+			SPDK_ERRLOG("Option '%s' has no value\n", tok);
+			return -EINVAL;
+		}
+		*val++ = '\0';
+
+		num = spdk_strtoll(val, 0);
+		if (num < 0 || (num > UINT32_MAX && strcmp(tok, "num_blocks") != 0)) {
+			SPDK_ERRLOG("Invalid value '%s' of option '%s'\n", val, tok);
+			return -EINVAL;
+		}
+
+		if (strcmp(tok, "block_size") == 0) {
+			opts->block_size = num;
+		} else if (strcmp(tok, "num_blocks") == 0) {
+			opts->num_blocks = num;
+		} else if (strcmp(tok, "io_queues") == 0) {
+			opts->io_queues = num;
+		} else if (strcmp(tok, "queue_size") == 0) {
+			opts->queue_size = num;
+		} else if (strcmp(tok, "max_xfer_size") == 0) {
+			opts->max_xfer_size = num;
+		} else if (strcmp(tok, "latency_us") == 0) {
+			opts->latency_us = num;
+		} else if (strcmp(tok, "mb_per_sec") == 0) {
+			opts->mb_per_sec = num;
+		} else if (strcmp(tok, "store_data") == 0) {
+			opts->store_data = num != 0;
+		} else {
+			SPDK_ERRLOG("Unknown option '%s'\n", tok);
+			return -EINVAL;
+		}
+	}
+
+	if (opts->block_size < 512 || opts->block_size > NVME_MEM_PAGE_SIZE ||
+	    !spdk_u32_is_pow2(opts->block_size)) {
+		SPDK_ERRLOG("block_size must be a power of 2 between 512 and %u\n",
+			    NVME_MEM_PAGE_SIZE);
+		return -EINVAL;
+	}
+
+	if (opts->num_blocks == 0 || opts->num_blocks > UINT64_MAX / opts->block_size) {
+		SPDK_ERRLOG("Invalid num_blocks %" PRIu64 "\n", opts->num_blocks);
+		return -EINVAL;
+	}
+
+	if (opts->io_queues == 0 || opts->io_queues > UINT16_MAX) {
+		SPDK_ERRLOG("io_queues must be between 1 and %u\n", UINT16_MAX);
+		return -EINVAL;
+	}
+
+	if (opts->queue_size < 2 || opts->queue_size > UINT16_MAX + 1u) {
+		SPDK_ERRLOG("queue_size must be between 2 and %u\n", UINT16_MAX + 1u);
+		return -EINVAL;
+	}
+
+	if (opts->max_xfer_size < NVME_MEM_PAGE_SIZE || !spdk_u32_is_pow2(opts->max_xfer_size)) {
+		SPDK_ERRLOG("max_xfer_size must be a power of 2 of at least %u\n",
+			    NVME_MEM_PAGE_SIZE);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+nvme_mem_ctrlr_init_data(struct nvme_mem_ctrlr *mctrlr)
+{
+	struct nvme_mem_ctrlr_opts *opts = &mctrlr->opts;
+	struct spdk_nvme_ctrlr_data *cdata = &mctrlr->cdata;
+	struct spdk_nvme_ns_data *nsdata = &mctrlr->nsdata;
+
+	mctrlr->regs.cap.bits.mqes = opts->queue_size - 1;
+	mctrlr->regs.cap.bits.cqr = 1;
+	mctrlr->regs.cap.bits.to = 1;
+	mctrlr->regs.cap.bits.css = SPDK_NVME_CAP_CSS_NVM;
+	mctrlr->regs.vs.raw = SPDK_NVME_VERSION(1, 3, 0);
+
+	spdk_strcpy_pad(cdata->sn, mctrlr->ctrlr.trid.traddr, sizeof(cdata->sn), ' ');
+	spdk_strcpy_pad(cdata->mn, "SPDK Memory Controller", sizeof(cdata->mn), ' ');
+	spdk_strcpy_pad(cdata->fr, "1.0", sizeof(cdata->fr), ' ');
+	cdata->mdts = spdk_u32log2(opts->max_xfer_size / NVME_MEM_PAGE_SIZE);
+	cdata->cntlid = 1;
+	cdata->ver = mctrlr->regs.vs;
+	cdata->aerl = 3;
+	cdata->elpe = 0;
+	cdata->sqes.min = 6;
+	cdata->sqes.max = 6;
+	cdata->cqes.min = 4;
+	cdata->cqes.max = 4;
+	cdata->maxcmd = opts->queue_size;
+	cdata->nn = 1;
+	cdata->oncs.compare = 1;
+	cdata->oncs.dsm = 1;
+	cdata->oncs.write_zeroes = 1;
+	/* The data buffers are accessed by virtual address, any layout is fine. */
+	cdata->sgls.supported = 1;
+
+	nsdata->nsze = opts->num_blocks;
+	nsdata->ncap = opts->num_blocks;
+	nsdata->nuse = opts->num_blocks;
+	nsdata->nlbaf = 0;
+	nsdata->flbas.format = 0;
+	nsdata->lbaf[0].lbads = spdk_u32log2(opts->block_size);
+}
+
+/*
+ * Copy between a request's payload and a flat buffer of the emulated controller.
+ * This is the controller's data transfer, done by virtual address instead of
+ * through PRP or SGL descriptors.
+ */
+static int
+nvme_mem_req_copy(struct nvme_request *req, void *buf, uint32_t len, bool to_host)
+{
+	uint8_t *host_buf;
+	uint32_t offset = 0, sge_len;
+	void *sge;
+	int rc;
+
+	len = spdk_min(len, req->payload_size);
+
+	if (nvme_payload_type(&req->payload) == NVME_PAYLOAD_TYPE_CONTIG) {
+		host_buf = (uint8_t *)req->payload.contig_or_cb_arg + req->payload_offset;
+		if (to_host) {
+			memcpy(host_buf, buf, len);
+		} else {
+			memcpy(buf, host_buf, len);
+		}
+		return 0;
+	}
+
+	req->payload.reset_sgl_fn(req->payload.contig_or_cb_arg, req->payload_offset);
+	while (offset < len) {
+		rc = req->payload.next_sge_fn(req->payload.contig_or_cb_arg, &sge, &sge_len);
+		if (rc != 0 || sge_len == 0) {
+			return -EFAULT;
+		}
+
+		sge_len = spdk_min(sge_len, len - offset);
+		if (to_host) {
+			memcpy(sge, (uint8_t *)buf + offset, sge_len);
+		} else {
+			memcpy((uint8_t *)buf + offset, sge, sge_len);
+		}
+		offset += sge_len;
+	}
+
+	return 0;
+}
+
+static int
+nvme_mem_req_compare(struct nvme_request *req, const uint8_t *buf, uint32_t len, bool *equal)
+{
+	uint32_t offset = 0, sge_len;
+	void *sge;
+	int rc;
+
+	if (nvme_payload_type(&req->payload) == NVME_PAYLOAD_TYPE_CONTIG) {
+		*equal = memcmp((uint8_t *)req->payload.contig_or_cb_arg + req->payload_offset,
+				buf, len) == 0;
+		return 0;
+	}
+
+	*equal = true;
+	req->payload.reset_sgl_fn(req->payload.contig_or_cb_arg, req->payload_offset);
+	while (offset < len) {
+		rc = req->payload.next_sge_fn(req->payload.contig_or_cb_arg, &sge, &sge_len);
+		if (rc != 0 || sge_len == 0) {
+			return -EFAULT;
+		}
+
+		sge_len = spdk_min(sge_len, len - offset);
+		if (memcmp(sge, buf + offset, sge_len) != 0) {
+			*equal = false;
+			return 0;
+		}
+		offset += sge_len;
+	}
+
+	return 0;
+}
+
+static inline void
+nvme_mem_tracker_set_status(struct nvme_mem_tracker *tr, uint16_t sct, uint16_t sc)
+{
+	tr->status.sct = sct;
+	tr->status.sc = sc;
+}
+
+static void
+nvme_mem_ctrlr_identify(struct nvme_mem_ctrlr *mctrlr, const struct spdk_nvme_cmd *cmd,
+			struct nvme_mem_tracker *tr)
+{
+	struct nvme_request *req = tr->req;
+	struct spdk_nvme_ns_list ns_list;
+	uint8_t desc_list[4096];
+
+	switch (cmd->cdw10_bits.identify.cns) {
+	case SPDK_NVME_IDENTIFY_CTRLR:
+		nvme_mem_req_copy(req, &mctrlr->cdata, sizeof(mctrlr->cdata), true);
+		break;
+	case SPDK_NVME_IDENTIFY_NS:
+		if (cmd->nsid != NVME_MEM_NSID) {
+			nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC,
+						    SPDK_NVME_SC_INVALID_NAMESPACE_OR_FORMAT);
+			break;
+		}
+		nvme_mem_req_copy(req, &mctrlr->nsdata, sizeof(mctrlr->nsdata), true);
+		break;
+	case SPDK_NVME_IDENTIFY_ACTIVE_NS_LIST:
+		memset(&ns_list, 0, sizeof(ns_list));
+		if (cmd->nsid < NVME_MEM_NSID) {
+			ns_list.ns_list[0] = NVME_MEM_NSID;
+		}
+		nvme_mem_req_copy(req, &ns_list, sizeof(ns_list), true);
+		break;
+	case SPDK_NVME_IDENTIFY_NS_ID_DESCRIPTOR_LIST:
+		/* No namespace identifiers are reported. */
+		memset(desc_list, 0, sizeof(desc_list));
+		nvme_mem_req_copy(req, desc_list, sizeof(desc_list), true);
+		break;
+	default:
+		nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC, SPDK_NVME_SC_INVALID_FIELD);
+		break;
+	}
+}
+
+static void
+nvme_mem_ctrlr_features(struct nvme_mem_ctrlr *mctrlr, const struct spdk_nvme_cmd *cmd,
+			struct nvme_mem_tracker *tr)
+{
+	union spdk_nvme_feat_number_of_queues num_queues;
+	uint8_t fid;
+
+	if (cmd->opc == SPDK_NVME_OPC_SET_FEATURES) {
+		fid = cmd->cdw10_bits.set_features.fid;
+	} else {
+		fid = cmd->cdw10_bits.get_features.fid;
+	}
+
+	switch (fid) {
+	case SPDK_NVME_FEAT_NUMBER_OF_QUEUES:
+		if (cmd->opc == SPDK_NVME_OPC_SET_FEATURES) {
+			num_queues = cmd->cdw11_bits.feat_num_of_queues;
+			mctrlr->num_io_queues = spdk_min(num_queues.bits.nsqr, num_queues.bits.ncqr) + 1u;
+			mctrlr->num_io_queues = spdk_min(mctrlr->num_io_queues, mctrlr->opts.io_queues);
+		}
+		num_queues.raw = 0;
+		num_queues.bits.nsqr = mctrlr->num_io_queues - 1;
+		num_queues.bits.ncqr = mctrlr->num_io_queues - 1;
+		tr->cdw0 = num_queues.raw;
+		break;
+	case SPDK_NVME_FEAT_KEEP_ALIVE_TIMER:
+		nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC, SPDK_NVME_SC_INVALID_FIELD);
+		break;
+	default:
+		/* Accept any other feature, there is nothing for it to change. */
+		break;
+	}
+}
+
+static void
+nvme_mem_ctrlr_admin_cmd(struct nvme_mem_ctrlr *mctrlr, struct nvme_mem_qpair *mqpair,
+			 const struct spdk_nvme_cmd *cmd, struct nvme_mem_tracker *tr)
+{
+	uint8_t log_page[4096];
+
+	switch (cmd->opc) {
+	case SPDK_NVME_OPC_IDENTIFY:
+		nvme_mem_ctrlr_identify(mctrlr, cmd, tr);
+		break;
+	case SPDK_NVME_OPC_SET_FEATURES:
+	case SPDK_NVME_OPC_GET_FEATURES:
+		nvme_mem_ctrlr_features(mctrlr, cmd, tr);
+		break;
+	case SPDK_NVME_OPC_GET_LOG_PAGE:
+		/* All log pages are empty. */
+		memset(log_page, 0, sizeof(log_page));
+		nvme_mem_req_copy(tr->req, log_page, sizeof(log_page), true);
+		break;
+	case SPDK_NVME_OPC_ASYNC_EVENT_REQUEST:
+		/* No events are ever generated, hold the request until the queue is deleted. */
+		TAILQ_INSERT_TAIL(&mqpair->aer_tr, tr, ctrlr_list);
+		return;
+	case SPDK_NVME_OPC_ABORT:
+		/* Commands complete on their own, report that nothing was aborted. */
+		tr->cdw0 = 1;
+		break;
+	case SPDK_NVME_OPC_KEEP_ALIVE:
+		break;
+	default:
+		nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC, SPDK_NVME_SC_INVALID_OPCODE);
+		break;
+	}
+
+	TAILQ_INSERT_TAIL(&mqpair->executing_tr, tr, ctrlr_list);
+}
+
+/* Account for a transfer on the media and return the tick at which it is done. */
+static uint64_t
+nvme_mem_ctrlr_media_xfer(struct nvme_mem_ctrlr *mctrlr, uint64_t now, uint32_t len)
+{
+	uint64_t busy, done;
+
+	busy = __atomic_load_n(&mctrlr->media_busy_tsc, __ATOMIC_RELAXED);
+	do {
+		done = spdk_max(busy, now) + len * mctrlr->ticks_hz / mctrlr->bytes_per_sec;
+	} while (!__atomic_compare_exchange_n(&mctrlr->media_busy_tsc, &busy, done, true,
+					      __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	return done;
+}
+
+static void
+nvme_mem_ctrlr_io_cmd(struct nvme_mem_ctrlr *mctrlr, struct nvme_mem_qpair *mqpair,
+		      const struct spdk_nvme_cmd *cmd, struct nvme_mem_tracker *tr)
+{
+	struct nvme_request *req = tr->req;
+	uint64_t lba, num_blocks, now;
+	uint32_t len = 0;
+	uint8_t *data = NULL;
+	bool equal;
+
+	if (spdk_unlikely(cmd->nsid != NVME_MEM_NSID)) {
+		nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC,
+					    SPDK_NVME_SC_INVALID_NAMESPACE_OR_FORMAT);
+		goto out;
+	}
+
+	switch (cmd->opc) {
+	case SPDK_NVME_OPC_READ:
+	case SPDK_NVME_OPC_WRITE:
+	case SPDK_NVME_OPC_COMPARE:
+	case SPDK_NVME_OPC_WRITE_ZEROES:
+		lba = from_le64(&cmd->cdw10);
+		num_blocks = (from_le32(&cmd->cdw12) & 0xFFFFu) + 1;
+		if (spdk_unlikely(lba + num_blocks > mctrlr->opts.num_blocks)) {
+			nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC,
+						    SPDK_NVME_SC_LBA_OUT_OF_RANGE);
+			goto out;
+		}
+
+		if (cmd->opc != SPDK_NVME_OPC_WRITE_ZEROES) {
+			len = num_blocks * mctrlr->opts.block_size;
+			if (spdk_unlikely(len > req->payload_size)) {
+				nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC,
+							    SPDK_NVME_SC_DATA_SGL_LENGTH_INVALID);
+				goto out;
+			}
+		}
+
+		if (mctrlr->data != NULL) {
+			data = mctrlr->data + lba * mctrlr->opts.block_size;
+		}
+		break;
+	default:
+		break;
+	}
+
+	switch (cmd->opc) {
+	case SPDK_NVME_OPC_READ:
+		if (data != NULL && nvme_mem_req_copy(req, data, len, true) != 0) {
+			nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC,
+						    SPDK_NVME_SC_DATA_TRANSFER_ERROR);
+		}
+		break;
+	case SPDK_NVME_OPC_WRITE:
+		if (data != NULL && nvme_mem_req_copy(req, data, len, false) != 0) {
+			nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC,
+						    SPDK_NVME_SC_DATA_TRANSFER_ERROR);
+		}
+		break;
+	case SPDK_NVME_OPC_COMPARE:
+		if (data == NULL) {
+			break;
+		}
+		if (nvme_mem_req_compare(req, data, len, &equal) != 0) {
+			nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC,
+						    SPDK_NVME_SC_DATA_TRANSFER_ERROR);
+		} else if (!equal) {
+			nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_MEDIA_ERROR,
+						    SPDK_NVME_SC_COMPARE_FAILURE);
+		}
+		break;
+	case SPDK_NVME_OPC_WRITE_ZEROES:
+		if (data != NULL) {
+			memset(data, 0, (num_blocks * mctrlr->opts.block_size));
+		}
+		break;
+	case SPDK_NVME_OPC_FLUSH:
+	case SPDK_NVME_OPC_DATASET_MANAGEMENT:
+		/* Nothing is cached and deallocated blocks may keep their contents. */
+		break;
+	default:
+		nvme_mem_tracker_set_status(tr, SPDK_NVME_SCT_GENERIC, SPDK_NVME_SC_INVALID_OPCODE);
+		break;
+	}
+
+out:
+	if (mctrlr->latency_ticks != 0 || mctrlr->bytes_per_sec != 0) {
+		now = spdk_get_ticks();
+		if (mctrlr->bytes_per_sec != 0 && len != 0) {
+			now = nvme_mem_ctrlr_media_xfer(mctrlr, now, len);
+		}
+		tr->ready_tsc = now + mctrlr->latency_ticks;
+	}
+
+	TAILQ_INSERT_TAIL(&mqpair->executing_tr, tr, ctrlr_list);
+}
+
+/*
+ * The emulated controller's side of the queue pair: fetch the commands the
+ * host submitted, execute them and post the completions that are due.
+ */
+static void
+nvme_mem_ctrlr_process_qpair(struct nvme_mem_qpair *mqpair)
+{
+	struct nvme_mem_ctrlr *mctrlr = nvme_mem_ctrlr(mqpair->qpair.ctrlr);
+	struct nvme_mem_tracker *tr;
+	struct spdk_nvme_cmd *cmd;
+	struct spdk_nvme_cpl *cpl;
+	uint64_t now = 0;
+
+	while (mqpair->sq_head != mqpair->sq_tail) {
+		cmd = &mqpair->cmd[mqpair->sq_head];
+		tr = &mqpair->tr[cmd->cid];
+		assert(tr->req != NULL);
+
+		tr->ready_tsc = 0;
+		tr->cdw0 = 0;
+		tr->status.sct = SPDK_NVME_SCT_GENERIC;
+		tr->status.sc = SPDK_NVME_SC_SUCCESS;
+
+		if (nvme_qpair_is_admin_queue(&mqpair->qpair)) {
+			nvme_mem_ctrlr_admin_cmd(mctrlr, mqpair, cmd, tr);
+		} else {
+			nvme_mem_ctrlr_io_cmd(mctrlr, mqpair, cmd, tr);
+		}
+
+		if (++mqpair->sq_head == mqpair->num_entries) {
+			mqpair->sq_head = 0;
+		}
+	}
+
+	while ((tr = TAILQ_FIRST(&mqpair->executing_tr)) != NULL) {
+		if (tr->ready_tsc != 0) {
+			if (now == 0) {
+				now = spdk_get_ticks();
+			}
+			if (tr->ready_tsc > now) {
+				break;
+			}
+		}
+
+		TAILQ_REMOVE(&mqpair->executing_tr, tr, ctrlr_list);
+
+		cpl = &mqpair->cpl[mqpair->cq_tail];
+		cpl->cdw0 = tr->cdw0;
+		cpl->sqhd = mqpair->sq_head;
+		cpl->sqid = mqpair->qpair.id;
+		cpl->cid = tr->cid;
+		cpl->status = tr->status;
+		cpl->status.p = mqpair->ctrlr_phase;
+
+		if (++mqpair->cq_tail == mqpair->num_entries) {
+			mqpair->cq_tail = 0;
+			mqpair->ctrlr_phase = !mqpair->ctrlr_phase;
+		}
+	}
+}
+
+static void
+nvme_mem_qpair_complete_tracker(struct nvme_mem_qpair *mqpair, struct nvme_mem_tracker *tr,
+				struct spdk_nvme_cpl *cpl, bool print_on_error)
+{
+	struct spdk_nvme_qpair *qpair = &mqpair->qpair;
+	struct nvme_request *req = tr->req;
+
+	assert(req != NULL);
+
+	if (spdk_nvme_cpl_is_error(cpl) && print_on_error &&
+	    !qpair->ctrlr->opts.disable_error_logging) {
+		spdk_nvme_qpair_print_command(qpair, &req->cmd);
+		spdk_nvme_qpair_print_completion(qpair, cpl);
+	}
+
+	TAILQ_REMOVE(&mqpair->outstanding_tr, tr, tq_list);
+	tr->req = NULL;
+	TAILQ_INSERT_HEAD(&mqpair->free_tr, tr, tq_list);
+
+	nvme_complete_request(req->cb_fn, req->cb_arg, qpair, req, cpl);
+	nvme_qpair_free_request(qpair, req);
+}
+
+static void
+nvme_mem_qpair_manual_complete_tracker(struct nvme_mem_qpair *mqpair, struct nvme_mem_tracker *tr,
+				       uint32_t sct, uint32_t sc, uint32_t dnr, bool print_on_error)
+{
+	struct spdk_nvme_cpl cpl;
+
+	memset(&cpl, 0, sizeof(cpl));
+	cpl.sqid = mqpair->qpair.id;
+	cpl.cid = tr->cid;
+	cpl.status.sct = sct;
+	cpl.status.sc = sc;
+	cpl.status.dnr = dnr;
+	nvme_mem_qpair_complete_tracker(mqpair, tr, &cpl, print_on_error);
+}
+
+static int
+nvme_mem_qpair_reset(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_mem_qpair *mqpair = nvme_mem_qpair(qpair);
+	uint16_t i;
+
+	mqpair->sq_tail = mqpair->sq_head = 0;
+	mqpair->cq_head = mqpair->cq_tail = 0;
+	mqpair->phase = 1;
+	mqpair->ctrlr_phase = 1;
+	for (i = 0; i < mqpair->num_entries; i++) {
+		mqpair->cpl[i].status.p = 0;
+	}
+
+	return 0;
+}
+
+static void
+nvme_mem_qpair_abort_reqs(struct spdk_nvme_qpair *qpair, uint32_t dnr)
+{
+	struct nvme_mem_qpair *mqpair = nvme_mem_qpair(qpair);
+	struct nvme_mem_tracker *tr;
+
+	/* The controller drops everything it was working on, like on queue deletion. */
+	TAILQ_INIT(&mqpair->executing_tr);
+	TAILQ_INIT(&mqpair->aer_tr);
+	nvme_mem_qpair_reset(qpair);
+
+	while ((tr = TAILQ_FIRST(&mqpair->outstanding_tr)) != NULL) {
+		if (!qpair->ctrlr->opts.disable_error_logging) {
+			SPDK_ERRLOG("aborting outstanding command\n");
+		}
+		nvme_mem_qpair_manual_complete_tracker(mqpair, tr, SPDK_NVME_SCT_GENERIC,
+						       SPDK_NVME_SC_ABORTED_BY_REQUEST, dnr, true);
+	}
+}
+
+static void
+nvme_mem_admin_qpair_abort_aers(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_mem_qpair *mqpair = nvme_mem_qpair(qpair);
+	struct nvme_mem_tracker *tr;
+
+	while ((tr = TAILQ_FIRST(&mqpair->aer_tr)) != NULL) {
+		TAILQ_REMOVE(&mqpair->aer_tr, tr, ctrlr_list);
+		nvme_mem_qpair_manual_complete_tracker(mqpair, tr, SPDK_NVME_SCT_GENERIC,
+						       SPDK_NVME_SC_ABORTED_SQ_DELETION, 0, false);
+	}
+}
+
+static int
+nvme_mem_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
+{
+	struct nvme_mem_qpair *mqpair = nvme_mem_qpair(qpair);
+	struct nvme_mem_tracker *tr;
+	struct spdk_nvme_ctrlr *ctrlr = qpair->ctrlr;
+	int rc = 0;
+
+	if (spdk_unlikely(nvme_qpair_is_admin_queue(qpair))) {
+		nvme_robust_mutex_lock(&ctrlr->ctrlr_lock);
+	}
+
+	tr = TAILQ_FIRST(&mqpair->free_tr);
+	if (tr == NULL) {
+		/* Inform the upper layer to try again later. */
+		rc = -EAGAIN;
+		goto exit;
+	}
+
+	TAILQ_REMOVE(&mqpair->free_tr, tr, tq_list);
+	TAILQ_INSERT_TAIL(&mqpair->outstanding_tr, tr, tq_list);
+	tr->req = req;
+	req->cmd.cid = tr->cid;
+
+	mqpair->cmd[mqpair->sq_tail] = req->cmd;
+	if (++mqpair->sq_tail == mqpair->num_entries) {
+		mqpair->sq_tail = 0;
+	}
+
+exit:
+	if (spdk_unlikely(nvme_qpair_is_admin_queue(qpair))) {
+		nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
+	}
+
+	return rc;
+}
+
+static int32_t
+nvme_mem_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_completions)
+{
+	struct nvme_mem_qpair *mqpair = nvme_mem_qpair(qpair);
+	struct spdk_nvme_ctrlr *ctrlr = qpair->ctrlr;
+	struct nvme_mem_tracker *tr;
+	struct spdk_nvme_cpl *cpl;
+	uint32_t num_completions = 0;
+
+	if (spdk_unlikely(nvme_qpair_is_admin_queue(qpair))) {
+		nvme_robust_mutex_lock(&ctrlr->ctrlr_lock);
+	}
+
+	if (max_completions == 0 || max_completions > mqpair->num_entries - 1u) {
+		max_completions = mqpair->num_entries - 1u;
+	}
+
+	nvme_mem_ctrlr_process_qpair(mqpair);
+
+	while (num_completions < max_completions) {
+		cpl = &mqpair->cpl[mqpair->cq_head];
+		if (cpl->status.p != mqpair->phase) {
+			break;
+		}
+
+		if (++mqpair->cq_head == mqpair->num_entries) {
+			mqpair->cq_head = 0;
+			mqpair->phase = !mqpair->phase;
+		}
+
+		tr = &mqpair->tr[cpl->cid];
+		assert(tr->req != NULL);
+		nvme_mem_qpair_complete_tracker(mqpair, tr, cpl, true);
+		num_completions++;
+	}
+
+	if (spdk_unlikely(nvme_qpair_is_admin_queue(qpair))) {
+		nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
+	}
+
+	return num_completions;
+}
+
+static int
+nvme_mem_qpair_iterate_requests(struct spdk_nvme_qpair *qpair,
+				int (*iter_fn)(struct nvme_request *req, void *arg),
+				void *arg)
+{
+	struct nvme_mem_qpair *mqpair = nvme_mem_qpair(qpair);
+	struct nvme_mem_tracker *tr, *tmp;
+	int rc;
+
+	assert(iter_fn != NULL);
+
+	TAILQ_FOREACH_SAFE(tr, &mqpair->outstanding_tr, tq_list, tmp) {
+		assert(tr->req != NULL);
+
+		rc = iter_fn(tr->req, arg);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+static struct spdk_nvme_qpair *
+nvme_mem_ctrlr_create_qpair(struct spdk_nvme_ctrlr *ctrlr, uint16_t qid, uint32_t qsize,
+			    enum spdk_nvme_qprio qprio, uint32_t num_requests)
+{
+	struct nvme_mem_qpair *mqpair;
+	struct spdk_nvme_qpair *qpair;
+	uint16_t i;
+	int rc;
+
+	mqpair = calloc(1, sizeof(*mqpair));
+	if (mqpair == NULL) {
+		SPDK_ERRLOG("failed to allocate mqpair\n");
+		return NULL;
+	}
+
+	mqpair->num_entries = qsize;
+	TAILQ_INIT(&mqpair->free_tr);
+	TAILQ_INIT(&mqpair->outstanding_tr);
+	TAILQ_INIT(&mqpair->executing_tr);
+	TAILQ_INIT(&mqpair->aer_tr);
+
+	mqpair->cmd = calloc(qsize, sizeof(*mqpair->cmd));
+	mqpair->cpl = calloc(qsize, sizeof(*mqpair->cpl));
+	/* One entry is left empty to tell a full queue from an empty one. */
+	mqpair->tr = calloc(qsize - 1, sizeof(*mqpair->tr));
+	if (mqpair->cmd == NULL || mqpair->cpl == NULL || mqpair->tr == NULL) {
+		SPDK_ERRLOG("failed to allocate queues of qpair %u\n", qid);
+		goto err;
+	}
+
+	qpair = &mqpair->qpair;
+	rc = nvme_qpair_init(qpair, qid, ctrlr, qprio, num_requests);
+	if (rc != 0) {
+		goto err;
+	}
+
+	for (i = 0; i < qsize - 1; i++) {
+		mqpair->tr[i].cid = i;
+		TAILQ_INSERT_TAIL(&mqpair->free_tr, &mqpair->tr[i], tq_list);
+	}
+
+	nvme_mem_qpair_reset(qpair);
+
+	return qpair;
+
+err:
+	free(mqpair->tr);
+	free(mqpair->cpl);
+	free(mqpair->cmd);
+	free(mqpair);
+	return NULL;
+}
+
+static struct spdk_nvme_qpair *
+nvme_mem_ctrlr_create_io_qpair(struct spdk_nvme_ctrlr *ctrlr, uint16_t qid,
+			       const struct spdk_nvme_io_qpair_opts *opts)
+{
+	return nvme_mem_ctrlr_create_qpair(ctrlr, qid, opts->io_queue_size, opts->qprio,
+					   opts->io_queue_requests);
+}
+
+static int
+nvme_mem_ctrlr_delete_io_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_mem_qpair *mqpair;
+
+	if (!qpair) {
+		return -1;
+	}
+
+	mqpair = nvme_mem_qpair(qpair);
+	nvme_mem_qpair_abort_reqs(qpair, 1);
+	nvme_qpair_deinit(qpair);
+
+	free(mqpair->tr);
+	free(mqpair->cpl);
+	free(mqpair->cmd);
+	free(mqpair);
+
+	return 0;
+}
+
+static int
+nvme_mem_ctrlr_connect_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_mem_ctrlr *mctrlr = nvme_mem_ctrlr(ctrlr);
+
+	if (!nvme_qpair_is_admin_queue(qpair) && qpair->id > mctrlr->num_io_queues) {
+		SPDK_ERRLOG("qpair %u exceeds the %u granted I/O queues\n", qpair->id,
+			    mctrlr->num_io_queues);
+		return -EINVAL;
+	}
+
+	return nvme_mem_qpair_reset(qpair);
+}
+
+static void
+nvme_mem_ctrlr_disconnect_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair)
+{
+}
+
+static int
+nvme_mem_ctrlr_set_reg_4(struct spdk_nvme_ctrlr *ctrlr, uint32_t offset, uint32_t value)
+{
+	struct nvme_mem_ctrlr *mctrlr = nvme_mem_ctrlr(ctrlr);
+	union spdk_nvme_cc_register cc;
+
+	if (offset + sizeof(value) > sizeof(mctrlr->regs)) {
+		return -EINVAL;
+	}
+
+	if (offset == offsetof(struct spdk_nvme_registers, cc.raw)) {
+		cc.raw = value;
+		/* Enabling, disabling and shutting down all take effect immediately. */
+		mctrlr->regs.csts.bits.rdy = cc.bits.en;
+		if (cc.bits.shn != 0) {
+			mctrlr->regs.csts.bits.shst = SPDK_NVME_SHST_COMPLETE;
+		} else if (cc.bits.en) {
+			mctrlr->regs.csts.bits.shst = SPDK_NVME_SHST_NORMAL;
+		}
+	}
+
+	memcpy((uint8_t *)&mctrlr->regs + offset, &value, sizeof(value));
+
+	return 0;
+}
+
+static int
+nvme_mem_ctrlr_set_reg_8(struct spdk_nvme_ctrlr *ctrlr, uint32_t offset, uint64_t value)
+{
+	struct nvme_mem_ctrlr *mctrlr = nvme_mem_ctrlr(ctrlr);
+
+	if (offset + sizeof(value) > sizeof(mctrlr->regs)) {
+		return -EINVAL;
+	}
+
+	memcpy((uint8_t *)&mctrlr->regs + offset, &value, sizeof(value));
+
+	return 0;
+}
+
+static int
+nvme_mem_ctrlr_get_reg_4(struct spdk_nvme_ctrlr *ctrlr, uint32_t offset, uint32_t *value)
+{
+	struct nvme_mem_ctrlr *mctrlr = nvme_mem_ctrlr(ctrlr);
+
+	if (offset + sizeof(*value) > sizeof(mctrlr->regs)) {
+		return -EINVAL;
+	}
+
+	memcpy(value, (uint8_t *)&mctrlr->regs + offset, sizeof(*value));
+
+	return 0;
+}
+
+static int
+nvme_mem_ctrlr_get_reg_8(struct spdk_nvme_ctrlr *ctrlr, uint32_t offset, uint64_t *value)
+{
+	struct nvme_mem_ctrlr *mctrlr = nvme_mem_ctrlr(ctrlr);
+
+	if (offset + sizeof(*value) > sizeof(mctrlr->regs)) {
+		return -EINVAL;
+	}
+
+	memcpy(value, (uint8_t *)&mctrlr->regs + offset, sizeof(*value));
+
+	return 0;
+}
+
+static uint32_t
+nvme_mem_ctrlr_get_max_xfer_size(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return nvme_mem_ctrlr(ctrlr)->opts.max_xfer_size;
+}
+
+static uint16_t
+nvme_mem_ctrlr_get_max_sges(struct spdk_nvme_ctrlr *ctrlr)
+{
+	/* Data is copied by virtual address, there is no descriptor limit. */
+	return UINT16_MAX;
+}
+
+static int
+nvme_mem_ctrlr_enable(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return 0;
+}
+
+static int
+nvme_mem_ctrlr_destruct(struct spdk_nvme_ctrlr *ctrlr)
+{
+	struct nvme_mem_ctrlr *mctrlr = nvme_mem_ctrlr(ctrlr);
+
+	if (ctrlr->adminq) {
+		nvme_mem_ctrlr_delete_io_qpair(ctrlr, ctrlr->adminq);
+	}
+
+	nvme_ctrlr_destruct_finish(ctrlr);
+
+	free(mctrlr->data);
+	free(mctrlr);
+
+	return 0;
+}
+
+static struct spdk_nvme_ctrlr *
+nvme_mem_ctrlr_construct(const struct spdk_nvme_transport_id *trid,
+			 const struct spdk_nvme_ctrlr_opts *opts,
+			 void *devhandle)
+{
+	struct nvme_mem_ctrlr *mctrlr;
+	union spdk_nvme_cap_register cap;
+	union spdk_nvme_vs_register vs;
+	int rc;
+
+	mctrlr = calloc(1, sizeof(*mctrlr));
+	if (mctrlr == NULL) {
+		SPDK_ERRLOG("could not allocate ctrlr\n");
+		return NULL;
+	}
+
+	if (nvme_mem_parse_opts(trid->traddr, &mctrlr->opts) != 0) {
+		free(mctrlr);
+		return NULL;
+	}
+
+	if (mctrlr->opts.store_data) {
+		mctrlr->data = calloc(mctrlr->opts.num_blocks, mctrlr->opts.block_size);
+		if (mctrlr->data == NULL) {
+			SPDK_ERRLOG("could not allocate %" PRIu64 " blocks of namespace data\n",
+				    mctrlr->opts.num_blocks);
+			free(mctrlr);
+			return NULL;
+		}
+	}
+
+	mctrlr->ticks_hz = spdk_get_ticks_hz();
+	mctrlr->latency_ticks = mctrlr->opts.latency_us * mctrlr->ticks_hz / SPDK_SEC_TO_USEC;
+	mctrlr->bytes_per_sec = (uint64_t)mctrlr->opts.mb_per_sec * 1000 * 1000;
+
+	mctrlr->ctrlr.opts = *opts;
+	mctrlr->ctrlr.trid = *trid;
+	nvme_mem_ctrlr_init_data(mctrlr);
+	mctrlr->ctrlr.cntlid = mctrlr->cdata.cntlid;
+
+	rc = nvme_ctrlr_construct(&mctrlr->ctrlr);
+	if (rc != 0) {
+		free(mctrlr->data);
+		free(mctrlr);
+		return NULL;
+	}
+
+	mctrlr->ctrlr.adminq = nvme_mem_ctrlr_create_qpair(&mctrlr->ctrlr, 0,
+			       mctrlr->ctrlr.opts.admin_queue_size, 0,
+			       mctrlr->ctrlr.opts.admin_queue_size);
+	if (!mctrlr->ctrlr.adminq) {
+		SPDK_ERRLOG("failed to create admin qpair\n");
+		nvme_mem_ctrlr_destruct(&mctrlr->ctrlr);
+		return NULL;
+	}
+
+	rc = nvme_transport_ctrlr_connect_qpair(&mctrlr->ctrlr, mctrlr->ctrlr.adminq);
+	if (rc < 0) {
+		SPDK_ERRLOG("failed to connect admin qpair\n");
+		nvme_mem_ctrlr_destruct(&mctrlr->ctrlr);
+		return NULL;
+	}
+
+	if (nvme_ctrlr_get_cap(&mctrlr->ctrlr, &cap)) {
+		SPDK_ERRLOG("get_cap() failed\n");
+		nvme_ctrlr_destruct(&mctrlr->ctrlr);
+		return NULL;
+	}
+
+	if (nvme_ctrlr_get_vs(&mctrlr->ctrlr, &vs)) {
+		SPDK_ERRLOG("get_vs() failed\n");
+		nvme_ctrlr_destruct(&mctrlr->ctrlr);
+		return NULL;
+	}
+
+	if (nvme_ctrlr_add_process(&mctrlr->ctrlr, 0) != 0) {
+		SPDK_ERRLOG("nvme_ctrlr_add_process() failed\n");
+		nvme_ctrlr_destruct(&mctrlr->ctrlr);
+		return NULL;
+	}
+
+	nvme_ctrlr_init_cap(&mctrlr->ctrlr, &cap, &vs);
+
+	return &mctrlr->ctrlr;
+}
+
+static int
+nvme_mem_ctrlr_scan(struct spdk_nvme_probe_ctx *probe_ctx, bool direct_connect)
+{
+	/* There is nothing to discover, every address names a controller of its own. */
+	return nvme_ctrlr_probe(&probe_ctx->trid, probe_ctx, NULL);
+}
+
+static struct spdk_nvme_transport_poll_group *
+nvme_mem_poll_group_create(void)
+{
+	struct nvme_mem_poll_group *group = calloc(1, sizeof(*group));
+
+	if (group == NULL) {
+		SPDK_ERRLOG("Unable to allocate poll group.\n");
+		return NULL;
+	}
+
+	return &group->group;
+}
+
+static int
+nvme_mem_poll_group_connect_qpair(struct spdk_nvme_qpair *qpair)
+{
+	return 0;
+}
+
+static int
+nvme_mem_poll_group_disconnect_qpair(struct spdk_nvme_qpair *qpair)
+{
+	return 0;
+}
+
+static int
+nvme_mem_poll_group_add(struct spdk_nvme_transport_poll_group *tgroup,
+			struct spdk_nvme_qpair *qpair)
+{
+	return 0;
+}
+
+static int
+nvme_mem_poll_group_remove(struct spdk_nvme_transport_poll_group *tgroup,
+			   struct spdk_nvme_qpair *qpair)
+{
+	return 0;
+}
+
+static int64_t
+nvme_mem_poll_group_process_completions(struct spdk_nvme_transport_poll_group *tgroup,
+					uint32_t completions_per_qpair, spdk_nvme_disconnected_qpair_cb disconnected_qpair_cb)
+{
+	struct spdk_nvme_qpair *qpair, *tmp_qpair;
+	int32_t local_completions = 0;
+	int64_t total_completions = 0;
+
+	STAILQ_FOREACH_SAFE(qpair, &tgroup->disconnected_qpairs, poll_group_stailq, tmp_qpair) {
+		disconnected_qpair_cb(qpair, tgroup->group->ctx);
+	}
+
+	STAILQ_FOREACH_SAFE(qpair, &tgroup->connected_qpairs, poll_group_stailq, tmp_qpair) {
+		local_completions = spdk_nvme_qpair_process_completions(qpair, completions_per_qpair);
+		if (local_completions < 0) {
+			disconnected_qpair_cb(qpair, tgroup->group->ctx);
+			local_completions = 0;
+		}
+		total_completions += local_completions;
+	}
+
+	return total_completions;
+}
+
+static int
+nvme_mem_poll_group_destroy(struct spdk_nvme_transport_poll_group *tgroup)
+{
+	if (!STAILQ_EMPTY(&tgroup->connected_qpairs) || !STAILQ_EMPTY(&tgroup->disconnected_qpairs)) {
+		return -EBUSY;
+	}
+
+	free(tgroup);
+
+	return 0;
+}
+
+const struct spdk_nvme_transport_ops mem_ops = {
+	.name = SPDK_NVME_TRANSPORT_NAME_MEMORY,
+	.type = SPDK_NVME_TRANSPORT_CUSTOM,
+	.ctrlr_construct = nvme_mem_ctrlr_construct,
+	.ctrlr_scan = nvme_mem_ctrlr_scan,
+	.ctrlr_destruct = nvme_mem_ctrlr_destruct,
+	.ctrlr_enable = nvme_mem_ctrlr_enable,
+
+	.ctrlr_set_reg_4 = nvme_mem_ctrlr_set_reg_4,
+	.ctrlr_set_reg_8 = nvme_mem_ctrlr_set_reg_8,
+	.ctrlr_get_reg_4 = nvme_mem_ctrlr_get_reg_4,
+	.ctrlr_get_reg_8 = nvme_mem_ctrlr_get_reg_8,
+
+	.ctrlr_get_max_xfer_size = nvme_mem_ctrlr_get_max_xfer_size,
+	.ctrlr_get_max_sges = nvme_mem_ctrlr_get_max_sges,
+
+	.ctrlr_create_io_qpair = nvme_mem_ctrlr_create_io_qpair,
+	.ctrlr_delete_io_qpair = nvme_mem_ctrlr_delete_io_qpair,
+	.ctrlr_connect_qpair = nvme_mem_ctrlr_connect_qpair,
+	.ctrlr_disconnect_qpair = nvme_mem_ctrlr_disconnect_qpair,
+
+	.qpair_abort_reqs = nvme_mem_qpair_abort_reqs,
+	.qpair_reset = nvme_mem_qpair_reset,
+	.qpair_submit_request = nvme_mem_qpair_submit_request,
+	.qpair_process_completions = nvme_mem_qpair_process_completions,
+	.qpair_iterate_requests = nvme_mem_qpair_iterate_requests,
+	.admin_qpair_abort_aers = nvme_mem_admin_qpair_abort_aers,
+
+	.poll_group_create = nvme_mem_poll_group_create,
+	.poll_group_connect_qpair = nvme_mem_poll_group_connect_qpair,
+	.poll_group_disconnect_qpair = nvme_mem_poll_group_disconnect_qpair,
+	.poll_group_add = nvme_mem_poll_group_add,
+	.poll_group_remove = nvme_mem_poll_group_remove,
+	.poll_group_process_completions = nvme_mem_poll_group_process_completions,
+	.poll_group_destroy = nvme_mem_poll_group_destroy,
+};
+
+SPDK_NVME_TRANSPORT_REGISTER(memory, &mem_ops);
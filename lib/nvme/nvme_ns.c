@@ -124,7 +124,7 @@ nvme_ctrlr_identify_ns(struct spdk_nvme_ns *ns)
 	}
 
 	nsdata = _nvme_ns_get_data(ns);
-	rc = nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS, 0, ns->id,
+	rc = nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS, 0, ns->id, 0,
 				     nsdata, sizeof(*nsdata),
 				     nvme_completion_poll_cb, status);
 	if (rc != 0) {
@@ -149,6 +149,75 @@ nvme_ctrlr_identify_ns(struct spdk_nvme_ns *ns)
 	return 0;
 }
 
+int
+nvme_ns_alloc_zns_specific_data(struct spdk_nvme_ns *ns)
+{
+	if (ns->nsdata_zns != NULL) {
+		return 0;
+	}
+
+	ns->nsdata_zns = spdk_zmalloc(sizeof(*ns->nsdata_zns), 64, NULL, SPDK_ENV_SOCKET_ID_ANY,
+				      SPDK_MALLOC_SHARE | SPDK_MALLOC_DMA);
+	if (ns->nsdata_zns == NULL) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+void
+nvme_ns_free_zns_specific_data(struct spdk_nvme_ns *ns)
+{
+	spdk_free(ns->nsdata_zns);
+	ns->nsdata_zns = NULL;
+}
+
+static int
+nvme_ctrlr_identify_ns_zns_specific(struct spdk_nvme_ns *ns)
+{
+	struct nvme_completion_poll_status	*status;
+	int					rc;
+
+	assert(ns->csi == SPDK_NVME_CSI_ZNS);
+
+	rc = nvme_ns_alloc_zns_specific_data(ns);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to allocate zoned namespace data\n");
+		return rc;
+	}
+
+	status = calloc(1, sizeof(*status));
+	if (!status) {
+		SPDK_ERRLOG("Failed to allocate status tracker\n");
+		nvme_ns_free_zns_specific_data(ns);
+		return -ENOMEM;
+	}
+
+	rc = nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS_IOCS, 0, ns->id,
+				     SPDK_NVME_CSI_ZNS, ns->nsdata_zns, sizeof(*ns->nsdata_zns),
+				     nvme_completion_poll_cb, status);
+	if (rc != 0) {
+		nvme_ns_free_zns_specific_data(ns);
+		free(status);
+		return rc;
+	}
+
+	rc = nvme_wait_for_completion_robust_lock(ns->ctrlr->adminq, status,
+			&ns->ctrlr->ctrlr_lock);
+	if (rc != 0) {
+		/* Not fatal, the namespace is only left without its zone geometry. */
+		SPDK_WARNLOG("Failed to retrieve zoned namespace data of NS %u\n", ns->id);
+		nvme_ns_free_zns_specific_data(ns);
+		rc = 0;
+	}
+
+	if (!status->timed_out) {
+		free(status);
+	}
+
+	return rc;
+}
+
 static int
 nvme_ctrlr_identify_id_desc(struct spdk_nvme_ns *ns)
 {
@@ -160,6 +229,7 @@ nvme_ctrlr_identify_id_desc(struct spdk_nvme_ns *ns)
 	if (ns->ctrlr->vs.raw < SPDK_NVME_VERSION(1, 3, 0) ||
 	    (ns->ctrlr->quirks & NVME_QUIRK_IDENTIFY_CNS)) {
 		SPDK_DEBUGLOG(SPDK_LOG_NVME, "Version < 1.3; not attempting to retrieve NS ID Descriptor List\n");
+		nvme_ns_set_id_desc_list_data(ns);
 		return 0;
 	}
 
@@ -171,7 +241,7 @@ nvme_ctrlr_identify_id_desc(struct spdk_nvme_ns *ns)
 
 	SPDK_DEBUGLOG(SPDK_LOG_NVME, "Attempting to retrieve NS ID Descriptor List\n");
 	rc = nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS_ID_DESCRIPTOR_LIST, 0, ns->id,
-				     ns->id_desc_list, sizeof(ns->id_desc_list),
+				     0, ns->id_desc_list, sizeof(ns->id_desc_list),
 				     nvme_completion_poll_cb, status);
 	if (rc < 0) {
 		free(status);
@@ -184,6 +254,8 @@ nvme_ctrlr_identify_id_desc(struct spdk_nvme_ns *ns)
 		memset(ns->id_desc_list, 0, sizeof(ns->id_desc_list));
 	}
 
+	nvme_ns_set_id_desc_list_data(ns);
+
 	if (!status->timed_out) {
 		free(status);
 	}
@@ -358,6 +430,30 @@ spdk_nvme_ns_get_uuid(const struct spdk_nvme_ns *ns)
 	return uuid;
 }
 
+void
+nvme_ns_set_id_desc_list_data(struct spdk_nvme_ns *ns)
+{
+	const uint8_t *csi;
+	size_t csi_size;
+
+	csi = nvme_ns_find_id_desc(ns, SPDK_NVME_NIDT_CSI, &csi_size);
+	if (csi == NULL || csi_size != sizeof(*csi)) {
+		/* Controllers that predate command sets only have NVM namespaces */
+		ns->csi = SPDK_NVME_CSI_NVM;
+	} else {
+		ns->csi = (enum spdk_nvme_csi)*csi;
+	}
+
+	if (ns->csi != SPDK_NVME_CSI_ZNS) {
+		nvme_ns_free_zns_specific_data(ns);
+	}
+}
+
+enum spdk_nvme_csi
+spdk_nvme_ns_get_csi(const struct spdk_nvme_ns *ns) {
+	return ns->csi;
+}
+
 int nvme_ns_construct(struct spdk_nvme_ns *ns, uint32_t id,
 		      struct spdk_nvme_ctrlr *ctrlr)
 {
@@ -373,7 +469,16 @@ int nvme_ns_construct(struct spdk_nvme_ns *ns, uint32_t id,
 		return rc;
 	}
 
-	return nvme_ctrlr_identify_id_desc(ns);
+	rc = nvme_ctrlr_identify_id_desc(ns);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (ns->csi == SPDK_NVME_CSI_ZNS) {
+		return nvme_ctrlr_identify_ns_zns_specific(ns);
+	}
+
+	return 0;
 }
 
 void nvme_ns_destruct(struct spdk_nvme_ns *ns)
@@ -393,9 +498,22 @@ void nvme_ns_destruct(struct spdk_nvme_ns *ns)
 	ns->sectors_per_max_io = 0;
 	ns->sectors_per_stripe = 0;
 	ns->flags = 0;
+	ns->csi = SPDK_NVME_CSI_NVM;
+	nvme_ns_free_zns_specific_data(ns);
 }
 
 int nvme_ns_update(struct spdk_nvme_ns *ns)
 {
-	return nvme_ctrlr_identify_ns(ns);
+	int rc;
+
+	rc = nvme_ctrlr_identify_ns(ns);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (ns->csi == SPDK_NVME_CSI_ZNS) {
+		return nvme_ctrlr_identify_ns_zns_specific(ns);
+	}
+
+	return 0;
 }
@@ -42,24 +42,15 @@ static inline struct nvme_request *_nvme_ns_cmd_rw(struct spdk_nvme_ns *ns,
 
 
 static bool
-nvme_ns_check_request_length(uint32_t lba_count, uint32_t sectors_per_max_io,
-			     uint32_t sectors_per_stripe, uint32_t qdepth)
+nvme_ns_check_request_length(struct spdk_nvme_ns *ns)
 {
-	uint32_t child_per_io = UINT32_MAX;
-
 	/* After a namespace is destroyed(e.g. hotplug), all the fields associated with the
 	 * namespace will be cleared to zero, the function will return TRUE for this case,
-	 * and -EINVAL will be returned to caller.
+	 * and -EINVAL will be returned to caller.  Requests that need more children than
+	 * the qpair has requests are not rejected, the children that do not fit are built
+	 * as earlier ones complete.
 	 */
-	if (sectors_per_stripe > 0) {
-		child_per_io = (lba_count + sectors_per_stripe - 1) / sectors_per_stripe;
-	} else if (sectors_per_max_io > 0) {
-		child_per_io = (lba_count + sectors_per_max_io - 1) / sectors_per_max_io;
-	}
-
-	SPDK_DEBUGLOG(SPDK_LOG_NVME, "checking maximum i/o length %d\n", child_per_io);
-
-	return child_per_io >= qdepth;
+	return ns->sectors_per_max_io == 0 && ns->sectors_per_stripe == 0;
 }
 
 static struct nvme_request *
@@ -84,21 +75,51 @@ _nvme_add_child_request(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 	return child;
 }
 
+static struct nvme_request *
+_nvme_ns_cmd_split_add_child(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
+{
+	struct spdk_nvme_ns	*ns = req->split.ns;
+	struct nvme_request	*child;
+	uint32_t		lba_count;
+
+	lba_count = req->split.sectors_per_io - (req->split.lba & req->split.sector_mask);
+	lba_count = spdk_min(req->split.lba_count, lba_count);
+
+	child = _nvme_ns_cmd_rw(ns, qpair, &req->payload, req->split.payload_offset,
+				req->split.md_offset, req->split.lba, lba_count, NULL, NULL,
+				req->split.opc, req->split.io_flags, req->split.apptag_mask,
+				req->split.apptag, true);
+	if (child == NULL) {
+		return NULL;
+	}
+
+	nvme_request_add_child(req, child);
+
+	req->split.lba_count -= lba_count;
+	req->split.lba += lba_count;
+	req->split.payload_offset += lba_count * req->split.sector_size;
+	req->split.md_offset += lba_count * ns->md_size;
+
+	return child;
+}
+
 static struct nvme_request *
 _nvme_ns_cmd_split_request(struct spdk_nvme_ns *ns,
 			   struct spdk_nvme_qpair *qpair,
-			   const struct nvme_payload *payload,
 			   uint32_t payload_offset, uint32_t md_offset,
-			   uint64_t lba, uint32_t lba_count,
-			   spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t opc,
+			   uint64_t lba, uint32_t lba_count, uint32_t opc,
 			   uint32_t io_flags, struct nvme_request *req,
 			   uint32_t sectors_per_max_io, uint32_t sector_mask,
 			   uint16_t apptag_mask, uint16_t apptag)
 {
 	uint32_t		sector_size;
 	uint32_t		md_size = ns->md_size;
-	uint32_t		remaining_lba_count = lba_count;
-	struct nvme_request	*child;
+
+	if (sectors_per_max_io == 0) {
+		/* The namespace was destroyed, see nvme_ns_check_request_length(). */
+		nvme_free_request(req);
+		return NULL;
+	}
 
 	sector_size = ns->extended_lba_size;
 
@@ -109,26 +130,85 @@ _nvme_ns_cmd_split_request(struct spdk_nvme_ns *ns,
 		sector_size -= 8;
 	}
 
-	while (remaining_lba_count > 0) {
-		lba_count = sectors_per_max_io - (lba & sector_mask);
-		lba_count = spdk_min(remaining_lba_count, lba_count);
+	req->split.ns = ns;
+	req->split.lba = lba;
+	req->split.lba_count = lba_count;
+	req->split.payload_offset = payload_offset;
+	req->split.md_offset = md_offset;
+	req->split.sector_size = sector_size;
+	req->split.sectors_per_io = sectors_per_max_io;
+	req->split.sector_mask = sector_mask;
+	req->split.io_flags = io_flags;
+	req->split.apptag_mask = apptag_mask;
+	req->split.apptag = apptag;
+	req->split.opc = opc;
+
+	while (req->split.lba_count > 0) {
+		if (_nvme_ns_cmd_split_add_child(qpair, req) != NULL) {
+			continue;
+		}
 
-		child = _nvme_add_child_request(ns, qpair, payload, payload_offset, md_offset,
-						lba, lba_count, cb_fn, cb_arg, opc,
-						io_flags, apptag_mask, apptag, req, true);
-		if (child == NULL) {
+		if (req->num_children == 0) {
+			nvme_free_request(req);
 			return NULL;
 		}
 
-		remaining_lba_count -= lba_count;
-		lba += lba_count;
-		payload_offset += lba_count * sector_size;
-		md_offset += lba_count * md_size;
+		/*
+		 * The qpair ran out of requests.  Submit the children built so far, the
+		 *  qpair builds the rest as they complete, see nvme_ns_cmd_resume_split().
+		 */
+		req->split_pending = 1;
+		break;
 	}
 
 	return req;
 }
 
+bool
+nvme_ns_cmd_resume_split(struct nvme_request *req)
+{
+	struct spdk_nvme_qpair	*qpair = req->qpair;
+	struct nvme_request	*child;
+
+	assert(req->split_pending);
+
+	/* Stop building children once one of them has failed. */
+	while (req->split.lba_count > 0 && !spdk_nvme_cpl_is_error(&req->parent_status)) {
+		child = _nvme_ns_cmd_split_add_child(qpair, req);
+		if (child == NULL) {
+			if (req->num_children > 0 || STAILQ_EMPTY(&qpair->free_req)) {
+				/* Try again once more requests complete on this qpair. */
+				return false;
+			}
+
+			/*
+			 * None of the requests this one is waiting for are outstanding, so
+			 *  the child can't be built from what is free on the qpair.  Fail the
+			 *  request rather than wait for requests that may never complete.
+			 */
+			req->parent_status.status.sct = SPDK_NVME_SCT_GENERIC;
+			req->parent_status.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+			break;
+		}
+
+		if (nvme_qpair_submit_request(qpair, child) != 0) {
+			/* The child was already removed from the parent and freed. */
+			req->parent_status.status.sct = SPDK_NVME_SCT_GENERIC;
+			req->parent_status.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+			break;
+		}
+	}
+
+	req->split_pending = 0;
+
+	if (req->num_children == 0) {
+		nvme_complete_request(req->cb_fn, req->cb_arg, qpair, req, &req->parent_status);
+		nvme_free_request(req);
+	}
+
+	return true;
+}
+
 static inline bool
 _is_io_flags_valid(uint32_t io_flags)
 {
@@ -263,9 +343,17 @@ _nvme_ns_cmd_split_request_prp(struct spdk_nvme_ns *ns,
 			struct nvme_request *child;
 			uint32_t child_lba_count;
 
+			if (opc == SPDK_NVME_OPC_ZONE_APPEND) {
+				SPDK_ERRLOG("zone append payload is not PRP compatible\n");
+				nvme_free_request(req);
+				return NULL;
+			}
+
 			if ((child_length % ns->extended_lba_size) != 0) {
 				SPDK_ERRLOG("child_length %u not even multiple of lba_size %u\n",
 					    child_length, ns->extended_lba_size);
+				nvme_request_free_children(req);
+				nvme_free_request(req);
 				return NULL;
 			}
 			child_lba_count = child_length / ns->extended_lba_size;
@@ -346,9 +434,17 @@ _nvme_ns_cmd_split_request_sgl(struct spdk_nvme_ns *ns,
 			struct nvme_request *child;
 			uint32_t child_lba_count;
 
+			if (opc == SPDK_NVME_OPC_ZONE_APPEND) {
+				SPDK_ERRLOG("zone append payload exceeds %u SGEs\n", max_sges);
+				nvme_free_request(req);
+				return NULL;
+			}
+
 			if ((child_length % ns->extended_lba_size) != 0) {
 				SPDK_ERRLOG("child_length %u not even multiple of lba_size %u\n",
 					    child_length, ns->extended_lba_size);
+				nvme_request_free_children(req);
+				nvme_free_request(req);
 				return NULL;
 			}
 			child_lba_count = child_length / ns->extended_lba_size;
@@ -411,6 +507,15 @@ _nvme_ns_cmd_rw(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 	req->payload_offset = payload_offset;
 	req->md_offset = md_offset;
 
+	/*
+	 * A zone append picks its LBA when it is executed, so it cannot be split.
+	 *  Its size has already been checked against the controller's ZASL.
+	 */
+	if (opc == SPDK_NVME_OPC_ZONE_APPEND) {
+		sectors_per_stripe = 0;
+		sectors_per_max_io = UINT32_MAX;
+	}
+
 	/*
 	 * Intel DC P3*00 NVMe controllers benefit from driver-assisted striping.
 	 * If this controller defines a stripe boundary and this I/O spans a stripe
@@ -420,15 +525,14 @@ _nvme_ns_cmd_rw(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 	if (sectors_per_stripe > 0 &&
 	    (((lba & (sectors_per_stripe - 1)) + lba_count) > sectors_per_stripe)) {
 
-		return _nvme_ns_cmd_split_request(ns, qpair, payload, payload_offset, md_offset, lba, lba_count,
-						  cb_fn,
-						  cb_arg, opc,
-						  io_flags, req, sectors_per_stripe, sectors_per_stripe - 1, apptag_mask, apptag);
+		return _nvme_ns_cmd_split_request(ns, qpair, payload_offset, md_offset,
+						  lba, lba_count, opc, io_flags, req,
+						  sectors_per_stripe, sectors_per_stripe - 1,
+						  apptag_mask, apptag);
 	} else if (lba_count > sectors_per_max_io) {
-		return _nvme_ns_cmd_split_request(ns, qpair, payload, payload_offset, md_offset, lba, lba_count,
-						  cb_fn,
-						  cb_arg, opc,
-						  io_flags, req, sectors_per_max_io, 0, apptag_mask, apptag);
+		return _nvme_ns_cmd_split_request(ns, qpair, payload_offset, md_offset,
+						  lba, lba_count, opc, io_flags, req,
+						  sectors_per_max_io, 0, apptag_mask, apptag);
 	} else if (nvme_payload_type(&req->payload) == NVME_PAYLOAD_TYPE_SGL && check_sgl) {
 		if (ns->ctrlr->flags & SPDK_NVME_CTRLR_SGL_SUPPORTED) {
 			return _nvme_ns_cmd_split_request_sgl(ns, qpair, payload, payload_offset, md_offset,
@@ -466,10 +570,7 @@ spdk_nvme_ns_cmd_compare(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 			      0, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -499,10 +600,7 @@ spdk_nvme_ns_cmd_compare_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair
 			      apptag_mask, apptag, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -534,10 +632,7 @@ spdk_nvme_ns_cmd_comparev(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair
 			      io_flags, 0, 0, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -569,10 +664,7 @@ spdk_nvme_ns_cmd_comparev_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpai
 			      SPDK_NVME_OPC_COMPARE, io_flags, apptag_mask, apptag, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -599,10 +691,7 @@ spdk_nvme_ns_cmd_read(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair, vo
 			      0, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -630,10 +719,7 @@ spdk_nvme_ns_cmd_read_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *q
 			      apptag_mask, apptag, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -664,10 +750,7 @@ spdk_nvme_ns_cmd_readv(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 			      io_flags, 0, 0, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -699,10 +782,7 @@ spdk_nvme_ns_cmd_readv_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *
 			      io_flags, apptag_mask, apptag, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -728,10 +808,7 @@ spdk_nvme_ns_cmd_write(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 			      io_flags, 0, 0, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -757,10 +834,7 @@ spdk_nvme_ns_cmd_write_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *
 			      io_flags, apptag_mask, apptag, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -791,10 +865,7 @@ spdk_nvme_ns_cmd_writev(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 			      io_flags, 0, 0, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
@@ -826,10 +897,89 @@ spdk_nvme_ns_cmd_writev_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair
 			      io_flags, apptag_mask, apptag, true);
 	if (req != NULL) {
 		return nvme_qpair_submit_request(qpair, req);
-	} else if (nvme_ns_check_request_length(lba_count,
-						ns->sectors_per_max_io,
-						ns->sectors_per_stripe,
-						qpair->ctrlr->opts.io_queue_requests)) {
+	} else if (nvme_ns_check_request_length(ns)) {
+		return -EINVAL;
+	} else {
+		return -ENOMEM;
+	}
+}
+
+static bool
+nvme_ns_check_zone_append_length(struct spdk_nvme_ns *ns, uint32_t lba_count, uint32_t io_flags)
+{
+	uint32_t sector_size = ns->extended_lba_size;
+
+	if ((io_flags & SPDK_NVME_IO_FLAGS_PRACT) &&
+	    (ns->flags & SPDK_NVME_NS_EXTENDED_LBA_SUPPORTED) &&
+	    (ns->flags & SPDK_NVME_NS_DPS_PI_SUPPORTED) &&
+	    (ns->md_size == 8)) {
+		sector_size -= 8;
+	}
+
+	return lba_count != 0 &&
+	       (uint64_t)lba_count * sector_size <= ns->ctrlr->max_zone_append_size;
+}
+
+int
+nvme_ns_cmd_zone_append_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+				void *buffer, void *metadata, uint64_t zslba,
+				uint32_t lba_count, spdk_nvme_cmd_cb cb_fn, void *cb_arg,
+				uint32_t io_flags, uint16_t apptag_mask, uint16_t apptag)
+{
+	struct nvme_request *req;
+	struct nvme_payload payload;
+
+	if (!_is_io_flags_valid(io_flags)) {
+		return -EINVAL;
+	}
+
+	if (!nvme_ns_check_zone_append_length(ns, lba_count, io_flags)) {
+		return -EINVAL;
+	}
+
+	payload = NVME_PAYLOAD_CONTIG(buffer, metadata);
+
+	req = _nvme_ns_cmd_rw(ns, qpair, &payload, 0, 0, zslba, lba_count, cb_fn, cb_arg,
+			      SPDK_NVME_OPC_ZONE_APPEND, io_flags, apptag_mask, apptag, true);
+	if (req != NULL) {
+		return nvme_qpair_submit_request(qpair, req);
+	} else if (nvme_ns_check_request_length(ns)) {
+		return -EINVAL;
+	} else {
+		return -ENOMEM;
+	}
+}
+
+int
+nvme_ns_cmd_zone_appendv_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+				 uint64_t zslba, uint32_t lba_count,
+				 spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t io_flags,
+				 spdk_nvme_req_reset_sgl_cb reset_sgl_fn,
+				 spdk_nvme_req_next_sge_cb next_sge_fn, void *metadata,
+				 uint16_t apptag_mask, uint16_t apptag)
+{
+	struct nvme_request *req;
+	struct nvme_payload payload;
+
+	if (!_is_io_flags_valid(io_flags)) {
+		return -EINVAL;
+	}
+
+	if (reset_sgl_fn == NULL || next_sge_fn == NULL) {
+		return -EINVAL;
+	}
+
+	if (!nvme_ns_check_zone_append_length(ns, lba_count, io_flags)) {
+		return -EINVAL;
+	}
+
+	payload = NVME_PAYLOAD_SGL(reset_sgl_fn, next_sge_fn, cb_arg, metadata);
+
+	req = _nvme_ns_cmd_rw(ns, qpair, &payload, 0, 0, zslba, lba_count, cb_fn, cb_arg,
+			      SPDK_NVME_OPC_ZONE_APPEND, io_flags, apptag_mask, apptag, true);
+	if (req != NULL) {
+		return nvme_qpair_submit_request(qpair, req);
+	} else if (nvme_ns_check_request_length(ns)) {
 		return -EINVAL;
 	} else {
 		return -ENOMEM;
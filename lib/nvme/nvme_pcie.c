@@ -50,6 +50,22 @@
 #define NVME_MIN_COMPLETIONS	(1)
 #define NVME_MAX_COMPLETIONS	(128)
 
+/*
+ * Qpairs with delay_cmd_submit set batch their doorbell writes. The SQ tail doorbell
+ *  is rung by the next poll, or at submission once this many commands are waiting
+ *  for it or the oldest of them has waited for NVME_PCIE_SQ_DOORBELL_BUDGET_US.
+ */
+#define NVME_PCIE_SQ_DOORBELL_BATCH	(32)
+#define NVME_PCIE_SQ_DOORBELL_BUDGET_US	(20)
+
+/*
+ * Upper bound of consumed completion queue entries a delay_cmd_submit qpair may
+ *  leave unreported to the controller across polls.
+ */
+#define NVME_PCIE_CQ_DOORBELL_BATCH	(8)
+
+#define NVME_PCIE_CPL_PER_CACHE_LINE	(SPDK_CACHE_LINE_SIZE / sizeof(struct spdk_nvme_cpl))
+
 /*
  * NVME_MAX_SGL_DESCRIPTORS defines the maximum number of descriptors in one SGL
  *  segment.
@@ -132,6 +148,7 @@ SPDK_STATIC_ASSERT((offsetof(struct nvme_tracker, meta_sgl) & 7) == 0, "SGL must
 
 struct nvme_pcie_poll_group {
 	struct spdk_nvme_transport_poll_group group;
+	struct spdk_nvme_pcie_stat stats;
 };
 
 /* PCIe transport extensions for spdk_nvme_qpair */
@@ -165,12 +182,23 @@ struct nvme_pcie_qpair {
 	uint16_t cq_head;
 	uint16_t sq_head;
 
+	/* Consumed completion queue entries not yet reported through the CQ head doorbell */
+	uint16_t cq_pending;
+	uint16_t cq_doorbell_batch;
+
+	/* Time the oldest command not covered by the SQ tail doorbell was submitted */
+	uint64_t sq_pending_tsc;
+	uint64_t sq_doorbell_budget_ticks;
+
 	struct {
 		uint8_t phase			: 1;
 		uint8_t delay_cmd_submit	: 1;
 		uint8_t has_shadow_doorbell	: 1;
 	} flags;
 
+	/* Points to the poll group's counters, or to own_stats outside of a poll group */
+	struct spdk_nvme_pcie_stat *stats;
+
 	/*
 	 * Base qpair structure.
 	 * This is located after the hot data in this structure so that the important parts of
@@ -203,6 +231,8 @@ struct nvme_pcie_qpair {
 
 	struct spdk_nvme_cmd *sq_vaddr;
 	struct spdk_nvme_cpl *cq_vaddr;
+
+	struct spdk_nvme_pcie_stat own_stats;
 };
 
 static int nvme_pcie_ctrlr_attach(struct spdk_nvme_probe_ctx *probe_ctx,
@@ -974,6 +1004,7 @@ nvme_pcie_qpair_reset(struct spdk_nvme_qpair *qpair)
 
 	/* all head/tail vals are set to 0 */
 	pqpair->last_sq_tail = pqpair->sq_tail = pqpair->sq_head = pqpair->cq_head = 0;
+	pqpair->cq_pending = 0;
 
 	/*
 	 * First time through the completion queue, HW will set phase
@@ -1042,6 +1073,7 @@ nvme_pcie_qpair_construct(struct spdk_nvme_qpair *qpair,
 	}
 
 	pqpair->retry_count = ctrlr->opts.transport_retry_count;
+	pqpair->stats = &pqpair->own_stats;
 
 	/*
 	 * Limit the maximum number of completions to return per call to prevent wraparound,
@@ -1053,6 +1085,15 @@ nvme_pcie_qpair_construct(struct spdk_nvme_qpair *qpair,
 	pqpair->max_completions_cap = spdk_min(pqpair->max_completions_cap, NVME_MAX_COMPLETIONS);
 	num_trackers = pqpair->num_entries - pqpair->max_completions_cap;
 
+	/*
+	 * Entries left unreported to the controller count against max_completions_cap, so
+	 *  keep the CQ doorbell batch well below it to leave room for each poll.
+	 */
+	pqpair->cq_doorbell_batch = spdk_min(NVME_PCIE_CQ_DOORBELL_BATCH,
+					     pqpair->max_completions_cap / 2);
+	pqpair->sq_doorbell_budget_ticks = NVME_PCIE_SQ_DOORBELL_BUDGET_US * spdk_get_ticks_hz() /
+					   SPDK_SEC_TO_USEC;
+
 	SPDK_INFOLOG(SPDK_LOG_NVME, "max_completions_cap = %" PRIu16 " num_trackers = %" PRIu16 "\n",
 		     pqpair->max_completions_cap, num_trackers);
 
@@ -1309,7 +1350,10 @@ nvme_pcie_qpair_ring_sq_doorbell(struct spdk_nvme_qpair *qpair)
 		g_thread_mmio_ctrlr = pctrlr;
 		spdk_mmio_write_4(pqpair->sq_tdbl, pqpair->sq_tail);
 		g_thread_mmio_ctrlr = NULL;
+		pqpair->stats->sq_doorbell_updates++;
 	}
+
+	pqpair->last_sq_tail = pqpair->sq_tail;
 }
 
 static inline void
@@ -1330,6 +1374,32 @@ nvme_pcie_qpair_ring_cq_doorbell(struct spdk_nvme_qpair *qpair)
 		g_thread_mmio_ctrlr = pctrlr;
 		spdk_mmio_write_4(pqpair->cq_hdbl, pqpair->cq_head);
 		g_thread_mmio_ctrlr = NULL;
+		pqpair->stats->cq_doorbell_updates++;
+	}
+
+	pqpair->cq_pending = 0;
+}
+
+static inline void
+nvme_pcie_qpair_delay_sq_doorbell(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_pcie_qpair	*pqpair = nvme_pcie_qpair(qpair);
+	uint16_t		pending;
+
+	if (pqpair->sq_tail >= pqpair->last_sq_tail) {
+		pending = pqpair->sq_tail - pqpair->last_sq_tail;
+	} else {
+		pending = pqpair->num_entries - pqpair->last_sq_tail + pqpair->sq_tail;
+	}
+
+	if (pending == 1) {
+		pqpair->sq_pending_tsc = spdk_get_ticks();
+		return;
+	}
+
+	if (pending >= NVME_PCIE_SQ_DOORBELL_BATCH ||
+	    spdk_get_ticks() - pqpair->sq_pending_tsc >= pqpair->sq_doorbell_budget_ticks) {
+		nvme_pcie_qpair_ring_sq_doorbell(qpair);
 	}
 }
 
@@ -1366,8 +1436,12 @@ nvme_pcie_qpair_submit_tracker(struct spdk_nvme_qpair *qpair, struct nvme_tracke
 		SPDK_ERRLOG("sq_tail is passing sq_head!\n");
 	}
 
+	pqpair->stats->submitted_requests++;
+
 	if (!pqpair->flags.delay_cmd_submit) {
 		nvme_pcie_qpair_ring_sq_doorbell(qpair);
+	} else {
+		nvme_pcie_qpair_delay_sq_doorbell(qpair);
 	}
 }
 
@@ -2286,6 +2360,7 @@ nvme_pcie_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_reques
 	tr = TAILQ_FIRST(&pqpair->free_tr);
 
 	if (tr == NULL) {
+		pqpair->stats->queued_requests++;
 		/* Inform the upper layer to try again later. */
 		rc = -EAGAIN;
 		goto exit;
@@ -2377,7 +2452,7 @@ nvme_pcie_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_
 	struct spdk_nvme_cpl	*cpl, *next_cpl;
 	uint32_t		 num_completions = 0;
 	struct spdk_nvme_ctrlr	*ctrlr = qpair->ctrlr;
-	uint16_t		 next_cq_head;
+	uint16_t		 next_cq_head, cpl_ahead;
 	uint8_t			 next_phase;
 	bool			 next_is_valid = false;
 
@@ -2394,6 +2469,10 @@ nvme_pcie_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_
 		max_completions = pqpair->max_completions_cap;
 	}
 
+	/* Entries consumed by earlier polls but not reported yet still count against the cap */
+	max_completions = spdk_min(max_completions,
+				   (uint32_t)(pqpair->max_completions_cap - pqpair->cq_pending));
+
 	while (1) {
 		cpl = &pqpair->cpl[pqpair->cq_head];
 
@@ -2414,6 +2493,15 @@ nvme_pcie_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_
 			__builtin_prefetch(&pqpair->tr[next_cpl->cid]);
 		}
 
+		if ((pqpair->cq_head & (NVME_PCIE_CPL_PER_CACHE_LINE - 1)) == 0) {
+			/* Starting on a new cache line of the CQ - prefetch the one after it */
+			cpl_ahead = pqpair->cq_head + NVME_PCIE_CPL_PER_CACHE_LINE;
+			if (spdk_unlikely(cpl_ahead >= pqpair->num_entries)) {
+				cpl_ahead -= pqpair->num_entries;
+			}
+			__builtin_prefetch(&pqpair->cpl[cpl_ahead]);
+		}
+
 #ifdef __PPC64__
 		/*
 		 * This memory barrier prevents reordering of:
@@ -2450,15 +2538,28 @@ nvme_pcie_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_
 		}
 	}
 
+	pqpair->stats->polls++;
 	if (num_completions > 0) {
-		nvme_pcie_qpair_ring_cq_doorbell(qpair);
+		pqpair->stats->completions += num_completions;
+		pqpair->cq_pending += num_completions;
+	} else {
+		pqpair->stats->idle_polls++;
 	}
 
 	if (pqpair->flags.delay_cmd_submit) {
+		/*
+		 * Busy qpairs report consumed CQ entries once per batch, an idle poll
+		 *  reports whatever is left.
+		 */
+		if (pqpair->cq_pending > pqpair->cq_doorbell_batch ||
+		    (pqpair->cq_pending > 0 && num_completions == 0)) {
+			nvme_pcie_qpair_ring_cq_doorbell(qpair);
+		}
 		if (pqpair->last_sq_tail != pqpair->sq_tail) {
 			nvme_pcie_qpair_ring_sq_doorbell(qpair);
-			pqpair->last_sq_tail = pqpair->sq_tail;
 		}
+	} else if (num_completions > 0) {
+		nvme_pcie_qpair_ring_cq_doorbell(qpair);
 	}
 
 	if (spdk_unlikely(ctrlr->timeout_enabled)) {
@@ -2478,6 +2579,12 @@ nvme_pcie_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_
 	return num_completions;
 }
 
+static inline struct nvme_pcie_poll_group *
+nvme_pcie_poll_group(struct spdk_nvme_transport_poll_group *group)
+{
+	return SPDK_CONTAINEROF(group, struct nvme_pcie_poll_group, group);
+}
+
 static struct spdk_nvme_transport_poll_group *
 nvme_pcie_poll_group_create(void)
 {
@@ -2507,6 +2614,10 @@ static int
 nvme_pcie_poll_group_add(struct spdk_nvme_transport_poll_group *tgroup,
 			 struct spdk_nvme_qpair *qpair)
 {
+	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
+	struct nvme_pcie_poll_group *group = nvme_pcie_poll_group(tgroup);
+
+	pqpair->stats = &group->stats;
 	return 0;
 }
 
@@ -2514,6 +2625,9 @@ static int
 nvme_pcie_poll_group_remove(struct spdk_nvme_transport_poll_group *tgroup,
 			    struct spdk_nvme_qpair *qpair)
 {
+	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
+
+	pqpair->stats = &pqpair->own_stats;
 	return 0;
 }
 
@@ -2553,6 +2667,17 @@ nvme_pcie_poll_group_destroy(struct spdk_nvme_transport_poll_group *tgroup)
 	return 0;
 }
 
+static int
+nvme_pcie_poll_group_get_stats(struct spdk_nvme_transport_poll_group *tgroup,
+			       struct spdk_nvme_transport_poll_group_stat *stat)
+{
+	struct nvme_pcie_poll_group *group = nvme_pcie_poll_group(tgroup);
+
+	memcpy(&stat->u.pcie, &group->stats, sizeof(group->stats));
+
+	return 0;
+}
+
 const struct spdk_nvme_transport_ops pcie_ops = {
 	.name = "PCIE",
 	.type = SPDK_NVME_TRANSPORT_PCIE,
@@ -2592,6 +2717,7 @@ const struct spdk_nvme_transport_ops pcie_ops = {
 	.poll_group_remove = nvme_pcie_poll_group_remove,
 	.poll_group_process_completions = nvme_pcie_poll_group_process_completions,
 	.poll_group_destroy = nvme_pcie_poll_group_destroy,
+	.poll_group_get_stats = nvme_pcie_poll_group_get_stats,
 };
 
 SPDK_NVME_TRANSPORT_REGISTER(pcie, &pcie_ops);
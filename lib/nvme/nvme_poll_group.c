@@ -36,6 +36,12 @@
 
 struct spdk_nvme_poll_group *
 spdk_nvme_poll_group_create(void *ctx)
+{
+	return spdk_nvme_poll_group_create_ext(ctx, NULL);
+}
+
+struct spdk_nvme_poll_group *
+spdk_nvme_poll_group_create_ext(void *ctx, struct spdk_nvme_accel_fn_table *table)
 {
 	struct spdk_nvme_poll_group *group;
 
@@ -44,6 +50,18 @@ spdk_nvme_poll_group_create(void *ctx)
 		return NULL;
 	}
 
+	group->accel_fn_table.table_size = sizeof(struct spdk_nvme_accel_fn_table);
+	if (table != NULL && table->table_size != 0) {
+#define FIELD_OK(field) \
+	offsetof(struct spdk_nvme_accel_fn_table, field) + sizeof(table->field) <= table->table_size
+
+		if (FIELD_OK(submit_accel_crc32c)) {
+			group->accel_fn_table.submit_accel_crc32c = table->submit_accel_crc32c;
+		}
+
+#undef FIELD_OK
+	}
+
 	group->ctx = ctx;
 	STAILQ_INIT(&group->tgroups);
 
@@ -144,6 +162,55 @@ spdk_nvme_poll_group_get_ctx(struct spdk_nvme_poll_group *group)
 	return group->ctx;
 }
 
+int
+spdk_nvme_poll_group_get_stats(struct spdk_nvme_poll_group *group,
+			       struct spdk_nvme_poll_group_stat **stats)
+{
+	struct spdk_nvme_transport_poll_group *tgroup;
+	struct spdk_nvme_poll_group_stat *result;
+	struct spdk_nvme_transport_poll_group_stat *stat;
+	uint32_t num_tgroups = 0;
+
+	STAILQ_FOREACH(tgroup, &group->tgroups, link) {
+		num_tgroups++;
+	}
+
+	result = calloc(1, sizeof(*result));
+	if (result == NULL) {
+		return -ENOMEM;
+	}
+
+	if (num_tgroups > 0) {
+		result->transport_stat = calloc(num_tgroups, sizeof(*result->transport_stat));
+		if (result->transport_stat == NULL) {
+			free(result);
+			return -ENOMEM;
+		}
+	}
+
+	STAILQ_FOREACH(tgroup, &group->tgroups, link) {
+		stat = &result->transport_stat[result->num_transports];
+		/* Transports that do not keep statistics are left out. */
+		if (nvme_transport_poll_group_get_stats(tgroup, stat) == 0) {
+			result->num_transports++;
+		}
+	}
+
+	*stats = result;
+	return 0;
+}
+
+void
+spdk_nvme_poll_group_free_stats(struct spdk_nvme_poll_group_stat *stats)
+{
+	if (stats == NULL) {
+		return;
+	}
+
+	free(stats->transport_stat);
+	free(stats);
+}
+
 int
 spdk_nvme_poll_group_destroy(struct spdk_nvme_poll_group *group)
 {
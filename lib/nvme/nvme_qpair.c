@@ -122,6 +122,9 @@ static const struct nvme_string io_opcode[] = {
 	{ SPDK_NVME_OPC_RESERVATION_REPORT, "RESERVATION REPORT" },
 	{ SPDK_NVME_OPC_RESERVATION_ACQUIRE, "RESERVATION ACQUIRE" },
 	{ SPDK_NVME_OPC_RESERVATION_RELEASE, "RESERVATION RELEASE" },
+	{ SPDK_NVME_OPC_ZONE_MGMT_SEND, "ZONE MANAGEMENT SEND" },
+	{ SPDK_NVME_OPC_ZONE_MGMT_RECV, "ZONE MANAGEMENT RECEIVE" },
+	{ SPDK_NVME_OPC_ZONE_APPEND, "ZONE APPEND" },
 	{ SPDK_OCSSD_OPC_VECTOR_RESET, "OCSSD / VECTOR RESET" },
 	{ SPDK_OCSSD_OPC_VECTOR_WRITE, "OCSSD / VECTOR WRITE" },
 	{ SPDK_OCSSD_OPC_VECTOR_READ, "OCSSD / VECTOR READ" },
@@ -265,6 +268,7 @@ nvme_io_qpair_print_command(uint16_t qid, struct spdk_nvme_cmd *cmd)
 	case SPDK_NVME_OPC_READ:
 	case SPDK_NVME_OPC_WRITE_UNCORRECTABLE:
 	case SPDK_NVME_OPC_COMPARE:
+	case SPDK_NVME_OPC_ZONE_APPEND:
 		SPDK_NOTICELOG("%s sqid:%d cid:%d nsid:%d "
 			       "lba:%llu len:%d %s\n",
 			       nvme_get_string(io_opcode, cmd->opc), qid, cmd->cid, cmd->nsid,
@@ -381,6 +385,14 @@ static const struct nvme_string command_specific_status[] = {
 	{ SPDK_NVME_SC_CONFLICTING_ATTRIBUTES, "CONFLICTING ATTRIBUTES" },
 	{ SPDK_NVME_SC_INVALID_PROTECTION_INFO, "INVALID PROTECTION INFO" },
 	{ SPDK_NVME_SC_ATTEMPTED_WRITE_TO_RO_RANGE, "WRITE TO RO RANGE" },
+	{ SPDK_NVME_SC_ZONE_BOUNDARY_ERROR, "ZONE BOUNDARY ERROR" },
+	{ SPDK_NVME_SC_ZONE_IS_FULL, "ZONE IS FULL" },
+	{ SPDK_NVME_SC_ZONE_IS_READ_ONLY, "ZONE IS READ ONLY" },
+	{ SPDK_NVME_SC_ZONE_IS_OFFLINE, "ZONE IS OFFLINE" },
+	{ SPDK_NVME_SC_ZONE_INVALID_WRITE, "ZONE INVALID WRITE" },
+	{ SPDK_NVME_SC_TOO_MANY_ACTIVE_ZONES, "TOO MANY ACTIVE ZONES" },
+	{ SPDK_NVME_SC_TOO_MANY_OPEN_ZONES, "TOO MANY OPEN ZONES" },
+	{ SPDK_NVME_SC_INVALID_ZONE_STATE_TRANSITION, "INVALID ZONE STATE TRANSITION" },
 	{ 0xFFFF, "COMMAND SPECIFIC" }
 };
 
@@ -575,6 +587,33 @@ _nvme_qpair_complete_abort_queued_reqs(struct spdk_nvme_qpair *qpair)
 	}
 }
 
+static void
+_nvme_qpair_abort_split_reqs(struct spdk_nvme_qpair *qpair, uint32_t dnr)
+{
+	struct nvme_request		*req;
+
+	while (!STAILQ_EMPTY(&qpair->split_req)) {
+		req = STAILQ_FIRST(&qpair->split_req);
+		STAILQ_REMOVE_HEAD(&qpair->split_req, stailq);
+		if (!qpair->ctrlr->opts.disable_error_logging) {
+			SPDK_ERRLOG("aborting split i/o\n");
+		}
+		/*
+		 * Don't build the remaining children.  The request completes with its
+		 *  last outstanding child, or right away if it has none.
+		 */
+		req->split_pending = 0;
+		req->parent_status.status.sct = SPDK_NVME_SCT_GENERIC;
+		req->parent_status.status.sc = SPDK_NVME_SC_ABORTED_BY_REQUEST;
+		req->parent_status.status.dnr = dnr;
+		if (req->num_children == 0) {
+			nvme_complete_request(req->cb_fn, req->cb_arg, qpair, req,
+					      &req->parent_status);
+			nvme_free_request(req);
+		}
+	}
+}
+
 uint32_t
 nvme_qpair_abort_queued_reqs(struct spdk_nvme_qpair *qpair, void *cmd_cb_arg)
 {
@@ -646,6 +685,28 @@ nvme_qpair_check_enabled(struct spdk_nvme_qpair *qpair)
 	return nvme_qpair_get_state(qpair) == NVME_QPAIR_ENABLED;
 }
 
+static void
+nvme_qpair_resume_split_reqs(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_request *req;
+
+	/*
+	 * Resume split requests in the order they were submitted and stop at the first
+	 *  one that can't build all of its remaining children, so that the requests
+	 *  freed by later completions go to it first.
+	 */
+	while ((req = STAILQ_FIRST(&qpair->split_req)) != NULL) {
+		if (qpair->ctrlr->is_resetting) {
+			break;
+		}
+		STAILQ_REMOVE_HEAD(&qpair->split_req, stailq);
+		if (!nvme_ns_cmd_resume_split(req)) {
+			STAILQ_INSERT_HEAD(&qpair->split_req, req, stailq);
+			break;
+		}
+	}
+}
+
 void
 nvme_qpair_resubmit_requests(struct spdk_nvme_qpair *qpair, uint32_t num_requests)
 {
@@ -669,6 +730,15 @@ nvme_qpair_resubmit_requests(struct spdk_nvme_qpair *qpair, uint32_t num_request
 	}
 
 	_nvme_qpair_complete_abort_queued_reqs(qpair);
+
+	/*
+	 * Transport poll groups call this directly instead of going through
+	 *  spdk_nvme_qpair_process_completions(), so split requests waiting
+	 *  for free requests have to be resumed here too.
+	 */
+	if (spdk_unlikely(!STAILQ_EMPTY(&qpair->split_req))) {
+		nvme_qpair_resume_split_reqs(qpair);
+	}
 }
 
 int32_t
@@ -761,6 +831,7 @@ nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
 	STAILQ_INIT(&qpair->free_req);
 	STAILQ_INIT(&qpair->queued_req);
 	STAILQ_INIT(&qpair->aborting_queued_req);
+	STAILQ_INIT(&qpair->split_req);
 	TAILQ_INIT(&qpair->err_cmd_head);
 	STAILQ_INIT(&qpair->err_req_head);
 
@@ -803,6 +874,7 @@ nvme_qpair_deinit(struct spdk_nvme_qpair *qpair)
 {
 	struct nvme_error_cmd *cmd, *entry;
 
+	_nvme_qpair_abort_split_reqs(qpair, 1);
 	_nvme_qpair_abort_queued_reqs(qpair, 1);
 	_nvme_qpair_complete_abort_queued_reqs(qpair);
 	nvme_qpair_complete_error_reqs(qpair);
@@ -823,14 +895,17 @@ _nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *r
 	struct nvme_error_cmd	*cmd;
 	struct spdk_nvme_ctrlr	*ctrlr = qpair->ctrlr;
 	bool			child_req_failed = false;
+	bool			split_pending;
 
 	nvme_qpair_check_enabled(qpair);
 
 	if (req->num_children) {
 		/*
 		 * This is a split (parent) request. Submit all of the children but not the parent
-		 * request itself, since the parent is the original unsplit request.
+		 * request itself, since the parent is the original unsplit request.  A parent
+		 * without split_pending may complete with its last child inside the loop below.
 		 */
+		split_pending = req->split_pending;
 		TAILQ_FOREACH_SAFE(child_req, &req->children, child_tailq, tmp) {
 			if (spdk_likely(!child_req_failed)) {
 				rc = nvme_qpair_submit_request(qpair, child_req);
@@ -845,6 +920,8 @@ _nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *r
 		}
 
 		if (spdk_unlikely(child_req_failed)) {
+			/* Don't build the remaining children of a request split on submission. */
+			req->split_pending = 0;
 			/* part of children requests have been submitted,
 			 * return success since we must wait for those children to complete,
 			 * but set the parent request to failure.
@@ -857,6 +934,10 @@ _nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *r
 			goto error;
 		}
 
+		if (spdk_unlikely(split_pending)) {
+			STAILQ_INSERT_TAIL(&qpair->split_req, req, stailq);
+		}
+
 		return rc;
 	}
 
@@ -997,6 +1078,7 @@ void
 nvme_qpair_abort_reqs(struct spdk_nvme_qpair *qpair, uint32_t dnr)
 {
 	nvme_qpair_complete_error_reqs(qpair);
+	_nvme_qpair_abort_split_reqs(qpair, dnr);
 	_nvme_qpair_abort_queued_reqs(qpair, dnr);
 	_nvme_qpair_complete_abort_queued_reqs(qpair);
 	nvme_transport_qpair_abort_reqs(qpair, dnr);
@@ -169,6 +169,7 @@ struct nvme_rdma_poll_group {
 	STAILQ_HEAD(, nvme_rdma_poller)			pollers;
 	int						num_pollers;
 	STAILQ_HEAD(, nvme_rdma_destroyed_qpair)	destroyed_qpairs;
+	struct spdk_nvme_rdma_stat			stats;
 };
 
 struct spdk_nvme_send_wr_list {
@@ -239,6 +240,10 @@ struct nvme_rdma_qpair {
 	uint16_t				current_num_recvs;
 	uint16_t				current_num_sends;
 
+	/* Points to the poll group's counters, or to own_stats outside of a poll group */
+	struct spdk_nvme_rdma_stat		*stats;
+	struct spdk_nvme_rdma_stat		own_stats;
+
 	/* Placed at the end of the struct since it is not used frequently */
 	struct rdma_cm_event			*evt;
 
@@ -657,6 +662,10 @@ nvme_rdma_qpair_submit_sends(struct nvme_rdma_qpair *rqpair)
 	struct ibv_send_wr *bad_send_wr;
 	int rc;
 
+	if (rqpair->rdma_qp->send_wrs.first != NULL) {
+		rqpair->stats->send_doorbell_updates++;
+	}
+
 	rc = spdk_rdma_qp_flush_send_wrs(rqpair->rdma_qp, &bad_send_wr);
 
 	if (spdk_unlikely(rc)) {
@@ -680,6 +689,7 @@ nvme_rdma_qpair_submit_recvs(struct nvme_rdma_qpair *rqpair)
 	int rc = 0;
 
 	if (rqpair->recvs_to_post.first) {
+		rqpair->stats->recv_doorbell_updates++;
 		rc = ibv_post_recv(rqpair->rdma_qp->qp, rqpair->recvs_to_post.first, &bad_recv_wr);
 		if (spdk_unlikely(rc)) {
 			SPDK_ERRLOG("Failed to post WRs on receive queue, errno %d (%s), bad_wr %p\n",
@@ -706,6 +716,7 @@ nvme_rdma_qpair_queue_send_wr(struct nvme_rdma_qpair *rqpair, struct ibv_send_wr
 	assert(rqpair->current_num_sends < rqpair->num_entries);
 
 	rqpair->current_num_sends++;
+	rqpair->stats->total_send_wrs++;
 	spdk_rdma_qp_queue_send_wrs(rqpair->rdma_qp, wr);
 
 	if (!rqpair->delay_cmd_submit) {
@@ -725,6 +736,7 @@ nvme_rdma_qpair_queue_recv_wr(struct nvme_rdma_qpair *rqpair, struct ibv_recv_wr
 	assert(rqpair->current_num_recvs < rqpair->num_entries);
 
 	rqpair->current_num_recvs++;
+	rqpair->stats->total_recv_wrs++;
 	if (rqpair->recvs_to_post.first == NULL) {
 		rqpair->recvs_to_post.first = wr;
 	} else {
@@ -1780,6 +1792,7 @@ nvme_rdma_ctrlr_create_qpair(struct spdk_nvme_ctrlr *ctrlr,
 	}
 
 	rqpair->num_entries = qsize;
+	rqpair->stats = &rqpair->own_stats;
 	rqpair->delay_cmd_submit = delay_cmd_submit;
 	qpair = &rqpair->qpair;
 	rc = nvme_qpair_init(qpair, qid, ctrlr, qprio, num_requests);
@@ -2073,6 +2086,7 @@ nvme_rdma_qpair_submit_request(struct spdk_nvme_qpair *qpair,
 
 	rdma_req = nvme_rdma_req_get(rqpair);
 	if (!rdma_req) {
+		rqpair->stats->queued_requests++;
 		/* Inform the upper layer to try again later. */
 		return -EAGAIN;
 	}
@@ -2204,7 +2218,8 @@ nvme_rdma_conditional_fail_qpair(struct nvme_rdma_qpair *rqpair, struct nvme_rdm
 static int
 nvme_rdma_cq_process_completions(struct ibv_cq *cq, uint32_t batch_size,
 				 struct nvme_rdma_poll_group *group,
-				 struct nvme_rdma_qpair *rdma_qpair)
+				 struct nvme_rdma_qpair *rdma_qpair,
+				 struct spdk_nvme_rdma_stat *stats)
 {
 	struct ibv_wc			wc[MAX_COMPLETIONS_PER_POLL];
 	struct nvme_rdma_qpair		*rqpair;
@@ -2215,12 +2230,14 @@ nvme_rdma_cq_process_completions(struct ibv_cq *cq, uint32_t batch_size,
 	int				completion_rc = 0;
 	int				rc, i;
 
+	stats->polls++;
 	rc = ibv_poll_cq(cq, batch_size, wc);
 	if (rc < 0) {
 		SPDK_ERRLOG("Error polling CQ! (%d): %s\n",
 			    errno, spdk_strerror(errno));
 		return -ECANCELED;
 	} else if (rc == 0) {
+		stats->idle_polls++;
 		return 0;
 	}
 
@@ -2262,6 +2279,7 @@ nvme_rdma_cq_process_completions(struct ibv_cq *cq, uint32_t batch_size,
 				}
 				reaped++;
 				rqpair->num_completions++;
+				rqpair->stats->completions++;
 			}
 			break;
 
@@ -2298,6 +2316,7 @@ nvme_rdma_cq_process_completions(struct ibv_cq *cq, uint32_t batch_size,
 				}
 				reaped++;
 				rqpair->num_completions++;
+				rqpair->stats->completions++;
 			}
 			break;
 
@@ -2361,7 +2380,7 @@ nvme_rdma_qpair_process_completions(struct spdk_nvme_qpair *qpair,
 	rqpair->num_completions = 0;
 	do {
 		batch_size = spdk_min((max_completions - rqpair->num_completions), MAX_COMPLETIONS_PER_POLL);
-		rc = nvme_rdma_cq_process_completions(cq, batch_size, NULL, rqpair);
+		rc = nvme_rdma_cq_process_completions(cq, batch_size, NULL, rqpair, rqpair->stats);
 
 		if (rc == 0) {
 			break;
@@ -2662,6 +2681,9 @@ static int
 nvme_rdma_poll_group_add(struct spdk_nvme_transport_poll_group *tgroup,
 			 struct spdk_nvme_qpair *qpair)
 {
+	struct nvme_rdma_qpair *rqpair = nvme_rdma_qpair(qpair);
+
+	rqpair->stats = &nvme_rdma_poll_group(tgroup)->stats;
 	return 0;
 }
 
@@ -2669,6 +2691,10 @@ static int
 nvme_rdma_poll_group_remove(struct spdk_nvme_transport_poll_group *tgroup,
 			    struct spdk_nvme_qpair *qpair)
 {
+	struct nvme_rdma_qpair *rqpair = nvme_rdma_qpair(qpair);
+
+	rqpair->stats = &rqpair->own_stats;
+
 	if (qpair->poll_group_tailq_head == &tgroup->connected_qpairs) {
 		return nvme_poll_group_disconnect_qpair(qpair);
 	}
@@ -2735,7 +2761,8 @@ nvme_rdma_poll_group_process_completions(struct spdk_nvme_transport_poll_group *
 		poller_completions = 0;
 		do {
 			batch_size = spdk_min((completions_per_poller - poller_completions), MAX_COMPLETIONS_PER_POLL);
-			rc = nvme_rdma_cq_process_completions(poller->cq, batch_size, group, NULL);
+			rc = nvme_rdma_cq_process_completions(poller->cq, batch_size, group, NULL,
+							      &group->stats);
 			if (rc <= 0) {
 				if (rc == -ECANCELED) {
 					return -EIO;
@@ -2805,6 +2832,17 @@ nvme_rdma_poll_group_destroy(struct spdk_nvme_transport_poll_group *tgroup)
 	return 0;
 }
 
+static int
+nvme_rdma_poll_group_get_stats(struct spdk_nvme_transport_poll_group *tgroup,
+			       struct spdk_nvme_transport_poll_group_stat *stat)
+{
+	struct nvme_rdma_poll_group *group = nvme_rdma_poll_group(tgroup);
+
+	memcpy(&stat->u.rdma, &group->stats, sizeof(group->stats));
+
+	return 0;
+}
+
 void
 spdk_nvme_rdma_init_hooks(struct spdk_nvme_rdma_hooks *hooks)
 {
@@ -2846,6 +2884,7 @@ const struct spdk_nvme_transport_ops rdma_ops = {
 	.poll_group_remove = nvme_rdma_poll_group_remove,
 	.poll_group_process_completions = nvme_rdma_poll_group_process_completions,
 	.poll_group_destroy = nvme_rdma_poll_group_destroy,
+	.poll_group_get_stats = nvme_rdma_poll_group_get_stats,
 
 };
 
@@ -58,6 +58,8 @@
 #define NVME_TCP_MAX_R2T_DEFAULT		1
 #define NVME_TCP_PDU_H2C_MIN_DATA_SIZE		4096
 #define NVME_TCP_IN_CAPSULE_DATA_MAX_SIZE	8192
+/* Size of the per qpair buffer the PDU headers are read through */
+#define NVME_TCP_RECV_BUF_SIZE			4096
 
 /* NVMe TCP transport extensions for spdk_nvme_ctrlr */
 struct nvme_tcp_ctrlr {
@@ -69,6 +71,7 @@ struct nvme_tcp_poll_group {
 	struct spdk_sock_group *sock_group;
 	uint32_t completions_per_qpair;
 	int64_t num_completions;
+	struct spdk_nvme_tcp_stat stats;
 };
 
 /* NVMe TCP qpair extensions for spdk_nvme_qpair */
@@ -101,6 +104,26 @@ struct nvme_tcp_qpair {
 	uint8_t					cpda;
 
 	enum nvme_tcp_qpair_state		state;
+
+	/* Number of data digests being computed by the poll group's accel functions */
+	uint32_t				ddgst_inflight;
+	/* The qpair was deleted, free it once ddgst_inflight drops to 0 */
+	bool					free_deferred;
+	/* Requests completed by the accel functions, reported by the next poll */
+	uint32_t				ddgst_reaped;
+
+	/*
+	 * Bytes read from the socket ahead of the current PDU. A single read
+	 * usually brings in the headers of several PDUs, which are then parsed
+	 * from here without further syscalls.
+	 */
+	uint8_t					*recv_buf;
+	uint32_t				recv_buf_off;
+	uint32_t				recv_buf_len;
+
+	/* Points to the poll group's counters, or to own_stats outside of a poll group */
+	struct spdk_nvme_tcp_stat		*stats;
+	struct spdk_nvme_tcp_stat		own_stats;
 };
 
 enum nvme_tcp_req_state {
@@ -128,6 +151,13 @@ struct nvme_tcp_req {
 	struct nvme_tcp_pdu			*send_pdu;
 	struct iovec				iov[NVME_TCP_MAX_SGL_DESCRIPTORS];
 	uint32_t				iovcnt;
+	/* A data digest of this request is computed by the accel functions. While
+	 * set, send_pdu belongs to the computation and the request can't be freed.
+	 */
+	bool					ddgst_pending;
+	/* The response arrived while the digest of received data was verified */
+	bool					cpl_deferred;
+	struct spdk_nvme_cpl			deferred_cpl;
 	struct nvme_tcp_qpair			*tqpair;
 	TAILQ_ENTRY(nvme_tcp_req)		link;
 };
@@ -176,6 +206,8 @@ nvme_tcp_req_get(struct nvme_tcp_qpair *tqpair)
 	tcp_req->ordering.send_ack = 0;
 	tcp_req->ordering.data_recv = 0;
 	tcp_req->ordering.r2t_recv = 0;
+	tcp_req->cpl_deferred = false;
+	assert(!tcp_req->ddgst_pending);
 	memset(tcp_req->send_pdu, 0, sizeof(struct nvme_tcp_pdu));
 	TAILQ_INSERT_TAIL(&tqpair->outstanding_reqs, tcp_req, link);
 
@@ -227,6 +259,9 @@ nvme_tcp_free_reqs(struct nvme_tcp_qpair *tqpair)
 
 	spdk_free(tqpair->send_pdus);
 	tqpair->send_pdus = NULL;
+
+	free(tqpair->recv_buf);
+	tqpair->recv_buf = NULL;
 }
 
 static int
@@ -250,6 +285,12 @@ nvme_tcp_alloc_reqs(struct nvme_tcp_qpair *tqpair)
 		goto fail;
 	}
 
+	tqpair->recv_buf = malloc(NVME_TCP_RECV_BUF_SIZE);
+	if (tqpair->recv_buf == NULL) {
+		SPDK_ERRLOG("Failed to allocate recv_buf on tqpair=%p\n", tqpair);
+		goto fail;
+	}
+
 	TAILQ_INIT(&tqpair->send_queue);
 	TAILQ_INIT(&tqpair->free_reqs);
 	TAILQ_INIT(&tqpair->outstanding_reqs);
@@ -275,6 +316,10 @@ nvme_tcp_ctrlr_disconnect_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_
 
 	spdk_sock_close(&tqpair->sock);
 
+	/* Drop whatever was read ahead from the old connection */
+	tqpair->recv_buf_off = 0;
+	tqpair->recv_buf_len = 0;
+
 	/* clear the send_queue */
 	while (!TAILQ_EMPTY(&tqpair->send_queue)) {
 		pdu = TAILQ_FIRST(&tqpair->send_queue);
@@ -300,6 +345,11 @@ nvme_tcp_ctrlr_delete_io_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_q
 	nvme_tcp_qpair_abort_reqs(qpair, 1);
 	nvme_qpair_deinit(qpair);
 	tqpair = nvme_tcp_qpair(qpair);
+	if (tqpair->ddgst_inflight > 0) {
+		/* The accel functions still use requests of the qpair */
+		tqpair->free_deferred = true;
+		return 0;
+	}
 	nvme_tcp_free_reqs(tqpair);
 	free(tqpair);
 
@@ -345,18 +395,115 @@ _pdu_write_done(void *cb_arg, int err)
 	pdu->cb_fn(pdu->cb_arg);
 }
 
+static struct spdk_nvme_poll_group *
+nvme_tcp_qpair_accel_group(struct nvme_tcp_qpair *tqpair)
+{
+	struct spdk_nvme_transport_poll_group *tgroup = tqpair->qpair.poll_group;
+
+	if (tgroup == NULL || tgroup->group->accel_fn_table.submit_accel_crc32c == NULL) {
+		return NULL;
+	}
+
+	return tgroup->group;
+}
+
+/* The accel functions compute a plain CRC-32C over the data, so digests that need
+ * padding or are computed over data with DIF stay on the polling thread.
+ */
+static inline bool
+nvme_tcp_pdu_ddgst_offloadable(struct nvme_tcp_pdu *pdu)
+{
+	return pdu->dif_ctx == NULL && pdu->data_len % SPDK_NVME_TCP_DIGEST_ALIGNMENT == 0;
+}
+
+static void
+nvme_tcp_req_submit_ddgst(struct spdk_nvme_poll_group *group, struct nvme_tcp_req *tcp_req,
+			  spdk_nvme_accel_completion_cb cb_fn)
+{
+	struct nvme_tcp_pdu *pdu = tcp_req->send_pdu;
+
+	/* A seed of 0 starts the CRC from ~0, like nvme_tcp_pdu_calc_data_digest() */
+	group->accel_fn_table.submit_accel_crc32c(group->ctx, &pdu->data_digest_crc32,
+			pdu->data_iov, pdu->data_iovcnt, 0, cb_fn, tcp_req);
+}
+
+/* Returns true if the request can go on with the computed digest. */
+static bool
+nvme_tcp_req_ddgst_done(struct nvme_tcp_req *tcp_req)
+{
+	struct nvme_tcp_qpair *tqpair = tcp_req->tqpair;
+
+	assert(tcp_req->ddgst_pending);
+	assert(tqpair->ddgst_inflight > 0);
+	tcp_req->ddgst_pending = false;
+	tqpair->ddgst_inflight--;
+
+	if (spdk_unlikely(tcp_req->req == NULL)) {
+		/* The request was aborted while its digest was computed */
+		nvme_tcp_req_put(tqpair, tcp_req);
+		if (tqpair->free_deferred && tqpair->ddgst_inflight == 0) {
+			nvme_tcp_free_reqs(tqpair);
+			free(tqpair);
+		}
+		return false;
+	}
+
+	/* A disconnected qpair aborts the request later on */
+	return tqpair->sock != NULL;
+}
+
+static void
+_nvme_tcp_qpair_write_pdu(struct nvme_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu)
+{
+	uint32_t mapped_length = 0;
+
+	pdu->sock_req.iovcnt = nvme_tcp_build_iovs(pdu->iov, NVME_TCP_MAX_SGL_DESCRIPTORS, pdu,
+			       tqpair->host_hdgst_enable, tqpair->host_ddgst_enable,
+			       &mapped_length);
+	pdu->sock_req.cb_fn = _pdu_write_done;
+	pdu->sock_req.cb_arg = pdu;
+	TAILQ_INSERT_TAIL(&tqpair->send_queue, pdu, tailq);
+	spdk_sock_writev_async(tqpair->sock, &pdu->sock_req);
+}
+
+static void
+nvme_tcp_send_ddgst_done(void *cb_arg, int status)
+{
+	struct nvme_tcp_req *tcp_req = cb_arg;
+	struct nvme_tcp_pdu *pdu = tcp_req->send_pdu;
+	uint32_t crc32c;
+
+	if (!nvme_tcp_req_ddgst_done(tcp_req)) {
+		return;
+	}
+
+	if (spdk_likely(status == 0)) {
+		crc32c = pdu->data_digest_crc32 ^ SPDK_CRC32C_XOR;
+	} else {
+		crc32c = nvme_tcp_pdu_calc_data_digest(pdu);
+	}
+	MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+
+	_nvme_tcp_qpair_write_pdu(tcp_req->tqpair, pdu);
+}
+
 static int
 nvme_tcp_qpair_write_pdu(struct nvme_tcp_qpair *tqpair,
 			 struct nvme_tcp_pdu *pdu,
 			 nvme_tcp_qpair_xfer_complete_cb cb_fn,
 			 void *cb_arg)
 {
+	struct spdk_nvme_poll_group *group;
+	struct nvme_tcp_req *tcp_req;
 	int hlen;
 	uint32_t crc32c;
-	uint32_t mapped_length = 0;
 
 	hlen = pdu->hdr.common.hlen;
 
+	pdu->cb_fn = cb_fn;
+	pdu->cb_arg = cb_arg;
+	pdu->qpair = tqpair;
+
 	/* Header Digest */
 	if (g_nvme_tcp_hdgst[pdu->hdr.common.pdu_type] && tqpair->host_hdgst_enable) {
 		crc32c = nvme_tcp_pdu_calc_header_digest(pdu);
@@ -365,21 +512,22 @@ nvme_tcp_qpair_write_pdu(struct nvme_tcp_qpair *tqpair,
 
 	/* Data Digest */
 	if (pdu->data_len > 0 && g_nvme_tcp_ddgst[pdu->hdr.common.pdu_type] && tqpair->host_ddgst_enable) {
+		tcp_req = pdu->req;
+		group = nvme_tcp_qpair_accel_group(tqpair);
+		if (group != NULL && tcp_req != NULL && nvme_tcp_pdu_ddgst_offloadable(pdu)) {
+			assert(tcp_req->send_pdu == pdu);
+			assert(!tcp_req->ddgst_pending);
+			tcp_req->ddgst_pending = true;
+			tqpair->ddgst_inflight++;
+			nvme_tcp_req_submit_ddgst(group, tcp_req, nvme_tcp_send_ddgst_done);
+			return 0;
+		}
+
 		crc32c = nvme_tcp_pdu_calc_data_digest(pdu);
 		MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
 	}
 
-	pdu->cb_fn = cb_fn;
-	pdu->cb_arg = cb_arg;
-
-	pdu->sock_req.iovcnt = nvme_tcp_build_iovs(pdu->iov, NVME_TCP_MAX_SGL_DESCRIPTORS, pdu,
-			       tqpair->host_hdgst_enable, tqpair->host_ddgst_enable,
-			       &mapped_length);
-	pdu->qpair = tqpair;
-	pdu->sock_req.cb_fn = _pdu_write_done;
-	pdu->sock_req.cb_arg = pdu;
-	TAILQ_INSERT_TAIL(&tqpair->send_queue, pdu, tailq);
-	spdk_sock_writev_async(tqpair->sock, &pdu->sock_req);
+	_nvme_tcp_qpair_write_pdu(tqpair, pdu);
 
 	return 0;
 }
@@ -577,6 +725,7 @@ nvme_tcp_qpair_capsule_cmd_send(struct nvme_tcp_qpair *tqpair,
 	tcp_req->datao = 0;
 	nvme_tcp_pdu_set_data_buf(pdu, tcp_req->iov, tcp_req->iovcnt,
 				  0, tcp_req->req->payload_size);
+	pdu->req = tcp_req;
 end:
 	capsule_cmd->common.plen = plen;
 	return nvme_tcp_qpair_write_pdu(tqpair, pdu, nvme_tcp_qpair_cmd_send_complete, tcp_req);
@@ -596,6 +745,7 @@ nvme_tcp_qpair_submit_request(struct spdk_nvme_qpair *qpair,
 
 	tcp_req = nvme_tcp_req_get(tqpair);
 	if (!tcp_req) {
+		tqpair->stats->queued_requests++;
 		/* Inform the upper layer to try again later. */
 		return -EAGAIN;
 	}
@@ -607,6 +757,8 @@ nvme_tcp_qpair_submit_request(struct spdk_nvme_qpair *qpair,
 		return -1;
 	}
 
+	tqpair->stats->submitted_requests++;
+
 	return nvme_tcp_qpair_capsule_cmd_send(tqpair, tcp_req);
 }
 
@@ -626,6 +778,7 @@ nvme_tcp_req_complete(struct nvme_tcp_req *tcp_req,
 	req = tcp_req->req;
 
 	TAILQ_REMOVE(&tcp_req->tqpair->outstanding_reqs, tcp_req, link);
+	tcp_req->tqpair->stats->nvme_completions++;
 	nvme_complete_request(req->cb_fn, req->cb_arg, req->qpair, req, rsp);
 	nvme_free_request(req);
 }
@@ -643,6 +796,11 @@ nvme_tcp_qpair_abort_reqs(struct spdk_nvme_qpair *qpair, uint32_t dnr)
 
 	TAILQ_FOREACH_SAFE(tcp_req, &tqpair->outstanding_reqs, link, tmp) {
 		nvme_tcp_req_complete(tcp_req, &cpl);
+		if (spdk_unlikely(tcp_req->ddgst_pending)) {
+			/* Freed once the accel functions are done with send_pdu */
+			tcp_req->req = NULL;
+			continue;
+		}
 		nvme_tcp_req_put(tqpair, tcp_req);
 	}
 }
@@ -818,6 +976,28 @@ get_nvme_active_req_by_cid(struct nvme_tcp_qpair *tqpair, uint32_t cid)
 	return &tqpair->tcp_reqs[cid];
 }
 
+/* Complete a request whose response was received. The completion is held back
+ * while the digest of data received for the request is still being verified.
+ */
+static void
+nvme_tcp_req_complete_recv(struct nvme_tcp_req *tcp_req, struct spdk_nvme_cpl *cpl,
+			   uint32_t *reaped)
+{
+	if (spdk_unlikely(tcp_req->ddgst_pending)) {
+		tcp_req->deferred_cpl = *cpl;
+		tcp_req->cpl_deferred = true;
+		return;
+	}
+
+	nvme_tcp_req_complete(tcp_req, cpl);
+	if (tcp_req->ordering.send_ack) {
+		(*reaped)++;
+	}
+
+	tcp_req->ordering.data_recv = 1;
+	nvme_tcp_req_put_safe(tcp_req);
+}
+
 static void
 nvme_tcp_c2h_data_payload_handle(struct nvme_tcp_qpair *tqpair,
 				 struct nvme_tcp_pdu *pdu, uint32_t *reaped)
@@ -845,13 +1025,7 @@ nvme_tcp_c2h_data_payload_handle(struct nvme_tcp_qpair *tqpair,
 
 		cpl.cid = tcp_req->cid;
 		cpl.sqid = tqpair->qpair.id;
-		nvme_tcp_req_complete(tcp_req, &cpl);
-		if (tcp_req->ordering.send_ack) {
-			(*reaped)++;
-		}
-
-		tcp_req->ordering.data_recv = 1;
-		nvme_tcp_req_put_safe(tcp_req);
+		nvme_tcp_req_complete_recv(tcp_req, &cpl, reaped);
 	}
 }
 
@@ -885,12 +1059,82 @@ nvme_tcp_c2h_term_req_payload_handle(struct nvme_tcp_qpair *tqpair,
 	nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_ERROR);
 }
 
+static void
+nvme_tcp_recv_ddgst_done(void *cb_arg, int status)
+{
+	struct nvme_tcp_req *tcp_req = cb_arg;
+	struct nvme_tcp_qpair *tqpair = tcp_req->tqpair;
+	struct nvme_tcp_pdu *pdu = tcp_req->send_pdu;
+	uint32_t crc32c;
+
+	if (!nvme_tcp_req_ddgst_done(tcp_req)) {
+		return;
+	}
+
+	if (spdk_likely(status == 0)) {
+		crc32c = pdu->data_digest_crc32 ^ SPDK_CRC32C_XOR;
+	} else {
+		crc32c = nvme_tcp_pdu_calc_data_digest(pdu);
+	}
+
+	if (!MATCH_DIGEST_WORD(pdu->data_digest, crc32c)) {
+		SPDK_ERRLOG("data digest error on tqpair=(%p) with pdu=%p\n", tqpair, pdu);
+		/* The request is aborted when the qpair is torn down */
+		nvme_tcp_qpair_send_h2c_term_req(tqpair, pdu,
+						 SPDK_NVME_TCP_TERM_REQ_FES_HDGST_ERROR, 0);
+		return;
+	}
+
+	if (tcp_req->cpl_deferred) {
+		tcp_req->cpl_deferred = false;
+		nvme_tcp_req_complete_recv(tcp_req, &tcp_req->deferred_cpl, &tqpair->ddgst_reaped);
+	}
+}
+
+/* Hand the verification of a received data digest over to the accel functions
+ * of the poll group. The PDU is copied to the request's send_pdu, which is idle
+ * once the command was sent, as the receive PDU is reused right away.
+ */
+static struct spdk_nvme_poll_group *
+nvme_tcp_recv_ddgst_offload(struct nvme_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu)
+{
+	struct spdk_nvme_poll_group *group;
+	struct nvme_tcp_req *tcp_req = pdu->req;
+	struct nvme_tcp_pdu *ddgst_pdu;
+
+	if (pdu->hdr.common.pdu_type != SPDK_NVME_TCP_PDU_TYPE_C2H_DATA || tcp_req == NULL) {
+		return NULL;
+	}
+
+	group = nvme_tcp_qpair_accel_group(tqpair);
+	if (group == NULL || !nvme_tcp_pdu_ddgst_offloadable(pdu) ||
+	    !tcp_req->ordering.send_ack || tcp_req->ddgst_pending) {
+		return NULL;
+	}
+
+	ddgst_pdu = tcp_req->send_pdu;
+	memcpy(&ddgst_pdu->hdr, &pdu->hdr, sizeof(pdu->hdr));
+	memcpy(ddgst_pdu->data_digest, pdu->data_digest, sizeof(pdu->data_digest));
+	memcpy(ddgst_pdu->data_iov, pdu->data_iov, sizeof(pdu->data_iov[0]) * pdu->data_iovcnt);
+	ddgst_pdu->data_iovcnt = pdu->data_iovcnt;
+	ddgst_pdu->data_len = pdu->data_len;
+	ddgst_pdu->dif_ctx = NULL;
+	ddgst_pdu->req = tcp_req;
+
+	tcp_req->ddgst_pending = true;
+	tqpair->ddgst_inflight++;
+
+	return group;
+}
+
 static void
 nvme_tcp_pdu_payload_handle(struct nvme_tcp_qpair *tqpair,
 			    uint32_t *reaped)
 {
 	int rc = 0;
 	struct nvme_tcp_pdu *pdu;
+	struct nvme_tcp_req *ddgst_req = NULL;
+	struct spdk_nvme_poll_group *group = NULL;
 	uint32_t crc32c, error_offset = 0;
 	enum spdk_nvme_tcp_term_req_fes fes;
 
@@ -901,6 +1145,15 @@ nvme_tcp_pdu_payload_handle(struct nvme_tcp_qpair *tqpair,
 
 	/* check data digest if need */
 	if (pdu->ddgst_enable) {
+		group = nvme_tcp_recv_ddgst_offload(tqpair, pdu);
+		if (group != NULL) {
+			/* The PDU is handled right away, a completion of the request is
+			 * deferred until the digest was verified.
+			 */
+			ddgst_req = pdu->req;
+			goto handle;
+		}
+
 		crc32c = nvme_tcp_pdu_calc_data_digest(pdu);
 		rc = MATCH_DIGEST_WORD(pdu->data_digest, crc32c);
 		if (rc == 0) {
@@ -911,6 +1164,7 @@ nvme_tcp_pdu_payload_handle(struct nvme_tcp_qpair *tqpair,
 		}
 	}
 
+handle:
 	switch (pdu->hdr.common.pdu_type) {
 	case SPDK_NVME_TCP_PDU_TYPE_C2H_DATA:
 		nvme_tcp_c2h_data_payload_handle(tqpair, pdu, reaped);
@@ -925,6 +1179,10 @@ nvme_tcp_pdu_payload_handle(struct nvme_tcp_qpair *tqpair,
 		SPDK_ERRLOG("The code should not go to here\n");
 		break;
 	}
+
+	if (ddgst_req != NULL) {
+		nvme_tcp_req_submit_ddgst(group, ddgst_req, nvme_tcp_recv_ddgst_done);
+	}
 }
 
 static void
@@ -1027,13 +1285,7 @@ nvme_tcp_capsule_resp_hdr_handle(struct nvme_tcp_qpair *tqpair, struct nvme_tcp_
 
 	}
 
-	nvme_tcp_req_complete(tcp_req, &cpl);
-	if (tcp_req->ordering.send_ack) {
-		(*reaped)++;
-	}
-
-	tcp_req->ordering.data_recv = 1;
-	nvme_tcp_req_put_safe(tcp_req);
+	nvme_tcp_req_complete_recv(tcp_req, &cpl, reaped);
 
 	SPDK_DEBUGLOG(SPDK_LOG_NVME, "complete tcp_req(%p) on tqpair=%p\n", tcp_req, tqpair);
 
@@ -1171,6 +1423,7 @@ nvme_tcp_send_h2c_data(struct nvme_tcp_req *tcp_req)
 	h2c_data->datal = spdk_min(tcp_req->r2tl_remain, tqpair->maxh2cdata);
 	nvme_tcp_pdu_set_data_buf(rsp_pdu, tcp_req->iov, tcp_req->iovcnt,
 				  h2c_data->datao, h2c_data->datal);
+	rsp_pdu->req = tcp_req;
 	tcp_req->r2tl_remain -= h2c_data->datal;
 
 	if (tqpair->host_hdgst_enable) {
@@ -1325,6 +1578,89 @@ nvme_tcp_pdu_psh_handle(struct nvme_tcp_qpair *tqpair, uint32_t *reaped)
 
 }
 
+/*
+ * Read up to len bytes of PDU header. The bytes are taken from the receive buffer,
+ * which is refilled with a single read of up to NVME_TCP_RECV_BUF_SIZE bytes once
+ * it runs empty.
+ */
+static int
+nvme_tcp_qpair_recv(struct nvme_tcp_qpair *tqpair, uint32_t len, void *buf)
+{
+	uint32_t avail;
+	int rc;
+
+	avail = tqpair->recv_buf_len - tqpair->recv_buf_off;
+	if (avail == 0) {
+		tqpair->stats->recv_syscalls++;
+		rc = nvme_tcp_read_data(tqpair->sock, NVME_TCP_RECV_BUF_SIZE, tqpair->recv_buf);
+		if (rc <= 0) {
+			return rc;
+		}
+
+		tqpair->stats->recv_buffered_bytes += rc;
+		tqpair->recv_buf_off = 0;
+		tqpair->recv_buf_len = rc;
+		avail = rc;
+	}
+
+	len = spdk_min(len, avail);
+	memcpy(buf, tqpair->recv_buf + tqpair->recv_buf_off, len);
+	tqpair->recv_buf_off += len;
+
+	return len;
+}
+
+/*
+ * Read the payload of the current PDU. Payload bytes that were read ahead together
+ * with the headers are copied out of the receive buffer. The rest is read straight
+ * into the request's buffers, with the receive buffer appended to the iovecs to
+ * pick up the headers of the following PDUs in the same syscall.
+ */
+static int
+nvme_tcp_qpair_recv_payload(struct nvme_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu)
+{
+	struct iovec iov[NVME_TCP_MAX_SGL_DESCRIPTORS + 2];
+	uint32_t mapped_length, avail, len;
+	int iovcnt, i, rc;
+
+	iovcnt = nvme_tcp_build_payload_iovs(iov, NVME_TCP_MAX_SGL_DESCRIPTORS + 1, pdu,
+					     pdu->ddgst_enable, &mapped_length);
+	assert(iovcnt > 0);
+
+	avail = tqpair->recv_buf_len - tqpair->recv_buf_off;
+	if (avail > 0) {
+		rc = 0;
+		for (i = 0; i < iovcnt && avail > 0; i++) {
+			len = spdk_min(iov[i].iov_len, avail);
+			memcpy(iov[i].iov_base, tqpair->recv_buf + tqpair->recv_buf_off, len);
+			tqpair->recv_buf_off += len;
+			avail -= len;
+			rc += len;
+		}
+
+		return rc;
+	}
+
+	iov[iovcnt].iov_base = tqpair->recv_buf;
+	iov[iovcnt].iov_len = NVME_TCP_RECV_BUF_SIZE;
+
+	tqpair->stats->recv_syscalls++;
+	rc = nvme_tcp_readv_data(tqpair->sock, iov, iovcnt + 1);
+	if (rc <= 0) {
+		return rc;
+	}
+
+	if ((uint32_t)rc > mapped_length) {
+		tqpair->recv_buf_off = 0;
+		tqpair->recv_buf_len = rc - mapped_length;
+		tqpair->stats->recv_buffered_bytes += tqpair->recv_buf_len;
+		rc = mapped_length;
+	}
+	tqpair->stats->recv_direct_bytes += rc;
+
+	return rc;
+}
+
 static int
 nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped)
 {
@@ -1345,28 +1681,32 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped)
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_CH:
 			pdu = &tqpair->recv_pdu;
 			if (pdu->ch_valid_bytes < sizeof(struct spdk_nvme_tcp_common_pdu_hdr)) {
-				rc = nvme_tcp_read_data(tqpair->sock,
-							sizeof(struct spdk_nvme_tcp_common_pdu_hdr) - pdu->ch_valid_bytes,
-							(uint8_t *)&pdu->hdr.common + pdu->ch_valid_bytes);
+				rc = nvme_tcp_qpair_recv(tqpair,
+							 sizeof(struct spdk_nvme_tcp_common_pdu_hdr) - pdu->ch_valid_bytes,
+							 (uint8_t *)&pdu->hdr.common + pdu->ch_valid_bytes);
 				if (rc < 0) {
 					nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_ERROR);
 					break;
 				}
 				pdu->ch_valid_bytes += rc;
 				if (pdu->ch_valid_bytes < sizeof(struct spdk_nvme_tcp_common_pdu_hdr)) {
+					if (pdu->ch_valid_bytes > 0) {
+						tqpair->stats->recv_partial_reads++;
+					}
 					return NVME_TCP_PDU_IN_PROGRESS;
 				}
 			}
 
 			/* The command header of this PDU has now been read from the socket. */
+			tqpair->stats->recv_pdus++;
 			nvme_tcp_pdu_ch_handle(tqpair);
 			break;
 		/* Wait for the pdu specific header  */
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PSH:
 			pdu = &tqpair->recv_pdu;
-			rc = nvme_tcp_read_data(tqpair->sock,
-						pdu->psh_len - pdu->psh_valid_bytes,
-						(uint8_t *)&pdu->hdr.raw + sizeof(struct spdk_nvme_tcp_common_pdu_hdr) + pdu->psh_valid_bytes);
+			rc = nvme_tcp_qpair_recv(tqpair,
+						 pdu->psh_len - pdu->psh_valid_bytes,
+						 (uint8_t *)&pdu->hdr.raw + sizeof(struct spdk_nvme_tcp_common_pdu_hdr) + pdu->psh_valid_bytes);
 			if (rc < 0) {
 				nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_ERROR);
 				break;
@@ -1374,6 +1714,7 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped)
 
 			pdu->psh_valid_bytes += rc;
 			if (pdu->psh_valid_bytes < pdu->psh_len) {
+				tqpair->stats->recv_partial_reads++;
 				return NVME_TCP_PDU_IN_PROGRESS;
 			}
 
@@ -1395,7 +1736,7 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped)
 				pdu->ddgst_enable = true;
 			}
 
-			rc = nvme_tcp_read_payload_data(tqpair->sock, pdu);
+			rc = nvme_tcp_qpair_recv_payload(tqpair, pdu);
 			if (rc < 0) {
 				nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_ERROR);
 				break;
@@ -1403,6 +1744,7 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped)
 
 			pdu->readv_offset += rc;
 			if (pdu->readv_offset < data_len) {
+				tqpair->stats->recv_partial_reads++;
 				return NVME_TCP_PDU_IN_PROGRESS;
 			}
 
@@ -1493,6 +1835,14 @@ nvme_tcp_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_c
 
 	} while (reaped < max_completions);
 
+	reaped += tqpair->ddgst_reaped;
+	tqpair->ddgst_reaped = 0;
+
+	tqpair->stats->polls++;
+	if (reaped == 0) {
+		tqpair->stats->idle_polls++;
+	}
+
 	if (spdk_unlikely(tqpair->qpair.ctrlr->timeout_enabled)) {
 		nvme_tcp_qpair_check_timeout(qpair);
 	}
@@ -1669,6 +2019,7 @@ nvme_tcp_ctrlr_create_qpair(struct spdk_nvme_ctrlr *ctrlr,
 	}
 
 	tqpair->num_entries = qsize;
+	tqpair->stats = &tqpair->own_stats;
 	qpair = &tqpair->qpair;
 	rc = nvme_qpair_init(qpair, qid, ctrlr, qprio, num_requests);
 	if (rc != 0) {
@@ -1872,6 +2223,8 @@ nvme_tcp_poll_group_add(struct spdk_nvme_transport_poll_group *tgroup,
 	struct nvme_tcp_qpair *tqpair = nvme_tcp_qpair(qpair);
 	struct nvme_tcp_poll_group *group = nvme_tcp_poll_group(tgroup);
 
+	tqpair->stats = &group->stats;
+
 	/* disconnected qpairs won't have a sock to add. */
 	if (nvme_qpair_get_state(qpair) >= NVME_QPAIR_CONNECTED) {
 		if (spdk_sock_group_add_sock(group->sock_group, tqpair->sock, nvme_tcp_qpair_sock_cb, qpair)) {
@@ -1886,6 +2239,10 @@ static int
 nvme_tcp_poll_group_remove(struct spdk_nvme_transport_poll_group *tgroup,
 			   struct spdk_nvme_qpair *qpair)
 {
+	struct nvme_tcp_qpair *tqpair = nvme_tcp_qpair(qpair);
+
+	tqpair->stats = &tqpair->own_stats;
+
 	if (qpair->poll_group_tailq_head == &tgroup->connected_qpairs) {
 		return nvme_poll_group_disconnect_qpair(qpair);
 	}
@@ -1899,12 +2256,24 @@ nvme_tcp_poll_group_process_completions(struct spdk_nvme_transport_poll_group *t
 {
 	struct nvme_tcp_poll_group *group = nvme_tcp_poll_group(tgroup);
 	struct spdk_nvme_qpair *qpair, *tmp_qpair;
+	struct nvme_tcp_qpair *tqpair;
 
 	group->completions_per_qpair = completions_per_qpair;
 	group->num_completions = 0;
 
 	spdk_sock_group_poll(group->sock_group);
 
+	/*
+	 * A qpair that hit completions_per_qpair may have PDUs left in its receive
+	 * buffer. The socket won't report them as readable, so poll those directly.
+	 */
+	STAILQ_FOREACH_SAFE(qpair, &tgroup->connected_qpairs, poll_group_stailq, tmp_qpair) {
+		tqpair = nvme_tcp_qpair(qpair);
+		if (tqpair->recv_buf_off < tqpair->recv_buf_len) {
+			nvme_tcp_qpair_sock_cb(qpair, group->sock_group, tqpair->sock);
+		}
+	}
+
 	STAILQ_FOREACH_SAFE(qpair, &tgroup->disconnected_qpairs, poll_group_stailq, tmp_qpair) {
 		disconnected_qpair_cb(qpair, tgroup->group->ctx);
 	}
@@ -1933,6 +2302,17 @@ nvme_tcp_poll_group_destroy(struct spdk_nvme_transport_poll_group *tgroup)
 	return 0;
 }
 
+static int
+nvme_tcp_poll_group_get_stats(struct spdk_nvme_transport_poll_group *tgroup,
+			      struct spdk_nvme_transport_poll_group_stat *stat)
+{
+	struct nvme_tcp_poll_group *group = nvme_tcp_poll_group(tgroup);
+
+	memcpy(&stat->u.tcp, &group->stats, sizeof(group->stats));
+
+	return 0;
+}
+
 const struct spdk_nvme_transport_ops tcp_ops = {
 	.name = "TCP",
 	.type = SPDK_NVME_TRANSPORT_TCP,
@@ -1968,6 +2348,7 @@ const struct spdk_nvme_transport_ops tcp_ops = {
 	.poll_group_remove = nvme_tcp_poll_group_remove,
 	.poll_group_process_completions = nvme_tcp_poll_group_process_completions,
 	.poll_group_destroy = nvme_tcp_poll_group_destroy,
+	.poll_group_get_stats = nvme_tcp_poll_group_get_stats,
 };
 
 SPDK_NVME_TRANSPORT_REGISTER(tcp, &tcp_ops);
@@ -524,6 +524,18 @@ nvme_transport_poll_group_destroy(struct spdk_nvme_transport_poll_group *tgroup)
 	return tgroup->transport->ops.poll_group_destroy(tgroup);
 }
 
+int
+nvme_transport_poll_group_get_stats(struct spdk_nvme_transport_poll_group *tgroup,
+				    struct spdk_nvme_transport_poll_group_stat *stat)
+{
+	if (tgroup->transport->ops.poll_group_get_stats == NULL) {
+		return -ENOTSUP;
+	}
+
+	stat->trtype = tgroup->transport->ops.type;
+	return tgroup->transport->ops.poll_group_get_stats(tgroup, stat);
+}
+
 int
 nvme_transport_poll_group_disconnect_qpair(struct spdk_nvme_qpair *qpair)
 {
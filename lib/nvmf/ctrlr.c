@@ -368,7 +368,8 @@ nvmf_ctrlr_create(struct spdk_nvmf_subsystem *subsystem,
 	ctrlr->vcprop.cap.bits.ams = 0; /* optional arb mechanisms */
 	ctrlr->vcprop.cap.bits.to = 1; /* ready timeout - 500 msec units */
 	ctrlr->vcprop.cap.bits.dstrd = 0; /* fixed to 0 for NVMe-oF */
-	ctrlr->vcprop.cap.bits.css = SPDK_NVME_CAP_CSS_NVM; /* NVM command set */
+	/* NVM command set, or the I/O command sets reported by each namespace */
+	ctrlr->vcprop.cap.bits.css = SPDK_NVME_CAP_CSS_NVM | SPDK_NVME_CAP_CSS_IOCS;
 	ctrlr->vcprop.cap.bits.mpsmin = 0; /* 2 ^ (12 + mpsmin) == 4k */
 	ctrlr->vcprop.cap.bits.mpsmax = 0; /* 2 ^ (12 + mpsmax) == 4k */
 
@@ -836,8 +837,14 @@ nvmf_prop_set_cc(struct spdk_nvmf_ctrlr *ctrlr, uint32_t value)
 	}
 
 	if (diff.bits.css) {
-		SPDK_ERRLOG("I/O Command Set Selected (CSS) 0x%x not supported!\n", cc.bits.css);
-		return false;
+		if (cc.bits.css != SPDK_NVME_CC_CSS_NVM && cc.bits.css != SPDK_NVME_CC_CSS_IOCS) {
+			SPDK_ERRLOG("I/O Command Set Selected (CSS) 0x%x not supported!\n",
+				    cc.bits.css);
+			return false;
+		}
+		SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Prop Set CSS = 0x%x\n", cc.bits.css);
+		ctrlr->vcprop.cc.bits.css = cc.bits.css;
+		diff.bits.css = 0;
 	}
 
 	if (diff.raw != 0) {
@@ -1623,6 +1630,12 @@ static const struct spdk_nvme_cmds_and_effect_log_page g_cmds_and_effect_log_pag
 		[SPDK_NVME_OPC_DATASET_MANAGEMENT]	= {1, 1, 0, 0, 0, 0, 0, 0},
 		/* COMPARE */
 		[SPDK_NVME_OPC_COMPARE]			= {1, 0, 0, 0, 0, 0, 0, 0},
+		/* ZONE MANAGEMENT SEND */
+		[SPDK_NVME_OPC_ZONE_MGMT_SEND]		= {1, 1, 0, 0, 0, 0, 0, 0},
+		/* ZONE MANAGEMENT RECEIVE */
+		[SPDK_NVME_OPC_ZONE_MGMT_RECV]		= {1, 0, 0, 0, 0, 0, 0, 0},
+		/* ZONE APPEND */
+		[SPDK_NVME_OPC_ZONE_APPEND]		= {1, 1, 0, 0, 0, 0, 0, 0},
 	},
 };
 
@@ -1809,6 +1822,79 @@ spdk_nvmf_ctrlr_identify_ns(struct spdk_nvmf_ctrlr *ctrlr,
 	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 }
 
+static int
+nvmf_ctrlr_identify_iocs_specific_ns(struct spdk_nvmf_ctrlr *ctrlr,
+				     struct spdk_nvme_cmd *cmd,
+				     struct spdk_nvme_cpl *rsp,
+				     void *nsdata)
+{
+	struct spdk_nvmf_subsystem *subsystem = ctrlr->subsys;
+	struct spdk_nvmf_ns *ns;
+	uint8_t csi = cmd->cdw11_bits.identify.csi;
+
+	if (cmd->nsid == 0 || cmd->nsid > subsystem->max_nsid) {
+		SPDK_ERRLOG("Identify Namespace for invalid NSID %u\n", cmd->nsid);
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INVALID_NAMESPACE_OR_FORMAT;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	ns = _nvmf_subsystem_get_ns(subsystem, cmd->nsid);
+	if (ns == NULL || ns->bdev == NULL) {
+		/* Zero filled, like the Identify Namespace data of an inactive namespace */
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_SUCCESS;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	switch (csi) {
+	case SPDK_NVME_CSI_NVM:
+		/* No NVM command set specific fields are reported */
+		break;
+	case SPDK_NVME_CSI_ZNS:
+		if (!nvmf_bdev_ctrlr_ns_is_zoned(ns)) {
+			goto invalid_iocs;
+		}
+		nvmf_bdev_ctrlr_identify_zns_ns(ns, nsdata);
+		break;
+	default:
+		goto invalid_iocs;
+	}
+
+	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+
+invalid_iocs:
+	SPDK_DEBUGLOG(SPDK_LOG_NVMF, "NSID %u does not support CSI 0x%x\n", cmd->nsid, csi);
+	rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+	rsp->status.sc = SPDK_NVME_SC_INVALID_IOCS;
+	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+}
+
+static int
+nvmf_ctrlr_identify_iocs_specific_ctrlr(struct spdk_nvmf_ctrlr *ctrlr,
+					struct spdk_nvme_cmd *cmd,
+					struct spdk_nvme_cpl *rsp,
+					void *cdata)
+{
+	struct spdk_nvme_zns_ctrlr_data *cdata_zns;
+
+	switch (cmd->cdw11_bits.identify.csi) {
+	case SPDK_NVME_CSI_NVM:
+		break;
+	case SPDK_NVME_CSI_ZNS:
+		cdata_zns = cdata;
+		/* The zone append size limit is MDTS */
+		cdata_zns->zasl = 0;
+		break;
+	default:
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INVALID_IOCS;
+		break;
+	}
+
+	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+}
+
 static void
 nvmf_ctrlr_populate_oacs(struct spdk_nvmf_ctrlr *ctrlr,
 			 struct spdk_nvme_ctrlr_data *cdata)
@@ -1980,6 +2066,7 @@ nvmf_ctrlr_identify_ns_id_descriptor_list(
 	struct spdk_nvmf_ns *ns;
 	size_t buf_remain = id_desc_list_size;
 	void *buf_ptr = id_desc_list;
+	uint8_t csi;
 
 	ns = _nvmf_subsystem_get_ns(subsystem, cmd->nsid);
 	if (ns == NULL || ns->bdev == NULL) {
@@ -1999,6 +2086,10 @@ nvmf_ctrlr_identify_ns_id_descriptor_list(
 	ADD_ID_DESC(SPDK_NVME_NIDT_NGUID, ns->opts.nguid, sizeof(ns->opts.nguid));
 	ADD_ID_DESC(SPDK_NVME_NIDT_UUID, &ns->opts.uuid, sizeof(ns->opts.uuid));
 
+	/* Hosts assume the NVM command set when there is no CSI descriptor */
+	csi = nvmf_bdev_ctrlr_ns_is_zoned(ns) ? SPDK_NVME_CSI_ZNS : SPDK_NVME_CSI_NVM;
+	ADD_ID_DESC(SPDK_NVME_NIDT_CSI, &csi, sizeof(csi));
+
 	/*
 	 * The list is automatically 0-terminated because controller to host buffers in
 	 * admin commands always get zeroed in nvmf_ctrlr_process_admin_cmd().
@@ -2042,6 +2133,10 @@ nvmf_ctrlr_identify(struct spdk_nvmf_request *req)
 		return nvmf_ctrlr_identify_active_ns_list(subsystem, cmd, rsp, req->data);
 	case SPDK_NVME_IDENTIFY_NS_ID_DESCRIPTOR_LIST:
 		return nvmf_ctrlr_identify_ns_id_descriptor_list(subsystem, cmd, rsp, req->data, req->length);
+	case SPDK_NVME_IDENTIFY_NS_IOCS:
+		return nvmf_ctrlr_identify_iocs_specific_ns(ctrlr, cmd, rsp, req->data);
+	case SPDK_NVME_IDENTIFY_CTRLR_IOCS:
+		return nvmf_ctrlr_identify_iocs_specific_ctrlr(ctrlr, cmd, rsp, req->data);
 	default:
 		goto invalid_cns;
 	}
@@ -2656,6 +2751,7 @@ nvmf_ns_reservation_request_check(struct spdk_nvmf_subsystem_pg_ns_info *ns_info
 	switch (cmd->opc) {
 	case SPDK_NVME_OPC_READ:
 	case SPDK_NVME_OPC_COMPARE:
+	case SPDK_NVME_OPC_ZONE_MGMT_RECV:
 		if (rtype == SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS) {
 			status = SPDK_NVME_SC_RESERVATION_CONFLICT;
 			goto exit;
@@ -2670,6 +2766,8 @@ nvmf_ns_reservation_request_check(struct spdk_nvmf_subsystem_pg_ns_info *ns_info
 	case SPDK_NVME_OPC_WRITE_UNCORRECTABLE:
 	case SPDK_NVME_OPC_WRITE_ZEROES:
 	case SPDK_NVME_OPC_DATASET_MANAGEMENT:
+	case SPDK_NVME_OPC_ZONE_MGMT_SEND:
+	case SPDK_NVME_OPC_ZONE_APPEND:
 		if (rtype == SPDK_NVME_RESERVE_WRITE_EXCLUSIVE ||
 		    rtype == SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS) {
 			status = SPDK_NVME_SC_RESERVATION_CONFLICT;
@@ -2868,6 +2966,12 @@ nvmf_ctrlr_process_io_cmd(struct spdk_nvmf_request *req)
 		return nvmf_bdev_ctrlr_flush_cmd(bdev, desc, ch, req);
 	case SPDK_NVME_OPC_DATASET_MANAGEMENT:
 		return nvmf_bdev_ctrlr_dsm_cmd(bdev, desc, ch, req);
+	case SPDK_NVME_OPC_ZONE_APPEND:
+		return nvmf_bdev_ctrlr_zone_append_cmd(bdev, desc, ch, req);
+	case SPDK_NVME_OPC_ZONE_MGMT_SEND:
+		return nvmf_bdev_ctrlr_zone_mgmt_send_cmd(bdev, desc, ch, req);
+	case SPDK_NVME_OPC_ZONE_MGMT_RECV:
+		return nvmf_bdev_ctrlr_zone_mgmt_recv_cmd(bdev, desc, ch, req);
 	case SPDK_NVME_OPC_RESERVATION_REGISTER:
 	case SPDK_NVME_OPC_RESERVATION_ACQUIRE:
 	case SPDK_NVME_OPC_RESERVATION_RELEASE:
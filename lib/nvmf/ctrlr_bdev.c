@@ -36,6 +36,7 @@
 #include "nvmf_internal.h"
 
 #include "spdk/bdev.h"
+#include "spdk/bdev_zone.h"
 #include "spdk/endian.h"
 #include "spdk/thread.h"
 #include "spdk/likely.h"
@@ -87,6 +88,12 @@ nvmf_ctrlr_write_zeroes_supported(struct spdk_nvmf_ctrlr *ctrlr)
 	return nvmf_subsystem_bdev_io_type_supported(ctrlr->subsys, SPDK_BDEV_IO_TYPE_WRITE_ZEROES);
 }
 
+bool
+nvmf_bdev_ctrlr_ns_is_zoned(struct spdk_nvmf_ns *ns)
+{
+	return spdk_bdev_is_zoned(ns->bdev);
+}
+
 static void
 nvmf_bdev_ctrlr_complete_cmd(struct spdk_bdev_io *bdev_io, bool success,
 			     void *cb_arg)
@@ -201,6 +208,20 @@ nvmf_bdev_ctrlr_identify_ns(struct spdk_nvmf_ns *ns, struct spdk_nvme_ns_data *n
 	memcpy(&nsdata->eui64, ns->opts.eui64, sizeof(nsdata->eui64));
 }
 
+void
+nvmf_bdev_ctrlr_identify_zns_ns(struct spdk_nvmf_ns *ns, struct spdk_nvme_zns_ns_data *nsdata_zns)
+{
+	struct spdk_bdev *bdev = ns->bdev;
+	uint32_t max_open_zones = spdk_bdev_get_max_open_zones(bdev);
+
+	assert(spdk_bdev_is_zoned(bdev));
+
+	/* The bdev layer has no notion of active zones, only of open ones */
+	nsdata_zns->mar = UINT32_MAX;
+	nsdata_zns->mor = max_open_zones != 0 ? max_open_zones - 1 : UINT32_MAX;
+	nsdata_zns->lbafe[0].zsze = spdk_bdev_get_zone_size(bdev);
+}
+
 static void
 nvmf_bdev_ctrlr_get_rw_params(const struct spdk_nvme_cmd *cmd, uint64_t *start_lba,
 			      uint64_t *num_blocks)
@@ -648,6 +669,548 @@ nvmf_bdev_ctrlr_dsm_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 }
 
+static void
+nvmf_bdev_ctrlr_complete_zone_append_cmd(struct spdk_bdev_io *bdev_io, bool success,
+					 void *cb_arg)
+{
+	struct spdk_nvmf_request	*req = cb_arg;
+	struct spdk_nvme_cpl		*response = &req->rsp->nvme_cpl;
+	int				sc = 0, sct = 0;
+	uint32_t			cdw0 = 0;
+	uint64_t			alba;
+
+	spdk_bdev_io_get_nvme_status(bdev_io, &cdw0, &sct, &sc);
+
+	if (success) {
+		/* Assigned LBA: CDW0 and DW1 */
+		alba = spdk_bdev_io_get_append_location(bdev_io);
+		response->cdw0 = (uint32_t)alba;
+		response->rsvd1 = (uint32_t)(alba >> 32);
+	} else {
+		response->cdw0 = cdw0;
+	}
+	response->status.sc = sc;
+	response->status.sct = sct;
+
+	spdk_nvmf_request_complete(req);
+	spdk_bdev_free_io(bdev_io);
+}
+
+int
+nvmf_bdev_ctrlr_zone_append_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+				struct spdk_io_channel *ch, struct spdk_nvmf_request *req)
+{
+	uint64_t bdev_num_blocks = spdk_bdev_get_num_blocks(bdev);
+	uint32_t block_size = spdk_bdev_get_block_size(bdev);
+	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
+	struct spdk_nvme_cpl *rsp = &req->rsp->nvme_cpl;
+	uint64_t zslba;
+	uint64_t num_blocks;
+	int rc;
+
+	if (spdk_unlikely(!spdk_bdev_is_zoned(bdev))) {
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INVALID_OPCODE;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	/* ZSLBA and NLB are placed like SLBA and NLB of a write */
+	nvmf_bdev_ctrlr_get_rw_params(cmd, &zslba, &num_blocks);
+
+	if (spdk_unlikely(!nvmf_bdev_ctrlr_lba_in_range(bdev_num_blocks, zslba, num_blocks))) {
+		SPDK_ERRLOG("end of media\n");
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_LBA_OUT_OF_RANGE;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	if (spdk_unlikely(zslba % spdk_bdev_get_zone_size(bdev) != 0)) {
+		SPDK_ERRLOG("Zone Append ZSLBA 0x%" PRIx64 " is not the start of a zone\n", zslba);
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INVALID_FIELD;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	if (spdk_unlikely(num_blocks * block_size > req->length)) {
+		SPDK_ERRLOG("Zone Append NLB %" PRIu64 " * block size %" PRIu32
+			    " > SGL length %" PRIu32 "\n", num_blocks, block_size, req->length);
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_DATA_SGL_LENGTH_INVALID;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	rc = spdk_bdev_zone_appendv(desc, ch, req->iov, req->iovcnt, zslba, num_blocks,
+				    nvmf_bdev_ctrlr_complete_zone_append_cmd, req);
+	if (spdk_unlikely(rc)) {
+		if (rc == -ENOMEM) {
+			nvmf_bdev_ctrl_queue_io(req, bdev, ch, nvmf_ctrlr_process_io_cmd_resubmit, req);
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+		}
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+}
+
+struct nvmf_bdev_ctrlr_zone_reset_all {
+	struct spdk_nvmf_request	*req;
+	struct spdk_bdev_desc		*desc;
+	struct spdk_bdev		*bdev;
+	struct spdk_io_channel		*ch;
+	uint64_t			zone_id;
+};
+
+static int nvmf_bdev_ctrlr_zone_reset_all_submit(struct nvmf_bdev_ctrlr_zone_reset_all *ctx);
+
+static void
+nvmf_bdev_ctrlr_zone_reset_all_cpl(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct nvmf_bdev_ctrlr_zone_reset_all *ctx = cb_arg;
+	struct spdk_nvmf_request *req = ctx->req;
+	struct spdk_nvme_cpl *response = &req->rsp->nvme_cpl;
+	int sc = 0, sct = 0;
+	uint32_t cdw0 = 0;
+
+	if (!success) {
+		spdk_bdev_io_get_nvme_status(bdev_io, &cdw0, &sct, &sc);
+		response->cdw0 = cdw0;
+		response->status.sc = sc;
+		response->status.sct = sct;
+		goto complete;
+	}
+
+	ctx->zone_id += spdk_bdev_get_zone_size(ctx->bdev);
+	if (ctx->zone_id < spdk_bdev_get_num_blocks(ctx->bdev)) {
+		if (nvmf_bdev_ctrlr_zone_reset_all_submit(ctx) == 0) {
+			spdk_bdev_free_io(bdev_io);
+			return;
+		}
+		response->status.sct = SPDK_NVME_SCT_GENERIC;
+		response->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+	}
+
+complete:
+	spdk_nvmf_request_complete(req);
+	spdk_bdev_free_io(bdev_io);
+	free(ctx);
+}
+
+static void
+nvmf_bdev_ctrlr_zone_reset_all_resubmit(void *arg)
+{
+	struct nvmf_bdev_ctrlr_zone_reset_all *ctx = arg;
+	struct spdk_nvmf_request *req = ctx->req;
+
+	if (nvmf_bdev_ctrlr_zone_reset_all_submit(ctx) != 0) {
+		req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		spdk_nvmf_request_complete(req);
+		free(ctx);
+	}
+}
+
+/* The zones are reset one at a time, a reset of all zones is rare enough not to bother. */
+static int
+nvmf_bdev_ctrlr_zone_reset_all_submit(struct nvmf_bdev_ctrlr_zone_reset_all *ctx)
+{
+	int rc;
+
+	rc = spdk_bdev_zone_management(ctx->desc, ctx->ch, ctx->zone_id, SPDK_BDEV_ZONE_RESET,
+				       nvmf_bdev_ctrlr_zone_reset_all_cpl, ctx);
+	if (rc == -ENOMEM) {
+		nvmf_bdev_ctrl_queue_io(ctx->req, ctx->bdev, ctx->ch,
+					nvmf_bdev_ctrlr_zone_reset_all_resubmit, ctx);
+		return 0;
+	}
+
+	return rc;
+}
+
+static int
+nvmf_bdev_ctrlr_zone_reset_all(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+			       struct spdk_io_channel *ch, struct spdk_nvmf_request *req)
+{
+	struct spdk_nvme_cpl *response = &req->rsp->nvme_cpl;
+	struct nvmf_bdev_ctrlr_zone_reset_all *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		response->status.sct = SPDK_NVME_SCT_GENERIC;
+		response->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	ctx->req = req;
+	ctx->desc = desc;
+	ctx->bdev = bdev;
+	ctx->ch = ch;
+
+	if (nvmf_bdev_ctrlr_zone_reset_all_submit(ctx) != 0) {
+		free(ctx);
+		response->status.sct = SPDK_NVME_SCT_GENERIC;
+		response->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+}
+
+int
+nvmf_bdev_ctrlr_zone_mgmt_send_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+				   struct spdk_io_channel *ch, struct spdk_nvmf_request *req)
+{
+	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
+	struct spdk_nvme_cpl *rsp = &req->rsp->nvme_cpl;
+	enum spdk_bdev_zone_action action;
+	uint64_t zslba;
+	uint32_t cdw13;
+	uint8_t zsa;
+	bool select_all;
+	int rc;
+
+	if (spdk_unlikely(!spdk_bdev_is_zoned(bdev))) {
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INVALID_OPCODE;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	/* SLBA: CDW10 and CDW11 */
+	zslba = from_le64(&cmd->cdw10);
+
+	/* Zone Send Action: CDW13 bits 07:00, Select All: CDW13 bit 08 */
+	cdw13 = from_le32(&cmd->cdw13);
+	zsa = cdw13 & 0xFFu;
+	select_all = (cdw13 >> 8) & 0x1u;
+
+	switch (zsa) {
+	case SPDK_NVME_ZONE_CLOSE:
+		action = SPDK_BDEV_ZONE_CLOSE;
+		break;
+	case SPDK_NVME_ZONE_FINISH:
+		action = SPDK_BDEV_ZONE_FINISH;
+		break;
+	case SPDK_NVME_ZONE_OPEN:
+		action = SPDK_BDEV_ZONE_OPEN;
+		break;
+	case SPDK_NVME_ZONE_RESET:
+		action = SPDK_BDEV_ZONE_RESET;
+		break;
+	default:
+		SPDK_ERRLOG("Unsupported Zone Send Action 0x%x\n", zsa);
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INVALID_FIELD;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	if (select_all) {
+		/* Only the reset applies to every zone no matter its state */
+		if (action != SPDK_BDEV_ZONE_RESET) {
+			SPDK_ERRLOG("Select All is only supported for Reset Zone\n");
+			rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+			rsp->status.sc = SPDK_NVME_SC_INVALID_FIELD;
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+		}
+
+		return nvmf_bdev_ctrlr_zone_reset_all(bdev, desc, ch, req);
+	}
+
+	if (spdk_unlikely(zslba >= spdk_bdev_get_num_blocks(bdev))) {
+		SPDK_ERRLOG("end of media\n");
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_LBA_OUT_OF_RANGE;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	if (spdk_unlikely(zslba % spdk_bdev_get_zone_size(bdev) != 0)) {
+		SPDK_ERRLOG("Zone Management Send SLBA 0x%" PRIx64 " is not the start of a zone\n",
+			    zslba);
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INVALID_FIELD;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	rc = spdk_bdev_zone_management(desc, ch, zslba, action, nvmf_bdev_ctrlr_complete_cmd, req);
+	if (spdk_unlikely(rc)) {
+		if (rc == -ENOMEM) {
+			nvmf_bdev_ctrl_queue_io(req, bdev, ch, nvmf_ctrlr_process_io_cmd_resubmit, req);
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+		}
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+}
+
+/* Number of zones asked from the bdev at once while building a zone report */
+#define NVMF_ZONE_REPORT_BATCH	64
+
+struct nvmf_bdev_ctrlr_zone_report {
+	struct spdk_nvmf_request		*req;
+	struct spdk_bdev_desc			*desc;
+	struct spdk_bdev			*bdev;
+	struct spdk_io_channel			*ch;
+	struct spdk_nvme_zns_zone_report	*report;
+	uint32_t				report_len;
+	uint32_t				max_descs;
+	uint64_t				zone_id;
+	uint8_t					filter;
+	bool					partial;
+	size_t					num_info;
+	struct spdk_bdev_zone_info		info[NVMF_ZONE_REPORT_BATCH];
+};
+
+static enum spdk_nvme_zns_zone_state
+nvmf_bdev_ctrlr_zone_state(enum spdk_bdev_zone_state state)
+{
+	switch (state) {
+	case SPDK_BDEV_ZONE_STATE_EMPTY:
+		return SPDK_NVME_ZONE_STATE_EMPTY;
+	case SPDK_BDEV_ZONE_STATE_OPEN:
+		/* The bdev layer does not tell implicitly and explicitly opened zones apart */
+		return SPDK_NVME_ZONE_STATE_IOPEN;
+	case SPDK_BDEV_ZONE_STATE_FULL:
+		return SPDK_NVME_ZONE_STATE_FULL;
+	case SPDK_BDEV_ZONE_STATE_CLOSED:
+		return SPDK_NVME_ZONE_STATE_CLOSED;
+	case SPDK_BDEV_ZONE_STATE_READ_ONLY:
+		return SPDK_NVME_ZONE_STATE_RONLY;
+	case SPDK_BDEV_ZONE_STATE_OFFLINE:
+	default:
+		return SPDK_NVME_ZONE_STATE_OFFLINE;
+	}
+}
+
+static bool
+nvmf_bdev_ctrlr_zone_state_matches(enum spdk_nvme_zns_zone_state state, uint8_t filter)
+{
+	switch (filter) {
+	case SPDK_NVME_ZRA_LIST_ALL:
+		return true;
+	case SPDK_NVME_ZRA_LIST_ZSE:
+		return state == SPDK_NVME_ZONE_STATE_EMPTY;
+	case SPDK_NVME_ZRA_LIST_ZSIO:
+		return state == SPDK_NVME_ZONE_STATE_IOPEN;
+	case SPDK_NVME_ZRA_LIST_ZSEO:
+		return state == SPDK_NVME_ZONE_STATE_EOPEN;
+	case SPDK_NVME_ZRA_LIST_ZSC:
+		return state == SPDK_NVME_ZONE_STATE_CLOSED;
+	case SPDK_NVME_ZRA_LIST_ZSF:
+		return state == SPDK_NVME_ZONE_STATE_FULL;
+	case SPDK_NVME_ZRA_LIST_ZSRO:
+		return state == SPDK_NVME_ZONE_STATE_RONLY;
+	case SPDK_NVME_ZRA_LIST_ZSO:
+		return state == SPDK_NVME_ZONE_STATE_OFFLINE;
+	default:
+		return false;
+	}
+}
+
+static void
+nvmf_bdev_ctrlr_zone_report_free(struct nvmf_bdev_ctrlr_zone_report *ctx)
+{
+	free(ctx->report);
+	free(ctx);
+}
+
+static int nvmf_bdev_ctrlr_zone_report_submit(struct nvmf_bdev_ctrlr_zone_report *ctx);
+
+static void
+nvmf_bdev_ctrlr_zone_report_cpl(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct nvmf_bdev_ctrlr_zone_report *ctx = cb_arg;
+	struct spdk_nvme_zns_zone_report *report = ctx->report;
+	struct spdk_nvmf_request *req = ctx->req;
+	struct spdk_nvme_cpl *response = &req->rsp->nvme_cpl;
+	struct spdk_nvme_zns_zone_desc *zdesc;
+	enum spdk_nvme_zns_zone_state state;
+	struct iovec iov;
+	int sc = 0, sct = 0;
+	uint32_t cdw0 = 0;
+	size_t i;
+
+	if (!success) {
+		spdk_bdev_io_get_nvme_status(bdev_io, &cdw0, &sct, &sc);
+		response->cdw0 = cdw0;
+		response->status.sc = sc;
+		response->status.sct = sct;
+		goto complete;
+	}
+
+	for (i = 0; i < ctx->num_info; i++) {
+		if (ctx->partial && report->nr_zones == ctx->max_descs) {
+			break;
+		}
+
+		state = nvmf_bdev_ctrlr_zone_state(ctx->info[i].state);
+		if (!nvmf_bdev_ctrlr_zone_state_matches(state, ctx->filter)) {
+			continue;
+		}
+
+		/* Without Partial Report, zones that do not fit are still counted */
+		if (report->nr_zones < ctx->max_descs) {
+			zdesc = &report->descs[report->nr_zones];
+			zdesc->zt = SPDK_NVME_ZONE_TYPE_SEQWR;
+			zdesc->zs = state;
+			zdesc->zcap = ctx->info[i].capacity;
+			zdesc->zslba = ctx->info[i].zone_id;
+			zdesc->wp = ctx->info[i].write_pointer;
+		}
+		report->nr_zones++;
+	}
+
+	ctx->zone_id += ctx->num_info * spdk_bdev_get_zone_size(ctx->bdev);
+	if (ctx->zone_id < spdk_bdev_get_num_blocks(ctx->bdev) &&
+	    !(ctx->partial && report->nr_zones == ctx->max_descs)) {
+		if (nvmf_bdev_ctrlr_zone_report_submit(ctx) == 0) {
+			spdk_bdev_free_io(bdev_io);
+			return;
+		}
+		response->status.sct = SPDK_NVME_SCT_GENERIC;
+		response->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		goto complete;
+	}
+
+	iov.iov_base = report;
+	iov.iov_len = ctx->report_len;
+	spdk_iovcpy(&iov, 1, req->iov, req->iovcnt);
+
+complete:
+	spdk_nvmf_request_complete(req);
+	spdk_bdev_free_io(bdev_io);
+	nvmf_bdev_ctrlr_zone_report_free(ctx);
+}
+
+static void
+nvmf_bdev_ctrlr_zone_report_resubmit(void *arg)
+{
+	struct nvmf_bdev_ctrlr_zone_report *ctx = arg;
+	struct spdk_nvmf_request *req = ctx->req;
+
+	if (nvmf_bdev_ctrlr_zone_report_submit(ctx) != 0) {
+		req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		spdk_nvmf_request_complete(req);
+		nvmf_bdev_ctrlr_zone_report_free(ctx);
+	}
+}
+
+static int
+nvmf_bdev_ctrlr_zone_report_submit(struct nvmf_bdev_ctrlr_zone_report *ctx)
+{
+	uint64_t num_zones;
+	int rc;
+
+	num_zones = (spdk_bdev_get_num_blocks(ctx->bdev) - ctx->zone_id) /
+		    spdk_bdev_get_zone_size(ctx->bdev);
+	ctx->num_info = spdk_min(num_zones, NVMF_ZONE_REPORT_BATCH);
+
+	rc = spdk_bdev_get_zone_info(ctx->desc, ctx->ch, ctx->zone_id, ctx->num_info, ctx->info,
+				     nvmf_bdev_ctrlr_zone_report_cpl, ctx);
+	if (rc == -ENOMEM) {
+		nvmf_bdev_ctrl_queue_io(ctx->req, ctx->bdev, ctx->ch,
+					nvmf_bdev_ctrlr_zone_report_resubmit, ctx);
+		return 0;
+	}
+
+	return rc;
+}
+
+int
+nvmf_bdev_ctrlr_zone_mgmt_recv_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+				   struct spdk_io_channel *ch, struct spdk_nvmf_request *req)
+{
+	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
+	struct spdk_nvme_cpl *rsp = &req->rsp->nvme_cpl;
+	struct nvmf_bdev_ctrlr_zone_report *ctx;
+	uint64_t slba, zone_size, len;
+	uint32_t cdw13;
+	uint8_t zra, filter;
+
+	if (spdk_unlikely(!spdk_bdev_is_zoned(bdev))) {
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INVALID_OPCODE;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	/* SLBA: CDW10 and CDW11 */
+	slba = from_le64(&cmd->cdw10);
+
+	/* NUMD: CDW12, 0's based */
+	len = ((uint64_t)from_le32(&cmd->cdw12) + 1) * sizeof(uint32_t);
+
+	/* Zone Receive Action: CDW13 bits 07:00, its specific field: bits 15:08,
+	 * Partial Report: bit 16 */
+	cdw13 = from_le32(&cmd->cdw13);
+	zra = cdw13 & 0xFFu;
+	filter = (cdw13 >> 8) & 0xFFu;
+
+	/* There are no zone descriptor extensions, so no extended report either */
+	if (zra != SPDK_NVME_ZONE_REPORT || filter > SPDK_NVME_ZRA_LIST_ZSO) {
+		SPDK_ERRLOG("Unsupported Zone Receive Action 0x%x (0x%x)\n", zra, filter);
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INVALID_FIELD;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	if (spdk_unlikely(slba >= spdk_bdev_get_num_blocks(bdev))) {
+		SPDK_ERRLOG("end of media\n");
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_LBA_OUT_OF_RANGE;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	if (spdk_unlikely(len > req->length || len < sizeof(struct spdk_nvme_zns_zone_report))) {
+		SPDK_ERRLOG("Zone Management Receive length %" PRIu64 " invalid, SGL length %"
+			    PRIu32 "\n", len, req->length);
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_DATA_SGL_LENGTH_INVALID;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	/* The host buffer may be scattered, so the report is built in a contiguous one */
+	ctx->report = calloc(1, len);
+	if (!ctx->report) {
+		free(ctx);
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	zone_size = spdk_bdev_get_zone_size(bdev);
+
+	ctx->req = req;
+	ctx->desc = desc;
+	ctx->bdev = bdev;
+	ctx->ch = ch;
+	ctx->report_len = len;
+	ctx->max_descs = (len - sizeof(struct spdk_nvme_zns_zone_report)) /
+			 sizeof(struct spdk_nvme_zns_zone_desc);
+	/* The report starts with the zone containing SLBA */
+	ctx->zone_id = slba / zone_size * zone_size;
+	ctx->filter = filter;
+	ctx->partial = (cdw13 >> 16) & 0x1u;
+
+	if (nvmf_bdev_ctrlr_zone_report_submit(ctx) != 0) {
+		nvmf_bdev_ctrlr_zone_report_free(ctx);
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+}
+
 int
 nvmf_bdev_ctrlr_nvme_passthru_io(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 				 struct spdk_io_channel *ch, struct spdk_nvmf_request *req)
@@ -104,7 +104,7 @@ BDEV_DEPS_THREAD = $(BDEV_DEPS) thread
 BDEV_DEPS_CONF_THREAD = $(BDEV_DEPS) conf thread
 
 # module/blob
-DEPDIRS-blob_bdev := log thread bdev
+DEPDIRS-blob_bdev := log thread bdev accel
 
 # module/blobfs
 DEPDIRS-blobfs_bdev := $(BDEV_DEPS_THREAD) blob_bdev blobfs
@@ -142,7 +142,7 @@ DEPDIRS-bdev_aio := $(BDEV_DEPS_CONF_THREAD)
 DEPDIRS-bdev_crypto := $(BDEV_DEPS_CONF_THREAD)
 DEPDIRS-bdev_iscsi := $(BDEV_DEPS_CONF_THREAD)
 DEPDIRS-bdev_null := $(BDEV_DEPS_CONF_THREAD)
-DEPDIRS-bdev_nvme = $(BDEV_DEPS_CONF_THREAD) nvme
+DEPDIRS-bdev_nvme = $(BDEV_DEPS_CONF_THREAD) accel nvme
 DEPDIRS-bdev_ocf := $(BDEV_DEPS_CONF_THREAD)
 DEPDIRS-bdev_passthru := $(BDEV_DEPS_CONF_THREAD)
 DEPDIRS-bdev_pmem := $(BDEV_DEPS_CONF_THREAD)
@@ -56,9 +56,26 @@ struct bdev_aio_io_channel {
 	struct bdev_aio_group_channel		*group_ch;
 };
 
+#define SPDK_AIO_QUEUE_DEPTH 128
+#define SPDK_AIO_SUBMIT_BATCH 32
+#define MAX_EVENTS_PER_POLL 32
+
+struct bdev_aio_group_stat {
+	uint64_t				ios_submitted;
+	uint64_t				submit_calls;
+	uint64_t				getevents_calls;
+};
+
 struct bdev_aio_group_channel {
 	struct spdk_poller			*poller;
 	io_context_t				io_ctx;
+
+	/* iocbs staged since the last io_submit() */
+	struct iocb				*pending[SPDK_AIO_SUBMIT_BATCH];
+	int					num_pending;
+
+	struct bdev_aio_group_stat		stat;
+	TAILQ_ENTRY(bdev_aio_group_channel)	link;
 };
 
 struct bdev_aio_task {
@@ -76,6 +93,7 @@ struct file_disk {
 	int			fd;
 	TAILQ_ENTRY(file_disk)  link;
 	bool			block_size_override;
+	bool			o_direct;
 };
 
 /* For user space reaping of completions */
@@ -98,9 +116,9 @@ static void bdev_aio_fini(void);
 static void aio_free_disk(struct file_disk *fdisk);
 static void bdev_aio_get_spdk_running_config(FILE *fp);
 static TAILQ_HEAD(, file_disk) g_aio_disk_head;
-
-#define SPDK_AIO_QUEUE_DEPTH 128
-#define MAX_EVENTS_PER_POLL 32
+static pthread_mutex_t g_aio_group_mutex = PTHREAD_MUTEX_INITIALIZER;
+static TAILQ_HEAD(, bdev_aio_group_channel) g_aio_group_channels =
+	TAILQ_HEAD_INITIALIZER(g_aio_group_channels);
 
 static int
 bdev_aio_get_ctx_size(void)
@@ -124,6 +142,7 @@ bdev_aio_open(struct file_disk *disk)
 	int fd;
 
 	fd = open(disk->filename, O_RDWR | O_DIRECT);
+	disk->o_direct = true;
 	if (fd < 0) {
 		/* Try without O_DIRECT for non-disk files */
 		fd = open(disk->filename, O_RDWR);
@@ -133,6 +152,7 @@ bdev_aio_open(struct file_disk *disk)
 			disk->fd = -1;
 			return -1;
 		}
+		disk->o_direct = false;
 	}
 
 	disk->fd = fd;
@@ -161,66 +181,73 @@ bdev_aio_close(struct file_disk *disk)
 	return 0;
 }
 
-static int64_t
-bdev_aio_readv(struct file_disk *fdisk, struct spdk_io_channel *ch,
-	       struct bdev_aio_task *aio_task,
-	       struct iovec *iov, int iovcnt, uint64_t nbytes, uint64_t offset)
+static void
+bdev_aio_group_submit(struct bdev_aio_group_channel *group_ch)
 {
-	struct iocb *iocb = &aio_task->iocb;
-	struct bdev_aio_io_channel *aio_ch = spdk_io_channel_get_ctx(ch);
-	int rc;
-
-	io_prep_preadv(iocb, fdisk->fd, iov, iovcnt, offset);
-	iocb->data = aio_task;
-	aio_task->len = nbytes;
-	aio_task->ch = aio_ch;
-
-	SPDK_DEBUGLOG(SPDK_LOG_AIO, "read %d iovs size %lu to off: %#lx\n",
-		      iovcnt, nbytes, offset);
+	struct bdev_aio_task *aio_task;
+	int count = 0, rc;
+
+	while (count < group_ch->num_pending) {
+		rc = io_submit(group_ch->io_ctx, group_ch->num_pending - count,
+			       &group_ch->pending[count]);
+		group_ch->stat.submit_calls++;
+		if (rc > 0) {
+			group_ch->stat.ios_submitted += rc;
+			count += rc;
+			continue;
+		}
 
-	rc = io_submit(aio_ch->group_ch->io_ctx, 1, &iocb);
-	if (rc < 0) {
-		if (rc == -EAGAIN) {
-			spdk_bdev_io_complete(spdk_bdev_io_from_ctx(aio_task), SPDK_BDEV_IO_STATUS_NOMEM);
-		} else {
-			spdk_bdev_io_complete(spdk_bdev_io_from_ctx(aio_task), SPDK_BDEV_IO_STATUS_FAILED);
-			SPDK_ERRLOG("%s: io_submit returned %d\n", __func__, rc);
+		if (rc == -EAGAIN || rc == 0) {
+			/* The kernel queue is full. Let the bdev layer retry the rest
+			 * once some I/O completes. */
+			while (count < group_ch->num_pending) {
+				aio_task = group_ch->pending[count++]->data;
+				aio_task->ch->io_inflight--;
+				spdk_bdev_io_complete(spdk_bdev_io_from_ctx(aio_task),
+						      SPDK_BDEV_IO_STATUS_NOMEM);
+			}
+			break;
 		}
-		return -1;
+
+		/* io_submit() only reports an error for the first iocb of the batch. */
+		SPDK_ERRLOG("%s: io_submit returned %d\n", __func__, rc);
+		aio_task = group_ch->pending[count++]->data;
+		aio_task->ch->io_inflight--;
+		spdk_bdev_io_complete(spdk_bdev_io_from_ctx(aio_task), SPDK_BDEV_IO_STATUS_FAILED);
 	}
-	aio_ch->io_inflight++;
-	return nbytes;
+
+	group_ch->num_pending = 0;
 }
 
-static int64_t
-bdev_aio_writev(struct file_disk *fdisk, struct spdk_io_channel *ch,
-		struct bdev_aio_task *aio_task,
-		struct iovec *iov, int iovcnt, size_t len, uint64_t offset)
+static void
+bdev_aio_rw(struct file_disk *fdisk, struct spdk_io_channel *ch,
+	    struct bdev_aio_task *aio_task, bool write,
+	    struct iovec *iov, int iovcnt, uint64_t nbytes, uint64_t offset)
 {
 	struct iocb *iocb = &aio_task->iocb;
 	struct bdev_aio_io_channel *aio_ch = spdk_io_channel_get_ctx(ch);
-	int rc;
+	struct bdev_aio_group_channel *group_ch = aio_ch->group_ch;
 
-	io_prep_pwritev(iocb, fdisk->fd, iov, iovcnt, offset);
+	if (write) {
+		io_prep_pwritev(iocb, fdisk->fd, iov, iovcnt, offset);
+	} else {
+		io_prep_preadv(iocb, fdisk->fd, iov, iovcnt, offset);
+	}
 	iocb->data = aio_task;
-	aio_task->len = len;
+	aio_task->len = nbytes;
 	aio_task->ch = aio_ch;
 
-	SPDK_DEBUGLOG(SPDK_LOG_AIO, "write %d iovs size %lu from off: %#lx\n",
-		      iovcnt, len, offset);
+	SPDK_DEBUGLOG(SPDK_LOG_AIO, "%s %d iovs size %lu %s off: %#lx\n",
+		      write ? "write" : "read", iovcnt, nbytes, write ? "from" : "to", offset);
 
-	rc = io_submit(aio_ch->group_ch->io_ctx, 1, &iocb);
-	if (rc < 0) {
-		if (rc == -EAGAIN) {
-			spdk_bdev_io_complete(spdk_bdev_io_from_ctx(aio_task), SPDK_BDEV_IO_STATUS_NOMEM);
-		} else {
-			spdk_bdev_io_complete(spdk_bdev_io_from_ctx(aio_task), SPDK_BDEV_IO_STATUS_FAILED);
-			SPDK_ERRLOG("%s: io_submit returned %d\n", __func__, rc);
-		}
-		return -1;
-	}
+	/* Stage the iocb. The whole batch is handed to the kernel with a single
+	 * io_submit() on the next group poll, or right away once it is full. */
+	group_ch->pending[group_ch->num_pending++] = iocb;
 	aio_ch->io_inflight++;
-	return len;
+
+	if (group_ch->num_pending == SPDK_AIO_SUBMIT_BATCH) {
+		bdev_aio_group_submit(group_ch);
+	}
 }
 
 static void
@@ -249,7 +276,8 @@ bdev_aio_destruct(void *ctx)
 }
 
 static int
-bdev_user_io_getevents(io_context_t io_ctx, unsigned int max, struct io_event *uevents)
+bdev_user_io_getevents(io_context_t io_ctx, unsigned int max, struct io_event *uevents,
+		       uint64_t *syscalls)
 {
 	uint32_t head, tail, count;
 	struct spdk_aio_ring *ring;
@@ -262,6 +290,7 @@ bdev_user_io_getevents(io_context_t io_ctx, unsigned int max, struct io_event *u
 		timeout.tv_sec = 0;
 		timeout.tv_nsec = 0;
 
+		(*syscalls)++;
 		return io_getevents(io_ctx, 0, max, uevents, &timeout);
 	}
 
@@ -319,11 +348,17 @@ bdev_aio_group_poll(void *arg)
 	enum spdk_bdev_io_status status;
 	struct bdev_aio_task *aio_task;
 	struct io_event events[SPDK_AIO_QUEUE_DEPTH];
+	int submitted = group_ch->num_pending;
 
-	nr = bdev_user_io_getevents(group_ch->io_ctx, SPDK_AIO_QUEUE_DEPTH, events);
+	if (submitted > 0) {
+		bdev_aio_group_submit(group_ch);
+	}
+
+	nr = bdev_user_io_getevents(group_ch->io_ctx, SPDK_AIO_QUEUE_DEPTH, events,
+				    &group_ch->stat.getevents_calls);
 
 	if (nr < 0) {
-		return SPDK_POLLER_IDLE;
+		return submitted > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 	}
 
 	for (i = 0; i < nr; i++) {
@@ -338,7 +373,7 @@ bdev_aio_group_poll(void *arg)
 		aio_task->ch->io_inflight--;
 	}
 
-	return nr > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+	return nr + submitted > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
 
 static void
@@ -406,22 +441,15 @@ bdev_aio_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
 
 	switch (bdev_io->type) {
 	case SPDK_BDEV_IO_TYPE_READ:
-		bdev_aio_readv((struct file_disk *)bdev_io->bdev->ctxt,
-			       ch,
-			       (struct bdev_aio_task *)bdev_io->driver_ctx,
-			       bdev_io->u.bdev.iovs,
-			       bdev_io->u.bdev.iovcnt,
-			       bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen,
-			       bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen);
-		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
-		bdev_aio_writev((struct file_disk *)bdev_io->bdev->ctxt,
-				ch,
-				(struct bdev_aio_task *)bdev_io->driver_ctx,
-				bdev_io->u.bdev.iovs,
-				bdev_io->u.bdev.iovcnt,
-				bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen,
-				bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen);
+		bdev_aio_rw((struct file_disk *)bdev_io->bdev->ctxt,
+			    ch,
+			    (struct bdev_aio_task *)bdev_io->driver_ctx,
+			    bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE,
+			    bdev_io->u.bdev.iovs,
+			    bdev_io->u.bdev.iovcnt,
+			    bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen,
+			    bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen);
 		break;
 	default:
 		SPDK_ERRLOG("Wrong io type\n");
@@ -508,9 +536,36 @@ bdev_aio_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 {
 	struct file_disk *fdisk = ctx;
 
+	struct bdev_aio_group_channel *group_ch;
+	struct bdev_aio_group_stat stat = {};
+	double syscalls_per_io = 0.0;
+
+	/* The io_submit()/io_getevents() contexts are shared by all aio bdevs
+	 * on a thread, so the syscall counters cover the whole module. */
+	pthread_mutex_lock(&g_aio_group_mutex);
+	TAILQ_FOREACH(group_ch, &g_aio_group_channels, link) {
+		stat.ios_submitted += group_ch->stat.ios_submitted;
+		stat.submit_calls += group_ch->stat.submit_calls;
+		stat.getevents_calls += group_ch->stat.getevents_calls;
+	}
+	pthread_mutex_unlock(&g_aio_group_mutex);
+
+	if (stat.ios_submitted != 0) {
+		syscalls_per_io = (double)(stat.submit_calls + stat.getevents_calls) /
+				  stat.ios_submitted;
+	}
+
 	spdk_json_write_named_object_begin(w, "aio");
 
 	spdk_json_write_named_string(w, "filename", fdisk->filename);
+	spdk_json_write_named_bool(w, "o_direct", fdisk->o_direct);
+
+	spdk_json_write_named_object_begin(w, "stats");
+	spdk_json_write_named_uint64(w, "ios_submitted", stat.ios_submitted);
+	spdk_json_write_named_uint64(w, "io_submit_calls", stat.submit_calls);
+	spdk_json_write_named_uint64(w, "io_getevents_calls", stat.getevents_calls);
+	spdk_json_write_named_string_fmt(w, "syscalls_per_io", "%.3f", syscalls_per_io);
+	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
 
@@ -566,6 +621,10 @@ bdev_aio_group_create_cb(void *io_device, void *ctx_buf)
 		return -1;
 	}
 
+	pthread_mutex_lock(&g_aio_group_mutex);
+	TAILQ_INSERT_TAIL(&g_aio_group_channels, ch, link);
+	pthread_mutex_unlock(&g_aio_group_mutex);
+
 	ch->poller = SPDK_POLLER_REGISTER(bdev_aio_group_poll, ch, 0);
 	return 0;
 }
@@ -575,6 +634,10 @@ bdev_aio_group_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_aio_group_channel *ch = ctx_buf;
 
+	pthread_mutex_lock(&g_aio_group_mutex);
+	TAILQ_REMOVE(&g_aio_group_channels, ch, link);
+	pthread_mutex_unlock(&g_aio_group_mutex);
+
 	io_destroy(ch->io_ctx);
 
 	spdk_poller_unregister(&ch->poller);
@@ -656,7 +719,17 @@ create_aio_bdev(const char *name, const char *filename, uint32_t block_size)
 	}
 
 	fdisk->disk.blocklen = block_size;
-	fdisk->disk.required_alignment = spdk_u32log2(block_size);
+	if (!fdisk->o_direct) {
+		/* Buffered I/O has no alignment constraints, so there's no need for
+		 * the bdev layer to bounce unaligned buffers. */
+		fdisk->disk.required_alignment = 0;
+	} else if (detected_block_size != 0) {
+		/* O_DIRECT only requires buffers aligned to the logical block size
+		 * of the device, which may be smaller than the bdev block size. */
+		fdisk->disk.required_alignment = spdk_u32log2(detected_block_size);
+	} else {
+		fdisk->disk.required_alignment = spdk_u32log2(block_size);
+	}
 
 	if (disk_size % fdisk->disk.blocklen != 0) {
 		SPDK_ERRLOG("Disk size %" PRIu64 " is not a multiple of block size %" PRIu32 "\n",
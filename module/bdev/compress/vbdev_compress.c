@@ -32,6 +32,7 @@
  */
 
 #include "vbdev_compress.h"
+#include "vbdev_compress_sw.h"
 
 #include "spdk/reduce.h"
 #include "spdk/stdinc.h"
@@ -64,6 +65,7 @@
 
 #define ISAL_PMD "compress_isal"
 #define QAT_PMD "compress_qat"
+#define SW_PMD "compress_sw"
 #define NUM_MBUFS		8192
 #define POOL_CACHE_SIZE		256
 
@@ -130,6 +132,7 @@ struct vbdev_compress {
 	struct spdk_reduce_vol_params	params;		/* params for the reduce volume */
 	struct spdk_reduce_backing_dev	backing_dev;	/* backing device info for the reduce volume */
 	struct spdk_reduce_vol		*vol;		/* the reduce volume */
+	struct comp_sw_vol		sw_vol;		/* software path state and stats */
 	struct vbdev_comp_delete_ctx	*delete_ctx;
 	bool				orphaned;	/* base bdev claimed but comp_bdev not registered */
 	int				reduce_errno;
@@ -705,6 +708,71 @@ comp_dev_poller(void *args)
 	return num_deq == 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
 }
 
+static inline bool
+_comp_bdev_use_sw(struct vbdev_compress *comp_bdev)
+{
+	return strcmp(comp_bdev->drv_name, SW_PMD) == 0;
+}
+
+/* Submit to the software path. Operations that find all of the volume's tasks
+ * in use are queued, _comp_sw_resume() submits them again as tasks free up.
+ */
+static int
+_comp_sw_operation(struct vbdev_compress *comp_bdev, struct iovec *src_iovs, int src_iovcnt,
+		   struct iovec *dst_iovs, int dst_iovcnt, bool compress,
+		   struct spdk_reduce_vol_cb_args *cb_arg)
+{
+	struct vbdev_comp_op *op_to_queue;
+	int rc;
+
+	rc = comp_sw_submit(&comp_bdev->sw_vol, compress, src_iovs, src_iovcnt,
+			    dst_iovs, dst_iovcnt, cb_arg->cb_fn, cb_arg->cb_arg);
+	if (rc != -ENOMEM) {
+		return rc;
+	}
+
+	op_to_queue = calloc(1, sizeof(struct vbdev_comp_op));
+	if (op_to_queue == NULL) {
+		SPDK_ERRLOG("unable to allocate operation for queueing.\n");
+		return -ENOMEM;
+	}
+	op_to_queue->backing_dev = &comp_bdev->backing_dev;
+	op_to_queue->src_iovs = src_iovs;
+	op_to_queue->src_iovcnt = src_iovcnt;
+	op_to_queue->dst_iovs = dst_iovs;
+	op_to_queue->dst_iovcnt = dst_iovcnt;
+	op_to_queue->compress = compress;
+	op_to_queue->cb_arg = cb_arg;
+	TAILQ_INSERT_TAIL(&comp_bdev->queued_comp_ops, op_to_queue, link);
+	return 0;
+}
+
+/* Called by the software path on the reduce thread each time a task frees up. */
+static void
+_comp_sw_resume(void *arg)
+{
+	struct vbdev_compress *comp_bdev = arg;
+	struct vbdev_comp_op *op_to_resubmit;
+	struct spdk_reduce_vol_cb_args *cb_arg;
+	int rc;
+
+	op_to_resubmit = TAILQ_FIRST(&comp_bdev->queued_comp_ops);
+	if (op_to_resubmit == NULL) {
+		return;
+	}
+	TAILQ_REMOVE(&comp_bdev->queued_comp_ops, op_to_resubmit, link);
+
+	cb_arg = op_to_resubmit->cb_arg;
+	rc = _comp_sw_operation(comp_bdev, op_to_resubmit->src_iovs, op_to_resubmit->src_iovcnt,
+				op_to_resubmit->dst_iovs, op_to_resubmit->dst_iovcnt,
+				op_to_resubmit->compress, cb_arg);
+	free(op_to_resubmit);
+	if (rc) {
+		/* For a compress, including -ENOSPC, reduce stores the chunk as is. */
+		cb_arg->cb_fn(cb_arg->cb_arg, rc);
+	}
+}
+
 /* Entry point for reduce lib to issue a compress operation. */
 static void
 _comp_reduce_compress(struct spdk_reduce_backing_dev *dev,
@@ -712,9 +780,22 @@ _comp_reduce_compress(struct spdk_reduce_backing_dev *dev,
 		      struct iovec *dst_iovs, int dst_iovcnt,
 		      struct spdk_reduce_vol_cb_args *cb_arg)
 {
+	struct vbdev_compress *comp_bdev = SPDK_CONTAINEROF(dev, struct vbdev_compress,
+					   backing_dev);
 	int rc;
 
-	rc = _compress_operation(dev, src_iovs, src_iovcnt, dst_iovs, dst_iovcnt, true, cb_arg);
+	if (_comp_bdev_use_sw(comp_bdev)) {
+		rc = _comp_sw_operation(comp_bdev, src_iovs, src_iovcnt, dst_iovs, dst_iovcnt,
+					true, cb_arg);
+		if (rc == -ENOSPC) {
+			/* Not worth compressing, reduce will store the chunk as is. */
+			cb_arg->cb_fn(cb_arg->cb_arg, rc);
+			return;
+		}
+	} else {
+		rc = _compress_operation(dev, src_iovs, src_iovcnt, dst_iovs, dst_iovcnt, true,
+					 cb_arg);
+	}
 	if (rc) {
 		SPDK_ERRLOG("with compress operation code %d (%s)\n", rc, spdk_strerror(-rc));
 		cb_arg->cb_fn(cb_arg->cb_arg, rc);
@@ -728,9 +809,17 @@ _comp_reduce_decompress(struct spdk_reduce_backing_dev *dev,
 			struct iovec *dst_iovs, int dst_iovcnt,
 			struct spdk_reduce_vol_cb_args *cb_arg)
 {
+	struct vbdev_compress *comp_bdev = SPDK_CONTAINEROF(dev, struct vbdev_compress,
+					   backing_dev);
 	int rc;
 
-	rc = _compress_operation(dev, src_iovs, src_iovcnt, dst_iovs, dst_iovcnt, false, cb_arg);
+	if (_comp_bdev_use_sw(comp_bdev)) {
+		rc = _comp_sw_operation(comp_bdev, src_iovs, src_iovcnt, dst_iovs, dst_iovcnt,
+					false, cb_arg);
+	} else {
+		rc = _compress_operation(dev, src_iovs, src_iovcnt, dst_iovs, dst_iovcnt, false,
+					 cb_arg);
+	}
 	if (rc) {
 		SPDK_ERRLOG("with decompress operation code %d (%s)\n", rc, spdk_strerror(-rc));
 		cb_arg->cb_fn(cb_arg->cb_arg, rc);
@@ -1081,6 +1170,9 @@ vbdev_compress_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&comp_bdev->comp_bdev));
 	spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(comp_bdev->base_bdev));
 	spdk_json_write_named_string(w, "compression_pmd", comp_bdev->drv_name);
+	if (_comp_bdev_use_sw(comp_bdev)) {
+		comp_sw_vol_dump_stats(&comp_bdev->sw_vol, w);
+	}
 	spdk_json_write_object_end(w);
 
 	return 0;
@@ -1324,6 +1416,8 @@ _set_pmd(struct vbdev_compress *comp_dev)
 		comp_dev->drv_name = QAT_PMD;
 	} else if (g_opts == COMPRESS_PMD_ISAL_ONLY && g_isal_available) {
 		comp_dev->drv_name = ISAL_PMD;
+	} else if (g_opts == COMPRESS_PMD_SW_ONLY) {
+		comp_dev->drv_name = SW_PMD;
 	} else {
 		SPDK_ERRLOG("Requested PMD is not available.\n");
 		return false;
@@ -1381,10 +1475,20 @@ comp_bdev_ch_create_cb(void *io_device, void *ctx_buf)
 {
 	struct vbdev_compress *comp_bdev = io_device;
 	struct comp_device_qp *device_qp;
+	int rc;
 
 	/* Now set the reduce channel if it's not already set. */
 	pthread_mutex_lock(&comp_bdev->reduce_lock);
 	if (comp_bdev->ch_count == 0) {
+		if (_comp_bdev_use_sw(comp_bdev)) {
+			rc = comp_sw_vol_init(&comp_bdev->sw_vol, _comp_sw_resume, comp_bdev);
+			if (rc) {
+				pthread_mutex_unlock(&comp_bdev->reduce_lock);
+				SPDK_ERRLOG("software compression init failed %d\n", rc);
+				return rc;
+			}
+		}
+
 		/* We use this queue to track outstanding IO in our layer. */
 		TAILQ_INIT(&comp_bdev->pending_comp_ios);
 
@@ -1393,7 +1497,13 @@ comp_bdev_ch_create_cb(void *io_device, void *ctx_buf)
 
 		comp_bdev->base_ch = spdk_bdev_get_io_channel(comp_bdev->base_desc);
 		comp_bdev->reduce_thread = spdk_get_thread();
-		comp_bdev->poller = SPDK_POLLER_REGISTER(comp_dev_poller, comp_bdev, 0);
+		/* The software path completes on the reduce thread through messages from
+		 * its worker threads. There is no device to poll and, as no device carries
+		 * its driver name, no qpair gets assigned below.
+		 */
+		if (!_comp_bdev_use_sw(comp_bdev)) {
+			comp_bdev->poller = SPDK_POLLER_REGISTER(comp_dev_poller, comp_bdev, 0);
+		}
 		/* Now assign a q pair */
 		pthread_mutex_lock(&g_comp_device_qp_lock);
 		TAILQ_FOREACH(device_qp, &g_comp_device_qp, link) {
@@ -1414,7 +1524,7 @@ comp_bdev_ch_create_cb(void *io_device, void *ctx_buf)
 	comp_bdev->ch_count++;
 	pthread_mutex_unlock(&comp_bdev->reduce_lock);
 
-	if (comp_bdev->device_qp != NULL) {
+	if (comp_bdev->device_qp != NULL || _comp_bdev_use_sw(comp_bdev)) {
 		return 0;
 	} else {
 		SPDK_ERRLOG("out of qpairs, cannot assign one to comp_bdev %p\n", comp_bdev);
@@ -1433,6 +1543,7 @@ _channel_cleanup(struct vbdev_compress *comp_bdev)
 	spdk_put_io_channel(comp_bdev->base_ch);
 	comp_bdev->reduce_thread = NULL;
 	spdk_poller_unregister(&comp_bdev->poller);
+	comp_sw_vol_fini(&comp_bdev->sw_vol);
 }
 
 /* Used to reroute destroy_ch to the correct thread */
@@ -73,6 +73,7 @@ enum compress_pmd {
 	COMPRESS_PMD_AUTO = 0,
 	COMPRESS_PMD_QAT_ONLY,
 	COMPRESS_PMD_ISAL_ONLY,
+	COMPRESS_PMD_SW_ONLY,
 	COMPRESS_PMD_MAX
 };
 
@@ -0,0 +1,442 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vbdev_compress_sw.h"
+
+#include "spdk/env.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#include "spdk_internal/log.h"
+
+#include "isa-l/include/igzip_lib.h"
+
+/* Reduce keeps 256 requests per volume and each of them has at most one
+ * compress or decompress operation outstanding.
+ */
+#define COMP_SW_NUM_TASKS	256
+#define COMP_SW_MAX_WORKERS	16
+
+/* Compressibility is tracked as compressed/uncompressed size scaled by
+ * COMP_SW_RATIO_ONE. Below COMP_SW_RATIO_FAST the better ratio of ISA-L level 1
+ * is worth its extra cost, up to COMP_SW_RATIO_RAW level 0 is used and above it
+ * chunks are stored raw, except for one probe every COMP_SW_PROBE_INTERVAL
+ * chunks so that the volume can recover when its data becomes compressible.
+ * Reduce only stores a chunk compressed when it saves at least one backing
+ * io unit, 1/4 of a chunk with the default sizes, so COMP_SW_RATIO_RAW sits
+ * above that.
+ */
+#define COMP_SW_RATIO_ONE	1024
+#define COMP_SW_RATIO_FAST	(COMP_SW_RATIO_ONE * 5 / 8)
+#define COMP_SW_RATIO_RAW	(COMP_SW_RATIO_ONE * 7 / 8)
+#define COMP_SW_PROBE_INTERVAL	16
+#define COMP_SW_LEVEL_RAW	-1
+
+struct comp_sw_worker {
+	struct spdk_thread	*thread;
+	struct isal_zstream	stream;
+	struct inflate_state	state;
+	uint8_t			level_buf[ISAL_DEF_LVL1_DEFAULT];
+};
+
+struct comp_sw_task {
+	struct comp_sw_vol		*vol;
+	struct comp_sw_worker		*worker;
+	struct spdk_thread		*orig_thread;
+	bool				compress;
+	int				level;
+	struct iovec			*src_iovs;
+	int				src_iovcnt;
+	struct iovec			*dst_iovs;
+	int				dst_iovcnt;
+	uint64_t			src_len;
+	uint64_t			submit_tsc;
+	int				rc;
+	comp_sw_done_fn			cb_fn;
+	void				*cb_arg;
+	TAILQ_ENTRY(comp_sw_task)	link;
+};
+
+/* Worker threads are shared by all volumes using the software path. */
+static struct comp_sw_worker **g_workers;
+static uint32_t g_num_workers;
+static uint32_t g_worker_refs;
+static pthread_mutex_t g_worker_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Runs on the worker thread. Raw deflate with the default 32KB window, as used by
+ * the DPDK ISA-L and QAT PMDs, so volumes can move between the two paths.
+ */
+static int
+_comp_sw_deflate(struct comp_sw_worker *worker, struct comp_sw_task *task)
+{
+	struct isal_zstream *stream = &worker->stream;
+	int i, rc;
+
+	/* Reduce always hands us a single chunk sized buffer to compress into. */
+	assert(task->dst_iovcnt == 1);
+
+	isal_deflate_init(stream);
+	stream->level = task->level;
+	if (task->level > 0) {
+		stream->level_buf = worker->level_buf;
+		stream->level_buf_size = sizeof(worker->level_buf);
+	}
+	stream->next_out = task->dst_iovs[0].iov_base;
+	stream->avail_out = task->dst_iovs[0].iov_len;
+
+	for (i = 0; i < task->src_iovcnt; i++) {
+		stream->next_in = task->src_iovs[i].iov_base;
+		stream->avail_in = task->src_iovs[i].iov_len;
+		stream->end_of_stream = (i == task->src_iovcnt - 1);
+
+		rc = isal_deflate(stream);
+		if (rc != COMP_OK) {
+			SPDK_ERRLOG("isal_deflate() failed with %d\n", rc);
+			return -EIO;
+		}
+		if (stream->avail_in != 0) {
+			return -ENOSPC;
+		}
+	}
+
+	if (stream->internal_state.state != ZSTATE_END) {
+		return -ENOSPC;
+	}
+
+	return stream->total_out;
+}
+
+/* Runs on the worker thread. */
+static int
+_comp_sw_inflate(struct comp_sw_worker *worker, struct comp_sw_task *task)
+{
+	struct inflate_state *state = &worker->state;
+	int src_idx = 0, dst_idx = 0;
+	bool out_full = false;
+	int rc;
+
+	isal_inflate_init(state);
+	state->avail_in = 0;
+	state->avail_out = 0;
+
+	for (;;) {
+		if (state->avail_in == 0 && src_idx < task->src_iovcnt) {
+			state->next_in = task->src_iovs[src_idx].iov_base;
+			state->avail_in = task->src_iovs[src_idx].iov_len;
+			src_idx++;
+		}
+		if (state->avail_out == 0 && dst_idx < task->dst_iovcnt) {
+			state->next_out = task->dst_iovs[dst_idx].iov_base;
+			state->avail_out = task->dst_iovs[dst_idx].iov_len;
+			dst_idx++;
+		}
+
+		rc = isal_inflate(state);
+		if (rc != ISAL_DECOMP_OK) {
+			SPDK_ERRLOG("isal_inflate() failed with %d\n", rc);
+			return -EIO;
+		}
+		if (state->block_state == ISAL_BLOCK_FINISH) {
+			return state->total_out;
+		}
+
+		if (state->avail_out == 0 && dst_idx == task->dst_iovcnt) {
+			/* The end of block marker may still be pending, give it one more pass. */
+			if (out_full) {
+				return -ENOSPC;
+			}
+			out_full = true;
+			continue;
+		}
+		if (state->avail_in == 0 && src_idx == task->src_iovcnt) {
+			SPDK_ERRLOG("compressed chunk is truncated\n");
+			return -EIO;
+		}
+	}
+}
+
+/* Back on the submitting thread, account for the operation and complete it. */
+static void
+_comp_sw_task_done(void *arg)
+{
+	struct comp_sw_task *task = arg;
+	struct comp_sw_vol *vol = task->vol;
+	struct comp_sw_stats *stats = &vol->stats;
+	comp_sw_done_fn cb_fn = task->cb_fn;
+	void *cb_arg = task->cb_arg;
+	uint64_t ticks = spdk_get_ticks() - task->submit_tsc;
+	uint32_t sample;
+	int rc = task->rc;
+
+	stats->ops++;
+	stats->total_ticks += ticks;
+	stats->max_ticks = spdk_max(stats->max_ticks, ticks);
+
+	if (task->compress) {
+		stats->bytes_in += task->src_len;
+		if (rc > 0) {
+			stats->chunks_compressed++;
+			stats->bytes_out += rc;
+			sample = (uint64_t)rc * COMP_SW_RATIO_ONE / task->src_len;
+		} else {
+			stats->chunks_raw++;
+			stats->bytes_out += task->src_len;
+			sample = COMP_SW_RATIO_ONE;
+		}
+		vol->ratio = (vol->ratio * 7 + spdk_min(sample, COMP_SW_RATIO_ONE)) / 8;
+	} else if (rc >= 0) {
+		stats->chunks_decompressed++;
+	}
+
+	TAILQ_INSERT_HEAD(&vol->free_tasks, task, link);
+	/* Operations that were waiting for a task go before anything cb_fn submits. */
+	vol->resume_fn(vol->resume_arg);
+	cb_fn(cb_arg, rc);
+}
+
+static void
+_comp_sw_task_run(void *arg)
+{
+	struct comp_sw_task *task = arg;
+
+	if (task->compress) {
+		task->rc = _comp_sw_deflate(task->worker, task);
+	} else {
+		task->rc = _comp_sw_inflate(task->worker, task);
+	}
+
+	spdk_thread_send_msg(task->orig_thread, _comp_sw_task_done, task);
+}
+
+static int
+_comp_sw_select_level(struct comp_sw_vol *vol)
+{
+	if (vol->ratio >= COMP_SW_RATIO_RAW) {
+		if (++vol->skip_count < COMP_SW_PROBE_INTERVAL) {
+			return COMP_SW_LEVEL_RAW;
+		}
+		vol->skip_count = 0;
+		return 0;
+	}
+
+	return vol->ratio >= COMP_SW_RATIO_FAST ? 0 : 1;
+}
+
+int
+comp_sw_submit(struct comp_sw_vol *vol, bool compress,
+	       struct iovec *src_iovs, int src_iovcnt,
+	       struct iovec *dst_iovs, int dst_iovcnt,
+	       comp_sw_done_fn cb_fn, void *cb_arg)
+{
+	struct comp_sw_task *task;
+	int level = 0;
+	int i, rc;
+
+	/* Check the pool first, a chunk that has to wait for a task must not use
+	 * up the probe of an incompressible volume.
+	 */
+	task = TAILQ_FIRST(&vol->free_tasks);
+	if (task == NULL) {
+		return -ENOMEM;
+	}
+
+	if (compress) {
+		level = _comp_sw_select_level(vol);
+		if (level == COMP_SW_LEVEL_RAW) {
+			vol->stats.chunks_raw++;
+			vol->stats.chunks_skipped++;
+			return -ENOSPC;
+		}
+	}
+
+	TAILQ_REMOVE(&vol->free_tasks, task, link);
+
+	task->vol = vol;
+	task->worker = g_workers[vol->next_worker++ % g_num_workers];
+	task->orig_thread = spdk_get_thread();
+	task->compress = compress;
+	task->level = level;
+	task->src_iovs = src_iovs;
+	task->src_iovcnt = src_iovcnt;
+	task->dst_iovs = dst_iovs;
+	task->dst_iovcnt = dst_iovcnt;
+	task->src_len = 0;
+	for (i = 0; i < src_iovcnt; i++) {
+		task->src_len += src_iovs[i].iov_len;
+	}
+	task->submit_tsc = spdk_get_ticks();
+	task->cb_fn = cb_fn;
+	task->cb_arg = cb_arg;
+
+	rc = spdk_thread_send_msg(task->worker->thread, _comp_sw_task_run, task);
+	if (rc) {
+		TAILQ_INSERT_HEAD(&vol->free_tasks, task, link);
+		return rc;
+	}
+
+	return 0;
+}
+
+static void
+_comp_sw_worker_exit(void *arg)
+{
+	struct comp_sw_worker *worker = arg;
+
+	spdk_thread_exit(worker->thread);
+	free(worker);
+}
+
+/* Called with g_worker_lock held. */
+static void
+_comp_sw_workers_stop(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < g_num_workers; i++) {
+		spdk_thread_send_msg(g_workers[i]->thread, _comp_sw_worker_exit, g_workers[i]);
+	}
+	free(g_workers);
+	g_workers = NULL;
+	g_num_workers = 0;
+}
+
+/* Called with g_worker_lock held. */
+static int
+_comp_sw_workers_start(void)
+{
+	struct comp_sw_worker *worker;
+	char name[32];
+	uint32_t num_workers;
+
+	num_workers = spdk_min(spdk_max(spdk_env_get_core_count(), 1u), COMP_SW_MAX_WORKERS);
+	g_workers = calloc(num_workers, sizeof(*g_workers));
+	if (g_workers == NULL) {
+		return -ENOMEM;
+	}
+
+	while (g_num_workers < num_workers) {
+		worker = calloc(1, sizeof(*worker));
+		if (worker == NULL) {
+			_comp_sw_workers_stop();
+			return -ENOMEM;
+		}
+
+		snprintf(name, sizeof(name), "comp_sw_%u", g_num_workers);
+		worker->thread = spdk_thread_create(name, NULL);
+		if (worker->thread == NULL) {
+			free(worker);
+			_comp_sw_workers_stop();
+			return -ENOMEM;
+		}
+		g_workers[g_num_workers++] = worker;
+	}
+
+	SPDK_NOTICELOG("started %u software compression threads\n", g_num_workers);
+	return 0;
+}
+
+int
+comp_sw_vol_init(struct comp_sw_vol *vol, comp_sw_resume_fn resume_fn, void *resume_arg)
+{
+	int i, rc = 0;
+
+	vol->task_mem = calloc(COMP_SW_NUM_TASKS, sizeof(struct comp_sw_task));
+	if (vol->task_mem == NULL) {
+		return -ENOMEM;
+	}
+
+	TAILQ_INIT(&vol->free_tasks);
+	for (i = 0; i < COMP_SW_NUM_TASKS; i++) {
+		TAILQ_INSERT_TAIL(&vol->free_tasks, &vol->task_mem[i], link);
+	}
+	vol->ratio = 0;
+	vol->skip_count = 0;
+	vol->next_worker = 0;
+	vol->resume_fn = resume_fn;
+	vol->resume_arg = resume_arg;
+
+	pthread_mutex_lock(&g_worker_lock);
+	if (g_worker_refs == 0) {
+		rc = _comp_sw_workers_start();
+	}
+	if (rc == 0) {
+		g_worker_refs++;
+	}
+	pthread_mutex_unlock(&g_worker_lock);
+
+	if (rc) {
+		free(vol->task_mem);
+		vol->task_mem = NULL;
+	}
+	return rc;
+}
+
+void
+comp_sw_vol_fini(struct comp_sw_vol *vol)
+{
+	if (vol->task_mem == NULL) {
+		return;
+	}
+
+	free(vol->task_mem);
+	vol->task_mem = NULL;
+
+	pthread_mutex_lock(&g_worker_lock);
+	assert(g_worker_refs > 0);
+	if (--g_worker_refs == 0) {
+		_comp_sw_workers_stop();
+	}
+	pthread_mutex_unlock(&g_worker_lock);
+}
+
+void
+comp_sw_vol_dump_stats(const struct comp_sw_vol *vol, struct spdk_json_write_ctx *w)
+{
+	const struct comp_sw_stats *stats = &vol->stats;
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+	uint64_t avg_ticks = stats->ops ? stats->total_ticks / stats->ops : 0;
+
+	spdk_json_write_named_object_begin(w, "stats");
+	spdk_json_write_named_uint64(w, "chunks_compressed", stats->chunks_compressed);
+	spdk_json_write_named_uint64(w, "chunks_raw", stats->chunks_raw);
+	spdk_json_write_named_uint64(w, "chunks_skipped", stats->chunks_skipped);
+	spdk_json_write_named_uint64(w, "chunks_decompressed", stats->chunks_decompressed);
+	spdk_json_write_named_uint64(w, "bytes_in", stats->bytes_in);
+	spdk_json_write_named_uint64(w, "bytes_out", stats->bytes_out);
+	spdk_json_write_named_string_fmt(w, "compression_ratio", "%.3f",
+					 stats->bytes_in ? (double)stats->bytes_out / stats->bytes_in : 1.0);
+	spdk_json_write_named_uint64(w, "avg_latency_us", avg_ticks * SPDK_SEC_TO_USEC / ticks_hz);
+	spdk_json_write_named_uint64(w, "max_latency_us",
+				     stats->max_ticks * SPDK_SEC_TO_USEC / ticks_hz);
+	spdk_json_write_object_end(w);
+}
@@ -0,0 +1,137 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPDK_VBDEV_COMPRESS_SW_H
+#define SPDK_VBDEV_COMPRESS_SW_H
+
+#include "spdk/stdinc.h"
+
+#include "spdk/json.h"
+#include "spdk/queue.h"
+
+/**
+ * Completion callback for a software (de)compression operation.
+ *
+ * \param cb_arg Argument passed to comp_sw_submit().
+ * \param rc Number of bytes produced on success, negative errno on failure.
+ */
+typedef void (*comp_sw_done_fn)(void *cb_arg, int rc);
+
+/**
+ * Called on the submitting thread each time one of the volume's tasks is
+ * returned to its pool, before the operation's own completion callback.
+ *
+ * \param resume_arg Argument passed to comp_sw_vol_init().
+ */
+typedef void (*comp_sw_resume_fn)(void *resume_arg);
+
+struct comp_sw_task;
+
+/* Counters are only updated on the thread that submits operations for the volume. */
+struct comp_sw_stats {
+	uint64_t	chunks_compressed;	/* chunks written compressed */
+	uint64_t	chunks_raw;		/* chunks handed back to reduce to store raw */
+	uint64_t	chunks_skipped;		/* subset of chunks_raw never sent to a worker */
+	uint64_t	chunks_decompressed;
+	uint64_t	bytes_in;		/* uncompressed bytes offered to a worker */
+	uint64_t	bytes_out;		/* compressed bytes produced for bytes_in */
+	uint64_t	ops;			/* operations completed by a worker */
+	uint64_t	total_ticks;		/* submit to completion, summed over ops */
+	uint64_t	max_ticks;
+};
+
+/* Per volume state of the software compression path. */
+struct comp_sw_vol {
+	struct comp_sw_stats		stats;
+	uint32_t			ratio;		/* EWMA of compressed/uncompressed size */
+	uint32_t			skip_count;	/* chunks stored raw since the last probe */
+	uint32_t			next_worker;
+	struct comp_sw_task		*task_mem;
+	TAILQ_HEAD(, comp_sw_task)	free_tasks;
+	comp_sw_resume_fn		resume_fn;
+	void				*resume_arg;
+};
+
+/**
+ * Prepare a volume for software compression. The first volume starts the pool
+ * of worker threads, the pool is shared by all volumes.
+ *
+ * \param vol Volume state to initialize.
+ * \param resume_fn Called when a task frees up, to resubmit operations that
+ * comp_sw_submit() rejected with -ENOMEM.
+ * \param resume_arg Argument passed to resume_fn.
+ * \return 0 on success, negative errno on failure.
+ */
+int comp_sw_vol_init(struct comp_sw_vol *vol, comp_sw_resume_fn resume_fn, void *resume_arg);
+
+/**
+ * Release the resources taken by comp_sw_vol_init(). All operations submitted
+ * for the volume must have completed. Statistics are left intact.
+ *
+ * \param vol Volume state to release.
+ */
+void comp_sw_vol_fini(struct comp_sw_vol *vol);
+
+/**
+ * Compress or decompress a chunk on one of the worker threads. The callback is
+ * executed on the calling thread. A compress request is rejected with -ENOSPC
+ * when the volume's recent data does not compress well enough to be worth the
+ * CPU time; reduce then stores the chunk uncompressed. -ENOMEM means all of the
+ * volume's tasks are in use, the caller should queue the operation and submit
+ * it again from the volume's resume_fn.
+ *
+ * \param vol Volume the chunk belongs to.
+ * \param compress true to compress, false to decompress.
+ * \param src_iovs Source buffers.
+ * \param src_iovcnt Number of source buffers.
+ * \param dst_iovs Destination buffers.
+ * \param dst_iovcnt Number of destination buffers.
+ * \param cb_fn Completion callback.
+ * \param cb_arg Argument passed to cb_fn.
+ * \return 0 if the operation was submitted, negative errno otherwise. cb_fn is
+ * not called when an error is returned.
+ */
+int comp_sw_submit(struct comp_sw_vol *vol, bool compress,
+		   struct iovec *src_iovs, int src_iovcnt,
+		   struct iovec *dst_iovs, int dst_iovcnt,
+		   comp_sw_done_fn cb_fn, void *cb_arg);
+
+/**
+ * Write the volume's compression ratio and latency statistics as a JSON object.
+ *
+ * \param vol Volume to report on.
+ * \param w JSON write context.
+ */
+void comp_sw_vol_dump_stats(const struct comp_sw_vol *vol, struct spdk_json_write_ctx *w);
+
+#endif /* SPDK_VBDEV_COMPRESS_SW_H */
@@ -32,6 +32,7 @@
  */
 
 #include "vbdev_crypto.h"
+#include "vbdev_crypto_ipsec_mb.h"
 
 #include "spdk/env.h"
 #include "spdk/conf.h"
@@ -51,7 +52,7 @@
  * Note that the string names are defined by the DPDK PMD in question so be
  * sure to use the exact names.
  */
-#define MAX_NUM_DRV_TYPES 2
+#define MAX_NUM_DRV_TYPES 3
 
 /* The VF spread is the number of queue pairs between virtual functions, we use this to
  * load balance the QAT device.
@@ -60,7 +61,7 @@
 static uint8_t g_qat_total_qp = 0;
 static uint8_t g_next_qat_index;
 
-const char *g_driver_names[MAX_NUM_DRV_TYPES] = { AESNI_MB, QAT };
+const char *g_driver_names[MAX_NUM_DRV_TYPES] = { AESNI_MB, QAT, IPSEC_MB };
 
 /* Global list of available crypto devices. */
 struct vbdev_dev {
@@ -176,6 +177,7 @@ struct vbdev_crypto {
 	struct rte_cryptodev_sym_session *session_encrypt;	/* encryption session for this bdev */
 	struct rte_cryptodev_sym_session *session_decrypt;	/* decryption session for this bdev */
 	struct rte_crypto_sym_xform	cipher_xform;		/* crypto control struct for this bdev */
+	struct crypto_ipsec_mb_key	*mb_key;		/* expanded keys, IPSEC_MB only */
 	TAILQ_ENTRY(vbdev_crypto)	link;
 	struct spdk_thread		*thread;		/* thread where base device is opened */
 };
@@ -208,6 +210,8 @@ struct crypto_io_channel {
 	TAILQ_HEAD(, spdk_bdev_io)	pending_cry_ios;	/* outstanding operations to the crypto device */
 	struct spdk_io_channel_iter	*iter;			/* used with for_each_channel in reset */
 	TAILQ_HEAD(, vbdev_crypto_op)	queued_cry_ops;		/* queued for re-submission to CryptoDev */
+	struct crypto_ipsec_mb_mgr	*mb_mgr;		/* used instead of device_qp */
+	TAILQ_HEAD(, crypto_bdev_io)	queued_sw_ios;		/* next IPSEC_MB batch */
 };
 
 /* This is the crypto per IO context that the bdev layer allocates for us opaquely and attaches to
@@ -221,6 +225,7 @@ struct crypto_bdev_io {
 	struct spdk_bdev_io *read_io;			/* the read IO we issued */
 	int8_t bdev_io_status;				/* the status we'll report back on the bdev IO */
 	bool on_pending_list;
+	TAILQ_ENTRY(crypto_bdev_io) sw_link;		/* on queued_sw_ios */
 	/* Used for the single contiguous buffer that serves as the crypto destination target for writes */
 	uint64_t aux_num_blocks;			/* num of blocks for the contiguous buffer */
 	uint64_t aux_offset_blocks;			/* block offset on media */
@@ -674,6 +679,153 @@ crypto_dev_poller(void *args)
 	return num_dequeued_ops;
 }
 
+/* For encryption, we need to prepare a single contiguous buffer as the encryption
+ * destination, we'll then pass that along for the write after encryption is done.
+ * This is done to avoiding encrypting the provided write buffer which may be
+ * undesirable in some use cases.
+ */
+static void
+_crypto_setup_aux_buf(struct spdk_bdev_io *bdev_io, void *aux_buf)
+{
+	struct crypto_bdev_io *io_ctx = (struct crypto_bdev_io *)bdev_io->driver_ctx;
+	uint64_t alignment = spdk_bdev_get_buf_align(&io_ctx->crypto_bdev->crypto_bdev);
+
+	io_ctx->aux_buf_iov.iov_len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+	io_ctx->aux_buf_raw = aux_buf;
+	io_ctx->aux_buf_iov.iov_base = (void *)(((uintptr_t)aux_buf + (alignment - 1)) &
+					       ~(alignment - 1));
+	io_ctx->aux_offset_blocks = bdev_io->u.bdev.offset_blocks;
+	io_ctx->aux_num_blocks = bdev_io->u.bdev.num_blocks;
+}
+
+/* Called by the ipsec-mb manager for every block it hands back. Mirrors what
+ * crypto_dev_poller() does for a dequeued crypto op.
+ */
+static void
+_crypto_sw_block_done(void *cb_arg, int status)
+{
+	struct spdk_bdev_io *bdev_io = cb_arg;
+	struct crypto_bdev_io *io_ctx = (struct crypto_bdev_io *)bdev_io->driver_ctx;
+
+	if (status != 0) {
+		io_ctx->bdev_io_status = SPDK_BDEV_IO_STATUS_FAILED;
+	}
+
+	assert(io_ctx->cryop_cnt_remaining > 0);
+	if (--io_ctx->cryop_cnt_remaining == 0) {
+		if (io_ctx->crypto_ch->iter) {
+			io_ctx->bdev_io_status = SPDK_BDEV_IO_STATUS_FAILED;
+		}
+		_crypto_operation_complete(bdev_io);
+	}
+}
+
+/* Hand every block of one bdev_io to the ipsec-mb manager. Reads are decrypted
+ * in place in the buffer we read into, writes are encrypted straight from the
+ * host buffer into the aux buffer so there is no extra copy either way.
+ */
+static void
+_crypto_sw_submit_io(struct crypto_io_channel *crypto_ch, struct crypto_bdev_io *io_ctx)
+{
+	struct spdk_bdev_io *bdev_io = io_ctx->orig_io;
+	struct vbdev_crypto *crypto_bdev = io_ctx->crypto_bdev;
+	uint32_t crypto_len = crypto_bdev->crypto_bdev.blocklen;
+	uint64_t num_blocks = bdev_io->u.bdev.num_blocks;
+	bool encrypt = bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE;
+	uint8_t *en_buf = io_ctx->aux_buf_iov.iov_base;
+	uint8_t *current_iov;
+	uint64_t current_iov_remaining;
+	uint32_t iov_index = 0;
+	uint64_t i;
+	int rc;
+
+	current_iov = bdev_io->u.bdev.iovs[iov_index].iov_base;
+	current_iov_remaining = bdev_io->u.bdev.iovs[iov_index].iov_len;
+	for (i = 0; i < num_blocks; i++) {
+		rc = crypto_ipsec_mb_submit(crypto_ch->mb_mgr, crypto_bdev->mb_key, encrypt,
+					    current_iov, encrypt ? en_buf : current_iov, crypto_len,
+					    bdev_io->u.bdev.offset_blocks + i, bdev_io);
+		if (rc) {
+			SPDK_ERRLOG("ERROR submitting block to ipsec-mb, rc %d\n", rc);
+			/* Account for the blocks that will never complete. */
+			io_ctx->bdev_io_status = SPDK_BDEV_IO_STATUS_FAILED;
+			io_ctx->cryop_cnt_remaining -= num_blocks - i;
+			if (io_ctx->cryop_cnt_remaining == 0) {
+				_crypto_operation_complete(bdev_io);
+			}
+			return;
+		}
+
+		if (encrypt) {
+			en_buf += crypto_len;
+		}
+		current_iov += crypto_len;
+		current_iov_remaining -= crypto_len;
+		if (current_iov_remaining == 0 && i + 1 < num_blocks) {
+			iov_index++;
+			current_iov = bdev_io->u.bdev.iovs[iov_index].iov_base;
+			current_iov_remaining = bdev_io->u.bdev.iovs[iov_index].iov_len;
+		}
+	}
+}
+
+/* Poller for channels using IPSEC_MB. All bdev_ios that queued up since the last
+ * run are fed to the manager together so that blocks from different IOs fill
+ * the parallel lanes, then whatever is left in the lanes is flushed.
+ */
+static int
+crypto_sw_poller(void *args)
+{
+	struct crypto_io_channel *crypto_ch = args;
+	TAILQ_HEAD(, crypto_bdev_io) batch;
+	struct crypto_bdev_io *io_ctx;
+	int num_completed = 0;
+
+	if (!TAILQ_EMPTY(&crypto_ch->queued_sw_ios)) {
+		/* Anything queued from a completion callback waits for the next run. */
+		TAILQ_INIT(&batch);
+		TAILQ_SWAP(&crypto_ch->queued_sw_ios, &batch, crypto_bdev_io, sw_link);
+
+		while ((io_ctx = TAILQ_FIRST(&batch))) {
+			TAILQ_REMOVE(&batch, io_ctx, sw_link);
+			num_completed += io_ctx->orig_io->u.bdev.num_blocks;
+			_crypto_sw_submit_io(crypto_ch, io_ctx);
+		}
+		crypto_ipsec_mb_flush(crypto_ch->mb_mgr);
+	}
+
+	/* Same quiesce handling as crypto_dev_poller(). */
+	if (crypto_ch->iter && TAILQ_EMPTY(&crypto_ch->pending_cry_ios)) {
+		SPDK_NOTICELOG("Channel %p has been quiesced.\n", crypto_ch);
+		spdk_for_each_channel_continue(crypto_ch->iter, 0);
+		crypto_ch->iter = NULL;
+	}
+
+	return num_completed;
+}
+
+/* IPSEC_MB version of _crypto_operation(). There are no mbufs or crypto ops to
+ * allocate, the bdev_io is just parked until the poller builds the next batch.
+ */
+static int
+_crypto_sw_operation(struct spdk_bdev_io *bdev_io, enum rte_crypto_cipher_operation crypto_op,
+		     void *aux_buf)
+{
+	struct crypto_bdev_io *io_ctx = (struct crypto_bdev_io *)bdev_io->driver_ctx;
+	struct crypto_io_channel *crypto_ch = io_ctx->crypto_ch;
+
+	if (crypto_op == RTE_CRYPTO_CIPHER_OP_ENCRYPT) {
+		_crypto_setup_aux_buf(bdev_io, aux_buf);
+	}
+
+	io_ctx->cryop_cnt_remaining = bdev_io->u.bdev.num_blocks;
+	TAILQ_INSERT_TAIL(&crypto_ch->pending_cry_ios, bdev_io, module_link);
+	io_ctx->on_pending_list = true;
+	TAILQ_INSERT_TAIL(&crypto_ch->queued_sw_ios, io_ctx, sw_link);
+
+	return 0;
+}
+
 /* We're either encrypting on the way down or decrypting on the way back. */
 static int
 _crypto_operation(struct spdk_bdev_io *bdev_io, enum rte_crypto_cipher_operation crypto_op,
@@ -683,7 +835,7 @@ _crypto_operation(struct spdk_bdev_io *bdev_io, enum rte_crypto_cipher_operation
 	uint32_t cryop_cnt = bdev_io->u.bdev.num_blocks;
 	struct crypto_bdev_io *io_ctx = (struct crypto_bdev_io *)bdev_io->driver_ctx;
 	struct crypto_io_channel *crypto_ch = io_ctx->crypto_ch;
-	uint8_t cdev_id = crypto_ch->device_qp->device->cdev_id;
+	uint8_t cdev_id;
 	uint32_t crypto_len = io_ctx->crypto_bdev->crypto_bdev.blocklen;
 	uint64_t total_length = bdev_io->u.bdev.num_blocks * crypto_len;
 	int rc;
@@ -699,10 +851,14 @@ _crypto_operation(struct spdk_bdev_io *bdev_io, enum rte_crypto_cipher_operation
 	struct rte_mbuf *dst_mbufs[MAX_ENQUEUE_ARRAY_SIZE];
 	int burst;
 	struct vbdev_crypto_op *op_to_queue;
-	uint64_t alignment = spdk_bdev_get_buf_align(&io_ctx->crypto_bdev->crypto_bdev);
 
 	assert((bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen) <= CRYPTO_MAX_IO);
 
+	if (crypto_ch->mb_mgr != NULL) {
+		return _crypto_sw_operation(bdev_io, crypto_op, aux_buf);
+	}
+	cdev_id = crypto_ch->device_qp->device->cdev_id;
+
 	/* Get the number of source mbufs that we need. These will always be 1:1 because we
 	 * don't support chaining. The reason we don't is because of our decision to use
 	 * LBA as IV, there can be no case where we'd need >1 mbuf per crypto op or the
@@ -738,17 +894,8 @@ _crypto_operation(struct spdk_bdev_io *bdev_io, enum rte_crypto_cipher_operation
 		goto error_get_ops;
 	}
 
-	/* For encryption, we need to prepare a single contiguous buffer as the encryption
-	 * destination, we'll then pass that along for the write after encryption is done.
-	 * This is done to avoiding encrypting the provided write buffer which may be
-	 * undesirable in some use cases.
-	 */
 	if (crypto_op == RTE_CRYPTO_CIPHER_OP_ENCRYPT) {
-		io_ctx->aux_buf_iov.iov_len = total_length;
-		io_ctx->aux_buf_raw = aux_buf;
-		io_ctx->aux_buf_iov.iov_base  = (void *)(((uintptr_t)aux_buf + (alignment - 1)) & ~(alignment - 1));
-		io_ctx->aux_offset_blocks = bdev_io->u.bdev.offset_blocks;
-		io_ctx->aux_num_blocks = bdev_io->u.bdev.num_blocks;
+		_crypto_setup_aux_buf(bdev_io, aux_buf);
 	}
 
 	/* This value is used in the completion callback to determine when the bdev_io is
@@ -1201,8 +1348,12 @@ _device_unregister_cb(void *io_device)
 	struct vbdev_crypto *crypto_bdev = io_device;
 
 	/* Done with this crypto_bdev. */
-	rte_cryptodev_sym_session_free(crypto_bdev->session_decrypt);
-	rte_cryptodev_sym_session_free(crypto_bdev->session_encrypt);
+	if (crypto_bdev->mb_key != NULL) {
+		crypto_ipsec_mb_key_free(crypto_bdev->mb_key);
+	} else {
+		rte_cryptodev_sym_session_free(crypto_bdev->session_decrypt);
+		rte_cryptodev_sym_session_free(crypto_bdev->session_encrypt);
+	}
 	free(crypto_bdev->drv_name);
 	if (crypto_bdev->key) {
 		memset(crypto_bdev->key, 0, strnlen(crypto_bdev->key, (AES_CBC_KEY_LENGTH + 1)));
@@ -1372,12 +1523,24 @@ crypto_bdev_ch_create_cb(void *io_device, void *ctx_buf)
 	struct device_qp *device_qp = NULL;
 
 	crypto_ch->base_ch = spdk_bdev_get_io_channel(crypto_bdev->base_desc);
-	crypto_ch->poller = SPDK_POLLER_REGISTER(crypto_dev_poller, crypto_ch, 0);
 	crypto_ch->device_qp = NULL;
+	crypto_ch->mb_mgr = NULL;
+
+	if (strcmp(crypto_bdev->drv_name, IPSEC_MB) == 0) {
+		/* No cryptodev involved, each channel gets its own multi-buffer manager. */
+		crypto_ch->mb_mgr = crypto_ipsec_mb_mgr_create(_crypto_sw_block_done);
+		if (crypto_ch->mb_mgr == NULL) {
+			spdk_put_io_channel(crypto_ch->base_ch);
+			return -ENOMEM;
+		}
+		crypto_ch->poller = SPDK_POLLER_REGISTER(crypto_sw_poller, crypto_ch, 0);
+	} else {
+		crypto_ch->poller = SPDK_POLLER_REGISTER(crypto_dev_poller, crypto_ch, 0);
 
-	/* Assign a device/qp combination that is unique per channel per PMD. */
-	_assign_device_qp(crypto_bdev, device_qp, crypto_ch);
-	assert(crypto_ch->device_qp);
+		/* Assign a device/qp combination that is unique per channel per PMD. */
+		_assign_device_qp(crypto_bdev, device_qp, crypto_ch);
+		assert(crypto_ch->device_qp);
+	}
 
 	/* We use this queue to track outstanding IO in our layer. */
 	TAILQ_INIT(&crypto_ch->pending_cry_ios);
@@ -1385,6 +1548,9 @@ crypto_bdev_ch_create_cb(void *io_device, void *ctx_buf)
 	/* We use this to queue up crypto ops when the device is busy. */
 	TAILQ_INIT(&crypto_ch->queued_cry_ops);
 
+	/* And this to collect IOs for the next IPSEC_MB batch. */
+	TAILQ_INIT(&crypto_ch->queued_sw_ios);
+
 	return 0;
 }
 
@@ -1397,9 +1563,14 @@ crypto_bdev_ch_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct crypto_io_channel *crypto_ch = ctx_buf;
 
-	pthread_mutex_lock(&g_device_qp_lock);
-	crypto_ch->device_qp->in_use = false;
-	pthread_mutex_unlock(&g_device_qp_lock);
+	if (crypto_ch->mb_mgr != NULL) {
+		assert(TAILQ_EMPTY(&crypto_ch->queued_sw_ios));
+		crypto_ipsec_mb_mgr_free(crypto_ch->mb_mgr);
+	} else {
+		pthread_mutex_lock(&g_device_qp_lock);
+		crypto_ch->device_qp->in_use = false;
+		pthread_mutex_unlock(&g_device_qp_lock);
+	}
 
 	spdk_poller_unregister(&crypto_ch->poller);
 	spdk_put_io_channel(crypto_ch->base_ch);
@@ -1755,13 +1926,90 @@ static struct spdk_bdev_module crypto_if = {
 
 SPDK_BDEV_MODULE_REGISTER(crypto, &crypto_if)
 
+/* Set up the cryptodev encrypt/decrypt sessions for a newly claimed vbdev. */
+static int
+_crypto_create_sessions(struct vbdev_crypto *vbdev, const char *cipher)
+{
+	struct vbdev_dev *device;
+	bool found = false;
+	int rc;
+
+	/* To init the session we have to get the cryptoDev device ID for this vbdev */
+	TAILQ_FOREACH(device, &g_vbdev_devs, link) {
+		if (strcmp(device->cdev_info.driver_name, vbdev->drv_name) == 0) {
+			found = true;
+			break;
+		}
+	}
+	if (found == false) {
+		SPDK_ERRLOG("ERROR can't match crypto device driver to crypto vbdev!\n");
+		return -EINVAL;
+	}
+
+	/* Get sessions. */
+	vbdev->session_encrypt = rte_cryptodev_sym_session_create(g_session_mp);
+	if (NULL == vbdev->session_encrypt) {
+		SPDK_ERRLOG("ERROR trying to create crypto session!\n");
+		return -EINVAL;
+	}
+
+	vbdev->session_decrypt = rte_cryptodev_sym_session_create(g_session_mp);
+	if (NULL == vbdev->session_decrypt) {
+		SPDK_ERRLOG("ERROR trying to create crypto session!\n");
+		rc = -EINVAL;
+		goto error_session_de_create;
+	}
+
+	/* Init our per vbdev xform with the desired cipher options. */
+	vbdev->cipher_xform.type = RTE_CRYPTO_SYM_XFORM_CIPHER;
+	vbdev->cipher_xform.cipher.iv.offset = IV_OFFSET;
+	if (strcmp(cipher, AES_CBC) == 0) {
+		vbdev->cipher_xform.cipher.key.data = vbdev->key;
+		vbdev->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_AES_CBC;
+		vbdev->cipher_xform.cipher.key.length = AES_CBC_KEY_LENGTH;
+	} else {
+		vbdev->cipher_xform.cipher.key.data = vbdev->xts_key;
+		vbdev->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_AES_XTS;
+		vbdev->cipher_xform.cipher.key.length = AES_XTS_KEY_LENGTH * 2;
+	}
+	vbdev->cipher_xform.cipher.iv.length = AES_CBC_IV_LENGTH;
+
+	vbdev->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_ENCRYPT;
+	rc = rte_cryptodev_sym_session_init(device->cdev_id, vbdev->session_encrypt,
+					    &vbdev->cipher_xform,
+					    g_session_mp_priv ? g_session_mp_priv : g_session_mp);
+	if (rc < 0) {
+		SPDK_ERRLOG("ERROR trying to init encrypt session!\n");
+		rc = -EINVAL;
+		goto error_session_init;
+	}
+
+	vbdev->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_DECRYPT;
+	rc = rte_cryptodev_sym_session_init(device->cdev_id, vbdev->session_decrypt,
+					    &vbdev->cipher_xform,
+					    g_session_mp_priv ? g_session_mp_priv : g_session_mp);
+	if (rc < 0) {
+		SPDK_ERRLOG("ERROR trying to init decrypt session!\n");
+		rc = -EINVAL;
+		goto error_session_init;
+	}
+
+	return 0;
+
+error_session_init:
+	rte_cryptodev_sym_session_free(vbdev->session_decrypt);
+error_session_de_create:
+	rte_cryptodev_sym_session_free(vbdev->session_encrypt);
+	vbdev->session_decrypt = NULL;
+	vbdev->session_encrypt = NULL;
+	return rc;
+}
+
 static int
 vbdev_crypto_claim(struct spdk_bdev *bdev)
 {
 	struct bdev_names *name;
 	struct vbdev_crypto *vbdev;
-	struct vbdev_dev *device;
-	bool found = false;
 	int rc = 0;
 
 	if (g_number_of_claimed_volumes >= MAX_CRYPTO_VOLUMES) {
@@ -1845,6 +2093,10 @@ vbdev_crypto_claim(struct spdk_bdev *bdev)
 			}
 		} else {
 			vbdev->crypto_bdev.required_alignment = bdev->required_alignment;
+			if (strcmp(vbdev->drv_name, IPSEC_MB) == 0 &&
+			    strcmp(name->cipher, AES_XTS) == 0) {
+				vbdev->cipher = AES_XTS;
+			}
 		}
 		/* Note: CRYPTO_MAX_IO is in units of bytes, optimal_io_boundary is
 		 * in units of blocks.
@@ -1886,66 +2138,20 @@ vbdev_crypto_claim(struct spdk_bdev *bdev)
 			goto error_claim;
 		}
 
-		/* To init the session we have to get the cryptoDev device ID for this vbdev */
-		TAILQ_FOREACH(device, &g_vbdev_devs, link) {
-			if (strcmp(device->cdev_info.driver_name, vbdev->drv_name) == 0) {
-				found = true;
-				break;
+		if (strcmp(vbdev->drv_name, IPSEC_MB) == 0) {
+			/* The software path has no device or sessions, just expanded keys. */
+			vbdev->mb_key = crypto_ipsec_mb_key_create(vbdev->cipher, vbdev->key,
+					vbdev->key2);
+			if (vbdev->mb_key == NULL) {
+				SPDK_ERRLOG("ERROR trying to expand ipsec-mb keys!\n");
+				rc = -ENOMEM;
+				goto error_session_create;
 			}
-		}
-		if (found == false) {
-			SPDK_ERRLOG("ERROR can't match crypto device driver to crypto vbdev!\n");
-			rc = -EINVAL;
-			goto error_cant_find_devid;
-		}
-
-		/* Get sessions. */
-		vbdev->session_encrypt = rte_cryptodev_sym_session_create(g_session_mp);
-		if (NULL == vbdev->session_encrypt) {
-			SPDK_ERRLOG("ERROR trying to create crypto session!\n");
-			rc = -EINVAL;
-			goto error_session_en_create;
-		}
-
-		vbdev->session_decrypt = rte_cryptodev_sym_session_create(g_session_mp);
-		if (NULL == vbdev->session_decrypt) {
-			SPDK_ERRLOG("ERROR trying to create crypto session!\n");
-			rc = -EINVAL;
-			goto error_session_de_create;
-		}
-
-		/* Init our per vbdev xform with the desired cipher options. */
-		vbdev->cipher_xform.type = RTE_CRYPTO_SYM_XFORM_CIPHER;
-		vbdev->cipher_xform.cipher.iv.offset = IV_OFFSET;
-		if (strcmp(name->cipher, AES_CBC) == 0) {
-			vbdev->cipher_xform.cipher.key.data = vbdev->key;
-			vbdev->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_AES_CBC;
-			vbdev->cipher_xform.cipher.key.length = AES_CBC_KEY_LENGTH;
 		} else {
-			vbdev->cipher_xform.cipher.key.data = vbdev->xts_key;
-			vbdev->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_AES_XTS;
-			vbdev->cipher_xform.cipher.key.length = AES_XTS_KEY_LENGTH * 2;
-		}
-		vbdev->cipher_xform.cipher.iv.length = AES_CBC_IV_LENGTH;
-
-		vbdev->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_ENCRYPT;
-		rc = rte_cryptodev_sym_session_init(device->cdev_id, vbdev->session_encrypt,
-						    &vbdev->cipher_xform,
-						    g_session_mp_priv ? g_session_mp_priv : g_session_mp);
-		if (rc < 0) {
-			SPDK_ERRLOG("ERROR trying to init encrypt session!\n");
-			rc = -EINVAL;
-			goto error_session_init;
-		}
-
-		vbdev->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_DECRYPT;
-		rc = rte_cryptodev_sym_session_init(device->cdev_id, vbdev->session_decrypt,
-						    &vbdev->cipher_xform,
-						    g_session_mp_priv ? g_session_mp_priv : g_session_mp);
-		if (rc < 0) {
-			SPDK_ERRLOG("ERROR trying to init decrypt session!\n");
-			rc = -EINVAL;
-			goto error_session_init;
+			rc = _crypto_create_sessions(vbdev, name->cipher);
+			if (rc) {
+				goto error_session_create;
+			}
 		}
 
 		rc = spdk_bdev_register(&vbdev->crypto_bdev);
@@ -1963,12 +2169,13 @@ vbdev_crypto_claim(struct spdk_bdev *bdev)
 
 	/* Error cleanup paths. */
 error_bdev_register:
-error_session_init:
-	rte_cryptodev_sym_session_free(vbdev->session_decrypt);
-error_session_de_create:
-	rte_cryptodev_sym_session_free(vbdev->session_encrypt);
-error_session_en_create:
-error_cant_find_devid:
+	if (vbdev->mb_key != NULL) {
+		crypto_ipsec_mb_key_free(vbdev->mb_key);
+	} else {
+		rte_cryptodev_sym_session_free(vbdev->session_decrypt);
+		rte_cryptodev_sym_session_free(vbdev->session_encrypt);
+	}
+error_session_create:
 error_claim:
 	spdk_bdev_close(vbdev->base_desc);
 error_open:
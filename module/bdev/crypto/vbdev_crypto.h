@@ -43,10 +43,12 @@
 
 #define AESNI_MB "crypto_aesni_mb"
 #define QAT "crypto_qat"
+/* Not a DPDK PMD, calls intel-ipsec-mb directly from the channel poller. */
+#define IPSEC_MB "ipsec_mb"
 
 /* Supported ciphers */
-#define AES_CBC "AES_CBC" /* QAT and AESNI_MB */
-#define AES_XTS "AES_XTS" /* QAT only */
+#define AES_CBC "AES_CBC" /* QAT, AESNI_MB and IPSEC_MB */
+#define AES_XTS "AES_XTS" /* QAT and IPSEC_MB */
 
 typedef void (*spdk_delete_crypto_complete)(void *cb_arg, int bdeverrno);
 
@@ -0,0 +1,101 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef SPDK_VBDEV_CRYPTO_IPSEC_MB_H
+#define SPDK_VBDEV_CRYPTO_IPSEC_MB_H
+
+#include "spdk/stdinc.h"
+
+/* Software crypto backend built directly on intel-ipsec-mb. Instead of going
+ * through a cryptodev queue pair, each channel owns a multi-buffer manager and
+ * submits one job per logical block. The manager processes jobs from several
+ * bdev_ios in parallel lanes and hands them back in submission order.
+ */
+struct crypto_ipsec_mb_key;
+struct crypto_ipsec_mb_mgr;
+
+/* Called once per completed block with the cb_arg given at submission. */
+typedef void (*crypto_ipsec_mb_cb)(void *cb_arg, int status);
+
+/**
+ * Expand the keys for one crypto vbdev.
+ *
+ * \param cipher AES_CBC or AES_XTS.
+ * \param key Data key, AES_CBC_KEY_LENGTH bytes.
+ * \param key2 Tweak key for AES_XTS, AES_XTS_KEY_LENGTH bytes, NULL for AES_CBC.
+ * \return the expanded key schedule or NULL on failure.
+ */
+struct crypto_ipsec_mb_key *crypto_ipsec_mb_key_create(const char *cipher, const uint8_t *key,
+		const uint8_t *key2);
+
+/**
+ * Wipe and free a key schedule created with crypto_ipsec_mb_key_create().
+ */
+void crypto_ipsec_mb_key_free(struct crypto_ipsec_mb_key *key);
+
+/**
+ * Allocate a multi-buffer manager. A manager is not thread safe, so one is
+ * used per crypto channel.
+ *
+ * \param cb_fn Block completion callback.
+ * \return the manager or NULL on failure.
+ */
+struct crypto_ipsec_mb_mgr *crypto_ipsec_mb_mgr_create(crypto_ipsec_mb_cb cb_fn);
+
+/**
+ * Free a manager. All submitted blocks must have been flushed.
+ */
+void crypto_ipsec_mb_mgr_free(struct crypto_ipsec_mb_mgr *mgr);
+
+/**
+ * Submit one logical block. The LBA is used as IV (AES_CBC) or tweak
+ * (AES_XTS), matching what the cryptodev path puts on the media. src and
+ * dst may be the same buffer. The completion callback may run from within
+ * this call for previously submitted blocks.
+ *
+ * \return 0 on success, negative errno on failure, in which case the
+ * callback will not be called for this block.
+ */
+int crypto_ipsec_mb_submit(struct crypto_ipsec_mb_mgr *mgr, struct crypto_ipsec_mb_key *key,
+			   bool encrypt, const void *src, void *dst, uint32_t len,
+			   uint64_t lba, void *cb_arg);
+
+/**
+ * Complete everything that is still held in the manager lanes.
+ *
+ * \return the number of blocks completed.
+ */
+int crypto_ipsec_mb_flush(struct crypto_ipsec_mb_mgr *mgr);
+
+#endif /* SPDK_VBDEV_CRYPTO_IPSEC_MB_H */
@@ -102,7 +102,8 @@ rpc_bdev_crypto_create(struct spdk_jsonrpc_request *request,
 
 	if (strcmp(req.crypto_pmd, AESNI_MB) == 0 && strcmp(req.cipher, AES_XTS) == 0) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
-						 "Invalid cipher. AES_XTS is only available on QAT.");
+						 "Invalid cipher. AES_XTS is only available on QAT "
+						 "and ipsec_mb.");
 		goto cleanup;
 	}
 
@@ -1219,6 +1219,52 @@ _vbdev_lvol_examine_close_cb(struct spdk_lvol_store *lvs)
 	}
 }
 
+static void
+_vbdev_lvol_resume_inflate_cb(void *cb_arg, int lvolerrno)
+{
+	char *unique_id = cb_arg;
+
+	if (lvolerrno == -ECANCELED) {
+		SPDK_NOTICELOG("Resumed inflate of lvol %s canceled, it resumes on next load\n",
+			       unique_id);
+	} else if (lvolerrno != 0) {
+		SPDK_ERRLOG("Resumed inflate of lvol %s failed: %s\n", unique_id,
+			    spdk_strerror(-lvolerrno));
+	} else {
+		SPDK_NOTICELOG("Resumed inflate of lvol %s completed\n", unique_id);
+	}
+
+	free(unique_id);
+}
+
+static void
+_vbdev_lvol_resume_inflate(struct spdk_lvol *lvol)
+{
+	struct spdk_blob_inflate_opts opts;
+	bool allocate_all;
+	char *unique_id;
+
+	/* An inflate or decouple interrupted by shutdown is recorded in the blob */
+	if (spdk_blob_get_inflate_checkpoint(lvol->blob, &opts, &allocate_all) != 0) {
+		return;
+	}
+
+	unique_id = strdup(lvol->unique_id);
+	if (unique_id == NULL) {
+		SPDK_ERRLOG("Cannot resume inflate of lvol %s\n", lvol->unique_id);
+		return;
+	}
+
+	SPDK_NOTICELOG("Resuming interrupted %s of lvol %s\n",
+		       allocate_all ? "inflate" : "parent decouple", lvol->unique_id);
+	if (allocate_all) {
+		spdk_lvol_inflate_ext(lvol, &opts, _vbdev_lvol_resume_inflate_cb, unique_id);
+	} else {
+		spdk_lvol_decouple_parent_ext(lvol, &opts, _vbdev_lvol_resume_inflate_cb,
+					      unique_id);
+	}
+}
+
 static void
 _vbdev_lvs_examine_finish(void *cb_arg, struct spdk_lvol *lvol, int lvolerrno)
 {
@@ -1243,6 +1289,8 @@ _vbdev_lvs_examine_finish(void *cb_arg, struct spdk_lvol *lvol, int lvolerrno)
 	lvs->lvols_opened++;
 	SPDK_INFOLOG(SPDK_LOG_VBDEV_LVOL, "Opening lvol %s succeeded\n", lvol->unique_id);
 
+	_vbdev_lvol_resume_inflate(lvol);
+
 end:
 
 	if (lvs->lvols_opened >= lvs->lvol_count) {
@@ -33,6 +33,7 @@
 
 #include "spdk/rpc.h"
 #include "spdk/bdev.h"
+#include "spdk/env.h"
 #include "spdk/util.h"
 #include "vbdev_lvol.h"
 #include "spdk/string.h"
@@ -648,6 +649,9 @@ SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_lvol_rename, rename_lvol_bdev)
 
 struct rpc_bdev_lvol_inflate {
 	char *name;
+	uint64_t max_clusters_per_sec;
+	uint64_t max_bytes_per_sec;
+	bool background;
 };
 
 static void
@@ -658,6 +662,9 @@ free_rpc_bdev_lvol_inflate(struct rpc_bdev_lvol_inflate *req)
 
 static const struct spdk_json_object_decoder rpc_bdev_lvol_inflate_decoders[] = {
 	{"name", offsetof(struct rpc_bdev_lvol_inflate, name), spdk_json_decode_string},
+	{"max_clusters_per_sec", offsetof(struct rpc_bdev_lvol_inflate, max_clusters_per_sec), spdk_json_decode_uint64, true},
+	{"max_bytes_per_sec", offsetof(struct rpc_bdev_lvol_inflate, max_bytes_per_sec), spdk_json_decode_uint64, true},
+	{"background", offsetof(struct rpc_bdev_lvol_inflate, background), spdk_json_decode_bool, true},
 };
 
 static void
@@ -681,14 +688,32 @@ invalid:
 }
 
 static void
-rpc_bdev_lvol_inflate(struct spdk_jsonrpc_request *request,
-		      const struct spdk_json_val *params)
+rpc_bdev_lvol_inflate_background_cb(void *cb_arg, int lvolerrno)
+{
+	char *name = cb_arg;
+
+	if (lvolerrno == -ECANCELED) {
+		SPDK_NOTICELOG("Inflate of lvol %s canceled, it resumes on next load\n", name);
+	} else if (lvolerrno != 0) {
+		SPDK_ERRLOG("Inflate of lvol %s failed: %s\n", name, spdk_strerror(-lvolerrno));
+	} else {
+		SPDK_NOTICELOG("Inflate of lvol %s completed\n", name);
+	}
+
+	free(name);
+}
+
+static void
+rpc_bdev_lvol_inflate_start(struct spdk_jsonrpc_request *request,
+			    const struct spdk_json_val *params, bool allocate_all)
 {
 	struct rpc_bdev_lvol_inflate req = {};
+	struct spdk_blob_inflate_opts opts;
+	struct spdk_json_write_ctx *w;
 	struct spdk_bdev *bdev;
 	struct spdk_lvol *lvol;
-
-	SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "Inflating lvol\n");
+	spdk_lvol_op_complete cb_fn = rpc_bdev_lvol_inflate_cb;
+	void *cb_arg = request;
 
 	if (spdk_json_decode_object(params, rpc_bdev_lvol_inflate_decoders,
 				    SPDK_COUNTOF(rpc_bdev_lvol_inflate_decoders),
@@ -713,12 +738,43 @@ rpc_bdev_lvol_inflate(struct spdk_jsonrpc_request *request,
 		goto cleanup;
 	}
 
-	spdk_lvol_inflate(lvol, rpc_bdev_lvol_inflate_cb, request);
+	spdk_blob_inflate_opts_init(&opts);
+	opts.max_clusters_per_sec = req.max_clusters_per_sec;
+	opts.max_bytes_per_sec = req.max_bytes_per_sec;
+
+	if (req.background) {
+		/* Respond right away, the progress is reported by bdev_lvol_get_inflate_progress */
+		cb_arg = strdup(req.name);
+		if (cb_arg == NULL) {
+			spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+			goto cleanup;
+		}
+		cb_fn = rpc_bdev_lvol_inflate_background_cb;
+
+		w = spdk_jsonrpc_begin_result(request);
+		spdk_json_write_bool(w, true);
+		spdk_jsonrpc_end_result(request, w);
+	}
+
+	if (allocate_all) {
+		spdk_lvol_inflate_ext(lvol, &opts, cb_fn, cb_arg);
+	} else {
+		spdk_lvol_decouple_parent_ext(lvol, &opts, cb_fn, cb_arg);
+	}
 
 cleanup:
 	free_rpc_bdev_lvol_inflate(&req);
 }
 
+static void
+rpc_bdev_lvol_inflate(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "Inflating lvol\n");
+
+	rpc_bdev_lvol_inflate_start(request, params, true);
+}
+
 SPDK_RPC_REGISTER("bdev_lvol_inflate", rpc_bdev_lvol_inflate, SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_lvol_inflate, inflate_lvol_bdev)
 
@@ -726,14 +782,43 @@ static void
 rpc_bdev_lvol_decouple_parent(struct spdk_jsonrpc_request *request,
 			      const struct spdk_json_val *params)
 {
-	struct rpc_bdev_lvol_inflate req = {};
+	SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "Decoupling parent of lvol\n");
+
+	rpc_bdev_lvol_inflate_start(request, params, false);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_decouple_parent", rpc_bdev_lvol_decouple_parent, SPDK_RPC_RUNTIME)
+SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_lvol_decouple_parent, decouple_parent_lvol_bdev)
+
+struct rpc_bdev_lvol_get_inflate_progress {
+	char *name;
+};
+
+static void
+free_rpc_bdev_lvol_get_inflate_progress(struct rpc_bdev_lvol_get_inflate_progress *req)
+{
+	free(req->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_get_inflate_progress_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_lvol_get_inflate_progress, name), spdk_json_decode_string},
+};
+
+static void
+rpc_bdev_lvol_get_inflate_progress(struct spdk_jsonrpc_request *request,
+				   const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_get_inflate_progress req = {};
+	struct spdk_blob_inflate_progress progress;
+	struct spdk_json_write_ctx *w;
 	struct spdk_bdev *bdev;
 	struct spdk_lvol *lvol;
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+	uint64_t eta_ms = 0;
+	int rc;
 
-	SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "Decoupling parent of lvol\n");
-
-	if (spdk_json_decode_object(params, rpc_bdev_lvol_inflate_decoders,
-				    SPDK_COUNTOF(rpc_bdev_lvol_inflate_decoders),
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_get_inflate_progress_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_get_inflate_progress_decoders),
 				    &req)) {
 		SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "spdk_json_decode_object failed\n");
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
@@ -755,14 +840,36 @@ rpc_bdev_lvol_decouple_parent(struct spdk_jsonrpc_request *request,
 		goto cleanup;
 	}
 
-	spdk_lvol_decouple_parent(lvol, rpc_bdev_lvol_inflate_cb, request);
+	rc = spdk_lvol_get_inflate_progress(lvol, &progress);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	/* Remaining clusters at the average rate so far */
+	if (progress.clusters_done != 0) {
+		eta_ms = progress.elapsed_ticks / progress.clusters_done *
+			 (progress.clusters_total - progress.clusters_done) * 1000 / ticks_hz;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "operation",
+				     progress.allocate_all ? "inflate" : "decouple_parent");
+	spdk_json_write_named_uint64(w, "clusters_total", progress.clusters_total);
+	spdk_json_write_named_uint64(w, "clusters_done", progress.clusters_done);
+	spdk_json_write_named_uint64(w, "elapsed_ms",
+				     progress.elapsed_ticks * 1000 / ticks_hz);
+	spdk_json_write_named_uint64(w, "eta_ms", eta_ms);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
 
 cleanup:
-	free_rpc_bdev_lvol_inflate(&req);
+	free_rpc_bdev_lvol_get_inflate_progress(&req);
 }
 
-SPDK_RPC_REGISTER("bdev_lvol_decouple_parent", rpc_bdev_lvol_decouple_parent, SPDK_RPC_RUNTIME)
-SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_lvol_decouple_parent, decouple_parent_lvol_bdev)
+SPDK_RPC_REGISTER("bdev_lvol_get_inflate_progress", rpc_bdev_lvol_get_inflate_progress,
+		  SPDK_RPC_RUNTIME)
 
 struct rpc_bdev_lvol_resize {
 	char *name;
@@ -1016,6 +1123,7 @@ static void
 rpc_dump_lvol_store_info(struct spdk_json_write_ctx *w, struct lvol_store_bdev *lvs_bdev)
 {
 	struct spdk_blob_store *bs;
+	struct spdk_lvol *lvol;
 	uint64_t cluster_size;
 	char uuid[SPDK_UUID_STRING_LEN];
 
@@ -1035,10 +1143,31 @@ rpc_dump_lvol_store_info(struct spdk_json_write_ctx *w, struct lvol_store_bdev *
 
 	spdk_json_write_named_uint64(w, "free_clusters", spdk_bs_free_cluster_count(bs));
 
+	spdk_json_write_named_uint64(w, "pending_unmap_clusters",
+				     spdk_bs_unmap_pending_cluster_count(bs));
+
 	spdk_json_write_named_uint64(w, "block_size", spdk_bs_get_io_unit_size(bs));
 
 	spdk_json_write_named_uint64(w, "cluster_size", cluster_size);
 
+	spdk_json_write_named_array_begin(w, "lvols");
+	TAILQ_FOREACH(lvol, &lvs_bdev->lvs->lvols, link) {
+		if (lvol->ref_count == 0) {
+			/* Closed, its blob is gone */
+			continue;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "name", lvol->name);
+		spdk_json_write_named_string(w, "uuid", lvol->uuid_str);
+		spdk_json_write_named_uint64(w, "allocated_clusters",
+					     spdk_blob_get_num_allocated_clusters(lvol->blob));
+		spdk_json_write_named_uint64(w, "shared_clusters",
+					     spdk_blob_get_num_shared_clusters(lvol->blob));
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
 	spdk_json_write_object_end(w);
 }
 
@@ -1096,3 +1225,59 @@ cleanup:
 
 SPDK_RPC_REGISTER("bdev_lvol_get_lvstores", rpc_bdev_lvol_get_lvstores, SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_lvol_get_lvstores, get_lvol_stores)
+
+struct rpc_bdev_lvol_set_unmap_rate_limit {
+	char *uuid;
+	char *lvs_name;
+	uint64_t max_bytes_per_sec;
+};
+
+static void
+free_rpc_bdev_lvol_set_unmap_rate_limit(struct rpc_bdev_lvol_set_unmap_rate_limit *req)
+{
+	free(req->uuid);
+	free(req->lvs_name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_set_unmap_rate_limit_decoders[] = {
+	{"uuid", offsetof(struct rpc_bdev_lvol_set_unmap_rate_limit, uuid), spdk_json_decode_string, true},
+	{"lvs_name", offsetof(struct rpc_bdev_lvol_set_unmap_rate_limit, lvs_name), spdk_json_decode_string, true},
+	{"max_bytes_per_sec", offsetof(struct rpc_bdev_lvol_set_unmap_rate_limit, max_bytes_per_sec), spdk_json_decode_uint64},
+};
+
+static void
+rpc_bdev_lvol_set_unmap_rate_limit(struct spdk_jsonrpc_request *request,
+				   const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_set_unmap_rate_limit req = {};
+	struct spdk_json_write_ctx *w;
+	struct spdk_lvol_store *lvs = NULL;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_set_unmap_rate_limit_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_set_unmap_rate_limit_decoders),
+				    &req)) {
+		SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = vbdev_get_lvol_store_by_uuid_xor_name(req.uuid, req.lvs_name, &lvs);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bs_set_unmap_rate_limit(lvs->blobstore, req.max_bytes_per_sec);
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_bool(w, true);
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	free_rpc_bdev_lvol_set_unmap_rate_limit(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_set_unmap_rate_limit", rpc_bdev_lvol_set_unmap_rate_limit,
+		  SPDK_RPC_RUNTIME)
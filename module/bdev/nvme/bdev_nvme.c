@@ -36,6 +36,7 @@
 #include "bdev_nvme.h"
 #include "bdev_ocssd.h"
 
+#include "spdk/accel_engine.h"
 #include "spdk/config.h"
 #include "spdk/conf.h"
 #include "spdk/endian.h"
@@ -43,6 +44,7 @@
 #include "spdk/json.h"
 #include "spdk/nvme.h"
 #include "spdk/nvme_ocssd.h"
+#include "spdk/nvme_zns.h"
 #include "spdk/thread.h"
 #include "spdk/string.h"
 #include "spdk/likely.h"
@@ -84,13 +86,56 @@ struct nvme_bdev_io {
 	/** Saved status for admin passthru completion event, PI error verification, or intermediate compare-and-write status */
 	struct spdk_nvme_cpl cpl;
 
-	/** Originating thread */
+	/** Originating thread, NULL if the I/O is completed on the thread it was submitted on */
 	struct spdk_thread *orig_thread;
 
 	/** Keeps track if first of fused commands was submitted */
 	bool first_fused_submitted;
+
+	/** Buffer for the zone report of a get zone info request */
+	struct spdk_nvme_zns_zone_report *zone_report_buf;
+
+	/** Size of zone_report_buf in bytes */
+	uint32_t zone_report_bufsize;
+
+	/** Number of zones already reported to the bdev layer */
+	uint32_t handled_zones;
+};
+
+/*
+ * With max_qpairs_per_ctrlr set, the channels of a controller share that many I/O
+ * qpairs at most. A shared qpair belongs to the thread that created it and is only
+ * polled there. Channels of other threads stage their I/O in a ring that only
+ * they enqueue to and only the owner dequeues from, so no lock is taken on the
+ * I/O path. The owner submits the staged I/O and sends each completion back to the
+ * submitting thread with a message.
+ */
+struct nvme_bdev_shared_qpair_stage {
+	struct spdk_ring				*ring;
+	struct nvme_bdev_shared_qpair			*shared_qpair;
+	TAILQ_ENTRY(nvme_bdev_shared_qpair_stage)	link;
+};
+
+struct nvme_bdev_shared_qpair {
+	struct spdk_nvme_qpair				*qpair;
+	struct nvme_bdev_ctrlr				*nvme_bdev_ctrlr;
+	struct spdk_thread				*thread;
+	struct nvme_bdev_poll_group			*group;
+	struct spdk_poller				*poller;
+	/* Number of channels using the qpair, protected by g_bdev_nvme_mutex */
+	uint32_t					ref;
+	/* Rings of the channels of other threads, only accessed by the owner */
+	TAILQ_HEAD(, nvme_bdev_shared_qpair_stage)	stages;
+	/* Staged I/O waiting for a free request of the qpair, only accessed by the owner */
+	TAILQ_HEAD(, spdk_bdev_io)			queued_ios;
+	/* Disconnected for a controller reset, only accessed by the owner */
+	bool						resetting;
+	TAILQ_ENTRY(nvme_bdev_shared_qpair)		tailq;
 };
 
+/* Staged I/O submitted by one pass of the owner poller over a ring */
+#define NVME_BDEV_SHARED_QPAIR_BATCH	32
+
 struct nvme_probe_ctx {
 	size_t count;
 	struct spdk_nvme_transport_id trids[NVME_MAX_CONTROLLERS];
@@ -120,6 +165,8 @@ static struct spdk_bdev_nvme_opts g_opts = {
 	.nvme_ioq_poll_period_us = 0,
 	.io_queue_requests = 0,
 	.delay_cmd_submit = SPDK_BDEV_NVME_DEFAULT_DELAY_CMD_SUBMIT,
+	.max_concurrent_attaches = 0,
+	.max_qpairs_per_ctrlr = 0,
 };
 
 #define NVME_HOTPLUG_POLL_PERIOD_MAX			10000000ULL
@@ -133,38 +180,56 @@ static struct spdk_poller *g_hotplug_poller;
 static struct spdk_nvme_probe_ctx *g_hotplug_probe_ctx;
 static char *g_nvme_hostnqn = NULL;
 
+/* Attaches waiting for one of the g_opts.max_concurrent_attaches slots */
+static TAILQ_HEAD(, nvme_async_probe_ctx) g_queued_attaches = TAILQ_HEAD_INITIALIZER(
+			g_queued_attaches);
+static uint32_t g_attaches_in_progress;
+/* Controllers from the configuration file still attaching, plus one while
+ * bdev_nvme_library_init() is running */
+static uint32_t g_init_attaches;
+
 static void nvme_ctrlr_populate_namespaces(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr,
 		struct nvme_async_probe_ctx *ctx);
 static void nvme_ctrlr_populate_namespaces_done(struct nvme_async_probe_ctx *ctx);
 static int bdev_nvme_library_init(void);
 static void bdev_nvme_library_fini(void);
-static int bdev_nvme_readv(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+static int bdev_nvme_readv(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 			   struct nvme_bdev_io *bio,
 			   struct iovec *iov, int iovcnt, void *md, uint64_t lba_count, uint64_t lba);
-static int bdev_nvme_no_pi_readv(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+static int bdev_nvme_no_pi_readv(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 				 struct nvme_bdev_io *bio,
 				 struct iovec *iov, int iovcnt, void *md, uint64_t lba_count, uint64_t lba);
-static int bdev_nvme_writev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+static int bdev_nvme_writev(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 			    struct nvme_bdev_io *bio,
 			    struct iovec *iov, int iovcnt, void *md, uint64_t lba_count, uint64_t lba);
-static int bdev_nvme_comparev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+static int bdev_nvme_comparev(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 			      struct nvme_bdev_io *bio,
 			      struct iovec *iov, int iovcnt, void *md, uint64_t lba_count, uint64_t lba);
-static int bdev_nvme_comparev_and_writev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+static int bdev_nvme_comparev_and_writev(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 		struct nvme_bdev_io *bio, struct iovec *cmp_iov, int cmp_iovcnt, struct iovec *write_iov,
 		int write_iovcnt, void *md, uint64_t lba_count, uint64_t lba);
 static int bdev_nvme_admin_passthru(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 				    struct nvme_bdev_io *bio,
 				    struct spdk_nvme_cmd *cmd, void *buf, size_t nbytes);
-static int bdev_nvme_io_passthru(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+static int bdev_nvme_io_passthru(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 				 struct nvme_bdev_io *bio,
 				 struct spdk_nvme_cmd *cmd, void *buf, size_t nbytes);
-static int bdev_nvme_io_passthru_md(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+static int bdev_nvme_io_passthru_md(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 				    struct nvme_bdev_io *bio,
 				    struct spdk_nvme_cmd *cmd, void *buf, size_t nbytes, void *md_buf, size_t md_len);
 static int bdev_nvme_reset(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, struct nvme_bdev_io *bio);
-static int bdev_nvme_abort(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+static int bdev_nvme_abort(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 			   struct nvme_bdev_io *bio, struct nvme_bdev_io *bio_to_abort);
+static int bdev_nvme_zone_appendv(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
+				  struct nvme_bdev_io *bio,
+				  struct iovec *iov, int iovcnt, void *md, uint64_t lba_count,
+				  uint64_t zslba);
+static int bdev_nvme_get_zone_info(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
+				   struct nvme_bdev_io *bio, uint64_t zone_id, uint32_t num_zones,
+				   struct spdk_bdev_zone_info *info);
+static int bdev_nvme_zone_management(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
+				     struct nvme_bdev_io *bio, uint64_t zone_id,
+				     enum spdk_bdev_zone_action action);
 
 typedef void (*populate_namespace_fn)(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr,
 				      struct nvme_bdev_ns *nvme_ns, struct nvme_async_probe_ctx *ctx);
@@ -214,6 +279,7 @@ bdev_nvme_get_ctx_size(void)
 
 static struct spdk_bdev_module nvme_if = {
 	.name = "nvme",
+	.async_init = true,
 	.async_fini = true,
 	.module_init = bdev_nvme_library_init,
 	.module_fini = bdev_nvme_library_fini,
@@ -347,22 +413,150 @@ _bdev_nvme_reset_complete(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, int rc)
 			      cb_arg, NULL);
 }
 
+/*
+ * spdk_nvme_ctrlr_reset() must not run while the owners of the shared qpairs poll or
+ * submit to them, so each owner disconnects its qpair before the reset and reconnects
+ * it afterwards. I/O staged by other threads waits in the rings meanwhile.
+ */
+typedef void (*bdev_nvme_reset_shared_cb)(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr,
+		struct nvme_bdev_io *bio, int status);
+
+struct nvme_bdev_reset_shared_ctx {
+	struct nvme_bdev_ctrlr		*nvme_bdev_ctrlr;
+	struct nvme_bdev_io		*bio;
+	struct spdk_thread		*orig_thread;
+	bool				reconnect;
+	/* Owners that haven't answered yet, only accessed by orig_thread */
+	uint32_t			outstanding;
+	int				status;
+	bdev_nvme_reset_shared_cb	cb_fn;
+};
+
+struct nvme_bdev_reset_shared_msg {
+	struct nvme_bdev_reset_shared_ctx	*ctx;
+	struct nvme_bdev_shared_qpair		*shared_qpair;
+	int					rc;
+};
+
+static void
+bdev_nvme_reset_shared_ctx_put(struct nvme_bdev_reset_shared_ctx *ctx)
+{
+	assert(ctx->outstanding > 0);
+	if (--ctx->outstanding > 0) {
+		return;
+	}
+
+	ctx->cb_fn(ctx->nvme_bdev_ctrlr, ctx->bio, ctx->status);
+	free(ctx);
+}
+
 static void
-_bdev_nvme_reset_create_qpairs_done(struct spdk_io_channel_iter *i, int status)
+_bdev_nvme_reset_shared_qpair_done(void *arg)
 {
-	struct nvme_bdev_ctrlr *nvme_bdev_ctrlr = spdk_io_channel_iter_get_io_device(i);
-	void *ctx = spdk_io_channel_iter_get_ctx(i);
-	int rc = SPDK_BDEV_IO_STATUS_SUCCESS;
+	struct nvme_bdev_reset_shared_msg *msg = arg;
+	struct nvme_bdev_reset_shared_ctx *ctx = msg->ctx;
+
+	if (msg->rc != 0 && ctx->status == 0) {
+		ctx->status = msg->rc;
+	}
+	free(msg);
+
+	bdev_nvme_reset_shared_ctx_put(ctx);
+}
+
+static void bdev_nvme_shared_qpair_put(struct nvme_bdev_shared_qpair *shared_qpair);
+
+static void
+_bdev_nvme_reset_shared_qpair(void *arg)
+{
+	struct nvme_bdev_reset_shared_msg *msg = arg;
+	struct nvme_bdev_shared_qpair *shared_qpair = msg->shared_qpair;
+
+	if (!msg->ctx->reconnect) {
+		shared_qpair->resetting = true;
+		spdk_nvme_ctrlr_disconnect_io_qpair(shared_qpair->qpair);
+	} else {
+		msg->rc = spdk_nvme_ctrlr_reconnect_io_qpair(shared_qpair->qpair);
+		if (msg->rc != 0) {
+			SPDK_ERRLOG("Unable to reconnect shared I/O qpair: %d\n", msg->rc);
+		}
+		shared_qpair->resetting = false;
+	}
+
+	/* Drop the reference taken by bdev_nvme_reset_shared_qpairs() */
+	bdev_nvme_shared_qpair_put(shared_qpair);
+	spdk_thread_send_msg(msg->ctx->orig_thread, _bdev_nvme_reset_shared_qpair_done, msg);
+}
+
+/* Disconnects or reconnects all shared qpairs, then calls cb_fn with the first error */
+static void
+bdev_nvme_reset_shared_qpairs(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, struct nvme_bdev_io *bio,
+			      bool reconnect, int status, bdev_nvme_reset_shared_cb cb_fn)
+{
+	struct nvme_bdev_reset_shared_ctx *ctx;
+	struct nvme_bdev_reset_shared_msg *msg;
+	struct nvme_bdev_shared_qpair *shared_qpair;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(nvme_bdev_ctrlr, bio, status != 0 ? status : -ENOMEM);
+		return;
+	}
+
+	ctx->nvme_bdev_ctrlr = nvme_bdev_ctrlr;
+	ctx->bio = bio;
+	ctx->orig_thread = spdk_get_thread();
+	ctx->reconnect = reconnect;
+	ctx->status = status;
+	ctx->cb_fn = cb_fn;
+	/* Held until all messages are sent */
+	ctx->outstanding = 1;
+
+	pthread_mutex_lock(&g_bdev_nvme_mutex);
+	TAILQ_FOREACH(shared_qpair, &nvme_bdev_ctrlr->shared_qpairs, tailq) {
+		msg = calloc(1, sizeof(*msg));
+		if (msg == NULL) {
+			ctx->status = ctx->status != 0 ? ctx->status : -ENOMEM;
+			break;
+		}
+
+		msg->ctx = ctx;
+		msg->shared_qpair = shared_qpair;
+		/* Keep the qpair alive until its owner handled the message */
+		shared_qpair->ref++;
+		ctx->outstanding++;
+		spdk_thread_send_msg(shared_qpair->thread, _bdev_nvme_reset_shared_qpair, msg);
+	}
+	pthread_mutex_unlock(&g_bdev_nvme_mutex);
+
+	bdev_nvme_reset_shared_ctx_put(ctx);
+}
+
+static void
+_bdev_nvme_reset_done(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, struct nvme_bdev_io *bio,
+		      int status)
+{
+	enum spdk_bdev_io_status io_status = SPDK_BDEV_IO_STATUS_SUCCESS;
 
 	if (status) {
-		rc = SPDK_BDEV_IO_STATUS_FAILED;
+		io_status = SPDK_BDEV_IO_STATUS_FAILED;
 	}
-	if (ctx) {
-		spdk_bdev_io_complete(spdk_bdev_io_from_ctx(ctx), rc);
+	if (bio) {
+		spdk_bdev_io_complete(spdk_bdev_io_from_ctx(bio), io_status);
 	}
 	_bdev_nvme_reset_complete(nvme_bdev_ctrlr, status);
 }
 
+static void
+_bdev_nvme_reset_create_qpairs_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct nvme_bdev_ctrlr *nvme_bdev_ctrlr = spdk_io_channel_iter_get_io_device(i);
+	struct nvme_bdev_io *bio = spdk_io_channel_iter_get_ctx(i);
+
+	/* The owners resubmit the I/O staged during the reset once reconnected */
+	bdev_nvme_reset_shared_qpairs(nvme_bdev_ctrlr, bio, true, status, _bdev_nvme_reset_done);
+}
+
 static void
 _bdev_nvme_reset_create_qpair(struct spdk_io_channel_iter *i)
 {
@@ -371,6 +565,12 @@ _bdev_nvme_reset_create_qpair(struct spdk_io_channel_iter *i)
 	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(_ch);
 	struct spdk_nvme_io_qpair_opts opts;
 
+	if (nvme_ch->shared_qpair != NULL) {
+		/* Shared qpairs are reconnected by their owners */
+		spdk_for_each_channel_continue(i, 0);
+		return;
+	}
+
 	spdk_nvme_ctrlr_get_default_io_qpair_opts(nvme_bdev_ctrlr->ctrlr, &opts, sizeof(opts));
 	opts.delay_cmd_submit = g_opts.delay_cmd_submit;
 	opts.create_only = true;
@@ -401,26 +601,17 @@ _bdev_nvme_reset_create_qpair(struct spdk_io_channel_iter *i)
 }
 
 static void
-_bdev_nvme_reset(struct spdk_io_channel_iter *i, int status)
+_bdev_nvme_reset_ctrlr(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, struct nvme_bdev_io *bio,
+		       int status)
 {
-	struct nvme_bdev_ctrlr *nvme_bdev_ctrlr = spdk_io_channel_iter_get_io_device(i);
-	struct nvme_bdev_io *bio = spdk_io_channel_iter_get_ctx(i);
-	int rc;
-
-	if (status) {
-		if (bio) {
-			spdk_bdev_io_complete(spdk_bdev_io_from_ctx(bio), SPDK_BDEV_IO_STATUS_FAILED);
-		}
-		_bdev_nvme_reset_complete(nvme_bdev_ctrlr, status);
-		return;
+	if (status == 0) {
+		status = spdk_nvme_ctrlr_reset(nvme_bdev_ctrlr->ctrlr);
 	}
 
-	rc = spdk_nvme_ctrlr_reset(nvme_bdev_ctrlr->ctrlr);
-	if (rc != 0) {
-		if (bio) {
-			spdk_bdev_io_complete(spdk_bdev_io_from_ctx(bio), SPDK_BDEV_IO_STATUS_FAILED);
-		}
-		_bdev_nvme_reset_complete(nvme_bdev_ctrlr, rc);
+	if (status != 0) {
+		/* Let the owners of the shared qpairs resume, the I/O fails on them */
+		bdev_nvme_reset_shared_qpairs(nvme_bdev_ctrlr, bio, true, status,
+					      _bdev_nvme_reset_done);
 		return;
 	}
 
@@ -429,8 +620,24 @@ _bdev_nvme_reset(struct spdk_io_channel_iter *i, int status)
 			      _bdev_nvme_reset_create_qpair,
 			      bio,
 			      _bdev_nvme_reset_create_qpairs_done);
+}
 
+static void
+_bdev_nvme_reset(struct spdk_io_channel_iter *i, int status)
+{
+	struct nvme_bdev_ctrlr *nvme_bdev_ctrlr = spdk_io_channel_iter_get_io_device(i);
+	struct nvme_bdev_io *bio = spdk_io_channel_iter_get_ctx(i);
+
+	if (status) {
+		if (bio) {
+			spdk_bdev_io_complete(spdk_bdev_io_from_ctx(bio), SPDK_BDEV_IO_STATUS_FAILED);
+		}
+		_bdev_nvme_reset_complete(nvme_bdev_ctrlr, status);
+		return;
+	}
 
+	/* Then have the owners disconnect the shared qpairs */
+	bdev_nvme_reset_shared_qpairs(nvme_bdev_ctrlr, bio, false, 0, _bdev_nvme_reset_ctrlr);
 }
 
 static void
@@ -440,6 +647,12 @@ _bdev_nvme_reset_destroy_qpair(struct spdk_io_channel_iter *i)
 	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
 	int rc;
 
+	if (nvme_ch->shared_qpair != NULL) {
+		/* Shared qpairs are disconnected by their owners */
+		spdk_for_each_channel_continue(i, 0);
+		return;
+	}
+
 	rc = spdk_nvme_ctrlr_free_io_qpair(nvme_ch->qpair);
 	if (!rc) {
 		nvme_ch->qpair = NULL;
@@ -495,62 +708,32 @@ bdev_nvme_reset(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, struct nvme_bdev_io *bi
 }
 
 static int
-bdev_nvme_unmap(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+bdev_nvme_unmap(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 		struct nvme_bdev_io *bio,
 		uint64_t offset_blocks,
 		uint64_t num_blocks);
 
-static void
-bdev_nvme_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
-		     bool success)
-{
-	int ret;
-
-	if (!success) {
-		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
-		return;
-	}
-
-	ret = bdev_nvme_readv((struct nvme_bdev *)bdev_io->bdev->ctxt,
-			      ch,
-			      (struct nvme_bdev_io *)bdev_io->driver_ctx,
-			      bdev_io->u.bdev.iovs,
-			      bdev_io->u.bdev.iovcnt,
-			      bdev_io->u.bdev.md_buf,
-			      bdev_io->u.bdev.num_blocks,
-			      bdev_io->u.bdev.offset_blocks);
-
-	if (spdk_likely(ret == 0)) {
-		return;
-	} else if (ret == -ENOMEM) {
-		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
-	} else {
-		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
-	}
-}
-
 static int
-_bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+bdev_nvme_submit_io(struct spdk_nvme_qpair *qpair, struct spdk_bdev_io *bdev_io)
 {
-	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
 	struct nvme_bdev *nbdev = (struct nvme_bdev *)bdev_io->bdev->ctxt;
 	struct nvme_bdev_io *nbdev_io = (struct nvme_bdev_io *)bdev_io->driver_ctx;
 	struct nvme_bdev_io *nbdev_io_to_abort;
 
-	if (nvme_ch->qpair == NULL) {
-		/* The device is currently resetting */
-		return -1;
-	}
-
 	switch (bdev_io->type) {
 	case SPDK_BDEV_IO_TYPE_READ:
-		spdk_bdev_io_get_buf(bdev_io, bdev_nvme_get_buf_cb,
-				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
-		return 0;
+		return bdev_nvme_readv(nbdev,
+				       qpair,
+				       nbdev_io,
+				       bdev_io->u.bdev.iovs,
+				       bdev_io->u.bdev.iovcnt,
+				       bdev_io->u.bdev.md_buf,
+				       bdev_io->u.bdev.num_blocks,
+				       bdev_io->u.bdev.offset_blocks);
 
 	case SPDK_BDEV_IO_TYPE_WRITE:
 		return bdev_nvme_writev(nbdev,
-					ch,
+					qpair,
 					nbdev_io,
 					bdev_io->u.bdev.iovs,
 					bdev_io->u.bdev.iovcnt,
@@ -560,7 +743,7 @@ _bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 
 	case SPDK_BDEV_IO_TYPE_COMPARE:
 		return bdev_nvme_comparev(nbdev,
-					  ch,
+					  qpair,
 					  nbdev_io,
 					  bdev_io->u.bdev.iovs,
 					  bdev_io->u.bdev.iovcnt,
@@ -570,7 +753,7 @@ _bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 
 	case SPDK_BDEV_IO_TYPE_COMPARE_AND_WRITE:
 		return bdev_nvme_comparev_and_writev(nbdev,
-						     ch,
+						     qpair,
 						     nbdev_io,
 						     bdev_io->u.bdev.iovs,
 						     bdev_io->u.bdev.iovcnt,
@@ -582,38 +765,21 @@ _bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 
 	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
 		return bdev_nvme_unmap(nbdev,
-				       ch,
+				       qpair,
 				       nbdev_io,
 				       bdev_io->u.bdev.offset_blocks,
 				       bdev_io->u.bdev.num_blocks);
 
 	case SPDK_BDEV_IO_TYPE_UNMAP:
 		return bdev_nvme_unmap(nbdev,
-				       ch,
-				       nbdev_io,
-				       bdev_io->u.bdev.offset_blocks,
-				       bdev_io->u.bdev.num_blocks);
-
-	case SPDK_BDEV_IO_TYPE_RESET:
-		return bdev_nvme_reset(nbdev->nvme_bdev_ctrlr, nbdev_io);
-
-	case SPDK_BDEV_IO_TYPE_FLUSH:
-		return bdev_nvme_flush(nbdev,
+				       qpair,
 				       nbdev_io,
 				       bdev_io->u.bdev.offset_blocks,
 				       bdev_io->u.bdev.num_blocks);
 
-	case SPDK_BDEV_IO_TYPE_NVME_ADMIN:
-		return bdev_nvme_admin_passthru(nbdev,
-						ch,
-						nbdev_io,
-						&bdev_io->u.nvme_passthru.cmd,
-						bdev_io->u.nvme_passthru.buf,
-						bdev_io->u.nvme_passthru.nbytes);
-
 	case SPDK_BDEV_IO_TYPE_NVME_IO:
 		return bdev_nvme_io_passthru(nbdev,
-					     ch,
+					     qpair,
 					     nbdev_io,
 					     &bdev_io->u.nvme_passthru.cmd,
 					     bdev_io->u.nvme_passthru.buf,
@@ -621,7 +787,7 @@ _bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 
 	case SPDK_BDEV_IO_TYPE_NVME_IO_MD:
 		return bdev_nvme_io_passthru_md(nbdev,
-						ch,
+						qpair,
 						nbdev_io,
 						&bdev_io->u.nvme_passthru.cmd,
 						bdev_io->u.nvme_passthru.buf,
@@ -632,10 +798,366 @@ _bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 	case SPDK_BDEV_IO_TYPE_ABORT:
 		nbdev_io_to_abort = (struct nvme_bdev_io *)bdev_io->u.abort.bio_to_abort->driver_ctx;
 		return bdev_nvme_abort(nbdev,
-				       ch,
+				       qpair,
 				       nbdev_io,
 				       nbdev_io_to_abort);
 
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
+		return bdev_nvme_zone_appendv(nbdev,
+					      qpair,
+					      nbdev_io,
+					      bdev_io->u.bdev.iovs,
+					      bdev_io->u.bdev.iovcnt,
+					      bdev_io->u.bdev.md_buf,
+					      bdev_io->u.bdev.num_blocks,
+					      bdev_io->u.bdev.offset_blocks);
+
+	case SPDK_BDEV_IO_TYPE_GET_ZONE_INFO:
+		return bdev_nvme_get_zone_info(nbdev,
+					       qpair,
+					       nbdev_io,
+					       bdev_io->u.zone_mgmt.zone_id,
+					       bdev_io->u.zone_mgmt.num_zones,
+					       bdev_io->u.zone_mgmt.buf);
+
+	case SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT:
+		return bdev_nvme_zone_management(nbdev,
+						 qpair,
+						 nbdev_io,
+						 bdev_io->u.zone_mgmt.zone_id,
+						 bdev_io->u.zone_mgmt.zone_action);
+
+	default:
+		return -EINVAL;
+	}
+}
+
+static void
+bdev_nvme_shared_io_failed(void *ctx)
+{
+	spdk_bdev_io_complete(ctx, SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+/* Returns -ENOMEM if the qpair has no free request and the I/O has to wait */
+static int
+bdev_nvme_shared_qpair_submit(struct nvme_bdev_shared_qpair *shared_qpair,
+			      struct spdk_bdev_io *bdev_io)
+{
+	struct nvme_bdev_io *bio = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+	int rc;
+
+	rc = bdev_nvme_submit_io(shared_qpair->qpair, bdev_io);
+	if (spdk_unlikely(rc != 0 && rc != -ENOMEM)) {
+		spdk_thread_send_msg(bio->orig_thread, bdev_nvme_shared_io_failed, bdev_io);
+		rc = 0;
+	}
+
+	return rc;
+}
+
+static int
+bdev_nvme_shared_qpair_poll(void *arg)
+{
+	struct nvme_bdev_shared_qpair *shared_qpair = arg;
+	struct nvme_bdev_shared_qpair_stage *stage;
+	struct spdk_bdev_io *bdev_ios[NVME_BDEV_SHARED_QPAIR_BATCH];
+	struct spdk_bdev_io *bdev_io;
+	size_t count, i;
+	int num_submitted = 0;
+
+	if (spdk_unlikely(shared_qpair->resetting)) {
+		/* Keep the I/O staged until the qpair is reconnected */
+		return SPDK_POLLER_IDLE;
+	}
+
+	while ((bdev_io = TAILQ_FIRST(&shared_qpair->queued_ios)) != NULL) {
+		if (bdev_nvme_shared_qpair_submit(shared_qpair, bdev_io) != 0) {
+			/* Leave the rest staged until completions free up requests */
+			return num_submitted > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+		}
+		TAILQ_REMOVE(&shared_qpair->queued_ios, bdev_io, module_link);
+		num_submitted++;
+	}
+
+	TAILQ_FOREACH(stage, &shared_qpair->stages, link) {
+		count = spdk_ring_dequeue(stage->ring, (void **)bdev_ios, SPDK_COUNTOF(bdev_ios));
+		for (i = 0; i < count; i++) {
+			if (!TAILQ_EMPTY(&shared_qpair->queued_ios) ||
+			    bdev_nvme_shared_qpair_submit(shared_qpair, bdev_ios[i]) != 0) {
+				TAILQ_INSERT_TAIL(&shared_qpair->queued_ios, bdev_ios[i],
+						  module_link);
+			}
+		}
+		num_submitted += count;
+	}
+
+	return num_submitted > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+_bdev_nvme_shared_qpair_add_stage(void *ctx)
+{
+	struct nvme_bdev_shared_qpair_stage *stage = ctx;
+
+	TAILQ_INSERT_TAIL(&stage->shared_qpair->stages, stage, link);
+}
+
+static void
+_bdev_nvme_shared_qpair_remove_stage(void *ctx)
+{
+	struct nvme_bdev_shared_qpair_stage *stage = ctx;
+
+	assert(spdk_ring_count(stage->ring) == 0);
+	TAILQ_REMOVE(&stage->shared_qpair->stages, stage, link);
+	spdk_ring_free(stage->ring);
+	free(stage);
+}
+
+static struct nvme_bdev_shared_qpair *
+bdev_nvme_shared_qpair_create(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr,
+			      struct spdk_nvme_io_qpair_opts *opts)
+{
+	struct nvme_bdev_shared_qpair *shared_qpair;
+	struct spdk_io_channel *pg_ch;
+
+	shared_qpair = calloc(1, sizeof(*shared_qpair));
+	if (shared_qpair == NULL) {
+		return NULL;
+	}
+
+	shared_qpair->nvme_bdev_ctrlr = nvme_bdev_ctrlr;
+	shared_qpair->thread = spdk_get_thread();
+	shared_qpair->ref = 1;
+	TAILQ_INIT(&shared_qpair->stages);
+	TAILQ_INIT(&shared_qpair->queued_ios);
+
+	shared_qpair->qpair = spdk_nvme_ctrlr_alloc_io_qpair(nvme_bdev_ctrlr->ctrlr, opts,
+			      sizeof(*opts));
+	if (shared_qpair->qpair == NULL) {
+		free(shared_qpair);
+		return NULL;
+	}
+
+	pg_ch = spdk_get_io_channel(&g_nvme_bdev_ctrlrs);
+	if (pg_ch == NULL) {
+		goto err_qpair;
+	}
+
+	shared_qpair->group = spdk_io_channel_get_ctx(pg_ch);
+	if (spdk_nvme_poll_group_add(shared_qpair->group->group, shared_qpair->qpair) != 0) {
+		goto err_pg_ch;
+	}
+
+	if (spdk_nvme_ctrlr_connect_io_qpair(nvme_bdev_ctrlr->ctrlr, shared_qpair->qpair) != 0) {
+		goto err_group;
+	}
+
+	shared_qpair->poller = SPDK_POLLER_REGISTER(bdev_nvme_shared_qpair_poll, shared_qpair, 0);
+	if (shared_qpair->poller == NULL) {
+		goto err_group;
+	}
+
+	return shared_qpair;
+
+err_group:
+	spdk_nvme_poll_group_remove(shared_qpair->group->group, shared_qpair->qpair);
+err_pg_ch:
+	spdk_put_io_channel(pg_ch);
+err_qpair:
+	spdk_nvme_ctrlr_free_io_qpair(shared_qpair->qpair);
+	free(shared_qpair);
+	return NULL;
+}
+
+static void
+bdev_nvme_shared_qpair_destroy(void *ctx)
+{
+	struct nvme_bdev_shared_qpair *shared_qpair = ctx;
+	struct nvme_bdev_ctrlr *nvme_bdev_ctrlr = shared_qpair->nvme_bdev_ctrlr;
+	bool detach;
+
+	assert(TAILQ_EMPTY(&shared_qpair->stages));
+	assert(TAILQ_EMPTY(&shared_qpair->queued_ios));
+
+	spdk_poller_unregister(&shared_qpair->poller);
+	spdk_nvme_poll_group_remove(shared_qpair->group->group, shared_qpair->qpair);
+	spdk_put_io_channel(spdk_io_channel_from_ctx(shared_qpair->group));
+	spdk_nvme_ctrlr_free_io_qpair(shared_qpair->qpair);
+	free(shared_qpair);
+
+	pthread_mutex_lock(&g_bdev_nvme_mutex);
+	assert(nvme_bdev_ctrlr->num_shared_qpairs > 0);
+	nvme_bdev_ctrlr->num_shared_qpairs--;
+	detach = nvme_bdev_ctrlr->num_shared_qpairs == 0 && nvme_bdev_ctrlr->detach_pending;
+	pthread_mutex_unlock(&g_bdev_nvme_mutex);
+
+	if (detach) {
+		spdk_thread_send_msg(nvme_bdev_ctrlr->thread, nvme_bdev_unregister_cb,
+				     nvme_bdev_ctrlr);
+	}
+}
+
+/*
+ * A new channel uses the qpair owned by its own thread if there is one. Otherwise
+ * it creates a qpair while the controller is below the limit and shares the least
+ * used one once the limit is reached.
+ */
+static struct nvme_bdev_shared_qpair *
+bdev_nvme_shared_qpair_get(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr,
+			   struct spdk_nvme_io_qpair_opts *opts)
+{
+	struct nvme_bdev_shared_qpair *shared_qpair = NULL, *tmp;
+	struct spdk_thread *thread = spdk_get_thread();
+
+	pthread_mutex_lock(&g_bdev_nvme_mutex);
+	TAILQ_FOREACH(tmp, &nvme_bdev_ctrlr->shared_qpairs, tailq) {
+		if (tmp->thread == thread) {
+			shared_qpair = tmp;
+			break;
+		}
+		if (shared_qpair == NULL || tmp->ref < shared_qpair->ref) {
+			shared_qpair = tmp;
+		}
+	}
+
+	if (shared_qpair != NULL &&
+	    (shared_qpair->thread == thread ||
+	     nvme_bdev_ctrlr->num_shared_qpairs >= g_opts.max_qpairs_per_ctrlr)) {
+		shared_qpair->ref++;
+		pthread_mutex_unlock(&g_bdev_nvme_mutex);
+		return shared_qpair;
+	}
+
+	/* Take the slot now, the qpair is connected without holding the lock */
+	nvme_bdev_ctrlr->num_shared_qpairs++;
+	pthread_mutex_unlock(&g_bdev_nvme_mutex);
+
+	shared_qpair = bdev_nvme_shared_qpair_create(nvme_bdev_ctrlr, opts);
+
+	pthread_mutex_lock(&g_bdev_nvme_mutex);
+	if (shared_qpair != NULL) {
+		TAILQ_INSERT_TAIL(&nvme_bdev_ctrlr->shared_qpairs, shared_qpair, tailq);
+	} else {
+		nvme_bdev_ctrlr->num_shared_qpairs--;
+	}
+	pthread_mutex_unlock(&g_bdev_nvme_mutex);
+
+	return shared_qpair;
+}
+
+static void
+bdev_nvme_shared_qpair_put(struct nvme_bdev_shared_qpair *shared_qpair)
+{
+	pthread_mutex_lock(&g_bdev_nvme_mutex);
+	assert(shared_qpair->ref > 0);
+	if (--shared_qpair->ref > 0) {
+		pthread_mutex_unlock(&g_bdev_nvme_mutex);
+		return;
+	}
+	TAILQ_REMOVE(&shared_qpair->nvme_bdev_ctrlr->shared_qpairs, shared_qpair, tailq);
+	pthread_mutex_unlock(&g_bdev_nvme_mutex);
+
+	if (shared_qpair->thread == spdk_get_thread()) {
+		bdev_nvme_shared_qpair_destroy(shared_qpair);
+	} else {
+		spdk_thread_send_msg(shared_qpair->thread, bdev_nvme_shared_qpair_destroy,
+				     shared_qpair);
+	}
+}
+
+static int
+bdev_nvme_ch_submit_io(struct nvme_io_channel *nvme_ch, struct spdk_bdev_io *bdev_io)
+{
+	struct nvme_bdev_io *bio = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+
+	if (spdk_likely(nvme_ch->stage == NULL)) {
+		return bdev_nvme_submit_io(nvme_ch->qpair, bdev_io);
+	}
+
+	bio->orig_thread = spdk_get_thread();
+	if (spdk_ring_enqueue(nvme_ch->stage->ring, (void **)&bdev_io, 1, NULL) != 1) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+bdev_nvme_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
+		     bool success)
+{
+	int ret;
+
+	if (!success) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	ret = bdev_nvme_ch_submit_io(spdk_io_channel_get_ctx(ch), bdev_io);
+
+	if (spdk_likely(ret == 0)) {
+		return;
+	} else if (ret == -ENOMEM) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
+	} else {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static int
+_bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
+	struct nvme_bdev *nbdev = (struct nvme_bdev *)bdev_io->bdev->ctxt;
+	struct nvme_bdev_io *nbdev_io = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+
+	if (nvme_ch->qpair == NULL && nvme_ch->stage == NULL) {
+		/* The device is currently resetting */
+		return -1;
+	}
+
+	if (nvme_ch->stage == NULL && nvme_ch->shared_qpair != NULL &&
+	    nvme_ch->shared_qpair->resetting) {
+		/* The owner's qpair is disconnected for a reset */
+		return -1;
+	}
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		spdk_bdev_io_get_buf(bdev_io, bdev_nvme_get_buf_cb,
+				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
+		return 0;
+
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_COMPARE:
+	case SPDK_BDEV_IO_TYPE_COMPARE_AND_WRITE:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_NVME_IO:
+	case SPDK_BDEV_IO_TYPE_NVME_IO_MD:
+	case SPDK_BDEV_IO_TYPE_ABORT:
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
+	case SPDK_BDEV_IO_TYPE_GET_ZONE_INFO:
+	case SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT:
+		return bdev_nvme_ch_submit_io(nvme_ch, bdev_io);
+
+	case SPDK_BDEV_IO_TYPE_RESET:
+		return bdev_nvme_reset(nbdev->nvme_bdev_ctrlr, nbdev_io);
+
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+		return bdev_nvme_flush(nbdev,
+				       nbdev_io,
+				       bdev_io->u.bdev.offset_blocks,
+				       bdev_io->u.bdev.num_blocks);
+
+	case SPDK_BDEV_IO_TYPE_NVME_ADMIN:
+		return bdev_nvme_admin_passthru(nbdev,
+						ch,
+						nbdev_io,
+						&bdev_io->u.nvme_passthru.cmd,
+						bdev_io->u.nvme_passthru.buf,
+						bdev_io->u.nvme_passthru.nbytes);
+
 	default:
 		return -EINVAL;
 	}
@@ -645,8 +1167,15 @@ _bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 static void
 bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
 {
-	int rc = _bdev_nvme_submit_request(ch, bdev_io);
+	struct nvme_bdev_io *nbdev_io = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+	int rc;
+
+	nbdev_io->orig_thread = NULL;
+	if (bdev_io->num_retries == 0) {
+		nbdev_io->first_fused_submitted = false;
+	}
 
+	rc = _bdev_nvme_submit_request(ch, bdev_io);
 	if (spdk_unlikely(rc != 0)) {
 		if (rc == -ENOMEM) {
 			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
@@ -707,11 +1236,84 @@ bdev_nvme_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 		}
 		return false;
 
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
+	case SPDK_BDEV_IO_TYPE_GET_ZONE_INFO:
+	case SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT:
+		return spdk_nvme_ns_get_csi(nbdev->nvme_ns->ns) == SPDK_NVME_CSI_ZNS;
+
 	default:
 		return false;
 	}
 }
 
+static int
+bdev_nvme_create_shared_channel(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr,
+				struct nvme_io_channel *ch,
+				struct spdk_nvme_io_qpair_opts *opts)
+{
+	struct nvme_bdev_shared_qpair *shared_qpair;
+	struct nvme_bdev_shared_qpair_stage *stage;
+	struct spdk_io_channel *pg_ch;
+
+	pg_ch = spdk_get_io_channel(&g_nvme_bdev_ctrlrs);
+	if (!pg_ch) {
+		return -1;
+	}
+	ch->group = spdk_io_channel_get_ctx(pg_ch);
+
+	shared_qpair = bdev_nvme_shared_qpair_get(nvme_bdev_ctrlr, opts);
+	if (shared_qpair == NULL) {
+		goto err;
+	}
+
+	if (shared_qpair->thread == spdk_get_thread()) {
+		ch->qpair = shared_qpair->qpair;
+	} else {
+		stage = calloc(1, sizeof(*stage));
+		if (stage == NULL) {
+			goto err_put;
+		}
+
+		stage->ring = spdk_ring_create(SPDK_RING_TYPE_SP_SC, opts->io_queue_requests,
+					       SPDK_ENV_SOCKET_ID_ANY);
+		if (stage->ring == NULL) {
+			free(stage);
+			goto err_put;
+		}
+		stage->shared_qpair = shared_qpair;
+
+		if (spdk_thread_send_msg(shared_qpair->thread, _bdev_nvme_shared_qpair_add_stage,
+					 stage) != 0) {
+			spdk_ring_free(stage->ring);
+			free(stage);
+			goto err_put;
+		}
+		ch->stage = stage;
+	}
+
+	ch->shared_qpair = shared_qpair;
+	TAILQ_INIT(&ch->pending_resets);
+	return 0;
+
+err_put:
+	bdev_nvme_shared_qpair_put(shared_qpair);
+err:
+	spdk_put_io_channel(pg_ch);
+	return -1;
+}
+
+static void
+bdev_nvme_destroy_shared_channel(struct nvme_io_channel *ch)
+{
+	if (ch->stage != NULL) {
+		spdk_thread_send_msg(ch->shared_qpair->thread, _bdev_nvme_shared_qpair_remove_stage,
+				     ch->stage);
+	}
+
+	bdev_nvme_shared_qpair_put(ch->shared_qpair);
+	spdk_put_io_channel(spdk_io_channel_from_ctx(ch->group));
+}
+
 static int
 bdev_nvme_create_cb(void *io_device, void *ctx_buf)
 {
@@ -727,6 +1329,12 @@ bdev_nvme_create_cb(void *io_device, void *ctx_buf)
 	opts.create_only = true;
 	g_opts.io_queue_requests = opts.io_queue_requests;
 
+	/* OCSSD channels keep a qpair of their own */
+	if (g_opts.max_qpairs_per_ctrlr != 0 &&
+	    !spdk_nvme_ctrlr_is_ocssd_supported(nvme_bdev_ctrlr->ctrlr)) {
+		return bdev_nvme_create_shared_channel(nvme_bdev_ctrlr, ch, &opts);
+	}
+
 	ch->qpair = spdk_nvme_ctrlr_alloc_io_qpair(nvme_bdev_ctrlr->ctrlr, &opts, sizeof(opts));
 
 	if (ch->qpair == NULL) {
@@ -779,6 +1387,11 @@ bdev_nvme_destroy_cb(void *io_device, void *ctx_buf)
 	struct nvme_io_channel *ch = ctx_buf;
 	struct nvme_bdev_poll_group *group;
 
+	if (ch->shared_qpair != NULL) {
+		bdev_nvme_destroy_shared_channel(ch);
+		return;
+	}
+
 	group = ch->group;
 	assert(group != NULL);
 
@@ -794,36 +1407,169 @@ bdev_nvme_destroy_cb(void *io_device, void *ctx_buf)
 	spdk_nvme_ctrlr_free_io_qpair(ch->qpair);
 }
 
+/* CRC-32C of a scattered buffer, computed by the accel engine one element at a
+ * time with the CRC of the previous element as the seed of the next one.
+ */
+struct nvme_bdev_accel_task {
+	struct nvme_bdev_poll_group		*group;
+	uint32_t				*dst;
+	struct iovec				*iov;
+	uint32_t				iovcnt;
+	uint32_t				iovpos;
+	uint32_t				crc32c;
+	spdk_nvme_accel_completion_cb		cb_fn;
+	void					*cb_arg;
+	STAILQ_ENTRY(nvme_bdev_accel_task)	link;
+	/* struct spdk_accel_task follows */
+};
+
+static struct spdk_accel_task *
+__accel_task_from_nvme_task(struct nvme_bdev_accel_task *task)
+{
+	return (struct spdk_accel_task *)((uintptr_t)task + sizeof(struct nvme_bdev_accel_task));
+}
+
+static struct nvme_bdev_accel_task *
+__nvme_task_from_accel_task(struct spdk_accel_task *accel_task)
+{
+	return (struct nvme_bdev_accel_task *)((uintptr_t)accel_task -
+					       sizeof(struct nvme_bdev_accel_task));
+}
+
+static void bdev_nvme_accel_crc32c_next(struct nvme_bdev_accel_task *task);
+
+static void
+bdev_nvme_accel_crc32c_done(void *ref, int status)
+{
+	struct nvme_bdev_accel_task *task = __nvme_task_from_accel_task(ref);
+
+	if (status == 0 && ++task->iovpos < task->iovcnt) {
+		bdev_nvme_accel_crc32c_next(task);
+		return;
+	}
+
+	if (status == 0) {
+		*task->dst = task->crc32c;
+	}
+
+	STAILQ_INSERT_HEAD(&task->group->free_accel_tasks, task, link);
+	task->cb_fn(task->cb_arg, status);
+}
+
+static void
+bdev_nvme_accel_crc32c_next(struct nvme_bdev_accel_task *task)
+{
+	struct iovec *iov = &task->iov[task->iovpos];
+	uint32_t seed;
+	int rc;
+
+	/* The engine starts from ~seed, chain the elements by undoing that */
+	seed = task->iovpos == 0 ? task->crc32c : ~task->crc32c;
+	rc = spdk_accel_submit_crc32c(__accel_task_from_nvme_task(task), task->group->accel_channel,
+				      &task->crc32c, iov->iov_base, seed, iov->iov_len,
+				      bdev_nvme_accel_crc32c_done);
+	if (rc != 0) {
+		bdev_nvme_accel_crc32c_done(__accel_task_from_nvme_task(task), rc);
+	}
+}
+
+static void
+bdev_nvme_submit_accel_crc32c(void *ctx, uint32_t *dst, struct iovec *iov,
+			      uint32_t iovcnt, uint32_t seed,
+			      spdk_nvme_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct nvme_bdev_poll_group *group = ctx;
+	struct nvme_bdev_accel_task *task;
+
+	if (spdk_unlikely(iovcnt == 0)) {
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	task = STAILQ_FIRST(&group->free_accel_tasks);
+	if (task != NULL) {
+		STAILQ_REMOVE_HEAD(&group->free_accel_tasks, link);
+	} else {
+		task = calloc(1, sizeof(*task) + spdk_accel_task_size());
+		if (task == NULL) {
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+		task->group = group;
+	}
+
+	task->dst = dst;
+	task->iov = iov;
+	task->iovcnt = iovcnt;
+	task->iovpos = 0;
+	task->crc32c = seed;
+	task->cb_fn = cb_fn;
+	task->cb_arg = cb_arg;
+
+	bdev_nvme_accel_crc32c_next(task);
+}
+
+static struct spdk_nvme_accel_fn_table g_bdev_nvme_accel_fn_table = {
+	.table_size = sizeof(struct spdk_nvme_accel_fn_table),
+	.submit_accel_crc32c = bdev_nvme_submit_accel_crc32c,
+};
+
 static int
 bdev_nvme_poll_group_create_cb(void *io_device, void *ctx_buf)
 {
 	struct nvme_bdev_poll_group *group = ctx_buf;
+	struct spdk_nvme_accel_fn_table *accel_fn_table = NULL;
 
-	group->group = spdk_nvme_poll_group_create(group);
+	STAILQ_INIT(&group->free_accel_tasks);
+
+	/* Transports offload e.g. NVMe/TCP data digests through the accel engine */
+	group->accel_channel = spdk_accel_engine_get_io_channel();
+	if (group->accel_channel != NULL &&
+	    (spdk_accel_get_capabilities(group->accel_channel) & ACCEL_CRC32C)) {
+		accel_fn_table = &g_bdev_nvme_accel_fn_table;
+	}
+
+	group->group = spdk_nvme_poll_group_create_ext(group, accel_fn_table);
 	if (group->group == NULL) {
-		return -1;
+		goto err;
 	}
 
 	group->poller = SPDK_POLLER_REGISTER(bdev_nvme_poll, group, g_opts.nvme_ioq_poll_period_us);
 
 	if (group->poller == NULL) {
 		spdk_nvme_poll_group_destroy(group->group);
-		return -1;
+		goto err;
 	}
 
 	return 0;
+
+err:
+	if (group->accel_channel != NULL) {
+		spdk_put_io_channel(group->accel_channel);
+	}
+	return -1;
 }
 
 static void
 bdev_nvme_poll_group_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct nvme_bdev_poll_group *group = ctx_buf;
+	struct nvme_bdev_accel_task *task;
 
 	spdk_poller_unregister(&group->poller);
 	if (spdk_nvme_poll_group_destroy(group->group)) {
 		SPDK_ERRLOG("Unable to destroy a poll group for the NVMe bdev module.");
 		assert(false);
 	}
+
+	while ((task = STAILQ_FIRST(&group->free_accel_tasks)) != NULL) {
+		STAILQ_REMOVE_HEAD(&group->free_accel_tasks, link);
+		free(task);
+	}
+
+	if (group->accel_channel != NULL) {
+		spdk_put_io_channel(group->accel_channel);
+	}
 }
 
 static struct spdk_io_channel *
@@ -1025,6 +1771,13 @@ nvme_ctrlr_populate_standard_namespace(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr,
 	bdev->disk.blockcnt = spdk_nvme_ns_get_num_sectors(ns);
 	bdev->disk.optimal_io_boundary = spdk_nvme_ns_get_optimal_io_boundary(ns);
 
+	if (spdk_nvme_ns_get_csi(ns) == SPDK_NVME_CSI_ZNS) {
+		bdev->disk.zoned = true;
+		bdev->disk.zone_size = spdk_nvme_zns_ns_get_zone_size_sectors(ns);
+		bdev->disk.max_open_zones = spdk_nvme_zns_ns_get_max_open_zones(ns);
+		bdev->disk.optimal_open_zones = bdev->disk.max_open_zones;
+	}
+
 	uuid = spdk_nvme_ns_get_uuid(ns);
 	if (uuid != NULL) {
 		bdev->disk.uuid = *uuid;
@@ -1404,6 +2157,7 @@ create_ctrlr(struct spdk_nvme_ctrlr *ctrlr,
 	nvme_bdev_ctrlr->adminq_timer_poller = NULL;
 	nvme_bdev_ctrlr->ctrlr = ctrlr;
 	nvme_bdev_ctrlr->ref = 0;
+	TAILQ_INIT(&nvme_bdev_ctrlr->shared_qpairs);
 	*nvme_bdev_ctrlr->trid = *trid;
 	nvme_bdev_ctrlr->name = strdup(name);
 	if (nvme_bdev_ctrlr->name == NULL) {
@@ -1631,14 +2385,53 @@ bdev_nvme_set_hotplug(bool enabled, uint64_t period_us, spdk_msg_fn cb, void *cb
 	return 0;
 }
 
+static int bdev_nvme_start_attach(struct nvme_async_probe_ctx *ctx);
+
+static void
+bdev_nvme_start_queued_attaches(void)
+{
+	struct nvme_async_probe_ctx *ctx;
+	int rc;
+
+	while ((ctx = TAILQ_FIRST(&g_queued_attaches)) != NULL) {
+		if (g_opts.max_concurrent_attaches != 0 &&
+		    g_attaches_in_progress >= g_opts.max_concurrent_attaches) {
+			break;
+		}
+
+		TAILQ_REMOVE(&g_queued_attaches, ctx, tailq);
+		rc = bdev_nvme_start_attach(ctx);
+		if (rc != 0) {
+			if (ctx->cb_fn) {
+				ctx->cb_fn(ctx->cb_ctx, 0, rc);
+			}
+			free(ctx);
+		}
+	}
+}
+
 static void
 populate_namespaces_cb(struct nvme_async_probe_ctx *ctx, size_t count, int rc)
 {
+	struct nvme_bdev_ctrlr *nvme_bdev_ctrlr;
+
+	nvme_bdev_ctrlr = nvme_bdev_ctrlr_get(&ctx->trid);
+	if (nvme_bdev_ctrlr != NULL) {
+		nvme_bdev_ctrlr->attach_time_us = (spdk_get_ticks() - ctx->start_ticks) *
+						  SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+		SPDK_INFOLOG(SPDK_LOG_BDEV_NVME, "Attached NVMe controller %s in %" PRIu64 " us\n",
+			     nvme_bdev_ctrlr->name, nvme_bdev_ctrlr->attach_time_us);
+	}
+
 	if (ctx->cb_fn) {
 		ctx->cb_fn(ctx->cb_ctx, count, rc);
 	}
 
 	free(ctx);
+
+	assert(g_attaches_in_progress > 0);
+	g_attaches_in_progress--;
+	bdev_nvme_start_queued_attaches();
 }
 
 static void
@@ -1666,7 +2459,10 @@ nvme_ctrlr_populate_namespaces_done(struct nvme_async_probe_ctx *ctx)
 		}
 		assert(ns->id == nsid);
 		TAILQ_FOREACH_SAFE(nvme_bdev, &ns->bdevs, tailq, tmp) {
-			if (j < ctx->count) {
+			if (ctx->names == NULL) {
+				/* The caller only needs the number of bdevs. */
+				j++;
+			} else if (j < ctx->count) {
 				ctx->names[j] = nvme_bdev->disk.name;
 				j++;
 			} else {
@@ -1716,12 +2512,28 @@ bdev_nvme_async_poll(void *arg)
 	rc = spdk_nvme_probe_poll_async(ctx->probe_ctx);
 	if (spdk_unlikely(rc != -EAGAIN && rc != 0)) {
 		spdk_poller_unregister(&ctx->poller);
-		free(ctx);
+		populate_namespaces_cb(ctx, 0, rc);
 	}
 
 	return SPDK_POLLER_BUSY;
 }
 
+static int
+bdev_nvme_start_attach(struct nvme_async_probe_ctx *ctx)
+{
+	ctx->start_ticks = spdk_get_ticks();
+	ctx->probe_ctx = spdk_nvme_connect_async(&ctx->trid, &ctx->opts, connect_attach_cb);
+	if (ctx->probe_ctx == NULL) {
+		SPDK_ERRLOG("No controller was found with provided trid (traddr: %s)\n",
+			    ctx->trid.traddr);
+		return -ENODEV;
+	}
+	ctx->poller = SPDK_POLLER_REGISTER(bdev_nvme_async_poll, ctx, 1000);
+	g_attaches_in_progress++;
+
+	return 0;
+}
+
 int
 bdev_nvme_create(struct spdk_nvme_transport_id *trid,
 		 struct spdk_nvme_host_id *hostid,
@@ -1735,6 +2547,7 @@ bdev_nvme_create(struct spdk_nvme_transport_id *trid,
 {
 	struct nvme_probe_skip_entry	*entry, *tmp;
 	struct nvme_async_probe_ctx	*ctx;
+	int				rc;
 
 	if (nvme_bdev_ctrlr_get(trid) != NULL) {
 		SPDK_ERRLOG("A controller with the provided trid (traddr: %s) already exists.\n", trid->traddr);
@@ -1783,15 +2596,18 @@ bdev_nvme_create(struct spdk_nvme_transport_id *trid,
 		snprintf(ctx->opts.src_svcid, sizeof(ctx->opts.src_svcid), "%s", hostid->hostsvcid);
 	}
 
-	ctx->probe_ctx = spdk_nvme_connect_async(trid, &ctx->opts, connect_attach_cb);
-	if (ctx->probe_ctx == NULL) {
-		SPDK_ERRLOG("No controller was found with provided trid (traddr: %s)\n", trid->traddr);
+	if (g_opts.max_concurrent_attaches != 0 &&
+	    g_attaches_in_progress >= g_opts.max_concurrent_attaches) {
+		TAILQ_INSERT_TAIL(&g_queued_attaches, ctx, tailq);
+		return 0;
+	}
+
+	rc = bdev_nvme_start_attach(ctx);
+	if (rc != 0) {
 		free(ctx);
-		return -ENODEV;
 	}
-	ctx->poller = SPDK_POLLER_REGISTER(bdev_nvme_async_poll, ctx, 1000);
 
-	return 0;
+	return rc;
 }
 
 int
@@ -1823,10 +2639,31 @@ bdev_nvme_delete(const char *name)
 	return 0;
 }
 
+static void
+bdev_nvme_init_attach_put(void)
+{
+	assert(g_init_attaches > 0);
+	if (--g_init_attaches == 0) {
+		spdk_bdev_module_init_done(&nvme_if);
+	}
+}
+
+static void
+bdev_nvme_init_attach_done(void *cb_ctx, size_t bdev_count, int rc)
+{
+	const char *name = cb_ctx;
+
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to attach NVMe controller %s (%d): %s\n", name, rc,
+			    spdk_strerror(-rc));
+	}
+
+	bdev_nvme_init_attach_put();
+}
+
 static int
 bdev_nvme_library_init(void)
 {
-	struct nvme_bdev_ctrlr *nvme_bdev_ctrlr;
 	struct spdk_conf_section *sp;
 	const char *val;
 	int rc = 0;
@@ -1839,6 +2676,7 @@ bdev_nvme_library_init(void)
 	bool hotplug_enabled = g_nvme_hotplug_enabled;
 
 	g_bdev_nvme_init_thread = spdk_get_thread();
+	g_init_attaches = 1;
 
 	spdk_io_device_register(&g_nvme_bdev_ctrlrs, bdev_nvme_poll_group_create_cb,
 				bdev_nvme_poll_group_destroy_cb,
@@ -1909,6 +2747,16 @@ bdev_nvme_library_init(void)
 	g_opts.delay_cmd_submit = spdk_conf_section_get_boolval(sp, "DelayCmdSubmit",
 				  SPDK_BDEV_NVME_DEFAULT_DELAY_CMD_SUBMIT);
 
+	intval = spdk_conf_section_get_intval(sp, "MaxConcurrentAttaches");
+	if (intval > 0) {
+		g_opts.max_concurrent_attaches = intval;
+	}
+
+	intval = spdk_conf_section_get_intval(sp, "MaxQpairsPerCtrlr");
+	if (intval > 0) {
+		g_opts.max_qpairs_per_ctrlr = intval;
+	}
+
 	for (i = 0; i < NVME_MAX_CONTROLLERS; i++) {
 		val = spdk_conf_section_get_nmval(sp, "TransportID", i, 0);
 		if (val == NULL) {
@@ -1951,58 +2799,26 @@ bdev_nvme_library_init(void)
 		probe_ctx->count++;
 
 		if (probe_ctx->trids[i].trtype != SPDK_NVME_TRANSPORT_PCIE) {
-			struct spdk_nvme_ctrlr *ctrlr;
-			struct spdk_nvme_ctrlr_opts opts;
-
-			if (nvme_bdev_ctrlr_get(&probe_ctx->trids[i])) {
-				SPDK_ERRLOG("A controller with the provided trid (traddr: %s) already exists.\n",
-					    probe_ctx->trids[i].traddr);
-				rc = -1;
-				goto end;
-			}
-
 			if (probe_ctx->trids[i].subnqn[0] == '\0') {
 				SPDK_ERRLOG("Need to provide subsystem nqn\n");
 				rc = -1;
 				goto end;
 			}
 
-			spdk_nvme_ctrlr_get_default_ctrlr_opts(&opts, sizeof(opts));
-			opts.transport_retry_count = g_opts.retry_count;
-
-			if (probe_ctx->hostnqn != NULL) {
-				snprintf(opts.hostnqn, sizeof(opts.hostnqn), "%s", probe_ctx->hostnqn);
-			}
-
-			if (probe_ctx->hostids[i].hostaddr[0] != '\0') {
-				snprintf(opts.src_addr, sizeof(opts.src_addr), "%s", probe_ctx->hostids[i].hostaddr);
-			}
-
-			if (probe_ctx->hostids[i].hostsvcid[0] != '\0') {
-				snprintf(opts.src_svcid, sizeof(opts.src_svcid), "%s", probe_ctx->hostids[i].hostsvcid);
-			}
-
-			ctrlr = spdk_nvme_connect(&probe_ctx->trids[i], &opts, sizeof(opts));
-			if (ctrlr == NULL) {
-				SPDK_ERRLOG("Unable to connect to provided trid (traddr: %s)\n",
-					    probe_ctx->trids[i].traddr);
-				rc = -1;
-				goto end;
-			}
-
-			rc = create_ctrlr(ctrlr, probe_ctx->names[i], &probe_ctx->trids[i], 0);
+			/*
+			 * Fabrics controllers are attached in the background so that a slow
+			 *  or unreachable target doesn't hold up the others.  Module init
+			 *  completes once all of them have finished attaching.
+			 */
+			rc = bdev_nvme_create(&probe_ctx->trids[i], &probe_ctx->hostids[i],
+					      probe_ctx->names[i], NULL, 0, probe_ctx->hostnqn,
+					      probe_ctx->prchk_flags[i], bdev_nvme_init_attach_done,
+					      (void *)probe_ctx->names[i]);
 			if (rc) {
+				rc = -1;
 				goto end;
 			}
-
-			nvme_bdev_ctrlr = nvme_bdev_ctrlr_get(&probe_ctx->trids[i]);
-			if (!nvme_bdev_ctrlr) {
-				SPDK_ERRLOG("Failed to find new NVMe controller\n");
-				rc = -ENODEV;
-				goto end;
-			}
-
-			nvme_ctrlr_populate_namespaces(nvme_bdev_ctrlr, NULL);
+			g_init_attaches++;
 		} else {
 			local_nvme_num++;
 		}
@@ -2034,6 +2850,9 @@ bdev_nvme_library_init(void)
 	}
 end:
 	free(probe_ctx);
+	if (rc == 0) {
+		bdev_nvme_init_attach_put();
+	}
 	return rc;
 }
 
@@ -2042,12 +2861,21 @@ bdev_nvme_library_fini(void)
 {
 	struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, *tmp;
 	struct nvme_probe_skip_entry *entry, *entry_tmp;
+	struct nvme_async_probe_ctx *ctx;
 	struct nvme_bdev_ns *ns;
 	uint32_t i;
 
 	spdk_poller_unregister(&g_hotplug_poller);
 	free(g_hotplug_probe_ctx);
 
+	while ((ctx = TAILQ_FIRST(&g_queued_attaches)) != NULL) {
+		TAILQ_REMOVE(&g_queued_attaches, ctx, tailq);
+		if (ctx->cb_fn) {
+			ctx->cb_fn(ctx->cb_ctx, 0, -ECANCELED);
+		}
+		free(ctx);
+	}
+
 	TAILQ_FOREACH_SAFE(entry, &g_skipped_nvme_ctrlrs, tailq, entry_tmp) {
 		TAILQ_REMOVE(&g_skipped_nvme_ctrlrs, entry, tailq);
 		free(entry);
@@ -2133,6 +2961,47 @@ bdev_nvme_verify_pi_error(struct spdk_bdev_io *bdev_io)
 	}
 }
 
+static void
+bdev_nvme_admin_passthru_completion(void *ctx)
+{
+	struct nvme_bdev_io *bio = ctx;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+
+	spdk_bdev_io_complete_nvme_status(bdev_io,
+					  bio->cpl.cdw0, bio->cpl.status.sct, bio->cpl.status.sc);
+}
+
+/*
+ * I/O staged to the owner of a shared qpair completes on the owner thread and is
+ * passed back to the thread it was submitted on.
+ */
+static void
+bdev_nvme_io_complete_nvme_status(struct nvme_bdev_io *bio, uint32_t cdw0, int sct, int sc)
+{
+	if (spdk_likely(bio->orig_thread == NULL)) {
+		spdk_bdev_io_complete_nvme_status(spdk_bdev_io_from_ctx(bio), cdw0, sct, sc);
+		return;
+	}
+
+	bio->cpl.cdw0 = cdw0;
+	bio->cpl.status.sct = sct;
+	bio->cpl.status.sc = sc;
+	spdk_thread_send_msg(bio->orig_thread, bdev_nvme_admin_passthru_completion, bio);
+}
+
+static struct spdk_nvme_qpair *
+bdev_nvme_io_get_qpair(struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_io_channel *ch = spdk_bdev_io_get_io_channel(bdev_io);
+	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
+
+	if (nvme_ch->stage != NULL) {
+		return nvme_ch->shared_qpair->qpair;
+	}
+
+	return nvme_ch->qpair;
+}
+
 static void
 bdev_nvme_no_pi_readv_done(void *ref, const struct spdk_nvme_cpl *cpl)
 {
@@ -2145,7 +3014,7 @@ bdev_nvme_no_pi_readv_done(void *ref, const struct spdk_nvme_cpl *cpl)
 	}
 
 	/* Return original completion status */
-	spdk_bdev_io_complete_nvme_status(bdev_io, bio->cpl.cdw0, bio->cpl.status.sct,
+	bdev_nvme_io_complete_nvme_status(bio, bio->cpl.cdw0, bio->cpl.status.sct,
 					  bio->cpl.status.sc);
 }
 
@@ -2165,7 +3034,7 @@ bdev_nvme_readv_done(void *ref, const struct spdk_nvme_cpl *cpl)
 
 		/* Read without PI checking to verify PI error. */
 		ret = bdev_nvme_no_pi_readv((struct nvme_bdev *)bdev_io->bdev->ctxt,
-					    spdk_bdev_io_get_io_channel(bdev_io),
+					    bdev_nvme_io_get_qpair(bdev_io),
 					    bio,
 					    bdev_io->u.bdev.iovs,
 					    bdev_io->u.bdev.iovcnt,
@@ -2177,13 +3046,14 @@ bdev_nvme_readv_done(void *ref, const struct spdk_nvme_cpl *cpl)
 		}
 	}
 
-	spdk_bdev_io_complete_nvme_status(bdev_io, cpl->cdw0, cpl->status.sct, cpl->status.sc);
+	bdev_nvme_io_complete_nvme_status(bio, cpl->cdw0, cpl->status.sct, cpl->status.sc);
 }
 
 static void
 bdev_nvme_writev_done(void *ref, const struct spdk_nvme_cpl *cpl)
 {
-	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx((struct nvme_bdev_io *)ref);
+	struct nvme_bdev_io *bio = ref;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
 
 	if (spdk_nvme_cpl_is_pi_error(cpl)) {
 		SPDK_ERRLOG("writev completed with PI error (sct=%d, sc=%d)\n",
@@ -2192,13 +3062,14 @@ bdev_nvme_writev_done(void *ref, const struct spdk_nvme_cpl *cpl)
 		bdev_nvme_verify_pi_error(bdev_io);
 	}
 
-	spdk_bdev_io_complete_nvme_status(bdev_io, cpl->cdw0, cpl->status.sct, cpl->status.sc);
+	bdev_nvme_io_complete_nvme_status(bio, cpl->cdw0, cpl->status.sct, cpl->status.sc);
 }
 
 static void
 bdev_nvme_comparev_done(void *ref, const struct spdk_nvme_cpl *cpl)
 {
-	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx((struct nvme_bdev_io *)ref);
+	struct nvme_bdev_io *bio = ref;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
 
 	if (spdk_nvme_cpl_is_pi_error(cpl)) {
 		SPDK_ERRLOG("comparev completed with PI error (sct=%d, sc=%d)\n",
@@ -2207,15 +3078,35 @@ bdev_nvme_comparev_done(void *ref, const struct spdk_nvme_cpl *cpl)
 		bdev_nvme_verify_pi_error(bdev_io);
 	}
 
-	spdk_bdev_io_complete_nvme_status(bdev_io, cpl->cdw0, cpl->status.sct, cpl->status.sc);
+	bdev_nvme_io_complete_nvme_status(bio, cpl->cdw0, cpl->status.sct, cpl->status.sc);
 }
 
 static void
-bdev_nvme_comparev_and_writev_done(void *ref, const struct spdk_nvme_cpl *cpl)
+bdev_nvme_zone_appendv_done(void *ref, const struct spdk_nvme_cpl *cpl)
 {
 	struct nvme_bdev_io *bio = ref;
 	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
 
+	/* spdk_bdev_io_get_append_location() returns the offset of the I/O, the LBA
+	 * the data was written at is in dwords 0 and 1 of the completion.
+	 */
+	bdev_io->u.bdev.offset_blocks = ((uint64_t)cpl->rsvd1 << 32) | cpl->cdw0;
+
+	if (spdk_nvme_cpl_is_pi_error(cpl)) {
+		SPDK_ERRLOG("zone append completed with PI error (sct=%d, sc=%d)\n",
+			    cpl->status.sct, cpl->status.sc);
+		/* Run PI verification for zone append data buffer if PI error is detected. */
+		bdev_nvme_verify_pi_error(bdev_io);
+	}
+
+	bdev_nvme_io_complete_nvme_status(bio, cpl->cdw0, cpl->status.sct, cpl->status.sc);
+}
+
+static void
+bdev_nvme_comparev_and_writev_done(void *ref, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_bdev_io *bio = ref;
+
 	/* Compare operation completion */
 	if ((cpl->cdw0 & 0xFF) == SPDK_NVME_OPC_COMPARE) {
 		/* Save compare result for write callback */
@@ -2232,28 +3123,17 @@ bdev_nvme_comparev_and_writev_done(void *ref, const struct spdk_nvme_cpl *cpl)
 			SPDK_ERRLOG("Unexpected write success after compare failure.\n");
 		}
 
-		spdk_bdev_io_complete_nvme_status(bdev_io, bio->cpl.cdw0, bio->cpl.status.sct, bio->cpl.status.sc);
+		bdev_nvme_io_complete_nvme_status(bio, bio->cpl.cdw0, bio->cpl.status.sct,
+						  bio->cpl.status.sc);
 	} else {
-		spdk_bdev_io_complete_nvme_status(bdev_io, cpl->cdw0, cpl->status.sct, cpl->status.sc);
+		bdev_nvme_io_complete_nvme_status(bio, cpl->cdw0, cpl->status.sct, cpl->status.sc);
 	}
 }
 
 static void
 bdev_nvme_queued_done(void *ref, const struct spdk_nvme_cpl *cpl)
 {
-	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx((struct nvme_bdev_io *)ref);
-
-	spdk_bdev_io_complete_nvme_status(bdev_io, cpl->cdw0, cpl->status.sct, cpl->status.sc);
-}
-
-static void
-bdev_nvme_admin_passthru_completion(void *ctx)
-{
-	struct nvme_bdev_io *bio = ctx;
-	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
-
-	spdk_bdev_io_complete_nvme_status(bdev_io,
-					  bio->cpl.cdw0, bio->cpl.status.sct, bio->cpl.status.sc);
+	bdev_nvme_io_complete_nvme_status(ref, cpl->cdw0, cpl->status.sct, cpl->status.sc);
 }
 
 static void
@@ -2378,11 +3258,10 @@ bdev_nvme_queued_next_fused_sge(void *ref, void **address, uint32_t *length)
 }
 
 static int
-bdev_nvme_no_pi_readv(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+bdev_nvme_no_pi_readv(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 		      struct nvme_bdev_io *bio, struct iovec *iov, int iovcnt,
 		      void *md, uint64_t lba_count, uint64_t lba)
 {
-	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
 	int rc;
 
 	SPDK_DEBUGLOG(SPDK_LOG_BDEV_NVME, "read %lu blocks with offset %#lx without PI check\n",
@@ -2393,7 +3272,7 @@ bdev_nvme_no_pi_readv(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 	bio->iovpos = 0;
 	bio->iov_offset = 0;
 
-	rc = spdk_nvme_ns_cmd_readv_with_md(nbdev->nvme_ns->ns, nvme_ch->qpair, lba, lba_count,
+	rc = spdk_nvme_ns_cmd_readv_with_md(nbdev->nvme_ns->ns, qpair, lba, lba_count,
 					    bdev_nvme_no_pi_readv_done, bio, 0,
 					    bdev_nvme_queued_reset_sgl, bdev_nvme_queued_next_sge,
 					    md, 0, 0);
@@ -2405,11 +3284,10 @@ bdev_nvme_no_pi_readv(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 }
 
 static int
-bdev_nvme_readv(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+bdev_nvme_readv(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 		struct nvme_bdev_io *bio, struct iovec *iov, int iovcnt,
 		void *md, uint64_t lba_count, uint64_t lba)
 {
-	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
 	int rc;
 
 	SPDK_DEBUGLOG(SPDK_LOG_BDEV_NVME, "read %lu blocks with offset %#lx\n",
@@ -2420,7 +3298,7 @@ bdev_nvme_readv(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 	bio->iovpos = 0;
 	bio->iov_offset = 0;
 
-	rc = spdk_nvme_ns_cmd_readv_with_md(nbdev->nvme_ns->ns, nvme_ch->qpair, lba, lba_count,
+	rc = spdk_nvme_ns_cmd_readv_with_md(nbdev->nvme_ns->ns, qpair, lba, lba_count,
 					    bdev_nvme_readv_done, bio, nbdev->disk.dif_check_flags,
 					    bdev_nvme_queued_reset_sgl, bdev_nvme_queued_next_sge,
 					    md, 0, 0);
@@ -2432,11 +3310,10 @@ bdev_nvme_readv(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 }
 
 static int
-bdev_nvme_writev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+bdev_nvme_writev(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 		 struct nvme_bdev_io *bio,
 		 struct iovec *iov, int iovcnt, void *md, uint64_t lba_count, uint64_t lba)
 {
-	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
 	int rc;
 
 	SPDK_DEBUGLOG(SPDK_LOG_BDEV_NVME, "write %lu blocks with offset %#lx\n",
@@ -2447,7 +3324,7 @@ bdev_nvme_writev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 	bio->iovpos = 0;
 	bio->iov_offset = 0;
 
-	rc = spdk_nvme_ns_cmd_writev_with_md(nbdev->nvme_ns->ns, nvme_ch->qpair, lba, lba_count,
+	rc = spdk_nvme_ns_cmd_writev_with_md(nbdev->nvme_ns->ns, qpair, lba, lba_count,
 					     bdev_nvme_writev_done, bio, nbdev->disk.dif_check_flags,
 					     bdev_nvme_queued_reset_sgl, bdev_nvme_queued_next_sge,
 					     md, 0, 0);
@@ -2459,11 +3336,37 @@ bdev_nvme_writev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 }
 
 static int
-bdev_nvme_comparev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+bdev_nvme_zone_appendv(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
+		       struct nvme_bdev_io *bio,
+		       struct iovec *iov, int iovcnt, void *md, uint64_t lba_count, uint64_t zslba)
+{
+	int rc;
+
+	SPDK_DEBUGLOG(SPDK_LOG_BDEV_NVME, "zone append %lu blocks to zone start lba %#lx\n",
+		      lba_count, zslba);
+
+	bio->iovs = iov;
+	bio->iovcnt = iovcnt;
+	bio->iovpos = 0;
+	bio->iov_offset = 0;
+
+	rc = spdk_nvme_zns_zone_appendv_with_md(nbdev->nvme_ns->ns, qpair, zslba, lba_count,
+						bdev_nvme_zone_appendv_done, bio,
+						nbdev->disk.dif_check_flags,
+						bdev_nvme_queued_reset_sgl,
+						bdev_nvme_queued_next_sge, md, 0, 0);
+
+	if (rc != 0 && rc != -ENOMEM) {
+		SPDK_ERRLOG("zone append failed: rc = %d\n", rc);
+	}
+	return rc;
+}
+
+static int
+bdev_nvme_comparev(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 		   struct nvme_bdev_io *bio,
 		   struct iovec *iov, int iovcnt, void *md, uint64_t lba_count, uint64_t lba)
 {
-	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
 	int rc;
 
 	SPDK_DEBUGLOG(SPDK_LOG_BDEV_NVME, "compare %lu blocks with offset %#lx\n",
@@ -2474,7 +3377,7 @@ bdev_nvme_comparev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 	bio->iovpos = 0;
 	bio->iov_offset = 0;
 
-	rc = spdk_nvme_ns_cmd_comparev_with_md(nbdev->nvme_ns->ns, nvme_ch->qpair, lba, lba_count,
+	rc = spdk_nvme_ns_cmd_comparev_with_md(nbdev->nvme_ns->ns, qpair, lba, lba_count,
 					       bdev_nvme_comparev_done, bio, nbdev->disk.dif_check_flags,
 					       bdev_nvme_queued_reset_sgl, bdev_nvme_queued_next_sge,
 					       md, 0, 0);
@@ -2486,12 +3389,10 @@ bdev_nvme_comparev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 }
 
 static int
-bdev_nvme_comparev_and_writev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+bdev_nvme_comparev_and_writev(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 			      struct nvme_bdev_io *bio, struct iovec *cmp_iov, int cmp_iovcnt, struct iovec *write_iov,
 			      int write_iovcnt, void *md, uint64_t lba_count, uint64_t lba)
 {
-	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
-	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
 	uint32_t flags = nbdev->disk.dif_check_flags;
 	int rc;
 
@@ -2507,15 +3408,11 @@ bdev_nvme_comparev_and_writev(struct nvme_bdev *nbdev, struct spdk_io_channel *c
 	bio->fused_iovpos = 0;
 	bio->fused_iov_offset = 0;
 
-	if (bdev_io->num_retries == 0) {
-		bio->first_fused_submitted = false;
-	}
-
 	if (!bio->first_fused_submitted) {
 		flags |= SPDK_NVME_IO_FLAGS_FUSE_FIRST;
 		memset(&bio->cpl, 0, sizeof(bio->cpl));
 
-		rc = spdk_nvme_ns_cmd_comparev_with_md(nbdev->nvme_ns->ns, nvme_ch->qpair, lba, lba_count,
+		rc = spdk_nvme_ns_cmd_comparev_with_md(nbdev->nvme_ns->ns, qpair, lba, lba_count,
 						       bdev_nvme_comparev_and_writev_done, bio, flags,
 						       bdev_nvme_queued_reset_sgl, bdev_nvme_queued_next_sge, md, 0, 0);
 		if (rc == 0) {
@@ -2531,7 +3428,7 @@ bdev_nvme_comparev_and_writev(struct nvme_bdev *nbdev, struct spdk_io_channel *c
 
 	flags |= SPDK_NVME_IO_FLAGS_FUSE_SECOND;
 
-	rc = spdk_nvme_ns_cmd_writev_with_md(nbdev->nvme_ns->ns, nvme_ch->qpair, lba, lba_count,
+	rc = spdk_nvme_ns_cmd_writev_with_md(nbdev->nvme_ns->ns, qpair, lba, lba_count,
 					     bdev_nvme_comparev_and_writev_done, bio, flags,
 					     bdev_nvme_queued_reset_fused_sgl, bdev_nvme_queued_next_fused_sge, md, 0, 0);
 	if (rc != 0 && rc != -ENOMEM) {
@@ -2543,12 +3440,11 @@ bdev_nvme_comparev_and_writev(struct nvme_bdev *nbdev, struct spdk_io_channel *c
 }
 
 static int
-bdev_nvme_unmap(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+bdev_nvme_unmap(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 		struct nvme_bdev_io *bio,
 		uint64_t offset_blocks,
 		uint64_t num_blocks)
 {
-	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_nvme_dsm_range dsm_ranges[SPDK_NVME_DATASET_MANAGEMENT_MAX_RANGES];
 	struct spdk_nvme_dsm_range *range;
 	uint64_t offset, remaining;
@@ -2584,7 +3480,7 @@ bdev_nvme_unmap(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 	range->length = remaining;
 	range->starting_lba = offset;
 
-	rc = spdk_nvme_ns_cmd_dataset_management(nbdev->nvme_ns->ns, nvme_ch->qpair,
+	rc = spdk_nvme_ns_cmd_dataset_management(nbdev->nvme_ns->ns, qpair,
 			SPDK_NVME_DSM_ATTR_DEALLOCATE,
 			dsm_ranges, num_ranges,
 			bdev_nvme_queued_done, bio);
@@ -2611,11 +3507,10 @@ bdev_nvme_admin_passthru(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 }
 
 static int
-bdev_nvme_io_passthru(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+bdev_nvme_io_passthru(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 		      struct nvme_bdev_io *bio,
 		      struct spdk_nvme_cmd *cmd, void *buf, size_t nbytes)
 {
-	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
 	uint32_t max_xfer_size = spdk_nvme_ctrlr_get_max_xfer_size(nbdev->nvme_bdev_ctrlr->ctrlr);
 
 	if (nbytes > max_xfer_size) {
@@ -2629,16 +3524,15 @@ bdev_nvme_io_passthru(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 	 */
 	cmd->nsid = spdk_nvme_ns_get_id(nbdev->nvme_ns->ns);
 
-	return spdk_nvme_ctrlr_cmd_io_raw(nbdev->nvme_bdev_ctrlr->ctrlr, nvme_ch->qpair, cmd, buf,
+	return spdk_nvme_ctrlr_cmd_io_raw(nbdev->nvme_bdev_ctrlr->ctrlr, qpair, cmd, buf,
 					  (uint32_t)nbytes, bdev_nvme_queued_done, bio);
 }
 
 static int
-bdev_nvme_io_passthru_md(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+bdev_nvme_io_passthru_md(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 			 struct nvme_bdev_io *bio,
 			 struct spdk_nvme_cmd *cmd, void *buf, size_t nbytes, void *md_buf, size_t md_len)
 {
-	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
 	size_t nr_sectors = nbytes / spdk_nvme_ns_get_extended_sector_size(nbdev->nvme_ns->ns);
 	uint32_t max_xfer_size = spdk_nvme_ctrlr_get_max_xfer_size(nbdev->nvme_bdev_ctrlr->ctrlr);
 
@@ -2658,7 +3552,7 @@ bdev_nvme_io_passthru_md(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 	 */
 	cmd->nsid = spdk_nvme_ns_get_id(nbdev->nvme_ns->ns);
 
-	return spdk_nvme_ctrlr_cmd_io_raw_with_md(nbdev->nvme_bdev_ctrlr->ctrlr, nvme_ch->qpair, cmd, buf,
+	return spdk_nvme_ctrlr_cmd_io_raw_with_md(nbdev->nvme_bdev_ctrlr->ctrlr, qpair, cmd, buf,
 			(uint32_t)nbytes, md_buf, bdev_nvme_queued_done, bio);
 }
 
@@ -2691,16 +3585,15 @@ bdev_nvme_abort_admin_cmd(void *ctx)
 }
 
 static int
-bdev_nvme_abort(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+bdev_nvme_abort(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
 		struct nvme_bdev_io *bio, struct nvme_bdev_io *bio_to_abort)
 {
-	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
 	int rc;
 
-	bio->orig_thread = spdk_io_channel_get_thread(ch);
+	bio->orig_thread = spdk_bdev_io_get_thread(spdk_bdev_io_from_ctx(bio));
 
 	rc = spdk_nvme_ctrlr_cmd_abort_ext(nbdev->nvme_bdev_ctrlr->ctrlr,
-					   nvme_ch->qpair,
+					   qpair,
 					   bio_to_abort,
 					   bdev_nvme_abort_done, bio);
 	if (rc == -ENOENT) {
@@ -2716,6 +3609,180 @@ bdev_nvme_abort(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 	return rc;
 }
 
+static int
+bdev_nvme_fill_zone_info(struct spdk_bdev_zone_info *info,
+			 const struct spdk_nvme_zns_zone_desc *desc)
+{
+	switch (desc->zs) {
+	case SPDK_NVME_ZONE_STATE_EMPTY:
+		info->state = SPDK_BDEV_ZONE_STATE_EMPTY;
+		break;
+	case SPDK_NVME_ZONE_STATE_IOPEN:
+	case SPDK_NVME_ZONE_STATE_EOPEN:
+		info->state = SPDK_BDEV_ZONE_STATE_OPEN;
+		break;
+	case SPDK_NVME_ZONE_STATE_CLOSED:
+		info->state = SPDK_BDEV_ZONE_STATE_CLOSED;
+		break;
+	case SPDK_NVME_ZONE_STATE_FULL:
+		info->state = SPDK_BDEV_ZONE_STATE_FULL;
+		break;
+	case SPDK_NVME_ZONE_STATE_RONLY:
+		info->state = SPDK_BDEV_ZONE_STATE_READ_ONLY;
+		break;
+	case SPDK_NVME_ZONE_STATE_OFFLINE:
+		info->state = SPDK_BDEV_ZONE_STATE_OFFLINE;
+		break;
+	default:
+		SPDK_ERRLOG("Invalid zone state: %#x in zone report\n", desc->zs);
+		return -EIO;
+	}
+
+	info->zone_id = desc->zslba;
+	info->write_pointer = desc->wp;
+	info->capacity = desc->zcap;
+
+	return 0;
+}
+
+static void
+bdev_nvme_get_zone_info_done(void *ref, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_bdev_io *bio = ref;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	struct nvme_bdev *nbdev = (struct nvme_bdev *)bdev_io->bdev->ctxt;
+	struct spdk_nvme_ns *ns = nbdev->nvme_ns->ns;
+	uint64_t zone_id = bdev_io->u.zone_mgmt.zone_id;
+	uint32_t zones_to_copy = bdev_io->u.zone_mgmt.num_zones;
+	struct spdk_bdev_zone_info *info = bdev_io->u.zone_mgmt.buf;
+	uint64_t max_zones_per_buf, i;
+	uint32_t sct, sc;
+	int rc;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		sct = cpl->status.sct;
+		sc = cpl->status.sc;
+		goto out_complete_io;
+	}
+
+	sct = SPDK_NVME_SCT_GENERIC;
+	sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+
+	max_zones_per_buf = (bio->zone_report_bufsize - sizeof(*bio->zone_report_buf)) /
+			    sizeof(bio->zone_report_buf->descs[0]);
+	if (bio->zone_report_buf->nr_zones == 0 ||
+	    bio->zone_report_buf->nr_zones > max_zones_per_buf) {
+		goto out_complete_io;
+	}
+
+	for (i = 0; i < bio->zone_report_buf->nr_zones && bio->handled_zones < zones_to_copy; i++) {
+		rc = bdev_nvme_fill_zone_info(&info[bio->handled_zones],
+					      &bio->zone_report_buf->descs[i]);
+		if (rc) {
+			goto out_complete_io;
+		}
+		bio->handled_zones++;
+	}
+
+	if (bio->handled_zones < zones_to_copy) {
+		uint64_t zone_size = spdk_nvme_zns_ns_get_zone_size_sectors(ns);
+		uint64_t slba = zone_id + (zone_size * bio->handled_zones);
+
+		memset(bio->zone_report_buf, 0, bio->zone_report_bufsize);
+		rc = spdk_nvme_zns_report_zones(ns, bdev_nvme_io_get_qpair(bdev_io),
+						bio->zone_report_buf, bio->zone_report_bufsize,
+						slba, SPDK_NVME_ZRA_LIST_ALL, true,
+						bdev_nvme_get_zone_info_done, bio);
+		if (!rc) {
+			return;
+		}
+		goto out_complete_io;
+	}
+
+	sct = SPDK_NVME_SCT_GENERIC;
+	sc = SPDK_NVME_SC_SUCCESS;
+
+out_complete_io:
+	free(bio->zone_report_buf);
+	bio->zone_report_buf = NULL;
+	bdev_nvme_io_complete_nvme_status(bio, 0, sct, sc);
+}
+
+static int
+bdev_nvme_get_zone_info(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
+			struct nvme_bdev_io *bio, uint64_t zone_id, uint32_t num_zones,
+			struct spdk_bdev_zone_info *info)
+{
+	struct spdk_nvme_ns *ns = nbdev->nvme_ns->ns;
+	uint64_t zone_size = spdk_nvme_zns_ns_get_zone_size_sectors(ns);
+	uint64_t total_zones = spdk_nvme_zns_ns_get_num_zones(ns);
+	uint64_t bufsize;
+	int rc;
+
+	if (zone_id % zone_size != 0) {
+		return -EINVAL;
+	}
+
+	if (num_zones == 0 || zone_id / zone_size + num_zones > total_zones) {
+		return -EINVAL;
+	}
+
+	/* Report as many zones as were asked for in one command, if a command can carry them */
+	bufsize = sizeof(*bio->zone_report_buf) +
+		  num_zones * sizeof(bio->zone_report_buf->descs[0]);
+	bio->zone_report_bufsize = spdk_min(bufsize, spdk_nvme_ns_get_max_io_xfer_size(ns));
+
+	bio->zone_report_buf = calloc(1, bio->zone_report_bufsize);
+	if (!bio->zone_report_buf) {
+		return -ENOMEM;
+	}
+
+	bio->handled_zones = 0;
+
+	rc = spdk_nvme_zns_report_zones(ns, qpair, bio->zone_report_buf, bio->zone_report_bufsize,
+					zone_id, SPDK_NVME_ZRA_LIST_ALL, true,
+					bdev_nvme_get_zone_info_done, bio);
+	if (rc) {
+		free(bio->zone_report_buf);
+		bio->zone_report_buf = NULL;
+	}
+
+	return rc;
+}
+
+static void
+bdev_nvme_zone_management_done(void *ref, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_bdev_io *bio = ref;
+
+	bdev_nvme_io_complete_nvme_status(bio, cpl->cdw0, cpl->status.sct, cpl->status.sc);
+}
+
+static int
+bdev_nvme_zone_management(struct nvme_bdev *nbdev, struct spdk_nvme_qpair *qpair,
+			  struct nvme_bdev_io *bio, uint64_t zone_id,
+			  enum spdk_bdev_zone_action action)
+{
+	struct spdk_nvme_ns *ns = nbdev->nvme_ns->ns;
+
+	switch (action) {
+	case SPDK_BDEV_ZONE_CLOSE:
+		return spdk_nvme_zns_close_zone(ns, qpair, zone_id, false,
+						bdev_nvme_zone_management_done, bio);
+	case SPDK_BDEV_ZONE_FINISH:
+		return spdk_nvme_zns_finish_zone(ns, qpair, zone_id, false,
+						 bdev_nvme_zone_management_done, bio);
+	case SPDK_BDEV_ZONE_OPEN:
+		return spdk_nvme_zns_open_zone(ns, qpair, zone_id, false,
+					       bdev_nvme_zone_management_done, bio);
+	case SPDK_BDEV_ZONE_RESET:
+		return spdk_nvme_zns_reset_zone(ns, qpair, zone_id, false,
+						bdev_nvme_zone_management_done, bio);
+	default:
+		return -EINVAL;
+	}
+}
+
 static void
 bdev_nvme_get_spdk_running_config(FILE *fp)
 {
@@ -2813,6 +3880,13 @@ bdev_nvme_get_spdk_running_config(FILE *fp)
 		fprintf(fp, "HostNQN %s\n",  g_nvme_hostnqn);
 	}
 	fprintf(fp, "DelayCmdSubmit %s\n", g_opts.delay_cmd_submit ? "True" : "False");
+	fprintf(fp, "\n"
+		"# Maximum number of controllers attached at the same time, 0 for no limit.\n");
+	fprintf(fp, "MaxConcurrentAttaches %u\n", g_opts.max_concurrent_attaches);
+	fprintf(fp, "\n"
+		"# Maximum number of I/O qpairs per controller shared by all threads,\n"
+		"# 0 for a qpair per thread.\n");
+	fprintf(fp, "MaxQpairsPerCtrlr %u\n", g_opts.max_qpairs_per_ctrlr);
 
 	fprintf(fp, "\n");
 }
@@ -2861,6 +3935,8 @@ bdev_nvme_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_uint64(w, "nvme_ioq_poll_period_us", g_opts.nvme_ioq_poll_period_us);
 	spdk_json_write_named_uint32(w, "io_queue_requests", g_opts.io_queue_requests);
 	spdk_json_write_named_bool(w, "delay_cmd_submit", g_opts.delay_cmd_submit);
+	spdk_json_write_named_uint32(w, "max_concurrent_attaches", g_opts.max_concurrent_attaches);
+	spdk_json_write_named_uint32(w, "max_qpairs_per_ctrlr", g_opts.max_qpairs_per_ctrlr);
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
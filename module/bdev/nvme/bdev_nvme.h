@@ -60,8 +60,13 @@ struct spdk_bdev_nvme_opts {
 	uint64_t nvme_ioq_poll_period_us;
 	uint32_t io_queue_requests;
 	bool delay_cmd_submit;
+	/* Maximum number of controllers attached at the same time, 0 for no limit */
+	uint32_t max_concurrent_attaches;
+	/* Maximum number of I/O qpairs per controller shared by all threads, 0 for one per thread */
+	uint32_t max_qpairs_per_ctrlr;
 };
 
+/* Returns NULL if the channel passes its I/O to a qpair owned by another thread */
 struct spdk_nvme_qpair *bdev_nvme_get_io_qpair(struct spdk_io_channel *ctrlr_io_ch);
 void bdev_nvme_get_opts(struct spdk_bdev_nvme_opts *opts);
 int bdev_nvme_set_opts(const struct spdk_bdev_nvme_opts *opts);
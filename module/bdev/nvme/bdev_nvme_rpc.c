@@ -84,6 +84,8 @@ static const struct spdk_json_object_decoder rpc_bdev_nvme_options_decoders[] =
 	{"nvme_ioq_poll_period_us", offsetof(struct spdk_bdev_nvme_opts, nvme_ioq_poll_period_us), spdk_json_decode_uint64, true},
 	{"io_queue_requests", offsetof(struct spdk_bdev_nvme_opts, io_queue_requests), spdk_json_decode_uint32, true},
 	{"delay_cmd_submit", offsetof(struct spdk_bdev_nvme_opts, delay_cmd_submit), spdk_json_decode_bool, true},
+	{"max_concurrent_attaches", offsetof(struct spdk_bdev_nvme_opts, max_concurrent_attaches), spdk_json_decode_uint32, true},
+	{"max_qpairs_per_ctrlr", offsetof(struct spdk_bdev_nvme_opts, max_qpairs_per_ctrlr), spdk_json_decode_uint32, true},
 };
 
 static void
@@ -376,6 +378,10 @@ rpc_dump_nvme_controller_info(struct spdk_json_write_ctx *w,
 	nvme_bdev_dump_trid_json(trid, w);
 	spdk_json_write_object_end(w);
 
+	if (nvme_bdev_ctrlr->attach_time_us != 0) {
+		spdk_json_write_named_uint64(w, "attach_time_us", nvme_bdev_ctrlr->attach_time_us);
+	}
+
 	spdk_json_write_object_end(w);
 }
 
@@ -487,6 +493,204 @@ SPDK_RPC_REGISTER("bdev_nvme_detach_controller", rpc_bdev_nvme_detach_controller
 		  SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_nvme_detach_controller, delete_nvme_controller)
 
+/* The poll group statistics are collected into buf first, so that an error on
+ * any of the channels can still be reported as an error response.
+ */
+struct rpc_get_transport_stats_ctx {
+	struct spdk_jsonrpc_request *request;
+	struct spdk_json_write_ctx *w;
+	char *buf;
+	size_t buf_len;
+	size_t buf_size;
+};
+
+static int
+rpc_bdev_nvme_stats_write_cb(void *cb_ctx, const void *data, size_t size)
+{
+	struct rpc_get_transport_stats_ctx *ctx = cb_ctx;
+	size_t new_size = spdk_max(ctx->buf_size, 4096);
+	char *new_buf;
+
+	while (new_size - ctx->buf_len < size) {
+		new_size *= 2;
+	}
+	if (new_size != ctx->buf_size) {
+		new_buf = realloc(ctx->buf, new_size);
+		if (new_buf == NULL) {
+			return -ENOMEM;
+		}
+		ctx->buf = new_buf;
+		ctx->buf_size = new_size;
+	}
+
+	memcpy(ctx->buf + ctx->buf_len, data, size);
+	ctx->buf_len += size;
+	return 0;
+}
+
+static void
+rpc_bdev_nvme_pcie_stats(struct spdk_json_write_ctx *w,
+			 struct spdk_nvme_transport_poll_group_stat *stat)
+{
+	struct spdk_nvme_pcie_stat *pcie_stat = &stat->u.pcie;
+
+	spdk_json_write_named_uint64(w, "polls", pcie_stat->polls);
+	spdk_json_write_named_uint64(w, "idle_polls", pcie_stat->idle_polls);
+	spdk_json_write_named_uint64(w, "completions", pcie_stat->completions);
+	spdk_json_write_named_uint64(w, "submitted_requests", pcie_stat->submitted_requests);
+	spdk_json_write_named_uint64(w, "queued_requests", pcie_stat->queued_requests);
+	spdk_json_write_named_uint64(w, "sq_doorbell_updates", pcie_stat->sq_doorbell_updates);
+	spdk_json_write_named_uint64(w, "cq_doorbell_updates", pcie_stat->cq_doorbell_updates);
+}
+
+static void
+rpc_bdev_nvme_tcp_stats(struct spdk_json_write_ctx *w,
+			struct spdk_nvme_transport_poll_group_stat *stat)
+{
+	struct spdk_nvme_tcp_stat *tcp_stat = &stat->u.tcp;
+
+	spdk_json_write_named_uint64(w, "polls", tcp_stat->polls);
+	spdk_json_write_named_uint64(w, "idle_polls", tcp_stat->idle_polls);
+	spdk_json_write_named_uint64(w, "submitted_requests", tcp_stat->submitted_requests);
+	spdk_json_write_named_uint64(w, "queued_requests", tcp_stat->queued_requests);
+	spdk_json_write_named_uint64(w, "nvme_completions", tcp_stat->nvme_completions);
+	spdk_json_write_named_uint64(w, "recv_syscalls", tcp_stat->recv_syscalls);
+	spdk_json_write_named_uint64(w, "recv_pdus", tcp_stat->recv_pdus);
+	spdk_json_write_named_uint64(w, "recv_buffered_bytes", tcp_stat->recv_buffered_bytes);
+	spdk_json_write_named_uint64(w, "recv_direct_bytes", tcp_stat->recv_direct_bytes);
+	spdk_json_write_named_uint64(w, "recv_partial_reads", tcp_stat->recv_partial_reads);
+}
+
+static void
+rpc_bdev_nvme_rdma_stats(struct spdk_json_write_ctx *w,
+			 struct spdk_nvme_transport_poll_group_stat *stat)
+{
+	struct spdk_nvme_rdma_stat *rdma_stat = &stat->u.rdma;
+
+	spdk_json_write_named_uint64(w, "polls", rdma_stat->polls);
+	spdk_json_write_named_uint64(w, "idle_polls", rdma_stat->idle_polls);
+	spdk_json_write_named_uint64(w, "completions", rdma_stat->completions);
+	spdk_json_write_named_uint64(w, "queued_requests", rdma_stat->queued_requests);
+	spdk_json_write_named_uint64(w, "total_send_wrs", rdma_stat->total_send_wrs);
+	spdk_json_write_named_uint64(w, "send_doorbell_updates", rdma_stat->send_doorbell_updates);
+	spdk_json_write_named_uint64(w, "total_recv_wrs", rdma_stat->total_recv_wrs);
+	spdk_json_write_named_uint64(w, "recv_doorbell_updates", rdma_stat->recv_doorbell_updates);
+}
+
+static void
+rpc_bdev_nvme_stats_per_channel(struct spdk_io_channel_iter *i)
+{
+	struct rpc_get_transport_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct nvme_bdev_poll_group *group = spdk_io_channel_get_ctx(ch);
+	struct spdk_nvme_poll_group_stat *stat;
+	struct spdk_nvme_transport_poll_group_stat *tr_stat;
+	uint32_t j;
+	int rc;
+
+	rc = spdk_nvme_poll_group_get_stats(group->group, &stat);
+	if (rc) {
+		SPDK_ERRLOG("Failed to get poll group statistics, rc %d\n", rc);
+		spdk_for_each_channel_continue(i, rc);
+		return;
+	}
+
+	spdk_json_write_object_begin(ctx->w);
+	spdk_json_write_named_string(ctx->w, "thread", spdk_thread_get_name(spdk_get_thread()));
+	spdk_json_write_named_array_begin(ctx->w, "transports");
+
+	for (j = 0; j < stat->num_transports; j++) {
+		tr_stat = &stat->transport_stat[j];
+		spdk_json_write_object_begin(ctx->w);
+		spdk_json_write_named_string(ctx->w, "trname",
+					     spdk_nvme_transport_id_trtype_str(tr_stat->trtype));
+
+		switch (tr_stat->trtype) {
+		case SPDK_NVME_TRANSPORT_PCIE:
+			rpc_bdev_nvme_pcie_stats(ctx->w, tr_stat);
+			break;
+		case SPDK_NVME_TRANSPORT_TCP:
+			rpc_bdev_nvme_tcp_stats(ctx->w, tr_stat);
+			break;
+		case SPDK_NVME_TRANSPORT_RDMA:
+			rpc_bdev_nvme_rdma_stats(ctx->w, tr_stat);
+			break;
+		default:
+			break;
+		}
+		spdk_json_write_object_end(ctx->w);
+	}
+
+	spdk_json_write_array_end(ctx->w);
+	spdk_json_write_object_end(ctx->w);
+
+	spdk_nvme_poll_group_free_stats(stat);
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+rpc_bdev_nvme_stats_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct rpc_get_transport_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_json_write_ctx *w;
+
+	spdk_json_write_array_end(ctx->w);
+	if (spdk_json_write_end(ctx->w) != 0 && status == 0) {
+		status = -ENOMEM;
+	}
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(-status));
+	} else {
+		w = spdk_jsonrpc_begin_result(ctx->request);
+		spdk_json_write_object_begin(w);
+		spdk_json_write_name(w, "poll_groups");
+		spdk_json_write_val_raw(w, ctx->buf, ctx->buf_len);
+		spdk_json_write_object_end(w);
+		spdk_jsonrpc_end_result(ctx->request, w);
+	}
+
+	free(ctx->buf);
+	free(ctx);
+}
+
+static void
+rpc_bdev_nvme_get_transport_statistics(struct spdk_jsonrpc_request *request,
+				       const struct spdk_json_val *params)
+{
+	struct rpc_get_transport_stats_ctx *ctx;
+
+	if (params) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "'bdev_nvme_get_transport_statistics' requires no arguments");
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Memory allocation error");
+		return;
+	}
+	ctx->request = request;
+	ctx->w = spdk_json_write_begin(rpc_bdev_nvme_stats_write_cb, ctx, 0);
+	if (!ctx->w) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Memory allocation error");
+		free(ctx);
+		return;
+	}
+	spdk_json_write_array_begin(ctx->w);
+
+	spdk_for_each_channel(&g_nvme_bdev_ctrlrs,
+			      rpc_bdev_nvme_stats_per_channel,
+			      ctx,
+			      rpc_bdev_nvme_stats_done);
+}
+SPDK_RPC_REGISTER("bdev_nvme_get_transport_statistics", rpc_bdev_nvme_get_transport_statistics,
+		  SPDK_RPC_RUNTIME)
+
 struct rpc_apply_firmware {
 	char *filename;
 	char *bdev_name;
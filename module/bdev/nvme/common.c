@@ -89,7 +89,11 @@ nvme_bdev_dump_trid_json(struct spdk_nvme_transport_id *trid, struct spdk_json_w
 	const char *trtype_str;
 	const char *adrfam_str;
 
-	trtype_str = spdk_nvme_transport_id_trtype_str(trid->trtype);
+	if (trid->trtype == SPDK_NVME_TRANSPORT_CUSTOM) {
+		trtype_str = trid->trstring;
+	} else {
+		trtype_str = spdk_nvme_transport_id_trtype_str(trid->trtype);
+	}
 	if (trtype_str) {
 		spdk_json_write_named_string(w, "trtype", trtype_str);
 	}
@@ -112,13 +116,19 @@ nvme_bdev_dump_trid_json(struct spdk_nvme_transport_id *trid, struct spdk_json_w
 	}
 }
 
-static void
+void
 nvme_bdev_unregister_cb(void *io_device)
 {
 	struct nvme_bdev_ctrlr *nvme_bdev_ctrlr = io_device;
 	uint32_t i;
 
 	pthread_mutex_lock(&g_bdev_nvme_mutex);
+	if (nvme_bdev_ctrlr->num_shared_qpairs != 0) {
+		/* The last shared qpair to be freed calls us again */
+		nvme_bdev_ctrlr->detach_pending = true;
+		pthread_mutex_unlock(&g_bdev_nvme_mutex);
+		return;
+	}
 	TAILQ_REMOVE(&g_nvme_bdev_ctrlrs, nvme_bdev_ctrlr, tailq);
 	pthread_mutex_unlock(&g_bdev_nvme_mutex);
 	spdk_nvme_detach(nvme_bdev_ctrlr->ctrlr);
@@ -68,6 +68,7 @@ struct nvme_bdev_ns {
 };
 
 struct ocssd_bdev_ctrlr;
+struct nvme_bdev_shared_qpair;
 
 struct nvme_bdev_ctrlr {
 	/**
@@ -87,6 +88,8 @@ struct nvme_bdev_ctrlr {
 	 * NVMe controllers are not included.
 	 */
 	uint32_t			prchk_flags;
+	/** Time from the start of the connect to the namespaces being populated */
+	uint64_t			attach_time_us;
 	uint32_t			num_ns;
 	/** Array of pointers to namespaces indexed by nsid - 1 */
 	struct nvme_bdev_ns		**namespaces;
@@ -99,6 +102,16 @@ struct nvme_bdev_ctrlr {
 
 	struct ocssd_bdev_ctrlr		*ocssd_ctrlr;
 
+	/**
+	 * I/O qpairs shared by the channels of several threads when the number of
+	 * qpairs per controller is capped. Protected by g_bdev_nvme_mutex.
+	 */
+	TAILQ_HEAD(, nvme_bdev_shared_qpair)	shared_qpairs;
+	/** Shared qpairs created and not freed yet, including the ones being torn down */
+	uint32_t				num_shared_qpairs;
+	/** The io_device was unregistered while shared qpairs were still being freed */
+	bool					detach_pending;
+
 	/** linked list pointer for device list */
 	TAILQ_ENTRY(nvme_bdev_ctrlr)	tailq;
 };
@@ -110,8 +123,12 @@ struct nvme_bdev {
 	TAILQ_ENTRY(nvme_bdev)	tailq;
 };
 
+struct nvme_bdev_accel_task;
+
 struct nvme_bdev_poll_group {
 	struct spdk_nvme_poll_group		*group;
+	struct spdk_io_channel			*accel_channel;
+	STAILQ_HEAD(, nvme_bdev_accel_task)	free_accel_tasks;
 	struct spdk_poller			*poller;
 	bool					collect_spin_stat;
 	uint64_t				spin_ticks;
@@ -133,15 +150,23 @@ struct nvme_async_probe_ctx {
 	spdk_bdev_create_nvme_fn cb_fn;
 	void *cb_ctx;
 	uint32_t populates_in_progress;
+	uint64_t start_ticks;
+	TAILQ_ENTRY(nvme_async_probe_ctx) tailq;
 };
 
 struct ocssd_io_channel;
+struct nvme_bdev_shared_qpair_stage;
 
 struct nvme_io_channel {
-	struct spdk_nvme_qpair		*qpair;
-	struct nvme_bdev_poll_group	*group;
-	TAILQ_HEAD(, spdk_bdev_io)	pending_resets;
-	struct ocssd_io_channel		*ocssd_ioch;
+	/** NULL while resetting, or if I/O is staged to a qpair owned by another thread */
+	struct spdk_nvme_qpair			*qpair;
+	struct nvme_bdev_poll_group		*group;
+	TAILQ_HEAD(, spdk_bdev_io)		pending_resets;
+	struct ocssd_io_channel			*ocssd_ioch;
+	/** Shared qpair used by the channel, NULL if the channel has a qpair of its own */
+	struct nvme_bdev_shared_qpair		*shared_qpair;
+	/** Ring to the owner of shared_qpair, NULL if the channel runs on the owner thread */
+	struct nvme_bdev_shared_qpair_stage	*stage;
 };
 
 void nvme_ctrlr_populate_namespace_done(struct nvme_async_probe_ctx *ctx,
@@ -157,6 +182,7 @@ void nvme_bdev_dump_trid_json(struct spdk_nvme_transport_id *trid,
 			      struct spdk_json_write_ctx *w);
 
 int nvme_bdev_ctrlr_destruct(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr);
+void nvme_bdev_unregister_cb(void *io_device);
 void nvme_bdev_attach_bdev_to_ns(struct nvme_bdev_ns *nvme_ns, struct nvme_bdev *nvme_disk);
 void nvme_bdev_detach_bdev_from_ns(struct nvme_bdev *nvme_disk);
 
@@ -56,6 +56,10 @@ static int bdev_rbd_count = 0;
 
 #define BDEV_RBD_POLL_US 50
 
+/* Size of the per-channel completion ring in poll mode. Also caps the
+ * number of librbd requests outstanding on a channel. */
+#define SPDK_RBD_COMP_RING_SIZE 4096
+
 struct bdev_rbd {
 	struct spdk_bdev disk;
 	char *rbd_name;
@@ -66,6 +70,13 @@ struct bdev_rbd {
 	TAILQ_ENTRY(bdev_rbd) tailq;
 	struct spdk_poller *reset_timer;
 	struct spdk_bdev_io *reset_bdev_io;
+
+	/* In poll mode, a single image handle is shared by all channels and
+	 * completions are handed to the channels without an eventfd. */
+	bool poll_mode;
+	rados_t cluster;
+	rados_ioctx_t io_ctx;
+	rbd_image_t image;
 };
 
 struct bdev_rbd_io_channel {
@@ -75,9 +86,14 @@ struct bdev_rbd_io_channel {
 	rbd_image_t image;
 	struct bdev_rbd *disk;
 	struct spdk_poller *poller;
+
+	/* Poll mode only: completions enqueued by the librbd callback */
+	struct spdk_ring *comp_ring;
+	uint32_t io_inflight;
 };
 
 struct bdev_rbd_io {
+	struct bdev_rbd_io_channel *ch;
 	uint64_t remaining_len;
 	int num_segments;
 	bool failed;
@@ -90,6 +106,19 @@ bdev_rbd_free(struct bdev_rbd *rbd)
 		return;
 	}
 
+	if (rbd->image) {
+		rbd_flush(rbd->image);
+		rbd_close(rbd->image);
+	}
+
+	if (rbd->io_ctx) {
+		rados_ioctx_destroy(rbd->io_ctx);
+	}
+
+	if (rbd->cluster) {
+		rados_shutdown(rbd->cluster);
+	}
+
 	free(rbd->disk.name);
 	free(rbd->rbd_name);
 	free(rbd->user_id);
@@ -230,12 +259,32 @@ bdev_rbd_exit(rbd_image_t image)
 static void
 bdev_rbd_finish_aiocb(rbd_completion_t cb, void *arg)
 {
-	/* Doing nothing here */
+	struct spdk_bdev_io *bdev_io = arg;
+	struct bdev_rbd_io *rbd_io = (struct bdev_rbd_io *)bdev_io->driver_ctx;
+	size_t count;
+
+	/* Without poll mode, completions are picked up through the eventfd. */
+	if (rbd_io->ch->comp_ring == NULL) {
+		return;
+	}
+
+	/* Called from a librbd thread. Hand the completion over to the channel's
+	 * poller, which reaps all of them in batches. The ring can't overflow as
+	 * submissions are capped at its size. */
+	count = spdk_ring_enqueue(rbd_io->ch->comp_ring, (void **)&cb, 1, NULL);
+	assert(count == 1);
+	(void)count;
+}
+
+static bool
+bdev_rbd_has_room(struct bdev_rbd_io_channel *ch, int count)
+{
+	return ch->comp_ring == NULL || ch->io_inflight + count < SPDK_RBD_COMP_RING_SIZE;
 }
 
 static int
-bdev_rbd_start_aio(rbd_image_t image, struct spdk_bdev_io *bdev_io,
-		   void *buf, uint64_t offset, size_t len)
+bdev_rbd_start_aio(struct bdev_rbd_io_channel *ch, struct spdk_bdev_io *bdev_io,
+		   struct iovec *iov, int iovcnt, uint64_t offset, size_t len)
 {
 	int ret;
 	rbd_completion_t comp;
@@ -247,13 +296,23 @@ bdev_rbd_start_aio(rbd_image_t image, struct spdk_bdev_io *bdev_io,
 	}
 
 	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
-		ret = rbd_aio_read(image, offset, len,
-				   buf, comp);
+#ifdef LIBRBD_SUPPORTS_IOVEC
+		ret = rbd_aio_readv(ch->image, iov, iovcnt, offset, comp);
+#else
+		assert(iovcnt == 1);
+		ret = rbd_aio_read(ch->image, offset, len,
+				   iov->iov_base, comp);
+#endif
 	} else if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
-		ret = rbd_aio_write(image, offset, len,
-				    buf, comp);
+#ifdef LIBRBD_SUPPORTS_IOVEC
+		ret = rbd_aio_writev(ch->image, iov, iovcnt, offset, comp);
+#else
+		assert(iovcnt == 1);
+		ret = rbd_aio_write(ch->image, offset, len,
+				    iov->iov_base, comp);
+#endif
 	} else if (bdev_io->type == SPDK_BDEV_IO_TYPE_FLUSH) {
-		ret = rbd_aio_flush(image, comp);
+		ret = rbd_aio_flush(ch->image, comp);
 	}
 
 	if (ret < 0) {
@@ -261,6 +320,8 @@ bdev_rbd_start_aio(rbd_image_t image, struct spdk_bdev_io *bdev_io,
 		return -1;
 	}
 
+	ch->io_inflight++;
+
 	return 0;
 }
 
@@ -288,16 +349,49 @@ bdev_rbd_rw(struct bdev_rbd *disk, struct spdk_io_channel *ch,
 	struct bdev_rbd_io *rbd_io = (struct bdev_rbd_io *)bdev_io->driver_ctx;
 	struct bdev_rbd_io_channel *rbdio_ch = spdk_io_channel_get_ctx(ch);
 	size_t remaining = len;
+	struct iovec seg;
 	int i, rc;
+#ifdef LIBRBD_SUPPORTS_IOVEC
+	size_t iov_len = 0;
+#endif
 
+	rbd_io->ch = rbdio_ch;
 	rbd_io->remaining_len = 0;
 	rbd_io->num_segments = 0;
 	rbd_io->failed = false;
 
+#ifdef LIBRBD_SUPPORTS_IOVEC
+	for (i = 0; i < iovcnt; i++) {
+		iov_len += iov[i].iov_len;
+	}
+
+	if (iov_len == len) {
+		/* Let librbd scatter the data straight into the iovec with a single
+		 * request instead of splitting the I/O into one request per segment. */
+		if (!bdev_rbd_has_room(rbdio_ch, 1)) {
+			return -ENOMEM;
+		}
+
+		rc = bdev_rbd_start_aio(rbdio_ch, bdev_io, iov, iovcnt, offset, len);
+		if (rc) {
+			return rc;
+		}
+
+		rbd_io->num_segments = 1;
+		rbd_io->remaining_len = len;
+		return 0;
+	}
+#endif
+
+	if (!bdev_rbd_has_room(rbdio_ch, iovcnt)) {
+		return -ENOMEM;
+	}
+
 	for (i = 0; i < iovcnt && remaining > 0; i++) {
-		size_t seg_len = spdk_min(remaining, iov[i].iov_len);
+		seg.iov_base = iov[i].iov_base;
+		seg.iov_len = spdk_min(remaining, iov[i].iov_len);
 
-		rc = bdev_rbd_start_aio(rbdio_ch->image, bdev_io, iov[i].iov_base, offset, seg_len);
+		rc = bdev_rbd_start_aio(rbdio_ch, bdev_io, &seg, 1, offset, seg.iov_len);
 		if (rc) {
 			/*
 			 * This bdev_rbd_start_aio() call failed, but if any previous ones were
@@ -314,10 +408,10 @@ bdev_rbd_rw(struct bdev_rbd *disk, struct spdk_io_channel *ch,
 		}
 
 		rbd_io->num_segments++;
-		rbd_io->remaining_len += seg_len;
+		rbd_io->remaining_len += seg.iov_len;
 
-		offset += seg_len;
-		remaining -= seg_len;
+		offset += seg.iov_len;
+		remaining -= seg.iov_len;
 	}
 
 	return 0;
@@ -330,8 +424,13 @@ bdev_rbd_flush(struct bdev_rbd *disk, struct spdk_io_channel *ch,
 	struct bdev_rbd_io_channel *rbdio_ch = spdk_io_channel_get_ctx(ch);
 	struct bdev_rbd_io *rbd_io = (struct bdev_rbd_io *)bdev_io->driver_ctx;
 
+	if (!bdev_rbd_has_room(rbdio_ch, 1)) {
+		return -ENOMEM;
+	}
+
+	rbd_io->ch = rbdio_ch;
 	rbd_io->num_segments++;
-	return bdev_rbd_start_aio(rbdio_ch->image, bdev_io, NULL, offset, nbytes);
+	return bdev_rbd_start_aio(rbdio_ch, bdev_io, NULL, 0, offset, nbytes);
 }
 
 static int
@@ -394,7 +493,9 @@ bdev_rbd_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
 			  bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen,
 			  bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen);
 
-	if (ret != 0) {
+	if (ret == -ENOMEM) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
+	} else if (ret != 0) {
 		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
 	}
 }
@@ -435,7 +536,12 @@ static int _bdev_rbd_submit_request(struct spdk_io_channel *ch, struct spdk_bdev
 
 static void bdev_rbd_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
 {
-	if (_bdev_rbd_submit_request(ch, bdev_io) < 0) {
+	int rc;
+
+	rc = _bdev_rbd_submit_request(ch, bdev_io);
+	if (rc == -ENOMEM) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
+	} else if (rc < 0) {
 		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
 	}
 }
@@ -464,14 +570,19 @@ bdev_rbd_io_poll(void *arg)
 	struct spdk_bdev_io *bdev_io;
 	struct bdev_rbd_io *rbd_io;
 
-	rc = poll(&ch->pfd, 1, 0);
+	if (ch->comp_ring != NULL) {
+		rc = spdk_ring_dequeue(ch->comp_ring, (void **)comps, SPDK_RBD_QUEUE_DEPTH);
+	} else {
+		rc = poll(&ch->pfd, 1, 0);
+
+		/* check the return value of poll since we have only one fd for each channel */
+		if (rc != 1) {
+			return SPDK_POLLER_BUSY;
+		}
 
-	/* check the return value of poll since we have only one fd for each channel */
-	if (rc != 1) {
-		return SPDK_POLLER_BUSY;
+		rc = rbd_poll_io_events(ch->image, comps, SPDK_RBD_QUEUE_DEPTH);
 	}
 
-	rc = rbd_poll_io_events(ch->image, comps, SPDK_RBD_QUEUE_DEPTH);
 	for (i = 0; i < rc; i++) {
 		bdev_io = rbd_aio_get_arg(comps[i]);
 		rbd_io = (struct bdev_rbd_io *)bdev_io->driver_ctx;
@@ -497,6 +608,7 @@ bdev_rbd_io_poll(void *arg)
 		}
 
 		rbd_aio_release(comps[i]);
+		ch->io_inflight--;
 
 		if (rbd_io->num_segments == 0) {
 			spdk_bdev_io_complete(bdev_io,
@@ -514,7 +626,12 @@ bdev_rbd_free_channel(struct bdev_rbd_io_channel *ch)
 		return;
 	}
 
-	if (ch->image) {
+	if (ch->comp_ring) {
+		spdk_ring_free(ch->comp_ring);
+	}
+
+	/* The shared image is closed along with the bdev. */
+	if (ch->image && !ch->disk->poll_mode) {
 		bdev_rbd_exit(ch->image);
 	}
 
@@ -556,6 +673,19 @@ bdev_rbd_create_cb(void *io_device, void *ctx_buf)
 	ch->io_ctx = NULL;
 	ch->pfd.fd = -1;
 
+	if (ch->disk->poll_mode) {
+		ch->image = ch->disk->image;
+		ch->comp_ring = spdk_ring_create(SPDK_RING_TYPE_MP_SC, SPDK_RBD_COMP_RING_SIZE,
+						 SPDK_ENV_SOCKET_ID_ANY);
+		if (ch->comp_ring == NULL) {
+			SPDK_ERRLOG("Failed to allocate rbd completion ring\n");
+			goto err;
+		}
+
+		ch->poller = SPDK_POLLER_REGISTER(bdev_rbd_io_poll, ch, 0);
+		return 0;
+	}
+
 	ret = bdev_rados_context_init(ch->disk->user_id, ch->disk->pool_name,
 				      (const char *const *)ch->disk->config,
 				      &ch->cluster, &ch->io_ctx);
@@ -624,6 +754,8 @@ bdev_rbd_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 		spdk_json_write_named_string(w, "user_id", rbd_bdev->user_id);
 	}
 
+	spdk_json_write_named_bool(w, "poll_mode", rbd_bdev->poll_mode);
+
 	if (rbd_bdev->config) {
 		char **entry = rbd_bdev->config;
 
@@ -657,6 +789,9 @@ bdev_rbd_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w
 	if (rbd->user_id) {
 		spdk_json_write_named_string(w, "user_id", rbd->user_id);
 	}
+	if (rbd->poll_mode) {
+		spdk_json_write_named_bool(w, "poll_mode", true);
+	}
 
 	if (rbd->config) {
 		char **entry = rbd->config;
@@ -683,12 +818,41 @@ static const struct spdk_bdev_fn_table rbd_fn_table = {
 	.write_config_json	= bdev_rbd_write_config_json,
 };
 
+static void *
+bdev_rbd_open_shared(void *arg)
+{
+	struct bdev_rbd *rbd = arg;
+
+	if (bdev_rados_context_init(rbd->user_id, rbd->pool_name, (const char *const *)rbd->config,
+				    &rbd->cluster, &rbd->io_ctx) < 0) {
+		SPDK_ERRLOG("Failed to create rados context for user_id=%s and rbd_pool=%s\n",
+			    rbd->user_id ? rbd->user_id : "admin (the default)", rbd->pool_name);
+		rbd->cluster = NULL;
+		rbd->io_ctx = NULL;
+		return NULL;
+	}
+
+	if (rbd_open(rbd->io_ctx, rbd->rbd_name, &rbd->image, NULL) < 0) {
+		SPDK_ERRLOG("Failed to open specified rbd device\n");
+		rbd->image = NULL;
+		return NULL;
+	}
+
+	if (rbd_stat(rbd->image, &rbd->info, sizeof(rbd->info)) < 0) {
+		SPDK_ERRLOG("Failed to stat specified rbd device\n");
+		return NULL;
+	}
+
+	return rbd;
+}
+
 int
 bdev_rbd_create(struct spdk_bdev **bdev, const char *name, const char *user_id,
 		const char *pool_name,
 		const char *const *config,
 		const char *rbd_name,
-		uint32_t block_size)
+		uint32_t block_size,
+		bool poll_mode)
 {
 	struct bdev_rbd *rbd;
 	int ret;
@@ -728,13 +892,24 @@ bdev_rbd_create(struct spdk_bdev **bdev, const char *name, const char *user_id,
 		return -ENOMEM;
 	}
 
-	ret = bdev_rbd_init(rbd->user_id, rbd->pool_name,
-			    (const char *const *)rbd->config,
-			    rbd_name, &rbd->info);
-	if (ret < 0) {
-		bdev_rbd_free(rbd);
-		SPDK_ERRLOG("Failed to init rbd device\n");
-		return ret;
+	rbd->poll_mode = poll_mode;
+	if (poll_mode) {
+		/* Open the image outside of the reactor's CPU mask, as librbd
+		 * threads inherit the affinity of the thread that starts them. */
+		if (spdk_call_unaffinitized(bdev_rbd_open_shared, rbd) == NULL) {
+			bdev_rbd_free(rbd);
+			SPDK_ERRLOG("Failed to init rbd device\n");
+			return -1;
+		}
+	} else {
+		ret = bdev_rbd_init(rbd->user_id, rbd->pool_name,
+				    (const char *const *)rbd->config,
+				    rbd_name, &rbd->info);
+		if (ret < 0) {
+			bdev_rbd_free(rbd);
+			SPDK_ERRLOG("Failed to init rbd device\n");
+			return ret;
+		}
 	}
 
 	if (name) {
@@ -788,6 +963,7 @@ bdev_rbd_delete(struct spdk_bdev *bdev, spdk_delete_rbd_complete cb_fn, void *cb
 int
 bdev_rbd_resize(struct spdk_bdev *bdev, const uint64_t new_size_in_mb)
 {
+	struct bdev_rbd *rbd;
 	struct spdk_io_channel *ch;
 	struct bdev_rbd_io_channel *rbd_io_ch;
 	int rc;
@@ -797,6 +973,7 @@ bdev_rbd_resize(struct spdk_bdev *bdev, const uint64_t new_size_in_mb)
 	if (bdev->module != &rbd_if) {
 		return -EINVAL;
 	}
+	rbd = bdev->ctxt;
 
 	current_size_in_mb = bdev->blocklen * bdev->blockcnt / (1024 * 1024);
 	if (current_size_in_mb > new_size_in_mb) {
@@ -804,11 +981,15 @@ bdev_rbd_resize(struct spdk_bdev *bdev, const uint64_t new_size_in_mb)
 		return -EINVAL;
 	}
 
-	ch = bdev_rbd_get_io_channel(bdev);
-	rbd_io_ch = spdk_io_channel_get_ctx(ch);
 	new_size_in_byte = new_size_in_mb * 1024 * 1024;
 
-	rc = rbd_resize(rbd_io_ch->image, new_size_in_byte);
+	if (rbd->poll_mode) {
+		rc = rbd_resize(rbd->image, new_size_in_byte);
+	} else {
+		ch = bdev_rbd_get_io_channel(bdev);
+		rbd_io_ch = spdk_io_channel_get_ctx(ch);
+		rc = rbd_resize(rbd_io_ch->image, new_size_in_byte);
+	}
 	if (rc != 0) {
 		SPDK_ERRLOG("failed to resize the ceph bdev.\n");
 		return rc;
@@ -885,7 +1066,8 @@ bdev_rbd_library_init(void)
 		}
 
 		/* TODO(?): user_id and rbd config values */
-		rc = bdev_rbd_create(&bdev, NULL, NULL, pool_name, NULL, rbd_name, block_size);
+		rc = bdev_rbd_create(&bdev, NULL, NULL, pool_name, NULL, rbd_name, block_size,
+				     false);
 		if (rc) {
 			goto end;
 		}
@@ -37,6 +37,7 @@
 
 #include "spdk/barrier.h"
 #include "spdk/bdev.h"
+#include "spdk/bit_array.h"
 #include "spdk/conf.h"
 #include "spdk/env.h"
 #include "spdk/fd.h"
@@ -46,11 +47,21 @@
 #include "spdk/util.h"
 #include "spdk/string.h"
 
+#include "spdk_internal/assert.h"
 #include "spdk_internal/log.h"
 #include "spdk_internal/uring.h"
 
+#define SPDK_URING_QUEUE_DEPTH 512
+#define MAX_EVENTS_PER_POLL 32
+#define SPDK_URING_MAX_FILES 256
+#define SPDK_URING_MAX_FIXED_BUFS 1024
+/* The kernel refuses to register a single fixed buffer larger than 1 GiB. */
+#define SPDK_URING_MAX_FIXED_BUF_SIZE (1ULL << 30)
+
 struct bdev_uring_io_channel {
 	struct bdev_uring_group_channel		*group_ch;
+	/* The bdev file is registered with group_ch's ring at uring->file_index */
+	bool					fixed_file;
 };
 
 struct bdev_uring_group_channel {
@@ -58,6 +69,18 @@ struct bdev_uring_group_channel {
 	uint64_t				io_pending;
 	struct spdk_poller			*poller;
 	struct io_uring				uring;
+	bool					sq_poll;
+	bool					files_registered;
+
+	/* Snapshot of the fixed buffers registered with this ring. buf_index maps
+	 * a slot in g_uring_bufs to an index in bufs, or -1 if not registered. */
+	bool					fixed_buffers;
+	uint64_t				bufs_gen;
+	uint32_t				num_bufs;
+	struct iovec				*bufs;
+	int32_t					*buf_index;
+
+	TAILQ_ENTRY(bdev_uring_group_channel)	link;
 };
 
 struct bdev_uring_task {
@@ -70,18 +93,48 @@ struct bdev_uring {
 	struct spdk_bdev	bdev;
 	char			*filename;
 	int			fd;
+	/* Slot in the registered file table of each ring, or -1 if none */
+	int			file_index;
 	TAILQ_ENTRY(bdev_uring)  link;
 };
 
+/*
+ * Hugepage regions known to the env layer, kept up to date through memory map
+ * notifications. Each group channel registers a snapshot of this table with its
+ * ring whenever the generation changes and the ring is idle.
+ */
+struct bdev_uring_fixed_bufs {
+	pthread_mutex_t		mutex;
+	struct spdk_mem_map	*map;
+	uint64_t		gen;
+	struct iovec		regions[SPDK_URING_MAX_FIXED_BUFS];
+};
+
+static struct bdev_uring_opts g_opts = {
+	.queue_depth = SPDK_URING_QUEUE_DEPTH,
+	.register_files = false,
+	.fixed_buffers = false,
+	.sq_poll = false,
+	.sq_thread_idle_ms = 1000,
+	.sq_thread_cpu = -1,
+};
+
+static struct bdev_uring_fixed_bufs g_uring_bufs = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static struct spdk_bit_array *g_uring_file_slots;
+static pthread_mutex_t g_uring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static TAILQ_HEAD(, bdev_uring_group_channel) g_uring_group_channels =
+	TAILQ_HEAD_INITIALIZER(g_uring_group_channels);
+
 static int bdev_uring_init(void);
 static void bdev_uring_fini(void);
 static void uring_free_bdev(struct bdev_uring *uring);
 static void bdev_uring_get_spdk_running_config(FILE *fp);
+static int bdev_uring_config_json(struct spdk_json_write_ctx *w);
 static TAILQ_HEAD(, bdev_uring) g_uring_bdev_head;
 
-#define SPDK_URING_QUEUE_DEPTH 512
-#define MAX_EVENTS_PER_POLL 32
-
 static int
 bdev_uring_get_ctx_size(void)
 {
@@ -93,6 +146,7 @@ static struct spdk_bdev_module uring_if = {
 	.module_init	= bdev_uring_init,
 	.module_fini	= bdev_uring_fini,
 	.config_text	= bdev_uring_get_spdk_running_config,
+	.config_json	= bdev_uring_config_json,
 	.get_ctx_size	= bdev_uring_get_ctx_size,
 };
 
@@ -141,48 +195,120 @@ bdev_uring_close(struct bdev_uring *bdev)
 	return 0;
 }
 
-static int64_t
-bdev_uring_readv(struct bdev_uring *uring, struct spdk_io_channel *ch,
-		 struct bdev_uring_task *uring_task,
-		 struct iovec *iov, int iovcnt, uint64_t nbytes, uint64_t offset)
+static struct io_uring_sqe *
+bdev_uring_get_sqe(struct bdev_uring_group_channel *group_ch)
 {
-	struct bdev_uring_io_channel *uring_ch = spdk_io_channel_get_ctx(ch);
-	struct bdev_uring_group_channel *group_ch = uring_ch->group_ch;
 	struct io_uring_sqe *sqe;
 
+	/* Don't let the number of outstanding requests overrun the completion queue. */
+	if (spdk_unlikely(group_ch->io_inflight + group_ch->io_pending >=
+			  *group_ch->uring.cq.kring_entries)) {
+		return NULL;
+	}
+
 	sqe = io_uring_get_sqe(&group_ch->uring);
-	io_uring_prep_readv(sqe, uring->fd, iov, iovcnt, offset);
-	io_uring_sqe_set_data(sqe, uring_task);
-	uring_task->len = nbytes;
-	uring_task->ch = uring_ch;
+	if (spdk_unlikely(sqe == NULL)) {
+		/* The submission queue is full. Flush the batch collected so far
+		 * early instead of waiting for the next group poll. */
+		if (io_uring_submit(&group_ch->uring) < 0) {
+			return NULL;
+		}
+		group_ch->io_inflight += group_ch->io_pending;
+		group_ch->io_pending = 0;
+		sqe = io_uring_get_sqe(&group_ch->uring);
+	}
 
-	SPDK_DEBUGLOG(SPDK_LOG_URING, "read %d iovs size %lu to off: %#lx\n",
-		      iovcnt, nbytes, offset);
+	return sqe;
+}
 
-	group_ch->io_pending++;
-	return nbytes;
+/*
+ * Look up the index of the fixed buffer backing [buf, buf + len) in the ring
+ * of group_ch. Returns -1 if the buffer isn't covered by a single registered
+ * buffer.
+ */
+static int
+bdev_uring_fixed_buf_index(struct bdev_uring_group_channel *group_ch, void *buf, uint64_t len)
+{
+	uint64_t slot, size = len;
+	struct iovec *iov;
+	int32_t idx;
+
+	if (group_ch->num_bufs == 0) {
+		return -1;
+	}
+
+	slot = spdk_mem_map_translate(g_uring_bufs.map, (uint64_t)buf, &size);
+	if (slot == 0 || slot > SPDK_URING_MAX_FIXED_BUFS) {
+		return -1;
+	}
+
+	idx = group_ch->buf_index[slot - 1];
+	if (idx < 0) {
+		return -1;
+	}
+
+	/* The slot may have been reused since this ring's snapshot was taken,
+	 * so verify against the region that was actually registered. */
+	iov = &group_ch->bufs[idx];
+	if ((uintptr_t)buf < (uintptr_t)iov->iov_base ||
+	    (uintptr_t)buf + len > (uintptr_t)iov->iov_base + iov->iov_len) {
+		return -1;
+	}
+
+	return idx;
 }
 
-static int64_t
-bdev_uring_writev(struct bdev_uring *uring, struct spdk_io_channel *ch,
-		  struct bdev_uring_task *uring_task,
-		  struct iovec *iov, int iovcnt, size_t nbytes, uint64_t offset)
+static int
+bdev_uring_rw(struct bdev_uring *uring, struct spdk_io_channel *ch,
+	      struct bdev_uring_task *uring_task, bool write,
+	      struct iovec *iov, int iovcnt, uint64_t nbytes, uint64_t offset)
 {
 	struct bdev_uring_io_channel *uring_ch = spdk_io_channel_get_ctx(ch);
 	struct bdev_uring_group_channel *group_ch = uring_ch->group_ch;
 	struct io_uring_sqe *sqe;
+	int fd, buf_index = -1;
+
+	sqe = bdev_uring_get_sqe(group_ch);
+	if (spdk_unlikely(sqe == NULL)) {
+		return -ENOMEM;
+	}
+
+	fd = uring_ch->fixed_file ? uring->file_index : uring->fd;
+
+	if (iovcnt == 1 && group_ch->fixed_buffers) {
+		buf_index = bdev_uring_fixed_buf_index(group_ch, iov[0].iov_base, nbytes);
+	}
+
+	if (buf_index >= 0) {
+		if (write) {
+			io_uring_prep_write_fixed(sqe, fd, iov[0].iov_base, nbytes, offset,
+						  buf_index);
+		} else {
+			io_uring_prep_read_fixed(sqe, fd, iov[0].iov_base, nbytes, offset,
+						 buf_index);
+		}
+	} else {
+		if (write) {
+			io_uring_prep_writev(sqe, fd, iov, iovcnt, offset);
+		} else {
+			io_uring_prep_readv(sqe, fd, iov, iovcnt, offset);
+		}
+	}
+
+	if (uring_ch->fixed_file) {
+		io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+	}
 
-	sqe = io_uring_get_sqe(&group_ch->uring);
-	io_uring_prep_writev(sqe, uring->fd, iov, iovcnt, offset);
 	io_uring_sqe_set_data(sqe, uring_task);
 	uring_task->len = nbytes;
 	uring_task->ch = uring_ch;
 
-	SPDK_DEBUGLOG(SPDK_LOG_URING, "write %d iovs size %lu from off: %#lx\n",
-		      iovcnt, nbytes, offset);
+	SPDK_DEBUGLOG(SPDK_LOG_URING, "%s %d iovs size %lu %s off: %#lx%s\n",
+		      write ? "write" : "read", iovcnt, nbytes, write ? "from" : "to", offset,
+		      buf_index >= 0 ? " (fixed buffer)" : "");
 
 	group_ch->io_pending++;
-	return nbytes;
+	return 0;
 }
 
 static int
@@ -192,6 +318,10 @@ bdev_uring_destruct(void *ctx)
 	int rc = 0;
 
 	TAILQ_REMOVE(&g_uring_bdev_head, uring, link);
+	if (uring->file_index >= 0) {
+		spdk_bit_array_clear(g_uring_file_slots, uring->file_index);
+		uring->file_index = -1;
+	}
 	rc = bdev_uring_close(uring);
 	if (rc < 0) {
 		SPDK_ERRLOG("bdev_uring_close() failed\n");
@@ -204,38 +334,72 @@ bdev_uring_destruct(void *ctx)
 static int
 bdev_uring_reap(struct io_uring *ring, int max)
 {
-	int i, count, ret;
-	struct io_uring_cqe *cqe;
+	int i, count;
+	struct io_uring_cqe *cqes[MAX_EVENTS_PER_POLL];
 	struct bdev_uring_task *uring_task;
 	enum spdk_bdev_io_status status;
 
-	count = 0;
-	for (i = 0; i < max; i++) {
-		ret = io_uring_peek_cqe(ring, &cqe);
-		if (ret != 0) {
-			return ret;
-		}
-
-		if (cqe == NULL) {
-			return count;
-		}
-
-		uring_task = (struct bdev_uring_task *)cqe->user_data;
-		if (cqe->res != (signed)uring_task->len) {
+	count = io_uring_peek_batch_cqe(ring, cqes, spdk_min(max, MAX_EVENTS_PER_POLL));
+	for (i = 0; i < count; i++) {
+		uring_task = (struct bdev_uring_task *)cqes[i]->user_data;
+		if (cqes[i]->res != (signed)uring_task->len) {
 			status = SPDK_BDEV_IO_STATUS_FAILED;
 		} else {
 			status = SPDK_BDEV_IO_STATUS_SUCCESS;
 		}
 
 		uring_task->ch->group_ch->io_inflight--;
-		io_uring_cqe_seen(ring, cqe);
 		spdk_bdev_io_complete(spdk_bdev_io_from_ctx(uring_task), status);
-		count++;
 	}
 
+	/* Release the whole batch of CQEs with a single head update. */
+	io_uring_cq_advance(ring, count);
+
 	return count;
 }
 
+static void
+bdev_uring_group_update_bufs(struct bdev_uring_group_channel *group_ch)
+{
+	uint32_t i, num_bufs = 0;
+	uint64_t gen;
+	int rc;
+
+	if (group_ch->num_bufs > 0) {
+		io_uring_unregister_buffers(&group_ch->uring);
+		group_ch->num_bufs = 0;
+	}
+
+	pthread_mutex_lock(&g_uring_bufs.mutex);
+	gen = g_uring_bufs.gen;
+	for (i = 0; i < SPDK_URING_MAX_FIXED_BUFS; i++) {
+		if (g_uring_bufs.regions[i].iov_base == NULL) {
+			group_ch->buf_index[i] = -1;
+			continue;
+		}
+		group_ch->buf_index[i] = num_bufs;
+		group_ch->bufs[num_bufs++] = g_uring_bufs.regions[i];
+	}
+	pthread_mutex_unlock(&g_uring_bufs.mutex);
+
+	group_ch->bufs_gen = gen;
+	if (num_bufs == 0) {
+		return;
+	}
+
+	rc = io_uring_register_buffers(&group_ch->uring, group_ch->bufs, num_bufs);
+	if (rc < 0) {
+		/* Most likely RLIMIT_MEMLOCK is too low. Keep going with regular
+		 * vectored I/O on this ring. */
+		SPDK_WARNLOG("Unable to register fixed buffers, rc %d: %s\n",
+			     rc, spdk_strerror(-rc));
+		group_ch->fixed_buffers = false;
+		return;
+	}
+
+	group_ch->num_bufs = num_bufs;
+}
+
 static int
 bdev_uring_group_poll(void *arg)
 {
@@ -246,16 +410,25 @@ bdev_uring_group_poll(void *arg)
 	to_submit = group_ch->io_pending;
 	to_complete = group_ch->io_inflight;
 
+	/* Registering buffers quiesces the ring, so only pick up changes to the
+	 * hugepage regions while there is no I/O outstanding. */
+	if (spdk_unlikely(group_ch->fixed_buffers && to_submit == 0 && to_complete == 0) &&
+	    group_ch->bufs_gen != __atomic_load_n(&g_uring_bufs.gen, __ATOMIC_RELAXED)) {
+		bdev_uring_group_update_bufs(group_ch);
+	}
+
 	ret = 0;
 	if (to_submit > 0) {
 		/* If there are I/O to submit, use io_uring_submit here.
-		 * It will automatically call spdk_io_uring_enter appropriately. */
+		 * It will automatically call spdk_io_uring_enter appropriately.
+		 * All I/O queued since the last poll is submitted as one batch. */
 		ret = io_uring_submit(&group_ch->uring);
 		group_ch->io_pending = 0;
 		group_ch->io_inflight += to_submit;
-	} else if (to_complete > 0) {
+	} else if (to_complete > 0 && !group_ch->sq_poll) {
 		/* If there are I/O in flight but none to submit, we need to
-		 * call io_uring_enter ourselves. */
+		 * call io_uring_enter ourselves. With SQPOLL the kernel thread
+		 * reaps the completions for us. */
 		ret = spdk_io_uring_enter(group_ch->uring.ring_fd, 0, 0,
 					  IORING_ENTER_GETEVENTS);
 	}
@@ -279,6 +452,8 @@ bdev_uring_group_poll(void *arg)
 static void bdev_uring_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
 				  bool success)
 {
+	int rc;
+
 	if (!success) {
 		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
 		return;
@@ -286,22 +461,20 @@ static void bdev_uring_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_i
 
 	switch (bdev_io->type) {
 	case SPDK_BDEV_IO_TYPE_READ:
-		bdev_uring_readv((struct bdev_uring *)bdev_io->bdev->ctxt,
-				 ch,
-				 (struct bdev_uring_task *)bdev_io->driver_ctx,
-				 bdev_io->u.bdev.iovs,
-				 bdev_io->u.bdev.iovcnt,
-				 bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen,
-				 bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen);
-		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
-		bdev_uring_writev((struct bdev_uring *)bdev_io->bdev->ctxt,
-				  ch,
-				  (struct bdev_uring_task *)bdev_io->driver_ctx,
-				  bdev_io->u.bdev.iovs,
-				  bdev_io->u.bdev.iovcnt,
-				  bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen,
-				  bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen);
+		rc = bdev_uring_rw((struct bdev_uring *)bdev_io->bdev->ctxt,
+				   ch,
+				   (struct bdev_uring_task *)bdev_io->driver_ctx,
+				   bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE,
+				   bdev_io->u.bdev.iovs,
+				   bdev_io->u.bdev.iovcnt,
+				   bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen,
+				   bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen);
+		if (rc == -ENOMEM) {
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
+		} else if (rc != 0) {
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		}
 		break;
 	default:
 		SPDK_ERRLOG("Wrong io type\n");
@@ -347,9 +520,27 @@ bdev_uring_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 static int
 bdev_uring_create_cb(void *io_device, void *ctx_buf)
 {
+	struct bdev_uring *uring = io_device;
 	struct bdev_uring_io_channel *ch = ctx_buf;
+	struct spdk_io_channel *group_io_ch;
+	int rc;
+
+	group_io_ch = spdk_get_io_channel(&uring_if);
+	if (group_io_ch == NULL) {
+		return -ENOMEM;
+	}
+	ch->group_ch = spdk_io_channel_get_ctx(group_io_ch);
 
-	ch->group_ch = spdk_io_channel_get_ctx(spdk_get_io_channel(&uring_if));
+	if (ch->group_ch->files_registered && uring->file_index >= 0) {
+		rc = io_uring_register_files_update(&ch->group_ch->uring, uring->file_index,
+						    &uring->fd, 1);
+		if (rc == 1) {
+			ch->fixed_file = true;
+		} else {
+			SPDK_WARNLOG("Unable to register %s with io_uring, rc %d\n",
+				     uring->filename, rc);
+		}
+	}
 
 	return 0;
 }
@@ -357,7 +548,14 @@ bdev_uring_create_cb(void *io_device, void *ctx_buf)
 static void
 bdev_uring_destroy_cb(void *io_device, void *ctx_buf)
 {
+	struct bdev_uring *uring = io_device;
 	struct bdev_uring_io_channel *ch = ctx_buf;
+	int fd = -1;
+
+	if (ch->fixed_file) {
+		/* Drop the ring's reference to the file so its slot can be reused. */
+		io_uring_register_files_update(&ch->group_ch->uring, uring->file_index, &fd, 1);
+	}
 
 	spdk_put_io_channel(spdk_io_channel_from_ctx(ch->group_ch));
 }
@@ -421,15 +619,195 @@ static void uring_free_bdev(struct bdev_uring *uring)
 	free(uring);
 }
 
+static int
+bdev_uring_mem_notify(void *cb_ctx, struct spdk_mem_map *map,
+		      enum spdk_mem_map_notify_action action,
+		      void *vaddr, size_t size)
+{
+	uint64_t len, slot, region_size;
+	struct iovec *region;
+	uint32_t i;
+	int rc = 0;
+
+	pthread_mutex_lock(&g_uring_bufs.mutex);
+
+	switch (action) {
+	case SPDK_MEM_MAP_NOTIFY_REGISTER:
+		i = 0;
+		while (size > 0) {
+			for (; i < SPDK_URING_MAX_FIXED_BUFS; i++) {
+				if (g_uring_bufs.regions[i].iov_base == NULL) {
+					break;
+				}
+			}
+			if (i == SPDK_URING_MAX_FIXED_BUFS) {
+				/* Out of slots. The remaining memory will simply be
+				 * accessed with regular vectored I/O. */
+				SPDK_NOTICELOG("Fixed buffer table full, not registering %p\n",
+					       vaddr);
+				break;
+			}
+
+			len = spdk_min(size, SPDK_URING_MAX_FIXED_BUF_SIZE);
+			rc = spdk_mem_map_set_translation(map, (uint64_t)vaddr, len, i + 1);
+			if (rc != 0) {
+				break;
+			}
+
+			g_uring_bufs.regions[i].iov_base = vaddr;
+			g_uring_bufs.regions[i].iov_len = len;
+			vaddr = (uint8_t *)vaddr + len;
+			size -= len;
+		}
+		break;
+	case SPDK_MEM_MAP_NOTIFY_UNREGISTER:
+		while (size > 0) {
+			region_size = size;
+			slot = spdk_mem_map_translate(map, (uint64_t)vaddr, &region_size);
+			if (slot != 0) {
+				/* Forget the whole region, even if only part of it is
+				 * going away. */
+				region = &g_uring_bufs.regions[slot - 1];
+				spdk_mem_map_clear_translation(map, (uint64_t)region->iov_base,
+							       region->iov_len);
+				region->iov_base = NULL;
+				region->iov_len = 0;
+			}
+			vaddr = (uint8_t *)vaddr + region_size;
+			size -= region_size;
+		}
+		break;
+	default:
+		SPDK_UNREACHABLE();
+	}
+
+	__atomic_fetch_add(&g_uring_bufs.gen, 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&g_uring_bufs.mutex);
+
+	/* Never fail the registration because of io_uring. */
+	return 0;
+}
+
+static int
+bdev_uring_mem_map_contiguous(uint64_t addr_1, uint64_t addr_2)
+{
+	/* Two contiguous mappings will point to the same fixed buffer slot. */
+	return addr_1 == addr_2;
+}
+
+static const struct spdk_mem_map_ops g_uring_mem_map_ops = {
+	.notify_cb = bdev_uring_mem_notify,
+	.are_contiguous = bdev_uring_mem_map_contiguous,
+};
+
+static int
+bdev_uring_group_init_ring(struct bdev_uring_group_channel *ch)
+{
+	struct io_uring_params params = {};
+	struct bdev_uring_group_channel *sq_owner = NULL;
+	int rc;
+
+	/* The existing ring setup is kept for the default configuration. */
+	params.flags = IORING_SETUP_IOPOLL;
+
+	if (g_opts.sq_poll) {
+		params.flags |= IORING_SETUP_SQPOLL;
+		params.sq_thread_idle = g_opts.sq_thread_idle_ms;
+		if (g_opts.sq_thread_cpu >= 0) {
+			params.flags |= IORING_SETUP_SQ_AFF;
+			params.sq_thread_cpu = g_opts.sq_thread_cpu;
+		}
+
+#ifdef IORING_SETUP_ATTACH_WQ
+		/* Share the kernel poller of an existing ring instead of
+		 * spawning one kernel thread per SPDK thread. */
+		TAILQ_FOREACH(sq_owner, &g_uring_group_channels, link) {
+			if (sq_owner->sq_poll) {
+				params.flags |= IORING_SETUP_ATTACH_WQ;
+				params.wq_fd = sq_owner->uring.ring_fd;
+				break;
+			}
+		}
+#endif
+
+		rc = io_uring_queue_init_params(g_opts.queue_depth, &ch->uring, &params);
+		if (rc == 0) {
+			ch->sq_poll = true;
+			return 0;
+		}
+
+		if (sq_owner != NULL) {
+			SPDK_NOTICELOG("Unable to attach to shared SQ poll thread, rc %d\n", rc);
+			params.flags &= ~IORING_SETUP_ATTACH_WQ;
+			params.wq_fd = 0;
+			rc = io_uring_queue_init_params(g_opts.queue_depth, &ch->uring, &params);
+			if (rc == 0) {
+				ch->sq_poll = true;
+				return 0;
+			}
+		}
+
+		SPDK_WARNLOG("Unable to set up SQ polling, rc %d: %s. "
+			     "Falling back to regular submission.\n", rc, spdk_strerror(-rc));
+		memset(&params, 0, sizeof(params));
+		params.flags = IORING_SETUP_IOPOLL;
+	}
+
+	return io_uring_queue_init_params(g_opts.queue_depth, &ch->uring, &params);
+}
+
 static int
 bdev_uring_group_create_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_uring_group_channel *ch = ctx_buf;
+	int fds[SPDK_URING_MAX_FILES];
+	int i, rc;
 
-	if (io_uring_queue_init(SPDK_URING_QUEUE_DEPTH, &ch->uring, IORING_SETUP_IOPOLL) < 0) {
+	pthread_mutex_lock(&g_uring_mutex);
+	rc = bdev_uring_group_init_ring(ch);
+	if (rc < 0) {
+		pthread_mutex_unlock(&g_uring_mutex);
 		SPDK_ERRLOG("uring I/O context setup failure\n");
 		return -1;
 	}
+	TAILQ_INSERT_TAIL(&g_uring_group_channels, ch, link);
+	pthread_mutex_unlock(&g_uring_mutex);
+
+	if (g_opts.register_files) {
+		/* Register a sparse table up front. Each bdev fills in its own slot
+		 * when its channel on this thread is created. */
+		for (i = 0; i < SPDK_URING_MAX_FILES; i++) {
+			fds[i] = -1;
+		}
+		rc = io_uring_register_files(&ch->uring, fds, SPDK_URING_MAX_FILES);
+		if (rc == 0) {
+			ch->files_registered = true;
+		} else {
+			SPDK_WARNLOG("Unable to register file table, rc %d: %s\n",
+				     rc, spdk_strerror(-rc));
+		}
+	}
+
+	if (g_opts.fixed_buffers) {
+		pthread_mutex_lock(&g_uring_mutex);
+		if (g_uring_bufs.map == NULL) {
+			g_uring_bufs.map = spdk_mem_map_alloc(0, &g_uring_mem_map_ops, NULL);
+		}
+		pthread_mutex_unlock(&g_uring_mutex);
+
+		ch->bufs = calloc(SPDK_URING_MAX_FIXED_BUFS, sizeof(*ch->bufs));
+		ch->buf_index = calloc(SPDK_URING_MAX_FIXED_BUFS, sizeof(*ch->buf_index));
+		if (g_uring_bufs.map == NULL || ch->bufs == NULL || ch->buf_index == NULL) {
+			SPDK_WARNLOG("Unable to set up fixed buffers\n");
+			free(ch->bufs);
+			free(ch->buf_index);
+			ch->bufs = NULL;
+			ch->buf_index = NULL;
+		} else {
+			ch->fixed_buffers = true;
+			bdev_uring_group_update_bufs(ch);
+		}
+	}
 
 	ch->poller = SPDK_POLLER_REGISTER(bdev_uring_group_poll, ch, 0);
 	return 0;
@@ -440,7 +818,13 @@ bdev_uring_group_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_uring_group_channel *ch = ctx_buf;
 
+	pthread_mutex_lock(&g_uring_mutex);
+	TAILQ_REMOVE(&g_uring_group_channels, ch, link);
 	io_uring_queue_exit(&ch->uring);
+	pthread_mutex_unlock(&g_uring_mutex);
+
+	free(ch->bufs);
+	free(ch->buf_index);
 
 	spdk_poller_unregister(&ch->poller);
 }
@@ -449,7 +833,7 @@ struct spdk_bdev *
 create_uring_bdev(const char *name, const char *filename, uint32_t block_size)
 {
 	struct bdev_uring *uring;
-	uint32_t detected_block_size;
+	uint32_t detected_block_size, file_index;
 	uint64_t bdev_size;
 	int rc;
 
@@ -459,6 +843,7 @@ create_uring_bdev(const char *name, const char *filename, uint32_t block_size)
 		return NULL;
 	}
 
+	uring->file_index = -1;
 	uring->filename = strdup(filename);
 	if (!uring->filename) {
 		goto error_return;
@@ -525,12 +910,25 @@ create_uring_bdev(const char *name, const char *filename, uint32_t block_size)
 
 	uring->bdev.fn_table = &uring_fn_table;
 
+	if (g_opts.register_files) {
+		file_index = spdk_bit_array_find_first_clear(g_uring_file_slots, 0);
+		if (file_index != UINT32_MAX) {
+			spdk_bit_array_set(g_uring_file_slots, file_index);
+			uring->file_index = file_index;
+		} else {
+			SPDK_NOTICELOG("No free registered file slot for %s\n", filename);
+		}
+	}
+
 	spdk_io_device_register(uring, bdev_uring_create_cb, bdev_uring_destroy_cb,
 				sizeof(struct bdev_uring_io_channel),
 				uring->bdev.name);
 	rc = spdk_bdev_register(&uring->bdev);
 	if (rc) {
 		spdk_io_device_unregister(uring, NULL);
+		if (uring->file_index >= 0) {
+			spdk_bit_array_clear(g_uring_file_slots, uring->file_index);
+		}
 		goto error_return;
 	}
 
@@ -586,6 +984,12 @@ bdev_uring_init(void)
 	struct spdk_bdev *bdev;
 
 	TAILQ_INIT(&g_uring_bdev_head);
+
+	g_uring_file_slots = spdk_bit_array_create(SPDK_URING_MAX_FILES);
+	if (g_uring_file_slots == NULL) {
+		return -ENOMEM;
+	}
+
 	spdk_io_device_register(&uring_if, bdev_uring_group_create_cb, bdev_uring_group_destroy_cb,
 				sizeof(struct bdev_uring_group_channel),
 				"uring_module");
@@ -643,6 +1047,56 @@ static void
 bdev_uring_fini(void)
 {
 	spdk_io_device_unregister(&uring_if, NULL);
+	spdk_mem_map_free(&g_uring_bufs.map);
+	spdk_bit_array_free(&g_uring_file_slots);
+}
+
+void
+bdev_uring_get_opts(struct bdev_uring_opts *opts)
+{
+	*opts = g_opts;
+}
+
+int
+bdev_uring_set_opts(const struct bdev_uring_opts *opts)
+{
+	if (!TAILQ_EMPTY(&g_uring_bdev_head)) {
+		return -EPERM;
+	}
+
+	if (opts->queue_depth == 0) {
+		return -EINVAL;
+	}
+
+	/* Kernels before 5.11 only accept registered files with SQPOLL. */
+	if (opts->sq_poll && !opts->register_files) {
+		return -EINVAL;
+	}
+
+	g_opts = *opts;
+
+	return 0;
+}
+
+static int
+bdev_uring_config_json(struct spdk_json_write_ctx *w)
+{
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_string(w, "method", "bdev_uring_set_options");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_uint32(w, "queue_depth", g_opts.queue_depth);
+	spdk_json_write_named_bool(w, "register_files", g_opts.register_files);
+	spdk_json_write_named_bool(w, "fixed_buffers", g_opts.fixed_buffers);
+	spdk_json_write_named_bool(w, "sq_poll", g_opts.sq_poll);
+	spdk_json_write_named_uint32(w, "sq_thread_idle_ms", g_opts.sq_thread_idle_ms);
+	spdk_json_write_named_int32(w, "sq_thread_cpu", g_opts.sq_thread_cpu);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+
+	return 0;
 }
 
 static void
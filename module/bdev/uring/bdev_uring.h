@@ -43,6 +43,29 @@
 
 typedef void (*spdk_delete_uring_complete)(void *cb_arg, int bdeverrno);
 
+struct bdev_uring_opts {
+	/* Number of submission queue entries of each per-thread ring */
+	uint32_t	queue_depth;
+
+	/* Register the bdev files with each ring (IORING_REGISTER_FILES) */
+	bool		register_files;
+
+	/* Register SPDK hugepage memory as fixed buffers (IORING_REGISTER_BUFFERS) */
+	bool		fixed_buffers;
+
+	/* Use a kernel thread to poll the submission queues (IORING_SETUP_SQPOLL) */
+	bool		sq_poll;
+
+	/* Idle time in milliseconds before the SQ poll thread goes to sleep */
+	uint32_t	sq_thread_idle_ms;
+
+	/* CPU to pin the SQ poll thread to, or -1 to leave it unpinned */
+	int32_t		sq_thread_cpu;
+};
+
+void bdev_uring_get_opts(struct bdev_uring_opts *opts);
+int bdev_uring_set_opts(const struct bdev_uring_opts *opts);
+
 struct spdk_bdev *create_uring_bdev(const char *name, const char *filename, uint32_t block_size);
 
 void delete_uring_bdev(struct spdk_bdev *bdev, spdk_delete_uring_complete cb_fn, void *cb_arg);
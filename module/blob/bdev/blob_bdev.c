@@ -33,10 +33,12 @@
 
 #include "spdk/stdinc.h"
 
+#include "spdk/accel_engine.h"
 #include "spdk/blob_bdev.h"
 #include "spdk/blob.h"
 #include "spdk/thread.h"
 #include "spdk/log.h"
+#include "spdk/util.h"
 #include "spdk/endian.h"
 #include "spdk/bdev_module.h"
 
@@ -234,6 +236,258 @@ bdev_blob_unmap(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, uint64
 	}
 }
 
+/*
+ * Copies are done by mapping both ranges with zcopy and moving the data between
+ * the buffers with the acceleration engine, so it never goes through a bounce buffer.
+ */
+struct blob_bdev_copy {
+	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+	struct spdk_bs_dev		*dev;
+	struct spdk_io_channel		*channel;
+	struct spdk_io_channel		*accel_channel;
+	uint64_t			dst_lba;
+	uint64_t			src_lba;
+	uint32_t			lba_count;
+	struct spdk_bdev_io		*src_io;
+	struct spdk_bdev_io		*dst_io;
+	int				bserrno;
+	struct spdk_bs_dev_cb_args	*cb_args;
+	/* Followed by spdk_accel_task_size() bytes for the accel task */
+};
+
+static inline struct spdk_accel_task *
+__accel_task_from_copy(struct blob_bdev_copy *copy)
+{
+	return (struct spdk_accel_task *)((uintptr_t)copy + sizeof(struct blob_bdev_copy));
+}
+
+static inline struct blob_bdev_copy *
+__copy_from_accel_task(void *task)
+{
+	return (struct blob_bdev_copy *)((uintptr_t)task - sizeof(struct blob_bdev_copy));
+}
+
+static void bdev_blob_copy_start_src(void *arg);
+static void bdev_blob_copy_start_dst(void *arg);
+
+static void
+bdev_blob_copy_done(struct blob_bdev_copy *copy)
+{
+	struct spdk_bs_dev_cb_args *cb_args = copy->cb_args;
+
+	if (copy->accel_channel != NULL) {
+		spdk_put_io_channel(copy->accel_channel);
+	}
+
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, copy->bserrno);
+	free(copy);
+}
+
+static void
+bdev_blob_copy_src_released(struct spdk_bdev_io *bdev_io, bool success, void *arg)
+{
+	struct blob_bdev_copy *copy = arg;
+
+	spdk_bdev_free_io(bdev_io);
+	bdev_blob_copy_done(copy);
+}
+
+static void
+bdev_blob_copy_release_src(struct blob_bdev_copy *copy)
+{
+	int rc;
+
+	rc = spdk_bdev_zcopy_end(copy->src_io, false, bdev_blob_copy_src_released, copy);
+	if (rc != 0) {
+		spdk_bdev_free_io(copy->src_io);
+		bdev_blob_copy_done(copy);
+	}
+}
+
+static void
+bdev_blob_copy_dst_released(struct spdk_bdev_io *bdev_io, bool success, void *arg)
+{
+	struct blob_bdev_copy *copy = arg;
+
+	if (!success && copy->bserrno == 0) {
+		copy->bserrno = -EIO;
+	}
+
+	spdk_bdev_free_io(bdev_io);
+	bdev_blob_copy_release_src(copy);
+}
+
+static void
+bdev_blob_copy_release(struct blob_bdev_copy *copy)
+{
+	int rc;
+
+	/* The destination is committed only if the data was copied into it */
+	rc = spdk_bdev_zcopy_end(copy->dst_io, copy->bserrno == 0,
+				 bdev_blob_copy_dst_released, copy);
+	if (rc != 0) {
+		copy->bserrno = rc;
+		spdk_bdev_free_io(copy->dst_io);
+		bdev_blob_copy_release_src(copy);
+	}
+}
+
+static void
+bdev_blob_copy_accel_done(void *ref, int status)
+{
+	struct blob_bdev_copy *copy = __copy_from_accel_task(ref);
+
+	copy->bserrno = status;
+	bdev_blob_copy_release(copy);
+}
+
+static void
+bdev_blob_copy_data(struct blob_bdev_copy *copy)
+{
+	struct iovec *src_iovs, *dst_iovs;
+	int src_iovcnt, dst_iovcnt;
+	size_t src_off = 0, dst_off = 0, len;
+	int rc, s = 0, d = 0;
+
+	spdk_bdev_io_get_iovec(copy->src_io, &src_iovs, &src_iovcnt);
+	spdk_bdev_io_get_iovec(copy->dst_io, &dst_iovs, &dst_iovcnt);
+
+	if (src_iovcnt == 1 && dst_iovcnt == 1) {
+		assert(src_iovs[0].iov_len == dst_iovs[0].iov_len);
+		copy->accel_channel = spdk_accel_engine_get_io_channel();
+		if (copy->accel_channel != NULL) {
+			rc = spdk_accel_submit_copy(__accel_task_from_copy(copy),
+						    copy->accel_channel,
+						    dst_iovs[0].iov_base, src_iovs[0].iov_base,
+						    src_iovs[0].iov_len, bdev_blob_copy_accel_done);
+			if (rc == 0) {
+				return;
+			}
+		}
+	}
+
+	/* The buffers are scattered or there's no acceleration engine, copy on the CPU */
+	while (s < src_iovcnt && d < dst_iovcnt) {
+		len = spdk_min(src_iovs[s].iov_len - src_off, dst_iovs[d].iov_len - dst_off);
+		memcpy((uint8_t *)dst_iovs[d].iov_base + dst_off,
+		       (uint8_t *)src_iovs[s].iov_base + src_off, len);
+		src_off += len;
+		dst_off += len;
+		if (src_off == src_iovs[s].iov_len) {
+			s++;
+			src_off = 0;
+		}
+		if (dst_off == dst_iovs[d].iov_len) {
+			d++;
+			dst_off = 0;
+		}
+	}
+
+	bdev_blob_copy_release(copy);
+}
+
+static void
+bdev_blob_copy_dst_started(struct spdk_bdev_io *bdev_io, bool success, void *arg)
+{
+	struct blob_bdev_copy *copy = arg;
+
+	if (!success) {
+		spdk_bdev_free_io(bdev_io);
+		copy->bserrno = -EIO;
+		bdev_blob_copy_release_src(copy);
+		return;
+	}
+
+	copy->dst_io = bdev_io;
+	bdev_blob_copy_data(copy);
+}
+
+static void
+bdev_blob_copy_queue(struct blob_bdev_copy *copy, spdk_bdev_io_wait_cb cb_fn)
+{
+	int rc;
+
+	copy->bdev_io_wait.bdev = __get_bdev(copy->dev);
+	copy->bdev_io_wait.cb_fn = cb_fn;
+	copy->bdev_io_wait.cb_arg = copy;
+
+	rc = spdk_bdev_queue_io_wait(__get_bdev(copy->dev), copy->channel, &copy->bdev_io_wait);
+	if (rc != 0) {
+		SPDK_ERRLOG("Queue io failed, rc=%d\n", rc);
+		assert(false);
+	}
+}
+
+static void
+bdev_blob_copy_start_dst(void *arg)
+{
+	struct blob_bdev_copy *copy = arg;
+	int rc;
+
+	rc = spdk_bdev_zcopy_start(__get_desc(copy->dev), copy->channel, copy->dst_lba,
+				   copy->lba_count, false, bdev_blob_copy_dst_started, copy);
+	if (rc == -ENOMEM) {
+		bdev_blob_copy_queue(copy, bdev_blob_copy_start_dst);
+	} else if (rc != 0) {
+		copy->bserrno = rc;
+		bdev_blob_copy_release_src(copy);
+	}
+}
+
+static void
+bdev_blob_copy_src_started(struct spdk_bdev_io *bdev_io, bool success, void *arg)
+{
+	struct blob_bdev_copy *copy = arg;
+
+	if (!success) {
+		spdk_bdev_free_io(bdev_io);
+		copy->bserrno = -EIO;
+		bdev_blob_copy_done(copy);
+		return;
+	}
+
+	copy->src_io = bdev_io;
+	bdev_blob_copy_start_dst(copy);
+}
+
+static void
+bdev_blob_copy_start_src(void *arg)
+{
+	struct blob_bdev_copy *copy = arg;
+	int rc;
+
+	rc = spdk_bdev_zcopy_start(__get_desc(copy->dev), copy->channel, copy->src_lba,
+				   copy->lba_count, true, bdev_blob_copy_src_started, copy);
+	if (rc == -ENOMEM) {
+		bdev_blob_copy_queue(copy, bdev_blob_copy_start_src);
+	} else if (rc != 0) {
+		copy->bserrno = rc;
+		bdev_blob_copy_done(copy);
+	}
+}
+
+static void
+bdev_blob_copy(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, uint64_t dst_lba,
+	       uint64_t src_lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct blob_bdev_copy *copy;
+
+	copy = calloc(1, sizeof(*copy) + spdk_accel_task_size());
+	if (copy == NULL) {
+		cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, -ENOMEM);
+		return;
+	}
+
+	copy->dev = dev;
+	copy->channel = channel;
+	copy->dst_lba = dst_lba;
+	copy->src_lba = src_lba;
+	copy->lba_count = lba_count;
+	copy->cb_args = cb_args;
+
+	bdev_blob_copy_start_src(copy);
+}
+
 static void
 bdev_blob_resubmit(void *arg)
 {
@@ -352,6 +606,9 @@ spdk_bdev_create_bs_dev(struct spdk_bdev *bdev, spdk_bdev_remove_cb_t remove_cb,
 	b->bs_dev.writev = bdev_blob_writev;
 	b->bs_dev.write_zeroes = bdev_blob_write_zeroes;
 	b->bs_dev.unmap = bdev_blob_unmap;
+	if (spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ZCOPY)) {
+		b->bs_dev.copy = bdev_blob_copy;
+	}
 
 	return &b->bs_dev;
 }
@@ -385,6 +642,9 @@ spdk_bdev_create_bs_dev_from_desc(struct spdk_bdev_desc *desc)
 	b->bs_dev.writev = bdev_blob_writev;
 	b->bs_dev.write_zeroes = bdev_blob_write_zeroes;
 	b->bs_dev.unmap = bdev_blob_unmap;
+	if (spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ZCOPY)) {
+		b->bs_dev.copy = bdev_blob_copy;
+	}
 
 	return &b->bs_dev;
 }
@@ -199,7 +199,7 @@ if __name__ == "__main__":
                                   pmd=args.pmd)
     p = subparsers.add_parser('compress_set_pmd', aliases=['set_compress_pmd'],
                               help='Set pmd option for a compress disk')
-    p.add_argument('-p', '--pmd', type=int, help='0 = auto-select, 1= QAT only, 2 = ISAL only')
+    p.add_argument('-p', '--pmd', type=int, help='0 = auto-select, 1= QAT only, 2 = ISAL only, 3 = software only')
     p.set_defaults(func=compress_set_pmd)
 
     def bdev_compress_get_orphans(args):
@@ -222,9 +222,10 @@ if __name__ == "__main__":
                               help='Add a crypto vbdev')
     p.add_argument('base_bdev_name', help="Name of the base bdev")
     p.add_argument('name', help="Name of the crypto vbdev")
-    p.add_argument('crypto_pmd', help="Name of the crypto device driver")
+    p.add_argument('crypto_pmd', help="Name of the crypto device driver, or ipsec_mb for the software path")
     p.add_argument('key', help="Key")
-    p.add_argument('-c', '--cipher', help="cipher to use, AES_CBC or AES_XTS (QAT only)", default="AES_CBC")
+    p.add_argument('-c', '--cipher', help="cipher to use, AES_CBC or AES_XTS (QAT and ipsec_mb only)",
+                   default="AES_CBC")
     p.add_argument('-k2', '--key2', help="2nd key for cipher AET_XTS", default=None)
     p.set_defaults(func=bdev_crypto_create)
 
@@ -358,6 +359,28 @@ if __name__ == "__main__":
     p.add_argument('name', help='aio bdev name')
     p.set_defaults(func=bdev_aio_delete)
 
+    def bdev_uring_set_options(args):
+        rpc.bdev.bdev_uring_set_options(args.client,
+                                        queue_depth=args.queue_depth,
+                                        register_files=args.register_files,
+                                        fixed_buffers=args.fixed_buffers,
+                                        sq_poll=args.sq_poll,
+                                        sq_thread_idle_ms=args.sq_thread_idle_ms,
+                                        sq_thread_cpu=args.sq_thread_cpu)
+
+    p = subparsers.add_parser('bdev_uring_set_options',
+                              help='Set options for the uring bdev type. This is startup command.')
+    p.add_argument('-q', '--queue-depth', help='Number of submission queue entries of each ring', type=int)
+    p.add_argument('-f', '--register-files', help='Register bdev files with each ring',
+                   action='store_true', default=None)
+    p.add_argument('-b', '--fixed-buffers', help='Register SPDK hugepage memory as fixed buffers',
+                   action='store_true', default=None)
+    p.add_argument('-s', '--sq-poll', help='Poll submission queues with a shared kernel thread (requires -f)',
+                   action='store_true', default=None)
+    p.add_argument('-i', '--sq-thread-idle-ms', help='Idle time before the SQ poll thread sleeps', type=int)
+    p.add_argument('-c', '--sq-thread-cpu', help='CPU to pin the SQ poll thread to', type=int)
+    p.set_defaults(func=bdev_uring_set_options)
+
     def bdev_uring_create(args):
         print_json(rpc.bdev.bdev_uring_create(args.client,
                                               filename=args.filename,
@@ -390,7 +413,9 @@ if __name__ == "__main__":
                                        nvme_adminq_poll_period_us=args.nvme_adminq_poll_period_us,
                                        nvme_ioq_poll_period_us=args.nvme_ioq_poll_period_us,
                                        io_queue_requests=args.io_queue_requests,
-                                       delay_cmd_submit=args.delay_cmd_submit)
+                                       delay_cmd_submit=args.delay_cmd_submit,
+                                       max_concurrent_attaches=args.max_concurrent_attaches,
+                                       max_qpairs_per_ctrlr=args.max_qpairs_per_ctrlr)
 
     p = subparsers.add_parser('bdev_nvme_set_options', aliases=['set_bdev_nvme_options'],
                               help='Set options for the bdev nvme type. This is startup command.')
@@ -417,6 +442,11 @@ if __name__ == "__main__":
     p.add_argument('-d', '--disable-delay-cmd-submit',
                    help='Disable delaying NVMe command submission, i.e. no batching of multiple commands',
                    action='store_false', dest='delay_cmd_submit', default=True)
+    p.add_argument('--max-concurrent-attaches',
+                   help='Maximum number of controllers attached at the same time. Default: 0, no limit', type=int)
+    p.add_argument('--max-qpairs-per-ctrlr',
+                   help='Maximum number of I/O qpairs per controller shared by all threads. Default: 0, a qpair per thread',
+                   type=int)
     p.set_defaults(func=bdev_nvme_set_options)
 
     def bdev_nvme_set_hotplug(args):
@@ -480,6 +510,13 @@ if __name__ == "__main__":
     p.add_argument('-n', '--name', help="Name of the NVMe controller. Example: Nvme0", required=False)
     p.set_defaults(func=bdev_nvme_get_controllers)
 
+    def bdev_nvme_get_transport_statistics(args):
+        print_dict(rpc.nvme.bdev_nvme_get_transport_statistics(args.client))
+
+    p = subparsers.add_parser('bdev_nvme_get_transport_statistics',
+                              help='Display transport statistics of the bdev_nvme poll groups')
+    p.set_defaults(func=bdev_nvme_get_transport_statistics)
+
     def bdev_nvme_detach_controller(args):
         rpc.bdev.bdev_nvme_detach_controller(args.client,
                                              name=args.name)
@@ -547,7 +584,8 @@ if __name__ == "__main__":
                                             config=config,
                                             pool_name=args.pool_name,
                                             rbd_name=args.rbd_name,
-                                            block_size=args.block_size))
+                                            block_size=args.block_size,
+                                            poll_mode=args.poll_mode))
 
     p = subparsers.add_parser('bdev_rbd_create', aliases=['construct_rbd_bdev'],
                               help='Add a bdev with ceph rbd backend')
@@ -555,6 +593,8 @@ if __name__ == "__main__":
     p.add_argument('--user', help="Ceph user name (i.e. admin, not client.admin)", required=False)
     p.add_argument('--config', action='append', metavar='key=value',
                    help="adds a key=value configuration option for rados_conf_set (default: rely on config file)")
+    p.add_argument('-p', '--poll-mode', action='store_true', default=None,
+                   help="Share one image handle between threads and poll for completions instead of using eventfd")
     p.add_argument('pool_name', help='rbd pool name')
     p.add_argument('rbd_name', help='rbd image name')
     p.add_argument('block_size', help='rbd block size', type=int)
@@ -1427,22 +1467,45 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
 
     def bdev_lvol_inflate(args):
         rpc.lvol.bdev_lvol_inflate(args.client,
-                                   name=args.name)
+                                   name=args.name,
+                                   max_clusters_per_sec=args.max_clusters_per_sec,
+                                   max_bytes_per_sec=args.max_bytes_per_sec,
+                                   background=args.background)
 
     p = subparsers.add_parser('bdev_lvol_inflate', aliases=['inflate_lvol_bdev'],
                               help='Make thin provisioned lvol a thick provisioned lvol')
     p.add_argument('name', help='lvol bdev name')
+    p.add_argument('-c', '--max-clusters-per-sec', help='Clusters copied per second at most', type=int)
+    p.add_argument('-b', '--max-bytes-per-sec', help='Bytes copied per second at most', type=int)
+    p.add_argument('-g', '--background', action='store_true',
+                   help='Respond before the operation completes')
     p.set_defaults(func=bdev_lvol_inflate)
 
     def bdev_lvol_decouple_parent(args):
         rpc.lvol.bdev_lvol_decouple_parent(args.client,
-                                           name=args.name)
+                                           name=args.name,
+                                           max_clusters_per_sec=args.max_clusters_per_sec,
+                                           max_bytes_per_sec=args.max_bytes_per_sec,
+                                           background=args.background)
 
     p = subparsers.add_parser('bdev_lvol_decouple_parent', aliases=['decouple_parent_lvol_bdev'],
                               help='Decouple parent of lvol')
     p.add_argument('name', help='lvol bdev name')
+    p.add_argument('-c', '--max-clusters-per-sec', help='Clusters copied per second at most', type=int)
+    p.add_argument('-b', '--max-bytes-per-sec', help='Bytes copied per second at most', type=int)
+    p.add_argument('-g', '--background', action='store_true',
+                   help='Respond before the operation completes')
     p.set_defaults(func=bdev_lvol_decouple_parent)
 
+    def bdev_lvol_get_inflate_progress(args):
+        print_json(rpc.lvol.bdev_lvol_get_inflate_progress(args.client,
+                                                           name=args.name))
+
+    p = subparsers.add_parser('bdev_lvol_get_inflate_progress',
+                              help='Get progress of lvol inflate or parent decouple')
+    p.add_argument('name', help='lvol bdev name')
+    p.set_defaults(func=bdev_lvol_get_inflate_progress)
+
     def bdev_lvol_resize(args):
         rpc.lvol.bdev_lvol_resize(args.client,
                                   name=args.name,
@@ -1494,6 +1557,20 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-l', '--lvs-name', help='lvol store name', required=False)
     p.set_defaults(func=bdev_lvol_get_lvstores)
 
+    def bdev_lvol_set_unmap_rate_limit(args):
+        rpc.lvol.bdev_lvol_set_unmap_rate_limit(args.client,
+                                                max_bytes_per_sec=args.max_bytes_per_sec,
+                                                uuid=args.uuid,
+                                                lvs_name=args.lvs_name)
+
+    p = subparsers.add_parser('bdev_lvol_set_unmap_rate_limit',
+                              help='Limit the rate at which released clusters are unmapped')
+    p.add_argument('-u', '--uuid', help='lvol store UUID', required=False)
+    p.add_argument('-l', '--lvs-name', help='lvol store name', required=False)
+    p.add_argument('max_bytes_per_sec', help='Maximum bytes unmapped per second, 0 for no limit',
+                   type=int)
+    p.set_defaults(func=bdev_lvol_set_unmap_rate_limit)
+
     def bdev_raid_get_bdevs(args):
         print_array(rpc.bdev.bdev_raid_get_bdevs(args.client,
                                                  category=args.category))
@@ -54,7 +54,7 @@ def compress_set_pmd(client, pmd):
     """Set pmd options for the bdev compress.
 
     Args:
-        pmd: 0 = auto-select, 1 = QAT, 2 = ISAL
+        pmd: 0 = auto-select, 1 = QAT, 2 = ISAL, 3 = software worker threads
     """
     params = {'pmd': pmd}
 
@@ -328,6 +328,41 @@ def bdev_aio_delete(client, name):
     return client.call('bdev_aio_delete', params)
 
 
+def bdev_uring_set_options(client, queue_depth=None, register_files=None, fixed_buffers=None,
+                           sq_poll=None, sq_thread_idle_ms=None, sq_thread_cpu=None):
+    """Set options for the uring bdev module. This is startup command.
+
+    Args:
+        queue_depth: number of submission queue entries of each per-thread ring (optional)
+        register_files: register bdev files with each ring (optional)
+        fixed_buffers: register SPDK hugepage memory as fixed buffers (optional)
+        sq_poll: poll the submission queues with a shared kernel thread; requires register_files (optional)
+        sq_thread_idle_ms: idle time in milliseconds before the SQ poll thread sleeps (optional)
+        sq_thread_cpu: CPU to pin the SQ poll thread to, -1 to leave it unpinned (optional)
+    """
+    params = {}
+
+    if queue_depth is not None:
+        params['queue_depth'] = queue_depth
+
+    if register_files is not None:
+        params['register_files'] = register_files
+
+    if fixed_buffers is not None:
+        params['fixed_buffers'] = fixed_buffers
+
+    if sq_poll is not None:
+        params['sq_poll'] = sq_poll
+
+    if sq_thread_idle_ms is not None:
+        params['sq_thread_idle_ms'] = sq_thread_idle_ms
+
+    if sq_thread_cpu is not None:
+        params['sq_thread_cpu'] = sq_thread_cpu
+
+    return client.call('bdev_uring_set_options', params)
+
+
 def bdev_uring_create(client, filename, name, block_size=None):
     """Create a bdev with Linux io_uring backend.
 
@@ -363,7 +398,7 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, retry
                           arbitration_burst=None, low_priority_weight=None,
                           medium_priority_weight=None, high_priority_weight=None,
                           nvme_adminq_poll_period_us=None, nvme_ioq_poll_period_us=None, io_queue_requests=None,
-                          delay_cmd_submit=None):
+                          delay_cmd_submit=None, max_concurrent_attaches=None, max_qpairs_per_ctrlr=None):
     """Set options for the bdev nvme. This is startup command.
 
     Args:
@@ -378,6 +413,8 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, retry
         nvme_ioq_poll_period_us: How often to poll I/O queues for completions in microseconds (optional)
         io_queue_requests: The number of requests allocated for each NVMe I/O queue. Default: 512 (optional)
         delay_cmd_submit: Enable delayed NVMe command submission to allow batching of multiple commands (optional)
+        max_concurrent_attaches: Maximum number of controllers attached at the same time. Default: 0, no limit (optional)
+        max_qpairs_per_ctrlr: Maximum number of I/O qpairs per controller shared by all threads. Default: 0, a qpair per thread (optional)
     """
     params = {}
 
@@ -414,6 +451,12 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, retry
     if delay_cmd_submit is not None:
         params['delay_cmd_submit'] = delay_cmd_submit
 
+    if max_concurrent_attaches is not None:
+        params['max_concurrent_attaches'] = max_concurrent_attaches
+
+    if max_qpairs_per_ctrlr is not None:
+        params['max_qpairs_per_ctrlr'] = max_qpairs_per_ctrlr
+
     return client.call('bdev_nvme_set_options', params)
 
 
@@ -555,7 +598,8 @@ def bdev_zone_block_delete(client, name):
 
 
 @deprecated_alias('construct_rbd_bdev')
-def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=None, config=None):
+def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=None, config=None,
+                    poll_mode=None):
     """Create a Ceph RBD block device.
 
     Args:
@@ -565,6 +609,7 @@ def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=Non
         name: name of block device (optional)
         user: Ceph user name (optional)
         config: map of config keys to values (optional)
+        poll_mode: share one image handle and poll for completions without eventfd (optional)
 
     Returns:
         Name of created block device.
@@ -581,6 +626,8 @@ def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=Non
         params['user_id'] = user
     if config is not None:
         params['config'] = config
+    if poll_mode is not None:
+        params['poll_mode'] = poll_mode
 
     return client.call('bdev_rbd_create', params)
 
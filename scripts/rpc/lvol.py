@@ -161,31 +161,66 @@ def bdev_lvol_delete(client, name):
 
 
 @deprecated_alias('inflate_lvol_bdev')
-def bdev_lvol_inflate(client, name):
+def bdev_lvol_inflate(client, name, max_clusters_per_sec=None, max_bytes_per_sec=None,
+                      background=None):
     """Inflate a logical volume.
 
     Args:
         name: name of logical volume to inflate
+        max_clusters_per_sec: clusters copied per second at most (optional)
+        max_bytes_per_sec: bytes copied per second at most (optional)
+        background: respond before the operation completes (optional)
     """
     params = {
         'name': name,
     }
+    if max_clusters_per_sec:
+        params['max_clusters_per_sec'] = max_clusters_per_sec
+    if max_bytes_per_sec:
+        params['max_bytes_per_sec'] = max_bytes_per_sec
+    if background:
+        params['background'] = background
     return client.call('bdev_lvol_inflate', params)
 
 
 @deprecated_alias('decouple_parent_lvol_bdev')
-def bdev_lvol_decouple_parent(client, name):
+def bdev_lvol_decouple_parent(client, name, max_clusters_per_sec=None, max_bytes_per_sec=None,
+                              background=None):
     """Decouple parent of a logical volume.
 
     Args:
         name: name of logical volume to decouple parent
+        max_clusters_per_sec: clusters copied per second at most (optional)
+        max_bytes_per_sec: bytes copied per second at most (optional)
+        background: respond before the operation completes (optional)
     """
     params = {
         'name': name,
     }
+    if max_clusters_per_sec:
+        params['max_clusters_per_sec'] = max_clusters_per_sec
+    if max_bytes_per_sec:
+        params['max_bytes_per_sec'] = max_bytes_per_sec
+    if background:
+        params['background'] = background
     return client.call('bdev_lvol_decouple_parent', params)
 
 
+def bdev_lvol_get_inflate_progress(client, name):
+    """Get the progress of the inflate or parent decouple of a logical volume.
+
+    Args:
+        name: name of logical volume
+
+    Returns:
+        Clusters to copy and copied so far, elapsed and estimated remaining time.
+    """
+    params = {
+        'name': name,
+    }
+    return client.call('bdev_lvol_get_inflate_progress', params)
+
+
 @deprecated_alias('destroy_lvol_store')
 def bdev_lvol_delete_lvstore(client, uuid=None, lvs_name=None):
     """Destroy a logical volume store.
@@ -226,3 +261,24 @@ def bdev_lvol_get_lvstores(client, uuid=None, lvs_name=None):
     if lvs_name:
         params['lvs_name'] = lvs_name
     return client.call('bdev_lvol_get_lvstores', params)
+
+
+def bdev_lvol_set_unmap_rate_limit(client, max_bytes_per_sec, uuid=None, lvs_name=None):
+    """Limit the rate at which released clusters of a logical volume store are unmapped.
+
+    Args:
+        max_bytes_per_sec: maximum number of bytes unmapped per second, 0 for no limit
+        uuid: UUID of logical volume store (optional)
+        lvs_name: name of logical volume store (optional)
+
+    Either uuid or lvs_name must be specified, but not both.
+    """
+    if (uuid and lvs_name) or (not uuid and not lvs_name):
+        raise ValueError("Exactly one of uuid or lvs_name must be specified")
+
+    params = {'max_bytes_per_sec': max_bytes_per_sec}
+    if uuid:
+        params['uuid'] = uuid
+    if lvs_name:
+        params['lvs_name'] = lvs_name
+    return client.call('bdev_lvol_set_unmap_rate_limit', params)
@@ -57,6 +57,15 @@ def bdev_nvme_get_controllers(client, name=None):
     return client.call('bdev_nvme_get_controllers', params)
 
 
+def bdev_nvme_get_transport_statistics(client):
+    """Get bdev_nvme poll group transport statistics.
+
+    Returns:
+        Transport statistics of each poll group.
+    """
+    return client.call('bdev_nvme_get_transport_statistics')
+
+
 def bdev_nvme_opal_init(client, nvme_ctrlr_name, password):
     """Init nvme opal. Take ownership and activate
 
@@ -13,6 +13,7 @@ source $rootdir/test/nvmf/common.sh
 rpc_py="$rootdir/scripts/rpc.py"
 
 truncate -s 64M $testdir/aio.bdev
+truncate -s 64M $testdir/aio_thin.bdev
 
 $rootdir/test/app/bdev_svc/bdev_svc &
 bdev_svc_pid=$!
@@ -23,6 +24,10 @@ waitforlisten $bdev_svc_pid
 $rpc_py bdev_aio_create $testdir/aio.bdev aio0 4096
 $rpc_py bdev_lvol_create_lvstore aio0 lvs0
 $rpc_py bdev_lvol_create -l lvs0 lvol0 32
+# Small clusters so that the thin lvol below keeps allocating for the whole run
+$rpc_py bdev_aio_create $testdir/aio_thin.bdev aio1 4096
+$rpc_py bdev_lvol_create_lvstore -c 65536 aio1 lvs1
+$rpc_py bdev_lvol_create -t -l lvs1 lvol_thin 48
 
 killprocess $bdev_svc_pid
 
@@ -33,8 +38,15 @@ BdevIoPoolSize 128
 BdevIoCacheSize 1
 [AIO]
 AIO $testdir/aio.bdev aio0 4096
+AIO $testdir/aio_thin.bdev aio1 4096
 EOL
 
+# Cluster allocation throughput: random writes to a fresh thin lvol, where
+# writes keep landing in clusters that still have to be allocated.
+# Runs first, the runs below write to all bdevs including aio1 underneath lvs1.
+$rootdir/test/bdev/bdevperf/bdevperf -c $testdir/bdevperf.conf -q 128 -o 4096 -w randwrite -t 2 \
+	-T lvs1/lvol_thin
+
 $rootdir/test/bdev/bdevperf/bdevperf -c $testdir/bdevperf.conf -q 128 -o 4096 -w write -t 5 -r /var/tmp/spdk.sock &
 bdev_perf_pid=$!
 waitforlisten $bdev_perf_pid
@@ -58,4 +70,5 @@ $rootdir/test/bdev/bdevperf/bdevperf -c $testdir/bdevperf.conf -q 128 -o 4096 -w
 sync
 rm -rf $testdir/bdevperf.conf
 rm -rf $testdir/aio.bdev
+rm -rf $testdir/aio_thin.bdev
 trap - SIGINT SIGTERM EXIT
@@ -0,0 +1,773 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "spdk/stdinc.h"
+#include "spdk_cunit.h"
+#include "spdk/thread.h"
+#include "spdk/bdev_module.h"
+#include "spdk/util.h"
+#include "spdk_internal/mock.h"
+#include "spdk_internal/thread.h"
+
+#include "bdev/nvme/bdev_nvme.c"
+#include "bdev/nvme/common.c"
+#include "common/lib/ut_multithread.c"
+#include "unit/lib/json_mock.c"
+
+DEFINE_STUB(bdev_ocssd_create_io_channel, int, (struct nvme_io_channel *ioch), 0);
+DEFINE_STUB_V(bdev_ocssd_destroy_io_channel, (struct nvme_io_channel *ioch));
+DEFINE_STUB(bdev_ocssd_init_ctrlr, int, (struct nvme_bdev_ctrlr *nvme_bdev_ctrlr), 0);
+DEFINE_STUB_V(bdev_ocssd_fini_ctrlr, (struct nvme_bdev_ctrlr *nvme_bdev_ctrlr));
+DEFINE_STUB_V(bdev_ocssd_populate_namespace, (struct nvme_bdev_ctrlr *nvme_bdev_ctrlr,
+		struct nvme_bdev_ns *nvme_ns, struct nvme_async_probe_ctx *ctx));
+DEFINE_STUB_V(bdev_ocssd_depopulate_namespace, (struct nvme_bdev_ns *ns));
+DEFINE_STUB_V(bdev_ocssd_namespace_config_json, (struct spdk_json_write_ctx *w,
+		struct nvme_bdev_ns *ns));
+DEFINE_STUB_V(bdev_ocssd_handle_chunk_notification, (struct nvme_bdev_ctrlr *nvme_bdev_ctrlr));
+
+DEFINE_STUB(spdk_accel_engine_get_io_channel, struct spdk_io_channel *, (void), NULL);
+DEFINE_STUB(spdk_accel_get_capabilities, uint64_t, (struct spdk_io_channel *ch), 0);
+DEFINE_STUB(spdk_accel_submit_crc32c, int, (struct spdk_accel_task *accel_req,
+		struct spdk_io_channel *ch, uint32_t *dst, void *src, uint32_t seed,
+		uint64_t nbytes, spdk_accel_completion_cb cb), 0);
+DEFINE_STUB(spdk_accel_task_size, size_t, (void), 0);
+
+DEFINE_STUB_V(spdk_bdev_io_get_buf, (struct spdk_bdev_io *bdev_io, spdk_bdev_io_get_buf_cb cb,
+				     uint64_t len));
+DEFINE_STUB(spdk_bdev_io_get_thread, struct spdk_thread *, (struct spdk_bdev_io *bdev_io), NULL);
+DEFINE_STUB_V(spdk_bdev_module_finish_done, (void));
+DEFINE_STUB_V(spdk_bdev_module_init_done, (struct spdk_bdev_module *module));
+DEFINE_STUB_V(spdk_bdev_module_list_add, (struct spdk_bdev_module *bdev_module));
+DEFINE_STUB(spdk_bdev_notify_blockcnt_change, int, (struct spdk_bdev *bdev, uint64_t size), 0);
+DEFINE_STUB(spdk_bdev_register, int, (struct spdk_bdev *bdev), 0);
+DEFINE_STUB_V(spdk_bdev_unregister, (struct spdk_bdev *bdev, spdk_bdev_unregister_cb cb_fn,
+				     void *cb_arg));
+
+DEFINE_STUB(spdk_conf_find_section, struct spdk_conf_section *, (struct spdk_conf *cp,
+		const char *name), NULL);
+DEFINE_STUB(spdk_conf_section_get_boolval, bool, (struct spdk_conf_section *sp, const char *key,
+		bool default_val), false);
+DEFINE_STUB(spdk_conf_section_get_intval, int, (struct spdk_conf_section *sp, const char *key),
+	    -1);
+DEFINE_STUB(spdk_conf_section_get_nmval, char *, (struct spdk_conf_section *sp, const char *key,
+		int idx1, int idx2), NULL);
+DEFINE_STUB(spdk_conf_section_get_val, char *, (struct spdk_conf_section *sp, const char *key),
+	    NULL);
+DEFINE_STUB(spdk_json_write_string_fmt, int, (struct spdk_json_write_ctx *w, const char *fmt,
+		...), 0);
+
+DEFINE_STUB(spdk_nvme_connect_async, struct spdk_nvme_probe_ctx *,
+	    (const struct spdk_nvme_transport_id *trid, const struct spdk_nvme_ctrlr_opts *opts,
+	     spdk_nvme_attach_cb attach_cb), NULL);
+DEFINE_STUB(spdk_nvme_ctrlr_alloc_io_qpair, struct spdk_nvme_qpair *,
+	    (struct spdk_nvme_ctrlr *ctrlr, const struct spdk_nvme_io_qpair_opts *opts,
+	     size_t opts_size), NULL);
+DEFINE_STUB(spdk_nvme_ctrlr_cmd_abort, int, (struct spdk_nvme_ctrlr *ctrlr,
+		struct spdk_nvme_qpair *qpair, uint16_t cid, spdk_nvme_cmd_cb cb_fn,
+		void *cb_arg), 0);
+DEFINE_STUB(spdk_nvme_ctrlr_cmd_abort_ext, int, (struct spdk_nvme_ctrlr *ctrlr,
+		struct spdk_nvme_qpair *qpair, void *cmd_cb_arg, spdk_nvme_cmd_cb cb_fn,
+		void *cb_arg), 0);
+DEFINE_STUB(spdk_nvme_ctrlr_cmd_admin_raw, int, (struct spdk_nvme_ctrlr *ctrlr,
+		struct spdk_nvme_cmd *cmd, void *buf, uint32_t len, spdk_nvme_cmd_cb cb_fn,
+		void *cb_arg), 0);
+DEFINE_STUB(spdk_nvme_ctrlr_cmd_io_raw, int, (struct spdk_nvme_ctrlr *ctrlr,
+		struct spdk_nvme_qpair *qpair, struct spdk_nvme_cmd *cmd, void *buf, uint32_t len,
+		spdk_nvme_cmd_cb cb_fn, void *cb_arg), 0);
+DEFINE_STUB(spdk_nvme_ctrlr_cmd_io_raw_with_md, int, (struct spdk_nvme_ctrlr *ctrlr,
+		struct spdk_nvme_qpair *qpair, struct spdk_nvme_cmd *cmd, void *buf, uint32_t len,
+		void *md_buf, spdk_nvme_cmd_cb cb_fn, void *cb_arg), 0);
+DEFINE_STUB(spdk_nvme_ctrlr_connect_io_qpair, int, (struct spdk_nvme_ctrlr *ctrlr,
+		struct spdk_nvme_qpair *qpair), 0);
+DEFINE_STUB(spdk_nvme_ctrlr_free_io_qpair, int, (struct spdk_nvme_qpair *qpair), 0);
+DEFINE_STUB(spdk_nvme_ctrlr_get_data, const struct spdk_nvme_ctrlr_data *,
+	    (struct spdk_nvme_ctrlr *ctrlr), NULL);
+DEFINE_STUB_V(spdk_nvme_ctrlr_get_default_ctrlr_opts, (struct spdk_nvme_ctrlr_opts *opts,
+		size_t opts_size));
+DEFINE_STUB_V(spdk_nvme_ctrlr_get_default_io_qpair_opts, (struct spdk_nvme_ctrlr *ctrlr,
+		struct spdk_nvme_io_qpair_opts *opts, size_t opts_size));
+DEFINE_STUB(spdk_nvme_ctrlr_get_flags, uint64_t, (struct spdk_nvme_ctrlr *ctrlr), 0);
+DEFINE_STUB(spdk_nvme_ctrlr_get_max_xfer_size, uint32_t, (const struct spdk_nvme_ctrlr *ctrlr), 0);
+DEFINE_STUB(spdk_nvme_ctrlr_get_ns, struct spdk_nvme_ns *, (struct spdk_nvme_ctrlr *ctrlr,
+		uint32_t ns_id), NULL);
+DEFINE_STUB(spdk_nvme_ctrlr_get_num_ns, uint32_t, (struct spdk_nvme_ctrlr *ctrlr), 0);
+DEFINE_STUB(spdk_nvme_ctrlr_get_regs_csts, union spdk_nvme_csts_register,
+	    (struct spdk_nvme_ctrlr *ctrlr), {});
+DEFINE_STUB(spdk_nvme_ctrlr_get_regs_vs, union spdk_nvme_vs_register,
+	    (struct spdk_nvme_ctrlr *ctrlr), {});
+DEFINE_STUB(spdk_nvme_ctrlr_get_transport_id, const struct spdk_nvme_transport_id *,
+	    (struct spdk_nvme_ctrlr *ctrlr), NULL);
+DEFINE_STUB(spdk_nvme_ctrlr_is_active_ns, bool, (struct spdk_nvme_ctrlr *ctrlr, uint32_t nsid),
+	    false);
+DEFINE_STUB(spdk_nvme_ctrlr_is_ocssd_supported, bool, (struct spdk_nvme_ctrlr *ctrlr), false);
+DEFINE_STUB(spdk_nvme_ctrlr_process_admin_completions, int32_t, (struct spdk_nvme_ctrlr *ctrlr),
+	    0);
+DEFINE_STUB_V(spdk_nvme_ctrlr_register_aer_callback, (struct spdk_nvme_ctrlr *ctrlr,
+		spdk_nvme_aer_cb aer_cb_fn, void *aer_cb_arg));
+DEFINE_STUB_V(spdk_nvme_ctrlr_register_timeout_callback, (struct spdk_nvme_ctrlr *ctrlr,
+		uint64_t timeout_us, spdk_nvme_timeout_cb cb_fn, void *cb_arg));
+DEFINE_STUB(spdk_nvme_detach, int, (struct spdk_nvme_ctrlr *ctrlr), 0);
+DEFINE_STUB(spdk_nvme_host_id_parse, int, (struct spdk_nvme_host_id *hostid, const char *str), 0);
+
+DEFINE_STUB(spdk_nvme_ns_cmd_comparev_with_md, int, (struct spdk_nvme_ns *ns,
+		struct spdk_nvme_qpair *qpair, uint64_t lba, uint32_t lba_count,
+		spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t io_flags,
+		spdk_nvme_req_reset_sgl_cb reset_sgl_fn, spdk_nvme_req_next_sge_cb next_sge_fn,
+		void *metadata, uint16_t apptag_mask, uint16_t apptag), 0);
+DEFINE_STUB(spdk_nvme_ns_cmd_dataset_management, int, (struct spdk_nvme_ns *ns,
+		struct spdk_nvme_qpair *qpair, uint32_t type,
+		const struct spdk_nvme_dsm_range *ranges, uint16_t num_ranges,
+		spdk_nvme_cmd_cb cb_fn, void *cb_arg), 0);
+DEFINE_STUB(spdk_nvme_ns_cmd_readv_with_md, int, (struct spdk_nvme_ns *ns,
+		struct spdk_nvme_qpair *qpair, uint64_t lba, uint32_t lba_count,
+		spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t io_flags,
+		spdk_nvme_req_reset_sgl_cb reset_sgl_fn, spdk_nvme_req_next_sge_cb next_sge_fn,
+		void *metadata, uint16_t apptag_mask, uint16_t apptag), 0);
+DEFINE_STUB(spdk_nvme_ns_cmd_writev_with_md, int, (struct spdk_nvme_ns *ns,
+		struct spdk_nvme_qpair *qpair, uint64_t lba, uint32_t lba_count,
+		spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t io_flags,
+		spdk_nvme_req_reset_sgl_cb reset_sgl_fn, spdk_nvme_req_next_sge_cb next_sge_fn,
+		void *metadata, uint16_t apptag_mask, uint16_t apptag), 0);
+DEFINE_STUB(spdk_nvme_ns_get_csi, enum spdk_nvme_csi, (const struct spdk_nvme_ns *ns),
+	    SPDK_NVME_CSI_ZNS);
+DEFINE_STUB(spdk_nvme_ns_get_data, const struct spdk_nvme_ns_data *, (struct spdk_nvme_ns *ns),
+	    NULL);
+DEFINE_STUB(spdk_nvme_ns_get_dealloc_logical_block_read_value,
+	    enum spdk_nvme_dealloc_logical_block_read_value, (struct spdk_nvme_ns *ns), 0);
+DEFINE_STUB(spdk_nvme_ns_get_extended_sector_size, uint32_t, (struct spdk_nvme_ns *ns), 4096);
+DEFINE_STUB(spdk_nvme_ns_get_id, uint32_t, (struct spdk_nvme_ns *ns), 1);
+DEFINE_STUB(spdk_nvme_ns_get_max_io_xfer_size, uint32_t, (struct spdk_nvme_ns *ns), 131072);
+DEFINE_STUB(spdk_nvme_ns_get_md_size, uint32_t, (struct spdk_nvme_ns *ns), 0);
+DEFINE_STUB(spdk_nvme_ns_get_num_sectors, uint64_t, (struct spdk_nvme_ns *ns), 0);
+DEFINE_STUB(spdk_nvme_ns_get_optimal_io_boundary, uint32_t, (struct spdk_nvme_ns *ns), 0);
+DEFINE_STUB(spdk_nvme_ns_get_pi_type, enum spdk_nvme_pi_type, (struct spdk_nvme_ns *ns), 0);
+DEFINE_STUB(spdk_nvme_ns_get_uuid, const struct spdk_uuid *, (const struct spdk_nvme_ns *ns),
+	    NULL);
+DEFINE_STUB(spdk_nvme_ns_supports_compare, bool, (struct spdk_nvme_ns *ns), false);
+
+DEFINE_STUB(spdk_nvme_poll_group_add, int, (struct spdk_nvme_poll_group *group,
+		struct spdk_nvme_qpair *qpair), 0);
+DEFINE_STUB(spdk_nvme_poll_group_create_ext, struct spdk_nvme_poll_group *, (void *ctx,
+		struct spdk_nvme_accel_fn_table *table), NULL);
+DEFINE_STUB(spdk_nvme_poll_group_destroy, int, (struct spdk_nvme_poll_group *group), 0);
+DEFINE_STUB(spdk_nvme_poll_group_process_completions, int64_t,
+	    (struct spdk_nvme_poll_group *group, uint32_t completions_per_qpair,
+	     spdk_nvme_disconnected_qpair_cb disconnected_qpair_cb), 0);
+DEFINE_STUB(spdk_nvme_poll_group_remove, int, (struct spdk_nvme_poll_group *group,
+		struct spdk_nvme_qpair *qpair), 0);
+DEFINE_STUB(spdk_nvme_prchk_flags_parse, int, (uint32_t *prchk_flags, const char *str), 0);
+DEFINE_STUB(spdk_nvme_prchk_flags_str, const char *, (uint32_t prchk_flags), NULL);
+DEFINE_STUB(spdk_nvme_probe, int, (const struct spdk_nvme_transport_id *trid, void *cb_ctx,
+				   spdk_nvme_probe_cb probe_cb, spdk_nvme_attach_cb attach_cb,
+				   spdk_nvme_remove_cb remove_cb), 0);
+DEFINE_STUB(spdk_nvme_probe_async, struct spdk_nvme_probe_ctx *,
+	    (const struct spdk_nvme_transport_id *trid, void *cb_ctx, spdk_nvme_probe_cb probe_cb,
+	     spdk_nvme_attach_cb attach_cb, spdk_nvme_remove_cb remove_cb), NULL);
+DEFINE_STUB(spdk_nvme_probe_poll_async, int, (struct spdk_nvme_probe_ctx *probe_ctx), 0);
+DEFINE_STUB(spdk_nvme_transport_id_adrfam_str, const char *, (enum spdk_nvmf_adrfam adrfam),
+	    NULL);
+DEFINE_STUB(spdk_nvme_transport_id_compare, int, (const struct spdk_nvme_transport_id *trid1,
+		const struct spdk_nvme_transport_id *trid2), 0);
+DEFINE_STUB(spdk_nvme_transport_id_parse, int, (struct spdk_nvme_transport_id *trid,
+		const char *str), 0);
+DEFINE_STUB(spdk_nvme_transport_id_trtype_str, const char *,
+	    (enum spdk_nvme_transport_type trtype), NULL);
+DEFINE_STUB_V(spdk_nvme_trid_populate_transport, (struct spdk_nvme_transport_id *trid,
+		enum spdk_nvme_transport_type trtype));
+
+DEFINE_STUB(spdk_nvme_zns_ns_get_max_open_zones, uint32_t, (struct spdk_nvme_ns *ns), 0);
+DEFINE_STUB(spdk_nvme_zns_ns_get_num_zones, uint64_t, (struct spdk_nvme_ns *ns), 8);
+DEFINE_STUB(spdk_nvme_zns_ns_get_zone_size_sectors, uint64_t, (struct spdk_nvme_ns *ns), 1024);
+
+DEFINE_STUB(spdk_opal_dev_construct, struct spdk_opal_dev *, (struct spdk_nvme_ctrlr *ctrlr),
+	    NULL);
+DEFINE_STUB_V(spdk_opal_dev_destruct, (struct spdk_opal_dev *dev));
+
+struct spdk_nvme_ns {
+	uint32_t nsid;
+};
+
+struct spdk_nvme_qpair {
+	uint16_t id;
+	bool disconnected;
+	/* Thread that last disconnected or reconnected the qpair */
+	struct spdk_thread *thread;
+};
+
+static struct spdk_nvme_ns g_ns;
+static struct spdk_nvme_qpair g_qpair;
+static struct spdk_io_channel *g_io_channel;
+
+/* The last zone command submitted to the namespace */
+static struct {
+	int			action;
+	uint64_t		slba;
+	bool			select_all;
+	uint32_t		lba_count;
+	void			*payload;
+	uint32_t		payload_size;
+	spdk_nvme_cmd_cb	cb_fn;
+	void			*cb_arg;
+} g_zns_cmd;
+
+/* The last completion reported to the bdev layer */
+static struct {
+	int		num_completions;
+	uint32_t	cdw0;
+	int		sct;
+	int		sc;
+} g_io_cpl;
+
+static enum spdk_bdev_io_status g_io_status;
+
+/* The shared qpairs of the reset tests, checked when the controller is reset */
+static struct nvme_bdev_shared_qpair g_shared_qpairs[2];
+static struct spdk_nvme_qpair g_shared_nvme_qpairs[2];
+static int g_num_ctrlr_resets;
+static int g_ctrlr_reset_rc;
+static int g_reconnect_rc;
+
+void
+spdk_bdev_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status status)
+{
+	g_io_status = status;
+}
+
+void
+spdk_nvme_ctrlr_disconnect_io_qpair(struct spdk_nvme_qpair *qpair)
+{
+	qpair->disconnected = true;
+	qpair->thread = spdk_get_thread();
+}
+
+int
+spdk_nvme_ctrlr_reconnect_io_qpair(struct spdk_nvme_qpair *qpair)
+{
+	CU_ASSERT(qpair->disconnected);
+	qpair->disconnected = false;
+	qpair->thread = spdk_get_thread();
+
+	return g_reconnect_rc;
+}
+
+int
+spdk_nvme_ctrlr_reset(struct spdk_nvme_ctrlr *ctrlr)
+{
+	size_t i;
+
+	/* No owner may be using its shared qpair while the controller resets */
+	for (i = 0; i < SPDK_COUNTOF(g_shared_qpairs); i++) {
+		CU_ASSERT(g_shared_qpairs[i].resetting);
+		CU_ASSERT(g_shared_nvme_qpairs[i].disconnected);
+	}
+	g_num_ctrlr_resets++;
+
+	return g_ctrlr_reset_rc;
+}
+
+struct spdk_io_channel *
+spdk_bdev_io_get_io_channel(struct spdk_bdev_io *bdev_io)
+{
+	return g_io_channel;
+}
+
+void
+spdk_bdev_io_complete_nvme_status(struct spdk_bdev_io *bdev_io, uint32_t cdw0, int sct, int sc)
+{
+	g_io_cpl.num_completions++;
+	g_io_cpl.cdw0 = cdw0;
+	g_io_cpl.sct = sct;
+	g_io_cpl.sc = sc;
+}
+
+static int
+ut_zns_zone_cmd(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair, int action,
+		uint64_t slba, bool select_all, spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	CU_ASSERT(ns == &g_ns);
+	CU_ASSERT(qpair == &g_qpair);
+
+	g_zns_cmd.action = action;
+	g_zns_cmd.slba = slba;
+	g_zns_cmd.select_all = select_all;
+	g_zns_cmd.cb_fn = cb_fn;
+	g_zns_cmd.cb_arg = cb_arg;
+
+	return 0;
+}
+
+int
+spdk_nvme_zns_close_zone(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair, uint64_t slba,
+			 bool select_all, spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return ut_zns_zone_cmd(ns, qpair, SPDK_NVME_ZONE_CLOSE, slba, select_all, cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_finish_zone(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair, uint64_t slba,
+			  bool select_all, spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return ut_zns_zone_cmd(ns, qpair, SPDK_NVME_ZONE_FINISH, slba, select_all, cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_open_zone(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair, uint64_t slba,
+			bool select_all, spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return ut_zns_zone_cmd(ns, qpair, SPDK_NVME_ZONE_OPEN, slba, select_all, cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_reset_zone(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair, uint64_t slba,
+			 bool select_all, spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return ut_zns_zone_cmd(ns, qpair, SPDK_NVME_ZONE_RESET, slba, select_all, cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_report_zones(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+			   void *payload, uint32_t payload_size, uint64_t slba,
+			   enum spdk_nvme_zns_zra_report_opts report_opts, bool partial_report,
+			   spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	CU_ASSERT(report_opts == SPDK_NVME_ZRA_LIST_ALL);
+	CU_ASSERT(partial_report == true);
+
+	g_zns_cmd.payload = payload;
+	g_zns_cmd.payload_size = payload_size;
+
+	return ut_zns_zone_cmd(ns, qpair, -1, slba, false, cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_zone_appendv_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+				   uint64_t zslba, uint32_t lba_count, spdk_nvme_cmd_cb cb_fn,
+				   void *cb_arg, uint32_t io_flags,
+				   spdk_nvme_req_reset_sgl_cb reset_sgl_fn,
+				   spdk_nvme_req_next_sge_cb next_sge_fn,
+				   void *metadata, uint16_t apptag_mask, uint16_t apptag)
+{
+	g_zns_cmd.lba_count = lba_count;
+
+	return ut_zns_zone_cmd(ns, qpair, -1, zslba, false, cb_fn, cb_arg);
+}
+
+static void
+ut_zns_cmd_complete(const struct spdk_nvme_cpl *cpl)
+{
+	spdk_nvme_cmd_cb cb_fn = g_zns_cmd.cb_fn;
+
+	SPDK_CU_ASSERT_FATAL(cb_fn != NULL);
+	g_zns_cmd.cb_fn = NULL;
+	cb_fn(g_zns_cmd.cb_arg, cpl);
+}
+
+static struct nvme_bdev_ns g_nvme_ns = {
+	.ns = &g_ns,
+};
+
+static struct nvme_bdev g_nbdev = {
+	.disk.ctxt = &g_nbdev,
+	.nvme_ns = &g_nvme_ns,
+};
+
+static struct spdk_bdev_io *
+ut_alloc_bdev_io(void)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	bdev_io = calloc(1, sizeof(*bdev_io) + sizeof(struct nvme_bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->bdev = &g_nbdev.disk;
+
+	memset(&g_zns_cmd, 0, sizeof(g_zns_cmd));
+	memset(&g_io_cpl, 0, sizeof(g_io_cpl));
+
+	return bdev_io;
+}
+
+static void
+ut_set_zone_desc(struct spdk_nvme_zns_zone_desc *desc, uint64_t zslba, uint8_t zs)
+{
+	memset(desc, 0, sizeof(*desc));
+	desc->zslba = zslba;
+	desc->zs = zs;
+	desc->wp = zslba + 16;
+	desc->zcap = 1000;
+}
+
+static void
+test_fill_zone_info(void)
+{
+	static const struct {
+		uint8_t				zs;
+		enum spdk_bdev_zone_state	state;
+	} states[] = {
+		{ SPDK_NVME_ZONE_STATE_EMPTY, SPDK_BDEV_ZONE_STATE_EMPTY },
+		{ SPDK_NVME_ZONE_STATE_IOPEN, SPDK_BDEV_ZONE_STATE_OPEN },
+		{ SPDK_NVME_ZONE_STATE_EOPEN, SPDK_BDEV_ZONE_STATE_OPEN },
+		{ SPDK_NVME_ZONE_STATE_CLOSED, SPDK_BDEV_ZONE_STATE_CLOSED },
+		{ SPDK_NVME_ZONE_STATE_RONLY, SPDK_BDEV_ZONE_STATE_READ_ONLY },
+		{ SPDK_NVME_ZONE_STATE_FULL, SPDK_BDEV_ZONE_STATE_FULL },
+		{ SPDK_NVME_ZONE_STATE_OFFLINE, SPDK_BDEV_ZONE_STATE_OFFLINE },
+	};
+	struct spdk_nvme_zns_zone_desc desc;
+	struct spdk_bdev_zone_info info;
+	size_t i;
+	int rc;
+
+	for (i = 0; i < SPDK_COUNTOF(states); i++) {
+		ut_set_zone_desc(&desc, 2048, states[i].zs);
+		memset(&info, 0, sizeof(info));
+
+		rc = bdev_nvme_fill_zone_info(&info, &desc);
+		CU_ASSERT(rc == 0);
+		CU_ASSERT(info.state == states[i].state);
+		CU_ASSERT(info.zone_id == 2048);
+		CU_ASSERT(info.write_pointer == 2048 + 16);
+		CU_ASSERT(info.capacity == 1000);
+	}
+
+	/* Reserved zone states are rejected */
+	ut_set_zone_desc(&desc, 2048, 0x5);
+	rc = bdev_nvme_fill_zone_info(&info, &desc);
+	CU_ASSERT(rc == -EIO);
+}
+
+static void
+test_get_zone_info(void)
+{
+	struct spdk_bdev_io *bdev_io;
+	struct nvme_bdev_io *bio;
+	struct spdk_nvme_zns_zone_report *report;
+	struct spdk_bdev_zone_info info[3] = {};
+	struct spdk_nvme_cpl cpl = {};
+	uint32_t report_size;
+	int rc;
+
+	bdev_io = ut_alloc_bdev_io();
+	bio = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+
+	/* Zones must be reported from the start of a zone, within the namespace */
+	rc = bdev_nvme_get_zone_info(&g_nbdev, &g_qpair, bio, 1000, 1, info);
+	CU_ASSERT(rc == -EINVAL);
+	rc = bdev_nvme_get_zone_info(&g_nbdev, &g_qpair, bio, 0, 0, info);
+	CU_ASSERT(rc == -EINVAL);
+	rc = bdev_nvme_get_zone_info(&g_nbdev, &g_qpair, bio, 7 * 1024, 2, info);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Only two zone descriptors fit in a command, three zones take two reports */
+	report_size = sizeof(*report) + 2 * sizeof(report->descs[0]);
+	MOCK_SET(spdk_nvme_ns_get_max_io_xfer_size, report_size);
+
+	bdev_io->u.zone_mgmt.zone_id = 2 * 1024;
+	bdev_io->u.zone_mgmt.num_zones = 3;
+	bdev_io->u.zone_mgmt.buf = info;
+	rc = bdev_nvme_get_zone_info(&g_nbdev, &g_qpair, bio, 2 * 1024, 3, info);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_zns_cmd.slba == 2 * 1024);
+	CU_ASSERT(g_zns_cmd.payload_size == report_size);
+	SPDK_CU_ASSERT_FATAL(g_zns_cmd.payload != NULL);
+
+	report = g_zns_cmd.payload;
+	report->nr_zones = 2;
+	ut_set_zone_desc(&report->descs[0], 2 * 1024, SPDK_NVME_ZONE_STATE_FULL);
+	ut_set_zone_desc(&report->descs[1], 3 * 1024, SPDK_NVME_ZONE_STATE_IOPEN);
+	ut_zns_cmd_complete(&cpl);
+	CU_ASSERT(g_io_cpl.num_completions == 0);
+	CU_ASSERT(g_zns_cmd.slba == 4 * 1024);
+
+	report = g_zns_cmd.payload;
+	report->nr_zones = 1;
+	ut_set_zone_desc(&report->descs[0], 4 * 1024, SPDK_NVME_ZONE_STATE_EMPTY);
+	ut_zns_cmd_complete(&cpl);
+	CU_ASSERT(g_io_cpl.num_completions == 1);
+	CU_ASSERT(g_io_cpl.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(g_io_cpl.sc == SPDK_NVME_SC_SUCCESS);
+	CU_ASSERT(bio->zone_report_buf == NULL);
+
+	CU_ASSERT(info[0].zone_id == 2 * 1024);
+	CU_ASSERT(info[0].state == SPDK_BDEV_ZONE_STATE_FULL);
+	CU_ASSERT(info[1].zone_id == 3 * 1024);
+	CU_ASSERT(info[1].state == SPDK_BDEV_ZONE_STATE_OPEN);
+	CU_ASSERT(info[2].zone_id == 4 * 1024);
+	CU_ASSERT(info[2].state == SPDK_BDEV_ZONE_STATE_EMPTY);
+
+	/* An empty report fails the request */
+	memset(&g_io_cpl, 0, sizeof(g_io_cpl));
+	rc = bdev_nvme_get_zone_info(&g_nbdev, &g_qpair, bio, 2 * 1024, 3, info);
+	CU_ASSERT(rc == 0);
+	ut_zns_cmd_complete(&cpl);
+	CU_ASSERT(g_io_cpl.num_completions == 1);
+	CU_ASSERT(g_io_cpl.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(g_io_cpl.sc == SPDK_NVME_SC_INTERNAL_DEVICE_ERROR);
+	CU_ASSERT(bio->zone_report_buf == NULL);
+
+	/* So does a failed report command, with its status */
+	memset(&g_io_cpl, 0, sizeof(g_io_cpl));
+	rc = bdev_nvme_get_zone_info(&g_nbdev, &g_qpair, bio, 2 * 1024, 1, info);
+	CU_ASSERT(rc == 0);
+	cpl.status.sct = SPDK_NVME_SCT_COMMAND_SPECIFIC;
+	cpl.status.sc = SPDK_NVME_SC_INVALID_FIELD;
+	ut_zns_cmd_complete(&cpl);
+	CU_ASSERT(g_io_cpl.num_completions == 1);
+	CU_ASSERT(g_io_cpl.sct == SPDK_NVME_SCT_COMMAND_SPECIFIC);
+	CU_ASSERT(g_io_cpl.sc == SPDK_NVME_SC_INVALID_FIELD);
+	CU_ASSERT(bio->zone_report_buf == NULL);
+
+	MOCK_CLEAR(spdk_nvme_ns_get_max_io_xfer_size);
+	free(bdev_io);
+}
+
+static void
+test_zone_management(void)
+{
+	static const struct {
+		enum spdk_bdev_zone_action		action;
+		enum spdk_nvme_zns_zone_send_action	nvme_action;
+	} actions[] = {
+		{ SPDK_BDEV_ZONE_CLOSE, SPDK_NVME_ZONE_CLOSE },
+		{ SPDK_BDEV_ZONE_FINISH, SPDK_NVME_ZONE_FINISH },
+		{ SPDK_BDEV_ZONE_OPEN, SPDK_NVME_ZONE_OPEN },
+		{ SPDK_BDEV_ZONE_RESET, SPDK_NVME_ZONE_RESET },
+	};
+	struct spdk_bdev_io *bdev_io;
+	struct nvme_bdev_io *bio;
+	struct spdk_nvme_cpl cpl = {};
+	size_t i;
+	int rc;
+
+	bdev_io = ut_alloc_bdev_io();
+	bio = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+
+	for (i = 0; i < SPDK_COUNTOF(actions); i++) {
+		memset(&g_zns_cmd, 0, sizeof(g_zns_cmd));
+		memset(&g_io_cpl, 0, sizeof(g_io_cpl));
+
+		rc = bdev_nvme_zone_management(&g_nbdev, &g_qpair, bio, 3 * 1024,
+					       actions[i].action);
+		CU_ASSERT(rc == 0);
+		CU_ASSERT(g_zns_cmd.action == (int)actions[i].nvme_action);
+		CU_ASSERT(g_zns_cmd.slba == 3 * 1024);
+		CU_ASSERT(g_zns_cmd.select_all == false);
+		CU_ASSERT(g_zns_cmd.cb_arg == bio);
+
+		cpl.status.sct = SPDK_NVME_SCT_COMMAND_SPECIFIC;
+		cpl.status.sc = SPDK_NVME_SC_INVALID_ZONE_STATE_TRANSITION;
+		ut_zns_cmd_complete(&cpl);
+		CU_ASSERT(g_io_cpl.num_completions == 1);
+		CU_ASSERT(g_io_cpl.sct == SPDK_NVME_SCT_COMMAND_SPECIFIC);
+		CU_ASSERT(g_io_cpl.sc == SPDK_NVME_SC_INVALID_ZONE_STATE_TRANSITION);
+	}
+
+	rc = bdev_nvme_zone_management(&g_nbdev, &g_qpair, bio, 3 * 1024,
+				       (enum spdk_bdev_zone_action)0xff);
+	CU_ASSERT(rc == -EINVAL);
+
+	free(bdev_io);
+}
+
+static void
+test_zone_append(void)
+{
+	struct spdk_bdev_io *bdev_io;
+	struct nvme_bdev_io *bio;
+	struct spdk_nvme_cpl cpl = {};
+	struct iovec iov = {};
+	int rc;
+
+	bdev_io = ut_alloc_bdev_io();
+	bio = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+
+	/* The I/O is submitted at the start of the zone */
+	bdev_io->u.bdev.offset_blocks = 0x1234 * 1024;
+	rc = bdev_nvme_zone_appendv(&g_nbdev, &g_qpair, bio, &iov, 1, NULL, 8, 0x1234 * 1024);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_zns_cmd.slba == 0x1234 * 1024);
+	CU_ASSERT(g_zns_cmd.lba_count == 8);
+	CU_ASSERT(g_zns_cmd.cb_arg == bio);
+
+	/* The completion reports the LBA the data was written at in dwords 0 and 1 */
+	cpl.cdw0 = 0x00490010;
+	cpl.rsvd1 = 0x1;
+	ut_zns_cmd_complete(&cpl);
+	CU_ASSERT(bdev_io->u.bdev.offset_blocks == 0x100490010ULL);
+	CU_ASSERT(g_io_cpl.num_completions == 1);
+	CU_ASSERT(g_io_cpl.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(g_io_cpl.sc == SPDK_NVME_SC_SUCCESS);
+
+	free(bdev_io);
+}
+
+static int
+ut_nvme_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	struct nvme_io_channel *nvme_ch = ctx_buf;
+
+	TAILQ_INIT(&nvme_ch->pending_resets);
+
+	return 0;
+}
+
+static void
+ut_nvme_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+static void
+ut_reset_shared_qpairs(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, struct spdk_bdev_io *bdev_io)
+{
+	struct nvme_bdev_io *bio;
+	size_t i;
+
+	g_num_ctrlr_resets = 0;
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+
+	set_thread(0);
+	bio = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+	CU_ASSERT(bdev_nvme_reset(nvme_bdev_ctrlr, bio) == 0);
+	poll_threads();
+
+	/* Each qpair was disconnected and reconnected by its owner */
+	for (i = 0; i < SPDK_COUNTOF(g_shared_qpairs); i++) {
+		CU_ASSERT(!g_shared_qpairs[i].resetting);
+		CU_ASSERT(g_shared_qpairs[i].ref == 1);
+		CU_ASSERT(!g_shared_nvme_qpairs[i].disconnected);
+		CU_ASSERT(g_shared_nvme_qpairs[i].thread == g_ut_threads[i].thread);
+	}
+	CU_ASSERT(!nvme_bdev_ctrlr->resetting);
+}
+
+static void
+test_reset_shared_qpairs(void)
+{
+	struct nvme_bdev_ctrlr nvme_bdev_ctrlr = {};
+	struct spdk_io_channel *ch[2];
+	struct nvme_io_channel *nvme_ch;
+	struct spdk_bdev_io *bdev_io;
+	size_t i;
+
+	allocate_threads(2);
+	set_thread(0);
+
+	nvme_bdev_ctrlr.ctrlr = (struct spdk_nvme_ctrlr *)0xDEADBEEF;
+	TAILQ_INIT(&nvme_bdev_ctrlr.shared_qpairs);
+	spdk_io_device_register(&nvme_bdev_ctrlr, ut_nvme_ch_create_cb, ut_nvme_ch_destroy_cb,
+				sizeof(struct nvme_io_channel), NULL);
+
+	/* Each thread owns a shared qpair and has a channel using it */
+	for (i = 0; i < SPDK_COUNTOF(g_shared_qpairs); i++) {
+		memset(&g_shared_nvme_qpairs[i], 0, sizeof(g_shared_nvme_qpairs[i]));
+		memset(&g_shared_qpairs[i], 0, sizeof(g_shared_qpairs[i]));
+		g_shared_qpairs[i].qpair = &g_shared_nvme_qpairs[i];
+		g_shared_qpairs[i].nvme_bdev_ctrlr = &nvme_bdev_ctrlr;
+		g_shared_qpairs[i].thread = g_ut_threads[i].thread;
+		g_shared_qpairs[i].ref = 1;
+		TAILQ_INIT(&g_shared_qpairs[i].stages);
+		TAILQ_INIT(&g_shared_qpairs[i].queued_ios);
+		TAILQ_INSERT_TAIL(&nvme_bdev_ctrlr.shared_qpairs, &g_shared_qpairs[i], tailq);
+
+		set_thread(i);
+		ch[i] = spdk_get_io_channel(&nvme_bdev_ctrlr);
+		SPDK_CU_ASSERT_FATAL(ch[i] != NULL);
+		nvme_ch = spdk_io_channel_get_ctx(ch[i]);
+		nvme_ch->shared_qpair = &g_shared_qpairs[i];
+		nvme_ch->qpair = &g_shared_nvme_qpairs[i];
+	}
+
+	bdev_io = ut_alloc_bdev_io();
+
+	ut_reset_shared_qpairs(&nvme_bdev_ctrlr, bdev_io);
+	CU_ASSERT(g_num_ctrlr_resets == 1);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* A failed reset still lets the owners reconnect */
+	g_ctrlr_reset_rc = -1;
+	ut_reset_shared_qpairs(&nvme_bdev_ctrlr, bdev_io);
+	CU_ASSERT(g_num_ctrlr_resets == 1);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_FAILED);
+	g_ctrlr_reset_rc = 0;
+
+	/* So does a failure to reconnect, which fails the reset */
+	g_reconnect_rc = -EAGAIN;
+	ut_reset_shared_qpairs(&nvme_bdev_ctrlr, bdev_io);
+	CU_ASSERT(g_num_ctrlr_resets == 1);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_FAILED);
+	g_reconnect_rc = 0;
+
+	free(bdev_io);
+
+	for (i = 0; i < SPDK_COUNTOF(g_shared_qpairs); i++) {
+		set_thread(i);
+		spdk_put_io_channel(ch[i]);
+	}
+	poll_threads();
+
+	set_thread(0);
+	spdk_io_device_unregister(&nvme_bdev_ctrlr, NULL);
+	poll_threads();
+
+	free_threads();
+}
+
+int
+main(int argc, const char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+	struct nvme_io_channel *nvme_ch;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("nvme", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_fill_zone_info);
+	CU_ADD_TEST(suite, test_get_zone_info);
+	CU_ADD_TEST(suite, test_zone_management);
+	CU_ADD_TEST(suite, test_zone_append);
+	CU_ADD_TEST(suite, test_reset_shared_qpairs);
+
+	g_io_channel = calloc(1, sizeof(*g_io_channel) + sizeof(*nvme_ch));
+	SPDK_CU_ASSERT_FATAL(g_io_channel != NULL);
+	nvme_ch = spdk_io_channel_get_ctx(g_io_channel);
+	nvme_ch->qpair = &g_qpair;
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+
+	free(g_io_channel);
+	CU_cleanup_registry();
+
+	return num_failures;
+}
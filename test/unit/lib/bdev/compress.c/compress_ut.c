@@ -261,6 +261,16 @@ spdk_reduce_vol_readv(struct spdk_reduce_vol *vol, struct iovec *iov, int iovcnt
 
 #include "bdev/compress/vbdev_compress.c"
 
+DEFINE_STUB(comp_sw_vol_init, int, (struct comp_sw_vol *vol, comp_sw_resume_fn resume_fn,
+				    void *resume_arg), 0);
+DEFINE_STUB_V(comp_sw_vol_fini, (struct comp_sw_vol *vol));
+DEFINE_STUB(comp_sw_submit, int, (struct comp_sw_vol *vol, bool compress,
+				  struct iovec *src_iovs, int src_iovcnt,
+				  struct iovec *dst_iovs, int dst_iovcnt,
+				  comp_sw_done_fn cb_fn, void *cb_arg), 0);
+DEFINE_STUB_V(comp_sw_vol_dump_stats, (const struct comp_sw_vol *vol,
+				       struct spdk_json_write_ctx *w));
+
 /* SPDK stubs */
 DEFINE_STUB(spdk_bdev_get_aliases, const struct spdk_bdev_aliases_list *,
 	    (const struct spdk_bdev *bdev), NULL);
@@ -539,6 +549,7 @@ test_setup(void)
 
 	g_comp_bdev.device_qp = &g_device_qp;
 	g_comp_bdev.device_qp->device = &g_device;
+	g_comp_bdev.drv_name = ISAL_PMD;
 
 	TAILQ_INIT(&g_comp_bdev.queued_comp_ops);
 
@@ -1107,6 +1118,79 @@ test_initdrivers(void)
 	spdk_mempool_free((struct spdk_mempool *)g_mbuf_mp);
 }
 
+static int ut_sw_done_errno;
+static int ut_sw_done_count;
+static void
+_sw_done(void *cb_arg, int reduce_errno)
+{
+	ut_sw_done_errno = reduce_errno;
+	ut_sw_done_count++;
+}
+
+static void
+test_sw_operation(void)
+{
+	struct iovec src_iovs[1] = {};
+	struct iovec dst_iovs[1] = {};
+	struct spdk_reduce_vol_cb_args cb_arg = { .cb_fn = _sw_done };
+
+	g_comp_bdev.drv_name = SW_PMD;
+
+	/* Chunks the software path declines to compress are handed back to reduce. */
+	ut_sw_done_count = 0;
+	MOCK_SET(comp_sw_submit, -ENOSPC);
+	_comp_reduce_compress(&g_comp_bdev.backing_dev, src_iovs, 1, dst_iovs, 1, &cb_arg);
+	CU_ASSERT(ut_sw_done_count == 1);
+	CU_ASSERT(ut_sw_done_errno == -ENOSPC);
+
+	/* Submitted operations complete later through the worker, not inline. */
+	ut_sw_done_count = 0;
+	MOCK_SET(comp_sw_submit, 0);
+	_comp_reduce_compress(&g_comp_bdev.backing_dev, src_iovs, 1, dst_iovs, 1, &cb_arg);
+	_comp_reduce_decompress(&g_comp_bdev.backing_dev, src_iovs, 1, dst_iovs, 1, &cb_arg);
+	CU_ASSERT(ut_sw_done_count == 0);
+
+	/* Operations that find the task pool exhausted are queued, not stored raw. */
+	MOCK_SET(comp_sw_submit, -ENOMEM);
+	_comp_reduce_compress(&g_comp_bdev.backing_dev, src_iovs, 1, dst_iovs, 1, &cb_arg);
+	_comp_reduce_decompress(&g_comp_bdev.backing_dev, src_iovs, 1, dst_iovs, 1, &cb_arg);
+	CU_ASSERT(ut_sw_done_count == 0);
+	CU_ASSERT(!TAILQ_EMPTY(&g_comp_bdev.queued_comp_ops));
+
+	/* Still no task, the resubmitted operation stays queued. */
+	_comp_sw_resume(&g_comp_bdev);
+	CU_ASSERT(ut_sw_done_count == 0);
+	CU_ASSERT(!TAILQ_EMPTY(&g_comp_bdev.queued_comp_ops));
+
+	/* One operation is resubmitted per freed task. */
+	MOCK_SET(comp_sw_submit, 0);
+	_comp_sw_resume(&g_comp_bdev);
+	CU_ASSERT(!TAILQ_EMPTY(&g_comp_bdev.queued_comp_ops));
+	_comp_sw_resume(&g_comp_bdev);
+	CU_ASSERT(TAILQ_EMPTY(&g_comp_bdev.queued_comp_ops));
+	_comp_sw_resume(&g_comp_bdev);
+	CU_ASSERT(ut_sw_done_count == 0);
+
+	/* A resubmitted compress that is declined goes back to reduce. */
+	MOCK_SET(comp_sw_submit, -ENOMEM);
+	_comp_reduce_compress(&g_comp_bdev.backing_dev, src_iovs, 1, dst_iovs, 1, &cb_arg);
+	MOCK_SET(comp_sw_submit, -ENOSPC);
+	_comp_sw_resume(&g_comp_bdev);
+	CU_ASSERT(TAILQ_EMPTY(&g_comp_bdev.queued_comp_ops));
+	CU_ASSERT(ut_sw_done_count == 1);
+	CU_ASSERT(ut_sw_done_errno == -ENOSPC);
+
+	/* A decompress that cannot be submitted fails the read. */
+	ut_sw_done_count = 0;
+	MOCK_SET(comp_sw_submit, -EINVAL);
+	_comp_reduce_decompress(&g_comp_bdev.backing_dev, src_iovs, 1, dst_iovs, 1, &cb_arg);
+	CU_ASSERT(ut_sw_done_count == 1);
+	CU_ASSERT(ut_sw_done_errno == -EINVAL);
+
+	MOCK_CLEAR(comp_sw_submit);
+	g_comp_bdev.drv_name = ISAL_PMD;
+}
+
 static void
 test_supported_io(void)
 {
@@ -1131,6 +1215,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_supported_io);
 	CU_ADD_TEST(suite, test_poller);
 	CU_ADD_TEST(suite, test_reset);
+	CU_ADD_TEST(suite, test_sw_operation);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -0,0 +1,346 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk_cunit.h"
+
+#include "common/lib/ut_multithread.c"
+#include "unit/lib/json_mock.c"
+
+#include "bdev/compress/vbdev_compress_sw.c"
+
+#define CHUNK_SIZE	(16 * 1024)
+#define IOV_SIZE	4096
+#define NUM_IOVS	(CHUNK_SIZE / IOV_SIZE)
+
+static struct comp_sw_vol g_vol;
+static int g_done_count;
+static int g_done_rc;
+static int g_resume_count;
+static int g_done_count_at_resume;
+
+static void
+ut_done(void *cb_arg, int rc)
+{
+	CU_ASSERT(cb_arg == &g_vol);
+	g_done_count++;
+	g_done_rc = rc;
+}
+
+static void
+ut_resume(void *resume_arg)
+{
+	CU_ASSERT(resume_arg == &g_vol);
+	if (g_resume_count++ == 0) {
+		g_done_count_at_resume = g_done_count;
+	}
+}
+
+/* The workers are not ut threads, poll them along with the submitting thread. */
+static void
+poll_workers(void)
+{
+	bool busy;
+	uint32_t i;
+
+	do {
+		busy = false;
+		for (i = 0; i < g_num_workers; i++) {
+			if (spdk_thread_poll(g_workers[i]->thread, 0, 0) > 0) {
+				busy = true;
+			}
+		}
+		busy |= poll_thread(0);
+	} while (busy);
+}
+
+static void
+ut_vol_init(void)
+{
+	g_done_count = 0;
+	g_resume_count = 0;
+	memset(&g_vol, 0, sizeof(g_vol));
+	CU_ASSERT(comp_sw_vol_init(&g_vol, ut_resume, &g_vol) == 0);
+	CU_ASSERT(g_num_workers > 0);
+}
+
+static void
+ut_vol_fini(void)
+{
+	struct spdk_thread *threads[COMP_SW_MAX_WORKERS];
+	uint32_t i, num_threads = g_num_workers;
+
+	for (i = 0; i < num_threads; i++) {
+		threads[i] = g_workers[i]->thread;
+	}
+
+	comp_sw_vol_fini(&g_vol);
+	CU_ASSERT(g_workers == NULL);
+
+	for (i = 0; i < num_threads; i++) {
+		while (!spdk_thread_is_exited(threads[i])) {
+			spdk_thread_poll(threads[i], 0, 0);
+		}
+		spdk_thread_destroy(threads[i]);
+	}
+}
+
+static void
+fill_compressible(uint8_t *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		buf[i] = (i / 64) % 7 + 'a';
+	}
+}
+
+static void
+fill_random(uint8_t *buf, size_t len)
+{
+	size_t i;
+
+	srand(0);
+	for (i = 0; i < len; i++) {
+		buf[i] = rand();
+	}
+}
+
+static void
+test_select_level(void)
+{
+	int i;
+
+	memset(&g_vol, 0, sizeof(g_vol));
+
+	/* Compressible data gets the better ratio of level 1. */
+	g_vol.ratio = 0;
+	CU_ASSERT(_comp_sw_select_level(&g_vol) == 1);
+	g_vol.ratio = COMP_SW_RATIO_FAST - 1;
+	CU_ASSERT(_comp_sw_select_level(&g_vol) == 1);
+
+	/* Level 0 until it is no longer worth compressing at all. */
+	g_vol.ratio = COMP_SW_RATIO_FAST;
+	CU_ASSERT(_comp_sw_select_level(&g_vol) == 0);
+	g_vol.ratio = COMP_SW_RATIO_RAW - 1;
+	CU_ASSERT(_comp_sw_select_level(&g_vol) == 0);
+	CU_ASSERT(g_vol.skip_count == 0);
+
+	/* Raw, except for one probe at level 0 every COMP_SW_PROBE_INTERVAL chunks. */
+	g_vol.ratio = COMP_SW_RATIO_RAW;
+	for (i = 1; i < COMP_SW_PROBE_INTERVAL; i++) {
+		CU_ASSERT(_comp_sw_select_level(&g_vol) == COMP_SW_LEVEL_RAW);
+		CU_ASSERT(g_vol.skip_count == (uint32_t)i);
+	}
+	CU_ASSERT(_comp_sw_select_level(&g_vol) == 0);
+	CU_ASSERT(g_vol.skip_count == 0);
+	CU_ASSERT(_comp_sw_select_level(&g_vol) == COMP_SW_LEVEL_RAW);
+}
+
+static void
+test_round_trip(void)
+{
+	const uint32_t ratios[] = { 0, COMP_SW_RATIO_FAST };
+	const int levels[] = { 1, 0 };
+	uint8_t *data, *comp, *out;
+	struct iovec data_iovs[NUM_IOVS], comp_iov, out_iovs[NUM_IOVS];
+	uint32_t i, j;
+	int comp_len;
+
+	data = calloc(1, CHUNK_SIZE);
+	comp = calloc(1, CHUNK_SIZE);
+	out = calloc(1, CHUNK_SIZE);
+	SPDK_CU_ASSERT_FATAL(data != NULL && comp != NULL && out != NULL);
+	for (i = 0; i < NUM_IOVS; i++) {
+		data_iovs[i].iov_base = data + i * IOV_SIZE;
+		data_iovs[i].iov_len = IOV_SIZE;
+		out_iovs[i].iov_base = out + i * IOV_SIZE;
+		out_iovs[i].iov_len = IOV_SIZE;
+	}
+
+	set_thread(0);
+	ut_vol_init();
+	fill_compressible(data, CHUNK_SIZE);
+
+	for (i = 0; i < SPDK_COUNTOF(ratios); i++) {
+		/* Compress from scattered buffers into one. */
+		g_vol.ratio = ratios[i];
+		g_done_count = 0;
+		comp_iov.iov_base = comp;
+		comp_iov.iov_len = CHUNK_SIZE;
+		CU_ASSERT(comp_sw_submit(&g_vol, true, data_iovs, NUM_IOVS, &comp_iov, 1,
+					 ut_done, &g_vol) == 0);
+		CU_ASSERT(g_done_count == 0);
+		poll_workers();
+		CU_ASSERT(g_done_count == 1);
+		CU_ASSERT(g_done_rc > 0 && g_done_rc < CHUNK_SIZE / 4);
+		/* The task that just completed is back at the head of the pool. */
+		CU_ASSERT(TAILQ_FIRST(&g_vol.free_tasks)->level == levels[i]);
+		CU_ASSERT(g_vol.stats.chunks_compressed == i + 1);
+		comp_len = g_done_rc;
+
+		/* And back into scattered buffers. */
+		memset(out, 0, CHUNK_SIZE);
+		comp_iov.iov_len = comp_len;
+		CU_ASSERT(comp_sw_submit(&g_vol, false, &comp_iov, 1, out_iovs, NUM_IOVS,
+					 ut_done, &g_vol) == 0);
+		poll_workers();
+		CU_ASSERT(g_done_count == 2);
+		CU_ASSERT(g_done_rc == CHUNK_SIZE);
+		CU_ASSERT(memcmp(data, out, CHUNK_SIZE) == 0);
+		CU_ASSERT(g_vol.stats.chunks_decompressed == i + 1);
+
+		/* A truncated chunk is an error, not short data. */
+		comp_iov.iov_len = comp_len / 2;
+		CU_ASSERT(comp_sw_submit(&g_vol, false, &comp_iov, 1, out_iovs, NUM_IOVS,
+					 ut_done, &g_vol) == 0);
+		poll_workers();
+		CU_ASSERT(g_done_count == 3);
+		CU_ASSERT(g_done_rc == -EIO);
+	}
+
+	/* The ratio of compressible data pulls the volume towards level 1. */
+	CU_ASSERT(g_vol.ratio < COMP_SW_RATIO_FAST);
+
+	/* Data that does not fit back into a chunk is left for reduce to store raw. */
+	fill_random(data, CHUNK_SIZE);
+	g_vol.ratio = 0;
+	g_done_count = 0;
+	comp_iov.iov_base = comp;
+	comp_iov.iov_len = CHUNK_SIZE;
+	for (j = 0; j < 32 && g_vol.ratio < COMP_SW_RATIO_RAW; j++) {
+		CU_ASSERT(comp_sw_submit(&g_vol, true, data_iovs, NUM_IOVS, &comp_iov, 1,
+					 ut_done, &g_vol) == 0);
+		poll_workers();
+		CU_ASSERT(g_done_rc == -ENOSPC);
+	}
+	CU_ASSERT(g_vol.ratio >= COMP_SW_RATIO_RAW);
+	CU_ASSERT(g_done_count == (int)j);
+	CU_ASSERT(g_vol.stats.chunks_raw == j);
+
+	/* Which then stops handing such data to the workers. */
+	CU_ASSERT(comp_sw_submit(&g_vol, true, data_iovs, NUM_IOVS, &comp_iov, 1,
+				 ut_done, &g_vol) == -ENOSPC);
+	CU_ASSERT(g_vol.stats.chunks_skipped == 1);
+	CU_ASSERT(g_vol.stats.chunks_raw == j + 1);
+	CU_ASSERT(g_done_count == (int)j);
+
+	ut_vol_fini();
+	set_thread(INVALID_THREAD);
+
+	free(data);
+	free(comp);
+	free(out);
+}
+
+static void
+test_pool_exhausted(void)
+{
+	uint8_t *data, *comp;
+	struct iovec data_iov, comp_iov;
+	int i;
+
+	data = calloc(1, IOV_SIZE);
+	comp = calloc(1, IOV_SIZE);
+	SPDK_CU_ASSERT_FATAL(data != NULL && comp != NULL);
+	fill_compressible(data, IOV_SIZE);
+	data_iov.iov_base = data;
+	data_iov.iov_len = IOV_SIZE;
+	comp_iov.iov_base = comp;
+	comp_iov.iov_len = IOV_SIZE;
+
+	set_thread(0);
+	ut_vol_init();
+
+	for (i = 0; i < COMP_SW_NUM_TASKS; i++) {
+		CU_ASSERT(comp_sw_submit(&g_vol, true, &data_iov, 1, &comp_iov, 1,
+					 ut_done, &g_vol) == 0);
+	}
+	CU_ASSERT(TAILQ_EMPTY(&g_vol.free_tasks));
+
+	/* No task left, the caller has to queue the operation. */
+	CU_ASSERT(comp_sw_submit(&g_vol, true, &data_iov, 1, &comp_iov, 1,
+				 ut_done, &g_vol) == -ENOMEM);
+	CU_ASSERT(comp_sw_submit(&g_vol, false, &comp_iov, 1, &data_iov, 1,
+				 ut_done, &g_vol) == -ENOMEM);
+	CU_ASSERT(g_vol.stats.chunks_raw == 0);
+
+	/* Waiting for a task does not use up the probe of an incompressible volume. */
+	g_vol.ratio = COMP_SW_RATIO_RAW;
+	g_vol.skip_count = COMP_SW_PROBE_INTERVAL - 1;
+	CU_ASSERT(comp_sw_submit(&g_vol, true, &data_iov, 1, &comp_iov, 1,
+				 ut_done, &g_vol) == -ENOMEM);
+	CU_ASSERT(g_vol.skip_count == COMP_SW_PROBE_INTERVAL - 1);
+	g_vol.ratio = 0;
+	g_vol.skip_count = 0;
+
+	/* Every task returned to the pool resumes the caller, ahead of its completion. */
+	CU_ASSERT(g_resume_count == 0);
+	poll_workers();
+	CU_ASSERT(g_done_count == COMP_SW_NUM_TASKS);
+	CU_ASSERT(g_resume_count == COMP_SW_NUM_TASKS);
+	CU_ASSERT(g_done_count_at_resume == 0);
+	CU_ASSERT(g_done_rc > 0);
+
+	ut_vol_fini();
+	set_thread(INVALID_THREAD);
+
+	free(data);
+	free(comp);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("compress_sw", NULL, NULL);
+	CU_ADD_TEST(suite, test_select_level);
+	CU_ADD_TEST(suite, test_round_trip);
+	CU_ADD_TEST(suite, test_pool_exhausted);
+
+	allocate_threads(1);
+	set_thread(0);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	free_threads();
+
+	return num_failures;
+}
@@ -208,6 +208,55 @@ DEFINE_STUB(rte_vdev_uninit, int, (const char *name), 0);
 
 struct rte_cryptodev *rte_cryptodevs;
 
+/* ipsec-mb stubs */
+DEFINE_STUB(crypto_ipsec_mb_key_create, struct crypto_ipsec_mb_key *, (const char *cipher,
+		const uint8_t *key, const uint8_t *key2), NULL);
+DEFINE_STUB_V(crypto_ipsec_mb_key_free, (struct crypto_ipsec_mb_key *key));
+DEFINE_STUB(crypto_ipsec_mb_mgr_create, struct crypto_ipsec_mb_mgr *, (crypto_ipsec_mb_cb cb_fn),
+	    NULL);
+DEFINE_STUB_V(crypto_ipsec_mb_mgr_free, (struct crypto_ipsec_mb_mgr *mgr));
+
+/* Blocks are only recorded on submit and handed back on flush, like the
+ * multi-buffer manager does when its lanes are not full.
+ */
+#define UT_MAX_SW_JOBS 16
+struct ut_sw_job {
+	bool encrypt;
+	const void *src;
+	void *dst;
+	uint64_t lba;
+	void *cb_arg;
+} g_ut_sw_jobs[UT_MAX_SW_JOBS];
+int g_ut_sw_submitted;
+int g_ut_sw_flushed;
+
+int
+crypto_ipsec_mb_submit(struct crypto_ipsec_mb_mgr *mgr, struct crypto_ipsec_mb_key *key,
+		       bool encrypt, const void *src, void *dst, uint32_t len,
+		       uint64_t lba, void *cb_arg)
+{
+	SPDK_CU_ASSERT_FATAL(g_ut_sw_submitted < UT_MAX_SW_JOBS);
+	g_ut_sw_jobs[g_ut_sw_submitted].encrypt = encrypt;
+	g_ut_sw_jobs[g_ut_sw_submitted].src = src;
+	g_ut_sw_jobs[g_ut_sw_submitted].dst = dst;
+	g_ut_sw_jobs[g_ut_sw_submitted].lba = lba;
+	g_ut_sw_jobs[g_ut_sw_submitted].cb_arg = cb_arg;
+	g_ut_sw_submitted++;
+	return 0;
+}
+
+int
+crypto_ipsec_mb_flush(struct crypto_ipsec_mb_mgr *mgr)
+{
+	int count = 0;
+
+	while (g_ut_sw_flushed < g_ut_sw_submitted) {
+		_crypto_sw_block_done(g_ut_sw_jobs[g_ut_sw_flushed++].cb_arg, 0);
+		count++;
+	}
+	return count;
+}
+
 /* global vars and setup/cleanup functions used for all test functions */
 struct spdk_bdev_io *g_bdev_io;
 struct crypto_bdev_io *g_io_ctx;
@@ -1002,6 +1051,77 @@ _check_expected_values(struct vbdev_crypto *crypto_bdev, struct device_qp *devic
 	CU_ASSERT(g_next_qat_index == current_index);
 }
 
+static void
+test_ipsec_mb(void)
+{
+	struct crypto_ipsec_mb_mgr *mgr = (struct crypto_ipsec_mb_mgr *)0xDEADBEEF;
+	int rc;
+
+	g_crypto_ch->mb_mgr = mgr;
+	TAILQ_INIT(&g_crypto_ch->pending_cry_ios);
+	TAILQ_INIT(&g_crypto_ch->queued_sw_ios);
+	g_crypto_bdev.crypto_bdev.blocklen = 512;
+	g_ut_sw_submitted = g_ut_sw_flushed = 0;
+
+	/* Two block read over two iovs, decrypted in place once the poller runs. */
+	g_bdev_io->internal.status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	g_bdev_io->type = SPDK_BDEV_IO_TYPE_READ;
+	g_bdev_io->u.bdev.iovcnt = 2;
+	g_bdev_io->u.bdev.num_blocks = 2;
+	g_bdev_io->u.bdev.offset_blocks = 10;
+	g_bdev_io->u.bdev.iovs[0].iov_len = 512;
+	g_bdev_io->u.bdev.iovs[0].iov_base = (void *)0x10000;
+	g_bdev_io->u.bdev.iovs[1].iov_len = 512;
+	g_bdev_io->u.bdev.iovs[1].iov_base = (void *)0x20000;
+	g_completion_called = false;
+
+	vbdev_crypto_submit_request(g_io_ch, g_bdev_io);
+	CU_ASSERT(g_completion_called == false);
+	CU_ASSERT(g_io_ctx->cryop_cnt_remaining == 2);
+	CU_ASSERT(TAILQ_FIRST(&g_crypto_ch->queued_sw_ios) == g_io_ctx);
+	CU_ASSERT(TAILQ_FIRST(&g_crypto_ch->pending_cry_ios) == g_bdev_io);
+	CU_ASSERT(g_ut_sw_submitted == 0);
+
+	rc = crypto_sw_poller(g_crypto_ch);
+	CU_ASSERT(rc == 2);
+	CU_ASSERT(g_ut_sw_submitted == 2);
+	CU_ASSERT(g_ut_sw_jobs[0].encrypt == false);
+	CU_ASSERT(g_ut_sw_jobs[0].src == (void *)0x10000);
+	CU_ASSERT(g_ut_sw_jobs[0].dst == g_ut_sw_jobs[0].src);
+	CU_ASSERT(g_ut_sw_jobs[0].lba == 10);
+	CU_ASSERT(g_ut_sw_jobs[1].src == (void *)0x20000);
+	CU_ASSERT(g_ut_sw_jobs[1].dst == g_ut_sw_jobs[1].src);
+	CU_ASSERT(g_ut_sw_jobs[1].lba == 11);
+	CU_ASSERT(g_completion_called == true);
+	CU_ASSERT(g_bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(TAILQ_EMPTY(&g_crypto_ch->queued_sw_ios));
+	CU_ASSERT(TAILQ_EMPTY(&g_crypto_ch->pending_cry_ios));
+
+	/* Single block write, encrypted into the aux buffer, not the host buffer. */
+	g_ut_sw_submitted = g_ut_sw_flushed = 0;
+	g_bdev_io->type = SPDK_BDEV_IO_TYPE_WRITE;
+	g_bdev_io->u.bdev.iovcnt = 1;
+	g_bdev_io->u.bdev.num_blocks = 1;
+	g_completion_called = false;
+
+	vbdev_crypto_submit_request(g_io_ch, g_bdev_io);
+	CU_ASSERT(g_completion_called == false);
+	rc = crypto_sw_poller(g_crypto_ch);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(g_ut_sw_submitted == 1);
+	CU_ASSERT(g_ut_sw_jobs[0].encrypt == true);
+	CU_ASSERT(g_ut_sw_jobs[0].src == (void *)0x10000);
+	CU_ASSERT(g_ut_sw_jobs[0].dst == g_io_ctx->aux_buf_iov.iov_base);
+	CU_ASSERT(g_completion_called == true);
+	CU_ASSERT(g_bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* Nothing queued, nothing to do. */
+	rc = crypto_sw_poller(g_crypto_ch);
+	CU_ASSERT(rc == 0);
+
+	g_crypto_ch->mb_mgr = NULL;
+}
+
 static void
 test_assign_device_qp(void)
 {
@@ -1074,6 +1194,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_supported_io);
 	CU_ADD_TEST(suite, test_reset);
 	CU_ADD_TEST(suite, test_poller);
+	CU_ADD_TEST(suite, test_ipsec_mb);
 	CU_ADD_TEST(suite, test_assign_device_qp);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
@@ -0,0 +1,338 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk_cunit.h"
+
+#include "spdk_internal/mock.h"
+
+#include "bdev/crypto/vbdev_crypto_ipsec_mb.c"
+
+/* Known answer tests from IEEE 1619-2007 Annex B, XTS-AES-128. The data unit
+ * sequence number is what the module takes as the LBA.
+ */
+struct xts_vector {
+	uint8_t		key1[IPSEC_MB_KEY_LENGTH];
+	uint8_t		key2[IPSEC_MB_KEY_LENGTH];
+	uint64_t	seq;
+	uint32_t	len;
+	const uint8_t	*ptx;
+	const uint8_t	*ctx;
+};
+
+/* Vectors 1-3 */
+static const uint8_t g_ptx_zero[32] = {0};
+static const uint8_t g_ptx_44[32] = {
+	0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44,
+	0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44,
+	0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44,
+};
+static const uint8_t g_ctx_1[32] = {
+	0x91, 0x7c, 0xf6, 0x9e, 0xbd, 0x68, 0xb2, 0xec, 0x9b, 0x9f, 0xe9, 0xa3,
+	0xea, 0xdd, 0xa6, 0x92, 0xcd, 0x43, 0xd2, 0xf5, 0x95, 0x98, 0xed, 0x85,
+	0x8c, 0x02, 0xc2, 0x65, 0x2f, 0xbf, 0x92, 0x2e,
+};
+static const uint8_t g_ctx_2[32] = {
+	0xc4, 0x54, 0x18, 0x5e, 0x6a, 0x16, 0x93, 0x6e, 0x39, 0x33, 0x40, 0x38,
+	0xac, 0xef, 0x83, 0x8b, 0xfb, 0x18, 0x6f, 0xff, 0x74, 0x80, 0xad, 0xc4,
+	0x28, 0x93, 0x82, 0xec, 0xd6, 0xd3, 0x94, 0xf0,
+};
+static const uint8_t g_ctx_3[32] = {
+	0xaf, 0x85, 0x33, 0x6b, 0x59, 0x7a, 0xfc, 0x1a, 0x90, 0x0b, 0x2e, 0xb2,
+	0x1e, 0xc9, 0x49, 0xd2, 0x92, 0xdf, 0x4c, 0x04, 0x7e, 0x0b, 0x21, 0x53,
+	0x21, 0x86, 0xa5, 0x97, 0x1a, 0x22, 0x7a, 0x89,
+};
+
+/* Vector 4, the plain text is bytes 0x00-0xff twice and is filled in at runtime. */
+static uint8_t g_ptx_4[512];
+static const uint8_t g_ctx_4[512] = {
+	0x27, 0xa7, 0x47, 0x9b, 0xef, 0xa1, 0xd4, 0x76, 0x48, 0x9f, 0x30, 0x8c,
+	0xd4, 0xcf, 0xa6, 0xe2, 0xa9, 0x6e, 0x4b, 0xbe, 0x32, 0x08, 0xff, 0x25,
+	0x28, 0x7d, 0xd3, 0x81, 0x96, 0x16, 0xe8, 0x9c, 0xc7, 0x8c, 0xf7, 0xf5,
+	0xe5, 0x43, 0x44, 0x5f, 0x83, 0x33, 0xd8, 0xfa, 0x7f, 0x56, 0x00, 0x00,
+	0x05, 0x27, 0x9f, 0xa5, 0xd8, 0xb5, 0xe4, 0xad, 0x40, 0xe7, 0x36, 0xdd,
+	0xb4, 0xd3, 0x54, 0x12, 0x32, 0x80, 0x63, 0xfd, 0x2a, 0xab, 0x53, 0xe5,
+	0xea, 0x1e, 0x0a, 0x9f, 0x33, 0x25, 0x00, 0xa5, 0xdf, 0x94, 0x87, 0xd0,
+	0x7a, 0x5c, 0x92, 0xcc, 0x51, 0x2c, 0x88, 0x66, 0xc7, 0xe8, 0x60, 0xce,
+	0x93, 0xfd, 0xf1, 0x66, 0xa2, 0x49, 0x12, 0xb4, 0x22, 0x97, 0x61, 0x46,
+	0xae, 0x20, 0xce, 0x84, 0x6b, 0xb7, 0xdc, 0x9b, 0xa9, 0x4a, 0x76, 0x7a,
+	0xae, 0xf2, 0x0c, 0x0d, 0x61, 0xad, 0x02, 0x65, 0x5e, 0xa9, 0x2d, 0xc4,
+	0xc4, 0xe4, 0x1a, 0x89, 0x52, 0xc6, 0x51, 0xd3, 0x31, 0x74, 0xbe, 0x51,
+	0xa1, 0x0c, 0x42, 0x11, 0x10, 0xe6, 0xd8, 0x15, 0x88, 0xed, 0xe8, 0x21,
+	0x03, 0xa2, 0x52, 0xd8, 0xa7, 0x50, 0xe8, 0x76, 0x8d, 0xef, 0xff, 0xed,
+	0x91, 0x22, 0x81, 0x0a, 0xae, 0xb9, 0x9f, 0x91, 0x72, 0xaf, 0x82, 0xb6,
+	0x04, 0xdc, 0x4b, 0x8e, 0x51, 0xbc, 0xb0, 0x82, 0x35, 0xa6, 0xf4, 0x34,
+	0x13, 0x32, 0xe4, 0xca, 0x60, 0x48, 0x2a, 0x4b, 0xa1, 0xa0, 0x3b, 0x3e,
+	0x65, 0x00, 0x8f, 0xc5, 0xda, 0x76, 0xb7, 0x0b, 0xf1, 0x69, 0x0d, 0xb4,
+	0xea, 0xe2, 0x9c, 0x5f, 0x1b, 0xad, 0xd0, 0x3c, 0x5c, 0xcf, 0x2a, 0x55,
+	0xd7, 0x05, 0xdd, 0xcd, 0x86, 0xd4, 0x49, 0x51, 0x1c, 0xeb, 0x7e, 0xc3,
+	0x0b, 0xf1, 0x2b, 0x1f, 0xa3, 0x5b, 0x91, 0x3f, 0x9f, 0x74, 0x7a, 0x8a,
+	0xfd, 0x1b, 0x13, 0x0e, 0x94, 0xbf, 0xf9, 0x4e, 0xff, 0xd0, 0x1a, 0x91,
+	0x73, 0x5c, 0xa1, 0x72, 0x6a, 0xcd, 0x0b, 0x19, 0x7c, 0x4e, 0x5b, 0x03,
+	0x39, 0x36, 0x97, 0xe1, 0x26, 0x82, 0x6f, 0xb6, 0xbb, 0xde, 0x8e, 0xcc,
+	0x1e, 0x08, 0x29, 0x85, 0x16, 0xe2, 0xc9, 0xed, 0x03, 0xff, 0x3c, 0x1b,
+	0x78, 0x60, 0xf6, 0xde, 0x76, 0xd4, 0xce, 0xcd, 0x94, 0xc8, 0x11, 0x98,
+	0x55, 0xef, 0x52, 0x97, 0xca, 0x67, 0xe9, 0xf3, 0xe7, 0xff, 0x72, 0xb1,
+	0xe9, 0x97, 0x85, 0xca, 0x0a, 0x7e, 0x77, 0x20, 0xc5, 0xb3, 0x6d, 0xc6,
+	0xd7, 0x2c, 0xac, 0x95, 0x74, 0xc8, 0xcb, 0xbc, 0x2f, 0x80, 0x1e, 0x23,
+	0xe5, 0x6f, 0xd3, 0x44, 0xb0, 0x7f, 0x22, 0x15, 0x4b, 0xeb, 0xa0, 0xf0,
+	0x8c, 0xe8, 0x89, 0x1e, 0x64, 0x3e, 0xd9, 0x95, 0xc9, 0x4d, 0x9a, 0x69,
+	0xc9, 0xf1, 0xb5, 0xf4, 0x99, 0x02, 0x7a, 0x78, 0x57, 0x2a, 0xee, 0xbd,
+	0x74, 0xd2, 0x0c, 0xc3, 0x98, 0x81, 0xc2, 0x13, 0xee, 0x77, 0x0b, 0x10,
+	0x10, 0xe4, 0xbe, 0xa7, 0x18, 0x84, 0x69, 0x77, 0xae, 0x11, 0x9f, 0x7a,
+	0x02, 0x3a, 0xb5, 0x8c, 0xca, 0x0a, 0xd7, 0x52, 0xaf, 0xe6, 0x56, 0xbb,
+	0x3c, 0x17, 0x25, 0x6a, 0x9f, 0x6e, 0x9b, 0xf1, 0x9f, 0xdd, 0x5a, 0x38,
+	0xfc, 0x82, 0xbb, 0xe8, 0x72, 0xc5, 0x53, 0x9e, 0xdb, 0x60, 0x9e, 0xf4,
+	0xf7, 0x9c, 0x20, 0x3e, 0xbb, 0x14, 0x0f, 0x2e, 0x58, 0x3c, 0xb2, 0xad,
+	0x15, 0xb4, 0xaa, 0x5b, 0x65, 0x50, 0x16, 0xa8, 0x44, 0x92, 0x77, 0xdb,
+	0xd4, 0x77, 0xef, 0x2c, 0x8d, 0x6c, 0x01, 0x7d, 0xb7, 0x38, 0xb1, 0x8d,
+	0xeb, 0x4a, 0x42, 0x7d, 0x19, 0x23, 0xce, 0x3f, 0xf2, 0x62, 0x73, 0x57,
+	0x79, 0xa4, 0x18, 0xf2, 0x0a, 0x28, 0x2d, 0xf9, 0x20, 0x14, 0x7b, 0xea,
+	0xbe, 0x42, 0x1e, 0xe5, 0x31, 0x9d, 0x05, 0x68,
+};
+
+static const struct xts_vector g_vectors[] = {
+	{
+		.key1 = {0},
+		.key2 = {0},
+		.seq = 0,
+		.len = sizeof(g_ptx_zero),
+		.ptx = g_ptx_zero,
+		.ctx = g_ctx_1,
+	},
+	{
+		.key1 = {
+			0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+		},
+		.key2 = {
+			0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+			0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+		},
+		.seq = 0x3333333333,
+		.len = sizeof(g_ptx_44),
+		.ptx = g_ptx_44,
+		.ctx = g_ctx_2,
+	},
+	{
+		.key1 = {
+			0xff, 0xfe, 0xfd, 0xfc, 0xfb, 0xfa, 0xf9, 0xf8,
+			0xf7, 0xf6, 0xf5, 0xf4, 0xf3, 0xf2, 0xf1, 0xf0,
+		},
+		.key2 = {
+			0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+			0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+		},
+		.seq = 0x3333333333,
+		.len = sizeof(g_ptx_44),
+		.ptx = g_ptx_44,
+		.ctx = g_ctx_3,
+	},
+	{
+		.key1 = {
+			0x27, 0x18, 0x28, 0x18, 0x28, 0x45, 0x90, 0x45,
+			0x23, 0x53, 0x60, 0x28, 0x74, 0x71, 0x35, 0x26,
+		},
+		.key2 = {
+			0x31, 0x41, 0x59, 0x26, 0x53, 0x58, 0x97, 0x93,
+			0x23, 0x84, 0x62, 0x64, 0x33, 0x83, 0x27, 0x95,
+		},
+		.seq = 0,
+		.len = sizeof(g_ptx_4),
+		.ptx = g_ptx_4,
+		.ctx = g_ctx_4,
+	},
+};
+
+static int g_cb_count;
+static int g_cb_status;
+
+static void
+ut_ipsec_mb_cb(void *cb_arg, int status)
+{
+	CU_ASSERT(cb_arg == &g_cb_count);
+	g_cb_count++;
+	if (status != 0) {
+		g_cb_status = status;
+	}
+}
+
+static void
+test_xts_xor_tweak(void)
+{
+	/* E_K2(0) with an all zero key2, the initial tweak of vector 1. */
+	const uint8_t t0[IPSEC_MB_AES_BLOCK] = {
+		0x66, 0xe9, 0x4b, 0xd4, 0xef, 0x8a, 0x2c, 0x3b,
+		0x88, 0x4c, 0xfa, 0x59, 0xca, 0x34, 0x2b, 0x2e,
+	};
+	/* t0 times alpha, then alpha^2. */
+	const uint8_t t1[IPSEC_MB_AES_BLOCK] = {
+		0xcc, 0xd2, 0x97, 0xa8, 0xdf, 0x15, 0x59, 0x76,
+		0x10, 0x99, 0xf4, 0xb3, 0x94, 0x69, 0x56, 0x5c,
+	};
+	const uint8_t t2[IPSEC_MB_AES_BLOCK] = {
+		0x98, 0xa5, 0x2f, 0x51, 0xbf, 0x2b, 0xb2, 0xec,
+		0x20, 0x32, 0xe9, 0x67, 0x29, 0xd3, 0xac, 0xb8,
+	};
+	uint8_t tweak[IPSEC_MB_AES_BLOCK] = {0};
+	uint8_t src[IPSEC_MB_AES_BLOCK * 3] = {0};
+	uint8_t dst[IPSEC_MB_AES_BLOCK * 3];
+	uint32_t i;
+
+	/* Zero data gives back the tweak sequence itself. */
+	_ipsec_mb_xts_xor_tweak(dst, src, sizeof(dst), t0);
+	CU_ASSERT(memcmp(dst, t0, IPSEC_MB_AES_BLOCK) == 0);
+	CU_ASSERT(memcmp(dst + IPSEC_MB_AES_BLOCK, t1, IPSEC_MB_AES_BLOCK) == 0);
+	CU_ASSERT(memcmp(dst + IPSEC_MB_AES_BLOCK * 2, t2, IPSEC_MB_AES_BLOCK) == 0);
+
+	/* The top bit carries out of byte 15 and is reduced by x^7 + x^2 + x + 1. */
+	tweak[15] = 0x80;
+	_ipsec_mb_xts_xor_tweak(dst, src, IPSEC_MB_AES_BLOCK * 2, tweak);
+	CU_ASSERT(memcmp(dst, tweak, IPSEC_MB_AES_BLOCK) == 0);
+	CU_ASSERT(dst[IPSEC_MB_AES_BLOCK] == 0x87);
+	for (i = 1; i < IPSEC_MB_AES_BLOCK; i++) {
+		CU_ASSERT(dst[IPSEC_MB_AES_BLOCK + i] == 0);
+	}
+
+	/* Carry from the low into the high 64 bits. */
+	memset(tweak, 0, sizeof(tweak));
+	tweak[7] = 0x80;
+	_ipsec_mb_xts_xor_tweak(dst, src, IPSEC_MB_AES_BLOCK * 2, tweak);
+	for (i = 0; i < IPSEC_MB_AES_BLOCK; i++) {
+		CU_ASSERT(dst[IPSEC_MB_AES_BLOCK + i] == (i == 8 ? 0x01 : 0));
+	}
+
+	/* Non zero data is XORed with the tweak, and doing it twice is a no-op. */
+	for (i = 0; i < sizeof(src); i++) {
+		src[i] = i;
+	}
+	_ipsec_mb_xts_xor_tweak(dst, src, sizeof(dst), t0);
+	for (i = 0; i < IPSEC_MB_AES_BLOCK; i++) {
+		CU_ASSERT(dst[i] == (src[i] ^ t0[i]));
+		CU_ASSERT(dst[IPSEC_MB_AES_BLOCK + i] == (src[IPSEC_MB_AES_BLOCK + i] ^ t1[i]));
+	}
+	_ipsec_mb_xts_xor_tweak(dst, dst, sizeof(dst), t0);
+	CU_ASSERT(memcmp(dst, src, sizeof(src)) == 0);
+}
+
+static void
+test_xts_kat(void)
+{
+	struct crypto_ipsec_mb_mgr *mgr;
+	struct crypto_ipsec_mb_key *key;
+	const struct xts_vector *v;
+	uint8_t buf[512], out[512];
+	uint32_t i;
+	int rc;
+
+	for (i = 0; i < sizeof(g_ptx_4); i++) {
+		g_ptx_4[i] = i & 0xff;
+	}
+
+	mgr = crypto_ipsec_mb_mgr_create(ut_ipsec_mb_cb);
+	SPDK_CU_ASSERT_FATAL(mgr != NULL);
+
+	for (i = 0; i < SPDK_COUNTOF(g_vectors); i++) {
+		v = &g_vectors[i];
+		SPDK_CU_ASSERT_FATAL(v->len <= sizeof(buf));
+
+		key = crypto_ipsec_mb_key_create(AES_XTS, v->key1, v->key2);
+		SPDK_CU_ASSERT_FATAL(key != NULL);
+
+		/* Encrypt out of place. */
+		g_cb_count = 0;
+		g_cb_status = 0;
+		memset(buf, 0, sizeof(buf));
+		rc = crypto_ipsec_mb_submit(mgr, key, true, v->ptx, buf, v->len, v->seq,
+					    &g_cb_count);
+		CU_ASSERT(rc == 0);
+		crypto_ipsec_mb_flush(mgr);
+		CU_ASSERT(g_cb_count == 1);
+		CU_ASSERT(g_cb_status == 0);
+		CU_ASSERT(memcmp(buf, v->ctx, v->len) == 0);
+
+		/* Decrypt out of place. */
+		g_cb_count = 0;
+		memset(out, 0, sizeof(out));
+		rc = crypto_ipsec_mb_submit(mgr, key, false, buf, out, v->len, v->seq, &g_cb_count);
+		CU_ASSERT(rc == 0);
+		crypto_ipsec_mb_flush(mgr);
+		CU_ASSERT(g_cb_count == 1);
+		CU_ASSERT(g_cb_status == 0);
+		CU_ASSERT(memcmp(out, v->ptx, v->len) == 0);
+
+		/* And in place, the way the bdev issues reads. */
+		g_cb_count = 0;
+		rc = crypto_ipsec_mb_submit(mgr, key, false, buf, buf, v->len, v->seq, &g_cb_count);
+		CU_ASSERT(rc == 0);
+		crypto_ipsec_mb_flush(mgr);
+		CU_ASSERT(g_cb_count == 1);
+		CU_ASSERT(g_cb_status == 0);
+		CU_ASSERT(memcmp(buf, v->ptx, v->len) == 0);
+
+		crypto_ipsec_mb_key_free(key);
+	}
+
+	/* Lengths that are not a multiple of the AES block are rejected. */
+	key = crypto_ipsec_mb_key_create(AES_XTS, g_vectors[0].key1, g_vectors[0].key2);
+	SPDK_CU_ASSERT_FATAL(key != NULL);
+	g_cb_count = 0;
+	rc = crypto_ipsec_mb_submit(mgr, key, true, g_ptx_zero, buf, 0, 0, &g_cb_count);
+	CU_ASSERT(rc == -EINVAL);
+	rc = crypto_ipsec_mb_submit(mgr, key, true, g_ptx_zero, buf, 17, 0, &g_cb_count);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(crypto_ipsec_mb_flush(mgr) == 0);
+	CU_ASSERT(g_cb_count == 0);
+	crypto_ipsec_mb_key_free(key);
+
+	crypto_ipsec_mb_mgr_free(mgr);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("crypto_ipsec_mb", NULL, NULL);
+	CU_ADD_TEST(suite, test_xts_xor_tweak);
+	CU_ADD_TEST(suite, test_xts_kat);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+	return num_failures;
+}
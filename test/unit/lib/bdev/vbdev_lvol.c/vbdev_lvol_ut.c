@@ -210,6 +210,40 @@ spdk_blob_is_thin_provisioned(struct spdk_blob *blob)
 	return false;
 }
 
+bool g_inflate_checkpoint = false;
+int g_inflate_started = 0;
+
+int
+spdk_blob_get_inflate_checkpoint(struct spdk_blob *blob, struct spdk_blob_inflate_opts *opts,
+				 bool *allocate_all)
+{
+	if (!g_inflate_checkpoint) {
+		return -ENOENT;
+	}
+
+	opts->max_clusters_per_sec = 10;
+	opts->max_bytes_per_sec = 0;
+	*allocate_all = true;
+	return 0;
+}
+
+void
+spdk_lvol_inflate_ext(struct spdk_lvol *lvol, const struct spdk_blob_inflate_opts *opts,
+		      spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	CU_ASSERT(opts->max_clusters_per_sec == 10);
+	g_inflate_started++;
+	cb_fn(cb_arg, 0);
+}
+
+void
+spdk_lvol_decouple_parent_ext(struct spdk_lvol *lvol, const struct spdk_blob_inflate_opts *opts,
+			      spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	g_inflate_started++;
+	cb_fn(cb_arg, 0);
+}
+
 static struct spdk_lvol *_lvol_create(struct spdk_lvol_store *lvs);
 
 void
@@ -943,6 +977,22 @@ ut_lvol_examine(void)
 	ut_lvs_examine_check(true);
 	CU_ASSERT(g_registered_bdevs != 0);
 	SPDK_CU_ASSERT_FATAL(!TAILQ_EMPTY(&g_lvol_store->lvols));
+	CU_ASSERT(g_inflate_started == 0);
+	vbdev_lvs_destruct(g_lvol_store, lvol_store_op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+
+	/* Examine successfully, an interrupted inflate is started again */
+	g_lvserrno = 0;
+	g_lvolerrno = 0;
+	g_registered_bdevs = 0;
+	g_inflate_checkpoint = true;
+	lvol_already_opened = false;
+	vbdev_lvs_examine(&g_bdev);
+	ut_lvs_examine_check(true);
+	CU_ASSERT(g_registered_bdevs != 0);
+	CU_ASSERT(g_inflate_started == 1);
+	g_inflate_checkpoint = false;
+	g_inflate_started = 0;
 	vbdev_lvs_destruct(g_lvol_store, lvol_store_op_complete, NULL);
 	CU_ASSERT(g_lvserrno == 0);
 }
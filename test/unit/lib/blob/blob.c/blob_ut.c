@@ -156,6 +156,14 @@ blob_op_complete(void *cb_arg, int bserrno)
 	g_bserrno = bserrno;
 }
 
+static void
+blob_op_rc_complete(void *cb_arg, int bserrno)
+{
+	int *rc = cb_arg;
+
+	*rc = bserrno;
+}
+
 static void
 blob_op_with_id_complete(void *cb_arg, spdk_blob_id blobid, int bserrno)
 {
@@ -1011,6 +1019,270 @@ blob_inflate(void)
 	_blob_inflate(true);
 }
 
+static void
+blob_inflate_throttle(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob_opts opts;
+	struct spdk_blob_inflate_opts inflate_opts;
+	struct spdk_blob_inflate_progress progress;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	spdk_blob_id blobid, snapshotid;
+	uint64_t pages_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_page_size(bs);
+	uint64_t copy_bytes;
+	uint8_t payload[4096];
+	bool allocate_all = false;
+	uint64_t i;
+	int inflate_rc = 1;
+	int rc;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	/* Thin blob with the first half of its clusters written */
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = 10;
+	opts.thin_provision = true;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	memset(payload, 0xAA, sizeof(payload));
+	for (i = 0; i < 5; i++) {
+		spdk_blob_io_write(blob, channel, payload, i * pages_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid = g_blobid;
+
+	rc = spdk_blob_get_inflate_progress(blob, &progress);
+	CU_ASSERT(rc == -ENOENT);
+
+	/* Inflate two clusters per second */
+	spdk_blob_inflate_opts_init(&inflate_opts);
+	inflate_opts.max_clusters_per_sec = 2;
+	copy_bytes = g_dev_copy_bytes;
+
+	spdk_bs_inflate_blob_ext(bs, channel, blobid, &inflate_opts, blob_op_rc_complete,
+				 &inflate_rc);
+	poll_threads();
+	CU_ASSERT(inflate_rc == 1);
+
+	rc = spdk_blob_get_inflate_progress(blob, &progress);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(progress.allocate_all == true);
+	CU_ASSERT(progress.clusters_total == 10);
+	CU_ASSERT(progress.clusters_done == 1);
+
+	/* The operation is recorded in the blob's metadata while it runs */
+	memset(&inflate_opts, 0, sizeof(inflate_opts));
+	rc = spdk_blob_get_inflate_checkpoint(blob, &inflate_opts, &allocate_all);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(allocate_all == true);
+	CU_ASSERT(inflate_opts.max_clusters_per_sec == 2);
+	CU_ASSERT(inflate_opts.max_bytes_per_sec == 0);
+
+	for (i = 2; i <= 10; i++) {
+		spdk_delay_us(500000);
+		poll_threads();
+		rc = spdk_blob_get_inflate_progress(blob, &progress);
+		if (i < 10) {
+			CU_ASSERT(rc == 0);
+			CU_ASSERT(progress.clusters_done == i);
+			CU_ASSERT(progress.elapsed_ticks == (i - 1) * 500000);
+			CU_ASSERT(inflate_rc == 1);
+		}
+	}
+
+	CU_ASSERT(inflate_rc == 0);
+	CU_ASSERT(rc == -ENOENT);
+	rc = spdk_blob_get_inflate_checkpoint(blob, &inflate_opts, &allocate_all);
+	CU_ASSERT(rc == -ENOENT);
+	CU_ASSERT(spdk_blob_is_thin_provisioned(blob) == false);
+
+	/* Only the clusters the snapshot has were copied, the others were zeroed */
+	CU_ASSERT(g_dev_copy_bytes - copy_bytes == 5 * spdk_bs_get_cluster_size(bs));
+
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+}
+
+static void
+blob_inflate_cancel(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_blob_opts opts;
+	struct spdk_blob_inflate_opts inflate_opts;
+	struct spdk_blob_inflate_progress progress;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	spdk_blob_id blobid;
+	uint64_t pages_per_cluster;
+	uint8_t payload[4096];
+	bool allocate_all = false;
+	uint64_t i;
+	int inflate_rc = 1;
+	int cancel_rc = 1;
+	int rc;
+
+	dev = init_dev();
+	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	pages_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_page_size(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = 10;
+	opts.thin_provision = true;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	memset(payload, 0xAA, sizeof(payload));
+	for (i = 0; i < 5; i++) {
+		spdk_blob_io_write(blob, channel, payload, i * pages_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Nothing to cancel yet */
+	rc = spdk_bs_inflate_blob_cancel(bs, blobid, blob_op_rc_complete, &cancel_rc);
+	CU_ASSERT(rc == -ENOENT);
+
+	spdk_blob_inflate_opts_init(&inflate_opts);
+	inflate_opts.max_clusters_per_sec = 2;
+	spdk_bs_inflate_blob_ext(bs, channel, blobid, &inflate_opts, blob_op_rc_complete,
+				 &inflate_rc);
+	poll_threads();
+	CU_ASSERT(inflate_rc == 1);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_blob = NULL;
+
+	/* The throttled inflate keeps the blob open */
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EBUSY);
+
+	rc = spdk_bs_inflate_blob_cancel(bs, blobid, blob_op_rc_complete, &cancel_rc);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bs_inflate_blob_cancel(bs, blobid, blob_op_rc_complete, NULL);
+	CU_ASSERT(rc == -EALREADY);
+	poll_threads();
+	CU_ASSERT(inflate_rc == -ECANCELED);
+	CU_ASSERT(cancel_rc == 0);
+
+	rc = spdk_bs_inflate_blob_cancel(bs, blobid, blob_op_rc_complete, &cancel_rc);
+	CU_ASSERT(rc == -ENOENT);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_bs_reload(&bs, NULL);
+
+	/* The canceled operation is still recorded, the copied cluster was kept */
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	memset(&inflate_opts, 0, sizeof(inflate_opts));
+	rc = spdk_blob_get_inflate_checkpoint(blob, &inflate_opts, &allocate_all);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(allocate_all == true);
+	CU_ASSERT(inflate_opts.max_clusters_per_sec == 2);
+	rc = spdk_blob_get_inflate_progress(blob, &progress);
+	CU_ASSERT(rc == -ENOENT);
+	CU_ASSERT(spdk_blob_is_thin_provisioned(blob) == true);
+	CU_ASSERT(blob->active.clusters[0] != 0);
+	CU_ASSERT(blob->active.clusters[1] == 0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_blob = NULL;
+
+	/* The legacy call does not record the operation, a canceled one is just gone */
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	spdk_blob_io_write(blob, channel, payload, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Hold the copy of the first cluster, so that the inflate can be canceled */
+	blob_freeze_io(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	inflate_rc = 1;
+	cancel_rc = 1;
+	spdk_bs_inflate_blob(bs, channel, blobid, blob_op_rc_complete, &inflate_rc);
+	poll_threads();
+	CU_ASSERT(inflate_rc == 1);
+
+	rc = spdk_blob_get_inflate_checkpoint(blob, &inflate_opts, &allocate_all);
+	CU_ASSERT(rc == -ENOENT);
+	rc = spdk_bs_inflate_blob_cancel(bs, blobid, blob_op_rc_complete, &cancel_rc);
+	CU_ASSERT(rc == 0);
+
+	blob_unfreeze_io(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(inflate_rc == -ECANCELED);
+	CU_ASSERT(cancel_rc == 0);
+
+	rc = spdk_blob_get_inflate_checkpoint(blob, &inflate_opts, &allocate_all);
+	CU_ASSERT(rc == -ENOENT);
+	CU_ASSERT(spdk_blob_is_thin_provisioned(blob) == true);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_blob = NULL;
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
 static void
 blob_delete(void)
 {
@@ -3239,70 +3511,295 @@ blob_dirty_shutdown(void)
 }
 
 static void
-blob_flags(void)
+blob_sync_md_coalesce_done(void *cb_arg, int bserrno)
 {
-	struct spdk_blob_store *bs = g_bs;
-	spdk_blob_id blobid_invalid, blobid_data_ro, blobid_md_ro;
-	struct spdk_blob *blob_invalid, *blob_data_ro, *blob_md_ro;
-	struct spdk_blob_opts blob_opts;
-	int rc;
+	int *count = cb_arg;
 
-	/* Create three blobs - one each for testing invalid, data_ro and md_ro flags. */
-	blob_invalid = ut_blob_create_and_open(bs, NULL);
-	blobid_invalid = spdk_blob_get_id(blob_invalid);
+	CU_ASSERT(bserrno == 0);
+	(*count)++;
+}
 
-	blob_data_ro = ut_blob_create_and_open(bs, NULL);
-	blobid_data_ro = spdk_blob_get_id(blob_data_ro);
+static void
+blob_sync_md_coalesce(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blobs[16];
+	spdk_blob_id blobids[16];
+	const void *value;
+	size_t value_len;
+	uint64_t write_ops;
+	uint64_t i;
+	int count = 0;
+	int rc;
 
-	ut_spdk_blob_opts_init(&blob_opts);
-	blob_opts.clear_method = BLOB_CLEAR_WITH_WRITE_ZEROES;
-	blob_md_ro = ut_blob_create_and_open(bs, &blob_opts);
-	blobid_md_ro = spdk_blob_get_id(blob_md_ro);
-	CU_ASSERT((blob_md_ro->md_ro_flags & SPDK_BLOB_MD_RO_FLAGS_MASK) == BLOB_CLEAR_WITH_WRITE_ZEROES);
+	for (i = 0; i < SPDK_COUNTOF(blobs); i++) {
+		blobs[i] = ut_blob_create_and_open(bs, NULL);
+		blobids[i] = spdk_blob_get_id(blobs[i]);
+	}
 
-	/* Change the size of blob_data_ro to check if flags are serialized
-	 * when blob has non zero number of extents */
-	spdk_blob_resize(blob_data_ro, 10, blob_op_complete, NULL);
+	/* Blobs synced together have their md pages written together */
+	write_ops = g_dev_write_ops;
+	for (i = 0; i < SPDK_COUNTOF(blobs); i++) {
+		rc = spdk_blob_set_xattr(blobs[i], "index", &i, sizeof(i));
+		CU_ASSERT(rc == 0);
+		spdk_blob_sync_md(blobs[i], blob_sync_md_coalesce_done, &count);
+	}
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(count == SPDK_COUNTOF(blobs));
+	CU_ASSERT(g_dev_write_ops - write_ops < SPDK_COUNTOF(blobs));
 
-	/* Set the xattr to check if flags are serialized
-	 * when blob has non zero number of xattrs */
-	rc = spdk_blob_set_xattr(blob_md_ro, "name", "log.txt", strlen("log.txt") + 1);
+	/* Syncs of one blob queued behind another one are written out together */
+	count = 0;
+	write_ops = g_dev_write_ops;
+	rc = spdk_blob_set_xattr(blobs[0], "first", "1", 2);
+	CU_ASSERT(rc == 0);
+	spdk_blob_sync_md(blobs[0], blob_sync_md_coalesce_done, &count);
+	rc = spdk_blob_set_xattr(blobs[0], "second", "2", 2);
+	CU_ASSERT(rc == 0);
+	spdk_blob_sync_md(blobs[0], blob_sync_md_coalesce_done, &count);
+	rc = spdk_blob_set_xattr(blobs[0], "third", "3", 2);
 	CU_ASSERT(rc == 0);
+	spdk_blob_sync_md(blobs[0], blob_sync_md_coalesce_done, &count);
+	CU_ASSERT(TAILQ_FIRST(&blobs[0]->pending_persists) != NULL);
+	poll_threads();
+	CU_ASSERT(count == 3);
+	CU_ASSERT(g_dev_write_ops - write_ops == 2);
+	CU_ASSERT(TAILQ_EMPTY(&blobs[0]->pending_persists));
+	CU_ASSERT(blobs[0]->state == SPDK_BLOB_STATE_CLEAN);
 
-	blob_invalid->invalid_flags = (1ULL << 63);
-	blob_invalid->state = SPDK_BLOB_STATE_DIRTY;
-	blob_data_ro->data_ro_flags = (1ULL << 62);
-	blob_data_ro->state = SPDK_BLOB_STATE_DIRTY;
-	blob_md_ro->md_ro_flags = (1ULL << 61);
-	blob_md_ro->state = SPDK_BLOB_STATE_DIRTY;
+	for (i = 0; i < SPDK_COUNTOF(blobs); i++) {
+		spdk_blob_close(blobs[i], blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	g_blob = NULL;
 
-	g_bserrno = -1;
-	spdk_blob_sync_md(blob_invalid, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	g_bserrno = -1;
-	spdk_blob_sync_md(blob_data_ro, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	g_bserrno = -1;
-	spdk_blob_sync_md(blob_md_ro, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	ut_bs_reload(&bs, NULL);
 
-	g_bserrno = -1;
-	spdk_blob_close(blob_invalid, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	blob_invalid = NULL;
-	g_bserrno = -1;
-	spdk_blob_close(blob_data_ro, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	blob_data_ro = NULL;
-	g_bserrno = -1;
-	spdk_blob_close(blob_md_ro, blob_op_complete, NULL);
+	for (i = 0; i < SPDK_COUNTOF(blobs); i++) {
+		spdk_bs_open_blob(bs, blobids[i], blob_op_with_handle_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+		blobs[i] = g_blob;
+
+		rc = spdk_blob_get_xattr_value(blobs[i], "index", &value, &value_len);
+		CU_ASSERT(rc == 0);
+		CU_ASSERT(value_len == sizeof(i));
+		CU_ASSERT(value != NULL && memcmp(value, &i, sizeof(i)) == 0);
+	}
+
+	rc = spdk_blob_get_xattr_value(blobs[0], "third", &value, &value_len);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(value_len == 2);
+
+	for (i = 0; i < SPDK_COUNTOF(blobs); i++) {
+		ut_blob_close_and_delete(bs, blobs[i]);
+	}
+}
+
+static void
+blob_dirty_shutdown_md_limit(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts opts;
+	struct spdk_bs_super_block *super = (struct spdk_bs_super_block *)g_dev_buffer;
+	struct spdk_blob *blob;
+	spdk_blob_id blobid;
+	const void *value;
+	size_t value_len;
+	char xattr[3000];
+	uint32_t i, md_len, fake_pages, num_pages;
+	int rc;
+
+	/* Enough md pages for recovery to read them in more than one window */
+	dev = init_dev();
+	spdk_bs_opts_init(&opts);
+	opts.num_md_pages = 1024;
+	spdk_bs_init(dev, &opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	md_len = bs->md_len;
+
+	/* Writing md marks the blobstore dirty, with a limit on md pages in use */
+	blob = ut_blob_create_and_open(bs, NULL);
+	blobid = spdk_blob_get_id(blob);
+	CU_ASSERT(super->clean == 0);
+	CU_ASSERT(super->version == SPDK_BS_VERSION_MD_USED_LIMIT);
+	CU_ASSERT(super->clean_version == SPDK_BS_VERSION);
+	CU_ASSERT(super->md_used_limit > bs_blobid_to_page(blobid));
+	CU_ASSERT(super->md_used_limit < md_len);
+
+	/* Claim md pages, so that the chain continues in the second window */
+	fake_pages = md_len * 3 / 4;
+	for (i = 0; i < fake_pages; i++) {
+		if (!spdk_bit_array_get(bs->used_md_pages, i)) {
+			spdk_bit_array_set(bs->used_md_pages, i);
+		} else {
+			CU_ASSERT(i == bs_blobid_to_page(blobid));
+		}
+	}
+
+	memset(xattr, 0xA5, sizeof(xattr));
+	rc = spdk_blob_set_xattr(blob, "xattr1", xattr, sizeof(xattr));
+	CU_ASSERT(rc == 0);
+	rc = spdk_blob_set_xattr(blob, "xattr2", xattr, sizeof(xattr));
+	CU_ASSERT(rc == 0);
+	spdk_blob_sync_md(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* The limit was raised before the pages past it were written */
+	CU_ASSERT(blob->active.num_pages > 1);
+	CU_ASSERT(blob->active.pages[1] >= fake_pages);
+	CU_ASSERT(super->md_used_limit > blob->active.pages[blob->active.num_pages - 1]);
+	CU_ASSERT(super->md_used_limit <= md_len);
+	num_pages = blob->active.num_pages;
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	blob = NULL;
+	g_blob = NULL;
+
+	ut_bs_dirty_load(&bs, &opts);
+
+	/* Only the pages of the blob are claimed after recovery */
+	CU_ASSERT(spdk_bit_array_get(bs->used_md_pages, bs_blobid_to_page(blobid)));
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_md_pages) == num_pages);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	rc = spdk_blob_get_xattr_value(blob, "xattr2", &value, &value_len);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(value != NULL);
+	CU_ASSERT(value_len == sizeof(xattr));
+	CU_ASSERT(memcmp(value, xattr, sizeof(xattr)) == 0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_blob = NULL;
+
+	/* A clean shutdown leaves no limit behind */
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	CU_ASSERT(super->clean == 1);
+	CU_ASSERT(super->md_used_limit == 0);
+	CU_ASSERT(super->version == SPDK_BS_VERSION);
+	CU_ASSERT(super->clean_version == 0);
+
+	/* A limit in a super block written by a version that doesn't maintain it may be
+	 * stale, recovery has to read the whole metadata region then. */
+	dev = init_dev();
+	spdk_bs_load(dev, &opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	blob = ut_blob_create_and_open(bs, NULL);
+	blobid = spdk_blob_get_id(blob);
+	CU_ASSERT(bs_blobid_to_page(blobid) > 0);
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_blob = NULL;
+
+	CU_ASSERT(super->version == SPDK_BS_VERSION_MD_USED_LIMIT);
+	super->version = SPDK_BS_VERSION;
+	super->md_used_limit = bs_blobid_to_page(blobid);
+	super->crc = blob_md_page_calc_crc(super);
+
+	ut_bs_dirty_load(&bs, &opts);
+	CU_ASSERT(spdk_bit_array_get(bs->used_md_pages, bs_blobid_to_page(blobid)));
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	ut_blob_close_and_delete(bs, g_blob);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
+static void
+blob_flags(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	spdk_blob_id blobid_invalid, blobid_data_ro, blobid_md_ro;
+	struct spdk_blob *blob_invalid, *blob_data_ro, *blob_md_ro;
+	struct spdk_blob_opts blob_opts;
+	int rc;
+
+	/* Create three blobs - one each for testing invalid, data_ro and md_ro flags. */
+	blob_invalid = ut_blob_create_and_open(bs, NULL);
+	blobid_invalid = spdk_blob_get_id(blob_invalid);
+
+	blob_data_ro = ut_blob_create_and_open(bs, NULL);
+	blobid_data_ro = spdk_blob_get_id(blob_data_ro);
+
+	ut_spdk_blob_opts_init(&blob_opts);
+	blob_opts.clear_method = BLOB_CLEAR_WITH_WRITE_ZEROES;
+	blob_md_ro = ut_blob_create_and_open(bs, &blob_opts);
+	blobid_md_ro = spdk_blob_get_id(blob_md_ro);
+	CU_ASSERT((blob_md_ro->md_ro_flags & SPDK_BLOB_MD_RO_FLAGS_MASK) == BLOB_CLEAR_WITH_WRITE_ZEROES);
+
+	/* Change the size of blob_data_ro to check if flags are serialized
+	 * when blob has non zero number of extents */
+	spdk_blob_resize(blob_data_ro, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Set the xattr to check if flags are serialized
+	 * when blob has non zero number of xattrs */
+	rc = spdk_blob_set_xattr(blob_md_ro, "name", "log.txt", strlen("log.txt") + 1);
+	CU_ASSERT(rc == 0);
+
+	blob_invalid->invalid_flags = (1ULL << 63);
+	blob_invalid->state = SPDK_BLOB_STATE_DIRTY;
+	blob_data_ro->data_ro_flags = (1ULL << 62);
+	blob_data_ro->state = SPDK_BLOB_STATE_DIRTY;
+	blob_md_ro->md_ro_flags = (1ULL << 61);
+	blob_md_ro->state = SPDK_BLOB_STATE_DIRTY;
+
+	g_bserrno = -1;
+	spdk_blob_sync_md(blob_invalid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bserrno = -1;
+	spdk_blob_sync_md(blob_data_ro, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bserrno = -1;
+	spdk_blob_sync_md(blob_md_ro, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	g_bserrno = -1;
+	spdk_blob_close(blob_invalid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	blob_invalid = NULL;
+	g_bserrno = -1;
+	spdk_blob_close(blob_data_ro, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	blob_data_ro = NULL;
+	g_bserrno = -1;
+	spdk_blob_close(blob_md_ro, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	blob_md_ro = NULL;
@@ -3433,9 +3930,25 @@ bs_version(void)
 
 	ut_blob_close_and_delete(bs, blob);
 
+	/* While dirty, the super block is marked as holding an md used limit */
+	CU_ASSERT(super->version == SPDK_BS_VERSION_MD_USED_LIMIT);
+	CU_ASSERT(super->clean_version == 2);
+	CU_ASSERT(super->used_blobid_mask_start == 0);
+	CU_ASSERT(super->used_blobid_mask_len == 0);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
 	CU_ASSERT(super->version == 2);
 	CU_ASSERT(super->used_blobid_mask_start == 0);
 	CU_ASSERT(super->used_blobid_mask_len == 0);
+
+	dev = init_dev();
+	spdk_bs_load(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
 }
 
 static void
@@ -3644,7 +4157,7 @@ blob_insert_cluster_msg_test(void)
 	bs_allocate_cluster(blob, cluster_num, &new_cluster, &extent_page, false);
 	CU_ASSERT(blob->active.clusters[cluster_num] == 0);
 
-	blob_insert_cluster_on_md_thread(blob, cluster_num, new_cluster, extent_page,
+	blob_insert_cluster_on_md_thread(blob, cluster_num, new_cluster, extent_page, 0,
 					 blob_op_complete, NULL);
 	poll_threads();
 
@@ -3764,331 +4277,1298 @@ blob_thin_prov_rw(void)
 }
 
 static void
-blob_thin_prov_rle(void)
+blob_thin_prov_concurrent_alloc(void)
 {
-	static const uint8_t zero[10 * 4096] = { 0 };
 	struct spdk_blob_store *bs = g_bs;
 	struct spdk_blob *blob;
 	struct spdk_io_channel *channel;
 	struct spdk_blob_opts opts;
-	spdk_blob_id blobid;
 	uint64_t free_clusters;
-	uint64_t page_size;
-	uint8_t payload_read[10 * 4096];
-	uint8_t payload_write[10 * 4096];
-	uint64_t write_bytes;
-	uint64_t read_bytes;
-	uint64_t io_unit;
+	uint64_t io_units_per_cluster;
+	uint8_t payload_read[4096];
+	uint8_t payload_write[3][4096];
 
 	free_clusters = spdk_bs_free_cluster_count(bs);
-	page_size = spdk_bs_get_page_size(bs);
+	io_units_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_io_unit_size(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
 
 	ut_spdk_blob_opts_init(&opts);
 	opts.thin_provision = true;
 	opts.num_clusters = 5;
 
 	blob = ut_blob_create_and_open(bs, &opts);
-	blobid = spdk_blob_get_id(blob);
 	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
 
-	channel = spdk_bs_alloc_io_channel(bs);
-	CU_ASSERT(channel != NULL);
+	/* Writes to two different unallocated clusters on the same channel
+	 * must both start allocating right away. */
+	memset(payload_write[0], 0xA1, sizeof(payload_write[0]));
+	spdk_blob_io_write(blob, channel, payload_write[0], 0, 1, blob_op_complete, NULL);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+	memset(payload_write[1], 0xB2, sizeof(payload_write[1]));
+	spdk_blob_io_write(blob, channel, payload_write[1], io_units_per_cluster, 1,
+			   blob_op_complete, NULL);
+	CU_ASSERT(free_clusters - 2 == spdk_bs_free_cluster_count(bs));
 
-	/* Target specifically second cluster in a blob as first allocation */
-	io_unit = bs_cluster_to_page(bs, 1) * bs_io_unit_per_page(bs);
+	/* A second write to a cluster that is being allocated waits for it
+	 * instead of allocating another one. */
+	memset(payload_write[2], 0xC3, sizeof(payload_write[2]));
+	spdk_blob_io_write(blob, channel, payload_write[2], 1, 1, blob_op_complete, NULL);
+	CU_ASSERT(free_clusters - 2 == spdk_bs_free_cluster_count(bs));
 
-	/* Payload should be all zeros from unallocated clusters */
-	memset(payload_read, 0xFF, sizeof(payload_read));
-	spdk_blob_io_read(blob, channel, payload_read, io_unit, 10, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+	CU_ASSERT(free_clusters - 2 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.clusters[0] != 0);
+	CU_ASSERT(blob->active.clusters[1] != 0);
+	CU_ASSERT(blob->active.clusters[2] == 0);
 
-	write_bytes = g_dev_write_bytes;
-	read_bytes = g_dev_read_bytes;
+	spdk_blob_io_read(blob, channel, payload_read, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write[0], payload_read, sizeof(payload_read)) == 0);
 
-	/* Issue write to second cluster in a blob */
-	memset(payload_write, 0xE5, sizeof(payload_write));
-	spdk_blob_io_write(blob, channel, payload_write, io_unit, 10, blob_op_complete, NULL);
+	spdk_blob_io_read(blob, channel, payload_read, io_units_per_cluster, 1,
+			  blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
-	/* For thin-provisioned blob we need to write 10 pages plus one page metadata and
-	 * read 0 bytes */
-	if (g_use_extent_table) {
-		/* Add one more page for EXTENT_PAGE write */
-		CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 12);
-	} else {
-		CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 11);
-	}
-	CU_ASSERT(g_dev_read_bytes - read_bytes == 0);
+	CU_ASSERT(memcmp(payload_write[1], payload_read, sizeof(payload_read)) == 0);
 
-	spdk_blob_io_read(blob, channel, payload_read, io_unit, 10, blob_op_complete, NULL);
+	spdk_blob_io_read(blob, channel, payload_read, 1, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+	CU_ASSERT(memcmp(payload_write[2], payload_read, sizeof(payload_read)) == 0);
+
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
 
 	spdk_bs_free_io_channel(channel);
 	poll_threads();
+	g_blob = NULL;
+	g_blobid = 0;
+}
 
-	spdk_blob_close(blob, blob_op_complete, NULL);
+static void
+blob_thin_prov_reserve(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob *blob, *thick_blob;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	uint64_t free_clusters, lba_per_cluster, io_units_per_cluster;
+	uint8_t payload_write[4096];
+
+	/* Use small clusters so there are enough free ones for channels to reserve runs. */
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	bs_opts.cluster_sz = SPDK_BS_PAGE_SIZE * 4;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	lba_per_cluster = bs_cluster_to_lba(bs, 1);
+	io_units_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_io_unit_size(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 4;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	/* Clusters handed out from a channel's reserved run are contiguous, and only
+	 * the ones actually used are accounted as no longer free. */
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+
+	spdk_blob_io_write(blob, channel, payload_write, io_units_per_cluster, 1,
+			   blob_op_complete, NULL);
+	spdk_blob_io_write(blob, channel, payload_write, 2 * io_units_per_cluster, 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 3 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.clusters[1] != 0);
+	CU_ASSERT(blob->active.clusters[2] == blob->active.clusters[1] + lba_per_cluster);
+
+	/* Resizing freezes I/O on all channels, which returns their reserved clusters.
+	 * All clusters reported as free can then be allocated to a thick blob. */
+	ut_spdk_blob_opts_init(&opts);
+	thick_blob = ut_blob_create_and_open(bs, &opts);
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	spdk_blob_resize(thick_blob, free_clusters, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 0);
+	CU_ASSERT(bs->num_free_clusters == 0);
+
+	ut_blob_close_and_delete(bs, thick_blob);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	/* Reserve again, unloading the blobstore has to return the run. */
+	spdk_blob_io_write(blob, channel, payload_write, 3 * io_units_per_cluster, 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(bs->num_free_clusters < free_clusters - 1);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	ut_bs_reload(&bs, &bs_opts);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(bs->num_free_clusters == free_clusters - 1);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
+static void
+blob_thin_prov_reserve_reclaim(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob *blob, *thick_blob;
+	struct spdk_io_channel *channel, *channel_thread1;
+	struct spdk_blob_opts opts;
+	uint64_t free_clusters, io_units_per_cluster, num_clusters, i;
+	uint8_t payload_write[4096];
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	bs_opts.cluster_sz = SPDK_BS_PAGE_SIZE * 4;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	io_units_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_io_unit_size(bs);
+	memset(payload_write, 0xE5, sizeof(payload_write));
+
+	/* Leave just enough free clusters for both channels to reserve a run. */
+	num_clusters = 2100;
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	SPDK_CU_ASSERT_FATAL(free_clusters > num_clusters);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = free_clusters - num_clusters;
+	thick_blob = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == num_clusters);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = num_clusters + 1;
+	blob = ut_blob_create_and_open(bs, &opts);
+
+	/* The first write also claims the extent page, if the blob uses them. */
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+	spdk_blob_io_write(blob, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* The write on thread 1 leaves the rest of its run reserved. */
+	set_thread(1);
+	channel_thread1 = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel_thread1 != NULL);
+	spdk_blob_io_write(blob, channel_thread1, payload_write, io_units_per_cluster, 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->num_reserved_clusters >= BS_CLUSTER_RESERVE_BATCH - 1);
+
+	/* Thread 0 runs through its own run and the shared pool, then has to take the
+	 * clusters thread 1 still holds. */
+	set_thread(0);
+	for (i = 2; i < num_clusters; i++) {
+		spdk_blob_io_write(blob, channel, payload_write, i * io_units_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 0);
+	CU_ASSERT(bs->num_free_clusters == 0);
+	CU_ASSERT(bs->num_reserved_clusters == 0);
+
+	/* Only now is the blobstore really full, the failed allocation aborts the write. */
+	spdk_blob_io_write(blob, channel_thread1, payload_write,
+			   num_clusters * io_units_per_cluster, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EIO);
+
+	set_thread(1);
+	spdk_bs_free_io_channel(channel_thread1);
+	set_thread(0);
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, thick_blob);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
+static void
+blob_clone_cow_units(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob *blob, *clone;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid, cloneid;
+	uint64_t free_clusters, i;
+	uint8_t payload_read[16 * 4096];
+	uint8_t payload_write[16 * 4096];
+	uint8_t payload_clone[4096];
+	struct spdk_blob_inflate_opts inflate_opts;
+	int delete_rc;
+
+	/* Clusters of 16 pages, copied from the parent one page at a time */
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	bs_opts.cluster_sz = SPDK_BS_PAGE_SIZE * 16;
+	bs_opts.cow_granularity = SPDK_BS_PAGE_SIZE;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = 2;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	memset(payload_write, 0xAA, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 0, 16, blob_op_complete, NULL);
+	spdk_blob_io_write(blob, channel, payload_write, 16, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+
+	CU_ASSERT(blob->cow_units_per_cluster == 16);
+	CU_ASSERT(blob->invalid_flags & SPDK_BLOB_COW_MAP);
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	/* Writing a single page allocates the cluster, but copies only the pages
+	 * from the first to the last one written. */
+	memset(payload_write, 0xBB, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 5, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.clusters[0] != 0);
+	CU_ASSERT(blob->cow_map[0] == (0xFFFF & ~(1u << 5)));
+	CU_ASSERT(blob->cow_map[1] == 0);
+
+	/* A write to the allocated cluster copies only the pages it touches */
+	spdk_blob_io_write(blob, channel, payload_write, 7, 2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->cow_map[0] == (0xFFFF & ~((1u << 5) | (1u << 7) | (1u << 8))));
+
+	/* Reads are split between the cluster and the snapshot */
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 0, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	for (i = 0; i < 16; i++) {
+		CU_ASSERT(payload_read[i * 4096] == ((i == 5 || i == 7 || i == 8) ? 0xBB : 0xAA));
+		CU_ASSERT(payload_read[i * 4096 + 4095] == payload_read[i * 4096]);
+	}
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* The map of partially copied clusters persists */
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	ut_bs_reload(&bs, &bs_opts);
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(blob->cow_units_per_cluster == 16);
+	SPDK_CU_ASSERT_FATAL(blob->cow_map != NULL);
+	CU_ASSERT(blob->cow_map[0] == (0xFFFF & ~((1u << 5) | (1u << 7) | (1u << 8))));
+	CU_ASSERT(blob->cow_map[1] == 0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Inflating copies the remaining units */
+	spdk_bs_inflate_blob(bs, channel, blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(spdk_blob_is_thin_provisioned(blob) == false);
+	CU_ASSERT(blob->cow_units_per_cluster == 1);
+	CU_ASSERT(blob->cow_map == NULL);
+	CU_ASSERT((blob->invalid_flags & SPDK_BLOB_COW_MAP) == 0);
+
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 0, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	for (i = 0; i < 16; i++) {
+		CU_ASSERT(payload_read[i * 4096] == ((i == 5 || i == 7 || i == 8) ? 0xBB : 0xAA));
+	}
+
+	/* Clones of the snapshot copy clusters in units as well */
+	spdk_bs_create_clone(bs, snapshotid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	cloneid = g_blobid;
+
+	spdk_bs_open_blob(bs, cloneid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	clone = g_blob;
+	CU_ASSERT(clone->cow_units_per_cluster == 16);
+
+	memset(payload_clone, 0xCC, sizeof(payload_clone));
+	spdk_blob_io_write(clone, channel, payload_clone, 31, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(clone->cow_map != NULL);
+	CU_ASSERT(clone->cow_map[0] == 0);
+	CU_ASSERT(clone->cow_map[1] == (0xFFFF & ~(1u << 15)));
+
+	spdk_blob_io_read(clone, channel, payload_read, 16, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(payload_read[0] == 0xAA);
+	CU_ASSERT(payload_read[15 * 4096] == 0xCC);
+
+	spdk_blob_io_write(clone, channel, payload_clone, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(clone->cow_map[0] == (0xFFFF & ~1u));
+
+	/* Deleting the snapshot first copies the units the clone still reads from it,
+	 * one cluster per second here, without freezing the clone I/O meanwhile */
+	ut_blob_close_and_delete(bs, blob);
+
+	spdk_blob_inflate_opts_init(&inflate_opts);
+	inflate_opts.max_clusters_per_sec = 1;
+	delete_rc = 1;
+	spdk_bs_delete_blob_ext(bs, snapshotid, &inflate_opts, blob_op_rc_complete, &delete_rc);
+	poll_threads();
+	CU_ASSERT(delete_rc == 1);
+	CU_ASSERT(clone->cow_map[0] == 0);
+	CU_ASSERT(clone->cow_map[1] == (0xFFFF & ~(1u << 15)));
+
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(clone, channel, payload_read, 16, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(payload_read[0] == 0xAA);
+	CU_ASSERT(payload_read[15 * 4096] == 0xCC);
+	CU_ASSERT(delete_rc == 1);
+
+	spdk_delay_us(1000000);
+	poll_threads();
+	CU_ASSERT(delete_rc == 0);
+
+	spdk_blob_close(clone, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_open_blob(bs, cloneid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	clone = g_blob;
+	CU_ASSERT(clone->parent_id == SPDK_BLOBID_INVALID);
+	CU_ASSERT(clone->cow_map[1] == 0);
+
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(clone, channel, payload_read, 16, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(payload_read[0] == 0xAA);
+	CU_ASSERT(payload_read[14 * 4096] == 0xAA);
+	CU_ASSERT(payload_read[15 * 4096] == 0xCC);
+
+	ut_blob_close_and_delete(bs, clone);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
+static void
+blob_thin_prov_rle(void)
+{
+	static const uint8_t zero[10 * 4096] = { 0 };
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid;
+	uint64_t free_clusters;
+	uint64_t page_size;
+	uint8_t payload_read[10 * 4096];
+	uint8_t payload_write[10 * 4096];
+	uint64_t write_bytes;
+	uint64_t read_bytes;
+	uint64_t io_unit;
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	page_size = spdk_bs_get_page_size(bs);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	/* Target specifically second cluster in a blob as first allocation */
+	io_unit = bs_cluster_to_page(bs, 1) * bs_io_unit_per_page(bs);
+
+	/* Payload should be all zeros from unallocated clusters */
+	memset(payload_read, 0xFF, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, io_unit, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+
+	write_bytes = g_dev_write_bytes;
+	read_bytes = g_dev_read_bytes;
+
+	/* Issue write to second cluster in a blob */
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, io_unit, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+	/* For thin-provisioned blob we need to write 10 pages plus one page metadata and
+	 * read 0 bytes */
+	if (g_use_extent_table) {
+		/* Add one more page for EXTENT_PAGE write */
+		CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 12);
+	} else {
+		CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 11);
+	}
+	CU_ASSERT(g_dev_read_bytes - read_bytes == 0);
+
+	spdk_blob_io_read(blob, channel, payload_read, io_unit, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	ut_bs_reload(&bs, NULL);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	/* Read second cluster after blob reload to confirm data written */
+	spdk_blob_io_read(blob, channel, payload_read, io_unit, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+}
+
+static void
+blob_thin_prov_rw_iov(void)
+{
+	static const uint8_t zero[10 * 4096] = { 0 };
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	uint64_t free_clusters;
+	uint8_t payload_read[10 * 4096];
+	uint8_t payload_write[10 * 4096];
+	struct iovec iov_read[3];
+	struct iovec iov_write[3];
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	CU_ASSERT(blob->active.num_clusters == 0);
+
+	/* The blob started at 0 clusters. Resize it to be 5, but still unallocated. */
+	spdk_blob_resize(blob, 5, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.num_clusters == 5);
+
+	spdk_blob_sync_md(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	/* Sync must not change anything */
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.num_clusters == 5);
+
+	/* Payload should be all zeros from unallocated clusters */
+	memset(payload_read, 0xAA, sizeof(payload_read));
+	iov_read[0].iov_base = payload_read;
+	iov_read[0].iov_len = 3 * 4096;
+	iov_read[1].iov_base = payload_read + 3 * 4096;
+	iov_read[1].iov_len = 4 * 4096;
+	iov_read[2].iov_base = payload_read + 7 * 4096;
+	iov_read[2].iov_len = 3 * 4096;
+	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	iov_write[0].iov_base = payload_write;
+	iov_write[0].iov_len = 1 * 4096;
+	iov_write[1].iov_base = payload_write + 1 * 4096;
+	iov_write[1].iov_len = 5 * 4096;
+	iov_write[2].iov_base = payload_write + 6 * 4096;
+	iov_write[2].iov_len = 4 * 4096;
+
+	spdk_blob_io_writev(blob, channel, iov_write, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	memset(payload_read, 0xAA, sizeof(payload_read));
+	iov_read[0].iov_base = payload_read;
+	iov_read[0].iov_len = 3 * 4096;
+	iov_read[1].iov_base = payload_read + 3 * 4096;
+	iov_read[1].iov_len = 4 * 4096;
+	iov_read[2].iov_base = payload_read + 7 * 4096;
+	iov_read[2].iov_len = 3 * 4096;
+	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+}
+
+struct iter_ctx {
+	int		current_iter;
+	spdk_blob_id	blobid[4];
+};
+
+static void
+test_iter(void *arg, struct spdk_blob *blob, int bserrno)
+{
+	struct iter_ctx *iter_ctx = arg;
+	spdk_blob_id blobid;
+
+	CU_ASSERT(bserrno == 0);
+	blobid = spdk_blob_get_id(blob);
+	CU_ASSERT(blobid == iter_ctx->blobid[iter_ctx->current_iter++]);
+}
+
+static void
+bs_load_iter_test(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct iter_ctx iter_ctx = { 0 };
+	struct spdk_blob *blob;
+	int i, rc;
+	struct spdk_bs_opts opts;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&opts);
+	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
+
+	/* Initialize a new blob store */
+	spdk_bs_init(dev, &opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	for (i = 0; i < 4; i++) {
+		blob = ut_blob_create_and_open(bs, NULL);
+		iter_ctx.blobid[i] = spdk_blob_get_id(blob);
+
+		/* Just save the blobid as an xattr for testing purposes. */
+		rc = spdk_blob_set_xattr(blob, "blobid", &iter_ctx.blobid[i], sizeof(spdk_blob_id));
+		CU_ASSERT(rc == 0);
+
+		/* Resize the blob */
+		spdk_blob_resize(blob, i, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+
+		spdk_blob_close(blob, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	g_bserrno = -1;
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	dev = init_dev();
+	spdk_bs_opts_init(&opts);
+	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
+	opts.iter_cb_fn = test_iter;
+	opts.iter_cb_arg = &iter_ctx;
+
+	/* Test blob iteration during load after a clean shutdown. */
+	spdk_bs_load(dev, &opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	/* Dirty shutdown */
+	bs_free(bs);
+
+	dev = init_dev();
+	spdk_bs_opts_init(&opts);
+	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
+	opts.iter_cb_fn = test_iter;
+	iter_ctx.current_iter = 0;
+	opts.iter_cb_arg = &iter_ctx;
+
+	/* Test blob iteration during load after a dirty shutdown. */
+	spdk_bs_load(dev, &opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
+static void
+blob_snapshot_rw(void)
+{
+	static const uint8_t zero[10 * 4096] = { 0 };
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid;
+	uint64_t free_clusters;
+	uint64_t cluster_size;
+	uint64_t page_size;
+	uint8_t payload_read[10 * 4096];
+	uint8_t payload_write[10 * 4096];
+	uint64_t write_bytes;
+	uint64_t read_bytes;
+	uint64_t copy_bytes;
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	cluster_size = spdk_bs_get_cluster_size(bs);
+	page_size = spdk_bs_get_page_size(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 5);
+
+	memset(payload_read, 0xFF, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters != spdk_bs_free_cluster_count(bs));
+
+	/* Create snapshot from blob */
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+	CU_ASSERT(snapshot->data_ro == true);
+	CU_ASSERT(snapshot->md_ro == true);
+
+	CU_ASSERT(spdk_blob_get_num_clusters(snapshot) == 5);
+
+	write_bytes = g_dev_write_bytes;
+	read_bytes = g_dev_read_bytes;
+	copy_bytes = g_dev_copy_bytes;
+
+	memset(payload_write, 0xAA, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters != spdk_bs_free_cluster_count(bs));
+
+	/* For a clone we need to allocate and copy one cluster, update one page of metadata
+	 * and then write 10 pages of payload. The cluster is copied within the device.
+	 */
+	if (g_use_extent_table) {
+		/* Add one more page for EXTENT_PAGE write */
+		CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 12 + cluster_size);
+	} else {
+		CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 11 + cluster_size);
+	}
+	CU_ASSERT(g_dev_read_bytes - read_bytes == 0);
+	CU_ASSERT(g_dev_copy_bytes - copy_bytes == cluster_size);
+
+	spdk_blob_io_read(blob, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
+	/* Data on snapshot should not change after write to clone */
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_read(snapshot, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, snapshot);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_snapshot_copy_dev(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot, *clone;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid, cloneid;
+	uint64_t cluster_size, pages_per_cluster;
+	uint64_t read_bytes, copy_bytes;
+	uint8_t payload_read[4096];
+	uint8_t payload_write[4096];
+	uint8_t pattern[4096];
+
+	cluster_size = spdk_bs_get_cluster_size(bs);
+	pages_per_cluster = cluster_size / spdk_bs_get_page_size(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 2;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	/* Allocate only the first cluster before taking the snapshot */
+	memset(pattern, 0x5A, sizeof(pattern));
+	spdk_blob_io_write(blob, channel, pattern, 1, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+
+	/* The snapshot holds the first cluster, it is copied within the device */
+	memset(payload_write, 0xAA, sizeof(payload_write));
+	read_bytes = g_dev_read_bytes;
+	copy_bytes = g_dev_copy_bytes;
+	spdk_blob_io_write(blob, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_read_bytes - read_bytes == 0);
+	CU_ASSERT(g_dev_copy_bytes - copy_bytes == cluster_size);
+
+	spdk_blob_io_read(blob, channel, payload_read, 1, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, pattern, sizeof(pattern)) == 0);
+
+	/* The second cluster is not allocated in the snapshot, nothing to copy */
+	copy_bytes = g_dev_copy_bytes;
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster, 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_copy_bytes - copy_bytes == 0);
+
+	/* Without device side copy, the cluster goes through a buffer */
+	spdk_bs_create_clone(bs, snapshotid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	cloneid = g_blobid;
+
+	spdk_bs_open_blob(bs, cloneid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	clone = g_blob;
+
+	bs->dev->copy = NULL;
+	read_bytes = g_dev_read_bytes;
+	copy_bytes = g_dev_copy_bytes;
+	spdk_blob_io_write(clone, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_read_bytes - read_bytes == cluster_size);
+	CU_ASSERT(g_dev_copy_bytes - copy_bytes == 0);
+	bs->dev->copy = dev_copy;
+
+	spdk_blob_io_read(clone, channel, payload_read, 1, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, pattern, sizeof(pattern)) == 0);
+
+	ut_blob_close_and_delete(bs, clone);
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, snapshot);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_snapshot_chain_read(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot1, *snapshot2;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid1, snapshotid2;
+	uint64_t pages_per_cluster;
+	uint8_t payload_read[2 * 4096];
+	uint8_t pattern1[4096];
+	uint8_t pattern2[4096];
+	uint8_t zero[4096];
+	uint64_t *cache;
+	struct iovec iov;
+
+	pages_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_page_size(bs);
+	memset(pattern1, 0x11, sizeof(pattern1));
+	memset(pattern2, 0x22, sizeof(pattern2));
+	memset(zero, 0, sizeof(zero));
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 3;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+	CU_ASSERT(blob->back_lba_cache == NULL);
+
+	/* Build the chain blob -> snapshot2 -> snapshot1, with the first cluster held by
+	 * snapshot1, the second one by snapshot2 and the third one by none of them. */
+	spdk_blob_io_write(blob, channel, pattern1, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid1 = g_blobid;
+
+	spdk_blob_io_write(blob, channel, pattern2, pages_per_cluster, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid2 = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid1, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot1 = g_blob;
+
+	spdk_bs_open_blob(bs, snapshotid2, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot2 = g_blob;
+
+	SPDK_CU_ASSERT_FATAL(blob->back_lba_cache != NULL);
+	CU_ASSERT(blob->back_lba_cache_size == 3);
+	CU_ASSERT(blob->back_lba_cache[0] == 0);
+	CU_ASSERT(blob->back_lba_cache[1] == 0);
+	CU_ASSERT(blob->back_lba_cache[2] == 0);
+
+	/* Reads look up the snapshot that holds each cluster once */
+	spdk_blob_io_read(blob, channel, payload_read, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, pattern1, sizeof(pattern1)) == 0);
+	CU_ASSERT(blob->back_lba_cache[0] == snapshot1->active.clusters[0]);
+
+	iov.iov_base = payload_read;
+	iov.iov_len = sizeof(pattern2);
+	spdk_blob_io_readv(blob, channel, &iov, 1, pages_per_cluster, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, pattern2, sizeof(pattern2)) == 0);
+	CU_ASSERT(blob->back_lba_cache[1] == snapshot2->active.clusters[1]);
+
+	memset(payload_read, 0xFF, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 2 * pages_per_cluster, 1,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, zero, sizeof(zero)) == 0);
+	CU_ASSERT(blob->back_lba_cache[2] == UINT64_MAX);
+
+	/* A read spanning two clusters is split and each part is looked up on its own */
+	spdk_blob_io_read(blob, channel, payload_read, pages_per_cluster - 1, 2,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, zero, sizeof(zero)) == 0);
+	CU_ASSERT(memcmp(payload_read + 4096, pattern2, sizeof(pattern2)) == 0);
+
+	/* Channels may be reading the cache of a blob that isn't frozen, a change of
+	 * the chains only clears it in place */
+	cache = blob->back_lba_cache;
+	bs_cluster_maps_changed(bs);
+	CU_ASSERT(blob->back_lba_cache == cache);
+	CU_ASSERT(blob->back_lba_cache_size == 3);
+	CU_ASSERT(blob->back_lba_cache[0] == 0);
+	CU_ASSERT(blob->back_lba_cache[1] == 0);
+	CU_ASSERT(blob->back_lba_cache[2] == 0);
+
+	/* Snapshots that are frozen while their chain changes are not looked up */
+	snapshot1->frozen_refcnt++;
+	CU_ASSERT(blob_back_lba_resolve(blob, 0) == 0);
+	CU_ASSERT(blob_back_lba_resolve(blob, 1) == snapshot2->active.clusters[1]);
+	snapshot1->frozen_refcnt--;
+	CU_ASSERT(blob_back_lba_resolve(blob, 0) == snapshot1->active.clusters[0]);
+
+	/* Removing snapshot2 from the chain drops what was looked up */
+	ut_blob_close_and_delete(bs, snapshot2);
+	SPDK_CU_ASSERT_FATAL(blob->back_lba_cache != NULL);
+	CU_ASSERT(blob->back_lba_cache[0] == 0);
+	CU_ASSERT(blob->back_lba_cache[1] == 0);
+	CU_ASSERT(blob->back_lba_cache[2] == 0);
+
+	spdk_blob_io_read(blob, channel, payload_read, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, pattern1, sizeof(pattern1)) == 0);
+	CU_ASSERT(blob->back_lba_cache[0] == snapshot1->active.clusters[0]);
+
+	spdk_blob_io_read(blob, channel, payload_read, pages_per_cluster, 1,
+			  blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, pattern2, sizeof(pattern2)) == 0);
 
-	ut_bs_reload(&bs, NULL);
-
-	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	/* Once inflated the blob has no snapshot to read from */
+	spdk_bs_inflate_blob(bs, channel, blobid, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
-	blob = g_blob;
-
-	channel = spdk_bs_alloc_io_channel(bs);
-	CU_ASSERT(channel != NULL);
+	CU_ASSERT(blob->back_lba_cache == NULL);
 
-	/* Read second cluster after blob reload to confirm data written */
-	spdk_blob_io_read(blob, channel, payload_read, io_unit, 10, blob_op_complete, NULL);
+	spdk_blob_io_read(blob, channel, payload_read, 0, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+	CU_ASSERT(memcmp(payload_read, pattern1, sizeof(pattern1)) == 0);
+
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, snapshot1);
 
 	spdk_bs_free_io_channel(channel);
 	poll_threads();
-
-	ut_blob_close_and_delete(bs, blob);
+	g_blob = NULL;
+	g_blobid = 0;
 }
 
 static void
-blob_thin_prov_rw_iov(void)
+blob_deferred_unmap(void)
 {
-	static const uint8_t zero[10 * 4096] = { 0 };
 	struct spdk_blob_store *bs = g_bs;
-	struct spdk_blob *blob;
-	struct spdk_io_channel *channel;
+	struct spdk_blob *blob1, *blob2, *blob3;
 	struct spdk_blob_opts opts;
-	uint64_t free_clusters;
-	uint8_t payload_read[10 * 4096];
-	uint8_t payload_write[10 * 4096];
-	struct iovec iov_read[3];
-	struct iovec iov_write[3];
+	uint64_t free_clusters, unmap_ops;
 
 	free_clusters = spdk_bs_free_cluster_count(bs);
 
-	channel = spdk_bs_alloc_io_channel(bs);
-	CU_ASSERT(channel != NULL);
-
 	ut_spdk_blob_opts_init(&opts);
-	opts.thin_provision = true;
-
-	blob = ut_blob_create_and_open(bs, &opts);
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
-
-	CU_ASSERT(blob->active.num_clusters == 0);
+	opts.num_clusters = 4;
+	blob1 = ut_blob_create_and_open(bs, &opts);
+	opts.num_clusters = 2;
+	blob2 = ut_blob_create_and_open(bs, &opts);
+	blob3 = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 8);
 
-	/* The blob started at 0 clusters. Resize it to be 5, but still unallocated. */
-	spdk_blob_resize(blob, 5, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
-	CU_ASSERT(blob->active.num_clusters == 5);
+	/* Without rate limit the clusters are unmapped and free right after the delete */
+	unmap_ops = g_dev_unmap_ops;
+	ut_blob_close_and_delete(bs, blob1);
+	CU_ASSERT(g_dev_unmap_ops - unmap_ops == 1);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 4);
 
-	spdk_blob_sync_md(blob, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	/* Sync must not change anything */
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
-	CU_ASSERT(blob->active.num_clusters == 5);
+	/* One cluster per second, the clusters of blob3 are unmapped right away and the
+	 * ones of blob2 two seconds later, merged with the range following them */
+	spdk_bs_set_unmap_rate_limit(bs, spdk_bs_get_cluster_size(bs));
 
-	/* Payload should be all zeros from unallocated clusters */
-	memset(payload_read, 0xAA, sizeof(payload_read));
-	iov_read[0].iov_base = payload_read;
-	iov_read[0].iov_len = 3 * 4096;
-	iov_read[1].iov_base = payload_read + 3 * 4096;
-	iov_read[1].iov_len = 4 * 4096;
-	iov_read[2].iov_base = payload_read + 7 * 4096;
-	iov_read[2].iov_len = 3 * 4096;
-	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+	unmap_ops = g_dev_unmap_ops;
+	ut_blob_close_and_delete(bs, blob3);
+	CU_ASSERT(g_dev_unmap_ops - unmap_ops == 1);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 2);
 
-	memset(payload_write, 0xE5, sizeof(payload_write));
-	iov_write[0].iov_base = payload_write;
-	iov_write[0].iov_len = 1 * 4096;
-	iov_write[1].iov_base = payload_write + 1 * 4096;
-	iov_write[1].iov_len = 5 * 4096;
-	iov_write[2].iov_base = payload_write + 6 * 4096;
-	iov_write[2].iov_len = 4 * 4096;
+	ut_blob_close_and_delete(bs, blob2);
+	CU_ASSERT(g_dev_unmap_ops - unmap_ops == 1);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == 2);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 2);
 
-	spdk_blob_io_writev(blob, channel, iov_write, 3, 250, 10, blob_op_complete, NULL);
+	spdk_delay_us(1000000);
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_unmap_ops - unmap_ops == 1);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == 2);
 
-	memset(payload_read, 0xAA, sizeof(payload_read));
-	iov_read[0].iov_base = payload_read;
-	iov_read[0].iov_len = 3 * 4096;
-	iov_read[1].iov_base = payload_read + 3 * 4096;
-	iov_read[1].iov_len = 4 * 4096;
-	iov_read[2].iov_base = payload_read + 7 * 4096;
-	iov_read[2].iov_len = 3 * 4096;
-	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	spdk_delay_us(1000000);
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+	CU_ASSERT(g_dev_unmap_ops - unmap_ops == 2);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
 
-	spdk_bs_free_io_channel(channel);
-	poll_threads();
+	/* Unload doesn't wait for the rate limit and persists the clusters as free */
+	opts.num_clusters = 4;
+	blob1 = ut_blob_create_and_open(bs, &opts);
+	ut_blob_close_and_delete(bs, blob1);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == 4);
 
-	ut_blob_close_and_delete(bs, blob);
+	ut_bs_reload(&bs, NULL);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
 }
 
-struct iter_ctx {
-	int		current_iter;
-	spdk_blob_id	blobid[4];
-};
-
 static void
-test_iter(void *arg, struct spdk_blob *blob, int bserrno)
+blob_deferred_unmap_enospc(void)
 {
-	struct iter_ctx *iter_ctx = arg;
-	spdk_blob_id blobid;
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob1, *blob2, *blob;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	uint64_t free_clusters;
+	uint8_t payload[4096];
 
-	CU_ASSERT(bserrno == 0);
-	blobid = spdk_blob_get_id(blob);
-	CU_ASSERT(blobid == iter_ctx->blobid[iter_ctx->current_iter++]);
-}
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	memset(payload, 0xAA, sizeof(payload));
 
-static void
-bs_load_iter_test(void)
-{
-	struct spdk_blob_store *bs;
-	struct spdk_bs_dev *dev;
-	struct iter_ctx iter_ctx = { 0 };
-	struct spdk_blob *blob;
-	int i, rc;
-	struct spdk_bs_opts opts;
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
 
-	dev = init_dev();
-	spdk_bs_opts_init(&opts);
-	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = 1;
+	blob1 = ut_blob_create_and_open(bs, &opts);
+	opts.num_clusters = free_clusters - 1;
+	blob2 = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 0);
+
+	/* The clusters of blob1 are unmapped right away, the ones of blob2 are held
+	 * back by the rate limit of one cluster per second */
+	spdk_bs_set_unmap_rate_limit(bs, spdk_bs_get_cluster_size(bs));
+	ut_blob_close_and_delete(bs, blob1);
+	ut_blob_close_and_delete(bs, blob2);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == free_clusters - 1);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 1);
+
+	/* Creating a thick blob drains the queue instead of failing */
+	opts.num_clusters = free_clusters;
+	blob = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 0);
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == free_clusters);
 
-	/* Initialize a new blob store */
-	spdk_bs_init(dev, &opts, bs_op_with_handle_complete, NULL);
+	/* So does resizing a blob */
+	opts.num_clusters = 0;
+	blob = ut_blob_create_and_open(bs, &opts);
+	spdk_blob_resize(blob, free_clusters, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
-	bs = g_bs;
-
-	for (i = 0; i < 4; i++) {
-		blob = ut_blob_create_and_open(bs, NULL);
-		iter_ctx.blobid[i] = spdk_blob_get_id(blob);
-
-		/* Just save the blobid as an xattr for testing purposes. */
-		rc = spdk_blob_set_xattr(blob, "blobid", &iter_ctx.blobid[i], sizeof(spdk_blob_id));
-		CU_ASSERT(rc == 0);
-
-		/* Resize the blob */
-		spdk_blob_resize(blob, i, blob_op_complete, NULL);
-		poll_threads();
-		CU_ASSERT(g_bserrno == 0);
-
-		spdk_blob_close(blob, blob_op_complete, NULL);
-		poll_threads();
-		CU_ASSERT(g_bserrno == 0);
-	}
-
-	g_bserrno = -1;
-	spdk_bs_unload(bs, bs_op_complete, NULL);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 0);
+	spdk_blob_sync_md(blob, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == free_clusters);
 
-	dev = init_dev();
-	spdk_bs_opts_init(&opts);
-	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
-	opts.iter_cb_fn = test_iter;
-	opts.iter_cb_arg = &iter_ctx;
-
-	/* Test blob iteration during load after a clean shutdown. */
-	spdk_bs_load(dev, &opts, bs_op_with_handle_complete, NULL);
+	/* And allocating a cluster on write to a thin provisioned blob */
+	opts.thin_provision = true;
+	opts.num_clusters = 1;
+	blob = ut_blob_create_and_open(bs, &opts);
+	g_bserrno = -1;
+	spdk_blob_io_write(blob, channel, payload, 0, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
-	bs = g_bs;
-
-	/* Dirty shutdown */
-	bs_free(bs);
-
-	dev = init_dev();
-	spdk_bs_opts_init(&opts);
-	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
-	opts.iter_cb_fn = test_iter;
-	iter_ctx.current_iter = 0;
-	opts.iter_cb_arg = &iter_ctx;
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == 0);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 1);
 
-	/* Test blob iteration during load after a dirty shutdown. */
-	spdk_bs_load(dev, &opts, bs_op_with_handle_complete, NULL);
+	spdk_bs_free_io_channel(channel);
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
-	bs = g_bs;
 
-	spdk_bs_unload(bs, bs_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	g_bs = NULL;
+	spdk_bs_set_unmap_rate_limit(bs, 0);
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(spdk_bs_unmap_pending_cluster_count(bs) == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
 }
 
 static void
-blob_snapshot_rw(void)
+blob_cluster_accounting(void)
 {
-	static const uint8_t zero[10 * 4096] = { 0 };
 	struct spdk_blob_store *bs = g_bs;
 	struct spdk_blob *blob, *snapshot;
 	struct spdk_io_channel *channel;
 	struct spdk_blob_opts opts;
 	spdk_blob_id blobid, snapshotid;
-	uint64_t free_clusters;
-	uint64_t cluster_size;
-	uint64_t page_size;
-	uint8_t payload_read[10 * 4096];
-	uint8_t payload_write[10 * 4096];
-	uint64_t write_bytes;
-	uint64_t read_bytes;
+	uint64_t pages_per_cluster;
+	uint8_t payload[4096];
 
-	free_clusters = spdk_bs_free_cluster_count(bs);
-	cluster_size = spdk_bs_get_cluster_size(bs);
-	page_size = spdk_bs_get_page_size(bs);
+	pages_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_page_size(bs);
+	memset(payload, 0xAA, sizeof(payload));
 
 	channel = spdk_bs_alloc_io_channel(bs);
-	CU_ASSERT(channel != NULL);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
 
 	ut_spdk_blob_opts_init(&opts);
 	opts.thin_provision = true;
-	opts.num_clusters = 5;
+	opts.num_clusters = 4;
 
 	blob = ut_blob_create_and_open(bs, &opts);
 	blobid = spdk_blob_get_id(blob);
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
-
-	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 5);
-
-	memset(payload_read, 0xFF, sizeof(payload_read));
-	spdk_blob_io_read(blob, channel, payload_read, 4, 10, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 0);
+	CU_ASSERT(spdk_blob_get_num_shared_clusters(blob) == 0);
 
-	memset(payload_write, 0xE5, sizeof(payload_write));
-	spdk_blob_io_write(blob, channel, payload_write, 4, 10, blob_op_complete, NULL);
+	spdk_blob_io_write(blob, channel, payload, 0, 1, blob_op_complete, NULL);
+	spdk_blob_io_write(blob, channel, payload, pages_per_cluster, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(free_clusters != spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 2);
+	CU_ASSERT(spdk_blob_get_num_shared_clusters(blob) == 0);
 
-	/* Create snapshot from blob */
+	/* The clusters move to the snapshot */
 	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
 	snapshotid = g_blobid;
 
 	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
@@ -4096,45 +5576,32 @@ blob_snapshot_rw(void)
 	CU_ASSERT(g_bserrno == 0);
 	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
 	snapshot = g_blob;
-	CU_ASSERT(snapshot->data_ro == true);
-	CU_ASSERT(snapshot->md_ro == true);
-
-	CU_ASSERT(spdk_blob_get_num_clusters(snapshot) == 5);
 
-	write_bytes = g_dev_write_bytes;
-	read_bytes = g_dev_read_bytes;
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 0);
+	CU_ASSERT(spdk_blob_get_num_shared_clusters(blob) == 2);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(snapshot) == 2);
+	CU_ASSERT(spdk_blob_get_num_shared_clusters(snapshot) == 0);
 
-	memset(payload_write, 0xAA, sizeof(payload_write));
-	spdk_blob_io_write(blob, channel, payload_write, 4, 10, blob_op_complete, NULL);
+	/* Writes to shared clusters stop sharing them, others only allocate */
+	spdk_blob_io_write(blob, channel, payload, 0, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(free_clusters != spdk_bs_free_cluster_count(bs));
-
-	/* For a clone we need to allocate and copy one cluster, update one page of metadata
-	 * and then write 10 pages of payload.
-	 */
-	if (g_use_extent_table) {
-		/* Add one more page for EXTENT_PAGE write */
-		CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 12 + cluster_size);
-	} else {
-		CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 11 + cluster_size);
-	}
-	CU_ASSERT(g_dev_read_bytes - read_bytes == cluster_size);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 1);
+	CU_ASSERT(spdk_blob_get_num_shared_clusters(blob) == 1);
 
-	spdk_blob_io_read(blob, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	spdk_blob_io_write(blob, channel, payload, 2 * pages_per_cluster, 1,
+			   blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 2);
+	CU_ASSERT(spdk_blob_get_num_shared_clusters(blob) == 1);
 
-	/* Data on snapshot should not change after write to clone */
-	memset(payload_write, 0xE5, sizeof(payload_write));
-	spdk_blob_io_read(snapshot, channel, payload_read, 4, 10, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+	/* The clone takes over the cluster it still shared */
+	ut_blob_close_and_delete(bs, snapshot);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 3);
+	CU_ASSERT(spdk_blob_get_num_shared_clusters(blob) == 0);
 
 	ut_blob_close_and_delete(bs, blob);
-	ut_blob_close_and_delete(bs, snapshot);
 
 	spdk_bs_free_io_channel(channel);
 	poll_threads();
@@ -6290,6 +7757,7 @@ blob_simultaneous_operations(void)
 	struct spdk_blob *blob, *snapshot;
 	spdk_blob_id blobid, snapshotid;
 	struct spdk_io_channel *channel;
+	int delete_rc;
 
 	channel = spdk_bs_alloc_io_channel(bs);
 	SPDK_CU_ASSERT_FATAL(channel != NULL);
@@ -6330,11 +7798,13 @@ blob_simultaneous_operations(void)
 	CU_ASSERT(blob->locked_operation_in_progress == false);
 	spdk_bs_inflate_blob(bs, channel, blobid, blob_op_complete, NULL);
 	CU_ASSERT(blob->locked_operation_in_progress == true);
-	spdk_bs_delete_blob(bs, blobid, blob_op_complete, NULL);
+	/* Inflate writes its checkpoint first, deletion fails once that is done */
+	delete_rc = 0;
+	spdk_bs_delete_blob(bs, blobid, blob_op_rc_complete, &delete_rc);
 	CU_ASSERT(blob->locked_operation_in_progress == true);
-	/* Deletion failure */
-	CU_ASSERT(g_bserrno == -EBUSY);
 	poll_threads();
+	/* Deletion failure */
+	CU_ASSERT(delete_rc == -EBUSY);
 	CU_ASSERT(blob->locked_operation_in_progress == false);
 	/* Inflation success */
 	CU_ASSERT(g_bserrno == 0);
@@ -6618,6 +8088,7 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite_bs, blob_snapshot);
 	CU_ADD_TEST(suite_bs, blob_clone);
 	CU_ADD_TEST(suite_bs, blob_inflate);
+	CU_ADD_TEST(suite_bs, blob_inflate_throttle);
 	CU_ADD_TEST(suite_bs, blob_delete);
 	CU_ADD_TEST(suite_bs, blob_resize_test);
 	CU_ADD_TEST(suite, blob_read_only);
@@ -6646,17 +8117,29 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite_bs, blob_crc);
 	CU_ADD_TEST(suite, super_block_crc);
 	CU_ADD_TEST(suite_blob, blob_dirty_shutdown);
+	CU_ADD_TEST(suite, blob_dirty_shutdown_md_limit);
+	CU_ADD_TEST(suite_bs, blob_sync_md_coalesce);
 	CU_ADD_TEST(suite_bs, blob_flags);
 	CU_ADD_TEST(suite_bs, bs_version);
 	CU_ADD_TEST(suite_bs, blob_set_xattrs_test);
 	CU_ADD_TEST(suite_bs, blob_thin_prov_alloc);
 	CU_ADD_TEST(suite_bs, blob_insert_cluster_msg_test);
 	CU_ADD_TEST(suite_bs, blob_thin_prov_rw);
+	CU_ADD_TEST(suite_bs, blob_thin_prov_concurrent_alloc);
+	CU_ADD_TEST(suite, blob_inflate_cancel);
+	CU_ADD_TEST(suite, blob_thin_prov_reserve);
+	CU_ADD_TEST(suite, blob_thin_prov_reserve_reclaim);
+	CU_ADD_TEST(suite, blob_clone_cow_units);
 	CU_ADD_TEST(suite_bs, blob_thin_prov_rle);
 	CU_ADD_TEST(suite_bs, blob_thin_prov_rw_iov);
 	CU_ADD_TEST(suite, bs_load_iter_test);
 	CU_ADD_TEST(suite_bs, blob_snapshot_rw);
+	CU_ADD_TEST(suite_bs, blob_snapshot_copy_dev);
 	CU_ADD_TEST(suite_bs, blob_snapshot_rw_iov);
+	CU_ADD_TEST(suite_bs, blob_snapshot_chain_read);
+	CU_ADD_TEST(suite_bs, blob_deferred_unmap);
+	CU_ADD_TEST(suite_bs, blob_deferred_unmap_enospc);
+	CU_ADD_TEST(suite_bs, blob_cluster_accounting);
 	CU_ADD_TEST(suite, blob_relations);
 	CU_ADD_TEST(suite, blob_relations2);
 	CU_ADD_TEST(suite, blobstore_clean_power_failure);
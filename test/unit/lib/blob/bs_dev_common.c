@@ -41,6 +41,9 @@
 uint8_t *g_dev_buffer;
 uint64_t g_dev_write_bytes;
 uint64_t g_dev_read_bytes;
+uint64_t g_dev_copy_bytes;
+uint64_t g_dev_write_ops;
+uint64_t g_dev_unmap_ops;
 
 struct spdk_power_failure_counters {
 	uint64_t general_counter;
@@ -191,6 +194,7 @@ dev_write(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, void *payloa
 
 		memcpy(&g_dev_buffer[offset], payload, length);
 		g_dev_write_bytes += length;
+		g_dev_write_ops++;
 	} else {
 		g_power_failure_rc = -EIO;
 	}
@@ -281,6 +285,7 @@ dev_writev(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
 		}
 
 		g_dev_write_bytes += length;
+		g_dev_write_ops++;
 	} else {
 		g_power_failure_rc = -EIO;
 	}
@@ -317,6 +322,8 @@ dev_unmap(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
 {
 	uint64_t offset, length;
 
+	g_dev_unmap_ops++;
+
 	if (g_power_failure_thresholds.unmap_threshold != 0) {
 		g_power_failure_counters.unmap_counter++;
 	}
@@ -371,6 +378,40 @@ dev_write_zeroes(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
 	spdk_thread_send_msg(spdk_get_thread(), dev_complete, cb_args);
 }
 
+static void
+dev_copy(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+	 uint64_t dst_lba, uint64_t src_lba, uint32_t lba_count,
+	 struct spdk_bs_dev_cb_args *cb_args)
+{
+	uint64_t dst_offset, src_offset, length;
+
+	if (g_power_failure_thresholds.write_threshold != 0) {
+		g_power_failure_counters.write_counter++;
+	}
+
+	if (g_power_failure_thresholds.general_threshold != 0) {
+		g_power_failure_counters.general_counter++;
+	}
+
+	if ((g_power_failure_thresholds.write_threshold == 0 ||
+	     g_power_failure_counters.write_counter < g_power_failure_thresholds.write_threshold)  &&
+	    (g_power_failure_thresholds.general_threshold == 0 ||
+	     g_power_failure_counters.general_counter < g_power_failure_thresholds.general_threshold)) {
+		dst_offset = dst_lba * dev->blocklen;
+		src_offset = src_lba * dev->blocklen;
+		length = lba_count * dev->blocklen;
+		SPDK_CU_ASSERT_FATAL(dst_offset + length <= DEV_BUFFER_SIZE);
+		SPDK_CU_ASSERT_FATAL(src_offset + length <= DEV_BUFFER_SIZE);
+		memcpy(&g_dev_buffer[dst_offset], &g_dev_buffer[src_offset], length);
+		g_dev_write_bytes += length;
+		g_dev_copy_bytes += length;
+	} else {
+		g_power_failure_rc = -EIO;
+	}
+
+	spdk_thread_send_msg(spdk_get_thread(), dev_complete, cb_args);
+}
+
 static struct spdk_bs_dev *
 init_dev(void)
 {
@@ -388,6 +429,7 @@ init_dev(void)
 	dev->flush = dev_flush;
 	dev->unmap = dev_unmap;
 	dev->write_zeroes = dev_write_zeroes;
+	dev->copy = dev_copy;
 	dev->blockcnt = DEV_BUFFER_BLOCKCNT;
 	dev->blocklen = DEV_BUFFER_BLOCKLEN;
 
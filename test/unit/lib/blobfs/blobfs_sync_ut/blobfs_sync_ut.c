@@ -616,6 +616,109 @@ fs_delete_file_without_close(void)
 
 }
 
+static bool
+file_readahead_in_progress(struct spdk_file *file)
+{
+	struct cache_buffer *buf;
+	uint64_t offset;
+	bool in_progress = false;
+
+	pthread_spin_lock(&file->lock);
+	for (offset = 0; offset < file->length; offset += CACHE_BUFFER_SIZE) {
+		buf = tree_find_buffer(file->tree, offset);
+		if (buf != NULL && buf->in_progress) {
+			in_progress = true;
+			break;
+		}
+	}
+	pthread_spin_unlock(&file->lock);
+
+	return in_progress;
+}
+
+static void
+cache_readahead(void)
+{
+	const uint64_t file_size = 8 * CACHE_BUFFER_SIZE;
+	const uint64_t read_size = 64 * 1024;
+	/* Readahead limit set on the file and the number of buffers expected to be
+	 * read ahead once the first two reads made the stream sequential.
+	 */
+	const uint64_t readahead_max[] = { CACHE_READAHEAD_MAX_DEFAULT, CACHE_BUFFER_SIZE, 0 };
+	const uint64_t readaheads[] = { 2, 1, 0 };
+	struct spdk_fs_thread_ctx *channel;
+	struct spdk_fs_cache_stats stats;
+	uint64_t offset, i;
+	int64_t nread;
+	char *w_buf, *r_buf;
+	int rc;
+
+	w_buf = malloc(file_size);
+	r_buf = malloc(file_size);
+	SPDK_CU_ASSERT_FATAL(w_buf != NULL && r_buf != NULL);
+	for (offset = 0; offset < file_size; offset++) {
+		w_buf[offset] = (char)(offset / 4096);
+	}
+
+	ut_send_request(_fs_init, NULL);
+	channel = spdk_fs_alloc_thread_ctx(g_fs);
+
+	rc = spdk_fs_open_file(g_fs, channel, "testfile", SPDK_BLOBFS_OPEN_CREATE, &g_file);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_file != NULL);
+	rc = spdk_file_write(g_file, channel, w_buf, 0, file_size);
+	CU_ASSERT(rc == 0);
+	spdk_file_close(g_file, channel);
+	fs_thread_poll();
+
+	spdk_fs_free_thread_ctx(channel);
+	ut_send_request(_fs_unload, NULL);
+
+	for (i = 0; i < SPDK_COUNTOF(readahead_max); i++) {
+		/* Reload the filesystem so that nothing of the file is in the cache */
+		ut_send_request(_fs_load, NULL);
+		channel = spdk_fs_alloc_thread_ctx(g_fs);
+
+		rc = spdk_fs_open_file(g_fs, channel, "testfile", 0, &g_file);
+		CU_ASSERT(rc == 0);
+		SPDK_CU_ASSERT_FATAL(g_file != NULL);
+		spdk_file_set_readahead(g_file, readahead_max[i]);
+
+		memset(r_buf, 0, file_size);
+		for (offset = 0; offset < file_size; offset += read_size) {
+			nread = spdk_file_read(g_file, channel, r_buf + offset, offset, read_size);
+			CU_ASSERT(nread == (int64_t)read_size);
+
+			if (offset + read_size == CACHE_READAHEAD_THRESHOLD) {
+				spdk_fs_get_cache_stats(&stats);
+				CU_ASSERT(stats.readaheads == readaheads[i]);
+			}
+		}
+		CU_ASSERT(memcmp(w_buf, r_buf, file_size) == 0);
+
+		while (file_readahead_in_progress(g_file)) {}
+
+		/* Every buffer but the first one is read ahead unless disabled */
+		spdk_fs_get_cache_stats(&stats);
+		CU_ASSERT(stats.hits + stats.misses == file_size / read_size);
+		if (readahead_max[i] == 0) {
+			CU_ASSERT(stats.readaheads == 0);
+			CU_ASSERT(stats.hits == 0);
+		} else {
+			CU_ASSERT(stats.readaheads == file_size / CACHE_BUFFER_SIZE - 1);
+		}
+
+		spdk_file_close(g_file, channel);
+		fs_thread_poll();
+
+		spdk_fs_free_thread_ctx(channel);
+		ut_send_request(_fs_unload, NULL);
+	}
+
+	free(w_buf);
+	free(r_buf);
+}
+
 static bool g_thread_exit = false;
 
 static void
@@ -659,6 +762,7 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, fs_rename_sync);
 	CU_ADD_TEST(suite, cache_append_no_cache);
 	CU_ADD_TEST(suite, fs_delete_file_without_close);
+	CU_ADD_TEST(suite, cache_readahead);
 
 	spdk_thread_lib_init(NULL, 0);
 
@@ -73,6 +73,10 @@ int g_lvserrno;
 int g_close_super_status;
 int g_resize_rc;
 int g_inflate_rc;
+bool g_inflate_background;
+spdk_blob_id g_inflate_blobid;
+spdk_blob_op_complete g_inflate_cb_fn;
+void *g_inflate_cb_arg;
 int g_remove_rc;
 bool g_lvs_rename_blob_open_error = false;
 struct spdk_lvol_store *g_lvol_store;
@@ -94,6 +98,9 @@ struct lvol_ut_bs_dev {
 	struct spdk_blob_store	*bs;
 };
 
+DEFINE_STUB(spdk_blob_get_inflate_progress, int, (struct spdk_blob *blob,
+		struct spdk_blob_inflate_progress *progress), -ENOENT);
+
 void spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 			  spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
 {
@@ -106,6 +113,45 @@ void spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_cha
 	cb_fn(cb_arg, g_inflate_rc);
 }
 
+void spdk_bs_inflate_blob_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			      spdk_blob_id blobid, const struct spdk_blob_inflate_opts *opts,
+			      spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	if (g_inflate_background) {
+		/* Keeps running until it is canceled */
+		g_inflate_blobid = blobid;
+		g_inflate_cb_fn = cb_fn;
+		g_inflate_cb_arg = cb_arg;
+		return;
+	}
+
+	cb_fn(cb_arg, g_inflate_rc);
+}
+
+int
+spdk_bs_inflate_blob_cancel(struct spdk_blob_store *bs, spdk_blob_id blobid,
+			    spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	spdk_blob_op_complete inflate_cb_fn = g_inflate_cb_fn;
+
+	if (inflate_cb_fn == NULL || blobid != g_inflate_blobid) {
+		return -ENOENT;
+	}
+
+	g_inflate_cb_fn = NULL;
+	inflate_cb_fn(g_inflate_cb_arg, -ECANCELED);
+	cb_fn(cb_arg, 0);
+
+	return 0;
+}
+
+void spdk_bs_blob_decouple_parent_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+				      spdk_blob_id blobid, const struct spdk_blob_inflate_opts *opts,
+				      spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	spdk_bs_inflate_blob_ext(bs, channel, blobid, opts, cb_fn, cb_arg);
+}
+
 void
 spdk_bs_iter_next(struct spdk_blob_store *bs, struct spdk_blob *b,
 		  spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
@@ -1995,6 +2041,81 @@ lvol_inflate(void)
 	CU_ASSERT(g_io_channel == NULL);
 }
 
+static void
+inflate_complete(void *cb_arg, int lvolerrno)
+{
+	*(int *)cb_arg = lvolerrno;
+}
+
+static void
+lvol_inflate_cancel(void)
+{
+	struct lvol_ut_bs_dev dev;
+	struct spdk_lvs_opts opts;
+	struct spdk_lvol *lvol;
+	int inflate_rc;
+	int rc = 0;
+
+	init_dev(&dev);
+
+	spdk_lvs_opts_init(&opts);
+	snprintf(opts.name, sizeof(opts.name), "lvs");
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_init(&dev.bs_dev, &opts, lvol_store_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+
+	g_inflate_background = true;
+
+	/* Destroying an lvol cancels the inflate that keeps its blob open */
+	spdk_lvol_create(g_lvol_store, "lvol1", 10, false, LVOL_CLEAR_WITH_DEFAULT,
+			 lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	lvol = g_lvol;
+
+	inflate_rc = 1;
+	spdk_lvol_inflate_ext(lvol, NULL, inflate_complete, &inflate_rc);
+	CU_ASSERT(inflate_rc == 1);
+
+	spdk_lvol_close(lvol, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	g_lvserrno = -1;
+	spdk_lvol_destroy(lvol, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(inflate_rc == -ECANCELED);
+	CU_ASSERT(g_inflate_cb_fn == NULL);
+
+	/* So does unloading the lvol store */
+	spdk_lvol_create(g_lvol_store, "lvol2", 10, false, LVOL_CLEAR_WITH_DEFAULT,
+			 lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	lvol = g_lvol;
+
+	inflate_rc = 1;
+	spdk_lvol_decouple_parent_ext(lvol, NULL, inflate_complete, &inflate_rc);
+	CU_ASSERT(inflate_rc == 1);
+
+	spdk_lvol_close(lvol, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_unload(g_lvol_store, op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(inflate_rc == -ECANCELED);
+	CU_ASSERT(g_inflate_cb_fn == NULL);
+	g_lvol_store = NULL;
+
+	g_inflate_background = false;
+
+	free_dev(&dev);
+	CU_ASSERT(g_io_channel == NULL);
+}
+
 static void
 lvol_decouple_parent(void)
 {
@@ -2080,6 +2201,7 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, lvol_rename);
 	CU_ADD_TEST(suite, lvs_rename);
 	CU_ADD_TEST(suite, lvol_inflate);
+	CU_ADD_TEST(suite, lvol_inflate_cancel);
 	CU_ADD_TEST(suite, lvol_decouple_parent);
 
 	allocate_threads(1);
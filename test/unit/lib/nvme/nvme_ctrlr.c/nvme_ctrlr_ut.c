@@ -67,6 +67,9 @@ DEFINE_STUB(nvme_ctrlr_cmd_set_host_id, int,
 	    (struct spdk_nvme_ctrlr *ctrlr, void *host_id, uint32_t host_id_size,
 	     spdk_nvme_cmd_cb cb_fn, void *cb_arg), 0);
 DEFINE_STUB_V(nvme_ns_set_identify_data, (struct spdk_nvme_ns *ns));
+DEFINE_STUB_V(nvme_ns_set_id_desc_list_data, (struct spdk_nvme_ns *ns));
+DEFINE_STUB_V(nvme_ns_free_zns_specific_data, (struct spdk_nvme_ns *ns));
+DEFINE_STUB(nvme_ns_alloc_zns_specific_data, int, (struct spdk_nvme_ns *ns), 0);
 DEFINE_STUB_V(nvme_qpair_abort_reqs, (struct spdk_nvme_qpair *qpair, uint32_t dnr));
 DEFINE_STUB(spdk_nvme_poll_group_remove, int, (struct spdk_nvme_poll_group *group,
 		struct spdk_nvme_qpair *qpair), 0);
@@ -213,6 +216,7 @@ int nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
 
 static struct spdk_nvme_cpl fake_cpl = {};
 static enum spdk_nvme_generic_command_status_code set_status_code = SPDK_NVME_SC_SUCCESS;
+static uint8_t g_ut_zasl;
 
 static void
 fake_cpl_sc(spdk_nvme_cmd_cb cb_fn, void *cb_arg)
@@ -334,7 +338,7 @@ nvme_ctrlr_cmd_set_async_event_config(struct spdk_nvme_ctrlr *ctrlr,
 
 int
 nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr, uint8_t cns, uint16_t cntid, uint32_t nsid,
-			void *payload, size_t payload_size,
+			uint8_t csi, void *payload, size_t payload_size,
 			spdk_nvme_cmd_cb cb_fn, void *cb_arg)
 {
 	if (cns == SPDK_NVME_IDENTIFY_ACTIVE_NS_LIST) {
@@ -353,6 +357,10 @@ nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr, uint8_t cns, uint16_t cnt
 			}
 		}
 
+	} else if (cns == SPDK_NVME_IDENTIFY_CTRLR_IOCS && csi == SPDK_NVME_CSI_ZNS) {
+		struct spdk_nvme_zns_ctrlr_data *cdata_zns = payload;
+
+		cdata_zns->zasl = g_ut_zasl;
 	}
 
 	fake_cpl_sc(cb_fn, cb_arg);
@@ -1974,6 +1982,8 @@ test_nvme_ctrlr_init_set_nvmf_ioccsz(void)
 
 	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY;
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_CONSTRUCT_NS);
@@ -1988,6 +1998,8 @@ test_nvme_ctrlr_init_set_nvmf_ioccsz(void)
 
 	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY;
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_CONSTRUCT_NS);
@@ -2004,6 +2016,8 @@ test_nvme_ctrlr_init_set_nvmf_ioccsz(void)
 
 	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY;
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_CONSTRUCT_NS);
@@ -2020,6 +2034,8 @@ test_nvme_ctrlr_init_set_nvmf_ioccsz(void)
 
 	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY;
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_CONSTRUCT_NS);
@@ -2036,6 +2052,8 @@ test_nvme_ctrlr_init_set_nvmf_ioccsz(void)
 
 	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY;
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_CONSTRUCT_NS);
@@ -2052,6 +2070,9 @@ test_nvme_ctrlr_init_set_num_queues(void)
 	DECLARE_AND_CONSTRUCT_CTRLR();
 
 	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0); /* -> IDENTIFY_IOCS_SPECIFIC */
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC);
+
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0); /* -> SET_NUM_QUEUES */
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
 
@@ -2066,6 +2087,92 @@ test_nvme_ctrlr_init_set_num_queues(void)
 	nvme_ctrlr_destruct(&ctrlr);
 }
 
+static void
+test_nvme_ctrlr_init_iocs_specific(void)
+{
+	DECLARE_AND_CONSTRUCT_CTRLR();
+
+	ctrlr.opts.command_set = SPDK_NVME_CC_CSS_IOCS;
+	ctrlr.min_page_size = 4096;
+	ctrlr.max_xfer_size = 128 * 1024;
+
+	/* A ZASL of 0 limits zone appends to MDTS */
+	g_ut_zasl = 0;
+	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0); /* -> SET_NUM_QUEUES */
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
+	SPDK_CU_ASSERT_FATAL(ctrlr.cdata_zns != NULL);
+	CU_ASSERT(ctrlr.max_zone_append_size == 128 * 1024);
+
+	/* ZASL is a power of two in units of the minimum page size */
+	g_ut_zasl = 3;
+	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
+	CU_ASSERT(ctrlr.max_zone_append_size == 32 * 1024);
+
+	/* ZASL larger than MDTS */
+	g_ut_zasl = 10;
+	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
+	CU_ASSERT(ctrlr.max_zone_append_size == 128 * 1024);
+	g_ut_zasl = 0;
+
+	/* A controller that does not implement ZNS fails the identify, that is not fatal */
+	set_status_code = SPDK_NVME_SC_INVALID_FIELD;
+	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
+	CU_ASSERT(ctrlr.cdata_zns == NULL);
+	CU_ASSERT(ctrlr.max_zone_append_size == 0);
+	set_status_code = SPDK_NVME_SC_SUCCESS;
+
+	/* Controllers enabled with the NVM command set only are not asked */
+	ctrlr.opts.command_set = SPDK_NVME_CC_CSS_NVM;
+	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_NUM_QUEUES);
+	CU_ASSERT(ctrlr.cdata_zns == NULL);
+	CU_ASSERT(ctrlr.max_zone_append_size == 0);
+
+	nvme_ctrlr_destruct(&ctrlr);
+}
+
+static void
+test_nvme_ctrlr_init_ns_iocs_specific(void)
+{
+	DECLARE_AND_CONSTRUCT_CTRLR();
+
+	ctrlr.opts.command_set = SPDK_NVME_CC_CSS_IOCS;
+	ctrlr.page_size = 0x1000;
+	ctrlr.vs.bits.mjr = 1;
+	ctrlr.vs.bits.mnr = 2;
+	ctrlr.num_ns = 2;
+	ctrlr.ns = calloc(ctrlr.num_ns, sizeof(struct spdk_nvme_ns));
+	SPDK_CU_ASSERT_FATAL(ctrlr.ns != NULL);
+	CU_ASSERT(nvme_ctrlr_identify_active_ns(&ctrlr) == 0);
+	ctrlr.ns[0].ctrlr = &ctrlr;
+	ctrlr.ns[0].id = 1;
+	ctrlr.ns[0].csi = SPDK_NVME_CSI_NVM;
+	ctrlr.ns[1].ctrlr = &ctrlr;
+	ctrlr.ns[1].id = 2;
+	ctrlr.ns[1].csi = SPDK_NVME_CSI_ZNS;
+
+	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0); /* -> CONFIGURE_AER */
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_CONFIGURE_AER);
+
+	/* A zoned namespace whose identify fails does not abort the initialization */
+	set_status_code = SPDK_NVME_SC_INVALID_FIELD;
+	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_CONFIGURE_AER);
+	set_status_code = SPDK_NVME_SC_SUCCESS;
+
+	nvme_ctrlr_destruct(&ctrlr);
+}
+
 static void
 test_nvme_ctrlr_init_set_keep_alive_timeout(void)
 {
@@ -2139,6 +2246,8 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_spdk_nvme_ctrlr_set_trid);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_init_set_nvmf_ioccsz);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_init_set_num_queues);
+	CU_ADD_TEST(suite, test_nvme_ctrlr_init_iocs_specific);
+	CU_ADD_TEST(suite, test_nvme_ctrlr_init_ns_iocs_specific);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_init_set_keep_alive_timeout);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
@@ -0,0 +1,455 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_cunit.h"
+
+#include "nvme/nvme_mem.c"
+#include "common/lib/nvme/common_stubs.h"
+
+SPDK_LOG_REGISTER_COMPONENT("nvme", SPDK_LOG_NVME);
+
+DEFINE_STUB(nvme_ctrlr_probe, int, (const struct spdk_nvme_transport_id *trid,
+				    struct spdk_nvme_probe_ctx *probe_ctx, void *devhandle), 0);
+DEFINE_STUB_V(spdk_nvme_qpair_print_command, (struct spdk_nvme_qpair *qpair,
+		struct spdk_nvme_cmd *cmd));
+DEFINE_STUB_V(spdk_nvme_qpair_print_completion, (struct spdk_nvme_qpair *qpair,
+		struct spdk_nvme_cpl *cpl));
+
+static struct spdk_nvme_cpl g_cpl;
+static uint32_t g_num_cpls;
+
+static void
+ut_cpl_cb(void *cb_arg, const struct spdk_nvme_cpl *cpl)
+{
+	g_cpl = *cpl;
+	g_num_cpls++;
+}
+
+static void
+ut_ctrlr_init(struct nvme_mem_ctrlr *mctrlr, const char *traddr)
+{
+	memset(mctrlr, 0, sizeof(*mctrlr));
+	mctrlr->ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_CUSTOM;
+	snprintf(mctrlr->ctrlr.trid.traddr, sizeof(mctrlr->ctrlr.trid.traddr), "%s", traddr);
+	mctrlr->ctrlr.opts.disable_error_logging = true;
+	pthread_mutex_init(&mctrlr->ctrlr.ctrlr_lock, NULL);
+
+	SPDK_CU_ASSERT_FATAL(nvme_mem_parse_opts(traddr, &mctrlr->opts) == 0);
+	if (mctrlr->opts.store_data) {
+		mctrlr->data = calloc(mctrlr->opts.num_blocks, mctrlr->opts.block_size);
+		SPDK_CU_ASSERT_FATAL(mctrlr->data != NULL);
+	}
+	mctrlr->ticks_hz = spdk_get_ticks_hz();
+	mctrlr->latency_ticks = mctrlr->opts.latency_us * mctrlr->ticks_hz / SPDK_SEC_TO_USEC;
+	mctrlr->bytes_per_sec = (uint64_t)mctrlr->opts.mb_per_sec * 1000 * 1000;
+	nvme_mem_ctrlr_init_data(mctrlr);
+	mctrlr->num_io_queues = mctrlr->opts.io_queues;
+}
+
+static struct nvme_mem_qpair *
+ut_qpair_create(struct nvme_mem_ctrlr *mctrlr, uint16_t qid, uint32_t qsize)
+{
+	struct spdk_nvme_qpair *qpair;
+
+	qpair = nvme_mem_ctrlr_create_qpair(&mctrlr->ctrlr, qid, qsize, 0, qsize);
+	SPDK_CU_ASSERT_FATAL(qpair != NULL);
+
+	/* nvme_qpair_init() is stubbed out */
+	qpair->id = qid;
+	qpair->ctrlr = &mctrlr->ctrlr;
+	STAILQ_INIT(&qpair->free_req);
+	TAILQ_INIT(&qpair->err_cmd_head);
+
+	return nvme_mem_qpair(qpair);
+}
+
+static void
+ut_req_init(struct nvme_request *req, struct nvme_mem_qpair *mqpair, uint8_t opc,
+	    uint64_t lba, uint32_t num_blocks, void *buf, uint32_t len)
+{
+	memset(req, 0, sizeof(*req));
+	req->qpair = &mqpair->qpair;
+	req->cb_fn = ut_cpl_cb;
+	req->payload = NVME_PAYLOAD_CONTIG(buf, NULL);
+	req->payload_size = len;
+	req->cmd.opc = opc;
+	req->cmd.nsid = NVME_MEM_NSID;
+	*(uint64_t *)&req->cmd.cdw10 = lba;
+	req->cmd.cdw12 = num_blocks - 1;
+}
+
+static void
+test_nvme_mem_parse_opts(void)
+{
+	struct nvme_mem_ctrlr_opts opts;
+
+	CU_ASSERT(nvme_mem_parse_opts("mem0", &opts) == 0);
+	CU_ASSERT(opts.block_size == NVME_MEM_DEFAULT_BLOCK_SIZE);
+	CU_ASSERT(opts.num_blocks == NVME_MEM_DEFAULT_NUM_BLOCKS);
+	CU_ASSERT(opts.io_queues == NVME_MEM_DEFAULT_IO_QUEUES);
+	CU_ASSERT(opts.queue_size == NVME_MEM_DEFAULT_QUEUE_SIZE);
+	CU_ASSERT(opts.max_xfer_size == NVME_MEM_DEFAULT_MAX_XFER_SIZE);
+	CU_ASSERT(opts.latency_us == 0);
+	CU_ASSERT(opts.mb_per_sec == 0);
+	CU_ASSERT(opts.store_data == false);
+
+	CU_ASSERT(nvme_mem_parse_opts("mem0,block_size=4096,num_blocks=0x100000000,io_queues=4,"
+				      "queue_size=64,max_xfer_size=1048576,latency_us=20,"
+				      "mb_per_sec=3000,store_data=1", &opts) == 0);
+	CU_ASSERT(opts.block_size == 4096);
+	CU_ASSERT(opts.num_blocks == 0x100000000ULL);
+	CU_ASSERT(opts.io_queues == 4);
+	CU_ASSERT(opts.queue_size == 64);
+	CU_ASSERT(opts.max_xfer_size == 1048576);
+	CU_ASSERT(opts.latency_us == 20);
+	CU_ASSERT(opts.mb_per_sec == 3000);
+	CU_ASSERT(opts.store_data == true);
+
+	CU_ASSERT(nvme_mem_parse_opts("", &opts) == -EINVAL);
+	CU_ASSERT(nvme_mem_parse_opts("mem0,latency_us", &opts) == -EINVAL);
+	CU_ASSERT(nvme_mem_parse_opts("mem0,foo=1", &opts) == -EINVAL);
+	CU_ASSERT(nvme_mem_parse_opts("mem0,latency_us=-1", &opts) == -EINVAL);
+	CU_ASSERT(nvme_mem_parse_opts("mem0,latency_us=0x100000000", &opts) == -EINVAL);
+	CU_ASSERT(nvme_mem_parse_opts("mem0,block_size=520", &opts) == -EINVAL);
+	CU_ASSERT(nvme_mem_parse_opts("mem0,block_size=8192", &opts) == -EINVAL);
+	CU_ASSERT(nvme_mem_parse_opts("mem0,num_blocks=0", &opts) == -EINVAL);
+	CU_ASSERT(nvme_mem_parse_opts("mem0,queue_size=1", &opts) == -EINVAL);
+	CU_ASSERT(nvme_mem_parse_opts("mem0,max_xfer_size=6144", &opts) == -EINVAL);
+}
+
+static void
+test_nvme_mem_io(void)
+{
+	struct nvme_mem_ctrlr mctrlr;
+	struct nvme_mem_qpair *mqpair;
+	struct nvme_request req;
+	uint8_t wbuf[4096], rbuf[4096];
+	uint32_t i;
+
+	ut_ctrlr_init(&mctrlr, "mem0,num_blocks=64,store_data=1");
+	mqpair = ut_qpair_create(&mctrlr, 1, 4);
+
+	memset(wbuf, 0xA5, sizeof(wbuf));
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_WRITE, 8, 8, wbuf, sizeof(wbuf));
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(req.cmd.cid == TAILQ_FIRST(&mqpair->outstanding_tr)->cid);
+
+	g_num_cpls = 0;
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(g_num_cpls == 1);
+	CU_ASSERT(!spdk_nvme_cpl_is_error(&g_cpl));
+	CU_ASSERT(TAILQ_EMPTY(&mqpair->outstanding_tr));
+	CU_ASSERT(memcmp(mctrlr.data + 8 * 512, wbuf, sizeof(wbuf)) == 0);
+
+	/* Read it back, going around the queues a few times to flip the phase */
+	for (i = 0; i < 10; i++) {
+		memset(rbuf, 0, sizeof(rbuf));
+		ut_req_init(&req, mqpair, SPDK_NVME_OPC_READ, 8, 8, rbuf, sizeof(rbuf));
+		CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+		g_num_cpls = 0;
+		CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+		CU_ASSERT(g_num_cpls == 1);
+		CU_ASSERT(!spdk_nvme_cpl_is_error(&g_cpl));
+		CU_ASSERT(memcmp(rbuf, wbuf, sizeof(wbuf)) == 0);
+	}
+
+	/* Compare against matching and different data */
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_COMPARE, 8, 8, wbuf, sizeof(wbuf));
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(!spdk_nvme_cpl_is_error(&g_cpl));
+
+	rbuf[100] ^= 0xFF;
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_COMPARE, 8, 8, rbuf, sizeof(rbuf));
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(g_cpl.status.sct == SPDK_NVME_SCT_MEDIA_ERROR);
+	CU_ASSERT(g_cpl.status.sc == SPDK_NVME_SC_COMPARE_FAILURE);
+
+	/* Write zeroes */
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_WRITE_ZEROES, 8, 4, NULL, 0);
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(!spdk_nvme_cpl_is_error(&g_cpl));
+	CU_ASSERT(spdk_mem_all_zero(mctrlr.data + 8 * 512, 4 * 512));
+	CU_ASSERT(memcmp(mctrlr.data + 12 * 512, wbuf, 4 * 512) == 0);
+
+	/* Out of range */
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_READ, 60, 8, rbuf, sizeof(rbuf));
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(g_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(g_cpl.status.sc == SPDK_NVME_SC_LBA_OUT_OF_RANGE);
+
+	/* Wrong namespace */
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_READ, 0, 8, rbuf, sizeof(rbuf));
+	req.cmd.nsid = 2;
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(g_cpl.status.sc == SPDK_NVME_SC_INVALID_NAMESPACE_OR_FORMAT);
+
+	nvme_mem_ctrlr_delete_io_qpair(&mctrlr.ctrlr, &mqpair->qpair);
+	free(mctrlr.data);
+	pthread_mutex_destroy(&mctrlr.ctrlr.ctrlr_lock);
+}
+
+static void
+test_nvme_mem_queue_full(void)
+{
+	struct nvme_mem_ctrlr mctrlr;
+	struct nvme_mem_qpair *mqpair;
+	struct nvme_request req[4];
+	uint8_t buf[512];
+	int i;
+
+	ut_ctrlr_init(&mctrlr, "mem0");
+	mqpair = ut_qpair_create(&mctrlr, 1, 4);
+
+	/* One entry of the queue always stays empty */
+	for (i = 0; i < 3; i++) {
+		ut_req_init(&req[i], mqpair, SPDK_NVME_OPC_READ, i, 1, buf, sizeof(buf));
+		CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req[i]) == 0);
+	}
+	ut_req_init(&req[3], mqpair, SPDK_NVME_OPC_READ, 3, 1, buf, sizeof(buf));
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req[3]) == -EAGAIN);
+
+	/* Completions are limited by max_completions */
+	g_num_cpls = 0;
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 2) == 2);
+	CU_ASSERT(g_num_cpls == 2);
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req[3]) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 2);
+	CU_ASSERT(g_num_cpls == 4);
+	CU_ASSERT(TAILQ_EMPTY(&mqpair->outstanding_tr));
+
+	/* Deleting the queue aborts what is still outstanding */
+	ut_req_init(&req[0], mqpair, SPDK_NVME_OPC_READ, 0, 1, buf, sizeof(buf));
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req[0]) == 0);
+	g_num_cpls = 0;
+	nvme_mem_ctrlr_delete_io_qpair(&mctrlr.ctrlr, &mqpair->qpair);
+	CU_ASSERT(g_num_cpls == 1);
+	CU_ASSERT(g_cpl.status.sc == SPDK_NVME_SC_ABORTED_BY_REQUEST);
+
+	pthread_mutex_destroy(&mctrlr.ctrlr.ctrlr_lock);
+}
+
+static void
+test_nvme_mem_latency(void)
+{
+	struct nvme_mem_ctrlr mctrlr;
+	struct nvme_mem_qpair *mqpair;
+	struct nvme_request req[2];
+	uint8_t buf[2][4096];
+
+	/* 10us per command and 4096 bytes take 4us at 1024 MB/s */
+	ut_ctrlr_init(&mctrlr, "mem0,latency_us=10,mb_per_sec=1024");
+	mqpair = ut_qpair_create(&mctrlr, 1, 8);
+
+	MOCK_SET(spdk_get_ticks, 100);
+	ut_req_init(&req[0], mqpair, SPDK_NVME_OPC_WRITE, 0, 8, buf[0], sizeof(buf[0]));
+	ut_req_init(&req[1], mqpair, SPDK_NVME_OPC_WRITE, 8, 8, buf[1], sizeof(buf[1]));
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req[0]) == 0);
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req[1]) == 0);
+
+	g_num_cpls = 0;
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 0);
+
+	/* The first transfer is done at 104, the second one waits for it until 108 */
+	MOCK_SET(spdk_get_ticks, 113);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 0);
+	MOCK_SET(spdk_get_ticks, 114);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	MOCK_SET(spdk_get_ticks, 117);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 0);
+	MOCK_SET(spdk_get_ticks, 118);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(g_num_cpls == 2);
+
+	/* An idle media does not carry the time it was busy over */
+	MOCK_SET(spdk_get_ticks, 1000);
+	ut_req_init(&req[0], mqpair, SPDK_NVME_OPC_FLUSH, 0, 1, NULL, 0);
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req[0]) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 0);
+	MOCK_SET(spdk_get_ticks, 1010);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(g_num_cpls == 3);
+
+	MOCK_CLEAR(spdk_get_ticks);
+	nvme_mem_ctrlr_delete_io_qpair(&mctrlr.ctrlr, &mqpair->qpair);
+	pthread_mutex_destroy(&mctrlr.ctrlr.ctrlr_lock);
+}
+
+static void
+test_nvme_mem_admin(void)
+{
+	struct nvme_mem_ctrlr mctrlr;
+	struct nvme_mem_qpair *mqpair;
+	struct nvme_request req, aer_req;
+	struct spdk_nvme_ctrlr_data cdata;
+	struct spdk_nvme_ns_data nsdata;
+	struct spdk_nvme_ns_list ns_list;
+	union spdk_nvme_feat_number_of_queues num_queues;
+
+	ut_ctrlr_init(&mctrlr, "mem0,num_blocks=1000,io_queues=4,max_xfer_size=65536");
+	mqpair = ut_qpair_create(&mctrlr, 0, 32);
+
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_IDENTIFY, 0, 1, &cdata, sizeof(cdata));
+	req.cmd.nsid = 0;
+	req.cmd.cdw10 = 0;
+	req.cmd.cdw10_bits.identify.cns = SPDK_NVME_IDENTIFY_CTRLR;
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(!spdk_nvme_cpl_is_error(&g_cpl));
+	CU_ASSERT(cdata.nn == 1);
+	CU_ASSERT(cdata.mdts == 4);
+	CU_ASSERT(cdata.oncs.write_zeroes == 1);
+
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_IDENTIFY, 0, 1, &ns_list, sizeof(ns_list));
+	req.cmd.nsid = 0;
+	req.cmd.cdw10 = 0;
+	req.cmd.cdw10_bits.identify.cns = SPDK_NVME_IDENTIFY_ACTIVE_NS_LIST;
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(ns_list.ns_list[0] == NVME_MEM_NSID);
+	CU_ASSERT(ns_list.ns_list[1] == 0);
+
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_IDENTIFY, 0, 1, &nsdata, sizeof(nsdata));
+	req.cmd.cdw10 = 0;
+	req.cmd.cdw10_bits.identify.cns = SPDK_NVME_IDENTIFY_NS;
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(nsdata.nsze == 1000);
+	CU_ASSERT(nsdata.lbaf[0].lbads == 9);
+
+	/* The number of queues granted is capped by io_queues */
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_SET_FEATURES, 0, 1, NULL, 0);
+	req.cmd.cdw10 = 0;
+	req.cmd.cdw10_bits.set_features.fid = SPDK_NVME_FEAT_NUMBER_OF_QUEUES;
+	req.cmd.cdw11_bits.feat_num_of_queues.bits.nsqr = 15;
+	req.cmd.cdw11_bits.feat_num_of_queues.bits.ncqr = 15;
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	num_queues.raw = g_cpl.cdw0;
+	CU_ASSERT(num_queues.bits.nsqr == 3);
+	CU_ASSERT(num_queues.bits.ncqr == 3);
+	CU_ASSERT(mctrlr.num_io_queues == 4);
+
+	/* AERs are held until they are aborted */
+	ut_req_init(&aer_req, mqpair, SPDK_NVME_OPC_ASYNC_EVENT_REQUEST, 0, 1, NULL, 0);
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &aer_req) == 0);
+	g_num_cpls = 0;
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 0);
+	CU_ASSERT(!TAILQ_EMPTY(&mqpair->aer_tr));
+
+	ut_req_init(&req, mqpair, SPDK_NVME_OPC_KEEP_ALIVE, 0, 1, NULL, 0);
+	CU_ASSERT(nvme_mem_qpair_submit_request(&mqpair->qpair, &req) == 0);
+	CU_ASSERT(nvme_mem_qpair_process_completions(&mqpair->qpair, 0) == 1);
+	CU_ASSERT(g_num_cpls == 1);
+
+	nvme_mem_admin_qpair_abort_aers(&mqpair->qpair);
+	CU_ASSERT(g_num_cpls == 2);
+	CU_ASSERT(g_cpl.status.sc == SPDK_NVME_SC_ABORTED_SQ_DELETION);
+	CU_ASSERT(TAILQ_EMPTY(&mqpair->aer_tr));
+	CU_ASSERT(TAILQ_EMPTY(&mqpair->outstanding_tr));
+
+	nvme_mem_ctrlr_delete_io_qpair(&mctrlr.ctrlr, &mqpair->qpair);
+	pthread_mutex_destroy(&mctrlr.ctrlr.ctrlr_lock);
+}
+
+static void
+test_nvme_mem_regs(void)
+{
+	struct nvme_mem_ctrlr mctrlr;
+	union spdk_nvme_cap_register cap;
+	union spdk_nvme_cc_register cc;
+	union spdk_nvme_csts_register csts;
+
+	ut_ctrlr_init(&mctrlr, "mem0,queue_size=256");
+
+	CU_ASSERT(nvme_mem_ctrlr_get_reg_8(&mctrlr.ctrlr, offsetof(struct spdk_nvme_registers, cap),
+					   &cap.raw) == 0);
+	CU_ASSERT(cap.bits.mqes == 255);
+	CU_ASSERT(cap.bits.css == SPDK_NVME_CAP_CSS_NVM);
+
+	cc.raw = 0;
+	cc.bits.en = 1;
+	CU_ASSERT(nvme_mem_ctrlr_set_reg_4(&mctrlr.ctrlr, offsetof(struct spdk_nvme_registers, cc),
+					   cc.raw) == 0);
+	CU_ASSERT(nvme_mem_ctrlr_get_reg_4(&mctrlr.ctrlr, offsetof(struct spdk_nvme_registers, csts),
+					   &csts.raw) == 0);
+	CU_ASSERT(csts.bits.rdy == 1);
+
+	cc.bits.shn = SPDK_NVME_SHN_NORMAL;
+	CU_ASSERT(nvme_mem_ctrlr_set_reg_4(&mctrlr.ctrlr, offsetof(struct spdk_nvme_registers, cc),
+					   cc.raw) == 0);
+	CU_ASSERT(nvme_mem_ctrlr_get_reg_4(&mctrlr.ctrlr, offsetof(struct spdk_nvme_registers, csts),
+					   &csts.raw) == 0);
+	CU_ASSERT(csts.bits.shst == SPDK_NVME_SHST_COMPLETE);
+
+	cc.raw = 0;
+	CU_ASSERT(nvme_mem_ctrlr_set_reg_4(&mctrlr.ctrlr, offsetof(struct spdk_nvme_registers, cc),
+					   cc.raw) == 0);
+	CU_ASSERT(nvme_mem_ctrlr_get_reg_4(&mctrlr.ctrlr, offsetof(struct spdk_nvme_registers, csts),
+					   &csts.raw) == 0);
+	CU_ASSERT(csts.bits.rdy == 0);
+
+	CU_ASSERT(nvme_mem_ctrlr_get_reg_4(&mctrlr.ctrlr, sizeof(struct spdk_nvme_registers),
+					   &csts.raw) == -EINVAL);
+
+	pthread_mutex_destroy(&mctrlr.ctrlr.ctrlr_lock);
+}
+
+int main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("nvme_mem", NULL, NULL);
+	CU_ADD_TEST(suite, test_nvme_mem_parse_opts);
+	CU_ADD_TEST(suite, test_nvme_mem_io);
+	CU_ADD_TEST(suite, test_nvme_mem_queue_full);
+	CU_ADD_TEST(suite, test_nvme_mem_latency);
+	CU_ADD_TEST(suite, test_nvme_mem_admin);
+	CU_ADD_TEST(suite, test_nvme_mem_regs);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+	return num_failures;
+}
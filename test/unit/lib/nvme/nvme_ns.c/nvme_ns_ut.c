@@ -48,7 +48,7 @@ DEFINE_STUB(nvme_wait_for_completion_robust_lock, int,
 
 int
 nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr, uint8_t cns, uint16_t cntid, uint32_t nsid,
-			void *payload, size_t payload_size,
+			uint8_t csi, void *payload, size_t payload_size,
 			spdk_nvme_cmd_cb cb_fn, void *cb_arg)
 {
 	return -1;
@@ -132,6 +132,36 @@ test_nvme_ns_uuid(void)
 	CU_ASSERT(memcmp(uuid, &expected_uuid, sizeof(*uuid)) == 0);
 }
 
+static void
+test_nvme_ns_csi(void)
+{
+	struct spdk_nvme_ns ns = {};
+
+	/* Empty list - the namespace uses the NVM command set */
+	memset(ns.id_desc_list, 0, sizeof(ns.id_desc_list));
+	nvme_ns_set_id_desc_list_data(&ns);
+	CU_ASSERT(spdk_nvme_ns_get_csi(&ns) == SPDK_NVME_CSI_NVM);
+
+	/* NGUID followed by CSI */
+	memset(ns.id_desc_list, 0, sizeof(ns.id_desc_list));
+	ns.id_desc_list[0] = 0x02; /* NIDT == NGUID */
+	ns.id_desc_list[1] = 0x10; /* NIDL */
+	memset(&ns.id_desc_list[4], 0xCC, 0x10);
+	ns.id_desc_list[20] = 0x04; /* NIDT == CSI */
+	ns.id_desc_list[21] = 0x01; /* NIDL */
+	ns.id_desc_list[24] = SPDK_NVME_CSI_ZNS;
+	nvme_ns_set_id_desc_list_data(&ns);
+	CU_ASSERT(spdk_nvme_ns_get_csi(&ns) == SPDK_NVME_CSI_ZNS);
+
+	/* CSI with an invalid length is ignored */
+	memset(ns.id_desc_list, 0, sizeof(ns.id_desc_list));
+	ns.id_desc_list[0] = 0x04; /* NIDT == CSI */
+	ns.id_desc_list[1] = 0x04; /* NIDL */
+	ns.id_desc_list[4] = SPDK_NVME_CSI_ZNS;
+	nvme_ns_set_id_desc_list_data(&ns);
+	CU_ASSERT(spdk_nvme_ns_get_csi(&ns) == SPDK_NVME_CSI_NVM);
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -144,6 +174,7 @@ int main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, test_nvme_ns_construct);
 	CU_ADD_TEST(suite, test_nvme_ns_uuid);
+	CU_ADD_TEST(suite, test_nvme_ns_csi);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -493,11 +493,6 @@ test_cmd_child_request(void)
 	SPDK_CU_ASSERT_FATAL(g_request != NULL);
 	CU_ASSERT(g_request->num_children == 4);
 
-	rc = spdk_nvme_ns_cmd_read(&ns, &qpair, payload, lba, (DEFAULT_IO_QUEUE_REQUESTS + 1) * sector_size,
-				   NULL,
-				   NULL, 0);
-	SPDK_CU_ASSERT_FATAL(rc == -EINVAL);
-
 	TAILQ_FOREACH_SAFE(child, &g_request->children, child_tailq, tmp) {
 		nvme_request_remove_child(g_request, child);
 		CU_ASSERT(child->payload_offset == offset);
@@ -515,6 +510,90 @@ test_cmd_child_request(void)
 	cleanup_after_test(&qpair);
 }
 
+static void
+split_done_cb(void *cb_arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_cpl *status = cb_arg;
+
+	*status = *cpl;
+	status->status.p = 1;
+}
+
+static void
+split_test_queue_depth(void)
+{
+	struct spdk_nvme_ns		ns;
+	struct spdk_nvme_ctrlr		ctrlr;
+	struct spdk_nvme_qpair		qpair;
+	struct spdk_nvme_cpl		cpl = {};
+	struct spdk_nvme_cpl		status = {};
+	struct nvme_request		*parent, *child;
+	void				*payload;
+	uint64_t			lba = 0x1000;
+	uint32_t			max_io_size = 128 * 1024;
+	uint32_t			sectors_per_max_io = max_io_size / 512;
+	uint32_t			i;
+	int				rc;
+
+	/*
+	 * The qpair has 32 requests.  A read that needs 40 children gets the parent
+	 *  and 31 children up front, the other 9 are built as children complete.
+	 */
+	prepare_for_test(&ns, &ctrlr, &qpair, 512, 0, max_io_size, 0, false);
+	payload = malloc(40 * max_io_size);
+	SPDK_CU_ASSERT_FATAL(payload != NULL);
+
+	rc = spdk_nvme_ns_cmd_read(&ns, &qpair, payload, lba, 40 * sectors_per_max_io,
+				   split_done_cb, &status, 0);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	parent = g_request;
+	CU_ASSERT(parent->num_children == 31);
+	CU_ASSERT(parent->split_pending == 1);
+	CU_ASSERT(parent->split.lba == lba + 31 * sectors_per_max_io);
+	CU_ASSERT(parent->split.lba_count == 9 * sectors_per_max_io);
+	CU_ASSERT(parent->split.payload_offset == 31 * max_io_size);
+	CU_ASSERT(STAILQ_EMPTY(&qpair.free_req));
+
+	/* Nothing completed, so no more children can be built yet. */
+	CU_ASSERT(nvme_ns_cmd_resume_split(parent) == false);
+	CU_ASSERT(parent->num_children == 31);
+
+	/* Complete 10 children, the parent stays outstanding. */
+	for (i = 0; i < 10; i++) {
+		child = TAILQ_FIRST(&parent->children);
+		child->cb_fn(child->cb_arg, &cpl);
+		nvme_free_request(child);
+	}
+	CU_ASSERT(parent->num_children == 21);
+	CU_ASSERT(status.status.p == 0);
+
+	/* All of the remaining children fit now. */
+	CU_ASSERT(nvme_ns_cmd_resume_split(parent) == true);
+	CU_ASSERT(parent->num_children == 30);
+	CU_ASSERT(parent->split_pending == 0);
+	/* The last child built was the last one submitted. */
+	child = g_request;
+	CU_ASSERT(child->parent == parent);
+	CU_ASSERT(child->payload_offset == 39 * max_io_size);
+	CU_ASSERT(child->cmd.cdw10 == lba + 39 * sectors_per_max_io);
+	CU_ASSERT(child->cmd.cdw12 == sectors_per_max_io - 1);
+
+	/* A failed child fails the parent once all children completed. */
+	cpl.status.sc = SPDK_NVME_SC_DATA_TRANSFER_ERROR;
+	while (!TAILQ_EMPTY(&parent->children)) {
+		child = TAILQ_FIRST(&parent->children);
+		child->cb_fn(child->cb_arg, &cpl);
+		nvme_free_request(child);
+		cpl.status.sc = SPDK_NVME_SC_SUCCESS;
+	}
+	CU_ASSERT(status.status.p == 1);
+	CU_ASSERT(status.status.sc == SPDK_NVME_SC_DATA_TRANSFER_ERROR);
+
+	free(payload);
+	cleanup_after_test(&qpair);
+}
+
 static void
 test_nvme_ns_cmd_flush(void)
 {
@@ -1710,6 +1789,7 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, split_test2);
 	CU_ADD_TEST(suite, split_test3);
 	CU_ADD_TEST(suite, split_test4);
+	CU_ADD_TEST(suite, split_test_queue_depth);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_flush);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_dataset_management);
 	CU_ADD_TEST(suite, test_io_flags);
@@ -476,6 +476,175 @@ test_build_contig_hw_sgl_request(void)
 	memset(&tr, 0, sizeof(tr));
 }
 
+static void
+test_nvme_pcie_poll_group_stats(void)
+{
+	struct nvme_pcie_ctrlr pctrlr = {};
+	struct nvme_pcie_qpair pqpair = {};
+	struct spdk_nvme_cpl cpl[4] = {};
+	struct spdk_nvme_transport_poll_group *tgroup;
+	struct spdk_nvme_transport_poll_group_stat stat = {};
+	uint32_t sq_tdbl = 0, cq_hdbl = 0;
+	int32_t rc;
+
+	pqpair.qpair.id = 1;
+	pqpair.qpair.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	pctrlr.ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	pqpair.qpair.ctrlr = &pctrlr.ctrlr;
+	pqpair.stats = &pqpair.own_stats;
+	pqpair.cpl = cpl;
+	pqpair.num_entries = SPDK_COUNTOF(cpl);
+	pqpair.max_completions_cap = 1;
+	pqpair.flags.phase = 1;
+	pqpair.flags.delay_cmd_submit = 1;
+	pqpair.sq_tdbl = &sq_tdbl;
+	pqpair.cq_hdbl = &cq_hdbl;
+
+	tgroup = nvme_pcie_poll_group_create();
+	SPDK_CU_ASSERT_FATAL(tgroup != NULL);
+	CU_ASSERT(nvme_pcie_poll_group_add(tgroup, &pqpair.qpair) == 0);
+
+	/* An empty completion queue counts as an idle poll */
+	rc = nvme_pcie_qpair_process_completions(&pqpair.qpair, 0);
+	CU_ASSERT(rc == 0);
+
+	/* A delayed submission is flushed by the next poll */
+	pqpair.sq_tail = 1;
+	rc = nvme_pcie_qpair_process_completions(&pqpair.qpair, 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(sq_tdbl == 1);
+
+	CU_ASSERT(nvme_pcie_poll_group_get_stats(tgroup, &stat) == 0);
+	CU_ASSERT(stat.u.pcie.polls == 2);
+	CU_ASSERT(stat.u.pcie.idle_polls == 2);
+	CU_ASSERT(stat.u.pcie.completions == 0);
+	CU_ASSERT(stat.u.pcie.sq_doorbell_updates == 1);
+	CU_ASSERT(stat.u.pcie.cq_doorbell_updates == 0);
+
+	/* Outside of a poll group the qpair counts on its own */
+	CU_ASSERT(nvme_pcie_poll_group_remove(tgroup, &pqpair.qpair) == 0);
+	rc = nvme_pcie_qpair_process_completions(&pqpair.qpair, 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pqpair.own_stats.polls == 1);
+	CU_ASSERT(nvme_pcie_poll_group_get_stats(tgroup, &stat) == 0);
+	CU_ASSERT(stat.u.pcie.polls == 2);
+
+	CU_ASSERT(nvme_pcie_poll_group_destroy(tgroup) == 0);
+}
+
+static void
+test_nvme_pcie_doorbell_batching(void)
+{
+	struct nvme_pcie_ctrlr pctrlr = {};
+	struct nvme_pcie_qpair pqpair = {};
+	struct spdk_nvme_cpl cpl[64] = {};
+	struct nvme_tracker tr[64] = {};
+	struct nvme_request req[64] = {};
+	uint32_t sq_tdbl = 0, cq_hdbl = 0;
+	uint16_t i;
+	int32_t rc;
+
+	pqpair.qpair.id = 1;
+	pqpair.qpair.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	pctrlr.ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	pqpair.qpair.ctrlr = &pctrlr.ctrlr;
+	pqpair.stats = &pqpair.own_stats;
+	pqpair.cpl = cpl;
+	pqpair.tr = tr;
+	pqpair.num_entries = SPDK_COUNTOF(cpl);
+	pqpair.max_completions_cap = 16;
+	pqpair.cq_doorbell_batch = 8;
+	pqpair.sq_doorbell_budget_ticks = 10;
+	pqpair.flags.phase = 1;
+	pqpair.flags.delay_cmd_submit = 1;
+	pqpair.sq_tdbl = &sq_tdbl;
+	pqpair.cq_hdbl = &cq_hdbl;
+	TAILQ_INIT(&pqpair.qpair.err_cmd_head);
+	STAILQ_INIT(&pqpair.qpair.free_req);
+	TAILQ_INIT(&pqpair.free_tr);
+	TAILQ_INIT(&pqpair.outstanding_tr);
+
+	/* Commands submitted close together wait for the next poll */
+	pqpair.sq_tail = 1;
+	nvme_pcie_qpair_delay_sq_doorbell(&pqpair.qpair);
+	pqpair.sq_tail = 2;
+	nvme_pcie_qpair_delay_sq_doorbell(&pqpair.qpair);
+	CU_ASSERT(pqpair.own_stats.sq_doorbell_updates == 0);
+
+	/* Once the oldest one is over the latency budget the doorbell is rung at submission */
+	spdk_delay_us(10);
+	pqpair.sq_tail = 3;
+	nvme_pcie_qpair_delay_sq_doorbell(&pqpair.qpair);
+	CU_ASSERT(pqpair.own_stats.sq_doorbell_updates == 1);
+	CU_ASSERT(sq_tdbl == 3);
+	CU_ASSERT(pqpair.last_sq_tail == 3);
+
+	/* A full batch is rung without waiting for the budget, also across the queue wrap */
+	pqpair.sq_tail = pqpair.last_sq_tail = sq_tdbl = 48;
+	for (i = 1; i < NVME_PCIE_SQ_DOORBELL_BATCH; i++) {
+		pqpair.sq_tail = (pqpair.sq_tail + 1) % pqpair.num_entries;
+		nvme_pcie_qpair_delay_sq_doorbell(&pqpair.qpair);
+	}
+	CU_ASSERT(pqpair.own_stats.sq_doorbell_updates == 1);
+	pqpair.sq_tail = (pqpair.sq_tail + 1) % pqpair.num_entries;
+	nvme_pcie_qpair_delay_sq_doorbell(&pqpair.qpair);
+	CU_ASSERT(pqpair.own_stats.sq_doorbell_updates == 2);
+	CU_ASSERT(sq_tdbl == 16);
+	pqpair.sq_tail = pqpair.last_sq_tail = sq_tdbl = 0;
+
+	for (i = 0; i < SPDK_COUNTOF(tr); i++) {
+		tr[i].cid = i;
+		tr[i].req = &req[i];
+		req[i].cmd.cid = i;
+		req[i].qpair = &pqpair.qpair;
+		TAILQ_INSERT_TAIL(&pqpair.outstanding_tr, &tr[i], tq_list);
+		cpl[i].cid = i;
+	}
+
+	/* A small number of completions is not reported to the controller right away */
+	for (i = 0; i < 4; i++) {
+		cpl[i].status.p = 1;
+	}
+	rc = nvme_pcie_qpair_process_completions(&pqpair.qpair, 0);
+	CU_ASSERT(rc == 4);
+	CU_ASSERT(pqpair.cq_pending == 4);
+	CU_ASSERT(pqpair.own_stats.cq_doorbell_updates == 0);
+
+	/* Going over the batch rings the doorbell */
+	for (i = 4; i < 9; i++) {
+		cpl[i].status.p = 1;
+	}
+	rc = nvme_pcie_qpair_process_completions(&pqpair.qpair, 0);
+	CU_ASSERT(rc == 5);
+	CU_ASSERT(pqpair.cq_pending == 0);
+	CU_ASSERT(pqpair.own_stats.cq_doorbell_updates == 1);
+	CU_ASSERT(cq_hdbl == 9);
+
+	/* Unreported entries reduce the number of completions a poll may consume */
+	for (i = 9; i < 13; i++) {
+		cpl[i].status.p = 1;
+	}
+	rc = nvme_pcie_qpair_process_completions(&pqpair.qpair, 0);
+	CU_ASSERT(rc == 4);
+	for (i = 13; i < 29; i++) {
+		cpl[i].status.p = 1;
+	}
+	rc = nvme_pcie_qpair_process_completions(&pqpair.qpair, 0);
+	CU_ASSERT(rc == 12);
+	CU_ASSERT(pqpair.own_stats.cq_doorbell_updates == 2);
+	CU_ASSERT(cq_hdbl == 25);
+
+	/* An idle poll reports whatever is left */
+	rc = nvme_pcie_qpair_process_completions(&pqpair.qpair, 0);
+	CU_ASSERT(rc == 4);
+	CU_ASSERT(pqpair.own_stats.cq_doorbell_updates == 2);
+	rc = nvme_pcie_qpair_process_completions(&pqpair.qpair, 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pqpair.cq_pending == 0);
+	CU_ASSERT(pqpair.own_stats.cq_doorbell_updates == 3);
+	CU_ASSERT(cq_hdbl == 29);
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -489,6 +658,8 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_pcie_hotplug_monitor);
 	CU_ADD_TEST(suite, test_shadow_doorbell_update);
 	CU_ADD_TEST(suite, test_build_contig_hw_sgl_request);
+	CU_ADD_TEST(suite, test_nvme_pcie_poll_group_stats);
+	CU_ADD_TEST(suite, test_nvme_pcie_doorbell_batching);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -193,10 +193,33 @@ nvme_transport_poll_group_process_completions(struct spdk_nvme_transport_poll_gr
 	return g_process_completions_return_value;
 }
 
+int
+nvme_transport_poll_group_get_stats(struct spdk_nvme_transport_poll_group *tgroup,
+				    struct spdk_nvme_transport_poll_group_stat *stat)
+{
+	/* Only transport1 keeps statistics */
+	if (tgroup->transport != &t1) {
+		return -ENOTSUP;
+	}
+
+	stat->trtype = SPDK_NVME_TRANSPORT_TCP;
+	stat->u.tcp.recv_syscalls = 3;
+	stat->u.tcp.nvme_completions = 2;
+
+	return 0;
+}
+
+static void
+ut_submit_accel_crc32c(void *ctx, uint32_t *dst, struct iovec *iov, uint32_t iovcnt,
+		       uint32_t seed, spdk_nvme_accel_completion_cb cb_fn, void *cb_arg)
+{
+}
+
 static void
 test_spdk_nvme_poll_group_create(void)
 {
 	struct spdk_nvme_poll_group *group;
+	struct spdk_nvme_accel_fn_table table = {};
 
 	/* basic case - create a poll group with no internal transport poll groups. */
 	group = spdk_nvme_poll_group_create(NULL);
@@ -214,6 +237,22 @@ test_spdk_nvme_poll_group_create(void)
 	CU_ASSERT(STAILQ_EMPTY(&group->tgroups));
 	SPDK_CU_ASSERT_FATAL(spdk_nvme_poll_group_destroy(group) == 0);
 
+	/* accel functions are only taken from the part of the table the caller knows about */
+	table.table_size = sizeof(table);
+	table.submit_accel_crc32c = ut_submit_accel_crc32c;
+	group = spdk_nvme_poll_group_create_ext(&table, &table);
+	SPDK_CU_ASSERT_FATAL(group != NULL);
+	CU_ASSERT(group->ctx == &table);
+	CU_ASSERT(group->accel_fn_table.table_size == sizeof(table));
+	CU_ASSERT(group->accel_fn_table.submit_accel_crc32c == ut_submit_accel_crc32c);
+	SPDK_CU_ASSERT_FATAL(spdk_nvme_poll_group_destroy(group) == 0);
+
+	table.table_size = offsetof(struct spdk_nvme_accel_fn_table, submit_accel_crc32c);
+	group = spdk_nvme_poll_group_create_ext(NULL, &table);
+	SPDK_CU_ASSERT_FATAL(group != NULL);
+	CU_ASSERT(group->accel_fn_table.submit_accel_crc32c == NULL);
+	SPDK_CU_ASSERT_FATAL(spdk_nvme_poll_group_destroy(group) == 0);
+
 	/* Failing case - failed to allocate a poll group. */
 	MOCK_SET(calloc, NULL);
 	group = spdk_nvme_poll_group_create(NULL);
@@ -448,6 +487,52 @@ test_spdk_nvme_poll_group_destroy(void)
 	free(tgroup_1);
 }
 
+static void
+test_spdk_nvme_poll_group_get_stats(void)
+{
+	struct spdk_nvme_poll_group *group;
+	struct spdk_nvme_poll_group_stat *stats = NULL;
+	struct spdk_nvme_transport_poll_group *tgroup, *tmp_tgroup;
+	struct spdk_nvme_qpair qpair1_1 = {0};
+	struct spdk_nvme_qpair qpair2_1 = {0};
+
+	/* A group without qpairs reports no transports. */
+	group = spdk_nvme_poll_group_create(NULL);
+	SPDK_CU_ASSERT_FATAL(group != NULL);
+	CU_ASSERT(spdk_nvme_poll_group_get_stats(group, &stats) == 0);
+	SPDK_CU_ASSERT_FATAL(stats != NULL);
+	CU_ASSERT(stats->num_transports == 0);
+	spdk_nvme_poll_group_free_stats(stats);
+
+	TAILQ_INSERT_TAIL(&g_spdk_nvme_transports, &t1, link);
+	TAILQ_INSERT_TAIL(&g_spdk_nvme_transports, &t2, link);
+
+	/* Transports without statistics are left out. */
+	qpair1_1.transport = &t1;
+	qpair2_1.transport = &t2;
+	CU_ASSERT(spdk_nvme_poll_group_add(group, &qpair1_1) == 0);
+	CU_ASSERT(spdk_nvme_poll_group_add(group, &qpair2_1) == 0);
+	stats = NULL;
+	CU_ASSERT(spdk_nvme_poll_group_get_stats(group, &stats) == 0);
+	SPDK_CU_ASSERT_FATAL(stats != NULL);
+	CU_ASSERT(stats->num_transports == 1);
+	CU_ASSERT(stats->transport_stat[0].trtype == SPDK_NVME_TRANSPORT_TCP);
+	CU_ASSERT(stats->transport_stat[0].u.tcp.recv_syscalls == 3);
+	CU_ASSERT(stats->transport_stat[0].u.tcp.nvme_completions == 2);
+	spdk_nvme_poll_group_free_stats(stats);
+
+	CU_ASSERT(spdk_nvme_poll_group_remove(group, &qpair1_1) == 0);
+	CU_ASSERT(spdk_nvme_poll_group_remove(group, &qpair2_1) == 0);
+	STAILQ_FOREACH_SAFE(tgroup, &group->tgroups, link, tmp_tgroup) {
+		STAILQ_REMOVE(&group->tgroups, tgroup, spdk_nvme_transport_poll_group, link);
+		free(tgroup);
+	}
+	SPDK_CU_ASSERT_FATAL(spdk_nvme_poll_group_destroy(group) == 0);
+
+	TAILQ_REMOVE(&g_spdk_nvme_transports, &t1, link);
+	TAILQ_REMOVE(&g_spdk_nvme_transports, &t2, link);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -470,7 +555,9 @@ main(int argc, char **argv)
 			    test_spdk_nvme_poll_group_add_remove) == NULL ||
 		CU_add_test(suite, "nvme_poll_group_process_completions",
 			    test_spdk_nvme_poll_group_process_completions) == NULL ||
-		CU_add_test(suite, "nvme_poll_group_destroy_test", test_spdk_nvme_poll_group_destroy) == NULL
+		CU_add_test(suite, "nvme_poll_group_destroy_test", test_spdk_nvme_poll_group_destroy) == NULL ||
+		CU_add_test(suite, "nvme_poll_group_get_stats_test",
+			    test_spdk_nvme_poll_group_get_stats) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
@@ -55,6 +55,7 @@ DEFINE_STUB(spdk_nvme_ctrlr_free_io_qpair, int, (struct spdk_nvme_qpair *qpair),
 DEFINE_STUB_V(nvme_transport_ctrlr_disconnect_qpair, (struct spdk_nvme_ctrlr *ctrlr,
 		struct spdk_nvme_qpair *qpair));
 DEFINE_STUB_V(nvme_ctrlr_disconnect_qpair, (struct spdk_nvme_qpair *qpair));
+DEFINE_STUB(nvme_ns_cmd_resume_split, bool, (struct nvme_request *req), true);
 
 void
 nvme_ctrlr_fail(struct spdk_nvme_ctrlr *ctrlr, bool hot_remove)
@@ -595,6 +596,49 @@ test_nvme_qpair_resubmit_request_with_transport_failed(void)
 	cleanup_submit_request_test(&qpair);
 }
 
+static void
+test_nvme_qpair_resubmit_requests_resume_split(void)
+{
+	struct spdk_nvme_qpair		qpair = {};
+	struct spdk_nvme_ctrlr		ctrlr = {};
+	struct nvme_request		*req1, *req2;
+
+	prepare_submit_request_test(&qpair, &ctrlr);
+
+	req1 = nvme_allocate_request_null(&qpair, dummy_cb_fn, NULL);
+	SPDK_CU_ASSERT_FATAL(req1 != NULL);
+	req2 = nvme_allocate_request_null(&qpair, dummy_cb_fn, NULL);
+	SPDK_CU_ASSERT_FATAL(req2 != NULL);
+	STAILQ_INSERT_TAIL(&qpair.split_req, req1, stailq);
+	STAILQ_INSERT_TAIL(&qpair.split_req, req2, stailq);
+
+	/*
+	 * Transport poll groups (e.g. RDMA) only call nvme_qpair_resubmit_requests()
+	 *  after reaping completions, the split parents must be resumed from there.
+	 *  The first parent that can't build its children stops the resume.
+	 */
+	MOCK_SET(nvme_ns_cmd_resume_split, false);
+	nvme_qpair_resubmit_requests(&qpair, 0);
+	CU_ASSERT(STAILQ_FIRST(&qpair.split_req) == req1);
+	CU_ASSERT(STAILQ_NEXT(req1, stailq) == req2);
+
+	/* Nothing is resumed while the controller is resetting */
+	MOCK_SET(nvme_ns_cmd_resume_split, true);
+	ctrlr.is_resetting = true;
+	nvme_qpair_resubmit_requests(&qpair, 1);
+	CU_ASSERT(STAILQ_FIRST(&qpair.split_req) == req1);
+	ctrlr.is_resetting = false;
+
+	nvme_qpair_resubmit_requests(&qpair, 1);
+	CU_ASSERT(STAILQ_EMPTY(&qpair.split_req));
+	MOCK_CLEAR(nvme_ns_cmd_resume_split);
+
+	nvme_free_request(req1);
+	nvme_free_request(req2);
+
+	cleanup_submit_request_test(&qpair);
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -616,6 +660,7 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_qpair_add_cmd_error_injection);
 	CU_ADD_TEST(suite, test_nvme_qpair_submit_request);
 	CU_ADD_TEST(suite, test_nvme_qpair_resubmit_request_with_transport_failed);
+	CU_ADD_TEST(suite, test_nvme_qpair_resubmit_requests_resume_split);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -436,6 +436,277 @@ test_nvme_tcp_build_iovs_with_md(void)
 		  512 * 8 + SPDK_NVME_TCP_DIGEST_LEN);
 }
 
+static struct {
+	uint32_t			*dst;
+	struct iovec			*iov;
+	uint32_t			iovcnt;
+	uint32_t			seed;
+	spdk_nvme_accel_completion_cb	cb_fn;
+	void				*cb_arg;
+} g_ut_crc32c;
+
+static void
+ut_submit_accel_crc32c(void *ctx, uint32_t *dst, struct iovec *iov, uint32_t iovcnt,
+		       uint32_t seed, spdk_nvme_accel_completion_cb cb_fn, void *cb_arg)
+{
+	g_ut_crc32c.dst = dst;
+	g_ut_crc32c.iov = iov;
+	g_ut_crc32c.iovcnt = iovcnt;
+	g_ut_crc32c.seed = seed;
+	g_ut_crc32c.cb_fn = cb_fn;
+	g_ut_crc32c.cb_arg = cb_arg;
+}
+
+static void
+ut_complete_accel_crc32c(uint32_t corrupt)
+{
+	spdk_nvme_accel_completion_cb cb_fn = g_ut_crc32c.cb_fn;
+
+	SPDK_CU_ASSERT_FATAL(cb_fn != NULL);
+	*g_ut_crc32c.dst = _update_crc32c_iov(g_ut_crc32c.iov, g_ut_crc32c.iovcnt,
+					      ~g_ut_crc32c.seed) ^ corrupt;
+	g_ut_crc32c.cb_fn = NULL;
+	cb_fn(g_ut_crc32c.cb_arg, 0);
+}
+
+static int g_ut_num_completions;
+
+static void
+ut_nvme_cpl_cb(void *cb_arg, const struct spdk_nvme_cpl *cpl)
+{
+	g_ut_num_completions++;
+}
+
+static void
+test_nvme_tcp_recv_ddgst_offload(void)
+{
+	struct nvme_tcp_qpair tqpair = {};
+	struct spdk_nvme_poll_group group = {};
+	struct spdk_nvme_transport_poll_group tgroup = {};
+	struct nvme_tcp_req tcp_req = {};
+	struct nvme_tcp_pdu send_pdu = {};
+	struct nvme_request req = {};
+	struct nvme_tcp_pdu *pdu = &tqpair.recv_pdu;
+	uint8_t data[4096];
+	uint32_t reaped = 0;
+	uint32_t corrupt;
+
+	for (corrupt = 0; corrupt < 2; corrupt++) {
+		memset(&tqpair, 0, sizeof(tqpair));
+		TAILQ_INIT(&tqpair.free_reqs);
+		TAILQ_INIT(&tqpair.outstanding_reqs);
+		TAILQ_INIT(&tqpair.send_queue);
+		TAILQ_INIT(&tqpair.qpair.err_cmd_head);
+		STAILQ_INIT(&tqpair.qpair.free_req);
+		tqpair.qpair.trtype = SPDK_NVME_TRANSPORT_TCP;
+		tqpair.stats = &tqpair.own_stats;
+		tqpair.sock = (struct spdk_sock *)0xDEADBEEF;
+		tqpair.qpair.poll_group = &tgroup;
+		tgroup.group = &group;
+		group.accel_fn_table.submit_accel_crc32c = ut_submit_accel_crc32c;
+
+		memset(data, 0x5a + corrupt, sizeof(data));
+		memset(&req, 0, sizeof(req));
+		req.qpair = &tqpair.qpair;
+		req.cb_fn = ut_nvme_cpl_cb;
+		req.payload_size = sizeof(data);
+
+		memset(&tcp_req, 0, sizeof(tcp_req));
+		tcp_req.req = &req;
+		tcp_req.tqpair = &tqpair;
+		tcp_req.send_pdu = &send_pdu;
+		tcp_req.state = NVME_TCP_REQ_ACTIVE;
+		tcp_req.ordering.send_ack = 1;
+		tcp_req.iov[0].iov_base = data;
+		tcp_req.iov[0].iov_len = sizeof(data);
+		tcp_req.iovcnt = 1;
+		TAILQ_INSERT_TAIL(&tqpair.outstanding_reqs, &tcp_req, link);
+
+		/* A C2H data PDU that also completes the request */
+		tqpair.recv_state = NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD;
+		pdu->hdr.common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_C2H_DATA;
+		pdu->hdr.common.flags = SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS;
+		pdu->ddgst_enable = true;
+		pdu->req = &tcp_req;
+		nvme_tcp_pdu_set_data_buf(pdu, tcp_req.iov, tcp_req.iovcnt, 0, sizeof(data));
+		MAKE_DIGEST_WORD(pdu->data_digest, nvme_tcp_pdu_calc_data_digest(pdu));
+
+		/* The PDU is consumed, but the completion waits for the digest */
+		g_ut_num_completions = 0;
+		reaped = 0;
+		nvme_tcp_pdu_payload_handle(&tqpair, &reaped);
+		CU_ASSERT(reaped == 0);
+		CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
+		CU_ASSERT(tcp_req.ddgst_pending == true);
+		CU_ASSERT(tcp_req.cpl_deferred == true);
+		CU_ASSERT(tqpair.ddgst_inflight == 1);
+		CU_ASSERT(g_ut_crc32c.iovcnt == 1);
+		CU_ASSERT(g_ut_crc32c.iov[0].iov_base == data);
+		CU_ASSERT(g_ut_num_completions == 0);
+
+		ut_complete_accel_crc32c(corrupt);
+		CU_ASSERT(tcp_req.ddgst_pending == false);
+		CU_ASSERT(tqpair.ddgst_inflight == 0);
+		if (corrupt == 0) {
+			CU_ASSERT(g_ut_num_completions == 1);
+			CU_ASSERT(tcp_req.state == NVME_TCP_REQ_FREE);
+			CU_ASSERT(TAILQ_EMPTY(&tqpair.outstanding_reqs));
+			/* Reported by the next poll of the qpair */
+			CU_ASSERT(tqpair.ddgst_reaped == 1);
+		} else {
+			/* A digest error terminates the connection, the request is aborted then */
+			CU_ASSERT(g_ut_num_completions == 0);
+			CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_ERROR);
+			CU_ASSERT(tqpair.send_pdu.hdr.term_req.common.pdu_type ==
+				  SPDK_NVME_TCP_PDU_TYPE_H2C_TERM_REQ);
+			CU_ASSERT(tqpair.ddgst_reaped == 0);
+			nvme_tcp_qpair_abort_reqs(&tqpair.qpair, 1);
+			CU_ASSERT(g_ut_num_completions == 1);
+			CU_ASSERT(tcp_req.state == NVME_TCP_REQ_FREE);
+		}
+	}
+}
+
+static uint32_t
+ut_put_c2h_data(uint8_t *buf, uint16_t cid, uint8_t flags, uint32_t datal, uint8_t fill)
+{
+	struct spdk_nvme_tcp_c2h_data_hdr *c2h_data = (struct spdk_nvme_tcp_c2h_data_hdr *)buf;
+
+	memset(c2h_data, 0, sizeof(*c2h_data));
+	c2h_data->common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_C2H_DATA;
+	c2h_data->common.flags = flags;
+	c2h_data->common.hlen = sizeof(*c2h_data);
+	c2h_data->common.pdo = sizeof(*c2h_data);
+	c2h_data->common.plen = sizeof(*c2h_data) + datal;
+	c2h_data->cccid = cid;
+	c2h_data->datal = datal;
+	memset(buf + sizeof(*c2h_data), fill, datal);
+
+	return sizeof(*c2h_data) + datal;
+}
+
+static uint32_t
+ut_put_capsule_resp(uint8_t *buf, uint16_t cid)
+{
+	struct spdk_nvme_tcp_rsp *capsule_resp = (struct spdk_nvme_tcp_rsp *)buf;
+
+	memset(capsule_resp, 0, sizeof(*capsule_resp));
+	capsule_resp->common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_CAPSULE_RESP;
+	capsule_resp->common.hlen = sizeof(*capsule_resp);
+	capsule_resp->common.plen = sizeof(*capsule_resp);
+	capsule_resp->rccqe.cid = cid;
+
+	return sizeof(*capsule_resp);
+}
+
+static void
+test_nvme_tcp_read_pdu_batched(void)
+{
+	struct nvme_tcp_qpair tqpair = {};
+	struct spdk_nvme_tcp_stat stats = {};
+	struct nvme_request req[2] = {};
+	struct nvme_tcp_req *tcp_req;
+	uint8_t data[2][512];
+	uint32_t reaped = 0, len = 0;
+	int i, rc;
+
+	TAILQ_INIT(&tqpair.qpair.err_cmd_head);
+	STAILQ_INIT(&tqpair.qpair.free_req);
+	tqpair.qpair.trtype = SPDK_NVME_TRANSPORT_TCP;
+	tqpair.sock = (struct spdk_sock *)0xDEADBEEF;
+	tqpair.state = NVME_TCP_QPAIR_STATE_RUNNING;
+	tqpair.stats = &stats;
+	tqpair.num_entries = 2;
+	rc = nvme_tcp_alloc_reqs(&tqpair);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	for (i = 0; i < 2; i++) {
+		req[i].qpair = &tqpair.qpair;
+		req[i].cb_fn = ut_nvme_cpl_cb;
+		req[i].payload_size = sizeof(data[i]);
+		tcp_req = nvme_tcp_req_get(&tqpair);
+		SPDK_CU_ASSERT_FATAL(tcp_req != NULL);
+		tcp_req->req = &req[i];
+		tcp_req->ordering.send_ack = 1;
+		tcp_req->iov[0].iov_base = data[i];
+		tcp_req->iov[0].iov_len = sizeof(data[i]);
+		tcp_req->iovcnt = 1;
+		TAILQ_INSERT_TAIL(&tqpair.outstanding_reqs, tcp_req, link);
+	}
+	memset(data, 0, sizeof(data));
+
+	/* Two C2H data PDUs and a capsule response that came in with a single read */
+	len += ut_put_c2h_data(tqpair.recv_buf + len, 0, SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS |
+			       SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU, sizeof(data[0]), 0xa5);
+	len += ut_put_c2h_data(tqpair.recv_buf + len, 1, SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU,
+			       sizeof(data[1]) / 2, 0x5a);
+	len += ut_put_capsule_resp(tqpair.recv_buf + len, 1);
+	tqpair.recv_buf_len = len;
+
+	/* The socket has nothing more to give */
+	MOCK_SET(spdk_sock_recv, -1);
+	errno = EAGAIN;
+	g_ut_num_completions = 0;
+	rc = nvme_tcp_read_pdu(&tqpair, &reaped);
+	CU_ASSERT(rc == NVME_TCP_PDU_IN_PROGRESS);
+	CU_ASSERT(reaped == 2);
+	CU_ASSERT(g_ut_num_completions == 2);
+	CU_ASSERT(data[0][0] == 0xa5 && data[0][sizeof(data[0]) - 1] == 0xa5);
+	CU_ASSERT(data[1][0] == 0x5a && data[1][sizeof(data[1]) / 2 - 1] == 0x5a);
+	CU_ASSERT(data[1][sizeof(data[1]) / 2] == 0);
+	CU_ASSERT(stats.recv_pdus == 3);
+	CU_ASSERT(stats.nvme_completions == 2);
+	/* Only the read that found the socket empty went to the socket */
+	CU_ASSERT(stats.recv_syscalls == 1);
+	CU_ASSERT(stats.recv_direct_bytes == 0);
+
+	/*
+	 * A payload that is not buffered yet is read straight into the request's
+	 * buffer, and whatever follows it lands in the receive buffer. The readv
+	 * stub does not copy anything, so stage the trailing response up front.
+	 */
+	reaped = 0;
+	tcp_req = nvme_tcp_req_get(&tqpair);
+	SPDK_CU_ASSERT_FATAL(tcp_req != NULL);
+	memset(&req[0], 0, sizeof(req[0]));
+	req[0].qpair = &tqpair.qpair;
+	req[0].cb_fn = ut_nvme_cpl_cb;
+	req[0].payload_size = sizeof(data[0]);
+	tcp_req->req = &req[0];
+	tcp_req->ordering.send_ack = 1;
+	tcp_req->iov[0].iov_base = data[0];
+	tcp_req->iov[0].iov_len = sizeof(data[0]);
+	tcp_req->iovcnt = 1;
+	TAILQ_INSERT_TAIL(&tqpair.outstanding_reqs, tcp_req, link);
+
+	ut_put_c2h_data(tqpair.recv_buf, tcp_req->cid, SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU,
+			sizeof(data[0]), 0);
+	tqpair.recv_buf_off = 0;
+	tqpair.recv_buf_len = sizeof(struct spdk_nvme_tcp_c2h_data_hdr);
+	MOCK_SET(spdk_sock_readv, -1);
+	errno = EAGAIN;
+	rc = nvme_tcp_read_pdu(&tqpair, &reaped);
+	CU_ASSERT(rc == NVME_TCP_PDU_IN_PROGRESS);
+	CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD);
+	CU_ASSERT(stats.recv_syscalls == 2);
+
+	len = ut_put_capsule_resp(tqpair.recv_buf, tcp_req->cid);
+	MOCK_SET(spdk_sock_readv, sizeof(data[0]) + len);
+	g_ut_num_completions = 0;
+	errno = EAGAIN;
+	rc = nvme_tcp_read_pdu(&tqpair, &reaped);
+	CU_ASSERT(rc == NVME_TCP_PDU_IN_PROGRESS);
+	CU_ASSERT(g_ut_num_completions == 1);
+	CU_ASSERT(stats.recv_direct_bytes == sizeof(data[0]));
+	CU_ASSERT(stats.recv_pdus == 5);
+	/* The readv, the response parsed from the buffer and the final empty read */
+	CU_ASSERT(stats.recv_syscalls == 4);
+
+	MOCK_CLEAR(spdk_sock_recv);
+	MOCK_CLEAR(spdk_sock_readv);
+	nvme_tcp_free_reqs(&tqpair);
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -450,6 +721,8 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_tcp_build_sgl_request);
 	CU_ADD_TEST(suite, test_nvme_tcp_pdu_set_data_buf_with_md);
 	CU_ADD_TEST(suite, test_nvme_tcp_build_iovs_with_md);
+	CU_ADD_TEST(suite, test_nvme_tcp_recv_ddgst_offload);
+	CU_ADD_TEST(suite, test_nvme_tcp_read_pdu_batched);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -0,0 +1,381 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_cunit.h"
+
+#include "nvme/nvme_zns.c"
+#include "nvme/nvme_ns_cmd.c"
+#include "nvme/nvme.c"
+
+#include "common/lib/test_env.c"
+
+#define ZNS_SECTOR_SIZE 0x1000
+#define ZNS_ZONE_SIZE 0x10000
+
+static struct nvme_request *g_request = NULL;
+static struct spdk_nvme_ns_data g_nsdata;
+
+int
+nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
+{
+	g_request = req;
+
+	return 0;
+}
+
+void
+nvme_ctrlr_destruct(struct spdk_nvme_ctrlr *ctrlr)
+{
+}
+
+void
+nvme_ctrlr_proc_get_ref(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return;
+}
+
+int
+nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return 0;
+}
+
+void
+nvme_ctrlr_proc_put_ref(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return;
+}
+
+void
+spdk_nvme_ctrlr_get_default_ctrlr_opts(struct spdk_nvme_ctrlr_opts *opts, size_t opts_size)
+{
+	memset(opts, 0, sizeof(*opts));
+}
+
+bool
+spdk_nvme_transport_available_by_name(const char *transport_name)
+{
+	return true;
+}
+
+struct spdk_nvme_ctrlr *nvme_transport_ctrlr_construct(const struct spdk_nvme_transport_id *trid,
+		const struct spdk_nvme_ctrlr_opts *opts,
+		void *devhandle)
+{
+	return NULL;
+}
+
+int
+nvme_ctrlr_get_ref_count(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return 0;
+}
+
+int
+nvme_transport_ctrlr_scan(struct spdk_nvme_probe_ctx *probe_ctx,
+			  bool direct_connect)
+{
+	return 0;
+}
+
+const struct spdk_nvme_ns_data *
+spdk_nvme_ns_get_data(struct spdk_nvme_ns *ns)
+{
+	return &g_nsdata;
+}
+
+uint32_t
+spdk_nvme_ns_get_sector_size(struct spdk_nvme_ns *ns)
+{
+	return ns->sector_size;
+}
+
+uint64_t
+spdk_nvme_ns_get_num_sectors(struct spdk_nvme_ns *ns)
+{
+	return g_nsdata.nsze;
+}
+
+static void
+prepare_for_test(struct spdk_nvme_ns *ns, struct spdk_nvme_ctrlr *ctrlr,
+		 struct spdk_nvme_qpair *qpair, struct spdk_nvme_zns_ns_data *nsdata_zns,
+		 uint32_t max_xfer_size, uint32_t max_zone_append_size)
+{
+	uint32_t num_requests = 32;
+	uint32_t i;
+
+	memset(ctrlr, 0, sizeof(*ctrlr));
+	ctrlr->max_xfer_size = max_xfer_size;
+	ctrlr->max_zone_append_size = max_zone_append_size;
+	ctrlr->min_page_size = 4096;
+	ctrlr->page_size = 4096;
+
+	memset(ns, 0, sizeof(*ns));
+	ns->ctrlr = ctrlr;
+	ns->id = 1;
+	ns->csi = SPDK_NVME_CSI_ZNS;
+	ns->sector_size = ZNS_SECTOR_SIZE;
+	ns->extended_lba_size = ZNS_SECTOR_SIZE;
+	ns->sectors_per_max_io = max_xfer_size / ns->extended_lba_size;
+
+	memset(nsdata_zns, 0, sizeof(*nsdata_zns));
+	nsdata_zns->lbafe[0].zsze = ZNS_ZONE_SIZE;
+	ns->nsdata_zns = nsdata_zns;
+
+	memset(&g_nsdata, 0, sizeof(g_nsdata));
+	g_nsdata.nsze = 16 * ZNS_ZONE_SIZE;
+
+	memset(qpair, 0, sizeof(*qpair));
+	qpair->ctrlr = ctrlr;
+	qpair->req_buf = calloc(num_requests, sizeof(struct nvme_request));
+	SPDK_CU_ASSERT_FATAL(qpair->req_buf != NULL);
+
+	for (i = 0; i < num_requests; i++) {
+		struct nvme_request *req = qpair->req_buf + i * sizeof(struct nvme_request);
+
+		req->qpair = qpair;
+		STAILQ_INSERT_HEAD(&qpair->free_req, req, stailq);
+	}
+
+	g_request = NULL;
+}
+
+static void
+cleanup_after_test(struct spdk_nvme_qpair *qpair)
+{
+	free(qpair->req_buf);
+}
+
+static void
+test_nvme_zns_ns_geometry(void)
+{
+	struct spdk_nvme_ns		ns;
+	struct spdk_nvme_ctrlr		ctrlr;
+	struct spdk_nvme_qpair		qpair;
+	struct spdk_nvme_zns_ns_data	nsdata_zns;
+
+	prepare_for_test(&ns, &ctrlr, &qpair, &nsdata_zns, 0x20000, 0x10000);
+
+	CU_ASSERT(spdk_nvme_zns_ns_get_data(&ns) == &nsdata_zns);
+	CU_ASSERT(spdk_nvme_zns_ns_get_zone_size_sectors(&ns) == ZNS_ZONE_SIZE);
+	CU_ASSERT(spdk_nvme_zns_ns_get_zone_size(&ns) == (uint64_t)ZNS_ZONE_SIZE * ZNS_SECTOR_SIZE);
+	CU_ASSERT(spdk_nvme_zns_ns_get_num_zones(&ns) == 16);
+	CU_ASSERT(spdk_nvme_zns_ctrlr_get_max_zone_append_size(&ctrlr) == 0x10000);
+
+	/* The resource limits are 0-based, all ones means no limit */
+	nsdata_zns.mor = 13;
+	nsdata_zns.mar = UINT32_MAX;
+	CU_ASSERT(spdk_nvme_zns_ns_get_max_open_zones(&ns) == 14);
+	CU_ASSERT(spdk_nvme_zns_ns_get_max_active_zones(&ns) == UINT32_MAX);
+
+	/* The zone size follows the formatted LBA format */
+	nsdata_zns.lbafe[1].zsze = 2 * ZNS_ZONE_SIZE;
+	g_nsdata.flbas.format = 1;
+	CU_ASSERT(spdk_nvme_zns_ns_get_zone_size_sectors(&ns) == 2 * ZNS_ZONE_SIZE);
+	CU_ASSERT(spdk_nvme_zns_ns_get_num_zones(&ns) == 8);
+
+	/* Namespaces that are not zoned */
+	ns.nsdata_zns = NULL;
+	CU_ASSERT(spdk_nvme_zns_ns_get_data(&ns) == NULL);
+	CU_ASSERT(spdk_nvme_zns_ns_get_zone_size(&ns) == 0);
+	CU_ASSERT(spdk_nvme_zns_ns_get_num_zones(&ns) == 0);
+	CU_ASSERT(spdk_nvme_zns_ns_get_max_open_zones(&ns) == 0);
+
+	cleanup_after_test(&qpair);
+}
+
+static void
+test_nvme_zns_zone_append(void)
+{
+	struct spdk_nvme_ns		ns;
+	struct spdk_nvme_ctrlr		ctrlr;
+	struct spdk_nvme_qpair		qpair;
+	struct spdk_nvme_zns_ns_data	nsdata_zns;
+	void				*buffer;
+	int				rc;
+
+	/* Appends are limited by ZASL, which is below MDTS */
+	prepare_for_test(&ns, &ctrlr, &qpair, &nsdata_zns, 0x20000, 0x10000);
+	buffer = malloc(0x20000);
+	SPDK_CU_ASSERT_FATAL(buffer != NULL);
+
+	rc = spdk_nvme_zns_zone_append(&ns, &qpair, buffer, 2 * ZNS_ZONE_SIZE, 16, NULL, NULL, 0);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->num_children == 0);
+	CU_ASSERT(g_request->payload_size == 16 * ZNS_SECTOR_SIZE);
+	CU_ASSERT(g_request->cmd.opc == SPDK_NVME_OPC_ZONE_APPEND);
+	CU_ASSERT(g_request->cmd.nsid == ns.id);
+	CU_ASSERT(*(uint64_t *)&g_request->cmd.cdw10 == 2 * ZNS_ZONE_SIZE);
+	CU_ASSERT(g_request->cmd.cdw12 == 15);
+	nvme_free_request(g_request);
+	g_request = NULL;
+
+	/* Larger than ZASL, but within MDTS - rejected instead of split */
+	rc = spdk_nvme_zns_zone_append(&ns, &qpair, buffer, 0, 17, NULL, NULL, 0);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(g_request == NULL);
+
+	/* Controllers without ZNS support do not accept any append */
+	ctrlr.max_zone_append_size = 0;
+	rc = spdk_nvme_zns_zone_append(&ns, &qpair, buffer, 0, 1, NULL, NULL, 0);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(g_request == NULL);
+
+	/* Appends are never split on stripe boundaries */
+	ctrlr.max_zone_append_size = 0x20000;
+	ns.sectors_per_stripe = 8;
+	rc = spdk_nvme_zns_zone_append(&ns, &qpair, buffer, 0, 32, NULL, NULL, 0);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->num_children == 0);
+	CU_ASSERT(g_request->cmd.cdw12 == 31);
+	nvme_free_request(g_request);
+
+	free(buffer);
+	cleanup_after_test(&qpair);
+}
+
+static void
+test_nvme_zns_zone_mgmt_send(void)
+{
+	struct spdk_nvme_ns		ns;
+	struct spdk_nvme_ctrlr		ctrlr;
+	struct spdk_nvme_qpair		qpair;
+	struct spdk_nvme_zns_ns_data	nsdata_zns;
+	int				rc;
+
+	prepare_for_test(&ns, &ctrlr, &qpair, &nsdata_zns, 0x20000, 0x10000);
+
+	rc = spdk_nvme_zns_reset_zone(&ns, &qpair, 3 * ZNS_ZONE_SIZE, false, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.opc == SPDK_NVME_OPC_ZONE_MGMT_SEND);
+	CU_ASSERT(g_request->cmd.nsid == ns.id);
+	CU_ASSERT(*(uint64_t *)&g_request->cmd.cdw10 == 3 * ZNS_ZONE_SIZE);
+	CU_ASSERT(g_request->cmd.cdw13 == SPDK_NVME_ZONE_RESET);
+	nvme_free_request(g_request);
+
+	/* Select All ignores the zone start LBA */
+	rc = spdk_nvme_zns_close_zone(&ns, &qpair, 3 * ZNS_ZONE_SIZE, true, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(*(uint64_t *)&g_request->cmd.cdw10 == 0);
+	CU_ASSERT(g_request->cmd.cdw13 == (SPDK_NVME_ZONE_CLOSE | 1 << 8));
+	nvme_free_request(g_request);
+
+	rc = spdk_nvme_zns_finish_zone(&ns, &qpair, 0, false, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.cdw13 == SPDK_NVME_ZONE_FINISH);
+	nvme_free_request(g_request);
+
+	rc = spdk_nvme_zns_open_zone(&ns, &qpair, 0, false, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.cdw13 == SPDK_NVME_ZONE_OPEN);
+	nvme_free_request(g_request);
+
+	rc = spdk_nvme_zns_offline_zone(&ns, &qpair, 0, false, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.cdw13 == SPDK_NVME_ZONE_OFFLINE);
+	nvme_free_request(g_request);
+
+	cleanup_after_test(&qpair);
+}
+
+static void
+test_nvme_zns_report_zones(void)
+{
+	struct spdk_nvme_ns		ns;
+	struct spdk_nvme_ctrlr		ctrlr;
+	struct spdk_nvme_qpair		qpair;
+	struct spdk_nvme_zns_ns_data	nsdata_zns;
+	uint32_t			report_size;
+	void				*report;
+	int				rc;
+
+	prepare_for_test(&ns, &ctrlr, &qpair, &nsdata_zns, 0x20000, 0x10000);
+	report_size = sizeof(struct spdk_nvme_zns_zone_report) +
+		      4 * sizeof(struct spdk_nvme_zns_zone_desc);
+	report = calloc(1, report_size);
+	SPDK_CU_ASSERT_FATAL(report != NULL);
+
+	rc = spdk_nvme_zns_report_zones(&ns, &qpair, report, report_size, ZNS_ZONE_SIZE,
+					SPDK_NVME_ZRA_LIST_ZSF, true, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.opc == SPDK_NVME_OPC_ZONE_MGMT_RECV);
+	CU_ASSERT(g_request->cmd.nsid == ns.id);
+	CU_ASSERT(*(uint64_t *)&g_request->cmd.cdw10 == ZNS_ZONE_SIZE);
+	CU_ASSERT(g_request->cmd.cdw12 == report_size / 4 - 1);
+	CU_ASSERT(g_request->cmd.cdw13 ==
+		  (SPDK_NVME_ZONE_REPORT | SPDK_NVME_ZRA_LIST_ZSF << 8 | 1 << 16));
+	spdk_free(g_request->payload.contig_or_cb_arg);
+	nvme_free_request(g_request);
+	g_request = NULL;
+
+	/* The payload must hold at least the report header */
+	rc = spdk_nvme_zns_report_zones(&ns, &qpair, report, 32, 0, SPDK_NVME_ZRA_LIST_ALL, false,
+					NULL, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(g_request == NULL);
+
+	free(report);
+	cleanup_after_test(&qpair);
+}
+
+int main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("nvme_zns", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_nvme_zns_ns_geometry);
+	CU_ADD_TEST(suite, test_nvme_zns_zone_append);
+	CU_ADD_TEST(suite, test_nvme_zns_zone_mgmt_send);
+	CU_ADD_TEST(suite, test_nvme_zns_report_zones);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+	return num_failures;
+}
@@ -167,6 +167,29 @@ DEFINE_STUB(nvmf_bdev_ctrlr_nvme_passthru_io,
 	     struct spdk_nvmf_request *req),
 	    0);
 
+DEFINE_STUB(nvmf_bdev_ctrlr_zone_append_cmd,
+	    int,
+	    (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+	     struct spdk_nvmf_request *req),
+	    0);
+
+DEFINE_STUB(nvmf_bdev_ctrlr_zone_mgmt_send_cmd,
+	    int,
+	    (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+	     struct spdk_nvmf_request *req),
+	    0);
+
+DEFINE_STUB(nvmf_bdev_ctrlr_zone_mgmt_recv_cmd,
+	    int,
+	    (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+	     struct spdk_nvmf_request *req),
+	    0);
+
+DEFINE_STUB(nvmf_bdev_ctrlr_ns_is_zoned,
+	    bool,
+	    (struct spdk_nvmf_ns *ns),
+	    false);
+
 DEFINE_STUB(nvmf_transport_req_complete,
 	    int,
 	    (struct spdk_nvmf_request *req),
@@ -191,6 +214,12 @@ spdk_nvmf_qpair_disconnect(struct spdk_nvmf_qpair *qpair, nvmf_qpair_disconnect_
 	return 0;
 }
 
+void
+nvmf_bdev_ctrlr_identify_zns_ns(struct spdk_nvmf_ns *ns, struct spdk_nvme_zns_ns_data *nsdata_zns)
+{
+	nsdata_zns->lbafe[0].zsze = 16;
+}
+
 void
 nvmf_bdev_ctrlr_identify_ns(struct spdk_nvmf_ns *ns, struct spdk_nvme_ns_data *nsdata,
 			    bool dif_insert_or_strip)
@@ -859,6 +888,19 @@ test_get_ns_id_desc_list(void)
 	CU_ASSERT(buf[36] == 0x33);
 	CU_ASSERT(buf[51] == 0xDD);
 	CU_ASSERT(buf[53] == 0);
+
+	/* Valid NSID of a zoned namespace, the CSI is reported last */
+	MOCK_SET(nvmf_bdev_ctrlr_ns_is_zoned, true);
+	memset(&rsp, 0, sizeof(rsp));
+	CU_ASSERT(nvmf_ctrlr_process_admin_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS);
+	CU_ASSERT(buf[32] == SPDK_NVME_NIDT_UUID);
+	CU_ASSERT(buf[52] == SPDK_NVME_NIDT_CSI);
+	CU_ASSERT(buf[53] == 1);
+	CU_ASSERT(buf[56] == SPDK_NVME_CSI_ZNS);
+	CU_ASSERT(buf[57] == 0);
+	MOCK_SET(nvmf_bdev_ctrlr_ns_is_zoned, false);
 }
 
 static void
@@ -1442,6 +1484,98 @@ test_identify_ctrlr(void)
 	CU_ASSERT(cdata.nvmf_specific.ioccsz == expected_ioccsz);
 }
 
+static void
+test_identify_iocs_specific(void)
+{
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_qpair qpair = {};
+	struct spdk_nvmf_ctrlr ctrlr = {};
+	struct spdk_nvmf_request req = {};
+	struct spdk_nvmf_ns *ns_ptrs[1];
+	struct spdk_nvmf_ns ns = {};
+	struct spdk_bdev bdev = {};
+	union nvmf_h2c_msg cmd = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_nvme_zns_ns_data *nsdata_zns;
+	uint8_t buf[4096];
+
+	ns_ptrs[0] = &ns;
+	subsystem.ns = ns_ptrs;
+	subsystem.max_nsid = 1;
+	subsystem.subtype = SPDK_NVMF_SUBTYPE_NVME;
+	ns.opts.nsid = 1;
+	ns.bdev = &bdev;
+	qpair.ctrlr = &ctrlr;
+	ctrlr.subsys = &subsystem;
+	ctrlr.vcprop.cc.bits.en = 1;
+
+	req.qpair = &qpair;
+	req.cmd = &cmd;
+	req.rsp = &rsp;
+	req.xfer = SPDK_NVME_DATA_CONTROLLER_TO_HOST;
+	req.data = buf;
+	req.length = sizeof(buf);
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_IDENTIFY;
+	nsdata_zns = (struct spdk_nvme_zns_ns_data *)buf;
+
+	/* ZNS Identify Controller data, zone appends are limited by MDTS */
+	cmd.nvme_cmd.cdw10_bits.identify.cns = SPDK_NVME_IDENTIFY_CTRLR_IOCS;
+	cmd.nvme_cmd.cdw11_bits.identify.csi = SPDK_NVME_CSI_ZNS;
+	memset(buf, 0xff, sizeof(buf));
+	CU_ASSERT(nvmf_ctrlr_process_admin_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS);
+	CU_ASSERT(spdk_mem_all_zero(buf, sizeof(buf)));
+
+	/* Unsupported command set */
+	cmd.nvme_cmd.cdw11_bits.identify.csi = SPDK_NVME_CSI_KV;
+	memset(&rsp, 0, sizeof(rsp));
+	CU_ASSERT(nvmf_ctrlr_process_admin_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_IOCS);
+
+	/* ZNS Identify Namespace data of a namespace that is not zoned */
+	cmd.nvme_cmd.cdw10_bits.identify.cns = SPDK_NVME_IDENTIFY_NS_IOCS;
+	cmd.nvme_cmd.cdw11_bits.identify.csi = SPDK_NVME_CSI_ZNS;
+	cmd.nvme_cmd.nsid = 1;
+	memset(&rsp, 0, sizeof(rsp));
+	CU_ASSERT(nvmf_ctrlr_process_admin_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_IOCS);
+
+	/* ZNS Identify Namespace data of a zoned namespace */
+	MOCK_SET(nvmf_bdev_ctrlr_ns_is_zoned, true);
+	memset(&rsp, 0, sizeof(rsp));
+	CU_ASSERT(nvmf_ctrlr_process_admin_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS);
+	CU_ASSERT(nsdata_zns->lbafe[0].zsze == 16);
+
+	/* Invalid NSID */
+	cmd.nvme_cmd.nsid = 2;
+	memset(&rsp, 0, sizeof(rsp));
+	CU_ASSERT(nvmf_ctrlr_process_admin_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_NAMESPACE_OR_FORMAT);
+	MOCK_SET(nvmf_bdev_ctrlr_ns_is_zoned, false);
+}
+
+static void
+test_prop_set_cc_css(void)
+{
+	struct spdk_nvmf_ctrlr ctrlr = {};
+	union spdk_nvme_cc_register cc = {};
+
+	/* Both the NVM and the I/O command set specific selection are accepted */
+	cc.bits.css = SPDK_NVME_CC_CSS_IOCS;
+	CU_ASSERT(nvmf_prop_set_cc(&ctrlr, cc.raw) == true);
+	CU_ASSERT(ctrlr.vcprop.cc.bits.css == SPDK_NVME_CC_CSS_IOCS);
+
+	cc.bits.css = SPDK_NVME_CC_CSS_NVM;
+	CU_ASSERT(nvmf_prop_set_cc(&ctrlr, cc.raw) == true);
+	CU_ASSERT(ctrlr.vcprop.cc.bits.css == SPDK_NVME_CC_CSS_NVM);
+
+	cc.bits.css = SPDK_NVME_CC_CSS_NOIO;
+	CU_ASSERT(nvmf_prop_set_cc(&ctrlr, cc.raw) == false);
+	CU_ASSERT(ctrlr.vcprop.cc.bits.css == SPDK_NVME_CC_CSS_NVM);
+}
+
 static int
 custom_admin_cmd_hdlr(struct spdk_nvmf_request *req)
 {
@@ -1693,6 +1827,8 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_get_dif_ctx);
 	CU_ADD_TEST(suite, test_set_get_features);
 	CU_ADD_TEST(suite, test_identify_ctrlr);
+	CU_ADD_TEST(suite, test_identify_iocs_specific);
+	CU_ADD_TEST(suite, test_prop_set_cc_css);
 	CU_ADD_TEST(suite, test_custom_admin_cmd);
 	CU_ADD_TEST(suite, test_fused_compare_and_write);
 	CU_ADD_TEST(suite, test_multi_async_event_reqs);
@@ -50,6 +50,9 @@ struct spdk_bdev {
 	uint32_t blocklen;
 	uint64_t num_blocks;
 	uint32_t md_len;
+	bool zoned;
+	uint64_t zone_size;
+	uint32_t max_open_zones;
 };
 
 uint32_t
@@ -77,6 +80,74 @@ spdk_bdev_get_md_size(const struct spdk_bdev *bdev)
 	return bdev->md_len;
 }
 
+bool
+spdk_bdev_is_zoned(const struct spdk_bdev *bdev)
+{
+	return bdev->zoned;
+}
+
+uint64_t
+spdk_bdev_get_zone_size(const struct spdk_bdev *bdev)
+{
+	return bdev->zone_size;
+}
+
+uint32_t
+spdk_bdev_get_max_open_zones(const struct spdk_bdev *bdev)
+{
+	return bdev->max_open_zones;
+}
+
+DEFINE_STUB(spdk_bdev_zone_appendv, int,
+	    (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+	     struct iovec *iov, int iovcnt, uint64_t zone_id, uint64_t num_blocks,
+	     spdk_bdev_io_completion_cb cb, void *cb_arg),
+	    0);
+
+DEFINE_STUB(spdk_bdev_io_get_append_location, uint64_t, (struct spdk_bdev_io *bdev_io), 0);
+
+static uint32_t g_zone_mgmt_count;
+static uint64_t g_zone_mgmt_zone_id;
+static enum spdk_bdev_zone_action g_zone_mgmt_action;
+
+int
+spdk_bdev_zone_management(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			  uint64_t zone_id, enum spdk_bdev_zone_action action,
+			  spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	g_zone_mgmt_count++;
+	g_zone_mgmt_zone_id = zone_id;
+	g_zone_mgmt_action = action;
+
+	cb(NULL, true, cb_arg);
+	return 0;
+}
+
+static struct spdk_bdev *g_zone_bdev;
+static enum spdk_bdev_zone_state g_zone_states[4];
+
+int
+spdk_bdev_get_zone_info(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			uint64_t zone_id, size_t num_zones, struct spdk_bdev_zone_info *info,
+			spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	uint64_t zone_size = g_zone_bdev->zone_size;
+	size_t i;
+
+	SPDK_CU_ASSERT_FATAL(zone_id % zone_size == 0);
+	SPDK_CU_ASSERT_FATAL(zone_id / zone_size + num_zones <= SPDK_COUNTOF(g_zone_states));
+
+	for (i = 0; i < num_zones; i++) {
+		info[i].zone_id = zone_id + i * zone_size;
+		info[i].write_pointer = info[i].zone_id;
+		info[i].capacity = zone_size;
+		info[i].state = g_zone_states[info[i].zone_id / zone_size];
+	}
+
+	cb(NULL, true, cb_arg);
+	return 0;
+}
+
 DEFINE_STUB(spdk_bdev_comparev_and_writev_blocks, int,
 	    (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 	     struct iovec *compare_iov, int compare_iovcnt,
@@ -391,6 +462,224 @@ test_spdk_nvmf_bdev_ctrlr_compare_and_write_cmd(void)
 	CU_ASSERT(write_rsp.nvme_cpl.status.sc == SPDK_NVME_SC_DATA_SGL_LENGTH_INVALID);
 }
 
+static void
+test_nvmf_bdev_ctrlr_zone_append_cmd(void)
+{
+	struct spdk_bdev bdev = {};
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel ch = {};
+	struct spdk_nvmf_request req = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_nvme_cmd cmd = {};
+	int rc;
+
+	bdev.blocklen = 512;
+	bdev.num_blocks = 64;
+	bdev.zone_size = 16;
+
+	req.cmd = (union nvmf_h2c_msg *)&cmd;
+	req.rsp = &rsp;
+	cmd.opc = SPDK_NVME_OPC_ZONE_APPEND;
+	cmd.cdw10 = 16;	/* ZSLBA: CDW10 and CDW11 */
+	cmd.cdw12 = 3;	/* NLB: CDW12 bits 15:00, 0's based */
+	req.length = 4 * bdev.blocklen;
+
+	/* Not a zoned bdev */
+	rc = nvmf_bdev_ctrlr_zone_append_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_OPCODE);
+
+	/* Success */
+	bdev.zoned = true;
+	memset(&rsp, 0, sizeof(rsp));
+	rc = nvmf_bdev_ctrlr_zone_append_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+
+	/* ZSLBA is not the start of a zone */
+	cmd.cdw10 = 17;
+	rc = nvmf_bdev_ctrlr_zone_append_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_FIELD);
+
+	/* Past the end of the bdev */
+	cmd.cdw10 = 62;
+	rc = nvmf_bdev_ctrlr_zone_append_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_LBA_OUT_OF_RANGE);
+
+	/* SGL shorter than NLB */
+	cmd.cdw10 = 16;
+	req.length = 4 * bdev.blocklen - 1;
+	rc = nvmf_bdev_ctrlr_zone_append_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_DATA_SGL_LENGTH_INVALID);
+
+	/* The assigned LBA is returned in CDW0 and DW1 */
+	memset(&rsp, 0, sizeof(rsp));
+	MOCK_SET(spdk_bdev_io_get_append_location, 0x100000012ULL);
+	nvmf_bdev_ctrlr_complete_zone_append_cmd(NULL, true, &req);
+	CU_ASSERT(rsp.nvme_cpl.cdw0 == 0x12);
+	CU_ASSERT(rsp.nvme_cpl.rsvd1 == 0x1);
+	MOCK_SET(spdk_bdev_io_get_append_location, 0);
+}
+
+static void
+test_nvmf_bdev_ctrlr_zone_mgmt_send_cmd(void)
+{
+	struct spdk_bdev bdev = {};
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel ch = {};
+	struct spdk_nvmf_request req = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_nvme_cmd cmd = {};
+	int rc;
+
+	bdev.blocklen = 512;
+	bdev.num_blocks = 64;
+	bdev.zoned = true;
+	bdev.zone_size = 16;
+
+	req.cmd = (union nvmf_h2c_msg *)&cmd;
+	req.rsp = &rsp;
+	cmd.opc = SPDK_NVME_OPC_ZONE_MGMT_SEND;
+
+	/* Open a single zone */
+	cmd.cdw10 = 32;
+	cmd.cdw13 = SPDK_NVME_ZONE_OPEN;
+	g_zone_mgmt_count = 0;
+	rc = nvmf_bdev_ctrlr_zone_mgmt_send_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(g_zone_mgmt_count == 1);
+	CU_ASSERT(g_zone_mgmt_zone_id == 32);
+	CU_ASSERT(g_zone_mgmt_action == SPDK_BDEV_ZONE_OPEN);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS);
+
+	/* SLBA is not the start of a zone */
+	cmd.cdw10 = 33;
+	rc = nvmf_bdev_ctrlr_zone_mgmt_send_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_FIELD);
+
+	/* Offline Zone has no bdev equivalent */
+	memset(&rsp, 0, sizeof(rsp));
+	cmd.cdw10 = 32;
+	cmd.cdw13 = SPDK_NVME_ZONE_OFFLINE;
+	rc = nvmf_bdev_ctrlr_zone_mgmt_send_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_FIELD);
+
+	/* Select All is only supported by Reset Zone */
+	memset(&rsp, 0, sizeof(rsp));
+	cmd.cdw13 = SPDK_NVME_ZONE_CLOSE | 1 << 8;
+	rc = nvmf_bdev_ctrlr_zone_mgmt_send_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_FIELD);
+
+	/* Reset all zones, SLBA is ignored */
+	memset(&rsp, 0, sizeof(rsp));
+	cmd.cdw10 = 1000;
+	cmd.cdw13 = SPDK_NVME_ZONE_RESET | 1 << 8;
+	g_zone_mgmt_count = 0;
+	rc = nvmf_bdev_ctrlr_zone_mgmt_send_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(g_zone_mgmt_count == 4);
+	CU_ASSERT(g_zone_mgmt_zone_id == 48);
+	CU_ASSERT(g_zone_mgmt_action == SPDK_BDEV_ZONE_RESET);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS);
+}
+
+static void
+test_nvmf_bdev_ctrlr_zone_mgmt_recv_cmd(void)
+{
+	struct spdk_bdev bdev = {};
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel ch = {};
+	struct spdk_nvmf_request req = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_nvme_cmd cmd = {};
+	struct spdk_nvme_zns_zone_report *report;
+	uint8_t buf[sizeof(*report) + 2 * sizeof(struct spdk_nvme_zns_zone_desc)];
+	int rc;
+
+	bdev.blocklen = 512;
+	bdev.num_blocks = 64;
+	bdev.zoned = true;
+	bdev.zone_size = 16;
+	g_zone_bdev = &bdev;
+	g_zone_states[0] = SPDK_BDEV_ZONE_STATE_EMPTY;
+	g_zone_states[1] = SPDK_BDEV_ZONE_STATE_OPEN;
+	g_zone_states[2] = SPDK_BDEV_ZONE_STATE_FULL;
+	g_zone_states[3] = SPDK_BDEV_ZONE_STATE_EMPTY;
+
+	report = (struct spdk_nvme_zns_zone_report *)buf;
+
+	/* The report is copied into a scattered buffer */
+	req.iov[0].iov_base = buf;
+	req.iov[0].iov_len = 100;
+	req.iov[1].iov_base = buf + 100;
+	req.iov[1].iov_len = sizeof(buf) - 100;
+	req.iovcnt = 2;
+	req.length = sizeof(buf);
+	req.cmd = (union nvmf_h2c_msg *)&cmd;
+	req.rsp = &rsp;
+	cmd.opc = SPDK_NVME_OPC_ZONE_MGMT_RECV;
+	cmd.cdw12 = sizeof(buf) / sizeof(uint32_t) - 1;
+
+	/* All zones, those that do not fit are still counted */
+	memset(buf, 0xff, sizeof(buf));
+	cmd.cdw10 = 0;
+	cmd.cdw13 = SPDK_NVME_ZONE_REPORT;
+	rc = nvmf_bdev_ctrlr_zone_mgmt_recv_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS);
+	CU_ASSERT(report->nr_zones == 4);
+	CU_ASSERT(report->descs[0].zslba == 0);
+	CU_ASSERT(report->descs[0].zs == SPDK_NVME_ZONE_STATE_EMPTY);
+	CU_ASSERT(report->descs[0].zt == SPDK_NVME_ZONE_TYPE_SEQWR);
+	CU_ASSERT(report->descs[0].zcap == 16);
+	CU_ASSERT(report->descs[1].zslba == 16);
+	CU_ASSERT(report->descs[1].wp == 16);
+	CU_ASSERT(report->descs[1].zs == SPDK_NVME_ZONE_STATE_IOPEN);
+
+	/* Partial report of the empty zones */
+	memset(buf, 0xff, sizeof(buf));
+	cmd.cdw13 = SPDK_NVME_ZONE_REPORT | SPDK_NVME_ZRA_LIST_ZSE << 8 | 1 << 16;
+	rc = nvmf_bdev_ctrlr_zone_mgmt_recv_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(report->nr_zones == 2);
+	CU_ASSERT(report->descs[0].zslba == 0);
+	CU_ASSERT(report->descs[1].zslba == 48);
+
+	/* The report starts with the zone containing SLBA */
+	memset(buf, 0xff, sizeof(buf));
+	cmd.cdw10 = 40;
+	cmd.cdw13 = SPDK_NVME_ZONE_REPORT | 1 << 16;
+	rc = nvmf_bdev_ctrlr_zone_mgmt_recv_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(report->nr_zones == 2);
+	CU_ASSERT(report->descs[0].zslba == 32);
+	CU_ASSERT(report->descs[0].zs == SPDK_NVME_ZONE_STATE_FULL);
+	CU_ASSERT(report->descs[1].zslba == 48);
+
+	/* Extended reports are not supported */
+	cmd.cdw10 = 0;
+	cmd.cdw13 = SPDK_NVME_ZONE_EXTENDED_REPORT;
+	rc = nvmf_bdev_ctrlr_zone_mgmt_recv_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_FIELD);
+
+	/* NUMD larger than the SGL */
+	cmd.cdw13 = SPDK_NVME_ZONE_REPORT;
+	cmd.cdw12 = sizeof(buf) / sizeof(uint32_t);
+	rc = nvmf_bdev_ctrlr_zone_mgmt_recv_cmd(&bdev, desc, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_DATA_SGL_LENGTH_INVALID);
+
+	g_zone_bdev = NULL;
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -406,6 +695,9 @@ int main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_get_dif_ctx);
 
 	CU_ADD_TEST(suite, test_spdk_nvmf_bdev_ctrlr_compare_and_write_cmd);
+	CU_ADD_TEST(suite, test_nvmf_bdev_ctrlr_zone_append_cmd);
+	CU_ADD_TEST(suite, test_nvmf_bdev_ctrlr_zone_mgmt_send_cmd);
+	CU_ADD_TEST(suite, test_nvmf_bdev_ctrlr_zone_mgmt_recv_cmd);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -15,6 +15,7 @@ cd "$rootdir"
 function unittest_bdev() {
 	$valgrind $testdir/lib/bdev/bdev.c/bdev_ut
 	$valgrind $testdir/lib/bdev/bdev_ocssd.c/bdev_ocssd_ut
+	$valgrind $testdir/lib/bdev/bdev_nvme.c/bdev_nvme_ut
 	$valgrind $testdir/lib/bdev/raid/bdev_raid.c/bdev_raid_ut
 	$valgrind $testdir/lib/bdev/bdev_zone.c/bdev_zone_ut
 	$valgrind $testdir/lib/bdev/gpt/gpt.c/gpt_ut
@@ -70,6 +71,7 @@ function unittest_nvme() {
 	$valgrind $testdir/lib/nvme/nvme_ctrlr.c/nvme_ctrlr_ut
 	$valgrind $testdir/lib/nvme/nvme_ctrlr_cmd.c/nvme_ctrlr_cmd_ut
 	$valgrind $testdir/lib/nvme/nvme_ctrlr_ocssd_cmd.c/nvme_ctrlr_ocssd_cmd_ut
+	$valgrind $testdir/lib/nvme/nvme_mem.c/nvme_mem_ut
 	$valgrind $testdir/lib/nvme/nvme_ns.c/nvme_ns_ut
 	$valgrind $testdir/lib/nvme/nvme_ns_cmd.c/nvme_ns_cmd_ut
 	$valgrind $testdir/lib/nvme/nvme_ns_ocssd_cmd.c/nvme_ns_ocssd_cmd_ut
@@ -79,6 +81,7 @@ function unittest_nvme() {
 	$valgrind $testdir/lib/nvme/nvme_quirks.c/nvme_quirks_ut
 	$valgrind $testdir/lib/nvme/nvme_tcp.c/nvme_tcp_ut
 	$valgrind $testdir/lib/nvme/nvme_uevent.c/nvme_uevent_ut
+	$valgrind $testdir/lib/nvme/nvme_zns.c/nvme_zns_ut
 }
 
 function unittest_nvmf() {
@@ -164,10 +167,12 @@ run_test "unittest_include" $valgrind $testdir/include/spdk/histogram_data.h/his
 run_test "unittest_bdev" unittest_bdev
 if grep -q '#define SPDK_CONFIG_CRYPTO 1' $rootdir/include/spdk/config.h; then
 	run_test "unittest_bdev_crypto" $valgrind $testdir/lib/bdev/crypto.c/crypto_ut
+	run_test "unittest_bdev_crypto_ipsec_mb" $valgrind $testdir/lib/bdev/crypto_ipsec_mb.c/crypto_ipsec_mb_ut
 fi
 
 if grep -q '#define SPDK_CONFIG_REDUCE 1' $rootdir/include/spdk/config.h; then
 	run_test "unittest_bdev_reduce" $valgrind $testdir/lib/bdev/compress.c/compress_ut
+	run_test "unittest_bdev_compress_sw" $valgrind $testdir/lib/bdev/compress_sw.c/compress_sw_ut
 fi
 
 if grep -q '#define SPDK_CONFIG_PMDK 1' $rootdir/include/spdk/config.h; then